@@ -61,6 +61,11 @@ enum {
   P_SHRINK_BYTES,
   P_LOCK,
   P_UNLOCK,
+  P_CACHE_HIT,
+  P_CACHE_MISS,
+  P_READAHEAD_BYTES,
+  P_WRITEBACK,
+  P_WRITEBACK_BYTES,
   P_LAST,
 };
 
@@ -75,6 +80,11 @@ int SimpleRADOSStriper::config_logger(CephContext* cct, std::string_view name, s
   plb.add_u64_counter(P_SHRINK_BYTES, "shrink_bytes", "Bytes shrunk");
   plb.add_u64_counter(P_LOCK, "lock", "Number of locks");
   plb.add_u64_counter(P_UNLOCK, "unlock", "Number of unlocks");
+  plb.add_u64_counter(P_CACHE_HIT, "cache_hit", "Number of reads served from the cache");
+  plb.add_u64_counter(P_CACHE_MISS, "cache_miss", "Number of reads that read from RADOS");
+  plb.add_u64_counter(P_READAHEAD_BYTES, "readahead_bytes", "Bytes read ahead");
+  plb.add_u64_counter(P_WRITEBACK, "writeback", "Number of writes of coalesced dirty extents");
+  plb.add_u64_counter(P_WRITEBACK_BYTES, "writeback_bytes", "Bytes written back");
   l->reset(plb.create_perf_counters());
   return 0;
 }
@@ -129,6 +139,8 @@ int SimpleRADOSStriper::remove()
     return rc;
   }
 
+  cache_clear();
+
   auto ext = get_first_extent();
   if (int rc = ioctx.remove(ext.soid); rc < 0) {
     d(5) << " remove failed: " << cpp_strerror(rc) << dendl;
@@ -149,6 +161,9 @@ int SimpleRADOSStriper::truncate(uint64_t size)
   }
 
   /* TODO: (not currently used by SQLite) handle growth + sparse */
+  if (caching()) {
+    cache_truncate(size);
+  }
   if (int rc = set_metadata(size, true); rc < 0) {
     return rc;
   }
@@ -189,6 +204,10 @@ int SimpleRADOSStriper::flush()
     return -EBLOCKLISTED;
   }
 
+  if (int rc = writeback(); rc < 0) {
+    return rc;
+  }
+
   if (size_dirty) {
     if (int rc = set_metadata(size, true); rc < 0) {
       return rc;
@@ -441,6 +460,27 @@ int SimpleRADOSStriper::set_metadata(uint64_t new_size, bool update_size)
   return 0;
 }
 
+ssize_t SimpleRADOSStriper::write_bl(bufferlist bl, uint64_t off)
+{
+  size_t len = bl.length();
+  size_t w = 0;
+  while ((len-w) > 0) {
+    auto ext = get_next_extent(off+w, len-w);
+    auto aiocp = aiocompletionptr(librados::Rados::aio_create_completion());
+    bufferlist ebl;
+    ebl.substr_of(bl, w, ext.len);
+    if (int rc = ioctx.aio_write(ext.soid, aiocp.get(), ebl, ext.len, ext.off); rc < 0) {
+      break;
+    }
+    aios.emplace(std::move(aiocp));
+    w += ext.len;
+  }
+
+  wait_for_aios(false); // clean up finished completions
+
+  return (ssize_t)w;
+}
+
 ssize_t SimpleRADOSStriper::write(const void* data, size_t len, uint64_t off)
 {
   d(5) << off << "~" << len << dendl;
@@ -455,38 +495,34 @@ ssize_t SimpleRADOSStriper::write(const void* data, size_t len, uint64_t off)
     }
   }
 
-  size_t w = 0;
-  while ((len-w) > 0) {
-    auto ext = get_next_extent(off+w, len-w);
-    auto aiocp = aiocompletionptr(librados::Rados::aio_create_completion());
+  size_t w;
+  if (caching()) {
+    cache_write(data, len, off);
+    w = len;
+  } else {
     bufferlist bl;
-    bl.append((const char*)data+w, ext.len);
-    if (int rc = ioctx.aio_write(ext.soid, aiocp.get(), bl, ext.len, ext.off); rc < 0) {
-      break;
-    }
-    aios.emplace(std::move(aiocp));
-    w += ext.len;
+    bl.append((const char*)data, len);
+    w = write_bl(std::move(bl), off);
   }
 
-  wait_for_aios(false); // clean up finished completions
-
   if (size < (len+off)) {
     size = len+off;
     size_dirty = true;
     d(10) << " dirty size: " << size << dendl;
   }
 
+  if (caching() && dirty_bytes > cache_size/2) {
+    d(10) << " writing back " << dirty_bytes << " dirty bytes" << dendl;
+    if (int rc = writeback(); rc < 0) {
+      return rc;
+    }
+  }
+
   return (ssize_t)w;
 }
 
-ssize_t SimpleRADOSStriper::read(void* data, size_t len, uint64_t off)
+ssize_t SimpleRADOSStriper::read_direct(void* data, size_t len, uint64_t off)
 {
-  d(5) << off << "~" << len << dendl;
-
-  if (blocklisted.load()) {
-    return -EBLOCKLISTED;
-  }
-
   size_t r = 0;
   std::vector<std::pair<bufferlist, aiocompletionptr>> reads;
   while ((len-r) > 0) {
@@ -514,6 +550,303 @@ ssize_t SimpleRADOSStriper::read(void* data, size_t len, uint64_t off)
   return r;
 }
 
+ssize_t SimpleRADOSStriper::read(void* data, size_t len, uint64_t off)
+{
+  d(5) << off << "~" << len << dendl;
+
+  if (blocklisted.load()) {
+    return -EBLOCKLISTED;
+  }
+
+  if (!caching()) {
+    return read_direct(data, len, off);
+  }
+
+  if (len == 0 || off >= size) {
+    return 0;
+  }
+  len = std::min<uint64_t>(len, size-off);
+  const uint64_t first = off / cache_block_size;
+  const uint64_t last = (off+len-1) / cache_block_size;
+  const uint64_t eof = (size-1) / cache_block_size;
+
+  /* Grow the readahead while the reads are sequential. */
+  if (off == readahead_next && readahead_max > 0) {
+    readahead_window = std::min(std::max(readahead_window*2, cache_block_size),
+                                std::min(readahead_max, cache_size/2));
+  } else {
+    readahead_window = 0;
+  }
+  readahead_next = off+len;
+  const uint64_t ra_last = std::min(eof, last + readahead_window/cache_block_size);
+
+  /* Read the missing blocks in runs of contiguous blocks. A miss also reads
+   * ahead the blocks missing up to the readahead window.
+   */
+  bool hit = true;
+  std::vector<std::pair<uint64_t, uint64_t>> runs;
+  for (uint64_t b = first; b <= ra_last; ++b) {
+    bool missing = !cache.count(b) &&
+                   !dirty_covers(b*cache_block_size, cache_block_size);
+    if (b <= last) {
+      hit = hit && !missing;
+    } else if (hit) {
+      break;
+    } else if (missing && logger) {
+      logger->inc(P_READAHEAD_BYTES, cache_block_size);
+    }
+    if (!missing) {
+      continue;
+    }
+    if (!runs.empty() && runs.back().first+runs.back().second == b) {
+      ++runs.back().second;
+    } else {
+      runs.emplace_back(b, 1);
+    }
+  }
+  for (auto& [run, n] : runs) {
+    if (int rc = read_blocks(run, n); rc < 0) {
+      return rc;
+    }
+  }
+  if (logger) {
+    logger->inc(hit ? P_CACHE_HIT : P_CACHE_MISS);
+  }
+
+  /* The blocks hold the dirty data too; a block missing is fully dirty. */
+  for (uint64_t b = first; b <= last; ++b) {
+    auto it = cache.find(b);
+    if (it == cache.end()) {
+      continue;
+    }
+    cache_lru.splice(cache_lru.end(), cache_lru, it->second.lru);
+    uint64_t boff = b*cache_block_size;
+    uint64_t s = std::max(off, boff);
+    uint64_t e = std::min(off+len, boff+cache_block_size);
+    memcpy((char*)data + (s-off), it->second.bp.c_str() + (s-boff), e-s);
+  }
+  auto p = dirty.lower_bound(off);
+  if (p != dirty.begin()) {
+    --p;
+  }
+  for (; p != dirty.end() && p->first < off+len; ++p) {
+    uint64_t s = std::max(off, p->first);
+    uint64_t e = std::min<uint64_t>(off+len, p->first+p->second.length());
+    if (s < e) {
+      p->second.begin(s-p->first).copy(e-s, (char*)data + (s-off));
+    }
+  }
+
+  cache_trim();
+  return len;
+}
+
+/* Read blocks [first, first+n) into the cache, with the dirty data. */
+int SimpleRADOSStriper::read_blocks(uint64_t first, uint64_t n)
+{
+  d(15) << "blocks " << first << "~" << n << dendl;
+
+  uint64_t off = first*cache_block_size;
+  uint64_t len = n*cache_block_size;
+  std::vector<std::pair<bufferlist, aiocompletionptr>> reads;
+  for (uint64_t r = 0; r < len; ) {
+    auto ext = get_next_extent(off+r, len-r);
+    auto& [bl, aiocp] = reads.emplace_back();
+    aiocp = aiocompletionptr(librados::Rados::aio_create_completion());
+    if (int rc = ioctx.aio_read(ext.soid, aiocp.get(), &bl, ext.len, ext.off); rc < 0) {
+      d(1) << " read failure: " << cpp_strerror(rc) << dendl;
+      return rc;
+    }
+    r += ext.len;
+  }
+
+  /* the objects may be shorter than the file: the rest reads as zeros */
+  bufferptr bp = buffer::create_page_aligned(len);
+  bp.zero();
+  uint64_t r = 0;
+  for (auto& [bl, aiocp] : reads) {
+    if (int rc = aiocp->wait_for_complete(); rc < 0 && rc != -ENOENT) {
+      d(1) << " read failure: " << cpp_strerror(rc) << dendl;
+      return rc;
+    }
+    auto ext = get_next_extent(off+r, len-r);
+    bl.begin().copy(std::min<uint64_t>(bl.length(), ext.len), bp.c_str()+r);
+    r += ext.len;
+  }
+
+  for (uint64_t i = 0; i < n; ++i) {
+    auto [it, inserted] = cache.try_emplace(first+i);
+    if (!inserted) {
+      continue;
+    }
+    it->second.bp = bufferptr(bp, i*cache_block_size, cache_block_size);
+    it->second.lru = cache_lru.insert(cache_lru.end(), first+i);
+    uint64_t boff = (first+i)*cache_block_size;
+    auto p = dirty.lower_bound(boff);
+    if (p != dirty.begin()) {
+      --p;
+    }
+    for (; p != dirty.end() && p->first < boff+cache_block_size; ++p) {
+      uint64_t s = std::max(boff, p->first);
+      uint64_t e = std::min<uint64_t>(boff+cache_block_size, p->first+p->second.length());
+      if (s < e) {
+        p->second.begin(s-p->first).copy(e-s, it->second.bp.c_str() + (s-boff));
+      }
+    }
+  }
+  return 0;
+}
+
+bool SimpleRADOSStriper::dirty_covers(uint64_t off, uint64_t len) const
+{
+  auto p = dirty.upper_bound(off);
+  if (p == dirty.begin()) {
+    return false;
+  }
+  --p;
+  /* the extents are disjoint but may be contiguous */
+  uint64_t end = off;
+  while (p != dirty.end() && p->first <= end) {
+    end = std::max<uint64_t>(end, p->first+p->second.length());
+    if (end >= off+len) {
+      return true;
+    }
+    ++p;
+  }
+  return false;
+}
+
+void SimpleRADOSStriper::cache_write(const void* data, size_t len, uint64_t off)
+{
+  if (len == 0) {
+    return;
+  }
+
+  /* keep the cached blocks current */
+  for (uint64_t b = off/cache_block_size; b <= (off+len-1)/cache_block_size; ++b) {
+    auto it = cache.find(b);
+    if (it == cache.end()) {
+      continue;
+    }
+    uint64_t boff = b*cache_block_size;
+    uint64_t s = std::max(off, boff);
+    uint64_t e = std::min<uint64_t>(off+len, boff+cache_block_size);
+    memcpy(it->second.bp.c_str() + (s-boff), (const char*)data + (s-off), e-s);
+  }
+
+  /* replace what the dirty extents hold of [off, off+len) */
+  auto p = dirty.lower_bound(off);
+  if (p != dirty.begin()) {
+    auto q = std::prev(p);
+    if (q->first + q->second.length() > off) {
+      p = q;
+    }
+  }
+  while (p != dirty.end() && p->first < off+len) {
+    uint64_t s = p->first;
+    uint64_t e = s + p->second.length();
+    bufferlist old = std::move(p->second);
+    dirty_bytes -= old.length();
+    p = dirty.erase(p);
+    if (s < off) {
+      bufferlist head;
+      head.substr_of(old, 0, off-s);
+      dirty_bytes += head.length();
+      dirty.emplace(s, std::move(head));
+    }
+    if (e > off+len) {
+      bufferlist tail;
+      tail.substr_of(old, off+len-s, e-(off+len));
+      dirty_bytes += tail.length();
+      dirty.emplace(off+len, std::move(tail));
+      break;
+    }
+  }
+  bufferlist bl;
+  bl.append((const char*)data, len);
+  dirty_bytes += len;
+  dirty.emplace(off, std::move(bl));
+}
+
+void SimpleRADOSStriper::cache_truncate(uint64_t new_size)
+{
+  d(15) << new_size << dendl;
+
+  auto b = new_size / cache_block_size;
+  if (auto it = cache.find(b); it != cache.end()) {
+    auto boff = b*cache_block_size;
+    memset(it->second.bp.c_str() + (new_size-boff), 0, cache_block_size-(new_size-boff));
+  }
+  for (auto it = cache.upper_bound(b); it != cache.end(); ) {
+    cache_lru.erase(it->second.lru);
+    it = cache.erase(it);
+  }
+
+  auto p = dirty.lower_bound(new_size);
+  if (p != dirty.begin()) {
+    auto q = std::prev(p);
+    if (q->first + q->second.length() > new_size) {
+      bufferlist head;
+      head.substr_of(q->second, 0, new_size-q->first);
+      dirty_bytes -= q->second.length() - head.length();
+      q->second = std::move(head);
+    }
+  }
+  while (p != dirty.end()) {
+    dirty_bytes -= p->second.length();
+    p = dirty.erase(p);
+  }
+}
+
+void SimpleRADOSStriper::cache_trim()
+{
+  while (cache.size()*cache_block_size > cache_size && !cache_lru.empty()) {
+    cache.erase(cache_lru.front());
+    cache_lru.pop_front();
+  }
+}
+
+void SimpleRADOSStriper::cache_clear()
+{
+  cache.clear();
+  cache_lru.clear();
+  dirty.clear();
+  dirty_bytes = 0;
+  readahead_next = 0;
+  readahead_window = 0;
+}
+
+/* Write the dirty extents, coalescing the contiguous ones. */
+int SimpleRADOSStriper::writeback()
+{
+  if (dirty.empty()) {
+    return 0;
+  }
+  d(10) << dirty.size() << " dirty extents, " << dirty_bytes << " bytes" << dendl;
+
+  while (!dirty.empty()) {
+    auto p = dirty.begin();
+    uint64_t off = p->first;
+    bufferlist bl;
+    while (p != dirty.end() && p->first == off+bl.length()) {
+      bl.claim_append(p->second);
+      p = dirty.erase(p);
+    }
+    auto len = bl.length();
+    dirty_bytes -= len;
+    if (logger) {
+      logger->inc(P_WRITEBACK);
+      logger->inc(P_WRITEBACK_BYTES, len);
+    }
+    if (auto w = write_bl(std::move(bl), off); w < (ssize_t)len) {
+      d(1) << " writeback failure at " << off+w << dendl;
+      cache_clear();
+      return -EIO;
+    }
+  }
+  return 0;
+}
+
 int SimpleRADOSStriper::print_lockers(std::ostream& out)
 {
   int exclusive;
@@ -726,6 +1059,8 @@ int SimpleRADOSStriper::lock(uint64_t timeoutms)
     d(5) << " open failed: " << cpp_strerror(rc) << dendl;
     return rc;
   }
+  /* anyone may have written while we didn't hold the lock */
+  cache_clear();
 
   d(5) << " = 0" << dendl;
   if (logger) {
@@ -751,6 +1086,7 @@ int SimpleRADOSStriper::unlock()
   if (int rc = flush(); rc < 0) {
     return rc;
   }
+  cache_clear();
 
   const auto ext = get_first_extent();
   auto op = librados::ObjectWriteOperation();
@@ -15,6 +15,8 @@
 #ifndef _SIMPLERADOSSTRIPER_H
 #define _SIMPLERADOSSTRIPER_H
 
+#include <list>
+#include <map>
 #include <queue>
 #include <string_view>
 #include <thread>
@@ -36,6 +38,7 @@ public:
 
   static inline const uint64_t object_size = 22; /* power of 2 */
   static inline const uint64_t min_growth = (1<<27); /* 128 MB */
+  static inline const uint64_t cache_block_size = (1<<16); /* 64K, the VFS sector size */
   static int config_logger(CephContext* cct, std::string_view name, std::shared_ptr<PerfCounters>* l);
 
   SimpleRADOSStriper() = default;
@@ -79,6 +82,15 @@ public:
   void set_blocklist_the_dead(bool b) {
     blocklist_the_dead = b;
   }
+  /* The data is cached only while locked, the lock being exclusive. Writes
+   * are kept dirty until flush(), or cache_size/2 bytes are dirty.
+   */
+  void set_cache_size(uint64_t s) {
+    cache_size = s;
+  }
+  void set_readahead_max(uint64_t s) {
+    readahead_max = s;
+  }
 
 protected:
   struct extent {
@@ -98,6 +110,18 @@ protected:
   extent get_first_extent() const {
     return get_next_extent(0, 0);
   }
+  ssize_t write_bl(ceph::bufferlist bl, uint64_t off);
+  ssize_t read_direct(void* data, size_t len, uint64_t off);
+  int read_blocks(uint64_t first, uint64_t n);
+  bool caching() const {
+    return cache_size > 0 && locked;
+  }
+  bool dirty_covers(uint64_t off, uint64_t len) const;
+  void cache_write(const void* data, size_t len, uint64_t off);
+  void cache_truncate(uint64_t new_size);
+  void cache_trim();
+  void cache_clear();
+  int writeback();
 
 private:
   static inline const char XATTR_EXCL[] = "striper.excl";
@@ -134,6 +158,19 @@ private:
   std::queue<aiocompletionptr> aios;
   int aios_failure = 0;
   std::string myaddrs;
+
+  struct cache_block {
+    ceph::bufferptr bp;
+    std::list<uint64_t>::iterator lru;
+  };
+  uint64_t cache_size = 0;
+  uint64_t readahead_max = 0;
+  std::map<uint64_t, cache_block> cache; /* by block number */
+  std::list<uint64_t> cache_lru; /* least recently used first */
+  std::map<uint64_t, ceph::bufferlist> dirty; /* by offset, disjoint */
+  uint64_t dirty_bytes = 0;
+  uint64_t readahead_next = 0;
+  uint64_t readahead_window = 0;
 };
 
 #endif /* _SIMPLERADOSSTRIPER_H */
@@ -23,6 +23,8 @@ int ceph_arch_intel_ssse3 = 0;
 int ceph_arch_intel_sse3 = 0;
 int ceph_arch_intel_sse2 = 0;
 int ceph_arch_intel_aesni = 0;
+int ceph_arch_intel_avx512 = 0;
+int ceph_arch_intel_vpclmul = 0;
 
 #ifdef __x86_64__
 #include <cpuid.h>
@@ -36,6 +38,14 @@ int ceph_arch_intel_aesni = 0;
 #define CPUID_SSE3	(1)
 #define CPUID_SSE2	(1 << 26)
 #define CPUID_AESNI (1 << 25)
+#define CPUID_OSXSAVE	(1 << 27)
+/* leaf 7, ebx */
+#define CPUID_AVX512F	(1 << 16)
+#define CPUID_AVX512DQ	(1 << 17)
+/* leaf 7, ecx */
+#define CPUID_VPCLMULQDQ	(1 << 10)
+/* xmm, ymm, opmask and zmm states enabled by the os */
+#define XCR0_AVX512	0xe6
 
 int ceph_arch_intel_probe(void)
 {
@@ -65,6 +75,18 @@ int ceph_arch_intel_probe(void)
   if ((ecx & CPUID_AESNI) != 0) {
           ceph_arch_intel_aesni = 1;
   }
+	if ((ecx & CPUID_OSXSAVE) != 0) {
+		unsigned int xcr0_lo, xcr0_hi;
+		__asm__ ("xgetbv" : "=a" (xcr0_lo), "=d" (xcr0_hi) : "c" (0));
+		if ((xcr0_lo & XCR0_AVX512) == XCR0_AVX512 &&
+		    __get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx) &&
+		    (ebx & CPUID_AVX512F) != 0 && (ebx & CPUID_AVX512DQ) != 0) {
+			ceph_arch_intel_avx512 = 1;
+			if ((ecx & CPUID_VPCLMULQDQ) != 0) {
+				ceph_arch_intel_vpclmul = 1;
+			}
+		}
+	}
 
 	return 0;
 }
@@ -12,6 +12,11 @@
  *
  */
 
+#include <cstring>
+#include <list>
+#include <string_view>
+#include <unordered_map>
+
 #include "CephxProtocol.h"
 #include "common/Clock.h"
 #include "common/ceph_context.h"
@@ -419,6 +424,75 @@ bool cephx_decode_ticket(CephContext *cct, KeyStore *keys,
  *
  * {timestamp + 1}^session_key
  */
+namespace {
+
+/*
+ * The service tickets decrypted lately by this thread, so that the
+ * clients reconnecting with the ticket they already presented, as they
+ * all do after a network blip, do not have it decrypted again.  A
+ * ticket is looked up by its blob along with the service and secret it
+ * is encrypted with, and only matches if that secret is still the same.
+ * Each messenger thread has a cache of its own, and needs no lock.
+ */
+class ServiceTicketCache {
+  struct entry_t {
+    std::string key;
+    std::string secret;
+    CephXServiceTicketInfo info;
+  };
+  std::list<entry_t> lru;  ///< the most recently used first
+  std::unordered_map<std::string_view, std::list<entry_t>::iterator> entries;
+
+public:
+  static std::string make_key(uint32_t service_id, uint64_t secret_id,
+			      const bufferlist& blob) {
+    std::string key;
+    key.reserve(sizeof(service_id) + sizeof(secret_id) + blob.length());
+    key.append(reinterpret_cast<const char*>(&service_id), sizeof(service_id));
+    key.append(reinterpret_cast<const char*>(&secret_id), sizeof(secret_id));
+    for (const auto& p : blob.buffers()) {
+      key.append(p.c_str(), p.length());
+    }
+    return key;
+  }
+
+  bool get(const std::string& key, const CryptoKey& secret,
+	   CephXServiceTicketInfo *info) {
+    auto p = entries.find(key);
+    if (p == entries.end()) {
+      return false;
+    }
+    auto& e = *p->second;
+    const auto& s = secret.get_secret();
+    if (e.secret.size() != s.length() ||
+	memcmp(e.secret.data(), s.c_str(), s.length()) != 0) {
+      lru.erase(p->second);
+      entries.erase(p);
+      return false;
+    }
+    lru.splice(lru.begin(), lru, p->second);
+    *info = e.info;
+    return true;
+  }
+
+  void put(std::string&& key, const CryptoKey& secret,
+	   const CephXServiceTicketInfo& info, size_t max_size) {
+    if (entries.count(key)) {
+      return;
+    }
+    const auto& s = secret.get_secret();
+    lru.push_front(entry_t{std::move(key), std::string(s.c_str(), s.length()),
+			   info});
+    entries.emplace(lru.front().key, lru.begin());
+    while (lru.size() > max_size) {
+      entries.erase(lru.back().key);
+      lru.pop_back();
+    }
+  }
+};
+
+} // anonymous namespace
+
 bool cephx_verify_authorizer(CephContext *cct, const KeyStore& keys,
 			     bufferlist::const_iterator& indata,
 			     size_t connection_secret_required_len,
@@ -465,10 +539,26 @@ bool cephx_verify_authorizer(CephContext *cct, const KeyStore& keys,
     }
   }
   std::string error;
-  if (!service_secret.get_secret().length())
+  const size_t cache_size = cct->_conf->cephx_service_ticket_cache_size;
+  static thread_local ServiceTicketCache ticket_cache;
+  std::string cache_key;
+  if (cache_size) {
+    cache_key = ServiceTicketCache::make_key(service_id, ticket.secret_id,
+					     ticket.blob);
+  }
+  if (!service_secret.get_secret().length()) {
     error = "invalid key";  // Bad key?
-  else
+  } else if (cache_size &&
+	     ticket_cache.get(cache_key, service_secret, &ticket_info)) {
+    ldout(cct, 20) << "verify_authorizer found the ticket info in the cache"
+		   << dendl;
+  } else {
     decode_decrypt_enc_bl(cct, ticket_info, service_secret, ticket.blob, error);
+    if (error.empty() && cache_size) {
+      ticket_cache.put(std::move(cache_key), service_secret, ticket_info,
+		       cache_size);
+    }
+  }
   if (!error.empty()) {
     ldout(cct, 0) << "verify_authorizer could not decrypt ticket info: error: "
       << error << dendl;
@@ -199,6 +199,11 @@ public:
     ceph_assert(is_smr());
     return conventional_region_size;
   }
+  /// move the write pointer of a sequential zone back to its start
+  virtual int reset_zone(uint64_t zone) {
+    ceph_assert(is_smr());
+    return -EOPNOTSUPP;
+  }
 
   virtual void aio_submit(IOContext *ioc) = 0;
 
@@ -35,6 +35,7 @@ struct aio_t {
   uint64_t offset, length;
   long rval;
   ceph::buffer::list bl;  ///< write payload (so that it remains stable for duration)
+  int ioring_buf = -1;    ///< registered io_uring buffer used for this io, if any
 
   boost::intrusive::list_member_hook<> queue_item;
 
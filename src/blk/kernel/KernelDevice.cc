@@ -19,14 +19,20 @@
 #include <sys/stat.h>
 #include <fcntl.h>
 #include <sys/file.h>
+#include <sys/mman.h>
+
+#include <boost/lockfree/queue.hpp>
 
 #include "KernelDevice.h"
+#include "include/buffer_raw.h"
 #include "include/intarith.h"
 #include "include/types.h"
 #include "include/compat.h"
 #include "include/stringify.h"
+#include "include/str_map.h"
 #include "common/blkdev.h"
 #include "common/errno.h"
+#include "common/strtol.h"
 #if defined(__FreeBSD__)
 #include "bsm/audit_errno.h"
 #endif
@@ -73,7 +79,10 @@ KernelDevice::KernelDevice(CephContext* cct, aio_callback_t cb, void *cbpriv, ai
   if (use_ioring && ioring_queue_t::supported()) {
     bool use_ioring_hipri = cct->_conf.get_val<bool>("bdev_ioring_hipri");
     bool use_ioring_sqthread_poll = cct->_conf.get_val<bool>("bdev_ioring_sqthread_poll");
-    io_queue = std::make_unique<ioring_queue_t>(iodepth, use_ioring_hipri, use_ioring_sqthread_poll);
+    uint64_t reg_bytes = cct->_conf.get_val<Option::size_t>("bdev_ioring_registered_buffers");
+    uint64_t reg_buf_size = cct->_conf.get_val<Option::size_t>("bdev_ioring_registered_buffer_size");
+    io_queue = std::make_unique<ioring_queue_t>(iodepth, use_ioring_hipri, use_ioring_sqthread_poll,
+                                                reg_bytes, reg_buf_size);
   } else {
     static bool once;
     if (use_ioring && !once) {
@@ -1027,6 +1036,104 @@ int KernelDevice::discard(uint64_t offset, uint64_t len)
   return r;
 }
 
+namespace {
+
+/// buffers of one size in explicit huge pages, mapped once and reused
+class ExplicitHugePagePool {
+  const size_t buffer_size;
+  boost::lockfree::queue<void*> regions;
+
+  /// gives its region back to the pool when released
+  class mmapped_buffer_raw : public ceph::buffer::raw {
+    ExplicitHugePagePool& pool;
+  public:
+    mmapped_buffer_raw(void* region, ExplicitHugePagePool& pool)
+      : raw(static_cast<char*>(region), pool.buffer_size),
+	pool(pool) {}
+    ~mmapped_buffer_raw() override {
+      pool.regions.push(data);
+    }
+    raw* clone_empty() override {
+      return ceph::buffer::create_small_page_aligned(len).release();
+    }
+  };
+
+public:
+  ExplicitHugePagePool(size_t buffer_size, size_t buffers)
+    : buffer_size(buffer_size), regions(buffers) {
+    while (buffers--) {
+      void* region = ::mmap(nullptr, buffer_size, PROT_READ | PROT_WRITE,
+			    MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE |
+			    MAP_HUGETLB, -1, 0);
+      if (region == MAP_FAILED) {
+	// out of reserved huge pages (vm.nr_hugepages): a smaller pool
+	break;
+      }
+      regions.push(region);
+    }
+  }
+
+  ceph::unique_leakable_ptr<ceph::buffer::raw> try_create() {
+    void* region;
+    if (regions.pop(region)) {
+      return ceph::unique_leakable_ptr<ceph::buffer::raw>(
+	new mmapped_buffer_raw(region, *this));
+    }
+    return nullptr;
+  }
+};
+
+/// the pools of bdev_read_preallocated_huge_buffers, by buffer size
+class HugePagePoolOfPools {
+  // never freed: the buffers handed out point back to their pool
+  std::map<size_t, ExplicitHugePagePool*> pools;
+
+public:
+  explicit HugePagePoolOfPools(const std::string& desc) {
+    std::map<std::string, std::string> sizes;
+    get_str_map(desc, &sizes, ",");
+    for (auto& [size, count] : sizes) {
+      std::string err;
+      size_t buffer_size = strict_iecstrtoll(size.c_str(), &err);
+      if (!err.empty() || buffer_size == 0) {
+	continue;
+      }
+      size_t buffers = strict_strtoll(count, 10, &err);
+      if (!err.empty() || buffers == 0) {
+	continue;
+      }
+      pools.emplace(buffer_size,
+		    new ExplicitHugePagePool(buffer_size, buffers));
+    }
+  }
+
+  ceph::unique_leakable_ptr<ceph::buffer::raw> try_create(size_t len) {
+    auto p = pools.find(len);
+    if (p == pools.end()) {
+      return nullptr;
+    }
+    return p->second->try_create();
+  }
+};
+
+} // anonymous namespace
+
+/*
+ * a buffer to read @p len bytes into: one of the huge page buffers of
+ * that size when there is one free, which saves the allocation of a big
+ * aligned buffer and spreads it over far fewer TLB entries
+ */
+static ceph::unique_leakable_ptr<ceph::buffer::raw> create_read_buffer(
+  CephContext* cct, size_t len)
+{
+  static HugePagePoolOfPools hp_pools(
+    cct->_conf.get_val<std::string>("bdev_read_preallocated_huge_buffers"));
+  if (auto raw = hp_pools.try_create(len); raw) {
+    return raw;
+  }
+  return ceph::buffer::create_small_page_aligned(len);
+}
+
 int KernelDevice::read(uint64_t off, uint64_t len, bufferlist *pbl,
 		      IOContext *ioc,
 		      bool buffered)
@@ -1040,7 +1147,7 @@ int KernelDevice::read(uint64_t off, uint64_t len, bufferlist *pbl,
 
   auto start1 = mono_clock::now();
 
-  auto p = ceph::buffer::ptr_node::create(ceph::buffer::create_small_page_aligned(len));
+  auto p = ceph::buffer::ptr_node::create(create_read_buffer(cct, len));
   int r = ::pread(buffered ? fd_buffereds[WRITE_LIFE_NOT_SET] : fd_directs[WRITE_LIFE_NOT_SET],
 		  p->c_str(), len, off);
   auto age = cct->_conf->bdev_debug_aio_log_age;
@@ -1091,7 +1198,7 @@ int KernelDevice::aio_read(
     ++ioc->num_pending;
     aio_t& aio = ioc->pending_aios.back();
     aio.bl.push_back(
-      ceph::buffer::ptr_node::create(ceph::buffer::create_small_page_aligned(len)));
+      ceph::buffer::ptr_node::create(create_read_buffer(cct, len)));
     aio.bl.prepare_iov(&aio.iov);
     aio.preadv(off, len);
     dout(30) << aio << dendl;
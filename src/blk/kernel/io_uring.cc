@@ -8,14 +8,66 @@
 #include "liburing.h"
 #include <sys/epoll.h>
 
+#include "include/intarith.h"
+#include "include/page.h"
+
 struct ioring_data {
   struct io_uring io_uring;
   pthread_mutex_t cq_mutex;
   pthread_mutex_t sq_mutex;
   int epoll_fd = -1;
   std::map<int, int> fixed_fds_map;
+
+  // registered buffers
+  pthread_mutex_t reg_mutex;
+  char *reg_base = nullptr;
+  size_t reg_buf_size = 0;
+  std::vector<int> reg_free;
 };
 
+static void copy_to_iov(struct aio_t *io, const char *src, size_t len)
+{
+  for (auto& v : io->iov) {
+    if (!len)
+      break;
+    size_t l = std::min(len, v.iov_len);
+    memcpy(v.iov_base, src, l);
+    src += l;
+    len -= l;
+  }
+}
+
+static void copy_from_iov(struct aio_t *io, char *dst)
+{
+  for (auto& v : io->iov) {
+    memcpy(dst, v.iov_base, v.iov_len);
+    dst += v.iov_len;
+  }
+}
+
+static int get_reg_buf(struct ioring_data *d, struct aio_t *io)
+{
+  if (!d->reg_base || io->length > d->reg_buf_size)
+    return -1;
+
+  int buf = -1;
+  pthread_mutex_lock(&d->reg_mutex);
+  if (!d->reg_free.empty()) {
+    buf = d->reg_free.back();
+    d->reg_free.pop_back();
+  }
+  pthread_mutex_unlock(&d->reg_mutex);
+  return buf;
+}
+
+static void put_reg_buf(struct ioring_data *d, struct aio_t *io)
+{
+  pthread_mutex_lock(&d->reg_mutex);
+  d->reg_free.push_back(io->ioring_buf);
+  pthread_mutex_unlock(&d->reg_mutex);
+  io->ioring_buf = -1;
+}
+
 static int ioring_get_cqe(struct ioring_data *d, unsigned int max,
 			  struct aio_t **paio)
 {
@@ -28,6 +80,13 @@ static int ioring_get_cqe(struct ioring_data *d, unsigned int max,
     struct aio_t *io = (struct aio_t *)(uintptr_t) io_uring_cqe_get_data(cqe);
     io->rval = cqe->res;
 
+    if (io->ioring_buf >= 0) {
+      if (io->iocb.aio_lio_opcode == IO_CMD_PREADV && cqe->res > 0)
+	copy_to_iov(io, d->reg_base + io->ioring_buf * d->reg_buf_size,
+		    cqe->res);
+      put_reg_buf(d, io);
+    }
+
     paio[nr++] = io;
 
     if (nr == max)
@@ -54,7 +113,23 @@ static void init_sqe(struct ioring_data *d, struct io_uring_sqe *sqe,
 
   ceph_assert(fixed_fd != -1);
 
-  if (io->iocb.aio_lio_opcode == IO_CMD_PWRITEV)
+  // small ios go through a registered buffer, which saves the kernel
+  // from mapping the user pages for every io
+  int buf = get_reg_buf(d, io);
+  if (buf >= 0) {
+    char *p = d->reg_base + buf * d->reg_buf_size;
+    io->ioring_buf = buf;
+    if (io->iocb.aio_lio_opcode == IO_CMD_PWRITEV) {
+      copy_from_iov(io, p);
+      io_uring_prep_write_fixed(sqe, fixed_fd, p, io->length,
+				io->offset, buf);
+    } else if (io->iocb.aio_lio_opcode == IO_CMD_PREADV) {
+      io_uring_prep_read_fixed(sqe, fixed_fd, p, io->length,
+			       io->offset, buf);
+    } else {
+      ceph_assert(0);
+    }
+  } else if (io->iocb.aio_lio_opcode == IO_CMD_PWRITEV)
     io_uring_prep_writev(sqe, fixed_fd, &io->iov[0],
 			 io->iov.size(), io->offset);
   else if (io->iocb.aio_lio_opcode == IO_CMD_PREADV)
@@ -103,11 +178,45 @@ static void build_fixed_fds_map(struct ioring_data *d,
   }
 }
 
-ioring_queue_t::ioring_queue_t(unsigned iodepth_, bool hipri_, bool sq_thread_) :
+static void init_reg_bufs(struct ioring_data *d, uint64_t bytes,
+			  uint64_t buf_size)
+{
+  // O_DIRECT wants block aligned buffers; the kernel limits the number
+  // of registered buffers
+  buf_size = p2roundup<uint64_t>(buf_size, CEPH_PAGE_SIZE);
+  unsigned n = std::min<uint64_t>(bytes / buf_size, 1 << 14);
+  if (!n)
+    return;
+
+  void *base = nullptr;
+  if (posix_memalign(&base, CEPH_PAGE_SIZE, n * buf_size))
+    return;
+
+  std::vector<struct iovec> iovs(n);
+  for (unsigned i = 0; i < n; ++i) {
+    iovs[i].iov_base = (char *)base + i * buf_size;
+    iovs[i].iov_len = buf_size;
+  }
+  // this fails if RLIMIT_MEMLOCK is too low; fall back to plain ios
+  if (io_uring_register_buffers(&d->io_uring, &iovs[0], n) < 0) {
+    free(base);
+    return;
+  }
+  d->reg_base = (char *)base;
+  d->reg_buf_size = buf_size;
+  d->reg_free.reserve(n);
+  for (int i = n - 1; i >= 0; --i)
+    d->reg_free.push_back(i);
+}
+
+ioring_queue_t::ioring_queue_t(unsigned iodepth_, bool hipri_, bool sq_thread_,
+			       uint64_t reg_bytes_, uint64_t reg_buf_size_) :
   d(make_unique<ioring_data>()),
   iodepth(iodepth_),
   hipri(hipri_),
-  sq_thread(sq_thread_)
+  sq_thread(sq_thread_),
+  reg_bytes(reg_bytes_),
+  reg_buf_size(reg_buf_size_)
 {
 }
 
@@ -121,6 +230,7 @@ int ioring_queue_t::init(std::vector<int> &fds)
 
   pthread_mutex_init(&d->cq_mutex, NULL);
   pthread_mutex_init(&d->sq_mutex, NULL);
+  pthread_mutex_init(&d->reg_mutex, NULL);
 
   if (hipri)
     flags |= IORING_SETUP_IOPOLL;
@@ -140,6 +250,9 @@ int ioring_queue_t::init(std::vector<int> &fds)
 
   build_fixed_fds_map(d.get(), fds);
 
+  if (reg_bytes && reg_buf_size)
+    init_reg_bufs(d.get(), reg_bytes, reg_buf_size);
+
   d->epoll_fd = epoll_create1(0);
   if (d->epoll_fd < 0) {
     ret = -errno;
@@ -169,6 +282,12 @@ void ioring_queue_t::shutdown()
   d->fixed_fds_map.clear();
   close(d->epoll_fd);
   d->epoll_fd = -1;
+  if (d->reg_base) {
+    io_uring_unregister_buffers(&d->io_uring);
+    free(d->reg_base);
+    d->reg_base = nullptr;
+    d->reg_free.clear();
+  }
   io_uring_queue_exit(&d->io_uring);
 }
 
@@ -221,7 +340,8 @@ bool ioring_queue_t::supported()
 
 struct ioring_data {};
 
-ioring_queue_t::ioring_queue_t(unsigned iodepth_, bool hipri_, bool sq_thread_)
+ioring_queue_t::ioring_queue_t(unsigned iodepth_, bool hipri_, bool sq_thread_,
+			       uint64_t reg_bytes_, uint64_t reg_buf_size_)
 {
   ceph_assert(0);
 }
@@ -15,13 +15,19 @@ struct ioring_queue_t final : public io_queue_t {
   unsigned iodepth = 0;
   bool hipri = false;
   bool sq_thread = false;
+  uint64_t reg_bytes = 0;
+  uint64_t reg_buf_size = 0;
 
   typedef std::list<aio_t>::iterator aio_iter;
 
   // Returns true if arch is x86-64 and kernel supports io_uring
   static bool supported();
 
-  ioring_queue_t(unsigned iodepth_, bool hipri_, bool sq_thread_);
+  // reg_bytes of memory split into reg_buf_size buffers is registered
+  // with the ring and used as bounce buffers for ios that fit in one
+  // buffer; 0 disables registered buffers.
+  ioring_queue_t(unsigned iodepth_, bool hipri_, bool sq_thread_,
+		 uint64_t reg_bytes_ = 0, uint64_t reg_buf_size_ = 0);
   ~ioring_queue_t() final;
 
   int init(std::vector<int> &fds) final;
@@ -180,13 +180,18 @@ bool PMEMDevice::support(const std::string &path)
 
 int PMEMDevice::flush()
 {
-  //Because all write is persist. So no need
+  // the writes are persistent once drained, in case any aio write was not
+  // submitted yet
+  pmem_drain();
   return 0;
 }
 
 
 void PMEMDevice::aio_submit(IOContext *ioc)
 {
+  // the aio writes of ioc are not drained yet, make them all persistent
+  // at once
+  pmem_drain();
   if (ioc->priv) {
     ceph_assert(ioc->num_running == 0);
     aio_callback(aio_callback_priv, ioc->priv);
@@ -197,6 +202,13 @@ void PMEMDevice::aio_submit(IOContext *ioc)
 }
 
 int PMEMDevice::write(uint64_t off, bufferlist& bl, bool buffered, int write_hint)
+{
+  int r = _write(off, bl);
+  pmem_drain();
+  return r;
+}
+
+int PMEMDevice::_write(uint64_t off, bufferlist& bl)
 {
   uint64_t len = bl.length();
   dout(20) << __func__ << " " << off << "~" << len  << dendl;
@@ -219,7 +231,8 @@ int PMEMDevice::write(uint64_t off, bufferlist& bl, bool buffered, int write_hin
   while (len) {
     const char *data;
     uint32_t l = p.get_ptr_and_advance(len, &data);
-    pmem_memcpy_persist(addr + off1, data, l);
+    // non-temporal stores, drained by the caller
+    pmem_memcpy_nodrain(addr + off1, data, l);
     len -= l;
     off1 += l;
   }
@@ -233,7 +246,7 @@ int PMEMDevice::aio_write(
   bool buffered,
   int write_hint)
 {
-  return write(off, bl, buffered);
+  return _write(off, bl);
 }
 
 
@@ -34,6 +34,8 @@ class PMEMDevice : public BlockDevice {
 
   std::atomic_int injecting_crash;
   int _lock();
+  /// copy bl to off, leaving the stores to be drained
+  int _write(uint64_t off, bufferlist& bl);
 
 public:
   PMEMDevice(CephContext *cct, aio_callback_t cb, void *cbpriv);
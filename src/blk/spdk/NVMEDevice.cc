@@ -125,6 +125,8 @@ class SharedDriverQueueData {
   std::string sn;
   uint32_t block_size;
   uint32_t max_queue_depth;
+  uint32_t max_io_completion;
+  uint64_t io_sleep_in_us;
   struct spdk_nvme_qpair *qpair;
   int alloc_buf_from_pool(Task *t, bool write);
 
@@ -140,6 +142,8 @@ class SharedDriverQueueData {
     ctrlr = driver->ctrlr;
     ns = driver->ns;
     block_size = driver->block_size;
+    max_io_completion = (uint32_t)g_conf().get_val<uint64_t>("bluestore_spdk_max_io_completion");
+    io_sleep_in_us = g_conf().get_val<uint64_t>("bluestore_spdk_io_sleep");
 
     struct spdk_nvme_io_qpair_opts opts = {};
     spdk_nvme_ctrlr_get_default_io_qpair_opts(ctrlr, &opts, sizeof(opts));
@@ -328,8 +332,6 @@ void SharedDriverQueueData::_aio_handle(Task *t, IOContext *ioc)
 
   int r = 0;
   uint64_t lba_off, lba_count;
-  uint32_t max_io_completion = (uint32_t)g_conf().get_val<uint64_t>("bluestore_spdk_max_io_completion");
-  uint64_t io_sleep_in_us = g_conf().get_val<uint64_t>("bluestore_spdk_io_sleep");
 
   while (ioc->num_running) {
  again:
@@ -777,8 +779,18 @@ void NVMEDevice::aio_submit(IOContext *ioc)
     // Only need to push the first entry
     ioc->nvme_task_first = ioc->nvme_task_last = nullptr;
 
-    thread_local SharedDriverQueueData queue_t = SharedDriverQueueData(this, driver);
-    queue_t._aio_handle(t, ioc);
+    // each thread has a queue pair of its own on every controller it
+    // submits to, and polls for its completions itself: no lock is taken
+    // on the way to the device, and the devices of different controllers
+    // do not share a queue pair
+    thread_local std::map<SharedDriverData*, SharedDriverQueueData> queues;
+    auto q = queues.find(driver);
+    if (q == queues.end()) {
+      q = queues.try_emplace(driver, this, driver).first;
+      dout(10) << __func__ << " allocated a queue pair for thread "
+	       << std::this_thread::get_id() << dendl;
+    }
+    q->second._aio_handle(t, ioc);
   }
 }
 
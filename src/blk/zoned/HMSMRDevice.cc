@@ -66,7 +66,10 @@ HMSMRDevice::HMSMRDevice(CephContext* cct, aio_callback_t cb, void *cbpriv, aio_
   if (use_ioring && ioring_queue_t::supported()) {
     bool use_ioring_hipri = cct->_conf.get_val<bool>("bdev_ioring_hipri");
     bool use_ioring_sqthread_poll = cct->_conf.get_val<bool>("bdev_ioring_sqthread_poll");
-    io_queue = std::make_unique<ioring_queue_t>(iodepth, use_ioring_hipri, use_ioring_sqthread_poll);
+    uint64_t reg_bytes = cct->_conf.get_val<Option::size_t>("bdev_ioring_registered_buffers");
+    uint64_t reg_buf_size = cct->_conf.get_val<Option::size_t>("bdev_ioring_registered_buffer_size");
+    io_queue = std::make_unique<ioring_queue_t>(iodepth, use_ioring_hipri, use_ioring_sqthread_poll,
+                                                reg_bytes, reg_buf_size);
   } else {
     static bool once;
     if (use_ioring && !once) {
@@ -123,6 +126,27 @@ bool HMSMRDevice::set_smr_params(const std::string& path) {
   return true;
 }
 
+int HMSMRDevice::reset_zone(uint64_t zone)
+{
+  dout(10) << __func__ << " zone " << zone << dendl;
+
+  int dev = zbd_open(path.c_str(), O_RDWR | O_DIRECT | O_LARGEFILE, nullptr);
+  if (dev < 0) {
+    int r = -errno;
+    derr << __func__ << " zbd_open failed: " << cpp_strerror(r) << dendl;
+    return r;
+  }
+  auto close_dev = make_scope_guard([dev] { zbd_close(dev); });
+
+  if (zbd_reset_zones(dev, zone * zone_size, zone_size) != 0) {
+    int r = -errno;
+    derr << __func__ << " resetting zone " << zone << " failed: "
+	 << cpp_strerror(r) << dendl;
+    return r;
+  }
+  return 0;
+}
+
 int HMSMRDevice::open(const string& p)
 {
   path = p;
@@ -134,6 +134,7 @@ public:
   int get_devices(std::set<std::string> *ls) const final;
 
   bool is_smr() const final { return true; }
+  int reset_zone(uint64_t zone) final;
 
   bool get_thin_utilization(uint64_t *total, uint64_t *avail) const final;
 
@@ -336,6 +336,7 @@ Client::Client(Messenger *m, MonClient *mc, Objecter *objecter_)
     remount_finisher(m->cct),
     async_ino_releasor(m->cct),
     objecter_finisher(m->cct),
+    async_dirop_finisher(m->cct, "async_dirop", "fn_dirop"),
     m_command_hook(this),
     fscid(0)
 {
@@ -543,6 +544,7 @@ void Client::_pre_init()
   timer.init();
 
   objecter_finisher.start();
+  async_dirop_finisher.start();
   filer.reset(new Filer(objecter, &objecter_finisher));
   objecter->enable_blocklist_events();
 
@@ -694,6 +696,9 @@ void Client::shutdown()
   objecter_finisher.wait_for_empty();
   objecter_finisher.stop();
 
+  async_dirop_finisher.wait_for_empty();
+  async_dirop_finisher.stop();
+
   if (logger) {
     cct->get_perfcounters_collection()->remove(logger.get());
     logger.reset();
@@ -1772,6 +1777,56 @@ int Client::make_request(MetaRequest *request,
 {
   int r = 0;
 
+  register_request(request, perms);
+  ceph_tid_t tid = request->tid;
+
+  // hack target mds?
+  if (use_mds >= 0)
+    request->resend_mds = use_mds;
+
+  MetaSession *session = send_request_and_wait(request);
+
+  if (!request->reply) {
+    ceph_assert(request->aborted());
+    ceph_assert(!request->got_unsafe);
+    r = request->get_abort_code();
+    request->item.remove_myself();
+    unregister_request(request);
+    put_request(request);
+    return r;
+  }
+
+  // got it!
+  auto reply = std::move(request->reply);
+  r = reply->get_result();
+  if (r >= 0)
+    request->success = true;
+
+  // kick dispatcher (we've got it!)
+  ceph_assert(request->dispatch_cond);
+  request->dispatch_cond->notify_all();
+  ldout(cct, 20) << "sendrecv kickback on tid " << tid << " " << request->dispatch_cond << dendl;
+  request->dispatch_cond = 0;
+  
+  if (r >= 0 && ptarget)
+    r = verify_reply_trace(r, session, request, reply, ptarget, pcreated, perms);
+
+  if (pdirbl)
+    *pdirbl = reply->get_extra_bl();
+
+  // -- log times --
+  utime_t lat = ceph_clock_now();
+  lat -= request->sent_stamp;
+  ldout(cct, 20) << "lat " << lat << dendl;
+  logger->tinc(l_c_lat, lat);
+  logger->tinc(l_c_reply, lat);
+
+  put_request(request);
+  return r;
+}
+
+void Client::register_request(MetaRequest *request, const UserPerm& perms)
+{
   // assign a unique tid
   ceph_tid_t tid = ++last_tid;
   request->set_tid(tid);
@@ -1792,11 +1847,18 @@ int Client::make_request(MetaRequest *request,
   } else {
     request->set_oldest_client_tid(oldest_tid);
   }
+}
 
-  // hack target mds?
-  if (use_mds >= 0)
-    request->resend_mds = use_mds;
-
+/**
+ * send_request_and_wait
+ *
+ * (Re)send a registered request until it gets a reply or is aborted,
+ * waiting for mdsmaps and sessions as needed.
+ *
+ * @return the session the request was last sent to
+ */
+MetaSession *Client::send_request_and_wait(MetaRequest *request)
+{
   MetaSession *session = NULL;
   while (1) {
     if (request->aborted())
@@ -1871,43 +1933,98 @@ int Client::make_request(MetaRequest *request,
       break;
   }
 
+  return session;
+}
+
+/**
+ * make_async_request
+ *
+ * Send a request without waiting for the reply if it can go out right
+ * away. The reply is handled by finish_async_request(), which also drops
+ * the caller's reference.
+ *
+ * @return false if the request was not sent, and it is up to the caller
+ *         to make_request() it
+ */
+bool Client::make_async_request(MetaRequest *request, const UserPerm& perms)
+{
+  Inode *hash_diri = NULL;
+  mds_rank_t mds = choose_target_mds(request, &hash_diri);
+  if (blocklisted || mds == MDS_RANK_NONE ||
+      mdsmap->get_state(mds) != MDSMap::STATE_ACTIVE ||
+      !have_open_session(mds))
+    return false;
+  MetaSession *session = &mds_sessions.at(mds);
+  if (session->state != MetaSession::STATE_OPEN)
+    return false;
+
+  register_request(request, perms);
+  request->set_async();
+  ldout(cct, 10) << __func__ << " tid " << request->tid << " to mds." << mds
+		 << dendl;
+  send_request(request, session);
+  return true;
+}
+
+/*
+ * Wake up whoever waits for the request. An async request nobody waits
+ * for is handed to the finisher, which sends it again.
+ */
+void Client::kick_request(MetaRequest *request)
+{
+  if (request->caller_cond) {
+    request->caller_cond->notify_all();
+  } else if (request->is_async() && !request->async_retry) {
+    ldout(cct, 10) << __func__ << " retrying async tid " << request->tid << dendl;
+    request->async_retry = true;
+    async_dirop_finisher.queue(new LambdaContext([this, request](int) {
+      std::scoped_lock l{client_lock};
+      retry_async_request(request);
+    }));
+  }
+}
+
+void Client::retry_async_request(MetaRequest *request)
+{
+  send_request_and_wait(request);
+
   if (!request->reply) {
     ceph_assert(request->aborted());
     ceph_assert(!request->got_unsafe);
-    r = request->get_abort_code();
     request->item.remove_myself();
+    int r = request->get_abort_code();
     unregister_request(request);
-    put_request(request);
-    return r;
+    finish_async_request(request, r);
+    return;
   }
 
-  // got it!
   auto reply = std::move(request->reply);
-  r = reply->get_result();
-  if (r >= 0)
-    request->success = true;
-
-  // kick dispatcher (we've got it!)
   ceph_assert(request->dispatch_cond);
   request->dispatch_cond->notify_all();
-  ldout(cct, 20) << "sendrecv kickback on tid " << tid << " " << request->dispatch_cond << dendl;
   request->dispatch_cond = 0;
-  
-  if (r >= 0 && ptarget)
-    r = verify_reply_trace(r, session, request, reply, ptarget, pcreated, perms);
-
-  if (pdirbl)
-    *pdirbl = reply->get_extra_bl();
-
-  // -- log times --
-  utime_t lat = ceph_clock_now();
-  lat -= request->sent_stamp;
-  ldout(cct, 20) << "lat " << lat << dendl;
-  logger->tinc(l_c_lat, lat);
-  logger->tinc(l_c_reply, lat);
+  finish_async_request(request, reply->get_result());
+}
 
+/*
+ * The first reply of an async request. The caller went on as if it had
+ * succeeded, so on an error all we can do is to stop trusting what we
+ * cached of the directory.
+ */
+void Client::finish_async_request(MetaRequest *request, int r)
+{
+  Inode *dir = request->inode();
+  ldout(cct, 10) << __func__ << " tid " << request->tid << " = " << r << dendl;
+  if (r >= 0) {
+    request->success = true;
+  } else {
+    lderr(cct) << "async " << ceph_mds_op_name(request->get_op()) << " of "
+	       << request->get_filepath() << " failed: " << r << dendl;
+    dir->flags &= ~(I_COMPLETE | I_DIR_ORDERED);
+    if (request->dentry())
+      request->dentry()->lease_mds = -1;
+  }
+  put_cap_ref(dir, CEPH_CAP_DIR_UNLINK);
   put_request(request);
-  return r;
 }
 
 void Client::unregister_request(MetaRequest *req)
@@ -2449,7 +2566,7 @@ void Client::handle_client_request_forward(const MConstRef<MClientRequestForward
   request->item.remove_myself();
   request->num_fwd = fwd->get_num_fwd();
   request->resend_mds = fwd->get_dest_mds();
-  request->caller_cond->notify_all();
+  kick_request(request);
 }
 
 bool Client::is_dir_operation(MetaRequest *req)
@@ -2507,7 +2624,7 @@ void Client::handle_client_reply(const MConstRef<MClientReply>& reply)
          request->sent_on_mseq == it->second.mseq)) {
       ldout(cct, 20) << "have to return ESTALE" << dendl;
     } else {
-      request->caller_cond->notify_all();
+      kick_request(request);
       return;
     }
   }
@@ -2533,7 +2650,12 @@ void Client::handle_client_reply(const MConstRef<MClientReply>& reply)
 
   // Only signal the caller once (on the first reply):
   // Either its an unsafe reply, or its a safe reply and no unsafe reply was sent.
-  if (!is_safe || !request->got_unsafe) {
+  if ((!is_safe || !request->got_unsafe) && !request->caller_cond) {
+    // nobody waits for an async request
+    ceph_assert(request->is_async());
+    request->reply.reset();
+    finish_async_request(request, reply->get_result());
+  } else if (!is_safe || !request->got_unsafe) {
     ceph::condition_variable cond;
     request->dispatch_cond = &cond;
 
@@ -3019,10 +3141,8 @@ void Client::kick_requests(MetaSession *session)
     if (req->got_unsafe)
       continue;
     if (req->aborted()) {
-      if (req->caller_cond) {
-	req->kick = true;
-	req->caller_cond->notify_all();
-      }
+      req->kick = true;
+      kick_request(req);
       continue;
     }
     if (req->retry_attempt > 0)
@@ -3087,9 +3207,9 @@ void Client::kick_requests_closed(MetaSession *session)
     MetaRequest *req = p->second;
     ++p;
     if (req->mds == session->mds_num) {
-      if (req->caller_cond) {
+      if (!req->got_unsafe) {
 	req->kick = true;
-	req->caller_cond->notify_all();
+	kick_request(req);
       }
       req->item.remove_myself();
       if (req->got_unsafe) {
@@ -4083,6 +4203,45 @@ void Client::_schedule_invalidate_callback(Inode *in, int64_t off, int64_t len)
     async_ino_invalidator.queue(new C_Client_CacheInvalidate(this, in, off, len));
 }
 
+class C_Client_KernelWriteback : public Context  {
+private:
+  Client *client;
+  Inode *in;
+  vinodeno_t ino;
+public:
+  C_Client_KernelWriteback(Client *c, Inode *in) : client(c), in(in) {
+    if (client->use_faked_inos())
+      ino = vinodeno_t(in->faked_ino, CEPH_NOSNAP);
+    else
+      ino = in->vino();
+  }
+  void finish(int r) override {
+    ceph_assert(ceph_mutex_is_not_locked_by_me(client->client_lock));
+    client->_async_kernel_writeback(in, ino);
+  }
+};
+
+/*
+ * The kernel may hold dirty data of its own, that it writes back through
+ * us when the cache of the inode is invalidated.  Hold a FILE_BUFFER ref
+ * meanwhile so that the revocation of Fb isn't acked before the data is
+ * written.
+ */
+void Client::_schedule_kernel_writeback(Inode *in)
+{
+  ldout(cct, 10) << __func__ << " " << *in << dendl;
+  get_cap_ref(in, CEPH_CAP_FILE_BUFFER);
+  async_ino_invalidator.queue(new C_Client_KernelWriteback(this, in));
+}
+
+void Client::_async_kernel_writeback(Inode *in, vinodeno_t ino)
+{
+  _async_invalidate(ino, 0, 0);
+  std::scoped_lock l(client_lock);
+  ldout(cct, 10) << __func__ << " " << *in << " done" << dendl;
+  put_cap_ref(in, CEPH_CAP_FILE_BUFFER);
+}
+
 void Client::_invalidate_inode_cache(Inode *in)
 {
   ldout(cct, 10) << __func__ << " " << *in << dendl;
@@ -5561,6 +5720,12 @@ void Client::handle_cap_grant(MetaSession *session, Inode *in, Cap *cap, const M
     else if (revoked & ceph_deleg_caps_for_type(CEPH_DELEGATION_WR))
       in->recall_deleg(true);
 
+    if ((revoked & CEPH_CAP_FILE_BUFFER) && kernel_writeback_cache &&
+	ino_invalidate_cb && in->is_file()) {
+      _schedule_kernel_writeback(in);
+      used |= CEPH_CAP_FILE_BUFFER;
+    }
+
     used = adjust_caps_used_for_lazyio(used, cap->issued, cap->implemented);
     if ((used & revoked & (CEPH_CAP_FILE_BUFFER | CEPH_CAP_FILE_LAZYIO)) &&
 	!_flush(in, new C_Client_FlushComplete(this, in))) {
@@ -6344,10 +6509,8 @@ void Client::_abort_mds_sessions(int err)
       continue;
 
     req->abort(err);
-    if (req->caller_cond) {
-      req->kick = true;
-      req->caller_cond->notify_all();
-    }
+    req->kick = true;
+    kick_request(req);
   }
 
   // Process aborts on any requests that were on this waitlist.
@@ -8619,6 +8782,10 @@ int Client::_readdir_get_frag(dir_result_t *dirp)
   req->set_inode(diri.get());
   req->head.args.readdir.frag = fg;
   req->head.args.readdir.flags = CEPH_READDIR_REPLY_BITFLAGS;
+  // never below what the MDS falls back to, which fits any one entry
+  uint64_t max_bytes = cct->_conf.get_val<Option::size_t>("client_readdir_max_bytes");
+  if (max_bytes > (512 << 10) + cct->_conf->mds_max_xattr_pairs_size)
+    req->head.args.readdir.max_bytes = std::min<uint64_t>(max_bytes, UINT32_MAX);
   if (dirp->last_name.length()) {
     req->path2.set_path(dirp->last_name);
   } else if (dirp->hash_order()) {
@@ -10020,14 +10187,11 @@ int Client::_read_async(Fh *f, uint64_t off, uint64_t len, bufferlist *bl)
   C_SaferCond onfinish("Client::_read_async flock");
   r = objectcacher->file_read(&in->oset, &in->layout, in->snapid,
 			      off, len, bl, 0, &onfinish);
-  if (r == 0) {
+  if (r == 0)
     get_cap_ref(in, CEPH_CAP_FILE_CACHE);
-    client_lock.unlock();
-    r = onfinish.wait();
-    client_lock.lock();
-    put_cap_ref(in, CEPH_CAP_FILE_CACHE);
-  }
 
+  // read ahead before waiting for the read, so that a stream keeps the
+  // next window in flight while the objects it wants now are being read
   if(f->readahead.get_min_readahead_size() > 0) {
     pair<uint64_t, uint64_t> readahead_extent = f->readahead.update(off, len, in->size);
     if (readahead_extent.second > 0) {
@@ -10047,6 +10211,13 @@ int Client::_read_async(Fh *f, uint64_t off, uint64_t len, bufferlist *bl)
     }
   }
 
+  if (r == 0) {
+    client_lock.unlock();
+    r = onfinish.wait();
+    client_lock.lock();
+    put_cap_ref(in, CEPH_CAP_FILE_CACHE);
+  }
+
   return r;
 }
 
@@ -10228,7 +10399,37 @@ int64_t Client::_write(Fh *f, int64_t offset, uint64_t size, const char *buf,
 {
   ceph_assert(ceph_mutex_is_locked_by_me(client_lock));
 
+  if ((uint64_t)(offset+size) > mdsmap->get_max_filesize()) //too large!
+    return -CEPHFS_EFBIG;
+
+  // copy into fresh buffer (since our write may be resub, async).  the
+  // caller's data is not client state, so other threads need not wait
+  // for the copy, as with the copy out in _preadv_pwritev_locked()
+  bufferlist bl;
+  client_lock.unlock();
+  if (buf) {
+    if (size > 0)
+      bl.append(buf, size);
+  } else if (iov){
+    // size may be clamped below the total of the iovs
+    for (int i = 0; i < iovcnt && bl.length() < size; i++) {
+      if (iov[i].iov_len > 0) {
+        bl.append((const char *)iov[i].iov_base,
+                  std::min<uint64_t>(iov[i].iov_len, size - bl.length()));
+      }
+    }
+  }
+  client_lock.lock();
+
+  return _write(f, offset, std::move(bl));
+}
+
+int64_t Client::_write(Fh *f, int64_t offset, bufferlist&& bl)
+{
+  ceph_assert(ceph_mutex_is_locked_by_me(client_lock));
+
   uint64_t fpos = 0;
+  uint64_t size = bl.length();
 
   if ((uint64_t)(offset+size) > mdsmap->get_max_filesize()) //too large!
     return -CEPHFS_EFBIG;
@@ -10286,19 +10487,6 @@ int64_t Client::_write(Fh *f, int64_t offset, uint64_t size, const char *buf,
     ceph_assert(in->inline_version > 0);
   }
 
-  // copy into fresh buffer (since our write may be resub, async)
-  bufferlist bl;
-  if (buf) {
-    if (size > 0)
-      bl.append(buf, size);
-  } else if (iov){
-    for (int i = 0; i < iovcnt; i++) {
-      if (iov[i].iov_len > 0) {
-        bl.append((const char *)iov[i].iov_base, iov[i].iov_len);
-      }
-    }
-  }
-
   utime_t lat;
   uint64_t totalwritten;
   int want, have;
@@ -13489,6 +13677,25 @@ int Client::_unlink(Inode *dir, const char *name, const UserPerm& perm)
 
   req->set_inode(dir);
 
+  if (cct->_conf.get_val<bool>("client_async_dirops") &&
+      !in->is_dir() && in->nlink == 1) {
+    // the unlink caps, held until the reply, keep whoever the MDS revokes
+    // them for from seeing the dentry before it is gone
+    if (dir->caps_issued_mask(CEPH_CAP_FILE_EXCL | CEPH_CAP_DIR_UNLINK)) {
+      get_cap_ref(dir, CEPH_CAP_DIR_UNLINK);
+      if (make_async_request(req, perm)) {
+	unlink(de, true, true);
+	trim_cache();
+	ldout(cct, 8) << "unlink(" << path << ") = 0 (async)" << dendl;
+	return 0;
+      }
+      put_cap_ref(dir, CEPH_CAP_DIR_UNLINK);
+    } else if (!(dir->flags & I_ASYNC_DIROPS)) {
+      dir->flags |= I_ASYNC_DIROPS;
+      check_caps(dir, CHECK_CAPS_NODELAY);
+    }
+  }
+
   res = make_request(req, perm);
 
   trim_cache();
@@ -14336,6 +14543,34 @@ int Client::ll_write(Fh *fh, loff_t off, loff_t len, const char *data)
   return r;
 }
 
+int Client::ll_write(Fh *fh, loff_t off, bufferlist&& bl)
+{
+  ldout(cct, 3) << "ll_write " << fh << " " << fh->inode->ino << " " << off <<
+    "~" << bl.length() << dendl;
+  tout(cct) << "ll_write" << std::endl;
+  tout(cct) << (uintptr_t)fh << std::endl;
+  tout(cct) << off << std::endl;
+  tout(cct) << bl.length() << std::endl;
+
+  RWRef_t mref_reader(mount_state, CLIENT_MOUNTING);
+  if (!mref_reader.is_state_satisfied())
+    return -CEPHFS_ENOTCONN;
+
+  /* We can't return bytes written larger than INT_MAX, clamp len to that */
+  if (bl.length() > INT_MAX) {
+    bufferlist head;
+    bl.splice(0, INT_MAX, &head);
+    bl = std::move(head);
+  }
+  std::scoped_lock lock(client_lock);
+
+  uint64_t len = bl.length();
+  int r = _write(fh, off, std::move(bl));
+  ldout(cct, 3) << "ll_write " << fh << " " << off << "~" << len << " = " << r
+		<< dendl;
+  return r;
+}
+
 int64_t Client::ll_writev(struct Fh *fh, const struct iovec *iov, int iovcnt, int64_t off)
 {
   RWRef_t mref_reader(mount_state, CLIENT_MOUNTING);
@@ -233,6 +233,7 @@ class Client : public Dispatcher, public md_config_obs_t {
 public:
   friend class C_Block_Sync; // Calls block map and protected helpers
   friend class C_Client_CacheInvalidate;  // calls ino_invalidate_cb
+  friend class C_Client_KernelWriteback;  // calls _async_kernel_writeback()
   friend class C_Client_DentryInvalidate;  // calls dentry_invalidate_cb
   friend class C_Client_FlushComplete; // calls put_inode()
   friend class C_Client_Remount;
@@ -627,6 +628,8 @@ public:
 
   int ll_read(Fh *fh, loff_t off, loff_t len, bufferlist *bl);
   int ll_write(Fh *fh, loff_t off, loff_t len, const char *data);
+  // takes the data as it is, without copying it
+  int ll_write(Fh *fh, loff_t off, bufferlist&& bl);
   int64_t ll_readv(struct Fh *fh, const struct iovec *iov, int iovcnt, int64_t off);
   int64_t ll_writev(struct Fh *fh, const struct iovec *iov, int iovcnt, int64_t off);
   loff_t ll_lseek(Fh *fh, loff_t offset, int whence);
@@ -654,6 +657,12 @@ public:
   int ll_osdaddr(int osd, char* buf, size_t size);
 
   void ll_register_callbacks(struct ceph_client_callback_args *args);
+  // the invalidate callback also writes back what the kernel caches, and
+  // the kernel caches writes (fuse writeback_cache)
+  void set_kernel_writeback_cache(bool on) {
+    std::scoped_lock l(client_lock);
+    kernel_writeback_cache = on;
+  }
   int test_dentry_handling(bool can_invalidate);
 
   const char** get_tracked_conf_keys() const override;
@@ -747,6 +756,8 @@ public:
   void _invalidate_inode_cache(Inode *in);
   void _invalidate_inode_cache(Inode *in, int64_t off, int64_t len);
   void _async_invalidate(vinodeno_t ino, int64_t off, int64_t len);
+  void _schedule_kernel_writeback(Inode *in);
+  void _async_kernel_writeback(Inode *in, vinodeno_t ino);
 
   void _schedule_ino_release_callback(Inode *in);
   void _async_inode_release(vinodeno_t ino);
@@ -915,8 +926,14 @@ protected:
   int make_request(MetaRequest *req, const UserPerm& perms,
 		   InodeRef *ptarget = 0, bool *pcreated = 0,
 		   mds_rank_t use_mds=-1, bufferlist *pdirbl=0);
+  bool make_async_request(MetaRequest *req, const UserPerm& perms);
   void put_request(MetaRequest *request);
+  void register_request(MetaRequest *request, const UserPerm& perms);
   void unregister_request(MetaRequest *request);
+  MetaSession *send_request_and_wait(MetaRequest *request);
+  void kick_request(MetaRequest *request);
+  void retry_async_request(MetaRequest *request);
+  void finish_async_request(MetaRequest *request, int r);
 
   int verify_reply_trace(int r, MetaSession *session, MetaRequest *request,
 			 const MConstRef<MClientReply>& reply,
@@ -1350,6 +1367,7 @@ private:
   int64_t _read(Fh *fh, int64_t offset, uint64_t size, bufferlist *bl);
   int64_t _write(Fh *fh, int64_t offset, uint64_t size, const char *buf,
           const struct iovec *iov, int iovcnt);
+  int64_t _write(Fh *fh, int64_t offset, bufferlist&& bl);
   int64_t _preadv_pwritev_locked(Fh *fh, const struct iovec *iov,
                                  unsigned iovcnt, int64_t offset,
                                  bool write, bool clamp_to_int);
@@ -1447,6 +1465,7 @@ private:
   client_switch_interrupt_callback_t switch_interrupt_cb = nullptr;
   client_remount_callback_t remount_cb = nullptr;
   client_ino_callback_t ino_invalidate_cb = nullptr;
+  bool kernel_writeback_cache = false;
   client_dentry_callback_t dentry_invalidate_cb = nullptr;
   client_umask_callback_t umask_cb = nullptr;
   client_ino_release_t ino_release_cb = nullptr;
@@ -1459,6 +1478,7 @@ private:
   Finisher remount_finisher;
   Finisher async_ino_releasor;
   Finisher objecter_finisher;
+  Finisher async_dirop_finisher;
 
   utime_t last_cap_renew;
 
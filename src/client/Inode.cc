@@ -325,6 +325,9 @@ int Inode::caps_wanted()
   int want = caps_file_wanted() | caps_used();
   if (want & CEPH_CAP_FILE_BUFFER)
     want |= CEPH_CAP_FILE_EXCL;
+  // the caps that let unlinks in a directory go async
+  if (flags & I_ASYNC_DIROPS)
+    want |= CEPH_CAP_FILE_EXCL | CEPH_CAP_DIR_UNLINK;
   return want;
 }
 
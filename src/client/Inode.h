@@ -113,6 +113,7 @@ struct CapSnap {
 #define I_KICK_FLUSH		(1 << 3)
 #define I_CAP_DROPPED		(1 << 4)
 #define I_ERROR_FILELOCK	(1 << 5)
+#define I_ASYNC_DIROPS		(1 << 6)
 
 struct Inode : RefCountedObject {
   Client *client;
@@ -53,6 +53,7 @@ public:
   ceph::cref_t<MClientReply> reply;         // the reply
   bool kick;
   bool success;
+  bool async_retry;  // an async request being retried by the finisher
   
   // readdir result
   dir_result_t *dirp;
@@ -84,7 +85,7 @@ public:
     mds(-1), resend_mds(-1), send_to_auth(false), sent_on_mseq(0),
     num_fwd(0), retry_attempt(0),
     reply(0),
-    kick(false), success(false), dirp(NULL),
+    kick(false), success(false), async_retry(false), dirp(NULL),
     got_unsafe(false), item(this), unsafe_item(this),
     unsafe_dir_item(this), unsafe_target_item(this),
     caller_cond(0), dispatch_cond(0) {
@@ -183,6 +184,10 @@ public:
   void set_dentry_wanted() {
     head.flags = head.flags | CEPH_MDS_FLAG_WANT_DENTRY;
   }
+  void set_async() {
+    head.flags = head.flags | CEPH_MDS_FLAG_ASYNC;
+  }
+  bool is_async() const { return head.flags & CEPH_MDS_FLAG_ASYNC; }
   int get_op() { return head.op; }
   ceph_tid_t get_tid() { return tid; }
   filepath& get_filepath() { return path; }
@@ -154,6 +154,9 @@ public:
   ceph::unordered_map<uint64_t,int> snap_stag_map;
   ceph::unordered_map<int,uint64_t> stag_snap_map;
 
+  // the kernel caches the writes, see fuse_writeback_cache
+  bool writeback_cache = false;
+
   pthread_key_t fuse_req_key = 0;
   void set_fuse_req(fuse_req_t);
   fuse_req_t get_fuse_req();
@@ -636,6 +639,21 @@ static void fuse_ll_link(fuse_req_t req, fuse_ino_t ino, fuse_ino_t newparent,
   cfuse->iput(nin);
 }
 
+static void fuse_ll_adjust_open_flags(CephFuse::Handle *cfuse,
+				      struct fuse_file_info *fi)
+{
+  if (!cfuse->writeback_cache)
+    return;
+  // with the writeback cache, the kernel reads in the pages it writes
+  // partially, even through write only files, and sets the offset of the
+  // appends itself
+  if ((fi->flags & O_ACCMODE) == O_WRONLY) {
+    fi->flags &= ~O_ACCMODE;
+    fi->flags |= O_RDWR;
+  }
+  fi->flags &= ~O_APPEND;
+}
+
 static void fuse_ll_open(fuse_req_t req, fuse_ino_t ino,
 			 struct fuse_file_info *fi)
 {
@@ -646,6 +664,7 @@ static void fuse_ll_open(fuse_req_t req, fuse_ino_t ino,
   UserPerm perms(ctx->uid, ctx->gid);
   get_fuse_groups(perms, req);
 
+  fuse_ll_adjust_open_flags(cfuse, fi);
   int r = cfuse->client->ll_open(in, fi->flags, &fh, perms);
   if (r == 0) {
     fi->fh = (uint64_t)fh;
@@ -714,6 +733,39 @@ static void fuse_ll_write(fuse_req_t req, fuse_ino_t ino, const char *buf,
     fuse_reply_err(req, get_sys_errno(-r));
 }
 
+#if FUSE_VERSION >= FUSE_MAKE_VERSION(2, 9)
+static void fuse_ll_write_buf(fuse_req_t req, fuse_ino_t ino,
+			      struct fuse_bufvec *in_buf, off_t off,
+			      struct fuse_file_info *fi)
+{
+  CephFuse::Handle *cfuse = fuse_ll_req_prepare(req);
+  Fh *fh = reinterpret_cast<Fh*>(fi->fh);
+  size_t size = fuse_buf_size(in_buf);
+  bufferlist bl;
+  if (size > 0) {
+    // have the data, spliced from the fuse device if the kernel does so,
+    // land in the buffer the client caches and sends on, rather than
+    // copying it there from the buffer of libfuse
+    bufferptr bp = ceph::buffer::create_page_aligned(size);
+    struct fuse_bufvec out_buf = FUSE_BUFVEC_INIT(size);
+    out_buf.buf[0].mem = bp.c_str();
+    ssize_t copied = fuse_buf_copy(&out_buf, in_buf,
+				   (enum fuse_buf_copy_flags)0);
+    if (copied < 0) {
+      fuse_reply_err(req, (int)-copied);
+      return;
+    }
+    bp.set_length(copied);
+    bl.push_back(std::move(bp));
+  }
+  int r = cfuse->client->ll_write(fh, off, std::move(bl));
+  if (r >= 0)
+    fuse_reply_write(req, r);
+  else
+    fuse_reply_err(req, get_sys_errno(-r));
+}
+#endif
+
 static void fuse_ll_flush(fuse_req_t req, fuse_ino_t ino,
 			  struct fuse_file_info *fi)
 {
@@ -892,6 +944,7 @@ static void fuse_ll_create(fuse_req_t req, fuse_ino_t parent, const char *name,
 
   memset(&fe, 0, sizeof(fe));
 
+  fuse_ll_adjust_open_flags(cfuse, fi);
   // pass &i2 for the created inode so that ll_create takes an initial ll_ref
   int r = cfuse->client->ll_create(i1, name, mode, fi->flags, &fe.attr, &i2,
 				   &fh, perms);
@@ -1077,6 +1130,22 @@ static void do_init(void *data, fuse_conn_info *conn)
   if(conn->capable & FUSE_CAP_SPLICE_MOVE)
     conn->want |= FUSE_CAP_SPLICE_MOVE;
 
+#ifdef FUSE_CAP_WRITEBACK_CACHE
+  if (client->cct->_conf.get_val<bool>("fuse_writeback_cache")) {
+    if (!client->cct->_conf.get_val<bool>("fuse_use_invalidate_cb") ||
+	client->cct->_conf.get_val<bool>("fuse_disable_pagecache")) {
+      derr << "fuse_ll: do_init: fuse_writeback_cache needs the page cache"
+	   << " and fuse_use_invalidate_cb, not caching writes" << dendl;
+    } else if (conn->capable & FUSE_CAP_WRITEBACK_CACHE) {
+      conn->want |= FUSE_CAP_WRITEBACK_CACHE;
+    }
+  }
+  if (conn->want & FUSE_CAP_WRITEBACK_CACHE) {
+    cfuse->writeback_cache = true;
+    client->set_kernel_writeback_cache(true);
+  }
+#endif
+
 #if !defined(__APPLE__)
   if (!client->fuse_default_permissions && client->ll_handle_umask()) {
     // apply umask in userspace if posix acl is enabled
@@ -1151,7 +1220,7 @@ const static struct fuse_lowlevel_ops fuse_ll_oper = {
  poll: 0,
 #endif
 #if FUSE_VERSION >= FUSE_MAKE_VERSION(2, 9)
- write_buf: 0,
+ write_buf: fuse_ll_write_buf,
  retrieve_reply: 0,
  forget_multi: 0,
  flock: fuse_ll_flock,
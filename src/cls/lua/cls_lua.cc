@@ -3,8 +3,12 @@
  */
 #include <errno.h>
 #include <setjmp.h>
+#include <list>
+#include <mutex>
 #include <string>
+#include <string_view>
 #include <sstream>
+#include <unordered_map>
 #include <lua.hpp>
 #include "include/types.h"
 #include "objclass/objclass.h"
@@ -752,6 +756,68 @@ static void clslua_setup_env(lua_State *L)
   lua_pop(L, 1);
 }
 
+/*
+ * Cache of compiled chunks, by their source. Loading the bytecode of a
+ * chunk skips parsing and compiling its source, which is most of the cost
+ * of a short handler. Each call still runs in a Lua state of its own.
+ */
+#define CLSLUA_MAX_CACHED_CHUNKS 64
+
+struct clslua_chunk {
+  std::string script;
+  std::string code;
+};
+
+static std::mutex clslua_chunk_lock;
+/* the most recently used first */
+static std::list<clslua_chunk> clslua_chunk_lru;
+static std::unordered_map<std::string_view,
+                          std::list<clslua_chunk>::iterator> clslua_chunks;
+
+static int clslua_chunk_writer(lua_State *L, const void *p, size_t sz,
+    void *ud)
+{
+  static_cast<std::string*>(ud)->append(static_cast<const char*>(p), sz);
+  return 0;
+}
+
+/*
+ * Pushes the compiled chunk of the script, or an error message like
+ * luaL_loadstring.
+ */
+static int clslua_load_chunk(lua_State *L, const std::string& script)
+{
+  std::string code;
+  {
+    std::lock_guard l(clslua_chunk_lock);
+    auto it = clslua_chunks.find(script);
+    if (it != clslua_chunks.end()) {
+      clslua_chunk_lru.splice(clslua_chunk_lru.begin(), clslua_chunk_lru,
+          it->second);
+      code = it->second->code;
+    }
+  }
+  if (!code.empty())
+    return luaL_loadbufferx(L, code.data(), code.size(), "=cls_lua", "b");
+
+  int ret = luaL_loadstring(L, script.c_str());
+  if (ret)
+    return ret;
+  if (lua_dump(L, clslua_chunk_writer, &code, 0) || code.empty())
+    return 0;
+
+  std::lock_guard l(clslua_chunk_lock);
+  if (clslua_chunks.count(script))
+    return 0;
+  clslua_chunk_lru.push_front(clslua_chunk{script, std::move(code)});
+  clslua_chunks[clslua_chunk_lru.front().script] = clslua_chunk_lru.begin();
+  if (clslua_chunk_lru.size() > CLSLUA_MAX_CACHED_CHUNKS) {
+    clslua_chunks.erase(clslua_chunk_lru.back().script);
+    clslua_chunk_lru.pop_back();
+  }
+  return 0;
+}
+
 /*
  * Schema:
  * {
@@ -898,7 +964,7 @@ static int clslua_eval(lua_State *L)
   lua_settable(L, LUA_REGISTRYINDEX);
 
   /* load and compile chunk */
-  if (luaL_loadstring(L, ctx->script.c_str()))
+  if (clslua_load_chunk(L, ctx->script))
     return lua_error(L);
 
   /* execute chunk */
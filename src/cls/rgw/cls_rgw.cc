@@ -45,13 +45,15 @@ CLS_NAME(rgw)
 #define BI_BUCKET_LOG_INDEX           1
 #define BI_BUCKET_OBJ_INSTANCE_INDEX  2
 #define BI_BUCKET_OLH_DATA_INDEX      3
+#define BI_BUCKET_RESHARD_LOG_INDEX   4
 
-#define BI_BUCKET_LAST_INDEX          4
+#define BI_BUCKET_LAST_INDEX          5
 
 static std::string bucket_index_prefixes[] = { "", /* special handling for the objs list index */
                                           "0_",     /* bucket log index */
                                           "1000_",  /* obj instance index */
                                           "1001_",  /* olh data index */
+                                          "2001_",  /* reshard log index */
 
                                           /* this must be the last index */
                                           "9999_",};
@@ -123,6 +125,31 @@ static void bi_log_index_key(cls_method_context_t hctx, string& key, string& id,
   key.append(id);
 }
 
+static void encode_reshard_log_key(const string& name, string *key)
+{
+  *key = BI_PREFIX_CHAR;
+  key->append(bucket_index_prefixes[BI_BUCKET_RESHARD_LOG_INDEX]);
+  key->append(name);
+}
+
+/*
+ * While a reshard copies the entries of a shard with the writes to it
+ * going on, note the names of the objects whose entries change, so it
+ * can copy those again once it blocks the writes.
+ */
+static int reshard_log_index_operation(cls_method_context_t hctx,
+                                       const rgw_bucket_dir_header& header,
+                                       const string& name)
+{
+  if (!header.resharding_in_logrecord()) {
+    return 0;
+  }
+  string key;
+  encode_reshard_log_key(name, &key);
+  bufferlist bl;
+  return cls_cxx_map_set_val(hctx, key, &bl);
+}
+
 static int log_index_operation(cls_method_context_t hctx, cls_rgw_obj_key& obj_key, RGWModifyOp op,
                                string& tag, real_time& timestamp,
                                rgw_bucket_entry_ver& ver, RGWPendingState state, uint64_t index_ver,
@@ -942,34 +969,22 @@ static int read_key_entry(cls_method_context_t hctx, cls_rgw_obj_key& key,
   return 0;
 }
 
-int rgw_bucket_complete_op(cls_method_context_t hctx, bufferlist *in, bufferlist *out)
+// applies op to the index, and to the in-memory header the caller
+// writes unless the op is cancelled
+static int complete_op(cls_method_context_t hctx, rgw_bucket_dir_header& header,
+                       rgw_cls_obj_complete_op& op, bool *cancelled)
 {
-  // decode request
-  rgw_cls_obj_complete_op op;
-  auto iter = in->cbegin();
-  try {
-    decode(op, iter);
-  } catch (ceph::buffer::error& err) {
-    CLS_LOG(1, "ERROR: rgw_bucket_complete_op(): failed to decode request\n");
-    return -EINVAL;
-  }
+  *cancelled = false;
   CLS_LOG(1, "rgw_bucket_complete_op(): request: op=%d name=%s instance=%s ver=%lu:%llu tag=%s\n",
           op.op, op.key.name.c_str(), op.key.instance.c_str(),
           (unsigned long)op.ver.pool, (unsigned long long)op.ver.epoch,
           op.tag.c_str());
 
-  rgw_bucket_dir_header header;
-  int rc = read_bucket_header(hctx, &header);
-  if (rc < 0) {
-    CLS_LOG(1, "ERROR: rgw_bucket_complete_op(): failed to read header\n");
-    return -EINVAL;
-  }
-
   rgw_bucket_dir_entry entry;
   bool ondisk = true;
 
   string idx;
-  rc = read_key_entry(hctx, op.key, &idx, &entry);
+  int rc = read_key_entry(hctx, op.key, &idx, &entry);
   if (rc == -ENOENT) {
     entry.key = op.key;
     entry.ver = op.ver;
@@ -1008,6 +1023,7 @@ int rgw_bucket_complete_op(cls_method_context_t hctx, bufferlist *in, bufferlist
 
   bufferlist op_bl;
   if (cancel) {
+    *cancelled = true;
     if (op.tag.size()) {
       bufferlist new_key_bl;
       encode(entry, new_key_bl);
@@ -1068,6 +1084,9 @@ int rgw_bucket_complete_op(cls_method_context_t hctx, bufferlist *in, bufferlist
     if (rc < 0)
       return rc;
   }
+  rc = reshard_log_index_operation(hctx, header, op.key.name);
+  if (rc < 0)
+    return rc;
 
   CLS_LOG(20, "rgw_bucket_complete_op(): remove_objs.size()=%d\n", (int)op.remove_objs.size());
   for (auto remove_iter = op.remove_objs.begin(); remove_iter != op.remove_objs.end(); ++remove_iter) {
@@ -1102,6 +1121,95 @@ int rgw_bucket_complete_op(cls_method_context_t hctx, bufferlist *in, bufferlist
       CLS_LOG(1, "rgw_bucket_complete_op(): cls_cxx_map_remove_key, failed to remove entry, name=%s instance=%s read_index_entry ret=%d\n", remove_key.name.c_str(), remove_key.instance.c_str(), rc);
       continue;
     }
+    rc = reshard_log_index_operation(hctx, header, remove_key.name);
+    if (rc < 0)
+      return rc;
+  }
+
+  return 0;
+}
+
+int rgw_bucket_complete_op(cls_method_context_t hctx, bufferlist *in, bufferlist *out)
+{
+  // decode request
+  rgw_cls_obj_complete_op op;
+  auto iter = in->cbegin();
+  try {
+    decode(op, iter);
+  } catch (ceph::buffer::error& err) {
+    CLS_LOG(1, "ERROR: rgw_bucket_complete_op(): failed to decode request\n");
+    return -EINVAL;
+  }
+
+  rgw_bucket_dir_header header;
+  int rc = read_bucket_header(hctx, &header);
+  if (rc < 0) {
+    CLS_LOG(1, "ERROR: rgw_bucket_complete_op(): failed to read header\n");
+    return -EINVAL;
+  }
+
+  bool cancelled;
+  rc = complete_op(hctx, header, op, &cancelled);
+  if (rc < 0 || cancelled) {
+    return rc;
+  }
+  return write_bucket_header(hctx, &header);
+}
+
+/*
+ * Several complete ops in one write of the index shard: the index
+ * shard is read and written once per batch instead of once per op,
+ * and so is the header.  A failure of any of them fails the whole
+ * batch, so that the caller can fall back to completing them one by
+ * one.  As the reads do not see the writes of the same transaction,
+ * the ops must be on different object names, and may not remove other
+ * entries.
+ */
+int rgw_bucket_complete_ops(cls_method_context_t hctx, bufferlist *in, bufferlist *out)
+{
+  // decode request
+  rgw_cls_obj_complete_ops_op op;
+  auto iter = in->cbegin();
+  try {
+    decode(op, iter);
+  } catch (ceph::buffer::error& err) {
+    CLS_LOG(1, "ERROR: %s(): failed to decode request\n", __func__);
+    return -EINVAL;
+  }
+
+  // the versions and the delete markers of an object may share entries
+  std::set<string> names;
+  for (auto& o : op.ops) {
+    if (!names.insert(o.key.name).second) {
+      CLS_LOG(1, "ERROR: %s(): duplicate name=%s\n", __func__,
+              o.key.name.c_str());
+      return -EINVAL;
+    }
+    if (!o.remove_objs.empty() && op.ops.size() > 1) {
+      CLS_LOG(1, "ERROR: %s(): op name=%s removes entries in a batch\n",
+              __func__, o.key.name.c_str());
+      return -EINVAL;
+    }
+  }
+
+  rgw_bucket_dir_header header;
+  int rc = read_bucket_header(hctx, &header);
+  if (rc < 0) {
+    CLS_LOG(1, "ERROR: %s(): failed to read header\n", __func__);
+    return -EINVAL;
+  }
+
+  for (size_t i = 0; i < op.ops.size(); i++) {
+    if (i > 0) {
+      // each op logs under its own index version, as if they came one by one
+      ++header.ver;
+    }
+    bool cancelled;
+    rc = complete_op(hctx, header, op.ops[i], &cancelled);
+    if (rc < 0) {
+      CLS_LOG(1, "ERROR: %s(): op %zu failed: %d\n", __func__, i, rc);
+      return rc;
+    }
   }
 
   return write_bucket_header(hctx, &header);
@@ -1677,16 +1785,20 @@ static int rgw_bucket_link_olh(cls_method_context_t hctx, bufferlist *in, buffer
     return ret;
   }
 
-  if (!op.log_op) {
-   return 0;
-  }
-
   rgw_bucket_dir_header header;
   ret = read_bucket_header(hctx, &header);
   if (ret < 0) {
     CLS_LOG(1, "ERROR: rgw_bucket_link_olh(): failed to read header\n");
     return ret;
   }
+  ret = reshard_log_index_operation(hctx, header, op.key.name);
+  if (ret < 0) {
+    return ret;
+  }
+
+  if (!op.log_op) {
+   return 0;
+  }
   if (header.syncstopped) {
     return 0;
   }
@@ -1842,16 +1954,20 @@ static int rgw_bucket_unlink_instance(cls_method_context_t hctx, bufferlist *in,
     return ret;
   }
 
-  if (!op.log_op) {
-    return 0;
-  }
-
   rgw_bucket_dir_header header;
   ret = read_bucket_header(hctx, &header);
   if (ret < 0) {
     CLS_LOG(1, "ERROR: rgw_bucket_unlink_instance(): failed to read header\n");
     return ret;
   }
+  ret = reshard_log_index_operation(hctx, header, op.key.name);
+  if (ret < 0) {
+    return ret;
+  }
+
+  if (!op.log_op) {
+    return 0;
+  }
   if (header.syncstopped) {
     return 0;
   }
@@ -1972,7 +2088,13 @@ static int rgw_bucket_trim_olh_log(cls_method_context_t hctx, bufferlist *in, bu
     return ret;
   }
 
-  return 0;
+  rgw_bucket_dir_header header;
+  ret = read_bucket_header(hctx, &header);
+  if (ret < 0) {
+    CLS_LOG(1, "ERROR: %s(): failed to read header\n", __func__);
+    return ret;
+  }
+  return reshard_log_index_operation(hctx, header, op.olh.name);
 }
 
 static int rgw_bucket_clear_olh(cls_method_context_t hctx, bufferlist *in, bufferlist *out)
@@ -2013,6 +2135,17 @@ static int rgw_bucket_clear_olh(cls_method_context_t hctx, bufferlist *in, buffe
     return ret;
   }
 
+  rgw_bucket_dir_header header;
+  ret = read_bucket_header(hctx, &header);
+  if (ret < 0) {
+    CLS_LOG(1, "ERROR: %s(): failed to read header\n", __func__);
+    return ret;
+  }
+  ret = reshard_log_index_operation(hctx, header, op.key.name);
+  if (ret < 0) {
+    return ret;
+  }
+
   rgw_bucket_dir_entry plain_entry;
 
   /* read plain entry, make sure it's a versioned place holder */
@@ -2120,6 +2253,10 @@ int rgw_dir_suggest_changes(cls_method_context_t hctx,
       rgw_bucket_category_stats& stats = header.stats[cur_change.meta.category];
       bool log_op = (op & CEPH_RGW_DIR_SUGGEST_LOG_OP) != 0;
       op &= CEPH_RGW_DIR_SUGGEST_OP_MASK;
+      ret = reshard_log_index_operation(hctx, header, cur_change.key.name);
+      if (ret < 0) {
+        return ret;
+      }
       switch(op) {
       case CEPH_RGW_REMOVE:
         CLS_LOG(10, "CEPH_RGW_REMOVE name=%s instance=%s\n", cur_change.key.name.c_str(), cur_change.key.instance.c_str());
@@ -3963,6 +4100,47 @@ static int rgw_reshard_remove(cls_method_context_t hctx, bufferlist *in, bufferl
   return ret;
 }
 
+static int trim_reshard_log(cls_method_context_t hctx)
+{
+  string key_begin;
+  encode_reshard_log_key(string(), &key_begin);
+  string key_end(1, static_cast<char>(BI_PREFIX_CHAR));
+  key_end.append(bucket_index_prefixes[BI_BUCKET_RESHARD_LOG_INDEX + 1]);
+  return cls_cxx_map_remove_range(hctx, key_begin, key_end);
+}
+
+/// list the names of the objects written to while the reshard log was on
+static int rgw_reshard_log_list(cls_method_context_t hctx, bufferlist *in, bufferlist *out)
+{
+  cls_rgw_reshard_log_list_op op;
+  auto in_iter = in->cbegin();
+  try {
+    decode(op, in_iter);
+  } catch (ceph::buffer::error& err) {
+    CLS_LOG(1, "ERROR: %s(): failed to decode request\n", __func__);
+    return -EINVAL;
+  }
+
+  string prefix;
+  encode_reshard_log_key(string(), &prefix);
+  string start_after = prefix + op.marker;
+  uint32_t max = std::min<uint32_t>(op.max, MAX_BI_LIST_ENTRIES);
+
+  map<string, bufferlist> keys;
+  cls_rgw_reshard_log_list_ret op_ret;
+  int ret = cls_cxx_map_get_vals(hctx, start_after, prefix, max, &keys,
+                                 &op_ret.is_truncated);
+  if (ret < 0) {
+    return ret;
+  }
+  for (auto& k : keys) {
+    op_ret.names.push_back(k.first.substr(prefix.size()));
+  }
+
+  encode(op_ret, *out);
+  return 0;
+}
+
 static int rgw_set_bucket_resharding(cls_method_context_t hctx, bufferlist *in,  bufferlist *out)
 {
   cls_rgw_set_bucket_resharding_op op;
@@ -3984,6 +4162,15 @@ static int rgw_set_bucket_resharding(cls_method_context_t hctx, bufferlist *in,
 
   header.new_instance.set_status(op.entry.new_bucket_instance_id, op.entry.num_shards, op.entry.reshard_status);
 
+  if (op.entry.reshard_status != cls_rgw_reshard_status::IN_PROGRESS) {
+    // a reshard starts recording or is over: drop what any earlier one
+    // left behind
+    rc = trim_reshard_log(hctx);
+    if (rc < 0) {
+      return rc;
+    }
+  }
+
   return write_bucket_header(hctx, &header);
 }
 
@@ -4007,6 +4194,11 @@ static int rgw_clear_bucket_resharding(cls_method_context_t hctx, bufferlist *in
   }
   header.new_instance.clear();
 
+  rc = trim_reshard_log(hctx);
+  if (rc < 0) {
+    return rc;
+  }
+
   return write_bucket_header(hctx, &header);
 }
 
@@ -4029,7 +4221,7 @@ static int rgw_guard_bucket_resharding(cls_method_context_t hctx, bufferlist *in
     return rc;
   }
 
-  if (header.resharding()) {
+  if (header.resharding() && !header.resharding_in_logrecord()) {
     return op.ret_err;
   }
 
@@ -4077,6 +4269,7 @@ CLS_INIT(rgw)
   cls_method_handle_t h_rgw_bucket_update_stats;
   cls_method_handle_t h_rgw_bucket_prepare_op;
   cls_method_handle_t h_rgw_bucket_complete_op;
+  cls_method_handle_t h_rgw_bucket_complete_ops;
   cls_method_handle_t h_rgw_bucket_link_olh;
   cls_method_handle_t h_rgw_bucket_unlink_instance_op;
   cls_method_handle_t h_rgw_bucket_read_olh_log;
@@ -4115,6 +4308,7 @@ CLS_INIT(rgw)
   cls_method_handle_t h_rgw_clear_bucket_resharding;
   cls_method_handle_t h_rgw_guard_bucket_resharding;
   cls_method_handle_t h_rgw_get_bucket_resharding;
+  cls_method_handle_t h_rgw_reshard_log_list;
 
   cls_register(RGW_CLASS, &h_class);
 
@@ -4127,6 +4321,7 @@ CLS_INIT(rgw)
   cls_register_cxx_method(h_class, RGW_BUCKET_UPDATE_STATS, CLS_METHOD_RD | CLS_METHOD_WR, rgw_bucket_update_stats, &h_rgw_bucket_update_stats);
   cls_register_cxx_method(h_class, RGW_BUCKET_PREPARE_OP, CLS_METHOD_RD | CLS_METHOD_WR, rgw_bucket_prepare_op, &h_rgw_bucket_prepare_op);
   cls_register_cxx_method(h_class, RGW_BUCKET_COMPLETE_OP, CLS_METHOD_RD | CLS_METHOD_WR, rgw_bucket_complete_op, &h_rgw_bucket_complete_op);
+  cls_register_cxx_method(h_class, RGW_BUCKET_COMPLETE_OPS, CLS_METHOD_RD | CLS_METHOD_WR, rgw_bucket_complete_ops, &h_rgw_bucket_complete_ops);
   cls_register_cxx_method(h_class, RGW_BUCKET_LINK_OLH, CLS_METHOD_RD | CLS_METHOD_WR, rgw_bucket_link_olh, &h_rgw_bucket_link_olh);
   cls_register_cxx_method(h_class, RGW_BUCKET_UNLINK_INSTANCE, CLS_METHOD_RD | CLS_METHOD_WR, rgw_bucket_unlink_instance, &h_rgw_bucket_unlink_instance_op);
   cls_register_cxx_method(h_class, RGW_BUCKET_READ_OLH_LOG, CLS_METHOD_RD, rgw_bucket_read_olh_log, &h_rgw_bucket_read_olh_log);
@@ -4185,6 +4380,8 @@ CLS_INIT(rgw)
 			  rgw_guard_bucket_resharding, &h_rgw_guard_bucket_resharding);
   cls_register_cxx_method(h_class, RGW_GET_BUCKET_RESHARDING, CLS_METHOD_RD ,
 			  rgw_get_bucket_resharding, &h_rgw_get_bucket_resharding);
+  cls_register_cxx_method(h_class, RGW_RESHARD_LOG_LIST, CLS_METHOD_RD,
+			  rgw_reshard_log_list, &h_rgw_reshard_log_list);
 
   return;
 }
@@ -215,6 +215,16 @@ void cls_rgw_bucket_complete_op(ObjectWriteOperation& o, RGWModifyOp op, string&
   o.exec(RGW_CLASS, RGW_BUCKET_COMPLETE_OP, in);
 }
 
+void cls_rgw_bucket_complete_ops(ObjectWriteOperation& o,
+                                 const vector<rgw_cls_obj_complete_op>& ops)
+{
+  bufferlist in;
+  rgw_cls_obj_complete_ops_op call;
+  call.ops = ops;
+  encode(call, in);
+  o.exec(RGW_CLASS, RGW_BUCKET_COMPLETE_OPS, in);
+}
+
 void cls_rgw_bucket_list_op(librados::ObjectReadOperation& op,
                             const cls_rgw_obj_key& start_obj,
                             const std::string& filter_prefix,
@@ -513,6 +523,19 @@ void cls_rgw_bilog_list(librados::ObjectReadOperation& op,
   op.exec(RGW_CLASS, RGW_BI_LOG_LIST, in, new ClsBucketIndexOpCtx<cls_rgw_bi_log_list_ret>(pdata, ret));
 }
 
+void cls_rgw_reshard_log_list(librados::ObjectReadOperation& op,
+                              const std::string& marker, uint32_t max,
+                              cls_rgw_reshard_log_list_ret *pdata, int *ret)
+{
+  cls_rgw_reshard_log_list_op call;
+  call.marker = marker;
+  call.max = max;
+
+  bufferlist in;
+  encode(call, in);
+  op.exec(RGW_CLASS, RGW_RESHARD_LOG_LIST, in, new ClsBucketIndexOpCtx<cls_rgw_reshard_log_list_ret>(pdata, ret));
+}
+
 static bool issue_bi_log_list_op(librados::IoCtx& io_ctx, const string& oid, int shard_id,
                                  BucketIndexShardsManager& marker_mgr, uint32_t max,
                                  BucketIndexAioManager *manager,
@@ -721,7 +721,9 @@ WRITE_CLASS_ENCODER(rgw_bucket_category_stats)
 enum class cls_rgw_reshard_status : uint8_t {
   NOT_RESHARDING  = 0,
   IN_PROGRESS     = 1,
-  DONE            = 2
+  DONE            = 2,
+  // copying with the writes going on, the objects they touch logged
+  IN_LOGRECORD    = 3
 };
 
 inline std::string to_string(const cls_rgw_reshard_status status)
@@ -733,6 +735,8 @@ inline std::string to_string(const cls_rgw_reshard_status status)
     return "in-progress";
   case cls_rgw_reshard_status::DONE:
     return "done";
+  case cls_rgw_reshard_status::IN_LOGRECORD:
+    return "in-logrecord";
   };
   return "Unknown reshard status";
 }
@@ -782,7 +786,11 @@ struct cls_rgw_bucket_instance_entry {
     return reshard_status != RESHARD_STATUS::NOT_RESHARDING;
   }
   bool resharding_in_progress() const {
-    return reshard_status == RESHARD_STATUS::IN_PROGRESS;
+    return reshard_status == RESHARD_STATUS::IN_PROGRESS ||
+      reshard_status == RESHARD_STATUS::IN_LOGRECORD;
+  }
+  bool resharding_in_logrecord() const {
+    return reshard_status == RESHARD_STATUS::IN_LOGRECORD;
   }
 };
 WRITE_CLASS_ENCODER(cls_rgw_bucket_instance_entry)
@@ -845,6 +853,9 @@ struct rgw_bucket_dir_header {
   bool resharding_in_progress() const {
     return new_instance.resharding_in_progress();
   }
+  bool resharding_in_logrecord() const {
+    return new_instance.resharding_in_logrecord();
+  }
 };
 WRITE_CLASS_ENCODER(rgw_bucket_dir_header)
 
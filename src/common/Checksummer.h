@@ -4,9 +4,13 @@
 #ifndef CEPH_OS_BLUESTORE_CHECKSUMMER
 #define CEPH_OS_BLUESTORE_CHECKSUMMER
 
+#include <algorithm>
+
 #include "include/buffer.h"
 #include "include/byteorder.h"
 #include "include/ceph_assert.h"
+#include "include/crc32c.h"
+#include "common/xxhash64_multi.h"
 
 #include "xxHash/xxhash.h"
 
@@ -90,6 +94,17 @@ public:
       ) {
       return p.crc32c(len, init_value);
     }
+
+    static constexpr unsigned lanes = 8;
+    static void calc_multi(
+      init_value_t init_value,
+      size_t len,
+      const unsigned char* const* data,
+      unsigned n,
+      init_value_t* out
+      ) {
+      ceph_crc32c_multi(init_value, data, len, n, out);
+    }
   };
 
   struct crc32c_16 {
@@ -111,6 +126,20 @@ public:
       ) {
       return p.crc32c(len, init_value) & 0xffff;
     }
+
+    static constexpr unsigned lanes = 8;
+    static void calc_multi(
+      init_value_t init_value,
+      size_t len,
+      const unsigned char* const* data,
+      unsigned n,
+      init_value_t* out
+      ) {
+      ceph_crc32c_multi(init_value, data, len, n, out);
+      for (unsigned i = 0; i < n; ++i) {
+	out[i] &= 0xffff;
+      }
+    }
   };
 
   struct crc32c_8 {
@@ -132,6 +161,20 @@ public:
       ) {
       return p.crc32c(len, init_value) & 0xff;
     }
+
+    static constexpr unsigned lanes = 8;
+    static void calc_multi(
+      init_value_t init_value,
+      size_t len,
+      const unsigned char* const* data,
+      unsigned n,
+      init_value_t* out
+      ) {
+      ceph_crc32c_multi(init_value, data, len, n, out);
+      for (unsigned i = 0; i < n; ++i) {
+	out[i] &= 0xff;
+      }
+    }
   };
 
   struct xxhash32 {
@@ -161,6 +204,8 @@ public:
       }
       return XXH32_digest(state);
     }
+
+    static constexpr unsigned lanes = 1;
   };
 
   struct xxhash64 {
@@ -190,8 +235,74 @@ public:
       }
       return XXH64_digest(state);
     }
+
+    static constexpr unsigned lanes = 8;
+    static void calc_multi(
+      init_value_t init_value,
+      size_t len,
+      const unsigned char* const* data,
+      unsigned n,
+      init_value_t* out
+      ) {
+      ceph_xxhash64_multi(init_value, data, len, n, out);
+    }
   };
 
+  /// checksum @p blocks blocks from @p p, handing each csum to @p f
+  /// until it returns false.  Blocks within one buffer go through
+  /// Alg::calc_multi, several at once.
+  template<class Alg, typename F>
+  static void calc_blocks(
+    typename Alg::state_t state,
+    typename Alg::init_value_t init_value,
+    size_t csum_block_size,
+    size_t blocks,
+    ceph::buffer::list::const_iterator& p,
+    F&& f
+    ) {
+    if constexpr (Alg::lanes > 1) {
+      const unsigned char* data[Alg::lanes];
+      typename Alg::init_value_t v[Alg::lanes];
+      while (blocks > 0) {
+	auto start = p;
+	const char *d;
+	size_t l = p.get_ptr_and_advance(blocks * csum_block_size, &d);
+	ceph_assert(l > 0);
+	size_t n = l / csum_block_size;
+	for (size_t i = 0; i < n; ) {
+	  unsigned k = std::min<size_t>(Alg::lanes, n - i);
+	  for (unsigned j = 0; j < k; ++j) {
+	    data[j] = reinterpret_cast<const unsigned char*>(d) +
+	      (i + j) * csum_block_size;
+	  }
+	  Alg::calc_multi(init_value, csum_block_size, data, k, v);
+	  for (unsigned j = 0; j < k; ++j) {
+	    if (!f(v[j])) {
+	      return;
+	    }
+	  }
+	  i += k;
+	}
+	blocks -= n;
+	if (l % csum_block_size) {
+	  // this block spans buffers
+	  start += n * csum_block_size;
+	  if (!f(Alg::calc(state, init_value, csum_block_size, start))) {
+	    return;
+	  }
+	  p = start;
+	  --blocks;
+	}
+      }
+    } else {
+      while (blocks--) {
+	if (!f(Alg::calc(state, init_value, csum_block_size, p))) {
+	  return;
+	}
+      }
+    }
+  }
+
   template<class Alg>
   static int calculate(
     size_t csum_block_size,
@@ -225,10 +336,11 @@ public:
     typename Alg::value_t *pv =
       reinterpret_cast<typename Alg::value_t*>(csum_data->c_str());
     pv += offset / csum_block_size;
-    while (blocks--) {
-      *pv = Alg::calc(state, init_value, csum_block_size, p);
-      ++pv;
-    }
+    calc_blocks<Alg>(state, init_value, csum_block_size, blocks, p,
+      [&pv](typename Alg::init_value_t v) {
+	*pv++ = v;
+	return true;
+      });
     Alg::fini(&state);
     return 0;
   }
@@ -253,21 +365,22 @@ public:
       reinterpret_cast<const typename Alg::value_t*>(csum_data.c_str());
     pv += offset / csum_block_size;
     size_t pos = offset;
-    while (length > 0) {
-      typename Alg::init_value_t v = Alg::calc(state, -1, csum_block_size, p);
-      if (*pv != v) {
-	if (bad_csum) {
-	  *bad_csum = v;
+    bool bad = false;
+    calc_blocks<Alg>(state, -1, csum_block_size, length / csum_block_size, p,
+      [&](typename Alg::init_value_t v) {
+	if (*pv != v) {
+	  if (bad_csum) {
+	    *bad_csum = v;
+	  }
+	  bad = true;
+	  return false;
 	}
-	Alg::fini(&state);
-	return pos;
-      }
-      ++pv;
-      pos += csum_block_size;
-      length -= csum_block_size;
-    }
+	++pv;
+	pos += csum_block_size;
+	return true;
+      });
     Alg::fini(&state);
-    return -1;  // no errors
+    return bad ? pos : -1;  // -1: no errors
   }
 };
 
@@ -1,9 +1,11 @@
 // -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
 // vim: ts=8 sw=2 smarttab
 
+#include <cstring>
 #include <random>
 
 #include "FastCDC.h"
+#include "include/ceph_assert.h"
 
 
 // Unlike FastCDC described in the paper, if we are close to the
@@ -71,35 +73,133 @@ void FastCDC::_setup(int target, int size_window_bits)
   }
 }
 
-static inline bool _scan(
-  // these are our cursor/postion...
-  bufferlist::buffers_t::const_iterator *p,
-  const char **pp, const char **pe,
-  size_t& pos,
-  size_t max,   // how much to read
-  uint64_t& fp, // fingerprint
-  uint64_t mask, const uint64_t *table)
+// The fingerprint only depends on the last 64 bytes read (the window):
+// the older ones are shifted out.  It can thus be computed from scratch
+// at any position, and a stretch can be scanned in several lanes at
+// once, each starting from the window before it.  A single fingerprint
+// is a chain of shifts and xors waiting on the previous byte; the lanes
+// are independent chains, so they run in parallel.  The stretch stops at
+// the first match of its first lane with one, which gives the same cut
+// point as scanning it byte by byte.
+
+namespace {
+
+/// the fingerprint after reading the 64 bytes before @p p
+inline uint64_t _window_fp(const unsigned char *p, const uint64_t *table)
+{
+  uint64_t fp = 0;
+  for (const unsigned char *i = p - 64; i < p; ++i) {
+    fp = (fp << 1) ^ table[*i];
+  }
+  return fp;
+}
+
+inline bool _match(uint64_t fp, uint64_t mask)
 {
-  while (pos < max) {
-    if (*pp == *pe) {
-      ++(*p);
-      *pp = (*p)->c_str();
-      *pe = *pp + (*p)->length();
+  return (fp & mask) == mask;
+}
+
+// These scan @p p for the first position with a match of @p mask, and
+// return its offset, or the length scanned if there is none, in which
+// case @p fp is updated to the fingerprint at the end.  @p fp is that at
+// @p p on entry, and the 64 bytes before @p p are readable.
+
+size_t _scan_1(const unsigned char *p, size_t len,
+	       uint64_t mask, const uint64_t *table, uint64_t *fp)
+{
+  uint64_t f = *fp;
+  for (size_t i = 0; i < len; ++i) {
+    if (_match(f, mask)) {
+      return i;
     }
-    const char *te = std::min(*pe, *pp + max - pos);
-    for (; *pp < te; ++(*pp), ++pos) {
-      if ((fp & mask) == mask) {
-	return false;
-      }
-      fp = (fp << 1) ^ table[*(unsigned char*)*pp];
+    f = (f << 1) ^ table[p[i]];
+  }
+  *fp = f;
+  return len;
+}
+
+/// scan 4 lanes of @p lane bytes
+size_t _scan_x4(const unsigned char *p, size_t lane,
+		uint64_t mask, const uint64_t *table, uint64_t *fp)
+{
+  const unsigned char *p1 = p + lane, *p2 = p1 + lane, *p3 = p2 + lane;
+  uint64_t f0 = *fp;
+  uint64_t f1 = _window_fp(p1, table);
+  uint64_t f2 = _window_fp(p2, table);
+  uint64_t f3 = _window_fp(p3, table);
+  size_t i = 0;
+  for (; i < lane; ++i) {
+    if (__builtin_expect(_match(f0, mask) | _match(f1, mask) |
+			 _match(f2, mask) | _match(f3, mask), 0)) {
+      break;
     }
-    if (pos >= max) {
-      return true;
+    f0 = (f0 << 1) ^ table[p[i]];
+    f1 = (f1 << 1) ^ table[p1[i]];
+    f2 = (f2 << 1) ^ table[p2[i]];
+    f3 = (f3 << 1) ^ table[p3[i]];
+  }
+  if (i == lane) {
+    *fp = f3;
+    return 4 * lane;
+  }
+  // a lane matched at i: the lanes before it may still match later on
+  uint64_t f[4] = {f0, f1, f2, f3};
+  for (unsigned k = 0; k < 4; ++k) {
+    if (_match(f[k], mask)) {
+      return k * lane + i;
+    }
+    size_t r = _scan_1(p + k * lane + i, lane - i, mask, table, &f[k]);
+    if (r < lane - i) {
+      return k * lane + i + r;
     }
   }
-  return true;
+  ceph_abort();
 }
 
+/// scan 4 lanes of @p lane bytes if that is @p len, or else one
+size_t _scan(const unsigned char *p, size_t len, size_t lane,
+	     uint64_t mask, const uint64_t *table, uint64_t *fp)
+{
+  if (len == 4 * lane) {
+    return _scan_x4(p, lane, mask, table, fp);
+  }
+  return _scan_1(p, len, mask, table, fp);
+}
+
+/// contiguous views of a bufferlist, read front to back
+class contiguous_reader {
+  bufferlist::buffers_t::const_iterator p;
+  size_t p_off = 0;  ///< offset of *p in the bufferlist
+  std::string scratch;
+
+public:
+  explicit contiguous_reader(const bufferlist& bl)
+    : p(bl.buffers().begin()) {}
+
+  /// the bytes [off, off + len) of the bufferlist, copied if they span
+  /// several buffers; @p off must not go back before a previous one
+  const unsigned char *get(size_t off, size_t len) {
+    while (p_off + p->length() <= off) {
+      p_off += p->length();
+      ++p;
+    }
+    if (off + len <= p_off + p->length()) {
+      return reinterpret_cast<const unsigned char*>(p->c_str()) + off - p_off;
+    }
+    scratch.resize(len);
+    auto q = p;
+    size_t q_off = off - p_off;
+    for (size_t copied = 0; copied < len; ++q, q_off = 0) {
+      size_t n = std::min<size_t>(q->length() - q_off, len - copied);
+      memcpy(scratch.data() + copied, q->c_str() + q_off, n);
+      copied += n;
+    }
+    return reinterpret_cast<const unsigned char*>(scratch.data());
+  }
+};
+
+} // anonymous namespace
+
 void FastCDC::calc_chunks(
   const bufferlist& bl,
   std::vector<std::pair<uint64_t, uint64_t>> *chunks) const
@@ -107,15 +207,17 @@ void FastCDC::calc_chunks(
   if (bl.length() == 0) {
     return;
   }
-  auto p = bl.buffers().begin();
-  const char *pp = p->c_str();
-  const char *pe = pp + p->length();
+  contiguous_reader reader(bl);
+
+  // lanes shorter than this spend more time filling their windows, and
+  // scanning past the cut point, than they save
+  const size_t lane = 1ul << std::max(9, (target_bits + 5) / 2);
+  const size_t stretch = 4 * lane;
 
   size_t pos = 0;
   size_t len = bl.length();
   while (pos < len) {
     size_t cstart = pos;
-    uint64_t fp = 0;
 
     // are we left with a min-sized (or smaller) chunk?
     if (len - pos <= (1ul << min_bits)) {
@@ -123,53 +225,37 @@ void FastCDC::calc_chunks(
       break;
     }
 
-    // skip forward to the min chunk size cut point (minus the window, so
-    // we can initialize the rolling fingerprint).
-    size_t skip = (1 << min_bits) - window;
-    pos += skip;
-    while (skip) {
-      size_t s = std::min<size_t>(pe - pp, skip);
-      skip -= s;
-      pp += s;
-      if (pp == pe) {
-	++p;
-	pp = p->c_str();
-	pe = pp + p->length();
-      }
-    }
-
-    // first fill the window
-    size_t max = pos + window;
-    while (pos < max) {
-      if (pp == pe) {
-	++p;
-	pp = p->c_str();
-	pe = pp + p->length();
-      }
-      const char *te = std::min(pe, pp + (max - pos));
-      for (; pp < te; ++pp, ++pos) {
-	fp = (fp << 1) ^ table[*(unsigned char*)pp];
-      }
-    }
+    // skip forward to the min chunk size cut point, and initialize the
+    // rolling fingerprint with the window before it.
+    pos += 1 << min_bits;
+    uint64_t fp = _window_fp(reader.get(pos - window, window) + window, table);
     ceph_assert(pos < len);
 
     // find an end marker
-    if (
+    const size_t end = std::min(len, cstart + (1 << max_bits));
+    const std::pair<size_t, uint64_t> masks[] = {
       // for the first "small" region
-      _scan(&p, &pp, &pe, pos,
-	    std::min(len, cstart + (1 << (target_bits - TARGET_WINDOW_BITS))),
-	    fp, small_mask, table) &&
+      {std::min(end, cstart + (1 << (target_bits - TARGET_WINDOW_BITS))),
+       small_mask},
       // for the middle range (close to our target)
-      (TARGET_WINDOW_BITS == 0 ||
-       _scan(&p, &pp, &pe, pos,
-	     std::min(len, cstart + (1 << (target_bits + TARGET_WINDOW_BITS))),
-	     fp, target_mask, table)) &&
+      {std::min(end, cstart + (1 << (target_bits + TARGET_WINDOW_BITS))),
+       target_mask},
       // we're past target, use large_mask!
-      _scan(&p, &pp, &pe, pos,
-	    std::min(len,
-		     cstart + (1 << max_bits)),
-	    fp, large_mask, table))
-      ;
+      {end, large_mask},
+    };
+    for (auto [until, mask] : masks) {
+      bool found = false;
+      while (pos < until && !found) {
+	size_t n = std::min(until - pos, stretch);
+	size_t r = _scan(reader.get(pos - window, window + n) + window, n,
+			 lane, mask, table, &fp);
+	pos += r;
+	found = r < n;
+      }
+      if (found) {
+	break;
+      }
+    }
 
     chunks->push_back(std::pair<uint64_t,uint64_t>(cstart, pos - cstart));
   }
@@ -15,6 +15,11 @@
 #ifndef CEPH_FINISHER_H
 #define CEPH_FINISHER_H
 
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
 #include "include/Context.h"
 #include "include/common_fwd.h"
 #include "common/Thread.h"
@@ -167,6 +172,68 @@ class Finisher {
   }
 };
 
+/** @brief Several finishers, one per shard.
+ * The contexts queued under the same key are completed in the order they
+ * were queued, by the same thread; those of different keys may be
+ * completed in parallel, by the finisher of their shard.  Each finisher
+ * completes what it has queued in batches, like any Finisher.
+ */
+class ShardedFinisher {
+  std::vector<std::unique_ptr<Finisher>> finishers;
+
+public:
+  /// With a single shard the finisher is named @p name, and its thread
+  /// @p tn; otherwise the shards are suffixed with their index.
+  ShardedFinisher(CephContext *cct, const std::string& name,
+		  const std::string& tn, unsigned num_shards) {
+    ceph_assert(num_shards > 0);
+    if (num_shards == 1) {
+      finishers.emplace_back(std::make_unique<Finisher>(cct, name, tn));
+      return;
+    }
+    for (unsigned i = 0; i < num_shards; ++i) {
+      finishers.emplace_back(std::make_unique<Finisher>(
+	cct, name + "-" + std::to_string(i), tn + std::to_string(i)));
+    }
+  }
+
+  unsigned get_num_shards() const {
+    return finishers.size();
+  }
+
+  /// the finisher of the contexts queued under @p key
+  template<typename Key>
+  Finisher& get(const Key& key) {
+    if (finishers.size() == 1) {
+      return *finishers.front();
+    }
+    // pointers and small ints have a poor spread in their low bits
+    uint64_t h = std::hash<Key>{}(key) * 0x9e3779b97f4a7c15ull;
+    return *finishers[(h >> 32) % finishers.size()];
+  }
+
+  template<typename Key, typename ...Args>
+  void queue(const Key& key, Args&& ...args) {
+    get(key).queue(std::forward<Args>(args)...);
+  }
+
+  void start() {
+    for (auto& f : finishers) {
+      f->start();
+    }
+  }
+  void stop() {
+    for (auto& f : finishers) {
+      f->stop();
+    }
+  }
+  void wait_for_empty() {
+    for (auto& f : finishers) {
+      f->wait_for_empty();
+    }
+  }
+};
+
 /// Context that is completed asynchronously on the supplied finisher.
 class C_OnFinisher : public Context {
   Context *con;
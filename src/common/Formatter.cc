@@ -22,6 +22,7 @@
 #include <algorithm>
 #include <set>
 #include <limits>
+#include <type_traits>
 
 // -----------------------
 namespace ceph {
@@ -157,44 +158,88 @@ JSONFormatter::JSONFormatter(bool p)
 void JSONFormatter::flush(std::ostream& os)
 {
   finish_pending_string();
-  os << m_ss.str();
+  os.write(m_buf.data(), m_buf.size());
   if (m_line_break_enabled)
     os << "\n";
-  m_ss.clear();
-  m_ss.str("");
+  m_buf.clear();
+}
+
+void JSONFormatter::flush(bufferlist &bl)
+{
+  finish_pending_string();
+  if (m_line_break_enabled)
+    m_buf.push_back('\n');
+  bl.append(m_buf.data(), m_buf.size());
+  m_buf.clear();
 }
 
 void JSONFormatter::reset()
 {
   m_stack.clear();
-  m_ss.clear();
-  m_ss.str("");
+  m_buf.clear();
   m_pending_string.clear();
   m_pending_string.str("");
 }
 
+void JSONFormatter::print_indent()
+{
+  for (unsigned i = 1; i < m_stack.size(); i++)
+    m_buf.append("    ");
+}
+
 void JSONFormatter::print_comma(json_formatter_stack_entry_d& entry)
 {
   if (entry.size) {
     if (m_pretty) {
-      m_ss << ",\n";
-      for (unsigned i = 1; i < m_stack.size(); i++)
-        m_ss << "    ";
+      m_buf.append(",\n");
+      print_indent();
     } else {
-      m_ss << ",";
+      m_buf.push_back(',');
     }
   } else if (m_pretty) {
-    m_ss << "\n";
-    for (unsigned i = 1; i < m_stack.size(); i++)
-      m_ss << "    ";
+    m_buf.push_back('\n');
+    print_indent();
   }
   if (m_pretty && entry.is_array)
-    m_ss << "    ";
+    m_buf.append("    ");
 }
 
 void JSONFormatter::print_quoted_string(std::string_view s)
 {
-  m_ss << '\"' << json_stream_escaper(s) << '\"';
+  // escapes the same characters as json_stream_escaper, but copies the
+  // runs in between as they are
+  static constexpr char hex[] = "0123456789abcdef";
+  m_buf.push_back('\"');
+  auto run = s.begin();
+  for (auto i = s.begin(); i != s.end(); ++i) {
+    unsigned char c = *i;
+    if (c >= 0x20 && c != '"' && c != '\\' && c != 0x7f) {
+      continue;
+    }
+    m_buf.append(run, i);
+    run = i + 1;
+    switch (c) {
+    case '"':
+      m_buf.append("\\\"");
+      break;
+    case '\\':
+      m_buf.append("\\\\");
+      break;
+    case '\t':
+      m_buf.append("\\t");
+      break;
+    case '\n':
+      m_buf.append("\\n");
+      break;
+    default:
+      m_buf.append("\\u00");
+      m_buf.push_back(hex[c >> 4]);
+      m_buf.push_back(hex[c & 0xf]);
+      break;
+    }
+  }
+  m_buf.append(run, s.end());
+  m_buf.push_back('\"');
 }
 
 void JSONFormatter::print_name(std::string_view name)
@@ -206,13 +251,15 @@ void JSONFormatter::print_name(std::string_view name)
   print_comma(entry);
   if (!entry.is_array) {
     if (m_pretty) {
-      m_ss << "    ";
+      m_buf.append("    ");
     }
-    m_ss << "\"" << name << "\"";
+    m_buf.push_back('\"');
+    m_buf.append(name);
+    m_buf.push_back('\"');
     if (m_pretty)
-      m_ss << ": ";
+      m_buf.append(": ");
     else
-      m_ss << ':';
+      m_buf.push_back(':');
   }
   ++entry.size;
 }
@@ -230,9 +277,9 @@ void JSONFormatter::open_section(std::string_view name, const char *ns, bool is_
     print_name(name);
   }
   if (is_array)
-    m_ss << '[';
+    m_buf.push_back('[');
   else
-    m_ss << '{';
+    m_buf.push_back('{');
 
   json_formatter_stack_entry_d n;
   n.is_array = is_array;
@@ -270,14 +317,13 @@ void JSONFormatter::close_section()
 
   struct json_formatter_stack_entry_d& entry = m_stack.back();
   if (m_pretty && entry.size) {
-    m_ss << "\n";
-    for (unsigned i = 1; i < m_stack.size(); i++)
-      m_ss << "    ";
+    m_buf.push_back('\n');
+    print_indent();
   }
-  m_ss << (entry.is_array ? ']' : '}');
+  m_buf.push_back(entry.is_array ? ']' : '}');
   m_stack.pop_back();
   if (m_pretty && m_stack.empty())
-    m_ss << "\n";
+    m_buf.push_back('\n');
 }
 
 void JSONFormatter::finish_pending_string()
@@ -292,10 +338,16 @@ void JSONFormatter::finish_pending_string()
 template <class T>
 void JSONFormatter::add_value(std::string_view name, T val)
 {
-  std::stringstream ss;
-  ss.precision(std::numeric_limits<T>::max_digits10);
-  ss << val;
-  add_value(name, ss.str(), false);
+  char buf[64];
+  int len;
+  if constexpr (std::is_floating_point_v<T>) {
+    // what an ostream with a precision of max_digits10 prints
+    len = snprintf(buf, sizeof(buf), "%.*g",
+		   std::numeric_limits<T>::max_digits10, val);
+  } else {
+    len = fmt::format_to_n(buf, sizeof(buf), "{}", val).size;
+  }
+  add_value(name, std::string_view(buf, len), false);
 }
 
 void JSONFormatter::add_value(std::string_view name, std::string_view val, bool quoted)
@@ -305,7 +357,7 @@ void JSONFormatter::add_value(std::string_view name, std::string_view val, bool
   }
   print_name(name);
   if (!quoted) {
-    m_ss << val;
+    m_buf.append(val);
   } else {
     print_quoted_string(val);
   }
@@ -349,12 +401,12 @@ void JSONFormatter::dump_format_va(std::string_view name, const char *ns, bool q
 
 int JSONFormatter::get_len() const
 {
-  return m_ss.str().size();
+  return m_buf.size();
 }
 
 void JSONFormatter::write_raw_data(const char *data)
 {
-  m_ss << data;
+  m_buf.append(data);
 }
 
 const char *XMLFormatter::XML_1_DTD =
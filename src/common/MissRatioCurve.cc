@@ -0,0 +1,151 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+/*
+ * Ceph - scalable distributed file system
+ *
+ * This is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License version 2.1, as published by the Free Software
+ * Foundation.  See file COPYING.
+ *
+ */
+
+#include "MissRatioCurve.h"
+
+#include <algorithm>
+
+#include "include/ceph_assert.h"
+
+namespace PriorityCache {
+
+MissRatioCurve::MissRatioCurve(size_t max_keys, double rate)
+  : max_keys(max_keys),
+    initial_threshold(std::clamp(rate, 0.0, 1.0) * (HASH_MASK + 1)),
+    threshold(initial_threshold),
+    distances(NUM_BUCKETS, 0)
+{
+  ceph_assert(max_keys > 0);
+}
+
+unsigned MissRatioCurve::bucket(uint64_t distance)
+{
+  if (distance < (1ull << MIN_BITS)) {
+    return 0;
+  }
+  unsigned l = 63 - __builtin_clzll(distance);
+  unsigned sub = (distance >> (l - 2)) & 3;
+  return 1 + (l - MIN_BITS) * 4 + sub;
+}
+
+uint64_t MissRatioCurve::bucket_start(unsigned b)
+{
+  if (b == 0) {
+    return 0;
+  }
+  if (b >= NUM_BUCKETS) {
+    return UINT64_MAX;
+  }
+  unsigned l = MIN_BITS + (b - 1) / 4;
+  return (uint64_t)(4 + (b - 1) % 4) << (l - 2);
+}
+
+void MissRatioCurve::_access(uint64_t hash, uint64_t bytes)
+{
+  std::lock_guard l(lock);
+  uint64_t t = threshold;
+  if (hash >= t) {
+    // raced with a lower threshold
+    return;
+  }
+  ++num_samples;
+  double rate = (double)t / (HASH_MASK + 1);
+  auto k = keys.find(hash);
+  if (k == keys.end()) {
+    cold += 1 / rate;
+    lru.push_front(key_t{hash, bytes});
+    keys.emplace(hash, lru.begin());
+    by_hash.insert(hash);
+    while (keys.size() > max_keys) {
+      _evict_highest();
+    }
+    return;
+  }
+  // the bytes referenced since, this key included
+  uint64_t distance = bytes;
+  for (auto p = lru.begin(); p != k->second; ++p) {
+    distance += p->bytes;
+  }
+  distances[bucket(distance / rate)] += 1 / rate;
+  k->second->bytes = bytes;
+  lru.splice(lru.begin(), lru, k->second);
+}
+
+void MissRatioCurve::_evict_highest()
+{
+  uint64_t h = *by_hash.rbegin();
+  by_hash.erase(h);
+  auto k = keys.find(h);
+  ceph_assert(k != keys.end());
+  lru.erase(k->second);
+  keys.erase(k);
+  threshold = h;
+}
+
+double MissRatioCurve::get_hits(uint64_t from, uint64_t to) const
+{
+  if (to <= from) {
+    return 0;
+  }
+  std::lock_guard l(lock);
+  double hits = 0;
+  for (unsigned b = bucket(from); b < NUM_BUCKETS; ++b) {
+    uint64_t start = bucket_start(b);
+    uint64_t end = bucket_start(b + 1);
+    if (start >= to) {
+      break;
+    }
+    // assume the distances are spread evenly over the bucket
+    uint64_t overlap = std::min(end, to) - std::max(start, from);
+    hits += distances[b] * overlap / (end - start);
+  }
+  return hits;
+}
+
+double MissRatioCurve::get_references() const
+{
+  std::lock_guard l(lock);
+  double r = cold;
+  for (auto d : distances) {
+    r += d;
+  }
+  return r;
+}
+
+uint64_t MissRatioCurve::get_num_samples() const
+{
+  std::lock_guard l(lock);
+  return num_samples;
+}
+
+void MissRatioCurve::age(double factor)
+{
+  std::lock_guard l(lock);
+  for (auto& d : distances) {
+    d *= factor;
+  }
+  cold *= factor;
+}
+
+void MissRatioCurve::reset()
+{
+  std::lock_guard l(lock);
+  lru.clear();
+  keys.clear();
+  by_hash.clear();
+  std::fill(distances.begin(), distances.end(), 0);
+  cold = 0;
+  num_samples = 0;
+  threshold = initial_threshold;
+}
+
+} // namespace PriorityCache
@@ -0,0 +1,117 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+/*
+ * Ceph - scalable distributed file system
+ *
+ * This is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License version 2.1, as published by the Free Software
+ * Foundation.  See file COPYING.
+ *
+ */
+
+#ifndef CEPH_MISS_RATIO_CURVE_H
+#define CEPH_MISS_RATIO_CURVE_H
+
+#include <atomic>
+#include <list>
+#include <set>
+#include <unordered_map>
+#include <vector>
+
+#include "common/ceph_mutex.h"
+
+namespace PriorityCache {
+
+/**
+ * MissRatioCurve - estimate how many hits a cache would get at any size
+ *
+ * The references of a cache are spatially sampled as in SHARDS
+ * (Waldspurger et al., FAST '15): a key is sampled if its hash falls
+ * under a threshold, and the reuse distance of a sampled reference, the
+ * bytes of the distinct sampled keys referenced since the previous
+ * reference of the same key, is scaled back by the sampling rate.  An
+ * LRU cache of size S hits exactly the references whose reuse distance
+ * is under S, so the histogram of the distances tells how many more
+ * hits a larger cache would have had.
+ *
+ * At most max_keys keys are tracked: the threshold is lowered, and the
+ * keys of the highest hashes are forgotten, when there are more.  Keys
+ * that are not sampled cost one hash and one compare.
+ */
+class MissRatioCurve {
+public:
+  explicit MissRatioCurve(size_t max_keys = 1024, double rate = 0.01);
+
+  /// note a reference to the @p bytes bytes of the key hashed to @p hash
+  void access(uint64_t hash, uint64_t bytes) {
+    hash = mix(hash);
+    if ((hash & HASH_MASK) >= threshold.load(std::memory_order_relaxed)) {
+      return;
+    }
+    _access(hash & HASH_MASK, bytes);
+  }
+
+  /// estimated number of references that a cache growing from @p from
+  /// to @p to bytes would turn from misses into hits
+  double get_hits(uint64_t from, uint64_t to) const;
+
+  /// estimated number of references a cache of @p size bytes hits
+  double get_hits(uint64_t size) const {
+    return get_hits(0, size);
+  }
+
+  /// estimated number of references noted in total
+  double get_references() const;
+
+  /// number of references actually sampled since the last reset()
+  uint64_t get_num_samples() const;
+
+  /// scale down the history by @p factor, so that it follows the workload
+  void age(double factor);
+
+  void reset();
+
+private:
+  static constexpr unsigned HASH_BITS = 24;
+  static constexpr uint64_t HASH_MASK = (1ull << HASH_BITS) - 1;
+  // 4 buckets for each power of two of the distance, from 4 KiB up
+  static constexpr unsigned MIN_BITS = 12;
+  static constexpr unsigned NUM_BUCKETS = 1 + 4 * (64 - MIN_BITS);
+
+  static uint64_t mix(uint64_t h) {
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdull;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ull;
+    h ^= h >> 33;
+    return h;
+  }
+  static unsigned bucket(uint64_t distance);
+  static uint64_t bucket_start(unsigned b);
+
+  struct key_t {
+    uint64_t hash;
+    uint64_t bytes;
+  };
+  typedef std::list<key_t> lru_t;
+
+  const size_t max_keys;
+  const uint64_t initial_threshold;
+  std::atomic<uint64_t> threshold;
+
+  mutable ceph::mutex lock = ceph::make_mutex("MissRatioCurve::lock");
+  lru_t lru;  ///< sampled keys, most recently referenced first
+  std::unordered_map<uint64_t, lru_t::iterator> keys;
+  std::set<uint64_t> by_hash;  ///< to forget the highest hashes first
+  std::vector<double> distances;  ///< references per reuse distance bucket
+  double cold = 0;  ///< first references
+  uint64_t num_samples = 0;
+
+  void _access(uint64_t hash, uint64_t bytes);
+  void _evict_highest();
+};
+
+} // namespace PriorityCache
+
+#endif
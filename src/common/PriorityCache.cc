@@ -13,6 +13,9 @@
  */
 
 #include "PriorityCache.h"
+
+#include <algorithm>
+
 #include "common/dout.h"
 #include "perfglue/heap_profiler.h"
 #define dout_context cct
@@ -157,6 +160,7 @@ namespace PriorityCache
     ceph_assert(!indexes.count(name));
 
     caches.emplace(name, c);
+    c->set_miss_ratio_curve_enabled(hit_gain_balance);
 
     if (!enable_perf_counters) {
       return;
@@ -265,8 +269,20 @@ namespace PriorityCache
     caches.clear();
   }
 
+  void Manager::set_hit_gain_balance(bool b)
+  {
+    hit_gain_balance = b;
+    for (auto& [n, c] : caches) {
+      c->set_miss_ratio_curve_enabled(b);
+    }
+  }
+
   void Manager::balance()
   {
+    if (hit_gain_balance) {
+      balance_ratios_by_hit_gain();
+    }
+
     int64_t mem_avail = tuned_mem;
     // Each cache is going to get a little extra from get_chunk, so shrink the
     // available memory here to compensate.
@@ -394,6 +410,72 @@ namespace PriorityCache
     }
   }
 
+  void Manager::balance_ratios_by_hit_gain()
+  {
+    // Curves with fewer samples than this are not trusted yet.
+    const uint64_t MIN_SAMPLES = 1000;
+    // Each balance, the history counts this much less, so that the ratios
+    // follow the workload.
+    const double AGE_FACTOR = 0.9;
+
+    // The caches with a curve split the sum of their ratios between them
+    std::vector<std::pair<std::shared_ptr<PriCache>, MissRatioCurve*>> estimated;
+    double share = 0;
+    for (auto& [n, c] : caches) {
+      auto mrc = c->get_miss_ratio_curve();
+      if (mrc && mrc->get_num_samples() >= MIN_SAMPLES) {
+        estimated.emplace_back(c, mrc);
+        share += c->get_cache_ratio();
+      }
+    }
+    if (estimated.size() >= 2 && share > 0) {
+      // Give memory away a step at a time to the cache it gets the most
+      // hits, until no cache gains from more.
+      uint64_t mem = tuned_mem * share;
+      uint64_t step = std::max<uint64_t>(mem / 128, 1 << 20);
+      std::vector<uint64_t> alloc(estimated.size(), 0);
+      uint64_t left = mem;
+      while (left >= step) {
+        int best = -1;
+        double best_hits = 0;
+        for (size_t i = 0; i < estimated.size(); ++i) {
+          double hits = estimated[i].second->get_hits(alloc[i], alloc[i] + step);
+          if (hits > best_hits) {
+            best = i;
+            best_hits = hits;
+          }
+        }
+        if (best < 0) {
+          break;
+        }
+        alloc[best] += step;
+        left -= step;
+      }
+      // What no cache would get hits with is split by the old ratios.
+      std::vector<double> ratios(estimated.size());
+      for (size_t i = 0; i < estimated.size(); ++i) {
+        auto& c = estimated[i].first;
+        ratios[i] = share * (alloc[i] + left * c->get_cache_ratio() / share) / mem;
+      }
+      for (size_t i = 0; i < estimated.size(); ++i) {
+        auto& c = estimated[i].first;
+        ldout(cct, 10) << __func__ << " " << c->get_cache_name()
+                       << " ratio: " << c->get_cache_ratio()
+                       << " -> " << ratios[i]
+                       << " hits at current ratio: "
+                       << estimated[i].second->get_hits(tuned_mem * c->get_cache_ratio())
+                       << " of " << estimated[i].second->get_references()
+                       << dendl;
+        c->set_cache_ratio(ratios[i]);
+      }
+    }
+    for (auto& [n, c] : caches) {
+      if (auto mrc = c->get_miss_ratio_curve(); mrc) {
+        mrc->age(AGE_FACTOR);
+      }
+    }
+  }
+
   PriCache::~PriCache()
   {
   }
@@ -20,6 +20,7 @@
 #include <vector>
 #include <memory>
 #include <unordered_map>
+#include "common/MissRatioCurve.h"
 #include "common/perf_counters.h"
 #include "include/ceph_assert.h"
 
@@ -100,6 +101,15 @@ namespace PriorityCache {
 
     // Get the name of this cache.
     virtual std::string get_cache_name() const = 0;
+
+    /* Start or stop estimating the hits this cache would get at other sizes,
+     * if it can. */
+    virtual void set_miss_ratio_curve_enabled(bool enabled) {}
+
+    // Get the estimator of the hits at other sizes, if it is enabled.
+    virtual MissRatioCurve* get_miss_ratio_curve() {
+      return nullptr;
+    }
   };
 
   class Manager {
@@ -117,6 +127,7 @@ namespace PriorityCache {
     uint64_t target_mem = 0;
     uint64_t tuned_mem = 0;
     bool reserve_extra;
+    bool hit_gain_balance = false;
     std::string name;
   public:
     Manager(CephContext *c, uint64_t min, uint64_t max, uint64_t target,
@@ -134,6 +145,9 @@ namespace PriorityCache {
     uint64_t get_tuned_mem() const {
       return tuned_mem;
     }
+    /* Let the caches that estimate their miss ratio curves split their
+     * ratios by how many hits the memory would get them. */
+    void set_hit_gain_balance(bool b);
     void insert(const std::string& name, const std::shared_ptr<PriCache> c,
                 bool enable_perf_counters);
     void erase(const std::string& name);
@@ -143,6 +157,7 @@ namespace PriorityCache {
 
   private:
     void balance_priority(int64_t *mem_avail, Priority pri);
+    void balance_ratios_by_hit_gain();
   };
 }
 
@@ -17,6 +17,11 @@
 
    Minimum and maximum readahead sizes may be violated by up to 50\% if alignment is enabled.
    Minimum readahead size may be violated if the end of the readahead target is reached.
+
+   Up to set_max_streams() sequential streams are followed at once, each with its own
+   readahead window, so interleaved sequential readers don't reset each other.  A read
+   which continues none of them starts a new stream in place of the least recently
+   read one.
  */
 class Readahead {
 public:
@@ -108,15 +113,42 @@ public:
    */
   void set_alignments(const std::vector<uint64_t> &alignments);
 
+  /**
+     Sets the number of sequential streams followed at once (at least 1).
+   */
+  void set_max_streams(size_t max_streams);
+
 private:
+  /// State of one sequential read stream
+  struct stream_t {
+    /// Number of consecutive read requests in the stream
+    int nr_consec_read = 0;
+
+    /// Number of bytes read in the stream
+    uint64_t consec_read_bytes = 0;
+
+    /// Position of the read stream
+    uint64_t last_pos = 0;
+
+    /// Position of the readahead stream
+    uint64_t readahead_pos = 0;
+
+    /// When readahead is already triggered and the read stream crosses this point, readahead is continued
+    uint64_t readahead_trigger_pos = 0;
+
+    /// Size of the next readahead request (barring changes due to alignment, etc.)
+    uint64_t readahead_size = 0;
+  };
+
   /**
-     Records that a read request has been received.
+     Records that a read request has been received, and moves the stream it
+     belongs to to the front of m_streams.
      m_lock must be held while calling.
    */
   void _observe_read(uint64_t offset, uint64_t length);
 
   /**
-     Computes the next readahead request.
+     Computes the next readahead request of the most recently read stream.
      m_lock must be held while calling.
   */
   extent_t _compute_readahead(uint64_t limit);
@@ -136,23 +168,11 @@ private:
   /// Held while reading/modifying any state except m_pending
   ceph::mutex m_lock = ceph::make_mutex("Readahead::m_lock");
 
-  /// Number of consecutive read requests in the current sequential stream
-  int m_nr_consec_read;
-
-  /// Number of bytes read in the current sequenial stream
-  uint64_t m_consec_read_bytes;
-
-  /// Position of the read stream
-  uint64_t m_last_pos;
-
-  /// Position of the readahead stream
-  uint64_t m_readahead_pos;
-
-  /// When readahead is already triggered and the read stream crosses this point, readahead is continued
-  uint64_t m_readahead_trigger_pos;
+  /// Maximum number of streams followed at once
+  size_t m_max_streams;
 
-  /// Size of the next readahead request (barring changes due to alignment, etc.)
-  uint64_t m_readahead_size;
+  /// Streams being followed, the most recently read first
+  std::vector<stream_t> m_streams;
 
   /// Number of pending readahead requests, as determined by inc_pending() and dec_pending()
   int m_pending;
@@ -92,31 +92,34 @@ void Throttle::_reset_max(int64_t m)
 
 bool Throttle::_wait(int64_t c, std::unique_lock<std::mutex>& l)
 {
+  // always wait behind other waiters.
+  if (conds.empty() && _try_take(c)) {
+    return false;
+  }
   mono_time start;
-  bool waited = false;
-  if (_should_wait(c) || !conds.empty()) { // always wait behind other waiters.
-    {
-      auto cv = conds.emplace(conds.end());
-      auto w = make_scope_guard([this, cv]() {
-	  conds.erase(cv);
-	});
-      waited = true;
-      ldout(cct, 2) << "_wait waiting..." << dendl;
-      if (logger)
-	start = mono_clock::now();
-
-      cv->wait(l, [this, c, cv]() { return (!_should_wait(c) &&
-					    cv == conds.begin()); });
-      ldout(cct, 2) << "_wait finished waiting" << dendl;
-      if (logger) {
-	logger->tinc(l_throttle_wait, mono_clock::now() - start);
-      }
+  {
+    auto cv = conds.emplace(conds.end());
+    // before we test count, so that a put() racing with the test sees us
+    ++num_waiters;
+    auto w = make_scope_guard([this, cv]() {
+	--num_waiters;
+	conds.erase(cv);
+      });
+    ldout(cct, 2) << "_wait waiting..." << dendl;
+    if (logger)
+      start = mono_clock::now();
+
+    cv->wait(l, [this, c, cv]() { return (cv == conds.begin() &&
+					  _try_take(c)); });
+    ldout(cct, 2) << "_wait finished waiting" << dendl;
+    if (logger) {
+      logger->tinc(l_throttle_wait, mono_clock::now() - start);
     }
-    // wake up the next guy
-    if (!conds.empty())
-      conds.front().notify_one();
   }
-  return waited;
+  // wake up the next guy
+  if (!conds.empty())
+    conds.front().notify_one();
+  return true;
 }
 
 bool Throttle::wait(int64_t m)
@@ -163,14 +166,13 @@ bool Throttle::get(int64_t c, int64_t m)
     logger->inc(l_throttle_get_started);
   }
   bool waited = false;
-  {
+  if (m || !_try_get(c)) {
     std::unique_lock l(lock);
     if (m) {
       ceph_assert(m > 0);
       _reset_max(m);
     }
     waited = _wait(c, l);
-    count += c;
   }
   if (logger) {
     logger->inc(l_throttle_get);
@@ -191,18 +193,11 @@ bool Throttle::get_or_fail(int64_t c)
   }
 
   assert (c >= 0);
-  bool result = false;
-  {
-    std::lock_guard l(lock);
-    if (_should_wait(c) || !conds.empty()) {
-      ldout(cct, 10) << "get_or_fail " << c << " failed" << dendl;
-      result = false;
-    } else {
-      ldout(cct, 10) << "get_or_fail " << c << " success (" << count.load()
-	<< " -> " << (count.load() + c) << ")" << dendl;
-      count += c;
-      result = true;
-    }
+  bool result = _try_get(c);
+  if (result) {
+    ldout(cct, 10) << "get_or_fail " << c << " success" << dendl;
+  } else {
+    ldout(cct, 10) << "get_or_fail " << c << " failed" << dendl;
   }
 
   if (logger) {
@@ -228,16 +223,17 @@ int64_t Throttle::put(int64_t c)
   ceph_assert(c >= 0);
   ldout(cct, 10) << "put " << c << " (" << count.load() << " -> "
 		 << (count.load()-c) << ")" << dendl;
-  int64_t new_count;
-  {
-    std::lock_guard l(lock);
-    new_count = count;
-    if (c) {
+  int64_t new_count = count;
+  if (c) {
+    new_count = count.fetch_sub(c) - c;
+    // if count goes negative, we failed somewhere!
+    ceph_assert(new_count >= 0);
+    if (num_waiters > 0) {
+      // the waiter either tests count after us, or is asleep by the time we
+      // get the lock
+      std::lock_guard l(lock);
       if (!conds.empty())
 	conds.front().notify_one();
-      // if count goes negative, we failed somewhere!
-      ceph_assert(count >= c);
-      new_count = count -= c;
     }
   }
   if (logger) {
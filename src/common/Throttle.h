@@ -24,6 +24,9 @@
  * This class defines the maximum number of slots currently taken away. The
  * excessive requests for more of them are delayed, until some slots are put
  * back, so @p get_current() drops below the limit after fulfills the requests.
+ *
+ * The slots are taken and put back without the lock as long as nobody is
+ * waiting; the waiters queue up under the lock, and are woken up in order.
  */
 class Throttle final : public ThrottleInterface {
   CephContext *cct;
@@ -32,6 +35,8 @@ class Throttle final : public ThrottleInterface {
   std::atomic<int64_t> count = { 0 }, max = { 0 };
   std::mutex lock;
   std::list<std::condition_variable> conds;
+  /// conds.size(), for put() and the unlocked get() to look at
+  std::atomic<uint32_t> num_waiters = { 0 };
   const bool use_perf;
 
 public:
@@ -40,14 +45,31 @@ public:
 
 private:
   void _reset_max(int64_t m);
-  bool _should_wait(int64_t c) const {
+  bool _should_wait(int64_t c, int64_t cur) const {
     int64_t m = max;
-    int64_t cur = count;
     return
       m &&
       ((c <= m && cur + c > m) || // normally stay under max
        (c >= m && cur > m));     // except for large c
   }
+  bool _should_wait(int64_t c) const {
+    return _should_wait(c, count);
+  }
+
+  /// add @p c to count unless that has to wait
+  bool _try_take(int64_t c) {
+    int64_t cur = count;
+    do {
+      if (_should_wait(c, cur)) {
+	return false;
+      }
+    } while (!count.compare_exchange_weak(cur, cur + c));
+    return true;
+  }
+  /// the lockless get(), as long as nobody is queued before us
+  bool _try_get(int64_t c) {
+    return num_waiters == 0 && _try_take(c);
+  }
 
   bool _wait(int64_t c, std::unique_lock<std::mutex>& l);
 
@@ -78,16 +78,8 @@ void SafeTimer::timer_thread()
   while (!stopping) {
     auto now = clock_t::now();
 
-    while (!schedule.empty()) {
-      auto p = schedule.begin();
-
-      // is the future now?
-      if (p->first > now)
-	break;
-
-      Context *callback = p->second;
-      events.erase(callback);
-      schedule.erase(p);
+    while (auto p = schedule.pop(now)) {
+      Context *callback = *p;
       ldout(cct,10) << "timer_thread executing " << callback << dendl;
       
       if (!safe_callbacks) {
@@ -104,11 +96,12 @@ void SafeTimer::timer_thread()
       break;
 
     ldout(cct,20) << "timer_thread going to sleep" << dendl;
-    if (schedule.empty()) {
-      cond.wait(l);
+    if (auto when = schedule.next_wakeup(); when) {
+      next_wakeup = *when;
+      cond.wait_until(l, *when);
     } else {
-      auto when = schedule.begin()->first;
-      cond.wait_until(l, when);
+      next_wakeup = clock_t::time_point::max();
+      cond.wait(l);
     }
     ldout(cct,20) << "timer_thread awake" << dendl;
   }
@@ -137,19 +130,15 @@ Context* SafeTimer::add_event_at(SafeTimer::clock_t::time_point when, Context *c
     delete callback;
     return nullptr;
   }
-  scheduled_map_t::value_type s_val(when, callback);
-  scheduled_map_t::iterator i = schedule.insert(s_val);
-
-  event_lookup_map_t::value_type e_val(callback, i);
-  pair < event_lookup_map_t::iterator, bool > rval(events.insert(e_val));
+  /* If this asserts, you tried to insert the same Context* twice. */
+  schedule.add(when, callback);
 
-  /* If you hit this, you tried to insert the same Context* twice. */
-  ceph_assert(rval.second);
-
-  /* If the event we have just inserted comes before everything else, we need to
-   * adjust our timeout. */
-  if (i == schedule.begin())
+  /* If the event we have just inserted comes before the timer thread is to
+   * wake up, we need to adjust its timeout. */
+  if (when < next_wakeup) {
+    next_wakeup = when;
     cond.notify_all();
+  }
   return callback;
 }
 
@@ -169,17 +158,14 @@ bool SafeTimer::cancel_event(Context *callback)
 {
   ceph_assert(ceph_mutex_is_locked(lock));
   
-  auto p = events.find(callback);
-  if (p == events.end()) {
+  auto when = schedule.cancel(callback);
+  if (!when) {
     ldout(cct,10) << "cancel_event " << callback << " not found" << dendl;
     return false;
   }
 
-  ldout(cct,10) << "cancel_event " << p->second->first << " -> " << callback << dendl;
-  delete p->first;
-
-  schedule.erase(p->second);
-  events.erase(p);
+  ldout(cct,10) << "cancel_event " << *when << " -> " << callback << dendl;
+  delete callback;
   return true;
 }
 
@@ -188,13 +174,10 @@ void SafeTimer::cancel_all_events()
   ldout(cct,10) << "cancel_all_events" << dendl;
   ceph_assert(ceph_mutex_is_locked(lock));
 
-  while (!events.empty()) {
-    auto p = events.begin();
-    ldout(cct,10) << " cancelled " << p->second->first << " -> " << p->first << dendl;
-    delete p->first;
-    schedule.erase(p->second);
-    events.erase(p);
-  }
+  schedule.clear_and_dispose([this](Context *callback) {
+    ldout(cct,10) << " cancelled " << callback << dendl;
+    delete callback;
+  });
 }
 
 void SafeTimer::dump(const char *caller) const
@@ -203,8 +186,7 @@ void SafeTimer::dump(const char *caller) const
     caller = "";
   ldout(cct,10) << "dump " << caller << dendl;
 
-  for (scheduled_map_t::const_iterator s = schedule.begin();
-       s != schedule.end();
-       ++s)
-    ldout(cct,10) << " " << s->first << "->" << s->second << dendl;
+  schedule.for_each([this](clock_t::time_point when, Context *callback) {
+    ldout(cct,10) << " " << when << "->" << callback << dendl;
+  });
 }
@@ -19,6 +19,7 @@
 #include "include/common_fwd.h"
 #include "ceph_time.h"
 #include "ceph_mutex.h"
+#include "timer_wheel.h"
 
 class Context;
 class SafeTimerThread;
@@ -37,10 +38,9 @@ class SafeTimer
   void _shutdown();
 
   using clock_t = ceph::mono_clock;
-  using scheduled_map_t = std::multimap<clock_t::time_point, Context*>;
-  scheduled_map_t schedule;
-  using event_lookup_map_t = std::map<Context*, scheduled_map_t::iterator>;
-  event_lookup_map_t events;
+  ceph::timer_wheel<clock_t, Context*> schedule;
+  /// when timer_thread() is to wake up next
+  clock_t::time_point next_wakeup = clock_t::time_point::max();
   bool stopping;
 
   void dump(const char *caller = 0) const;
@@ -292,6 +292,20 @@ void OpTracker::unregister_inflight_op(TrackedOp* const i)
 
 void OpTracker::record_history_op(TrackedOpRef&& i)
 {
+  const bool slow = i->get_duration() >= history.get_slow_op_threshold();
+  if (!i->sampled && !slow) {
+    // only the slow ones are worth keeping without their events
+    return;
+  }
+  if (slow && log_slow_ops) {
+    JSONFormatter f;
+    f.open_object_section("op");
+    i->dump(ceph_clock_now(), &f);
+    f.close_section();
+    std::ostringstream ss;
+    f.flush(ss);
+    dout(0) << "slow op " << ss.str() << dendl;
+  }
   std::shared_lock l{lock};
   history.insert(ceph_clock_now(), std::move(i));
 }
@@ -460,7 +474,10 @@ void TrackedOp::mark_event(std::string_view event, utime_t stamp)
   if (!state)
     return;
 
-  {
+  // the ops left out of the sample still record what they go through once
+  // they are slow, which is what their history is kept for
+  if (sampled || event == "done" ||
+      stamp - initiated_at >= (double)tracker->get_slow_op_threshold()) {
     std::lock_guard l(lock);
     events.emplace_back(stamp, event);
   }
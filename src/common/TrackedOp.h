@@ -95,6 +95,9 @@ public:
     history_slow_op_size = new_size;
     history_slow_op_threshold = new_threshold;
   }
+  uint32_t get_slow_op_threshold() const {
+    return history_slow_op_threshold;
+  }
 };
 
 struct ShardedTrackingData;
@@ -107,6 +110,8 @@ class OpTracker {
   float complaint_time;
   int log_threshold;
   std::atomic<bool> tracking_enabled;
+  std::atomic<uint32_t> sample_interval = { 1 };
+  std::atomic<bool> log_slow_ops = { false };
   ceph::shared_mutex lock = ceph::make_shared_mutex("OpTracker::lock");
 
 public:
@@ -129,6 +134,21 @@ public:
   void set_tracking(bool enable) {
     tracking_enabled = enable;
   }
+  /// record the events of one op in every @p interval
+  void set_sample_interval(uint32_t interval) {
+    sample_interval = interval;
+  }
+  bool is_sampled(uint64_t op_seq) const {
+    uint32_t interval = sample_interval;
+    return interval <= 1 || op_seq % interval == 0;
+  }
+  uint32_t get_slow_op_threshold() const {
+    return history.get_slow_op_threshold();
+  }
+  /// log the ops that get to the slow op threshold, with their events
+  void set_log_slow_ops(bool enable) {
+    log_slow_ops = enable;
+  }
   bool dump_ops_in_flight(ceph::Formatter *f, bool print_only_blocked = false, std::set<std::string> filters = {""});
   bool dump_historic_ops(ceph::Formatter *f, bool by_duration = false, std::set<std::string> filters = {""});
   bool dump_historic_slow_ops(ceph::Formatter *f, std::set<std::string> filters = {""});
@@ -249,6 +269,9 @@ protected:
   std::vector<Event> events;    ///< std::list of events and their times
   mutable ceph::mutex lock = ceph::make_mutex("TrackedOp::lock"); ///< to protect the events list
   uint64_t seq = 0;        ///< a unique value std::set by the OpTracker
+  /// whether the events are recorded; the others only keep their start and
+  /// end, which is enough to tell they are slow
+  bool sampled = true;
 
   uint32_t warn_interval_multiplier = 1; //< limits output of a given op warning
 
@@ -266,9 +289,7 @@ protected:
   TrackedOp(OpTracker *_tracker, const utime_t& initiated) :
     tracker(_tracker),
     initiated_at(initiated)
-  {
-    events.reserve(OPTRACKER_PREALLOC_EVENTS);
-  }
+  {}
 
   /// output any type-specific data you want to get when dump() is called
   virtual void _dump(ceph::Formatter *f) const {}
@@ -374,6 +395,9 @@ public:
 
   void tracking_start() {
     if (tracker->register_inflight_op(this)) {
+      sampled = tracker->is_sampled(seq);
+      // the others only get "initiated" and "done"
+      events.reserve(sampled ? OPTRACKER_PREALLOC_EVENTS : 2);
       events.emplace_back(initiated_at, "initiated");
       state = STATE_LIVE;
     }
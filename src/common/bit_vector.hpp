@@ -184,6 +184,9 @@ public:
   uint64_t size() const;
 
   const bufferlist& get_data() const;
+  // the packed elements, the first of a byte in its high order bits,
+  // to update many at once: the length must be left as it is
+  bufferlist& get_data();
 
   Reference operator[](uint64_t offset);
   ConstReference operator[](uint64_t offset) const;
@@ -298,6 +301,11 @@ const bufferlist& BitVector<_b>::get_data() const {
   return m_data;
 }
 
+template <uint8_t _b>
+bufferlist& BitVector<_b>::get_data() {
+  return m_data;
+}
+
 template <uint8_t _b>
 void BitVector<_b>::compute_index(uint64_t offset, uint64_t *index, uint64_t *shift) {
   *index = offset / ELEMENTS_PER_BLOCK;
@@ -2234,6 +2234,63 @@ buffer::ptr_node* buffer::ptr_node::cloner::operator()(
   return new ptr_node(clone_this);
 }
 
+namespace {
+// every ptr appended to a list gets a node of its own, so encoding
+// allocates and frees them at a high rate.
+struct ptr_node_cache_t {
+  static constexpr unsigned max_nodes = 64;
+  static constexpr unsigned disabled = ~0u;
+
+  void* head = nullptr; // linked through the first word of each node
+  unsigned count = 0;
+};
+// trivially destructible, so that it is still usable while the other
+// thread_local objects of an exiting thread free their lists
+thread_local ptr_node_cache_t ptr_node_cache;
+
+struct ptr_node_cache_cleaner_t {
+  bool armed = false;
+  ~ptr_node_cache_cleaner_t() {
+    auto& cache = ptr_node_cache;
+    while (cache.head) {
+      void* p = cache.head;
+      cache.head = *static_cast<void**>(p);
+      ::operator delete(p);
+    }
+    cache.count = ptr_node_cache_t::disabled;
+  }
+};
+thread_local ptr_node_cache_cleaner_t ptr_node_cache_cleaner;
+}
+
+void* buffer::ptr_node::operator new(std::size_t size)
+{
+  auto& cache = ptr_node_cache;
+  if (size == sizeof(ptr_node) && cache.head) {
+    void* p = cache.head;
+    cache.head = *static_cast<void**>(p);
+    --cache.count;
+    return p;
+  }
+  return ::operator new(size);
+}
+
+void buffer::ptr_node::operator delete(void* p)
+{
+  auto& cache = ptr_node_cache;
+  if (cache.count < ptr_node_cache_t::max_nodes) {
+    if (cache.count == 0) {
+      // makes sure the cache is emptied when the thread exits
+      ptr_node_cache_cleaner.armed = true;
+    }
+    *static_cast<void**>(p) = cache.head;
+    cache.head = p;
+    ++cache.count;
+    return;
+  }
+  ::operator delete(p);
+}
+
 std::ostream& buffer::operator<<(std::ostream& out, const buffer::raw &r) {
   return out << "buffer::raw("
              << (void*)r.get_data() << " len " << r.get_len()
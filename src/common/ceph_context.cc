@@ -545,6 +545,12 @@ int CephContext::_do_command(
   else if (command == "perf histogram schema") {
     _perf_counters_collection->dump_formatted_histograms(f, true);
   }
+  else if (command == "perf binary schema") {
+    _perf_counters_collection->encode_schema(*out);
+  }
+  else if (command == "perf binary dump") {
+    _perf_counters_collection->encode_values(*out);
+  }
   else if (command == "perf reset") {
     std::string var;
     std::string section(command);
@@ -732,6 +738,8 @@ CephContext::CephContext(uint32_t module_type_,
   _admin_socket->register_command("2", _admin_hook, "");
   _admin_socket->register_command("perf schema", _admin_hook, "dump perfcounters schema");
   _admin_socket->register_command("perf histogram schema", _admin_hook, "dump perf histogram schema");
+  _admin_socket->register_command("perf binary schema", _admin_hook, "dump perfcounters schema, encoded");
+  _admin_socket->register_command("perf binary dump", _admin_hook, "dump perfcounters values in the order of the binary schema, encoded");
   _admin_socket->register_command("perf reset name=var,type=CephString", _admin_hook, "perf reset <name>: perf reset all or one perfcounter name");
   _admin_socket->register_command("config show", _admin_hook, "dump current config settings");
   _admin_socket->register_command("config help name=var,type=CephString,req=false", _admin_hook, "get config setting schema and descriptions");
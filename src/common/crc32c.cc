@@ -8,6 +8,8 @@
 #include "arch/ppc.h"
 #include "common/sctp_crc32.h"
 #include "common/crc32c_intel_fast.h"
+#include "common/crc32c_intel_multi.h"
+#include "common/crc32c_intel_avx512.h"
 #include "common/crc32c_aarch64.h"
 #include "common/crc32c_ppc.h"
 
@@ -22,6 +24,12 @@ ceph_crc32c_func_t ceph_choose_crc32(void)
 
   // if the CPU supports it, *and* the fast version is compiled in,
   // use that.
+#if defined(__x86_64__)
+  if (ceph_arch_intel_avx512 && ceph_arch_intel_vpclmul &&
+      ceph_arch_intel_sse42) {
+    return ceph_crc32c_intel_avx512;
+  }
+#endif
 #if defined(__i386__) || defined(__x86_64__)
   if (ceph_arch_intel_sse42 && ceph_crc32c_intel_fast_exists()) {
     return ceph_crc32c_intel_fast;
@@ -52,6 +60,29 @@ ceph_crc32c_func_t ceph_choose_crc32(void)
  */
 ceph_crc32c_func_t ceph_crc32c_func = ceph_choose_crc32();
 
+static void ceph_crc32c_multi_serial(uint32_t crc,
+				     unsigned char const * const *buffers,
+				     unsigned length, unsigned count,
+				     uint32_t *out)
+{
+  for (unsigned i = 0; i < count; ++i) {
+    out[i] = ceph_crc32c_func(crc, buffers[i], length);
+  }
+}
+
+ceph_crc32c_multi_func_t ceph_choose_crc32_multi(void)
+{
+  ceph_arch_probe();
+#if defined(__x86_64__)
+  if (ceph_arch_intel_sse42) {
+    return ceph_crc32c_intel_multi;
+  }
+#endif
+  return ceph_crc32c_multi_serial;
+}
+
+ceph_crc32c_multi_func_t ceph_crc32c_multi_func = ceph_choose_crc32_multi();
+
 
 /*
  * Look: http://crcutil.googlecode.com/files/crc-doc.1.0.pdf
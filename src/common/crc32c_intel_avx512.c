@@ -0,0 +1,118 @@
+#include <string.h>
+
+#include "common/crc32c_intel_avx512.h"
+#include "common/crc32c_intel_baseline.h"
+#include "common/crc32c_intel_fast.h"
+
+#ifdef __x86_64__
+
+#include <immintrin.h>
+
+/*
+ * The message is folded into four 512-bit accumulators, a 128-bit lane
+ * being replaced by a 128-bit value congruent to it times x^D modulo the
+ * crc32c polynomial, D being the distance in bits to the data it is
+ * xor'ed into.  The bits are reflected, so that the low quadword of a
+ * lane holds the high degrees:
+ *
+ *   fold(lo, hi) = clmul(lo, x^(64+D-1) mod P) ^ clmul(hi, x^(D-1) mod P)
+ *
+ * the extra -1 making up for the product of two reflected quadwords
+ * being one bit short.  Once folded down to a single lane it has the
+ * same crc as the message it stands for, which the crc32 instruction
+ * takes on from there.
+ */
+#define K(D_LO, D_HI) \
+	{ D_LO, D_HI, D_LO, D_HI, D_LO, D_HI, D_LO, D_HI }
+
+/* the x^n mod P, in the high dword of each quadword */
+static const uint64_t fold_2048[8] __attribute__((aligned(64))) =
+	K(0xe9a5d8be00000000ull, 0x1426a81500000000ull);
+static const uint64_t fold_512[8] __attribute__((aligned(64))) =
+	K(0x1c19243b00000000ull, 0x75bba45b00000000ull);
+/* the lanes of one register, to the last one: by 384, 256 and 128 bits */
+static const uint64_t fold_lanes[8] __attribute__((aligned(64))) = {
+	0xa46ef4aa00000000ull, 0x6051243f00000000ull,
+	0x33ccbbbc00000000ull, 0xa2158b3400000000ull,
+	0x3743f7bd00000000ull, 0x3171d43000000000ull,
+	0, 0
+};
+
+#define TARGET __attribute__((target("avx512f,vpclmulqdq,pclmul,sse4.2")))
+
+TARGET
+static inline __m512i fold(__m512i x, __m512i k)
+{
+	return _mm512_xor_si512(_mm512_clmulepi64_epi128(x, k, 0x00),
+				_mm512_clmulepi64_epi128(x, k, 0x11));
+}
+
+static uint32_t crc32c_short(uint32_t crc, unsigned char const *buffer,
+			     unsigned len)
+{
+	if (ceph_crc32c_intel_fast_exists()) {
+		return ceph_crc32c_intel_fast(crc, buffer, len);
+	}
+	return ceph_crc32c_intel_baseline(crc, buffer, len);
+}
+
+TARGET
+uint32_t ceph_crc32c_intel_avx512(uint32_t crc, unsigned char const *buffer,
+				  unsigned len)
+{
+	__m512i x0, x1, x2, x3, k;
+	__m128i lane;
+	uint64_t q[2];
+
+	if (!buffer || len < 256) {
+		return crc32c_short(crc, buffer, len);
+	}
+
+	/* go on from crc as if it were the start of the message */
+	x0 = _mm512_xor_si512(_mm512_loadu_si512(buffer),
+			      _mm512_castsi128_si512(_mm_cvtsi32_si128(crc)));
+	x1 = _mm512_loadu_si512(buffer + 64);
+	x2 = _mm512_loadu_si512(buffer + 128);
+	x3 = _mm512_loadu_si512(buffer + 192);
+	buffer += 256;
+	len -= 256;
+
+	k = _mm512_load_si512(fold_2048);
+	while (len >= 256) {
+		x0 = _mm512_xor_si512(fold(x0, k), _mm512_loadu_si512(buffer));
+		x1 = _mm512_xor_si512(fold(x1, k), _mm512_loadu_si512(buffer + 64));
+		x2 = _mm512_xor_si512(fold(x2, k), _mm512_loadu_si512(buffer + 128));
+		x3 = _mm512_xor_si512(fold(x3, k), _mm512_loadu_si512(buffer + 192));
+		buffer += 256;
+		len -= 256;
+	}
+
+	k = _mm512_load_si512(fold_512);
+	x1 = _mm512_xor_si512(fold(x0, k), x1);
+	x2 = _mm512_xor_si512(fold(x1, k), x2);
+	x0 = _mm512_xor_si512(fold(x2, k), x3);
+	while (len >= 64) {
+		x0 = _mm512_xor_si512(fold(x0, k), _mm512_loadu_si512(buffer));
+		buffer += 64;
+		len -= 64;
+	}
+
+	/* the last lane is not folded, its constants being 0 */
+	x0 = _mm512_mask_mov_epi64(fold(x0, _mm512_load_si512(fold_lanes)),
+				   0xc0, x0);
+	lane = _mm_xor_si128(
+		_mm_xor_si128(_mm512_extracti32x4_epi32(x0, 0),
+			      _mm512_extracti32x4_epi32(x0, 1)),
+		_mm_xor_si128(_mm512_extracti32x4_epi32(x0, 2),
+			      _mm512_extracti32x4_epi32(x0, 3)));
+
+	_mm_storeu_si128((__m128i *)q, lane);
+	crc = (uint32_t)_mm_crc32_u64(0, q[0]);
+	crc = (uint32_t)_mm_crc32_u64(crc, q[1]);
+	if (len) {
+		crc = crc32c_short(crc, buffer, len);
+	}
+	return crc;
+}
+
+#endif
@@ -0,0 +1,28 @@
+#ifndef CEPH_COMMON_CRC32C_INTEL_AVX512_H
+#define CEPH_COMMON_CRC32C_INTEL_AVX512_H
+
+#include "include/int_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifdef __x86_64__
+
+/*
+ * crc32c folding 256 bytes at a time with VPCLMULQDQ on 512-bit
+ * registers.  Short buffers, their tails and a NULL buffer go to
+ * ceph_crc32c_intel_fast(), or to the baseline if that is not compiled in.
+ * Requires AVX-512F, VPCLMULQDQ and SSE 4.2.
+ */
+extern uint32_t ceph_crc32c_intel_avx512(uint32_t crc,
+					 unsigned char const *buffer,
+					 unsigned len);
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
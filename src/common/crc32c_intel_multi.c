@@ -0,0 +1,70 @@
+#include <string.h>
+
+#include "common/crc32c_intel_multi.h"
+
+#ifdef __x86_64__
+
+#include <nmmintrin.h>
+
+#define LANES 4
+
+static inline uint64_t load64(unsigned char const *p)
+{
+	uint64_t v;
+	memcpy(&v, p, sizeof(v));
+	return v;
+}
+
+__attribute__((target("sse4.2")))
+static uint32_t crc32c_tail(uint32_t crc, unsigned char const *p,
+			    unsigned len)
+{
+	while (len--) {
+		crc = _mm_crc32_u8(crc, *p++);
+	}
+	return crc;
+}
+
+__attribute__((target("sse4.2")))
+void ceph_crc32c_intel_multi(uint32_t crc,
+			     unsigned char const * const *buffers,
+			     unsigned len, unsigned count,
+			     uint32_t *out)
+{
+	unsigned words = len / 8;
+	unsigned tail = len % 8;
+	unsigned i, j;
+
+	for (i = 0; i + LANES <= count; i += LANES) {
+		unsigned char const *p0 = buffers[i];
+		unsigned char const *p1 = buffers[i + 1];
+		unsigned char const *p2 = buffers[i + 2];
+		unsigned char const *p3 = buffers[i + 3];
+		uint64_t c0 = crc, c1 = crc, c2 = crc, c3 = crc;
+		for (j = 0; j < words; ++j) {
+			c0 = _mm_crc32_u64(c0, load64(p0));
+			c1 = _mm_crc32_u64(c1, load64(p1));
+			c2 = _mm_crc32_u64(c2, load64(p2));
+			c3 = _mm_crc32_u64(c3, load64(p3));
+			p0 += 8;
+			p1 += 8;
+			p2 += 8;
+			p3 += 8;
+		}
+		out[i] = crc32c_tail(c0, p0, tail);
+		out[i + 1] = crc32c_tail(c1, p1, tail);
+		out[i + 2] = crc32c_tail(c2, p2, tail);
+		out[i + 3] = crc32c_tail(c3, p3, tail);
+	}
+	for (; i < count; ++i) {
+		unsigned char const *p = buffers[i];
+		uint64_t c = crc;
+		for (j = 0; j < words; ++j) {
+			c = _mm_crc32_u64(c, load64(p));
+			p += 8;
+		}
+		out[i] = crc32c_tail(c, p, tail);
+	}
+}
+
+#endif
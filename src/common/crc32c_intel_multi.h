@@ -0,0 +1,28 @@
+#ifndef CEPH_COMMON_CRC32C_INTEL_MULTI_H
+#define CEPH_COMMON_CRC32C_INTEL_MULTI_H
+
+#include "include/int_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifdef __x86_64__
+
+/*
+ * crc32c of @count buffers of @len bytes each, all seeded with @crc,
+ * into @out.  The buffers go through the crc32 instruction in
+ * interleaved lanes, which hides its latency.  Requires SSE 4.2.
+ */
+extern void ceph_crc32c_intel_multi(uint32_t crc,
+				    unsigned char const * const *buffers,
+				    unsigned len, unsigned count,
+				    uint32_t *out);
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
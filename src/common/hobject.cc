@@ -30,6 +30,37 @@ static void append_escaped(const string &in, string *out)
   }
 }
 
+// the sort keys: big-endian integers, with the sign bit of the signed
+// ones flipped, and strings with their NULs escaped as "\0\1" and
+// terminated by "\0\0", so that a prefix sorts first
+static void append_sort_u64(uint64_t v, string *out)
+{
+  char buf[8];
+  for (int i = 7; i >= 0; --i) {
+    buf[i] = (char)(v & 0xff);
+    v >>= 8;
+  }
+  out->append(buf, sizeof(buf));
+}
+
+static void append_sort_string(const string &in, string *out)
+{
+  size_t pos = 0;
+  for (;;) {
+    size_t nul = in.find('\0', pos);
+    if (nul == string::npos) {
+      out->append(in, pos, string::npos);
+      break;
+    }
+    out->append(in, pos, nul - pos);
+    out->push_back('\0');
+    out->push_back('\1');
+    pos = nul + 1;
+  }
+  out->push_back('\0');
+  out->push_back('\0');
+}
+
 set<string> hobject_t::get_prefixes(
   uint32_t bits,
   uint32_t mask,
@@ -326,6 +357,19 @@ bool hobject_t::parse(const string &s)
   return true;
 }
 
+void hobject_t::append_sort_key(string *out) const
+{
+  // cmp() only tells the keys apart when either is set, but when both
+  // are empty the effective keys are the names, which come next anyway
+  out->push_back(max ? 1 : 0);
+  append_sort_u64((uint64_t)pool ^ (1ull << 63), out);
+  append_sort_u64(get_bitwise_key(), out);
+  append_sort_string(nspace, out);
+  append_sort_string(get_effective_key(), out);
+  append_sort_string(oid.name, out);
+  append_sort_u64(snap, out);
+}
+
 int cmp(const hobject_t& l, const hobject_t& r)
 {
   if (l.max < r.max)
@@ -584,6 +628,14 @@ bool ghobject_t::parse(const string& s)
   return true;
 }
 
+void ghobject_t::append_sort_key(string *out) const
+{
+  out->push_back(max ? 1 : 0);
+  out->push_back((char)((uint8_t)shard_id.id ^ 0x80));
+  hobj.append_sort_key(out);
+  append_sort_u64(generation, out);
+}
+
 int cmp(const ghobject_t& l, const ghobject_t& r)
 {
   if (l.max < r.max)
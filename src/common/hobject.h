@@ -292,6 +292,19 @@ public:
 
   bool parse(const std::string& s);
 
+  /**
+   * append a binary key that sorts, with memcmp(), the way cmp() does
+   *
+   * The fields are not tracked, so it is up to the caller to keep it
+   * along with the object in a container where it saves comparisons.
+   */
+  void append_sort_key(std::string *out) const;
+  std::string get_sort_key() const {
+    std::string key;
+    append_sort_key(&key);
+    return key;
+  }
+
   void encode(ceph::buffer::list& bl) const;
   void decode(ceph::bufferlist::const_iterator& bl);
   void decode(json_spirit::Value& v);
@@ -452,6 +465,14 @@ public:
 
   bool parse(const std::string& s);
 
+  /// append a binary key that sorts, with memcmp(), the way cmp() does
+  void append_sort_key(std::string *out) const;
+  std::string get_sort_key() const {
+    std::string key;
+    append_sort_key(&key);
+    return key;
+  }
+
   // maximum sorted value.
   static ghobject_t get_max() {
     ghobject_t h;
@@ -15,6 +15,8 @@
 #ifndef MAPCACHER_H
 #define MAPCACHER_H
 
+#include <vector>
+
 #include "include/Context.h"
 #include "common/sharedptr_registry.hpp"
 
@@ -60,6 +62,27 @@ public:
     std::pair<K, V> *next    ///< [out] first key after key
     ) = 0; ///< @return 0 on success, -ENOENT if there is no next
 
+  /// Returns up to max keys after key, in order
+  virtual int get_next_batch(
+    const K &key,       ///< [in] key after which to get the keys
+    unsigned max,       ///< [in] number of keys wanted
+    std::vector<std::pair<K, V>> *out ///< [out] keys after key
+    ) {
+    K pos = key;
+    while (out->size() < max) {
+      std::pair<K, V> next;
+      int r = get_next(pos, &next);
+      if (r == -ENOENT) {
+	break;
+      } else if (r < 0) {
+	return r;
+      }
+      pos = next.first;
+      out->push_back(std::move(next));
+    }
+    return 0;
+  } ///< @return error value, 0 on success, even if there are fewer keys
+
   virtual ~StoreDriver() {}
 };
 
@@ -121,6 +144,50 @@ public:
     return -EINVAL;
   } ///< @return error value, 0 on success, -ENOENT if no more entries
 
+  /// Fetch up to max key/value pairs after specified key
+  int get_next_batch(
+    K key,                 ///< [in] key after which to get the keys
+    unsigned max,          ///< [in] number of keys wanted
+    std::vector<std::pair<K, V>> *out ///< [out] keys after key
+    ) {
+    // the keys from the store, merged with the in progress writes
+    std::vector<std::pair<K, V>> store;
+    size_t pos = 0;
+    bool store_done = false;
+    while (out->size() < max) {
+      if (pos == store.size() && !store_done) {
+	store.clear();
+	pos = 0;
+	unsigned want = max - out->size();
+	int r = driver->get_next_batch(key, want, &store);
+	if (r < 0) {
+	  return r;
+	}
+	store_done = store.size() < want;
+      }
+      std::pair<K, boost::optional<V> > cached;
+      bool got_cached = in_progress.get_next(key, &cached);
+      bool got_store = pos < store.size();
+      if (!got_cached && !got_store) {
+	break;
+      } else if (
+	got_cached &&
+	(!got_store || store[pos].first >= cached.first)) {
+	if (got_store && store[pos].first == cached.first) {
+	  ++pos;
+	}
+	key = cached.first;
+	if (cached.second) {
+	  out->emplace_back(cached.first, cached.second.get());
+	} // else cached as removed
+      } else {
+	key = store[pos].first;
+	out->push_back(std::move(store[pos++]));
+      }
+    }
+    return 0;
+  } ///< @return error value, 0 on success, even if there are fewer keys
+
   /// Adds operation setting keys to Transaction
   void set_keys(
     const std::map<K, V> &keys,  ///< [in] keys/values to std::set
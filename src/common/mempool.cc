@@ -26,7 +26,13 @@ mempool::pool_t& mempool::get_pool(mempool::pool_index_t ix)
   // We rely on this array being initialized before any invocation of
   // this function, even if it is called by ctors in other compilation
   // units that are being initialized before this compilation unit.
-  static mempool::pool_t table[num_pools];
+  static mempool::pool_t *table = [] {
+    static mempool::pool_t pools[num_pools];
+    for (size_t i = 0; i < num_pools; ++i) {
+      pools[i].ix = (pool_index_t)i;
+    }
+    return pools;
+  }();
   return table[ix];
 }
 
@@ -64,9 +70,39 @@ void mempool::set_debug_mode(bool d)
 // --------------------------------------------------------------
 // pool_t
 
+namespace {
+// adds what the thread still counts to the shards when it exits
+struct thread_cache_flusher_t {
+  ~thread_cache_flusher_t() {
+    // whatever is counted after this is flushed right away
+    mempool::thread_caches.exiting = true;
+    mempool::thread_caches.registered = false;
+    for (size_t i = 0; i < mempool::num_pools; ++i) {
+      mempool::get_pool((mempool::pool_index_t)i).flush_thread_cache();
+    }
+  }
+};
+}
+
+void mempool::pool_t::flush_thread_cache()
+{
+  if (!thread_caches.registered && !thread_caches.exiting) {
+    static thread_local thread_cache_flusher_t flusher;
+    (void)flusher;
+    thread_caches.registered = true;
+  }
+  thread_cache_t& c = thread_caches.pool[ix];
+  if (c.items || c.bytes) {
+    shard_t *shard = pick_a_shard();
+    shard->items += c.items;
+    shard->bytes += c.bytes;
+    c = thread_cache_t();
+  }
+}
+
 size_t mempool::pool_t::allocated_bytes() const
 {
-  ssize_t result = 0;
+  ssize_t result = thread_caches.pool[ix].bytes;
   for (size_t i = 0; i < num_shards; ++i) {
     result += shard[i].bytes;
   }
@@ -79,7 +115,7 @@ size_t mempool::pool_t::allocated_bytes() const
 
 size_t mempool::pool_t::allocated_items() const
 {
-  ssize_t result = 0;
+  ssize_t result = thread_caches.pool[ix].items;
   for (size_t i = 0; i < num_shards; ++i) {
     result += shard[i].items;
   }
@@ -90,17 +126,12 @@ size_t mempool::pool_t::allocated_items() const
   return (size_t) result;
 }
 
-void mempool::pool_t::adjust_count(ssize_t items, ssize_t bytes)
-{
-  shard_t *shard = pick_a_shard();
-  shard->items += items;
-  shard->bytes += bytes;
-}
-
 void mempool::pool_t::get_stats(
   stats_t *total,
   std::map<std::string, stats_t> *by_type) const
 {
+  total->items += thread_caches.pool[ix].items;
+  total->bytes += thread_caches.pool[ix].bytes;
   for (size_t i = 0; i < num_shards; ++i) {
     total->items += shard[i].items;
     total->bytes += shard[i].bytes;
@@ -6,6 +6,7 @@
 #include <cstring>
 #include <errno.h>
 #include <iostream>
+#include <string_view>
 
 #include "include/stringify.h"
 #include "common/safe_io.h"
@@ -188,6 +189,47 @@ int set_cpu_affinity_all_threads(size_t cpu_set_size, cpu_set_t *cpu_set)
   return 0;
 }
 
+int set_cpu_affinity_named_threads(const std::set<std::string>& prefixes,
+				   size_t cpu_set_size,
+				   cpu_set_t *cpu_set)
+{
+  std::set<std::string> ls;
+  std::string path = "/proc/"s + stringify(getpid()) + "/task";
+  int r = easy_readdir(path, &ls);
+  if (r < 0) {
+    return r;
+  }
+  for (auto& i : ls) {
+    pid_t tid = atoll(i.c_str());
+    if (!tid) {
+      continue;
+    }
+    int fd = ::open((path + "/" + i + "/comm").c_str(), O_RDONLY);
+    if (fd < 0) {
+      continue;  // exited
+    }
+    char buf[32];
+    r = safe_read(fd, &buf, sizeof(buf) - 1);
+    ::close(fd);
+    if (r <= 0) {
+      continue;
+    }
+    buf[r] = 0;
+    std::string_view name(buf);
+    bool match = false;
+    for (auto& prefix : prefixes) {
+      if (name.substr(0, prefix.size()) == prefix) {
+	match = true;
+	break;
+      }
+    }
+    if (match && sched_setaffinity(tid, cpu_set_size, cpu_set) < 0) {
+      return -errno;
+    }
+  }
+  return 0;
+}
+
 #else
 int parse_cpu_set_list(const char *s,
 		       size_t *cpu_set_size,
@@ -221,4 +263,11 @@ int set_cpu_affinity_all_threads(size_t cpu_set_size,
   return -ENOTSUP;
 }
 
+int set_cpu_affinity_named_threads(const std::set<std::string>& prefixes,
+				   size_t cpu_set_size,
+				   cpu_set_t *cpu_set)
+{
+  return -ENOTSUP;
+}
+
 #endif
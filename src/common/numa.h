@@ -22,3 +22,8 @@ int get_numa_node_cpu_set(int node,
 
 int set_cpu_affinity_all_threads(size_t cpu_set_size,
 				 cpu_set_t *cpu_set);
+
+/// set the affinity of the threads whose name starts with one of @p prefixes
+int set_cpu_affinity_named_threads(const std::set<std::string>& prefixes,
+				   size_t cpu_set_size,
+				   cpu_set_t *cpu_set);
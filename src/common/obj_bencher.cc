@@ -17,6 +17,7 @@
  */
 #include "include/compat.h"
 #include <pthread.h>
+#include <thread>
 #include "common/ceph_mutex.h"
 #include "common/Clock.h"
 #include "obj_bencher.h"
@@ -74,6 +75,46 @@ static void sanitize_object_contents (bench_data *data, size_t length) {
   memset(data->object_contents, 'z', length);
 }
 
+void bench_latency_histogram::add(double seconds)
+{
+  uint64_t us = seconds > 0 ? seconds * 1000000 : 0;
+  unsigned i;
+  if (us < SUB_BUCKETS) {
+    i = us;
+  } else {
+    unsigned m = 64 - __builtin_clzll(us) - SUB_BITS;
+    if (m >= MAGNITUDES) {
+      i = counts.size() - 1;
+    } else {
+      i = m * SUB_BUCKETS + (us >> m);
+    }
+  }
+  ++counts[i];
+  ++total;
+}
+
+double bench_latency_histogram::percentile(double p) const
+{
+  if (!total) {
+    return 0;
+  }
+  uint64_t rank = std::max<uint64_t>(1, std::ceil(p / 100 * total));
+  uint64_t seen = 0;
+  unsigned i = 0;
+  for (; i < counts.size() - 1; ++i) {
+    seen += counts[i];
+    if (seen >= rank) {
+      break;
+    }
+  }
+  // the highest latency of the bucket
+  unsigned m = i / SUB_BUCKETS;
+  uint64_t us = (uint64_t(i % SUB_BUCKETS + 1) << m) - 1;
+  return us / 1000000.0;
+}
+
+static const double latency_percentiles[] = {50, 90, 99, 99.9, 99.99};
+
 ostream& ObjBencher::out(ostream& os, utime_t& t)
 {
   if (show_time)
@@ -88,6 +129,47 @@ ostream& ObjBencher::out(ostream& os)
   return out(os, cur_time);
 }
 
+// with the lock held, once data.cur_latency is that of a completed op
+void ObjBencher::add_latency()
+{
+  data.latency_hist.add(data.cur_latency.count());
+  data.interval_latency_hist.add(data.cur_latency.count());
+}
+
+// the time the next op is due at: now, unless a target rate is set, in
+// which case we wait for its turn.  its latency is counted from then, so
+// that the ops which could not start on time because all the slots were
+// busy are accounted for
+mono_time ObjBencher::next_op_start()
+{
+  if (data.target_ops <= 0) {
+    return mono_clock::now();
+  }
+  mono_time start = data.start_time +
+    std::chrono::duration_cast<mono_clock::duration>(
+      std::chrono::duration<double>(data.started / data.target_ops));
+  std::this_thread::sleep_until(start);
+  return start;
+}
+
+void ObjBencher::dump_latency_percentiles(size_t width)
+{
+  for (auto p : latency_percentiles) {
+    std::ostringstream pct;
+    pct << p;
+    double lat = data.latency_hist.percentile(p);
+    if (!formatter) {
+      std::string label = "Latency p" + pct.str() + "(s):";
+      label.resize(std::max(width, label.size() + 1), ' ');
+      cout << label << lat << std::endl;
+    } else {
+      std::string name = "latency_p" + pct.str();
+      std::replace(name.begin(), name.end(), '.', '_');
+      formatter->dump_format(name.c_str(), "%f", lat);
+    }
+  }
+}
+
 void *ObjBencher::status_printer(void *_bencher) {
   ObjBencher *bencher = static_cast<ObjBencher *>(_bencher);
   bench_data& data = bencher->data;
@@ -112,7 +194,9 @@ void *ObjBencher::status_printer(void *_bencher) {
         t.localtime(cout)
           << " min lat: " << data.min_latency
           << " max lat: " << data.max_latency
-          << " avg lat: " << data.avg_latency << std::endl;
+          << " avg lat: " << data.avg_latency
+          << " p99 lat: " << data.latency_hist.percentile(99)
+          << " p99.99 lat: " << data.latency_hist.percentile(99.99) << std::endl;
       //I'm naughty and don't reset the fill
       bencher->out(cout, t) << setfill(' ')
           << setw(5) << "sec"
@@ -122,7 +206,9 @@ void *ObjBencher::status_printer(void *_bencher) {
           << setw(10) << "avg MB/s"
           << setw(10) << "cur MB/s"
           << setw(12) << "last lat(s)"
-          << setw(12) << "avg lat(s)" << std::endl;
+          << setw(12) << "avg lat(s)"
+          << setw(12) << "p50 lat(s)"
+          << setw(12) << "p99 lat(s)" << std::endl;
     }
     if (cycleSinceChange)
       bandwidth = (double)(data.finished - previous_writes)
@@ -182,7 +268,10 @@ void *ObjBencher::status_printer(void *_bencher) {
           << ' ' << setw(9) << avg_bandwidth
           << ' ' << setw(9) << bandwidth
           << ' ' << setw(11) << (double)data.cur_latency.count()
-          << ' ' << setw(11) << data.avg_latency << std::endl;
+          << ' ' << setw(11) << data.avg_latency
+          << ' ' << setw(11) << data.interval_latency_hist.percentile(50)
+          << ' ' << setw(11) << data.interval_latency_hist.percentile(99)
+          << std::endl;
       } else {
         formatter->dump_format("sec", "%d", i);
         formatter->dump_format("cur_ops", "%d", data.in_flight);
@@ -192,7 +281,16 @@ void *ObjBencher::status_printer(void *_bencher) {
         formatter->dump_format("cur_bw", "%f", bandwidth);
         formatter->dump_format("last_lat", "%f", (double)data.cur_latency.count());
         formatter->dump_format("avg_lat", "%f", data.avg_latency);
+        for (auto p : latency_percentiles) {
+          std::ostringstream name;
+          name << "lat_p" << p;
+          std::string key = name.str();
+          std::replace(key.begin(), key.end(), '.', '_');
+          formatter->dump_format(key.c_str(), "%f",
+                                 data.interval_latency_hist.percentile(p));
+        }
       }
+      data.interval_latency_hist.clear();
     }
     else {
       if (!formatter) {
@@ -205,7 +303,9 @@ void *ObjBencher::status_printer(void *_bencher) {
           << ' ' << setw(9) << avg_bandwidth
 	  << ' ' << setw(9) << '0'
           << ' ' << setw(11) << '-'
-          << ' '<< setw(11) << data.avg_latency << std::endl;
+          << ' '<< setw(11) << data.avg_latency
+          << ' ' << setw(11) << '-'
+          << ' ' << setw(11) << '-' << std::endl;
       } else {
         formatter->dump_format("sec", "%d", i);
         formatter->dump_format("cur_ops", "%d", data.in_flight);
@@ -285,6 +385,8 @@ int ObjBencher::aio_bench(
   data.max_latency = 0;
   data.avg_latency = 0;
   data.latency_diff_sum = 0;
+  data.latency_hist.clear();
+  data.interval_latency_hist.clear();
   data.object_contents = contentsChars;
   lock.unlock();
 
@@ -398,10 +500,16 @@ int ObjBencher::write_bench(int secondsToRun,
 	      << data.op_size << " bytes to objects of size "
 	      << data.object_size << " for up to "
 	      << secondsToRun << " seconds or "
-	      << max_objects << " objects"
-	      << std::endl;
+	      << max_objects << " objects";
+    if (data.target_ops > 0) {
+      cout << ", starting " << data.target_ops << " writes/s";
+    }
+    cout << std::endl;
   } else {
     formatter->dump_format("concurrent_ios", "%d", concurrentios);
+    if (data.target_ops > 0) {
+      formatter->dump_float("target_ops", data.target_ops);
+    }
     formatter->dump_format("object_size", "%d", data.object_size);
     formatter->dump_format("op_size", "%d", data.op_size);
     formatter->dump_format("seconds_to_run", "%d", secondsToRun);
@@ -449,7 +557,7 @@ int ObjBencher::write_bench(int secondsToRun,
   data.start_time = mono_clock::now();
   locker.unlock();
   for (int i = 0; i<concurrentios; ++i) {
-    start_times[i] = mono_clock::now();
+    start_times[i] = next_op_start();
     r = create_completion(i, _aio_cb, (void *)&lc);
     if (r < 0)
       goto ERR;
@@ -506,6 +614,7 @@ int ObjBencher::write_bench(int secondsToRun,
     if (data.cur_latency.count() < data.min_latency)
       data.min_latency = data.cur_latency.count();
     ++data.finished;
+    add_latency();
     double delta = data.cur_latency.count() - data.avg_latency;
     data.avg_latency = total_latency / data.finished;
     data.latency_diff_sum += delta * (data.cur_latency.count() - data.avg_latency);
@@ -535,7 +644,7 @@ int ObjBencher::write_bench(int secondsToRun,
     // we wrote to buffer, going around internal crc cache, so invalidate it now.
     newContents->invalidate_crc();
 
-    start_times[slot] = mono_clock::now();
+    start_times[slot] = next_op_start();
     r = create_completion(slot, _aio_cb, &lc);
     if (r < 0)
       goto ERR;
@@ -599,6 +708,7 @@ int ObjBencher::write_bench(int secondsToRun,
        << "Stddev Latency(s):      " << latency_stddev << std::endl
        << "Max latency(s):         " << data.max_latency << std::endl
        << "Min latency(s):         " << data.min_latency << std::endl;
+    dump_latency_percentiles(24);
   } else {
     formatter->dump_format("total_time_run", "%f", timePassed.count());
     formatter->dump_format("total_writes_made", "%d", data.finished);
@@ -616,6 +726,7 @@ int ObjBencher::write_bench(int secondsToRun,
     formatter->dump_format("stddev_latency", "%f", latency_stddev);
     formatter->dump_format("max_latency", "%f", data.max_latency);
     formatter->dump_format("min_latency", "%f", data.min_latency);
+    dump_latency_percentiles(0);
   }
   //write object size/number data for read benchmarks
   encode(data.object_size, b_write);
@@ -687,7 +798,7 @@ int ObjBencher::seq_read_bench(
   //start initial reads
   for (int i = 0; i < concurrentios; ++i) {
     index[i] = i;
-    start_times[i] = mono_clock::now();
+    start_times[i] = next_op_start();
     create_completion(i, _aio_cb, (void *)&lc);
     r = aio_read(name[i], i, contents[i].get(), data.op_size,
 		 data.op_size * (i % reads_per_object));
@@ -767,6 +878,7 @@ int ObjBencher::seq_read_bench(
     if (data.cur_latency.count() < data.min_latency)
       data.min_latency = data.cur_latency.count();
     ++data.finished;
+    add_latency();
     data.avg_latency = total_latency / data.finished;
     --data.in_flight;
     locker.unlock();
@@ -776,7 +888,7 @@ int ObjBencher::seq_read_bench(
       continue;
 
     //start new read and check data if requested
-    start_times[slot] = mono_clock::now();
+    start_times[slot] = next_op_start();
     create_completion(slot, _aio_cb, (void *)&lc);
     r = aio_read(newName, slot, contents[slot].get(), data.op_size,
 		 data.op_size * (data.started % reads_per_object));
@@ -821,6 +933,7 @@ int ObjBencher::seq_read_bench(
        << "Average Latency(s):   " << data.avg_latency << std::endl
        << "Max latency(s):       " << data.max_latency << std::endl
        << "Min latency(s):       " << data.min_latency << std::endl;
+    dump_latency_percentiles(22);
   } else {
     formatter->dump_format("total_time_run", "%f", timePassed.count());
     formatter->dump_format("total_reads_made", "%d", data.finished);
@@ -834,6 +947,7 @@ int ObjBencher::seq_read_bench(
     formatter->dump_format("average_latency", "%f", data.avg_latency);
     formatter->dump_format("max_latency", "%f", data.max_latency);
     formatter->dump_format("min_latency", "%f", data.min_latency);
+    dump_latency_percentiles(0);
   }
 
   completions_done();
@@ -899,7 +1013,7 @@ int ObjBencher::rand_read_bench(
   //start initial reads
   for (int i = 0; i < concurrentios; ++i) {
     index[i] = i;
-    start_times[i] = mono_clock::now();
+    start_times[i] = next_op_start();
     create_completion(i, _aio_cb, (void *)&lc);
     r = aio_read(name[i], i, contents[i].get(), data.op_size,
 		 data.op_size * (i % reads_per_object));
@@ -962,6 +1076,7 @@ int ObjBencher::rand_read_bench(
     if (data.cur_latency.count() < data.min_latency)
       data.min_latency = data.cur_latency.count();
     ++data.finished;
+    add_latency();
     data.avg_latency = total_latency / data.finished;
     --data.in_flight;
 
@@ -989,7 +1104,7 @@ int ObjBencher::rand_read_bench(
     // invalidate internal crc cache
     cur_contents->invalidate_crc();
 
-    start_times[slot] = mono_clock::now();
+    start_times[slot] = next_op_start();
     create_completion(slot, _aio_cb, (void *)&lc);
     r = aio_read(newName, slot, contents[slot].get(), data.op_size,
 		 data.op_size * (rand_id % reads_per_object));
@@ -1034,6 +1149,7 @@ int ObjBencher::rand_read_bench(
        << "Average Latency(s):   " << data.avg_latency << std::endl
        << "Max latency(s):       " << data.max_latency << std::endl
        << "Min latency(s):       " << data.min_latency << std::endl;
+    dump_latency_percentiles(22);
   } else {
     formatter->dump_format("total_time_run", "%f", timePassed.count());
     formatter->dump_format("total_reads_made", "%d", data.finished);
@@ -1047,6 +1163,7 @@ int ObjBencher::rand_read_bench(
     formatter->dump_format("average_latency", "%f", data.avg_latency);
     formatter->dump_format("max_latency", "%f", data.max_latency);
     formatter->dump_format("min_latency", "%f", data.min_latency);
+    dump_latency_percentiles(0);
   }
   completions_done();
 
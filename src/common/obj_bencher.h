@@ -18,6 +18,7 @@
 #include "common/ceph_context.h"
 #include "common/Formatter.h"
 #include "ceph_time.h"
+#include <array>
 #include <cfloat>
 
 using ceph::mono_clock;
@@ -35,6 +36,25 @@ struct bench_interval_data {
   double iops_diff_sum = 0;
 };
 
+/// latencies binned HDR-style: each power of two microseconds is split in
+/// SUB_BUCKETS / 2 linear steps, so that a percentile is within ~3% of the
+/// true value whatever the latency
+struct bench_latency_histogram {
+  static constexpr unsigned SUB_BITS = 6;
+  static constexpr unsigned SUB_BUCKETS = 1u << SUB_BITS;
+  static constexpr unsigned MAGNITUDES = 32; // up to 2^37us, more than a day
+  std::array<uint64_t, SUB_BUCKETS * MAGNITUDES> counts = {};
+  uint64_t total = 0;
+
+  void add(double seconds);
+  /// @returns the latency in seconds below which @p p percent of them are
+  double percentile(double p) const;
+  void clear() {
+    counts.fill(0);
+    total = 0;
+  }
+};
+
 struct bench_data {
   bool done; //is the benchmark is done
   uint64_t object_size; //the size of the objects
@@ -50,6 +70,9 @@ struct bench_data {
   struct bench_interval_data idata; // data that is updated by time intervals and not by events
   double latency_diff_sum;
   std::chrono::duration<double> cur_latency; //latency of last completed transaction - in seconds by default
+  bench_latency_histogram latency_hist; // all the latencies of the run
+  bench_latency_histogram interval_latency_hist; // those of the last interval
+  double target_ops; // ops/s to start the ops at regardless of their completions, 0 to start them as the previous ones complete
   mono_time start_time; //start time for benchmark - use the monotonic clock as we'll measure the passage of time
   char *object_contents; //pointer to the contents written to each object
 };
@@ -104,6 +127,10 @@ protected:
   virtual bool get_objects(std::list< std::pair<std::string, std::string> >* objects, int num) = 0;
   virtual void set_namespace(const std::string&) {}
 
+  void add_latency();
+  mono_time next_op_start();
+  void dump_latency_percentiles(size_t width);
+
   ostream& out(ostream& os);
   ostream& out(ostream& os, utime_t& t);
 public:
@@ -118,6 +145,11 @@ public:
   void set_show_time(bool dt) {
     show_time = dt;
   }
+  /// start @p ops ops per second, so that a slow op delays none of the next
+  /// ones, but for the --concurrent-ios of them in flight already
+  void set_target_ops(double ops) {
+    data.target_ops = ops;
+  }
   void set_formatter(Formatter *f) {
     formatter = f;
   }
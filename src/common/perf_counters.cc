@@ -17,6 +17,7 @@
 #include "common/dout.h"
 #include "common/valgrind.h"
 #include "include/common_fwd.h"
+#include "include/encoding.h"
 
 using std::ostringstream;
 using std::make_pair;
@@ -45,6 +46,7 @@ void PerfCountersCollectionImpl::add(PerfCounters *l)
   }
 
   m_loggers.insert(l);
+  ++m_generation;
 
   for (unsigned int i = 0; i < l->m_data.size(); ++i) {
     PerfCounters::perf_counter_data_any_d &data = l->m_data[i];
@@ -72,6 +74,7 @@ void PerfCountersCollectionImpl::remove(PerfCounters *l)
   perf_counters_set_t::iterator i = m_loggers.find(l);
   ceph_assert(i != m_loggers.end());
   m_loggers.erase(i);
+  ++m_generation;
 }
 
 void PerfCountersCollectionImpl::clear()
@@ -82,6 +85,7 @@ void PerfCountersCollectionImpl::clear()
     delete *i;
     m_loggers.erase(i++);
   }
+  ++m_generation;
 
   by_path.clear();
 }
@@ -144,6 +148,27 @@ void PerfCountersCollectionImpl::dump_formatted_generic(
   f->close_section();
 }
 
+void PerfCountersCollectionImpl::encode_schema(bufferlist& bl) const
+{
+  ENCODE_START(1, 1, bl);
+  encode(m_generation, bl);
+  encode((uint32_t)m_loggers.size(), bl);
+  for (auto l : m_loggers) {
+    l->encode_schema(bl);
+  }
+  ENCODE_FINISH(bl);
+}
+
+void PerfCountersCollectionImpl::encode_values(bufferlist& bl) const
+{
+  ENCODE_START(1, 1, bl);
+  encode(m_generation, bl);
+  for (auto l : m_loggers) {
+    l->encode_values(bl);
+  }
+  ENCODE_FINISH(bl);
+}
+
 void PerfCountersCollectionImpl::with_counters(std::function<void(
       const PerfCountersCollectionImpl::CounterMap &)> fn) const
 {
@@ -169,11 +194,9 @@ void PerfCounters::inc(int idx, uint64_t amt)
   if (!(data.type & PERFCOUNTER_U64))
     return;
   if (data.type & PERFCOUNTER_LONGRUNAVG) {
-    data.avgcount++;
-    data.u64 += amt;
-    data.avgcount2++;
+    data.add_avg(amt);
   } else {
-    data.u64 += amt;
+    data.add(amt);
   }
 }
 
@@ -190,7 +213,7 @@ void PerfCounters::dec(int idx, uint64_t amt)
   ceph_assert(!(data.type & PERFCOUNTER_LONGRUNAVG));
   if (!(data.type & PERFCOUNTER_U64))
     return;
-  data.u64 -= amt;
+  data.add(-amt);
 }
 
 void PerfCounters::set(int idx, uint64_t amt)
@@ -210,10 +233,10 @@ void PerfCounters::set(int idx, uint64_t amt)
                              "perf counter atomic");
   if (data.type & PERFCOUNTER_LONGRUNAVG) {
     data.avgcount++;
-    data.u64 = amt;
+    data.set_u64(amt);
     data.avgcount2++;
   } else {
-    data.u64 = amt;
+    data.set_u64(amt);
   }
 }
 
@@ -229,7 +252,7 @@ uint64_t PerfCounters::get(int idx) const
   const perf_counter_data_any_d& data(m_data[idx - m_lower_bound - 1]);
   if (!(data.type & PERFCOUNTER_U64))
     return 0;
-  return data.u64;
+  return data.read_u64();
 }
 
 void PerfCounters::tinc(int idx, utime_t amt)
@@ -245,11 +268,9 @@ void PerfCounters::tinc(int idx, utime_t amt)
   if (!(data.type & PERFCOUNTER_TIME))
     return;
   if (data.type & PERFCOUNTER_LONGRUNAVG) {
-    data.avgcount++;
-    data.u64 += amt.to_nsec();
-    data.avgcount2++;
+    data.add_avg(amt.to_nsec());
   } else {
-    data.u64 += amt.to_nsec();
+    data.add(amt.to_nsec());
   }
 }
 
@@ -266,11 +287,9 @@ void PerfCounters::tinc(int idx, ceph::timespan amt)
   if (!(data.type & PERFCOUNTER_TIME))
     return;
   if (data.type & PERFCOUNTER_LONGRUNAVG) {
-    data.avgcount++;
-    data.u64 += amt.count();
-    data.avgcount2++;
+    data.add_avg(amt.count());
   } else {
-    data.u64 += amt.count();
+    data.add(amt.count());
   }
 }
 
@@ -286,7 +305,7 @@ void PerfCounters::tset(int idx, utime_t amt)
   perf_counter_data_any_d& data(m_data[idx - m_lower_bound - 1]);
   if (!(data.type & PERFCOUNTER_TIME))
     return;
-  data.u64 = amt.to_nsec();
+  data.set_u64(amt.to_nsec());
   if (data.type & PERFCOUNTER_LONGRUNAVG)
     ceph_abort();
 }
@@ -303,7 +322,7 @@ utime_t PerfCounters::tget(int idx) const
   const perf_counter_data_any_d& data(m_data[idx - m_lower_bound - 1]);
   if (!(data.type & PERFCOUNTER_TIME))
     return utime_t();
-  uint64_t v = data.u64;
+  uint64_t v = data.read_u64();
   return utime_t(v / 1000000000ull, v % 1000000000ull);
 }
 
@@ -342,6 +361,15 @@ pair<uint64_t, uint64_t> PerfCounters::get_tavg_ns(int idx) const
   return make_pair(a.second, a.first);
 }
 
+unsigned PerfCounters::perf_counter_data_any_d::this_shard()
+{
+  // threads take the slots in turn, so that the few busy threads of a
+  // daemon rarely share one
+  static std::atomic<unsigned> next_shard = { 0 };
+  static thread_local unsigned shard = next_shard++ % num_shards;
+  return shard;
+}
+
 void PerfCounters::reset()
 {
   perf_counter_data_vec_t::iterator d = m_data.begin();
@@ -451,7 +479,7 @@ void PerfCounters::dump_formatted_generic(Formatter *f, bool schema,
         d->histogram->dump_formatted(f);
         f->close_section();
       } else {
-	uint64_t v = d->u64;
+	uint64_t v = d->read_u64();
 	if (d->type & PERFCOUNTER_U64) {
 	  f->dump_unsigned(d->name, v);
 	} else if (d->type & PERFCOUNTER_TIME) {
@@ -467,6 +495,61 @@ void PerfCounters::dump_formatted_generic(Formatter *f, bool schema,
   f->close_section();
 }
 
+/*
+ * For each counter, its name, description, nick, type, unit and
+ * adjusted priority, and for histograms the dimension and config of
+ * their axes.
+ */
+void PerfCounters::encode_schema(bufferlist& bl) const
+{
+  using ceph::encode;
+  encode(m_name, bl);
+  encode((uint32_t)m_data.size(), bl);
+  for (auto& d : m_data) {
+    encode(std::string(d.name), bl);
+    encode(std::string(d.description ? d.description : ""), bl);
+    encode(std::string(d.nick ? d.nick : ""), bl);
+    encode((uint8_t)d.type, bl);
+    encode((uint8_t)d.unit, bl);
+    encode((uint8_t)get_adjusted_priority(d.prio), bl);
+    if (d.type & PERFCOUNTER_HISTOGRAM) {
+      ceph_assert(d.histogram);
+      auto& axes = d.histogram->get_axes_config();
+      encode((uint8_t)axes.size(), bl);
+      for (auto& ac : axes) {
+	encode(std::string(ac.m_name), bl);
+	encode((uint8_t)ac.m_scale_type, bl);
+	encode(ac.m_min, bl);
+	encode(ac.m_quant_size, bl);
+	encode(ac.m_buckets, bl);
+      }
+    }
+  }
+}
+
+/*
+ * For each counter of the schema, in nanoseconds for times: the sum and
+ * the count of averages, the buckets of histograms, the value of the
+ * others.
+ */
+void PerfCounters::encode_values(bufferlist& bl) const
+{
+  using ceph::encode;
+  for (auto& d : m_data) {
+    if (d.type & PERFCOUNTER_LONGRUNAVG) {
+      auto a = d.read_avg();
+      encode(a.first, bl);
+      encode(a.second, bl);
+    } else if (d.type & PERFCOUNTER_HISTOGRAM) {
+      d.histogram->for_each_value([&bl](uint64_t v) {
+	encode(v, bl);
+      });
+    } else {
+      encode(d.read_u64(), bl);
+    }
+  }
+}
+
 const std::string &PerfCounters::get_name() const
 {
   return m_name;
@@ -575,11 +658,19 @@ void PerfCountersBuilder::add_impl(
 
 PerfCounters *PerfCountersBuilder::create_perf_counters()
 {
-  PerfCounters::perf_counter_data_vec_t::const_iterator d = m_perf_counters->m_data.begin();
-  PerfCounters::perf_counter_data_vec_t::const_iterator d_end = m_perf_counters->m_data.end();
+  PerfCounters::perf_counter_data_vec_t::iterator d = m_perf_counters->m_data.begin();
+  PerfCounters::perf_counter_data_vec_t::iterator d_end = m_perf_counters->m_data.end();
   for (; d != d_end; ++d) {
     ceph_assert(d->type != PERFCOUNTER_NONE);
     ceph_assert(d->type & (PERFCOUNTER_U64 | PERFCOUNTER_TIME));
+    // gauges are set rather than incremented, and histograms have
+    // their own buckets
+    if (sharded && !(d->type & PERFCOUNTER_HISTOGRAM) &&
+	(d->type & (PERFCOUNTER_COUNTER | PERFCOUNTER_LONGRUNAVG))) {
+      using shard_t = PerfCounters::perf_counter_data_any_d::shard_t;
+      d->shards.reset(
+	new shard_t[PerfCounters::perf_counter_data_any_d::num_shards]);
+    }
   }
 
   PerfCounters *ret = m_perf_counters;
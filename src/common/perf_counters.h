@@ -24,6 +24,7 @@
 #include <cstdint>
 
 #include "common/perf_histogram.h"
+#include "include/buffer_fwd.h"
 #include "include/utime.h"
 #include "include/common_fwd.h"
 #include "common/ceph_mutex.h"
@@ -113,6 +114,13 @@ public:
     prio_default = prio_;
   }
 
+  /// spread the increments of the counters and averages over per-thread
+  /// slots, for loggers updated from many threads at once
+  void set_sharded(bool s)
+  {
+    sharded = s;
+  }
+
   PerfCounters* create_perf_counters();
 private:
   PerfCountersBuilder(const PerfCountersBuilder &rhs);
@@ -124,6 +132,7 @@ private:
   PerfCounters *m_perf_counters;
 
   int prio_default = 0;
+  bool sharded = false;
 };
 
 /*
@@ -150,6 +159,10 @@ private:
  * For the time average, it returns the current value and
  * the "avgcount" member when read off. avgcount is incremented when you call
  * tinc. Calling tset on an average is an error and will assert out.
+ *
+ * The counters and averages of a sharded PerfCounters are incremented in
+ * one of several cache line sized slots picked by the calling thread, and
+ * the slots are only summed when read.
  */
 class PerfCounters
 {
@@ -168,8 +181,7 @@ public:
         description(other.description),
         nick(other.nick),
 	 type(other.type),
-	 unit(other.unit),
-	 u64(other.u64.load()) {
+	 unit(other.unit) {
       auto a = other.read_avg();
       u64 = a.first;
       avgcount = a.second;
@@ -190,28 +202,92 @@ public:
     std::atomic<uint64_t> avgcount2 = { 0 };
     std::unique_ptr<PerfHistogram<>> histogram;
 
+    static constexpr unsigned num_shards = 16;
+    struct alignas(64) shard_t {
+      std::atomic<uint64_t> u64 = { 0 };
+      std::atomic<uint64_t> avgcount = { 0 };
+      std::atomic<uint64_t> avgcount2 = { 0 };
+    };
+    /// added to the fields above when read, if sharded
+    std::unique_ptr<shard_t[]> shards;
+
+    /// the slot the calling thread updates
+    static unsigned this_shard();
+
     void reset()
     {
       if (type != PERFCOUNTER_U64) {
 	    u64 = 0;
 	    avgcount = 0;
 	    avgcount2 = 0;
+	    for (unsigned i = 0; shards && i < num_shards; ++i) {
+	      shards[i].u64 = 0;
+	      shards[i].avgcount = 0;
+	      shards[i].avgcount2 = 0;
+	    }
       }
       if (histogram) {
         histogram->reset();
       }
     }
 
+    void add(uint64_t v) {
+      if (shards) {
+	shards[this_shard()].u64 += v;
+      } else {
+	u64 += v;
+      }
+    }
+
+    void add_avg(uint64_t v) {
+      auto do_add = [v](auto& sum, auto& count, auto& count2) {
+	count++;
+	sum += v;
+	count2++;
+      };
+      if (shards) {
+	auto& s = shards[this_shard()];
+	do_add(s.u64, s.avgcount, s.avgcount2);
+      } else {
+	do_add(u64, avgcount, avgcount2);
+      }
+    }
+
+    void set_u64(uint64_t v) {
+      u64 = v;
+      for (unsigned i = 0; shards && i < num_shards; ++i) {
+	shards[i].u64 = 0;
+      }
+    }
+
+    uint64_t read_u64() const {
+      uint64_t v = u64;
+      for (unsigned i = 0; shards && i < num_shards; ++i) {
+	v += shards[i].u64;
+      }
+      return v;
+    }
+
     // read <sum, count> safely by making sure the post- and pre-count
     // are identical; in other words the whole loop needs to be run
     // without any intervening calls to inc, set, or tinc.
     std::pair<uint64_t,uint64_t> read_avg() const {
-      uint64_t sum, count;
-      do {
-	count = avgcount2;
-	sum = u64;
-      } while (avgcount != count);
-      return { sum, count };
+      auto do_read = [](const auto& u64, const auto& avgcount,
+			const auto& avgcount2) {
+	uint64_t sum, count;
+	do {
+	  count = avgcount2;
+	  sum = u64;
+	} while (avgcount != count);
+	return std::make_pair(sum, count);
+      };
+      auto r = do_read(u64, avgcount, avgcount2);
+      for (unsigned i = 0; shards && i < num_shards; ++i) {
+	auto s = do_read(shards[i].u64, shards[i].avgcount, shards[i].avgcount2);
+	r.first += s.first;
+	r.second += s.second;
+      }
+      return r;
     }
   };
 
@@ -279,6 +355,8 @@ private:
   PerfCounters& operator=(const PerfCounters &rhs);
   void dump_formatted_generic(ceph::Formatter *f, bool schema, bool histograms,
                               const std::string &counter = "") const;
+  void encode_schema(ceph::buffer::list& bl) const;
+  void encode_values(ceph::buffer::list& bl) const;
 
   typedef std::vector<perf_counter_data_any_d> perf_counter_data_vec_t;
 
@@ -349,12 +427,25 @@ public:
 
   void with_counters(std::function<void(const CounterMap &)>) const;
 
+  /**
+   * A binary form of the schema and of the values, for collectors that
+   * poll them often: the schema is fetched once, and each dump then
+   * only has the values, in the order of the schema, and the generation
+   * of the schema they follow.  The generation changes whenever a set of
+   * counters is added or removed, and the schema should then be fetched
+   * again.
+   */
+  void encode_schema(ceph::buffer::list& bl) const;
+  void encode_values(ceph::buffer::list& bl) const;
+
 private:
   void dump_formatted_generic(ceph::Formatter *f, bool schema, bool histograms,
                               const std::string &logger = "",
                               const std::string &counter = "") const;
 
   perf_counters_set_t m_loggers;
+  /// bumped whenever m_loggers changes
+  uint64_t m_generation = 0;
 
   CounterMap by_path; 
 };
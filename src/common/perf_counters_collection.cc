@@ -47,6 +47,16 @@ void PerfCountersCollection::dump_formatted_histograms(ceph::Formatter *f, bool
   std::lock_guard lck(m_lock);
   perf_impl.dump_formatted_histograms(f,schema,logger,counter);
 }
+void PerfCountersCollection::encode_schema(ceph::buffer::list& bl)
+{
+  std::lock_guard lck(m_lock);
+  perf_impl.encode_schema(bl);
+}
+void PerfCountersCollection::encode_values(ceph::buffer::list& bl)
+{
+  std::lock_guard lck(m_lock);
+  perf_impl.encode_values(bl);
+}
 void PerfCountersCollection::with_counters(std::function<void(const PerfCountersCollectionImpl::CounterMap &)> fn) const
 {
   std::lock_guard lck(m_lock);
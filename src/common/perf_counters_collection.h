@@ -27,6 +27,9 @@ public:
                                  const std::string &logger = "",
                                  const std::string &counter = "");
 
+  void encode_schema(ceph::buffer::list& bl);
+  void encode_values(ceph::buffer::list& bl);
+
   void with_counters(std::function<void(const PerfCountersCollectionImpl::CounterMap &)>) const;
 
   friend class PerfCountersCollectionTest;
@@ -128,6 +128,22 @@ public:
     return m_rawData[index];
   }
 
+  const std::array<axis_config_d, DIM>& get_axes_config() const {
+    return m_axes_config;
+  }
+
+  /// Call @p f with each counter, in the order dump_formatted() lists them
+  template <typename F>
+  void for_each_value(F&& f) const {
+    int64_t size = 1;
+    for (const auto &ac : m_axes_config) {
+      size *= ac.m_buckets;
+    }
+    for (int64_t i = 0; i < size; i++) {
+      f(m_rawData[i].load());
+    }
+  }
+
   /// Dump data to a Formatter object
   void dump_formatted(ceph::Formatter *f) const {
     // Dump axes configuration
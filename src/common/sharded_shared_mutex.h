@@ -0,0 +1,104 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+/*
+ * Ceph - scalable distributed file system
+ *
+ * This is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License version 2.1, as published by the Free Software
+ * Foundation. See file COPYING.
+ *
+ */
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "common/ceph_mutex.h"
+
+namespace ceph {
+
+// A shared mutex for read-mostly state such as the Objecter's osdmap.
+//
+// Even uncontended, every lock_shared() of a single shared_mutex
+// modifies the same cache line, so many threads which only ever read
+// still serialize on it.  Here, each thread takes its shared lock
+// on one of several shards (picked once per thread), whereas exclusive
+// owners lock every shard, in order.  Readers on different shards never
+// touch each other's cache lines, and an exclusive owner still sees a
+// state that no reader can observe halfway through an update.
+//
+// Shared ownership must be released by the thread that acquired it.
+class sharded_shared_mutex {
+  struct alignas(64) shard_t {
+    ceph::shared_mutex lock;
+    explicit shard_t(const std::string& name)
+      : lock(ceph::make_shared_mutex(name)) {}
+  };
+  std::vector<std::unique_ptr<shard_t>> shards;
+
+  shard_t& my_shard() {
+    static std::atomic<unsigned> next_thread = {0};
+    thread_local const unsigned thread_idx = next_thread++;
+    return *shards[thread_idx % shards.size()];
+  }
+
+public:
+  explicit sharded_shared_mutex(const std::string& name,
+				size_t num_shards = 1) {
+    if (num_shards == 0) {
+      num_shards = 1;
+    }
+    shards.reserve(num_shards);
+    for (size_t i = 0; i < num_shards; ++i) {
+      shards.emplace_back(std::make_unique<shard_t>(
+	num_shards == 1 ? name : name + "." + std::to_string(i)));
+    }
+  }
+  sharded_shared_mutex(const sharded_shared_mutex&) = delete;
+  sharded_shared_mutex& operator=(const sharded_shared_mutex&) = delete;
+
+  size_t get_num_shards() const {
+    return shards.size();
+  }
+
+  // exclusive
+  void lock() {
+    for (auto& s : shards) {
+      s->lock.lock();
+    }
+  }
+  bool try_lock() {
+    for (auto p = shards.begin(); p != shards.end(); ++p) {
+      if (!(*p)->lock.try_lock()) {
+	while (p != shards.begin()) {
+	  --p;
+	  (*p)->lock.unlock();
+	}
+	return false;
+      }
+    }
+    return true;
+  }
+  void unlock() {
+    for (auto p = shards.rbegin(); p != shards.rend(); ++p) {
+      (*p)->lock.unlock();
+    }
+  }
+
+  // shared
+  void lock_shared() {
+    my_shard().lock.lock_shared();
+  }
+  bool try_lock_shared() {
+    return my_shard().lock.try_lock_shared();
+  }
+  void unlock_shared() {
+    my_shard().lock.unlock_shared();
+  }
+};
+
+} // namespace ceph
@@ -0,0 +1,287 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+/*
+ * Ceph - scalable distributed file system
+ *
+ * This is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License version 2.1, as published by the Free Software
+ * Foundation. See file COPYING.
+ *
+ */
+
+#ifndef CEPH_COMMON_TIMER_WHEEL_H
+#define CEPH_COMMON_TIMER_WHEEL_H
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <unordered_map>
+
+#include <boost/intrusive/list.hpp>
+#include <boost/intrusive/set.hpp>
+
+#include "include/ceph_assert.h"
+
+namespace ceph {
+
+/**
+ * timer_wheel
+ *
+ * Events keyed by a unique key, due at a time of Clock, in a hierarchical
+ * timing wheel: adding and cancelling an event take constant time however
+ * many are scheduled.  The events of a wheel slot are sorted once their
+ * tick comes, so that they are due at their exact time, in the order of
+ * their times, and of their addition for the same time.
+ *
+ * Not thread safe; the owner serializes the calls.
+ */
+template<typename Clock, typename Key>
+class timer_wheel {
+public:
+  using time_point = typename Clock::time_point;
+  using duration = typename Clock::duration;
+
+private:
+  static constexpr unsigned SLOT_BITS = 6;
+  static constexpr unsigned SLOTS = 1u << SLOT_BITS;
+  static constexpr unsigned LEVELS = 4;
+  static constexpr uint64_t SLOT_MASK = SLOTS - 1;
+  /// the level 0 slots are a tick apart, each level SLOTS times longer
+  static constexpr duration TICK =
+    std::chrono::duration_cast<duration>(std::chrono::milliseconds(1));
+  /// the events further away than this wait in the last slot to come
+  static constexpr uint64_t MAX_DELTA = (1ull << (SLOT_BITS * LEVELS)) - 1;
+
+  using list_hook = boost::intrusive::list_member_hook<>;
+  using set_hook = boost::intrusive::set_member_hook<>;
+
+  struct event_t {
+    time_point when;
+    uint64_t seq;
+    Key key;
+    uint64_t tick;
+    int level = -1;  ///< -1 once it is ready
+    unsigned slot = 0;
+    list_hook slot_item;
+    set_hook ready_item;
+
+    event_t(time_point when, uint64_t seq, Key key)
+      : when(when), seq(seq), key(key),
+	tick(when.time_since_epoch() / TICK) {}
+
+    friend bool operator <(const event_t& l, const event_t& r) {
+      return l.when == r.when ? l.seq < r.seq : l.when < r.when;
+    }
+  };
+
+  using slot_t = boost::intrusive::list<
+    event_t,
+    boost::intrusive::member_hook<event_t, list_hook, &event_t::slot_item>>;
+  using ready_t = boost::intrusive::multiset<
+    event_t,
+    boost::intrusive::member_hook<event_t, set_hook, &event_t::ready_item>>;
+
+  std::unordered_map<Key, event_t> events;
+  std::array<std::array<slot_t, SLOTS>, LEVELS> wheel;
+  std::array<uint64_t, LEVELS> occupied = {}; ///< a bit per nonempty slot
+  size_t num_in_wheel = 0;
+  /// the events of the past ticks, by time
+  ready_t ready;
+  /// the last tick whose events were moved to ready
+  uint64_t cur = 0;
+  uint64_t next_seq = 0;
+
+  static uint64_t rotr(uint64_t v, unsigned n) {
+    n &= 63;
+    return n ? (v >> n) | (v << (64 - n)) : v;
+  }
+
+  void _schedule(event_t& e) {
+    if (e.tick <= cur) {
+      e.level = -1;
+      ready.insert(e);
+      return;
+    }
+    uint64_t delta = e.tick - cur;
+    uint64_t tick = e.tick;
+    if (delta > MAX_DELTA) {
+      // cascaded down again as it gets closer
+      delta = MAX_DELTA;
+      tick = cur + MAX_DELTA;
+    }
+    unsigned level = 0;
+    while (delta >> (SLOT_BITS * (level + 1))) {
+      ++level;
+    }
+    e.level = level;
+    e.slot = (tick >> (SLOT_BITS * level)) & SLOT_MASK;
+    wheel[level][e.slot].push_back(e);
+    occupied[level] |= 1ull << e.slot;
+    ++num_in_wheel;
+  }
+
+  void _unschedule(event_t& e) {
+    if (e.level < 0) {
+      ready.erase(ready.iterator_to(e));
+      return;
+    }
+    auto& slot = wheel[e.level][e.slot];
+    slot.erase(slot.iterator_to(e));
+    if (slot.empty()) {
+      occupied[e.level] &= ~(1ull << e.slot);
+    }
+    --num_in_wheel;
+  }
+
+  /// move the events of @p level, @p slot down to where they now belong
+  void _cascade(unsigned level, unsigned slot) {
+    slot_t moving;
+    moving.swap(wheel[level][slot]);
+    occupied[level] &= ~(1ull << slot);
+    num_in_wheel -= moving.size();
+    while (!moving.empty()) {
+      auto& e = moving.front();
+      moving.pop_front();
+      _schedule(e);
+    }
+  }
+
+  /// the first tick after cur at which the wheel has something to do
+  uint64_t _next_tick() const {
+    uint64_t next = UINT64_MAX;
+    for (unsigned l = 0; l < LEVELS; ++l) {
+      if (!occupied[l]) {
+	continue;
+      }
+      const unsigned shift = SLOT_BITS * l;
+      // the start of the next slot of this level, and its index
+      const uint64_t start = ((cur >> shift) + 1) << shift;
+      const unsigned index = (start >> shift) & SLOT_MASK;
+      const uint64_t t =
+	start + (uint64_t(__builtin_ctzll(rotr(occupied[l], index))) << shift);
+      next = std::min(next, t);
+    }
+    return next;
+  }
+
+  /// turn the wheel up to @p now, moving what is due by then to ready
+  void _advance(time_point now) {
+    const uint64_t target = now.time_since_epoch() / TICK;
+    while (cur < target) {
+      const uint64_t next = num_in_wheel ? _next_tick() : UINT64_MAX;
+      if (next > target) {
+	cur = target;
+	break;
+      }
+      cur = next;
+      for (unsigned l = 1; l < LEVELS; ++l) {
+	const unsigned shift = SLOT_BITS * l;
+	if (cur & ((1ull << shift) - 1)) {
+	  break;
+	}
+	_cascade(l, (cur >> shift) & SLOT_MASK);
+      }
+      _cascade(0, cur & SLOT_MASK);
+    }
+  }
+
+public:
+  timer_wheel() = default;
+  timer_wheel(const timer_wheel&) = delete;
+  timer_wheel& operator=(const timer_wheel&) = delete;
+  ~timer_wheel() {
+    clear();
+  }
+
+  bool empty() const {
+    return events.empty();
+  }
+  size_t size() const {
+    return events.size();
+  }
+  bool contains(const Key& key) const {
+    return events.count(key);
+  }
+
+  /// schedule @p key at @p when; the key must not be scheduled already
+  void add(time_point when, Key key) {
+    if (events.empty()) {
+      // nothing to catch up with
+      cur = std::max<uint64_t>(cur, Clock::now().time_since_epoch() / TICK);
+    }
+    auto [p, inserted] = events.try_emplace(key, when, next_seq++, key);
+    ceph_assert(inserted);
+    _schedule(p->second);
+  }
+
+  /// @returns the time @p key was scheduled at, if it was, and unschedule it
+  std::optional<time_point> cancel(const Key& key) {
+    auto p = events.find(key);
+    if (p == events.end()) {
+      return std::nullopt;
+    }
+    auto when = p->second.when;
+    _unschedule(p->second);
+    events.erase(p);
+    return when;
+  }
+
+  /// @returns the time at which pop() should be called next, if ever
+  std::optional<time_point> next_wakeup() const {
+    if (!ready.empty()) {
+      return ready.begin()->when;
+    }
+    if (!num_in_wheel) {
+      return std::nullopt;
+    }
+    return time_point(TICK * static_cast<typename duration::rep>(_next_tick()));
+  }
+
+  /// take out the first event due by @p now, if any
+  std::optional<Key> pop(time_point now) {
+    _advance(now);
+    if (ready.empty() || ready.begin()->when > now) {
+      return std::nullopt;
+    }
+    auto& e = *ready.begin();
+    ready.erase(ready.begin());
+    Key key = e.key;
+    events.erase(key);
+    return key;
+  }
+
+  template<typename F>
+  void for_each(F&& f) const {
+    for (auto& [key, e] : events) {
+      f(e.when, key);
+    }
+  }
+
+  /// unschedule everything, handing each key to @p f
+  template<typename F>
+  void clear_and_dispose(F&& f) {
+    ready.clear();
+    for (auto& level : wheel) {
+      for (auto& slot : level) {
+	slot.clear();
+      }
+    }
+    occupied = {};
+    num_in_wheel = 0;
+    while (!events.empty()) {
+      auto p = events.begin();
+      Key key = p->first;
+      events.erase(p);
+      f(key);
+    }
+  }
+  void clear() {
+    clear_and_dispose([](const Key&) {});
+  }
+};
+
+} // namespace ceph
+
+#endif
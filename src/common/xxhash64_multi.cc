@@ -0,0 +1,208 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+
+#include "common/xxhash64_multi.h"
+
+#include "arch/intel.h"
+#include "arch/probe.h"
+#include "xxHash/xxhash.h"
+
+#ifdef __x86_64__
+
+#include <immintrin.h>
+
+namespace {
+
+constexpr uint64_t PRIME64_1 = 0x9E3779B185EBCA87ULL;
+constexpr uint64_t PRIME64_2 = 0xC2B2AE3D27D4EB4FULL;
+constexpr uint64_t PRIME64_3 = 0x165667B19E3779F9ULL;
+constexpr uint64_t PRIME64_4 = 0x85EBCA77C2B2AE63ULL;
+constexpr uint64_t PRIME64_5 = 0x27D4EB2F165667C5ULL;
+
+#define XXH64_TARGET __attribute__((target("avx512f,avx512dq")))
+
+XXH64_TARGET inline __m512i mul(__m512i a, uint64_t b)
+{
+  return _mm512_mullo_epi64(a, _mm512_set1_epi64(b));
+}
+
+XXH64_TARGET inline __m512i add(__m512i a, uint64_t b)
+{
+  return _mm512_add_epi64(a, _mm512_set1_epi64(b));
+}
+
+XXH64_TARGET inline __m512i xxh_round(__m512i acc, __m512i input)
+{
+  acc = _mm512_add_epi64(acc, mul(input, PRIME64_2));
+  acc = _mm512_rol_epi64(acc, 31);
+  return mul(acc, PRIME64_1);
+}
+
+XXH64_TARGET inline __m512i merge_round(__m512i acc, __m512i val)
+{
+  val = xxh_round(_mm512_setzero_si512(), val);
+  acc = _mm512_xor_si512(acc, val);
+  return add(mul(acc, PRIME64_1), PRIME64_4);
+}
+
+// the 8 bytes at @p off of each lane
+XXH64_TARGET inline __m512i load64(__m512i addrs, size_t off)
+{
+  return _mm512_i64gather_epi64(add(addrs, off), nullptr, 1);
+}
+
+XXH64_TARGET inline __m512i load32(__m512i addrs, size_t off)
+{
+  return _mm512_and_si512(load64(addrs, off),
+			  _mm512_set1_epi64(0xffffffffULL));
+}
+
+// transpose the 8x8 64-bit matrix r0..r7: ri gets the i-th word of
+// each.  Written out, as the compiler keeps arrays of vectors on the
+// stack unless it unrolls.
+XXH64_TARGET inline void transpose(__m512i& r0, __m512i& r1, __m512i& r2,
+				   __m512i& r3, __m512i& r4, __m512i& r5,
+				   __m512i& r6, __m512i& r7)
+{
+  __m512i t0 = _mm512_unpacklo_epi64(r0, r1);
+  __m512i t1 = _mm512_unpackhi_epi64(r0, r1);
+  __m512i t2 = _mm512_unpacklo_epi64(r2, r3);
+  __m512i t3 = _mm512_unpackhi_epi64(r2, r3);
+  __m512i t4 = _mm512_unpacklo_epi64(r4, r5);
+  __m512i t5 = _mm512_unpackhi_epi64(r4, r5);
+  __m512i t6 = _mm512_unpacklo_epi64(r6, r7);
+  __m512i t7 = _mm512_unpackhi_epi64(r6, r7);
+  const __m512i lo2 = _mm512_setr_epi64(0, 1, 8, 9, 4, 5, 12, 13);
+  const __m512i hi2 = _mm512_setr_epi64(2, 3, 10, 11, 6, 7, 14, 15);
+  __m512i u0 = _mm512_permutex2var_epi64(t0, lo2, t2);
+  __m512i u1 = _mm512_permutex2var_epi64(t1, lo2, t3);
+  __m512i u2 = _mm512_permutex2var_epi64(t0, hi2, t2);
+  __m512i u3 = _mm512_permutex2var_epi64(t1, hi2, t3);
+  __m512i u4 = _mm512_permutex2var_epi64(t4, lo2, t6);
+  __m512i u5 = _mm512_permutex2var_epi64(t5, lo2, t7);
+  __m512i u6 = _mm512_permutex2var_epi64(t4, hi2, t6);
+  __m512i u7 = _mm512_permutex2var_epi64(t5, hi2, t7);
+  const __m512i lo4 = _mm512_setr_epi64(0, 1, 2, 3, 8, 9, 10, 11);
+  const __m512i hi4 = _mm512_setr_epi64(4, 5, 6, 7, 12, 13, 14, 15);
+  r0 = _mm512_permutex2var_epi64(u0, lo4, u4);
+  r1 = _mm512_permutex2var_epi64(u1, lo4, u5);
+  r2 = _mm512_permutex2var_epi64(u2, lo4, u6);
+  r3 = _mm512_permutex2var_epi64(u3, lo4, u7);
+  r4 = _mm512_permutex2var_epi64(u0, hi4, u4);
+  r5 = _mm512_permutex2var_epi64(u1, hi4, u5);
+  r6 = _mm512_permutex2var_epi64(u2, hi4, u6);
+  r7 = _mm512_permutex2var_epi64(u3, hi4, u7);
+}
+
+// XXH64 for 8 buffers of the same length, one per lane: as the
+// length is shared, so is the control flow.  Each lane may only read
+// the len bytes of its buffer, so the tail is loaded with gathers of
+// the exact width.
+XXH64_TARGET void xxhash64_x8(uint64_t seed, const unsigned char* const* buffers,
+			      size_t len, uint64_t* out)
+{
+  __m512i addrs = _mm512_loadu_si512(buffers);
+  __m512i h;
+  size_t off = 0;
+  if (len >= 32) {
+    __m512i v1 = _mm512_set1_epi64(seed + PRIME64_1 + PRIME64_2);
+    __m512i v2 = _mm512_set1_epi64(seed + PRIME64_2);
+    __m512i v3 = _mm512_set1_epi64(seed);
+    __m512i v4 = _mm512_set1_epi64(seed - PRIME64_1);
+    // two stripes of each lane at a time, turned into 8 words of
+    // every lane
+    for (; off + 64 <= len; off += 64) {
+      __m512i r0 = _mm512_loadu_si512(buffers[0] + off);
+      __m512i r1 = _mm512_loadu_si512(buffers[1] + off);
+      __m512i r2 = _mm512_loadu_si512(buffers[2] + off);
+      __m512i r3 = _mm512_loadu_si512(buffers[3] + off);
+      __m512i r4 = _mm512_loadu_si512(buffers[4] + off);
+      __m512i r5 = _mm512_loadu_si512(buffers[5] + off);
+      __m512i r6 = _mm512_loadu_si512(buffers[6] + off);
+      __m512i r7 = _mm512_loadu_si512(buffers[7] + off);
+      transpose(r0, r1, r2, r3, r4, r5, r6, r7);
+      v1 = xxh_round(v1, r0);
+      v2 = xxh_round(v2, r1);
+      v3 = xxh_round(v3, r2);
+      v4 = xxh_round(v4, r3);
+      v1 = xxh_round(v1, r4);
+      v2 = xxh_round(v2, r5);
+      v3 = xxh_round(v3, r6);
+      v4 = xxh_round(v4, r7);
+    }
+    for (; off + 32 <= len; off += 32) {
+      v1 = xxh_round(v1, load64(addrs, off));
+      v2 = xxh_round(v2, load64(addrs, off + 8));
+      v3 = xxh_round(v3, load64(addrs, off + 16));
+      v4 = xxh_round(v4, load64(addrs, off + 24));
+    }
+    h = _mm512_add_epi64(
+      _mm512_add_epi64(_mm512_rol_epi64(v1, 1), _mm512_rol_epi64(v2, 7)),
+      _mm512_add_epi64(_mm512_rol_epi64(v3, 12), _mm512_rol_epi64(v4, 18)));
+    h = merge_round(h, v1);
+    h = merge_round(h, v2);
+    h = merge_round(h, v3);
+    h = merge_round(h, v4);
+  } else {
+    h = _mm512_set1_epi64(seed + PRIME64_5);
+  }
+  h = add(h, len);
+  for (; off + 8 <= len; off += 8) {
+    __m512i k1 = xxh_round(_mm512_setzero_si512(), load64(addrs, off));
+    h = _mm512_xor_si512(h, k1);
+    h = add(mul(_mm512_rol_epi64(h, 27), PRIME64_1), PRIME64_4);
+  }
+  if (off + 4 <= len) {
+    h = _mm512_xor_si512(h, mul(load32(addrs, off), PRIME64_1));
+    h = add(mul(_mm512_rol_epi64(h, 23), PRIME64_2), PRIME64_3);
+    off += 4;
+  }
+  if (off < len) {
+    // the last 1-3 bytes, read as 32-bit words ending at the last byte
+    size_t rest = len - off;
+    __m512i tail = _mm512_srli_epi64(load32(addrs, len - 4), 8 * (4 - rest));
+    for (; rest > 0; --rest) {
+      __m512i b = _mm512_and_si512(tail, _mm512_set1_epi64(0xff));
+      h = _mm512_xor_si512(h, mul(b, PRIME64_5));
+      h = mul(_mm512_rol_epi64(h, 11), PRIME64_1);
+      tail = _mm512_srli_epi64(tail, 8);
+    }
+  }
+  h = _mm512_xor_si512(h, _mm512_srli_epi64(h, 33));
+  h = mul(h, PRIME64_2);
+  h = _mm512_xor_si512(h, _mm512_srli_epi64(h, 29));
+  h = mul(h, PRIME64_3);
+  h = _mm512_xor_si512(h, _mm512_srli_epi64(h, 32));
+  _mm512_storeu_si512(out, h);
+}
+
+bool have_avx512()
+{
+  ceph_arch_probe();
+  return ceph_arch_intel_avx512;
+}
+
+} // anonymous namespace
+
+#endif
+
+void ceph_xxhash64_multi(uint64_t seed,
+			 const unsigned char* const* buffers,
+			 size_t len, unsigned count,
+			 uint64_t* out)
+{
+  unsigned i = 0;
+#ifdef __x86_64__
+  static const bool avx512 = have_avx512();
+  // short buffers are not worth it, and their tail loads would start
+  // before the buffer
+  if (avx512 && len >= 32) {
+    for (; i + 8 <= count; i += 8) {
+      xxhash64_x8(seed, buffers + i, len, out + i);
+    }
+  }
+#endif
+  for (; i < count; ++i) {
+    out[i] = XXH64(buffers[i], len, seed);
+  }
+}
@@ -0,0 +1,22 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+
+#ifndef CEPH_COMMON_XXHASH64_MULTI_H
+#define CEPH_COMMON_XXHASH64_MULTI_H
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * xxhash64 of @p count buffers of @p len bytes each, all seeded with
+ * @p seed, into @p out.
+ *
+ * With AVX-512 the buffers are hashed 8 at a time, one per 64-bit lane;
+ * otherwise one after the other.
+ */
+void ceph_xxhash64_multi(uint64_t seed,
+			 const unsigned char* const* buffers,
+			 size_t len, unsigned count,
+			 uint64_t* out);
+
+#endif
@@ -15,9 +15,11 @@
 #ifndef CEPH_COMPRESSOR_H
 #define CEPH_COMPRESSOR_H
 
+#include <cerrno>
 #include <memory>
 #include <string>
 #include <string_view>
+#include <vector>
 #include <boost/optional.hpp>
 #include "include/ceph_assert.h"    // boost clobbers this
 #include "include/common_fwd.h"
@@ -96,6 +98,48 @@ public:
   // alignment with decode methods
   virtual int decompress(ceph::bufferlist::const_iterator &p, size_t compressed_len, ceph::bufferlist &out, boost::optional<int32_t> compressor_message) = 0;
 
+  /**
+   * Dictionary - a trained dictionary, digested for one algorithm
+   *
+   * Small inputs have little history of their own to match against,
+   * so compressing them against a dictionary trained on similar data
+   * (e.g. sampled objects of the same pool) gives much better ratios.
+   * Only some algorithms support dictionaries, the defaults below fail
+   * with -EOPNOTSUPP.
+   */
+  class Dictionary {
+  public:
+    explicit Dictionary(CompressionAlgorithm a) : alg(a) {}
+    virtual ~Dictionary() {}
+    CompressionAlgorithm get_type() const {
+      return alg;
+    }
+    /// id recorded with the data compressed against it, never 0
+    virtual uint32_t get_id() const = 0;
+  private:
+    CompressionAlgorithm alg;
+  };
+  typedef std::shared_ptr<Dictionary> DictionaryRef;
+
+  /// train a dictionary of at most dict_size bytes from samples
+  virtual int train_dictionary(const std::vector<ceph::bufferlist> &samples, size_t dict_size, ceph::bufferlist *dict) {
+    return -EOPNOTSUPP;
+  }
+  /// digest a dictionary made by train_dictionary(), nullptr if not valid
+  virtual DictionaryRef load_dictionary(const ceph::bufferlist &dict) {
+    return nullptr;
+  }
+  /// the id of the dictionary needed to decompress, 0 if none
+  virtual uint32_t get_dictionary_id(const boost::optional<int32_t> &compressor_message) const {
+    return 0;
+  }
+  virtual int compress_with_dictionary(const ceph::bufferlist &in, ceph::bufferlist &out, boost::optional<int32_t> &compressor_message, const Dictionary &dict) {
+    return -EOPNOTSUPP;
+  }
+  virtual int decompress_with_dictionary(ceph::bufferlist::const_iterator &p, size_t compressed_len, ceph::bufferlist &out, boost::optional<int32_t> compressor_message, const Dictionary &dict) {
+    return -EOPNOTSUPP;
+  }
+
   static CompressorRef create(CephContext *cct, const std::string &type);
   static CompressorRef create(CephContext *cct, int alg);
 
@@ -17,6 +17,7 @@
 
 #define ZSTD_STATIC_LINKING_ONLY
 #include "zstd/lib/zstd.h"
+#include "zstd/lib/zdict.h"
 
 #include "include/buffer.h"
 #include "include/encoding.h"
@@ -26,9 +27,122 @@ class ZstdCompressor : public Compressor {
  public:
   ZstdCompressor(CephContext *cct) : Compressor(COMP_ALG_ZSTD, "zstd"), cct(cct) {}
 
+  class ZstdDictionary : public Dictionary {
+  public:
+    ZstdDictionary(uint32_t id, ZSTD_CDict *cdict, ZSTD_DDict *ddict)
+      : Dictionary(COMP_ALG_ZSTD), id(id), cdict(cdict), ddict(ddict) {}
+    ~ZstdDictionary() override {
+      ZSTD_freeCDict(cdict);
+      ZSTD_freeDDict(ddict);
+    }
+    uint32_t get_id() const override {
+      return id;
+    }
+    const uint32_t id;
+    ZSTD_CDict *const cdict;
+    ZSTD_DDict *const ddict;
+  };
+
   int compress(const ceph::buffer::list &src, ceph::buffer::list &dst, boost::optional<int32_t> &compressor_message) override {
+    return _compress(src, dst, nullptr);
+  }
+
+  int decompress(const ceph::buffer::list &src, ceph::buffer::list &dst, boost::optional<int32_t> compressor_message) override {
+    auto i = std::cbegin(src);
+    return decompress(i, src.length(), dst, compressor_message);
+  }
+
+  int decompress(ceph::buffer::list::const_iterator &p,
+		 size_t compressed_len,
+		 ceph::buffer::list &dst,
+		 boost::optional<int32_t> compressor_message) override {
+    return _decompress(p, compressed_len, dst, nullptr);
+  }
+
+  int train_dictionary(const std::vector<ceph::buffer::list> &samples,
+		       size_t dict_size,
+		       ceph::buffer::list *dict) override {
+    ceph::buffer::list all;
+    std::vector<size_t> sizes;
+    sizes.reserve(samples.size());
+    for (auto& i : samples) {
+      if (i.length()) {
+	all.append(i);
+	sizes.push_back(i.length());
+      }
+    }
+    ceph::buffer::ptr dictptr(dict_size);
+    size_t r = ZDICT_trainFromBuffer(dictptr.c_str(), dictptr.length(),
+				     all.c_str(), sizes.data(), sizes.size());
+    if (ZDICT_isError(r)) {
+      return -EINVAL;
+    }
+    dict->append(dictptr, 0, r);
+    return 0;
+  }
+
+  DictionaryRef load_dictionary(const ceph::buffer::list &dict) override {
+    ceph::buffer::list t = dict;
+    const char *d = t.c_str();
+    // raw content would be accepted by zstd too, but it carries no id
+    // to find it again when decompressing
+    uint32_t id = ZDICT_getDictID(d, t.length());
+    if (id == 0) {
+      return nullptr;
+    }
+    ZSTD_CDict *cdict = ZSTD_createCDict(d, t.length(),
+					 cct->_conf->compressor_zstd_level);
+    ZSTD_DDict *ddict = ZSTD_createDDict(d, t.length());
+    if (!cdict || !ddict) {
+      ZSTD_freeCDict(cdict);
+      ZSTD_freeDDict(ddict);
+      return nullptr;
+    }
+    return std::make_shared<ZstdDictionary>(id, cdict, ddict);
+  }
+
+  uint32_t get_dictionary_id(const boost::optional<int32_t> &compressor_message) const override {
+    return compressor_message ? (uint32_t)*compressor_message : 0;
+  }
+
+  int compress_with_dictionary(const ceph::buffer::list &src,
+			       ceph::buffer::list &dst,
+			       boost::optional<int32_t> &compressor_message,
+			       const Dictionary &dict) override {
+    if (dict.get_type() != get_type()) {
+      return -EINVAL;
+    }
+    auto& d = static_cast<const ZstdDictionary&>(dict);
+    int r = _compress(src, dst, d.cdict);
+    if (r == 0) {
+      compressor_message = (int32_t)d.get_id();
+    }
+    return r;
+  }
+
+  int decompress_with_dictionary(ceph::buffer::list::const_iterator &p,
+				 size_t compressed_len,
+				 ceph::buffer::list &dst,
+				 boost::optional<int32_t> compressor_message,
+				 const Dictionary &dict) override {
+    if (dict.get_type() != get_type() ||
+	dict.get_id() != get_dictionary_id(compressor_message)) {
+      return -EINVAL;
+    }
+    return _decompress(p, compressed_len, dst,
+		       static_cast<const ZstdDictionary&>(dict).ddict);
+  }
+
+ private:
+  int _compress(const ceph::buffer::list &src, ceph::buffer::list &dst,
+		const ZSTD_CDict *cdict) {
     ZSTD_CStream *s = ZSTD_createCStream();
-    ZSTD_initCStream_srcSize(s, cct->_conf->compressor_zstd_level, src.length());
+    if (cdict) {
+      ZSTD_CCtx_refCDict(s, cdict);
+      ZSTD_CCtx_setPledgedSrcSize(s, src.length());
+    } else {
+      ZSTD_initCStream_srcSize(s, cct->_conf->compressor_zstd_level, src.length());
+    }
     auto p = src.begin();
     size_t left = src.length();
 
@@ -48,6 +162,7 @@ class ZstdCompressor : public Compressor {
       ZSTD_EndDirective const zed = (left==0) ? ZSTD_e_end : ZSTD_e_continue;
       size_t r = ZSTD_compressStream2(s, &outbuf, &inbuf, zed);
       if (ZSTD_isError(r)) {
+	ZSTD_freeCStream(s);
 	return -EINVAL;
       }
     }
@@ -61,15 +176,10 @@ class ZstdCompressor : public Compressor {
     return 0;
   }
 
-  int decompress(const ceph::buffer::list &src, ceph::buffer::list &dst, boost::optional<int32_t> compressor_message) override {
-    auto i = std::cbegin(src);
-    return decompress(i, src.length(), dst, compressor_message);
-  }
-
-  int decompress(ceph::buffer::list::const_iterator &p,
-		 size_t compressed_len,
-		 ceph::buffer::list &dst,
-		 boost::optional<int32_t> compressor_message) override {
+  int _decompress(ceph::buffer::list::const_iterator &p,
+		  size_t compressed_len,
+		  ceph::buffer::list &dst,
+		  const ZSTD_DDict *ddict) {
     if (compressed_len < 4) {
       return -1;
     }
@@ -84,15 +194,23 @@ class ZstdCompressor : public Compressor {
     outbuf.pos = 0;
     ZSTD_DStream *s = ZSTD_createDStream();
     ZSTD_initDStream(s);
+    if (ddict) {
+      ZSTD_DCtx_refDDict(s, ddict);
+    }
     while (compressed_len > 0) {
       if (p.end()) {
+	ZSTD_freeDStream(s);
 	return -1;
       }
       ZSTD_inBuffer_s inbuf;
       inbuf.pos = 0;
       inbuf.size = p.get_ptr_and_advance(compressed_len,
 					 (const char**)&inbuf.src);
-      ZSTD_decompressStream(s, &outbuf, &inbuf);
+      size_t r = ZSTD_decompressStream(s, &outbuf, &inbuf);
+      if (ZSTD_isError(r)) {
+	ZSTD_freeDStream(s);
+	return -1;
+      }
       compressed_len -= inbuf.size;
     }
     ZSTD_freeDStream(s);
@@ -100,7 +218,7 @@ class ZstdCompressor : public Compressor {
     dst.append(dstptr, 0, outbuf.pos);
     return 0;
   }
- private:
+
   CephContext *const cct;
 };
 
@@ -289,12 +289,11 @@ seastar::future<> ProtocolV2::read_frame_payload()
                        conn, alignment, rx_segments_data.size());
       }
       uint32_t onwire_len = rx_frame_asm.get_segment_onwire_len(seg_idx);
-      // TODO: create aligned and contiguous buffer from socket
-      return read_exactly(onwire_len).then([this] (auto tmp_bl) {
+      // read_exactly() copies whatever spans the buffers of the input
+      // stream into a contiguous one, read() shares them instead
+      return read(onwire_len).then([this] (auto segment) {
         logger().trace("{} RECV({}) frame segment[{}]",
-                       conn, tmp_bl.size(), rx_segments_data.size());
-        bufferlist segment;
-        segment.append(buffer::create(std::move(tmp_bl)));
+                       conn, segment.length(), rx_segments_data.size());
         rx_segments_data.emplace_back(std::move(segment));
       });
     }
@@ -69,10 +69,11 @@ void ThreadPool::loop(std::chrono::milliseconds queue_max_wait, size_t shard)
 {
   auto& pending = pending_queues[shard];
   for (;;) {
-    WorkItem* work_item = nullptr;
-    work_item = pending.pop_front(queue_max_wait);
-    if (work_item) {
-      work_item->process();
+    auto work_items = pending.pop_all(queue_max_wait);
+    if (!work_items.empty()) {
+      for (auto work_item : work_items) {
+        work_item->process();
+      }
     } else if (is_stopping()) {
       break;
     }
@@ -4,10 +4,13 @@
 
 #include <atomic>
 #include <condition_variable>
+#include <deque>
+#include <mutex>
 #include <tuple>
 #include <type_traits>
 #include <boost/lockfree/queue.hpp>
 #include <boost/optional.hpp>
+#include <seastar/core/alien.hh>
 #include <seastar/core/future.hh>
 #include <seastar/core/gate.hh>
 #include <seastar/core/reactor.hh>
@@ -31,7 +34,8 @@ struct Task final : WorkItem {
   using futurator_t = seastar::futurize<T>;
 public:
   explicit Task(Func&& f)
-    : func(std::move(f))
+    : func(std::move(f)),
+      shard(seastar::this_shard_id())
   {}
   void process() override {
     try {
@@ -44,10 +48,14 @@ public:
     } catch (...) {
       state.set_exception(std::current_exception());
     }
-    on_done.write_side().signal(1);
+    // wake up the submitting reactor through its alien queue, instead of
+    // an eventfd of our own per task
+    seastar::alien::run_on(shard, [this] {
+      on_done.set_value();
+    });
   }
   typename futurator_t::type get_future() {
-    return on_done.wait().then([this](size_t) {
+    return on_done.get_future().then([this] {
       if (state.failed()) {
 	return futurator_t::make_exception_future(state.get_exception());
       } else {
@@ -57,8 +65,9 @@ public:
   }
 private:
   Func func;
+  const unsigned shard;
   seastar::future_state<future_stored_type_t> state;
-  seastar::readable_eventfd on_done;
+  seastar::promise<> on_done;
 };
 
 struct SubmitQueue {
@@ -74,28 +83,34 @@ struct SubmitQueue {
 
 struct ShardedWorkQueue {
 public:
-  WorkItem* pop_front(std::chrono::milliseconds& queue_max_wait) {
-    WorkItem* work_item = nullptr;
+  /// take all the queued items at once, waiting for some up to queue_max_wait
+  std::deque<WorkItem*> pop_all(std::chrono::milliseconds& queue_max_wait) {
+    std::deque<WorkItem*> work_items;
     std::unique_lock lock{mutex};
-    cond.wait_for(lock, queue_max_wait,
-		  [this, &work_item] {
-      bool empty = true;
-      if (!pending.empty()) {
-        empty = false;
-        work_item = pending.front();
-        pending.pop_front();
-      }
-      return !empty || is_stopping();
+    cond.wait_for(lock, queue_max_wait, [this] {
+      return !pending.empty() || is_stopping();
     });
-    return work_item;
+    work_items.swap(pending);
+    return work_items;
   }
   void stop() {
-    stopping = true;
+    {
+      std::lock_guard lock{mutex};
+      stopping = true;
+    }
     cond.notify_all();
   }
   void push_back(WorkItem* work_item) {
-    pending.push_back(work_item);
-    cond.notify_one();
+    bool was_empty;
+    {
+      std::lock_guard lock{mutex};
+      was_empty = pending.empty();
+      pending.push_back(work_item);
+    }
+    // the worker drains the whole queue once awake
+    if (was_empty) {
+      cond.notify_one();
+    }
   }
 private:
   bool is_stopping() const {
@@ -134,8 +149,6 @@ public:
    *                 multiple of the number of cores.
    * @param n_threads the number of threads in this thread pool.
    * @param cpu the CPU core to which this thread pool is assigned
-   * @note each @c Task has its own crimson::thread::Condition, which possesses
-   * an fd, so we should keep the size of queue under a reasonable limit.
    */
   ThreadPool(size_t n_threads, size_t queue_sz, std::vector<uint64_t> cpus);
   ~ThreadPool();
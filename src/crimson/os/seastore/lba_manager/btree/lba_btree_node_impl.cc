@@ -61,16 +61,23 @@ LBAInternalNode::lookup_range_ret LBAInternalNode::lookup_range(
   auto [begin, end] = bound(addr, addr + len);
   auto result_up = std::make_unique<lba_pin_list_t>();
   auto &result = *result_up;
-  return crimson::do_for_each(
-    std::move(begin),
-    std::move(end),
-    [this, c, &result, addr, len](const auto &val) mutable {
-      return get_lba_btree_extent(
+  /* the children in the range are all read at once, rather than each on
+   * the miss of the one before it, as a long range spans many leaves */
+  auto children_up = std::make_unique<std::vector<get_lba_node_ret>>();
+  auto &children = *children_up;
+  for (auto i = begin; i != end; ++i) {
+    children.emplace_back(
+      get_lba_btree_extent(
 	c,
 	this,
 	get_meta().depth - 1,
-	val.get_val(),
-	get_paddr()).safe_then(
+	i->get_val(),
+	get_paddr()));
+  }
+  return crimson::do_for_each(
+    children,
+    [c, &result, addr, len](auto &child) mutable {
+      return std::move(child).safe_then(
 	  [c, &result, addr, len](auto extent) mutable {
 	    return extent->lookup_range(
 	      c,
@@ -81,7 +88,9 @@ LBAInternalNode::lookup_range_ret LBAInternalNode::lookup_range(
 				pin_list.begin(), pin_list.end());
 		});
 	  });
-    }).safe_then([result=std::move(result_up), ref=LBANodeRef(this)] {
+    }).safe_then([result=std::move(result_up),
+		  children=std::move(children_up),
+		  ref=LBANodeRef(this)] {
       return lookup_range_ertr::make_ready_future<lba_pin_list_t>(
 	std::move(*result));
     });
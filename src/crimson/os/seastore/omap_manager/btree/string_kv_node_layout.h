@@ -5,6 +5,7 @@
 
 #include <iostream>
 #include <string>
+#include <string_view>
 
 #include "include/byteorder.h"
 #include "include/denc.h"
@@ -430,6 +431,13 @@ public:
 	get_node_key().key_len);
     }
 
+    /// the key in place, valid as long as the node is not modified
+    std::string_view get_key_view() const {
+      return std::string_view(
+	get_node_val_ptr(),
+	get_node_key().key_len);
+    }
+
     laddr_t get_val() const {
       return get_node_key().laddr;
     }
@@ -438,9 +446,9 @@ public:
       assert(*this != node->iter_end());
       auto next = *this + 1;
       if (next == node->iter_end()) {
-        return get_key() <= key;
+        return get_key_view() <= key;
       } else {
-	return (get_key() <= key) && (next->get_key() > key);
+	return (get_key_view() <= key) && (next->get_key_view() > key);
       }
     }
   };
@@ -544,10 +552,10 @@ public:
     while (start != end) {
       unsigned mid = (start + end) / 2;
       const_iterator iter(this, mid);
-      std::string s = iter->get_key();
+      auto s = iter->get_key_view();
       if (s < str) {
         start = ++mid;
-      } else if ( s > str) {
+      } else if (s > str) {
         end = mid;
       } else {
         return iter;
@@ -562,13 +570,16 @@ public:
   }
 
   const_iterator string_upper_bound(std::string_view str) const {
-    auto ret = iter_begin();
-    for (; ret != iter_end(); ++ret) {
-      std::string s = ret->get_key();
-      if (s > str)
-        break;
+    uint16_t start = 0, end = get_size();
+    while (start != end) {
+      unsigned mid = (start + end) / 2;
+      if (const_iterator(this, mid)->get_key_view() <= str) {
+        start = mid + 1;
+      } else {
+        end = mid;
+      }
     }
-    return ret;
+    return const_iterator(this, start);
   }
 
   iterator string_upper_bound(std::string_view str) {
@@ -577,11 +588,9 @@ public:
   }
 
   const_iterator find_string_key(std::string_view str) const {
-    auto ret = iter_begin();
-    for (; ret != iter_end(); ++ret) {
-     std::string s = ret->get_key();
-      if (s == str)
-        break;
+    auto ret = string_lower_bound(str);
+    if (ret == iter_end() || ret->get_key_view() != str) {
+      return iter_end();
     }
     return ret;
   }
@@ -1020,6 +1029,13 @@ public:
 	get_node_key().key_len);
     }
 
+    /// the key in place, valid as long as the node is not modified
+    std::string_view get_key_view() const {
+      return std::string_view(
+	get_node_val_ptr(),
+	get_node_key().key_len);
+    }
+
     std::string get_str_val() const {
       auto node_key = get_node_key();
       return std::string(
@@ -1116,7 +1132,7 @@ public:
     while (start != end) {
       unsigned mid = (start + end) / 2;
       const_iterator iter(this, mid);
-      std::string s = iter->get_key();
+      auto s = iter->get_key_view();
       if (s < str) {
         start = ++mid;
       } else if (s > str) {
@@ -1134,13 +1150,16 @@ public:
   }
 
   const_iterator string_upper_bound(std::string_view str) const {
-    auto ret = iter_begin();
-    for (; ret != iter_end(); ++ret) {
-      std::string s = ret->get_key();
-      if (s > str)
-        break;
+    uint16_t start = 0, end = get_size();
+    while (start != end) {
+      unsigned mid = (start + end) / 2;
+      if (const_iterator(this, mid)->get_key_view() <= str) {
+        start = mid + 1;
+      } else {
+        end = mid;
+      }
     }
-    return ret;
+    return const_iterator(this, start);
   }
 
   iterator string_upper_bound(std::string_view str) {
@@ -1149,11 +1168,9 @@ public:
   }
 
   const_iterator find_string_key(std::string_view str) const {
-    auto ret = iter_begin();
-    for (; ret != iter_end(); ++ret) {
-      std::string s = ret->get_key();
-      if (s == str)
-        break;
+    auto ret = string_lower_bound(str);
+    if (ret == iter_end() || ret->get_key_view() != str) {
+      return iter_end();
     }
     return ret;
   }
@@ -18,6 +18,9 @@
 
 #include "crimson/os/seastore/segment_cleaner.h"
 #include "crimson/os/seastore/segment_manager/block.h"
+#ifdef HAVE_LIBZBD
+#include "crimson/os/seastore/segment_manager/zns.h"
+#endif
 #include "crimson/os/seastore/collection_manager/flat_collection_manager.h"
 #include "crimson/os/seastore/onode_manager/staged-fltree/fltree_onode_manager.h"
 #include "crimson/os/seastore/omap_manager/btree/btree_omap_manager.h"
@@ -1081,9 +1084,19 @@ std::unique_ptr<SeaStore> make_seastore(
   const std::string &device,
   const ConfigValues &config)
 {
-  auto sm = std::make_unique<
-    segment_manager::block::BlockSegmentManager
-    >(device + "/block");
+  SegmentManagerRef sm;
+#ifdef HAVE_LIBZBD
+  if (segment_manager::zns::ZNSSegmentManager::support(device + "/block")) {
+    sm = std::make_unique<
+      segment_manager::zns::ZNSSegmentManager
+      >(device + "/block");
+  }
+#endif
+  if (!sm) {
+    sm = std::make_unique<
+      segment_manager::block::BlockSegmentManager
+      >(device + "/block");
+  }
 
   auto segment_cleaner = std::make_unique<SegmentCleaner>(
     SegmentCleaner::config_t::get_default(),
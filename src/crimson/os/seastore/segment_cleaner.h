@@ -485,22 +485,44 @@ public:
     assert(ret >= 0);
   }
 
+  /**
+   * get_next_gc_target
+   *
+   * Picks by cost-benefit, as in LFS: the space cleaning a segment frees,
+   * weighed by the age of its data, over the cost of reading the segment
+   * and rewriting its live data.  The live data of an old segment is cold
+   * and unlikely to be freed by waiting, while a young one at the same
+   * utilization frees more if left to its overwrites.
+   */
   segment_id_t get_next_gc_target() const {
     segment_id_t ret = NULL_SEG_ID;
-    int64_t least_live_bytes = std::numeric_limits<int64_t>::max();
+    double best_score = -1;
     for (segment_id_t i = 0; i < segments.size(); ++i) {
-      if (segments[i].is_closed() &&
-	  !segments[i].is_in_journal(journal_tail_committed) &&
-	  space_tracker->get_usage(i) < least_live_bytes) {
+      if (!segments[i].is_closed() ||
+	  segments[i].is_in_journal(journal_tail_committed)) {
+	continue;
+      }
+      double utilization =
+	static_cast<double>(space_tracker->get_usage(i)) / segment_size;
+      // in journal segments written since it was
+      segment_seq_t seq = segments[i].journal_segment_seq;
+      double age = 1;
+      if (seq != NULL_SEG_SEQ && journal_head.segment_seq > seq) {
+	age += journal_head.segment_seq - seq;
+      }
+      double score = (1 - utilization) * age / (1 + utilization);
+      if (score > best_score) {
 	ret = i;
-	least_live_bytes = space_tracker->get_usage(i);
+	best_score = score;
       }
     }
     if (ret != NULL_SEG_ID) {
       crimson::get_logger(ceph_subsys_filestore).debug(
-	"SegmentCleaner::get_next_gc_target: segment {} seq {}",
+	"SegmentCleaner::get_next_gc_target: segment {} seq {} live {} score {}",
 	ret,
-	segments[ret].journal_segment_seq);
+	segments[ret].journal_segment_seq,
+	space_tracker->get_usage(ret),
+	best_score);
     }
     return ret;
   }
@@ -0,0 +1,508 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+
+#include <fcntl.h>
+#include <string.h>
+
+#include <libzbd/zbd.h>
+
+#include "crimson/common/log.h"
+
+#include "include/buffer.h"
+#include "crimson/os/seastore/segment_manager/zns.h"
+
+namespace {
+  seastar::logger& logger() {
+    return crimson::get_logger(ceph_subsys_filestore);
+  }
+}
+
+namespace crimson::os::seastore::segment_manager::zns {
+
+using write_ertr = crimson::errorator<
+  crimson::ct_error::input_output_error>;
+using read_ertr = crimson::errorator<
+  crimson::ct_error::input_output_error>;
+
+static write_ertr::future<> do_write(
+  seastar::file &device,
+  uint64_t offset,
+  bufferptr &bptr)
+{
+  logger().debug(
+    "zns: do_write offset {} len {}",
+    offset,
+    bptr.length());
+  return device.dma_write(
+    offset,
+    bptr.c_str(),
+    bptr.length()
+  ).handle_exception([](auto e) -> write_ertr::future<size_t> {
+      logger().error(
+	"do_write: dma_write got error {}",
+	e);
+      return crimson::ct_error::input_output_error::make();
+  }).then([length=bptr.length()](auto result)
+	       -> write_ertr::future<> {
+    if (result != length) {
+      return crimson::ct_error::input_output_error::make();
+    }
+    return write_ertr::now();
+  });
+}
+
+static read_ertr::future<> do_read(
+  seastar::file &device,
+  uint64_t offset,
+  bufferptr &bptr)
+{
+  logger().debug(
+    "zns: do_read offset {} len {}",
+    offset,
+    bptr.length());
+  return device.dma_read(
+    offset,
+    bptr.c_str(),
+    bptr.length()
+  ).handle_exception([](auto e) -> read_ertr::future<size_t> {
+    logger().error(
+      "do_read: dma_read got error {}",
+      e);
+    return crimson::ct_error::input_output_error::make();
+  }).then([length=bptr.length()](auto result) -> read_ertr::future<> {
+    if (result != length) {
+      return crimson::ct_error::input_output_error::make();
+    }
+    return read_ertr::now();
+  });
+}
+
+/**
+ * zone_layout_t
+ *
+ * The run of sequential write zones of a device, the first of which
+ * holds the superblock.  The zone management commands are short
+ * ioctls, and are issued synchronously.
+ */
+struct zone_layout_t {
+  uint64_t zone_size = 0;
+  uint64_t zone_capacity = 0;
+  uint64_t first_zone_offset = 0;
+  std::vector<zbd_zone> zones;
+};
+
+static int report_zones(int fd, zone_layout_t &layout)
+{
+  unsigned int nr_zones = 0;
+  if (zbd_report_nr_zones(fd, 0, 0, ZBD_RO_ALL, &nr_zones) != 0) {
+    return -EIO;
+  }
+  std::vector<zbd_zone> zones(nr_zones);
+  if (zbd_report_zones(fd, 0, 0, ZBD_RO_ALL, zones.data(), &nr_zones) != 0) {
+    return -EIO;
+  }
+  zones.resize(nr_zones);
+  layout.zones.clear();
+  for (auto &zone : zones) {
+    if (!zbd_zone_seq(&zone)) {
+      if (layout.zones.empty()) {
+	// the conventional zones in front of the sequential ones
+	continue;
+      }
+      // segments are addressed by their zone index from then on
+      break;
+    }
+    if (layout.zones.empty()) {
+      layout.zone_size = zbd_zone_len(&zone);
+      layout.zone_capacity = zbd_zone_capacity(&zone);
+      layout.first_zone_offset = zbd_zone_start(&zone);
+    } else if (zbd_zone_len(&zone) != layout.zone_size) {
+      break;
+    }
+    layout.zone_capacity = std::min<uint64_t>(
+      layout.zone_capacity, zbd_zone_capacity(&zone));
+    layout.zones.push_back(zone);
+  }
+  if (layout.zones.size() < 2) {
+    logger().error(
+      "report_zones: {} sequential zones, at least 2 are needed",
+      layout.zones.size());
+    return -EINVAL;
+  }
+  return 0;
+}
+
+using open_device_ret =
+  ZNSSegmentManager::access_ertr::future<
+  std::pair<seastar::file, seastar::stat_data>
+  >;
+static
+open_device_ret open_device(
+  const std::string &path,
+  seastar::open_flags mode)
+{
+  return seastar::file_stat(path, seastar::follow_symlink::yes
+  ).then([mode, &path](auto stat) mutable {
+    return seastar::open_file_dma(path, mode).then([=](auto file) {
+      logger().debug(
+	"open_device: open successful, size {}",
+	stat.size
+      );
+      return std::make_pair(file, stat);
+    });
+  }).handle_exception([](auto e) -> open_device_ret {
+    logger().error(
+      "open_device: got error {}",
+      e);
+    return crimson::ct_error::input_output_error::make();
+  });
+}
+
+static
+ZNSSegmentManager::access_ertr::future<>
+write_superblock(
+  seastar::file &device,
+  uint64_t offset,
+  zns_sm_superblock_t sb)
+{
+  assert(ceph::encoded_sizeof_bounded<zns_sm_superblock_t>() <
+	 sb.block_size);
+  return seastar::do_with(
+    bufferptr(ceph::buffer::create_page_aligned(sb.block_size)),
+    [=, &device](auto &bp) {
+      bufferlist bl;
+      encode(sb, bl);
+      auto iter = bl.begin();
+      assert(bl.length() < sb.block_size);
+      bp.zero();
+      iter.copy(bl.length(), bp.c_str());
+      logger().debug("write_superblock: doing writeout");
+      return do_write(device, offset, bp);
+    });
+}
+
+static
+ZNSSegmentManager::access_ertr::future<zns_sm_superblock_t>
+read_superblock(
+  seastar::file &device,
+  uint64_t offset,
+  seastar::stat_data sd)
+{
+  assert(ceph::encoded_sizeof_bounded<zns_sm_superblock_t>() <
+	 sd.block_size);
+  return seastar::do_with(
+    bufferptr(ceph::buffer::create_page_aligned(sd.block_size)),
+    [=, &device](auto &bp) {
+      return do_read(
+	device,
+	offset,
+	bp
+      ).safe_then([=, &bp] {
+	  bufferlist bl;
+	  bl.push_back(bp);
+	  zns_sm_superblock_t ret;
+	  auto bliter = bl.cbegin();
+	  decode(ret, bliter);
+	  return ZNSSegmentManager::access_ertr::future<zns_sm_superblock_t>(
+	    ZNSSegmentManager::access_ertr::ready_future_marker{},
+	    ret);
+      });
+    });
+}
+
+ZNSSegment::ZNSSegment(
+  ZNSSegmentManager &manager, segment_id_t id)
+  : manager(manager), id(id) {}
+
+segment_off_t ZNSSegment::get_write_capacity() const
+{
+  return manager.get_segment_size();
+}
+
+Segment::close_ertr::future<> ZNSSegment::close()
+{
+  // finishing the zone fails the writes still in flight, wait for them
+  return close_ertr::future<seastar::semaphore_units<>>(
+    seastar::get_units(write_lock, 1)
+  ).safe_then([this](auto units) {
+    return manager.segment_close(id).finally([units=std::move(units)] {});
+  });
+}
+
+Segment::write_ertr::future<> ZNSSegment::write(
+  segment_off_t offset, ceph::bufferlist bl)
+{
+  if (offset < write_pointer || offset % manager.superblock.block_size != 0)
+    return crimson::ct_error::invarg::make();
+
+  if (offset + bl.length() > manager.superblock.segment_size)
+    return crimson::ct_error::enospc::make();
+
+  // a zone cannot skip ahead of its write pointer, fill the gap
+  auto start = write_pointer;
+  write_pointer = offset + bl.length();
+  if (offset > start) {
+    bufferlist padded;
+    padded.append_zero(offset - start);
+    padded.claim_append(bl);
+    bl = std::move(padded);
+  }
+  return write_ertr::future<seastar::semaphore_units<>>(
+    seastar::get_units(write_lock, 1)
+  ).safe_then([this, start, bl=std::move(bl)](auto units) mutable {
+    return manager.segment_write(
+      {id, start}, std::move(bl)
+    ).finally([units=std::move(units)] {});
+  });
+}
+
+Segment::close_ertr::future<> ZNSSegmentManager::segment_close(segment_id_t id)
+{
+  paddr_t addr{id, 0};
+  if (zbd_finish_zones(zbd_fd, get_offset(addr), superblock.zone_size) != 0) {
+    logger().error(
+      "ZNSSegmentManager::segment_close: failed to finish zone of segment {}",
+      id);
+    return crimson::ct_error::input_output_error::make();
+  }
+  segment_state[id] = segment_state_t::CLOSED;
+  return Segment::close_ertr::now();
+}
+
+Segment::write_ertr::future<> ZNSSegmentManager::segment_write(
+  paddr_t addr,
+  ceph::bufferlist bl)
+{
+  assert((bl.length() % superblock.block_size) == 0);
+  logger().debug(
+    "segment_write to segment {} at offset {}, physical offset {}, len {}",
+    addr.segment,
+    addr.offset,
+    get_offset(addr),
+    bl.length());
+
+  bufferptr bptr(ceph::buffer::create_page_aligned(bl.length()));
+  auto iter = bl.cbegin();
+  iter.copy(bl.length(), bptr.c_str());
+  return seastar::do_with(
+    std::move(bptr),
+    [this, addr](auto &bp) {
+      return do_write(device, get_offset(addr), bp);
+    });
+}
+
+bool ZNSSegmentManager::support(const std::string &path)
+{
+  return zbd_device_is_zoned(path.c_str()) == 1;
+}
+
+ZNSSegmentManager::~ZNSSegmentManager()
+{
+  if (zbd_fd >= 0) {
+    zbd_close(zbd_fd);
+  }
+}
+
+ZNSSegmentManager::mount_ret ZNSSegmentManager::mount()
+{
+  zbd_fd = zbd_open(device_path.c_str(), O_RDWR, nullptr);
+  if (zbd_fd < 0) {
+    logger().error(
+      "ZNSSegmentManager::mount: failed to open {} as a zoned device",
+      device_path);
+    return crimson::ct_error::input_output_error::make();
+  }
+  return seastar::do_with(
+    zone_layout_t{},
+    [this](auto &layout) -> mount_ertr::future<> {
+      if (report_zones(zbd_fd, layout) < 0) {
+	return crimson::ct_error::input_output_error::make();
+      }
+      return open_device(
+	device_path, seastar::open_flags::rw
+      ).safe_then([this, &layout](auto p) {
+	device = std::move(p.first);
+	return read_superblock(device, layout.first_zone_offset, p.second);
+      }).safe_then([this, &layout](auto sb) -> mount_ertr::future<> {
+	if (sb.zone_size != layout.zone_size ||
+	    sb.first_segment_offset != layout.first_zone_offset + sb.zone_size ||
+	    sb.segments + 1 > layout.zones.size()) {
+	  logger().error(
+	    "ZNSSegmentManager::mount: superblock does not match the zones of {}",
+	    device_path);
+	  return crimson::ct_error::input_output_error::make();
+	}
+	superblock = sb;
+	segment_state.assign(superblock.segments, segment_state_t::EMPTY);
+	for (segment_id_t i = 0; i < superblock.segments; ++i) {
+	  auto &zone = layout.zones[i + 1];
+	  if (zbd_zone_empty(&zone)) {
+	    continue;
+	  }
+	  // what was open is closed, as BlockSegmentManager does
+	  if (!zbd_zone_full(&zone) &&
+	      zbd_finish_zones(zbd_fd, zbd_zone_start(&zone),
+			       zbd_zone_len(&zone)) != 0) {
+	    logger().error(
+	      "ZNSSegmentManager::mount: failed to finish zone of segment {}",
+	      i);
+	    return crimson::ct_error::input_output_error::make();
+	  }
+	  segment_state[i] = segment_state_t::CLOSED;
+	}
+	return mount_ertr::now();
+      });
+    });
+}
+
+ZNSSegmentManager::mkfs_ret ZNSSegmentManager::mkfs(seastore_meta_t meta)
+{
+  logger().debug("ZNSSegmentManager::mkfs path {}", device_path);
+  int fd = zbd_open(device_path.c_str(), O_RDWR, nullptr);
+  if (fd < 0) {
+    logger().error(
+      "ZNSSegmentManager::mkfs: failed to open {} as a zoned device",
+      device_path);
+    return crimson::ct_error::input_output_error::make();
+  }
+  return seastar::do_with(
+    seastar::file{},
+    zone_layout_t{},
+    zns_sm_superblock_t{},
+    [this, fd, meta](auto &device, auto &layout, auto &sb)
+    -> mkfs_ertr::future<> {
+      if (report_zones(fd, layout) < 0 ||
+	  zbd_reset_zones(fd, layout.first_zone_offset,
+			  layout.zones.size() * layout.zone_size) != 0) {
+	logger().error("ZNSSegmentManager::mkfs: failed to reset the zones");
+	return crimson::ct_error::input_output_error::make();
+      }
+      return open_device(
+	device_path, seastar::open_flags::rw
+      ).safe_then([&, meta](auto p) {
+	device = p.first;
+	auto block_size = p.second.block_size;
+	sb.zone_size = layout.zone_size;
+	sb.segment_size = p2align<uint64_t>(layout.zone_capacity, block_size);
+	sb.block_size = block_size;
+	sb.segments = layout.zones.size() - 1;
+	sb.size = sb.segments * sb.segment_size;
+	sb.first_segment_offset = layout.first_zone_offset + layout.zone_size;
+	sb.meta = meta;
+	return write_superblock(device, layout.first_zone_offset, sb);
+      }).safe_then([&, fd]() -> mkfs_ertr::future<> {
+	if (zbd_finish_zones(fd, layout.first_zone_offset,
+			     layout.zone_size) != 0) {
+	  return crimson::ct_error::input_output_error::make();
+	}
+	logger().debug("ZNSSegmentManager::mkfs: superblock written");
+	return mkfs_ertr::now();
+      }).finally([&] {
+	return device.close();
+      });
+    }).finally([fd] {
+      zbd_close(fd);
+    }).safe_then([] {
+      logger().debug("ZNSSegmentManager::mkfs: complete");
+      return mkfs_ertr::now();
+    });
+}
+
+ZNSSegmentManager::close_ertr::future<> ZNSSegmentManager::close()
+{
+  if (zbd_fd >= 0) {
+    zbd_close(zbd_fd);
+    zbd_fd = -1;
+  }
+  return device.close();
+}
+
+SegmentManager::open_ertr::future<SegmentRef> ZNSSegmentManager::open(
+  segment_id_t id)
+{
+  if (id >= get_num_segments()) {
+    logger().error("ZNSSegmentManager::open: invalid segment {}", id);
+    return crimson::ct_error::invarg::make();
+  }
+
+  if (segment_state[id] != segment_state_t::EMPTY) {
+    logger().error(
+      "ZNSSegmentManager::open: invalid segment {} state {}",
+      id,
+      segment_state[id]);
+    return crimson::ct_error::invarg::make();
+  }
+
+  // the zone is opened implicitly by its first write
+  segment_state[id] = segment_state_t::OPEN;
+  return open_ertr::future<SegmentRef>(
+    open_ertr::ready_future_marker{},
+    SegmentRef(new ZNSSegment(*this, id)));
+}
+
+SegmentManager::release_ertr::future<> ZNSSegmentManager::release(
+  segment_id_t id)
+{
+  logger().debug("ZNSSegmentManager::release: {}", id);
+
+  if (id >= get_num_segments()) {
+    logger().error(
+      "ZNSSegmentManager::release: invalid segment {}",
+      id);
+    return crimson::ct_error::invarg::make();
+  }
+
+  if (segment_state[id] != segment_state_t::CLOSED) {
+    logger().error(
+      "ZNSSegmentManager::release: invalid segment {} state {}",
+      id,
+      segment_state[id]);
+    return crimson::ct_error::invarg::make();
+  }
+
+  paddr_t addr{id, 0};
+  if (zbd_reset_zones(zbd_fd, get_offset(addr), superblock.zone_size) != 0) {
+    logger().error(
+      "ZNSSegmentManager::release: failed to reset zone of segment {}",
+      id);
+    return crimson::ct_error::input_output_error::make();
+  }
+  segment_state[id] = segment_state_t::EMPTY;
+  return release_ertr::now();
+}
+
+SegmentManager::read_ertr::future<> ZNSSegmentManager::read(
+  paddr_t addr,
+  size_t len,
+  ceph::bufferptr &out)
+{
+  if (addr.segment >= get_num_segments()) {
+    logger().error(
+      "ZNSSegmentManager::read: invalid segment {}",
+      addr);
+    return crimson::ct_error::invarg::make();
+  }
+
+  if (addr.offset + len > superblock.segment_size) {
+    logger().error(
+      "ZNSSegmentManager::read: invalid offset {}~{}!",
+      addr,
+      len);
+    return crimson::ct_error::invarg::make();
+  }
+
+  if (segment_state[addr.segment] == segment_state_t::EMPTY) {
+    logger().error(
+      "ZNSSegmentManager::read: read on invalid segment {} state {}",
+      addr.segment,
+      segment_state[addr.segment]);
+    return crimson::ct_error::enoent::make();
+  }
+
+  return do_read(
+    device,
+    get_offset(addr),
+    out);
+}
+
+}
@@ -0,0 +1,144 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+
+#pragma once
+
+#include <boost/intrusive_ptr.hpp>
+#include <boost/smart_ptr/intrusive_ref_counter.hpp>
+
+#include <seastar/core/file.hh>
+#include <seastar/core/future.hh>
+#include <seastar/core/reactor.hh>
+#include <seastar/core/semaphore.hh>
+
+#include "crimson/os/seastore/segment_manager.h"
+
+namespace crimson::os::seastore::segment_manager::zns {
+
+struct zns_sm_superblock_t {
+  size_t size = 0;
+  size_t segment_size = 0;
+  size_t zone_size = 0;
+  size_t block_size = 0;
+
+  size_t segments = 0;
+  uint64_t first_segment_offset = 0;
+
+  seastore_meta_t meta;
+
+  DENC(zns_sm_superblock_t, v, p) {
+    DENC_START(1, 1, p);
+    denc(v.size, p);
+    denc(v.segment_size, p);
+    denc(v.zone_size, p);
+    denc(v.block_size, p);
+    denc(v.segments, p);
+    denc(v.first_segment_offset, p);
+    denc(v.meta, p);
+    DENC_FINISH(p);
+  }
+};
+
+class ZNSSegmentManager;
+class ZNSSegment final : public Segment {
+  friend class ZNSSegmentManager;
+  ZNSSegmentManager &manager;
+  const segment_id_t id;
+  segment_off_t write_pointer = 0;
+  /// the zone takes its writes at its write pointer only, so they are
+  /// issued one at a time, in the order they are submitted
+  seastar::semaphore write_lock{1};
+public:
+  ZNSSegment(ZNSSegmentManager &manager, segment_id_t id);
+
+  segment_id_t get_segment_id() const final { return id; }
+  segment_off_t get_write_capacity() const final;
+  segment_off_t get_write_ptr() const final { return write_pointer; }
+  close_ertr::future<> close() final;
+  write_ertr::future<> write(segment_off_t offset, ceph::bufferlist bl) final;
+
+  ~ZNSSegment() {}
+};
+
+/**
+ * ZNSSegmentManager
+ *
+ * Implements SegmentManager on a zoned block device, one sequential
+ * write zone per segment.  The superblock takes the first sequential
+ * zone, conventional zones are left unused.  Unlike
+ * BlockSegmentManager, no state tracker is kept on the device: the
+ * condition of each zone tells whether its segment is empty, closing a
+ * segment finishes its zone and releasing it resets the zone, so that
+ * the device never has to collect the garbage itself.
+ */
+class ZNSSegmentManager final : public SegmentManager {
+public:
+  static bool support(const std::string &path);
+
+  mount_ret mount() final;
+
+  mkfs_ret mkfs(seastore_meta_t) final;
+
+  using close_ertr = crimson::errorator<
+    crimson::ct_error::input_output_error
+    >;
+  close_ertr::future<> close();
+
+  ZNSSegmentManager(const std::string &path) : device_path(path) {}
+  ~ZNSSegmentManager();
+
+  open_ertr::future<SegmentRef> open(segment_id_t id) final;
+
+  release_ertr::future<> release(segment_id_t id) final;
+
+  read_ertr::future<> read(
+    paddr_t addr,
+    size_t len,
+    ceph::bufferptr &out) final;
+
+  size_t get_size() const final {
+    return superblock.size;
+  }
+  segment_off_t get_block_size() const {
+    return superblock.block_size;
+  }
+  segment_off_t get_segment_size() const {
+    return superblock.segment_size;
+  }
+  segment_id_t get_num_segments() const final {
+    return superblock.segments;
+  }
+
+private:
+  friend class ZNSSegment;
+  using segment_state_t = Segment::segment_state_t;
+
+  std::string device_path;
+  zns_sm_superblock_t superblock;
+  seastar::file device;
+  /// libzbd handle of the device, for the zone management commands
+  int zbd_fd = -1;
+
+  std::vector<segment_state_t> segment_state;
+
+  uint64_t get_offset(paddr_t addr) const {
+    return superblock.first_segment_offset +
+      (addr.segment * superblock.zone_size) +
+      addr.offset;
+  }
+
+  const seastore_meta_t &get_meta() const {
+    return superblock.meta;
+  }
+
+  Segment::write_ertr::future<> segment_write(
+    paddr_t addr,
+    ceph::bufferlist bl);
+  Segment::close_ertr::future<> segment_close(segment_id_t id);
+};
+
+}
+
+WRITE_CLASS_DENC_BOUNDED(
+  crimson::os::seastore::segment_manager::zns::zns_sm_superblock_t
+)
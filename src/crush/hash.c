@@ -1,7 +1,9 @@
 #ifdef __KERNEL__
 # include <linux/crush/hash.h>
+# include <linux/string.h>
 #else
 # include "hash.h"
+# include <string.h>
 #endif
 
 /*
@@ -58,6 +60,50 @@ static __u32 crush_hash32_rjenkins1_3(__u32 a, __u32 b, __u32 c)
 	return hash;
 }
 
+/*
+ * hash (a, b[i], c) for n values of b at once.  use the compiler's
+ * generic vector types, which map to SSE/AVX or NEON registers, so that
+ * the lanes are mixed in parallel.
+ */
+#if defined(__GNUC__) && !defined(__KERNEL__)
+#define CRUSH_HASH_LANES 8
+typedef __u32 crush_hash_vec_t __attribute__((vector_size(4 * CRUSH_HASH_LANES)));
+
+static void crush_hash32_rjenkins1_3_vec(__u32 a, const __u32 *b, __u32 c,
+					 __u32 *out, unsigned int n)
+{
+	unsigned int i = 0;
+
+	for (; i + CRUSH_HASH_LANES <= n; i += CRUSH_HASH_LANES) {
+		crush_hash_vec_t va, vb, vc, hash, x, y;
+
+		va = (crush_hash_vec_t){0} + a;
+		memcpy(&vb, b + i, sizeof(vb));
+		vc = (crush_hash_vec_t){0} + c;
+		hash = crush_hash_seed ^ va ^ vb ^ vc;
+		x = (crush_hash_vec_t){0} + 231232;
+		y = (crush_hash_vec_t){0} + 1232;
+		crush_hashmix(va, vb, hash);
+		crush_hashmix(vc, x, hash);
+		crush_hashmix(y, va, hash);
+		crush_hashmix(vb, x, hash);
+		crush_hashmix(y, vc, hash);
+		memcpy(out + i, &hash, sizeof(hash));
+	}
+	for (; i < n; i++)
+		out[i] = crush_hash32_rjenkins1_3(a, b[i], c);
+}
+#else
+static void crush_hash32_rjenkins1_3_vec(__u32 a, const __u32 *b, __u32 c,
+					 __u32 *out, unsigned int n)
+{
+	unsigned int i;
+
+	for (i = 0; i < n; i++)
+		out[i] = crush_hash32_rjenkins1_3(a, b[i], c);
+}
+#endif
+
 static __u32 crush_hash32_rjenkins1_4(__u32 a, __u32 b, __u32 c, __u32 d)
 {
 	__u32 hash = crush_hash_seed ^ a ^ b ^ c ^ d;
@@ -120,6 +166,18 @@ __u32 crush_hash32_3(int type, __u32 a, __u32 b, __u32 c)
 	}
 }
 
+void crush_hash32_3_vec(int type, __u32 a, const __u32 *b, __u32 c,
+			__u32 *out, unsigned int n)
+{
+	switch (type) {
+	case CRUSH_HASH_RJENKINS1:
+		crush_hash32_rjenkins1_3_vec(a, b, c, out, n);
+		break;
+	default:
+		memset(out, 0, sizeof(*out) * n);
+	}
+}
+
 __u32 crush_hash32_4(int type, __u32 a, __u32 b, __u32 c, __u32 d)
 {
 	switch (type) {
@@ -17,6 +17,7 @@
 
 #include <algorithm>
 #include <cerrno>
+#include <cstring>
 
 #include "ErasureCode.h"
 
@@ -203,6 +204,13 @@ int ErasureCode::encode(const set<int> &want_to_encode,
   return 0;
 }
 
+int ErasureCode::encode_delta(int data_chunk,
+                              const bufferlist &delta,
+                              map<int, bufferlist> *coding)
+{
+  return -EOPNOTSUPP;
+}
+
 int ErasureCode::_decode(const set<int> &want_to_read,
 			 const map<int, bufferlist> &chunks,
 			 map<int, bufferlist> *decoded)
@@ -248,6 +256,141 @@ int ErasureCode::decode(const set<int> &want_to_read,
   return _decode(want_to_read, chunks, decoded);
 }
 
+int ErasureCode::encode_batch(const set<int> &want_to_encode,
+                              const vector<bufferlist> &in,
+                              vector<map<int, bufferlist>> *encoded)
+{
+  encoded->clear();
+  encoded->resize(in.size());
+  for (size_t i = 0; i < in.size(); i++) {
+    int r = encode(want_to_encode, in[i], &(*encoded)[i]);
+    if (r)
+      return r;
+  }
+  return 0;
+}
+
+int ErasureCode::decode_batch(const set<int> &want_to_read,
+                              const vector<map<int, bufferlist>> &chunks,
+                              vector<map<int, bufferlist>> *decoded,
+                              int chunk_size)
+{
+  decoded->clear();
+  decoded->resize(chunks.size());
+  for (size_t i = 0; i < chunks.size(); i++) {
+    int r = decode(want_to_read, chunks[i], &(*decoded)[i], chunk_size);
+    if (r)
+      return r;
+  }
+  return 0;
+}
+
+int ErasureCode::encode_batch_grouped(const set<int> &want_to_encode,
+                                      const vector<bufferlist> &in,
+                                      vector<map<int, bufferlist>> *encoded,
+                                      unsigned group_size)
+{
+  unsigned int k = get_data_chunk_count();
+  unsigned int n = get_chunk_count();
+  encoded->clear();
+  encoded->resize(in.size());
+  for (size_t s = 0, e; s < in.size(); s = e) {
+    unsigned length = in[s].length();
+    unsigned blocksize = get_chunk_size(length);
+    for (e = s + 1;
+         e < in.size() && in[e].length() == length &&
+           (e - s + 1) * blocksize * n <= group_size;
+         e++) ;
+    if (e - s == 1) {
+      int r = encode(want_to_encode, in[s], &(*encoded)[s]);
+      if (r)
+        return r;
+      continue;
+    }
+    // chunk i of the group is chunk i of each stripe, back to back,
+    // zero padded as encode_prepare does
+    unsigned group_length = (e - s) * blocksize;
+    map<int, bufferlist> group;
+    for (unsigned int i = 0; i < n; i++) {
+      bufferptr buf(buffer::create_aligned(group_length, SIMD_ALIGN));
+      for (size_t j = s; i < k && j < e; j++) {
+        unsigned off = i * blocksize;
+        unsigned len = off < length ? std::min(blocksize, length - off) : 0;
+        char *dst = buf.c_str() + (j - s) * blocksize;
+        if (len)
+          in[j].begin(off).copy(len, dst);
+        memset(dst + len, 0, blocksize - len);
+      }
+      group[chunk_index(i)].push_back(std::move(buf));
+    }
+    int r = encode_chunks(want_to_encode, &group);
+    if (r)
+      return r;
+    for (size_t j = s; j < e; j++) {
+      for (unsigned int i = 0; i < n; i++) {
+        if (want_to_encode.count(i))
+          (*encoded)[j][i].substr_of(group[i], (j - s) * blocksize, blocksize);
+      }
+    }
+  }
+  return 0;
+}
+
+int ErasureCode::decode_batch_grouped(const set<int> &want_to_read,
+                                      const vector<map<int, bufferlist>> &chunks,
+                                      vector<map<int, bufferlist>> *decoded,
+                                      int chunk_size,
+                                      unsigned group_size)
+{
+  auto same_chunks = [](const map<int, bufferlist> &a,
+                        const map<int, bufferlist> &b) {
+    return a.size() == b.size() &&
+      std::equal(a.begin(), a.end(), b.begin(),
+                 [](const auto &x, const auto &y) {
+                   return x.first == y.first &&
+                     x.second.length() == y.second.length();
+                 });
+  };
+  unsigned int n = get_chunk_count();
+  decoded->clear();
+  decoded->resize(chunks.size());
+  for (size_t s = 0, e; s < chunks.size(); s = e) {
+    unsigned blocksize =
+      chunks[s].empty() ? 0 : chunks[s].begin()->second.length();
+    for (e = s + 1;
+         e < chunks.size() && blocksize &&
+           same_chunks(chunks[s], chunks[e]) &&
+           (e - s + 1) * blocksize * n <= group_size;
+         e++) ;
+    if (e - s == 1) {
+      int r = decode(want_to_read, chunks[s], &(*decoded)[s], chunk_size);
+      if (r)
+        return r;
+      continue;
+    }
+    map<int, bufferlist> group;
+    for (auto &c : chunks[s]) {
+      bufferptr buf(buffer::create_aligned((e - s) * blocksize, SIMD_ALIGN));
+      for (size_t j = s; j < e; j++) {
+        chunks[j].at(c.first).begin().copy(
+          blocksize, buf.c_str() + (j - s) * blocksize);
+      }
+      group[c.first].push_back(std::move(buf));
+    }
+    map<int, bufferlist> out;
+    int r = decode(want_to_read, group, &out, chunk_size * (e - s));
+    if (r)
+      return r;
+    for (size_t j = s; j < e; j++) {
+      for (auto &o : out) {
+        (*decoded)[j][o.first].substr_of(o.second, (j - s) * blocksize,
+                                         blocksize);
+      }
+    }
+  }
+  return 0;
+}
+
 int ErasureCode::parse(const ErasureCodeProfile &profile,
 		       ostream *ss)
 {
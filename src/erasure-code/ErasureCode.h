@@ -79,6 +79,10 @@ namespace ceph {
                        const bufferlist &in,
                        std::map<int, bufferlist> *encoded) override;
 
+    int encode_delta(int data_chunk,
+                     const bufferlist &delta,
+                     std::map<int, bufferlist> *coding) override;
+
     int decode(const std::set<int> &want_to_read,
                 const std::map<int, bufferlist> &chunks,
                 std::map<int, bufferlist> *decoded, int chunk_size) override;
@@ -87,6 +91,15 @@ namespace ceph {
 			const std::map<int, bufferlist> &chunks,
 			std::map<int, bufferlist> *decoded);
 
+    int encode_batch(const std::set<int> &want_to_encode,
+                     const std::vector<bufferlist> &in,
+                     std::vector<std::map<int, bufferlist>> *encoded) override;
+
+    int decode_batch(const std::set<int> &want_to_read,
+                     const std::vector<std::map<int, bufferlist>> &chunks,
+                     std::vector<std::map<int, bufferlist>> *decoded,
+                     int chunk_size) override;
+
     const std::vector<int> &get_chunk_mapping() const override;
 
     int to_mapping(const ErasureCodeProfile &profile,
@@ -117,6 +130,22 @@ namespace ceph {
     int parse(const ErasureCodeProfile &profile,
 	      std::ostream *ss);
 
+    /// encode_batch for codes which encode every byte position of the
+    /// chunks independently: stripes of the same size are gathered, up
+    /// to group_size bytes of chunks, and encoded with one encode_chunks
+    int encode_batch_grouped(const std::set<int> &want_to_encode,
+                             const std::vector<bufferlist> &in,
+                             std::vector<std::map<int, bufferlist>> *encoded,
+                             unsigned group_size);
+
+    /// decode_batch counterpart of encode_batch_grouped, for consecutive
+    /// stripes providing the same chunks
+    int decode_batch_grouped(const std::set<int> &want_to_read,
+                             const std::vector<std::map<int, bufferlist>> &chunks,
+                             std::vector<std::map<int, bufferlist>> *decoded,
+                             int chunk_size,
+                             unsigned group_size);
+
   private:
     int chunk_index(unsigned int i) const;
   };
@@ -370,6 +370,35 @@ namespace ceph {
     virtual int encode_chunks(const std::set<int> &want_to_encode,
                               std::map<int, bufferlist> *encoded) = 0;
 
+    /**
+     * Update the coding chunks of a stripe after a change to the
+     * data chunk **data_chunk**, without reading the other data
+     * chunks. For a linear code, each coding chunk changes by its
+     * coefficient for **data_chunk** times the xor of the old and
+     * new content of that chunk.
+     *
+     * **delta** is the xor of the old and the new content of the
+     * data chunk. The **coding** map holds the current content of
+     * every coding chunk and is updated in place; all buffers must
+     * have the same length as **delta**, a multiple of the
+     * alignment the chunks were encoded with.
+     *
+     * Chunk indexes are those of **encode_chunks**: data chunks are
+     * 0 .. k-1 and coding chunks k .. k+m-1, before any remapping
+     * by **get_chunk_mapping**.
+     *
+     * Returns -EOPNOTSUPP if the code does not support delta
+     * updates, in which case the stripe must be encoded again.
+     *
+     * @param [in] data_chunk index of the modified data chunk
+     * @param [in] delta xor of the old and new data chunk content
+     * @param [in,out] coding map coding chunk indexes to chunk data
+     * @return **0** on success or a negative errno on error.
+     */
+    virtual int encode_delta(int data_chunk,
+                             const bufferlist &delta,
+                             std::map<int, bufferlist> *coding) = 0;
+
     /**
      * Decode the **chunks** and store at least **want_to_read**
      * chunks in **decoded**.
@@ -412,6 +441,47 @@ namespace ceph {
                               const std::map<int, bufferlist> &chunks,
                               std::map<int, bufferlist> *decoded) = 0;
 
+    /**
+     * Encode each of the **in** stripes as **encode** would and store
+     * the chunks of the i-th stripe in the i-th element of
+     * **encoded**. Codes that operate on every byte position of the
+     * chunks independently may group the stripes and encode each
+     * group with a single call into the underlying library, which
+     * amortizes the per call setup over many small stripes.
+     *
+     * The chunks of a stripe may point into buffers shared with other
+     * stripes of the same batch.
+     *
+     * Returns 0 on success.
+     *
+     * @param [in] want_to_encode chunk indexes to be encoded
+     * @param [in] in stripes to be encoded
+     * @param [out] encoded for each stripe, map chunk indexes to chunk data
+     * @return **0** on success or a negative errno on error.
+     */
+    virtual int encode_batch(const std::set<int> &want_to_encode,
+                             const std::vector<bufferlist> &in,
+                             std::vector<std::map<int, bufferlist>> *encoded) = 0;
+
+    /**
+     * Decode each of the **chunks** stripes as **decode** would and
+     * store the chunks of the i-th stripe in the i-th element of
+     * **decoded**. Consecutive stripes missing the same chunks may
+     * be decoded together, see **encode_batch**.
+     *
+     * Returns 0 on success.
+     *
+     * @param [in] want_to_read chunk indexes to be decoded
+     * @param [in] chunks for each stripe, map chunk indexes to chunk data
+     * @param [out] decoded for each stripe, map chunk indexes to chunk data
+     * @param [in] chunk_size chunk size
+     * @return **0** on success or a negative errno on error.
+     */
+    virtual int decode_batch(const std::set<int> &want_to_read,
+                             const std::vector<std::map<int, bufferlist>> &chunks,
+                             std::vector<std::map<int, bufferlist>> *decoded,
+                             int chunk_size) = 0;
+
     /**
      * Return the ordered list of chunks or an empty vector
      * if no remapping is necessary.
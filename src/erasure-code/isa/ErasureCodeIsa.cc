@@ -90,6 +90,47 @@ int ErasureCodeIsa::encode_chunks(const set<int> &want_to_encode,
   return 0;
 }
 
+int ErasureCodeIsa::encode_delta(int data_chunk,
+                                 const bufferlist &delta,
+                                 map<int, bufferlist> *coding)
+{
+  if (data_chunk < 0 || data_chunk >= k)
+    return -EINVAL;
+  unsigned blocksize = delta.length();
+  bufferlist d(delta);
+  d.rebuild_aligned(EC_ISA_ADDRESS_ALIGNMENT);
+  char *chunks[m];
+  for (int i = 0; i < m; i++) {
+    auto c = coding->find(k + i);
+    if (c == coding->end() || c->second.length() != blocksize)
+      return -EINVAL;
+    c->second.rebuild_aligned(EC_ISA_ADDRESS_ALIGNMENT);
+    chunks[i] = c->second.c_str();
+  }
+  isa_encode_delta(data_chunk, d.c_str(), chunks, blocksize);
+  return 0;
+}
+
+int ErasureCodeIsa::encode_batch(const set<int> &want_to_encode,
+                                 const vector<bufferlist> &in,
+                                 vector<map<int, bufferlist>> *encoded)
+{
+  // ec_encode_data works on each byte position independently, so the
+  // chunks of many stripes laid back to back are encoded in one call
+  return encode_batch_grouped(want_to_encode, in, encoded, BATCH_GROUP_SIZE);
+}
+
+int ErasureCodeIsa::decode_batch(const set<int> &want_to_read,
+                                 const vector<map<int, bufferlist>> &chunks,
+                                 vector<map<int, bufferlist>> *decoded,
+                                 int chunk_size)
+{
+  // one decoding table lookup and ec_encode_data call per group of
+  // stripes missing the same chunks
+  return decode_batch_grouped(want_to_read, chunks, decoded, chunk_size,
+                              BATCH_GROUP_SIZE);
+}
+
 int ErasureCodeIsa::decode_chunks(const set<int> &want_to_read,
                                   const map<int, bufferlist> &chunks,
                                   map<int, bufferlist> *decoded)
@@ -132,6 +173,24 @@ ErasureCodeIsaDefault::isa_encode(char **data,
 
 // -----------------------------------------------------------------------------
 
+void
+ErasureCodeIsaDefault::isa_encode_delta(int data_chunk,
+                                        char *delta,
+                                        char **coding,
+                                        int blocksize)
+{
+  if (m == 1)
+    // single parity stripe
+    byte_xor((unsigned char*) delta, (unsigned char*) coding[0],
+             (unsigned char*) delta + blocksize);
+  else
+    // xor the contribution of data_chunk into the coding chunks
+    ec_encode_data_update(blocksize, k, m, data_chunk, encode_tbls,
+                          (unsigned char*) delta, (unsigned char**) coding);
+}
+
+// -----------------------------------------------------------------------------
+
 bool
 ErasureCodeIsaDefault::erasure_contains(int *erasures, int i)
 {
@@ -76,6 +76,23 @@ public:
   int encode_chunks(const std::set<int> &want_to_encode,
                     std::map<int, ceph::buffer::list> *encoded) override;
 
+  int encode_delta(int data_chunk,
+                   const ceph::buffer::list &delta,
+                   std::map<int, ceph::buffer::list> *coding) override;
+
+  // stripes are encoded/decoded in groups of at most this many bytes of
+  // chunks, small enough for a group to stay in the L2 cache
+  static constexpr unsigned BATCH_GROUP_SIZE = 256 * 1024;
+
+  int encode_batch(const std::set<int> &want_to_encode,
+                   const std::vector<ceph::buffer::list> &in,
+                   std::vector<std::map<int, ceph::buffer::list>> *encoded) override;
+
+  int decode_batch(const std::set<int> &want_to_read,
+                   const std::vector<std::map<int, ceph::buffer::list>> &chunks,
+                   std::vector<std::map<int, ceph::buffer::list>> *decoded,
+                   int chunk_size) override;
+
   int decode_chunks(const std::set<int> &want_to_read,
                             const std::map<int, ceph::buffer::list> &chunks,
                             std::map<int, ceph::buffer::list> *decoded) override;
@@ -86,6 +103,11 @@ public:
                           char **coding,
                           int blocksize) = 0;
 
+  virtual void isa_encode_delta(int data_chunk,
+                                char *delta,
+                                char **coding,
+                                int blocksize) = 0;
+
 
   virtual int isa_decode(int *erasures,
                          char **data,
@@ -134,6 +156,11 @@ public:
                           char **coding,
                           int blocksize) override;
 
+  void isa_encode_delta(int data_chunk,
+                        char *delta,
+                        char **coding,
+                        int blocksize) override;
+
   virtual bool erasure_contains(int *erasures, int i);
 
   int isa_decode(int *erasures,
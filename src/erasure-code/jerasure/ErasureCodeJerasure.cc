@@ -37,8 +37,10 @@ extern "C" {
 using std::ostream;
 using std::map;
 using std::set;
+using std::vector;
 
 using ceph::bufferlist;
+using ceph::bufferptr;
 using ceph::ErasureCodeProfile;
 
 static ostream& _prefix(std::ostream* _dout)
@@ -112,6 +114,50 @@ int ErasureCodeJerasure::encode_chunks(const set<int> &want_to_encode,
   return 0;
 }
 
+int ErasureCodeJerasure::encode_delta(int data_chunk,
+				      const bufferlist &delta,
+				      map<int, bufferlist> *coding)
+{
+  if (data_chunk < 0 || data_chunk >= k)
+    return -EINVAL;
+  unsigned blocksize = delta.length();
+  bufferlist d(delta);
+  d.rebuild_aligned(SIMD_ALIGN);
+  char *chunks[m];
+  for (int i = 0; i < m; i++) {
+    auto c = coding->find(k + i);
+    if (c == coding->end() || c->second.length() != blocksize)
+      return -EINVAL;
+    c->second.rebuild_aligned(SIMD_ALIGN);
+    chunks[i] = c->second.c_str();
+  }
+  jerasure_encode_delta(data_chunk, d.c_str(), chunks, blocksize);
+  return 0;
+}
+
+void ErasureCodeJerasure::jerasure_encode_delta(int data_chunk,
+						char *delta,
+						char **coding,
+						int blocksize)
+{
+  // every technique is linear: encoding the delta with all the other
+  // data chunks zeroed yields the change of each coding chunk
+  bufferptr zero(ceph::buffer::create_aligned(blocksize, SIMD_ALIGN));
+  zero.zero();
+  vector<bufferptr> out;
+  char *data[k];
+  char *change[m];
+  for (int i = 0; i < k; i++)
+    data[i] = i == data_chunk ? delta : zero.c_str();
+  for (int i = 0; i < m; i++) {
+    out.push_back(ceph::buffer::create_aligned(blocksize, SIMD_ALIGN));
+    change[i] = out.back().c_str();
+  }
+  jerasure_encode(data, change, blocksize);
+  for (int i = 0; i < m; i++)
+    galois_region_xor(change[i], coding[i], blocksize);
+}
+
 int ErasureCodeJerasure::decode_chunks(const set<int> &want_to_read,
 				       const map<int, bufferlist> &chunks,
 				       map<int, bufferlist> *decoded)
@@ -162,6 +208,22 @@ void ErasureCodeJerasureReedSolomonVandermonde::jerasure_encode(char **data,
   jerasure_matrix_encode(k, m, w, matrix, data, coding, blocksize);
 }
 
+void ErasureCodeJerasureReedSolomonVandermonde::jerasure_encode_delta(int data_chunk,
+                                                                      char *delta,
+                                                                      char **coding,
+                                                                      int blocksize)
+{
+  // only the column of the generator for data_chunk is needed:
+  // coding[i] ^= matrix[i][data_chunk] * delta
+  bufferptr out(ceph::buffer::create_aligned(blocksize, SIMD_ALIGN));
+  char *change = out.c_str();
+  for (int i = 0; i < m; i++) {
+    jerasure_matrix_dotprod(1, w, &matrix[i * k + data_chunk], NULL, 1,
+                            &delta, &change, blocksize);
+    galois_region_xor(change, coding[i], blocksize);
+  }
+}
+
 int ErasureCodeJerasureReedSolomonVandermonde::jerasure_decode(int *erasures,
                                                                 char **data,
                                                                 char **coding,
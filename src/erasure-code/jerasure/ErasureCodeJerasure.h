@@ -59,6 +59,10 @@ public:
   int encode_chunks(const std::set<int> &want_to_encode,
 		    std::map<int, ceph::buffer::list> *encoded) override;
 
+  int encode_delta(int data_chunk,
+		   const ceph::buffer::list &delta,
+		   std::map<int, ceph::buffer::list> *coding) override;
+
   int decode_chunks(const std::set<int> &want_to_read,
 		    const std::map<int, ceph::buffer::list> &chunks,
 		    std::map<int, ceph::buffer::list> *decoded) override;
@@ -68,6 +72,10 @@ public:
   virtual void jerasure_encode(char **data,
                                char **coding,
                                int blocksize) = 0;
+  virtual void jerasure_encode_delta(int data_chunk,
+                                     char *delta,
+                                     char **coding,
+                                     int blocksize);
   virtual int jerasure_decode(int *erasures,
                                char **data,
                                char **coding,
@@ -98,6 +106,10 @@ public:
   void jerasure_encode(char **data,
                                char **coding,
                                int blocksize) override;
+  void jerasure_encode_delta(int data_chunk,
+                             char *delta,
+                             char **coding,
+                             int blocksize) override;
   int jerasure_decode(int *erasures,
                                char **data,
                                char **coding,
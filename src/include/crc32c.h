@@ -17,6 +17,19 @@ extern ceph_crc32c_func_t ceph_crc32c_func;
 
 extern ceph_crc32c_func_t ceph_choose_crc32(void);
 
+typedef void (*ceph_crc32c_multi_func_t)(uint32_t crc,
+					 unsigned char const * const *buffers,
+					 unsigned length, unsigned count,
+					 uint32_t *out);
+
+/*
+ * static global with the chosen implementation for many buffers at
+ * once.
+ */
+extern ceph_crc32c_multi_func_t ceph_crc32c_multi_func;
+
+extern ceph_crc32c_multi_func_t ceph_choose_crc32_multi(void);
+
 /**
  * calculate crc32c for data that is entirely 0 (ZERO)
  *
@@ -50,6 +63,27 @@ static inline uint32_t ceph_crc32c(uint32_t crc, unsigned char const *data, unsi
   return ceph_crc32c_func(crc, data, length);
 }
 
+/**
+ * calculate the crc32c of several buffers of the same length
+ *
+ * Works the same as calling ceph_crc32c on each buffer, but the
+ * implementation may interleave the buffers to compute several crcs
+ * at once.
+ *
+ * @param crc initial value of each crc
+ * @param buffers pointers to count buffers, none of them NULL
+ * @param length length of each buffer
+ * @param count number of buffers
+ * @param out the count crcs
+ */
+static inline void ceph_crc32c_multi(uint32_t crc,
+				     unsigned char const * const *buffers,
+				     unsigned length, unsigned count,
+				     uint32_t *out)
+{
+  ceph_crc32c_multi_func(crc, buffers, length, count, out);
+}
+
 #ifdef __cplusplus
 }
 #endif
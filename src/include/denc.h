@@ -923,11 +923,41 @@ struct denc_traits<
 };
 
 namespace _denc {
+  // element types which are laid out in memory just like they are on the
+  // wire, so that an array of them can be copied as a whole.
+  template<typename T, typename=void>
+  struct is_raw_copyable : std::false_type {};
+  template<typename T>
+  struct is_raw_copyable<
+    T,
+    std::enable_if_t<is_any_of<underlying_type_t<T>,
+			       ceph_le64, ceph_le32, ceph_le16, uint8_t>>>
+    : std::true_type {};
+  // the native integers, only where native is little endian; elsewhere
+  // they are swapped one by one
+  template<typename T>
+  struct is_raw_copyable<
+    T,
+    std::enable_if_t<is_any_of<T, int16_t, uint16_t, int32_t, uint32_t,
+			       int64_t, uint64_t>>>
+    : std::bool_constant<boost::endian::order::native ==
+			 boost::endian::order::little> {};
+  template<typename T>
+  inline constexpr bool is_raw_copyable_v =
+    is_raw_copyable<T>::value && std::is_trivially_copyable_v<T>;
+
+  template<template<class...> class C>
+  struct is_contiguous_container : std::false_type {};
+  template<>
+  struct is_contiguous_container<std::vector> : std::true_type {};
+
   template<template<class...> class C, typename Details, typename ...Ts>
   struct container_base {
   private:
     using container = C<Ts...>;
     using T = typename Details::T;
+    static constexpr bool raw_copyable =
+      is_contiguous_container<C>::value && is_raw_copyable_v<T>;
 
   public:
     using traits = denc_traits<T>;
@@ -1000,11 +1030,17 @@ namespace _denc {
     // nohead
     static void encode_nohead(const container& s, ceph::buffer::list::contiguous_appender& p,
 			      uint64_t f = 0) {
-      for (const T& e : s) {
-        if constexpr (traits::featured) {
-          denc(e, p, f);
-        } else {
-          denc(e, p);
+      if constexpr (raw_copyable) {
+        if (const size_t len = s.size() * sizeof(T); len > 0) {
+          memcpy(p.get_pos_add(len), s.data(), len);
+        }
+      } else {
+        for (const T& e : s) {
+          if constexpr (traits::featured) {
+            denc(e, p, f);
+          } else {
+            denc(e, p);
+          }
         }
       }
     }
@@ -1012,11 +1048,21 @@ namespace _denc {
 			      ceph::buffer::ptr::const_iterator& p,
 			      uint64_t f=0) {
       s.clear();
-      Details::reserve(s, num);
-      while (num--) {
-	T t;
-	denc(t, p, f);
-	Details::insert(s, std::move(t));
+      if constexpr (raw_copyable) {
+        if (num > 0) {
+          // get_pos_add() throws before we allocate for a bogus num
+          const size_t len = num * sizeof(T);
+          const char* src = p.get_pos_add(len);
+          s.resize(num);
+          memcpy(s.data(), src, len);
+        }
+      } else {
+        Details::reserve(s, num);
+        while (num--) {
+	  T t;
+	  denc(t, p, f);
+	  Details::insert(s, std::move(t));
+        }
       }
     }
     template<typename U=T>
@@ -1024,11 +1070,18 @@ namespace _denc {
     decode_nohead(size_t num, container& s,
 		  ceph::buffer::list::const_iterator& p) {
       s.clear();
-      Details::reserve(s, num);
-      while (num--) {
-	T t;
-	denc(t, p);
-	Details::insert(s, std::move(t));
+      if constexpr (raw_copyable) {
+        if (num > 0) {
+          s.resize(num);
+          p.copy(num * sizeof(T), reinterpret_cast<char*>(s.data()));
+        }
+      } else {
+        Details::reserve(s, num);
+        while (num--) {
+	  T t;
+	  denc(t, p);
+	  Details::insert(s, std::move(t));
+        }
       }
     }
   };
@@ -1093,6 +1146,7 @@ struct denc_traits<
   typename std::enable_if_t<denc_traits<T>::supported>> {
 private:
   using container = boost::container::small_vector<T, N, Ts...>;
+  static constexpr bool raw_copyable = _denc::is_raw_copyable_v<T>;
 public:
   using traits = denc_traits<T>;
 
@@ -1154,11 +1208,17 @@ public:
   // nohead
   static void encode_nohead(const container& s, ceph::buffer::list::contiguous_appender& p,
 			    uint64_t f = 0) {
-    for (const T& e : s) {
-      if constexpr (traits::featured) {
-        denc(e, p, f);
-      } else {
-        denc(e, p);
+    if constexpr (raw_copyable) {
+      if (const size_t len = s.size() * sizeof(T); len > 0) {
+	memcpy(p.get_pos_add(len), s.data(), len);
+      }
+    } else {
+      for (const T& e : s) {
+	if constexpr (traits::featured) {
+	  denc(e, p, f);
+	} else {
+	  denc(e, p);
+	}
       }
     }
   }
@@ -1166,11 +1226,20 @@ public:
 			    ceph::buffer::ptr::const_iterator& p,
 			    uint64_t f=0) {
     s.clear();
-    s.reserve(num);
-    while (num--) {
-      T t;
-      denc(t, p, f);
-      s.push_back(std::move(t));
+    if constexpr (raw_copyable) {
+      if (num > 0) {
+	const size_t len = num * sizeof(T);
+	const char* src = p.get_pos_add(len);
+	s.resize(num);
+	memcpy(s.data(), src, len);
+      }
+    } else {
+      s.reserve(num);
+      while (num--) {
+	T t;
+	denc(t, p, f);
+	s.push_back(std::move(t));
+      }
     }
   }
   template<typename U=T>
@@ -1178,11 +1247,18 @@ public:
   decode_nohead(size_t num, container& s,
 		ceph::buffer::list::const_iterator& p) {
     s.clear();
-    s.reserve(num);
-    while (num--) {
-      T t;
-      denc(t, p);
-      s.push_back(std::move(t));
+    if constexpr (raw_copyable) {
+      if (num > 0) {
+	s.resize(num);
+	p.copy(num * sizeof(T), reinterpret_cast<char*>(s.data()));
+      }
+    } else {
+      s.reserve(num);
+      while (num--) {
+	T t;
+	denc(t, p);
+	s.push_back(std::move(t));
+      }
     }
   }
 };
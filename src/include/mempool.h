@@ -135,6 +135,13 @@ You can also interrogate a specific pool programmatically with
 
 The runtime complexity is O(num_shards).
 
+Each thread keeps its counts of each pool to itself until they grow
+past max_cached_bytes or max_cached_items, either way, so that most
+allocations only touch its own memory; they are added to the shards
+then, and when the thread exits.  The totals of a pool are thus off by
+at most that much per thread, except for the calling thread, whose
+counts are always included.
+
 Note that you cannot easily query per-type, primarily because debug
 mode is optional and you should not rely on that information being
 available.
@@ -151,6 +158,7 @@ namespace mempool {
   f(bluestore_alloc)		      \
   f(bluestore_cache_data)	      \
   f(bluestore_cache_onode)	      \
+  f(bluestore_cache_encoded_onode)    \
   f(bluestore_cache_meta)	      \
   f(bluestore_cache_other)	      \
   f(bluestore_Buffer)		      \
@@ -219,6 +227,28 @@ struct shard_t {
 
 static_assert(sizeof(shard_t) == 128, "shard_t should be cacheline-sized");
 
+// how much a thread counts of a pool before adding it to a shard
+enum {
+  max_cached_bytes = 64 << 10,
+  max_cached_items = 512
+};
+
+struct thread_cache_t {
+  ssize_t items = 0;
+  ssize_t bytes = 0;
+};
+
+struct thread_caches_t {
+  /// set once the thread will add its counts to the shards when exiting
+  bool registered = false;
+  /// set once it has, as the thread is exiting
+  bool exiting = false;
+  thread_cache_t pool[num_pools];
+};
+
+// trivial, so that it needs no guard to be accessed
+inline thread_local thread_caches_t thread_caches;
+
 struct stats_t {
   ssize_t items = 0;
   ssize_t bytes = 0;
@@ -251,6 +281,8 @@ struct type_info_hash {
 
 class pool_t {
   shard_t shard[num_shards];
+  pool_index_t ix = num_pools;  ///< set by get_pool()
+  friend pool_t& get_pool(pool_index_t ix);
 
   mutable std::mutex lock;  // only used for types list
   std::unordered_map<const char *, type_t> type_map;
@@ -262,7 +294,18 @@ public:
   size_t allocated_bytes() const;
   size_t allocated_items() const;
 
-  void adjust_count(ssize_t items, ssize_t bytes);
+  void adjust_count(ssize_t items, ssize_t bytes) {
+    thread_cache_t& c = thread_caches.pool[ix];
+    c.items += items;
+    c.bytes += bytes;
+    if (c.bytes > max_cached_bytes || c.bytes < -max_cached_bytes ||
+	c.items > max_cached_items || c.items < -max_cached_items ||
+	!thread_caches.registered) {
+      flush_thread_cache();
+    }
+  }
+  /// add the counts of the calling thread to its shard
+  void flush_thread_cache();
 
   static size_t pick_a_shard_int() {
     // Dirt cheap, see:
@@ -339,9 +382,7 @@ public:
 
   T* allocate(size_t n, void *p = nullptr) {
     size_t total = sizeof(T) * n;
-    shard_t *shard = pool->pick_a_shard();
-    shard->bytes += total;
-    shard->items += n;
+    pool->adjust_count(n, total);
     if (type) {
       type->items += n;
     }
@@ -351,9 +392,7 @@ public:
 
   void deallocate(T* p, size_t n) {
     size_t total = sizeof(T) * n;
-    shard_t *shard = pool->pick_a_shard();
-    shard->bytes -= total;
-    shard->items -= n;
+    pool->adjust_count(-(ssize_t)n, -(ssize_t)total);
     if (type) {
       type->items -= n;
     }
@@ -362,9 +401,7 @@ public:
 
   T* allocate_aligned(size_t n, size_t align, void *p = nullptr) {
     size_t total = sizeof(T) * n;
-    shard_t *shard = pool->pick_a_shard();
-    shard->bytes += total;
-    shard->items += n;
+    pool->adjust_count(n, total);
     if (type) {
       type->items += n;
     }
@@ -378,9 +415,7 @@ public:
 
   void deallocate_aligned(T* p, size_t n) {
     size_t total = sizeof(T) * n;
-    shard_t *shard = pool->pick_a_shard();
-    shard->bytes -= total;
-    shard->items -= n;
+    pool->adjust_count(-(ssize_t)n, -(ssize_t)total);
     if (type) {
       type->items -= n;
     }
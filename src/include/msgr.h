@@ -51,6 +51,9 @@
 	(((x) & (CEPH_MSGR2_FEATUREMASK_##name)) == (CEPH_MSGR2_FEATUREMASK_##name))
 
 DEFINE_MSGR2_FEATURE( 0, 1, REVISION_1)   // msgr2.1
+DEFINE_MSGR2_FEATURE( 1, 1, LANES)        // several sessions per peer
+DEFINE_MSGR2_FEATURE( 2, 1, KTLS)         // secure mode over kernel TLS
+DEFINE_MSGR2_FEATURE( 3, 1, COMPRESSION)  // compressed message frames
 
 #define CEPH_MSGR2_SUPPORTED_FEATURES (CEPH_MSGR2_FEATURE_REVISION_1)
 
@@ -150,6 +153,9 @@ struct ceph_msg_connect_reply {
 } __attribute__ ((packed));
 
 #define CEPH_MSG_CONNECT_LOSSY  1  /* messages i send may be safely dropped */
+/* lane of the session, for peers with CEPH_MSGR2_FEATURE_LANES */
+#define CEPH_MSG_CONNECT_LANE_SHIFT  8
+#define CEPH_MSG_CONNECT_LANE_MASK   0xff
 
 
 /*
@@ -546,8 +546,25 @@ public:
 
   using executor_type = boost::asio::io_context::executor_type;
   executor_type get_executor() const;
+  /// Where the completions of the ops on @p o are dispatched, unless
+  /// their handlers have an executor of their own
+  executor_type get_executor(const Object& o) const;
   boost::asio::io_context& get_io_context();
 
+  /**
+   * Spread the completions over several io_contexts
+   *
+   * By default the completion of every op whose handler has no
+   * executor of its own is dispatched on the io_context this RADOS was
+   * built with. Once this is called, the completions of the ops on an
+   * object go to one of @p ioctxs, picked by the hash of the object's
+   * name. All the ops on one object therefore land on the same
+   * io_context. Set it before any op is submitted. An empty vector
+   * restores the default.
+   */
+  void set_completion_io_contexts(
+    std::vector<boost::asio::io_context*> ioctxs);
+
   template<typename CompletionToken>
   auto execute(const Object& o, const IOContext& ioc, ReadOp&& op,
 	       ceph::buffer::list* bl,
@@ -555,7 +572,7 @@ public:
 	       const blkin_trace_info* trace_info = nullptr) {
     boost::asio::async_completion<CompletionToken, Op::Signature> init(token);
     execute(o, ioc, std::move(op), bl,
-	    ReadOp::Completion::create(get_executor(),
+	    ReadOp::Completion::create(get_executor(o),
 				       std::move(init.completion_handler)),
 	    objver, trace_info);
     return init.result.get();
@@ -567,7 +584,7 @@ public:
 	       const blkin_trace_info* trace_info = nullptr) {
     boost::asio::async_completion<CompletionToken, Op::Signature> init(token);
     execute(o, ioc, std::move(op),
-	    Op::Completion::create(get_executor(),
+	    Op::Completion::create(get_executor(o),
 				   std::move(init.completion_handler)),
 	    objver, trace_info);
     return init.result.get();
@@ -583,7 +600,7 @@ public:
 	       uint64_t* objver = nullptr) {
     boost::asio::async_completion<CompletionToken, Op::Signature> init(token);
     execute(o, pool, std::move(op), bl,
-	    ReadOp::Completion::create(get_executor(),
+	    ReadOp::Completion::create(get_executor(o),
 				       std::move(init.completion_handler)),
 	    ns, key, objver);
     return init.result.get();
@@ -597,7 +614,7 @@ public:
 	       uint64_t* objver = nullptr) {
     boost::asio::async_completion<CompletionToken, Op::Signature> init(token);
     execute(o, pool, std::move(op),
-	    Op::Completion::create(get_executor(),
+	    Op::Completion::create(get_executor(o),
 				   std::move(init.completion_handler)),
 	    ns, key, objver);
     return init.result.get();
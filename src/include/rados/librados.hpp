@@ -1200,6 +1200,36 @@ inline namespace v14_2_0 {
     int aio_operate(const std::string& oid, AioCompletion *c,
         ObjectReadOperation *op, int flags,
         bufferlist *pbl, const blkin_trace_info *trace_info);
+    /**
+     * Schedule async write operations on several objects at once
+     *
+     * ops[i] is applied to oids[i] and completes cs[i], just as
+     * aio_operate(oids[i], cs[i], ops[i], flags) would, but the whole
+     * batch is handed to the OSDs in one go, which saves most of the
+     * cost of submitting many small operations one by one.  Operations
+     * on the same object are sent in the order of the batch.
+     *
+     * @param oids the objects to operate on
+     * @param cs what to do when each operation is complete and safe
+     * @param ops which operations to perform on each object
+     * @param flags the flags of all the operations
+     * @returns 0 on success, negative error code on failure
+     */
+    int aio_operate(const std::vector<std::string>& oids,
+		    const std::vector<AioCompletion*>& cs,
+		    const std::vector<ObjectWriteOperation*>& ops,
+		    int flags = 0);
+    /**
+     * Schedule async read operations on several objects at once
+     *
+     * The counterpart of the above for ObjectReadOperations, the data
+     * read from oids[i] going to pbls[i].
+     */
+    int aio_operate(const std::vector<std::string>& oids,
+		    const std::vector<AioCompletion*>& cs,
+		    const std::vector<ObjectReadOperation*>& ops,
+		    const std::vector<bufferlist*>& pbls,
+		    int flags = 0);
 
     // watch/notify
     int watch2(const std::string& o, uint64_t *handle,
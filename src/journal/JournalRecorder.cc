@@ -135,6 +135,11 @@ Future JournalRecorder::append(uint64_t tag_tid,
                                const bufferlist &payload_bl) {
   ldout(m_cct, 20) << "tag_tid=" << tag_tid << dendl;
 
+  // the entry crc covers the payload: have it cached in the payload
+  // buffers so that encoding the entry under the object lock only
+  // adjusts it for the entry header
+  payload_bl.crc32c(0);
+
   m_lock.lock();
 
   uint64_t entry_tid = m_journal_metadata->allocate_entry_tid(tag_tid);
@@ -214,6 +214,40 @@ public:
     virtual int seek_to_last() = 0;
     virtual int prev() = 0;
     virtual std::pair<std::string, std::string> raw_key() = 0;
+    /**
+     * Encode the (key, value) pairs from the current position on, the way
+     * a std::map<std::string, ceph::buffer::list> encodes its entries,
+     * without the leading count.
+     *
+     * @param end      stop at this key, if not empty
+     * @param skip     number of bytes cut off the front of the keys
+     * @param max_entries, max_bytes  encode no more pairs once reached
+     * @param out      pairs are appended here
+     * @param more     set if pairs are left because of the limits
+     * @returns the number of pairs encoded
+     */
+    virtual size_t encode_range(const std::string& end, size_t skip,
+				size_t max_entries, size_t max_bytes,
+				ceph::buffer::list* out, bool* more) {
+      size_t num = 0;
+      size_t start = out->length();
+      *more = false;
+      for (; valid(); next()) {
+	std::string k = key();
+	if (!end.empty() && k >= end) {
+	  break;
+	}
+	if (num >= max_entries || out->length() - start >= max_bytes) {
+	  *more = true;
+	  break;
+	}
+	ceph_assert(k.size() >= skip);
+	encode(std::string_view(k).substr(skip), *out);
+	encode(value(), *out);
+	++num;
+      }
+      return num;
+    }
     virtual ceph::buffer::ptr value_as_ptr() {
       ceph::buffer::list bl = value();
       if (bl.length() == 1) {
@@ -324,6 +358,8 @@ private:
 public:
   typedef uint32_t IteratorOpts;
   static const uint32_t ITERATOR_NOCACHE = 1;
+  /// the iterator is going to read many consecutive keys
+  static const uint32_t ITERATOR_READAHEAD = 2;
   virtual WholeSpaceIterator get_wholespace_iterator(IteratorOpts opts = 0) = 0;
   virtual Iterator get_iterator(const std::string &prefix, IteratorOpts opts = 0) {
     return std::make_shared<PrefixIteratorImpl>(
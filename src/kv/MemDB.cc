@@ -84,7 +84,7 @@ std::string MemDB::_get_data_fn()
 
 void MemDB::_save()
 {
-  std::lock_guard<std::mutex> l(m_lock);
+  std::shared_lock l(m_lock);
   dout(10) << __func__ << " Saving MemDB to file: "<< _get_data_fn().c_str() << dendl;
   int mode = 0644;
   int fd = TEMP_FAILURE_RETRY(::open(_get_data_fn().c_str(),
@@ -109,7 +109,7 @@ void MemDB::_save()
 
 int MemDB::_load()
 {
-  std::lock_guard<std::mutex> l(m_lock);
+  std::unique_lock l(m_lock);
   dout(10) << __func__ << " Reading MemDB from file: "<< _get_data_fn().c_str() << dendl;
   /*
    * Open file and read it in single shot.
@@ -232,6 +232,8 @@ int MemDB::submit_transaction(KeyValueDB::Transaction t)
   MDBTransactionImpl* mt =  static_cast<MDBTransactionImpl*>(t.get());
 
   dtrace << __func__ << " " << mt->get_ops().size() << dendl;
+  // applied as a whole, the readers see all of it or nothing
+  std::unique_lock l(m_lock);
   for(auto& op : mt->get_ops()) {
     if(op.first == MDBTransactionImpl::WRITE) {
       ms_op_t set_op = op.second;
@@ -245,6 +247,7 @@ int MemDB::submit_transaction(KeyValueDB::Transaction t)
       _rmkey(rm_op);
     }
   }
+  l.unlock();
 
   utime_t lat = ceph_clock_now() - start;
   logger->inc(l_memdb_txns);
@@ -316,42 +319,40 @@ void MemDB::MDBTransactionImpl::merge(
 
 int MemDB::_setkey(ms_op_t &op)
 {
-  std::lock_guard<std::mutex> l(m_lock);
   std::string key = make_key(op.first.first, op.first.second);
   bufferlist bl = op.second;
 
   m_total_bytes += bl.length();
 
-  bufferlist bl_old;
-  if (_get(op.first.first, op.first.second, &bl_old)) {
+  auto [iter, inserted] = m_map.try_emplace(std::move(key));
+  if (!inserted) {
     /*
-     * delete and free existing key.
+     * replace and free existing value.
      */
-    ceph_assert(m_total_bytes >= bl_old.length());
-    m_total_bytes -= bl_old.length();
-    m_map.erase(key);
+    ceph_assert(m_total_bytes >= iter->second.length());
+    m_total_bytes -= iter->second.length();
   }
-
-  m_map[key] = bufferptr((char *) bl.c_str(), bl.length());
+  iter->second = bufferptr((char *) bl.c_str(), bl.length());
   iterator_seq_no++;
   return 0;
 }
 
 int MemDB::_rmkey(ms_op_t &op)
 {
-  std::lock_guard<std::mutex> l(m_lock);
   std::string key = make_key(op.first.first, op.first.second);
 
-  bufferlist bl_old;
-  if (_get(op.first.first, op.first.second, &bl_old)) {
-    ceph_assert(m_total_bytes >= bl_old.length());
-    m_total_bytes -= bl_old.length();
-  }
   iterator_seq_no++;
+  mdb_iter_t iter = m_map.find(key);
+  if (iter == m_map.end()) {
+    return 0;
+  }
+  ceph_assert(m_total_bytes >= iter->second.length());
+  m_total_bytes -= iter->second.length();
   /*
    * Erase will call the destructor for bufferptr.
    */
-  return m_map.erase(key);
+  m_map.erase(iter);
+  return 1;
 }
 
 std::shared_ptr<KeyValueDB::MergeOperator> MemDB::_find_merge_op(const std::string &prefix)
@@ -369,7 +370,6 @@ std::shared_ptr<KeyValueDB::MergeOperator> MemDB::_find_merge_op(const std::stri
 
 int MemDB::_merge(ms_op_t &op)
 {
-  std::lock_guard<std::mutex> l(m_lock);
   std::string prefix = op.first.first;
   std::string key = make_key(op.first.first, op.first.second);
   bufferlist bl = op.second;
@@ -421,13 +421,13 @@ bool MemDB::_get(const string &prefix, const string &k, bufferlist *out)
     return false;
   }
 
-  out->push_back((m_map[key].clone()));
+  out->push_back(iter->second.clone());
   return true;
 }
 
 bool MemDB::_get_locked(const string &prefix, const string &k, bufferlist *out)
 {
-  std::lock_guard<std::mutex> l(m_lock);
+  std::shared_lock l(m_lock);
   return _get(prefix, k, out);
 }
 
@@ -456,10 +456,13 @@ int MemDB::get(const string &prefix, const std::set<string> &keys,
 {
   utime_t start = ceph_clock_now();
 
-  for (const auto& i : keys) {
-    bufferlist bl;
-    if (_get_locked(prefix, i, &bl))
-      out->insert(make_pair(i, bl));
+  {
+    std::shared_lock l(m_lock);
+    for (const auto& i : keys) {
+      bufferlist bl;
+      if (_get(prefix, i, &bl))
+        out->insert(make_pair(i, bl));
+    }
   }
 
   utime_t lat = ceph_clock_now() - start;
@@ -557,7 +560,7 @@ bufferlist MemDB::MDBWholeSpaceIteratorImpl::value()
 
 int MemDB::MDBWholeSpaceIteratorImpl::next()
 {
-  std::lock_guard<std::mutex> l(*m_map_lock_p);
+  std::shared_lock l(*m_map_lock_p);
   if (!iterator_validate()) {
     free_last();
     return -1;
@@ -574,7 +577,7 @@ int MemDB::MDBWholeSpaceIteratorImpl::next()
 
 int MemDB::MDBWholeSpaceIteratorImpl:: prev()
 {
-  std::lock_guard<std::mutex> l(*m_map_lock_p);
+  std::shared_lock l(*m_map_lock_p);
   if (!iterator_validate()) {
     free_last();
     return -1;
@@ -594,7 +597,7 @@ int MemDB::MDBWholeSpaceIteratorImpl:: prev()
  */
 int MemDB::MDBWholeSpaceIteratorImpl::seek_to_first(const std::string &k)
 {
-  std::lock_guard<std::mutex> l(*m_map_lock_p);
+  std::shared_lock l(*m_map_lock_p);
   free_last();
   if (k.empty()) {
     m_iter = m_map_p->begin();
@@ -611,7 +614,7 @@ int MemDB::MDBWholeSpaceIteratorImpl::seek_to_first(const std::string &k)
 
 int MemDB::MDBWholeSpaceIteratorImpl::seek_to_last(const std::string &k)
 {
-  std::lock_guard<std::mutex> l(*m_map_lock_p);
+  std::shared_lock l(*m_map_lock_p);
   free_last();
   if (k.empty()) {
     m_iter = m_map_p->end();
@@ -635,7 +638,7 @@ MemDB::MDBWholeSpaceIteratorImpl::~MDBWholeSpaceIteratorImpl()
 int MemDB::MDBWholeSpaceIteratorImpl::upper_bound(const std::string &prefix,
     const std::string &after) {
 
-  std::lock_guard<std::mutex> l(*m_map_lock_p);
+  std::shared_lock l(*m_map_lock_p);
 
   dtrace << "upper_bound " << prefix.c_str() << after.c_str() << dendl;
   string k = make_key(prefix, after);
@@ -649,7 +652,7 @@ int MemDB::MDBWholeSpaceIteratorImpl::upper_bound(const std::string &prefix,
 
 int MemDB::MDBWholeSpaceIteratorImpl::lower_bound(const std::string &prefix,
     const std::string &to) {
-  std::lock_guard<std::mutex> l(*m_map_lock_p);
+  std::shared_lock l(*m_map_lock_p);
   dtrace << "lower_bound " << prefix.c_str() << to.c_str() << dendl;
   string k = make_key(prefix, to);
   m_iter = m_map_p->lower_bound(k);
@@ -14,6 +14,7 @@
 #include <map>
 #include <string>
 #include <memory>
+#include <shared_mutex>
 #include <boost/scoped_ptr.hpp>
 #include "include/common_fwd.h"
 #include "include/encoding.h"
@@ -36,7 +37,8 @@ enum {
 class MemDB : public KeyValueDB
 {
   typedef std::pair<std::pair<std::string, std::string>, ceph::bufferlist> ms_op_t;
-  std::mutex m_lock;
+  /// taken shared by the readers, and exclusive by each transaction
+  std::shared_mutex m_lock;
   uint64_t m_total_bytes;
   uint64_t m_allocated_bytes;
 
@@ -119,7 +121,7 @@ public:
 private:
 
   /*
-   * Transaction states.
+   * Transaction states, applied with m_lock held.
    */
   int _merge(const std::string &k, ceph::bufferptr &bl);
   int _merge(ms_op_t &op);
@@ -156,17 +158,17 @@ public:
       mdb_iter_t m_iter;
       std::pair<std::string, ceph::bufferlist> m_key_value;
       mdb_map_t *m_map_p;
-      std::mutex *m_map_lock_p;
+      std::shared_mutex *m_map_lock_p;
       uint64_t *global_seq_no;
       uint64_t this_seq_no;
       bool m_using_btree;
 
   public:
-    MDBWholeSpaceIteratorImpl(mdb_map_t *btree_p, std::mutex *btree_lock_p,
+    MDBWholeSpaceIteratorImpl(mdb_map_t *btree_p, std::shared_mutex *btree_lock_p,
                               uint64_t *iterator_seq_no, bool using_btree) {
       m_map_p = btree_p;
       m_map_lock_p = btree_lock_p;
-      std::lock_guard<std::mutex> l(*m_map_lock_p);
+      std::shared_lock l(*m_map_lock_p);
       global_seq_no = iterator_seq_no;
       this_seq_no = *iterator_seq_no;
       m_using_btree = using_btree;
@@ -199,12 +201,12 @@ public:
   };
 
   uint64_t get_estimated_size(std::map<std::string,uint64_t> &extra) override {
-      std::lock_guard<std::mutex> l(m_lock);
+      std::shared_lock l(m_lock);
       return m_allocated_bytes;
   };
 
   int get_statfs(struct store_statfs_t *buf) override {
-    std::lock_guard<std::mutex> l(m_lock);
+    std::shared_lock l(m_lock);
     buf->reset();
     buf->total = m_total_bytes;
     buf->allocated = m_allocated_bytes;
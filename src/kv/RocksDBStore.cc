@@ -60,6 +60,7 @@ using ceph::Formatter;
 static const char* sharding_def_dir = "sharding";
 static const char* sharding_def_file = "sharding/def";
 static const char* sharding_recreate = "sharding/recreate_columns";
+static const char* sharding_online = "sharding/online";
 static const char* resharding_column_lock = "reshardingXcommencingXlocked";
 
 static bufferlist to_bufferlist(rocksdb::Slice in) {
@@ -1172,6 +1173,11 @@ int RocksDBStore::do_open(ostream &out,
     }
   }
   ceph_assert(default_cf != nullptr);
+
+  r = load_online_resharding(opt.env);
+  if (r < 0) {
+    return r;
+  }
   
   PerfCountersBuilder plb(cct, "rocksdb", l_rocksdb_first, l_rocksdb_last);
   plb.add_u64_counter(l_rocksdb_gets, "get", "Gets");
@@ -1195,6 +1201,10 @@ int RocksDBStore::do_open(ostream &out,
     compact();
     derr << "Finished compacting rocksdb store" << dendl;
   }
+  if (resharding_online && !open_readonly) {
+    reshard_thread_stop = false;
+    reshard_thread.create("rocksdb_reshard");
+  }
   return 0;
 }
 
@@ -1219,6 +1229,20 @@ RocksDBStore::~RocksDBStore()
 
 void RocksDBStore::close()
 {
+  // stop online resharding, it may queue compactions
+  if (reshard_thread.is_started()) {
+    dout(1) << __func__ << " waiting for resharding thread to stop" << dendl;
+    {
+      std::lock_guard l{reshard_thread_lock};
+      reshard_thread_stop = true;
+      reshard_thread_cond.notify_all();
+    }
+    reshard_thread.join();
+    dout(1) << __func__ << " resharding thread stopped" << dendl;
+  }
+  resharding_online = false;
+  resharding_prefixes.clear();
+
   // stop compaction thread
   compact_queue_lock.lock();
   if (compact_thread.is_started()) {
@@ -1490,8 +1514,16 @@ int RocksDBStore::submit_common(rocksdb::WriteOptions& woptions, KeyValueDB::Tra
   RocksWBHandler bat_txc(*this);
   _t->bat.Iterate(&bat_txc);
   *_dout << " Rocksdb transaction: " << bat_txc.seen.str() << dendl;
-  
+
+  // keep the resharding thread from moving keys we write under our feet
+  std::shared_lock reshard_l{reshard_lock, std::defer_lock};
+  if (resharding_online) {
+    reshard_l.lock();
+  }
   rocksdb::Status s = db->Write(woptions, &_t->bat);
+  if (reshard_l.owns_lock()) {
+    reshard_l.unlock();
+  }
   if (!s.ok()) {
     RocksWBHandler rocks_txc(*this);
     _t->bat.Iterate(&rocks_txc);
@@ -1584,6 +1616,9 @@ void RocksDBStore::RocksDBTransactionImpl::set(
   auto cf = db->get_cf_handle(prefix, k);
   if (cf) {
     put_bat(bat, cf, k, to_set_bl);
+    if (db->is_resharding(prefix)) {
+      bat.Delete(db->default_cf, combine_strings(prefix, k));
+    }
   } else {
     string key = combine_strings(prefix, k);
     put_bat(bat, db->default_cf, key, to_set_bl);
@@ -1599,6 +1634,9 @@ void RocksDBStore::RocksDBTransactionImpl::set(
   if (cf) {
     string key(k, keylen);  // fixme?
     put_bat(bat, cf, key, to_set_bl);
+    if (db->is_resharding(prefix)) {
+      bat.Delete(db->default_cf, combine_strings(prefix, key));
+    }
   } else {
     string key;
     combine_strings(prefix, k, keylen, &key);
@@ -1612,6 +1650,9 @@ void RocksDBStore::RocksDBTransactionImpl::rmkey(const string &prefix,
   auto cf = db->get_cf_handle(prefix, k);
   if (cf) {
     bat.Delete(cf, rocksdb::Slice(k));
+    if (db->is_resharding(prefix)) {
+      bat.Delete(db->default_cf, combine_strings(prefix, k));
+    }
   } else {
     bat.Delete(db->default_cf, combine_strings(prefix, k));
   }
@@ -1624,6 +1665,11 @@ void RocksDBStore::RocksDBTransactionImpl::rmkey(const string &prefix,
   auto cf = db->get_cf_handle(prefix, k, keylen);
   if (cf) {
     bat.Delete(cf, rocksdb::Slice(k, keylen));
+    if (db->is_resharding(prefix)) {
+      string key;
+      combine_strings(prefix, k, keylen, &key);
+      bat.Delete(db->default_cf, rocksdb::Slice(key));
+    }
   } else {
     string key;
     combine_strings(prefix, k, keylen, &key);
@@ -1637,6 +1683,9 @@ void RocksDBStore::RocksDBTransactionImpl::rm_single_key(const string &prefix,
   auto cf = db->get_cf_handle(prefix, k);
   if (cf) {
     bat.SingleDelete(cf, k);
+    if (db->is_resharding(prefix)) {
+      bat.SingleDelete(db->default_cf, combine_strings(prefix, k));
+    }
   } else {
     bat.SingleDelete(db->default_cf, combine_strings(prefix, k));
   }
@@ -1679,6 +1728,13 @@ void RocksDBStore::RocksDBTransactionImpl::rmkeys_by_prefix(const string &prefix
 	bat.PopSavePoint();
       }
     }
+    if (db->is_resharding(prefix)) {
+      string endprefix = prefix;
+      endprefix.push_back('\x01');
+      bat.DeleteRange(db->default_cf,
+		      combine_strings(prefix, string()),
+		      combine_strings(endprefix, string()));
+    }
   }
 }
 
@@ -1724,6 +1780,11 @@ void RocksDBStore::RocksDBTransactionImpl::rm_range_keys(const string &prefix,
       }
       delete it;
     }
+    if (db->is_resharding(prefix)) {
+      bat.DeleteRange(db->default_cf,
+		      rocksdb::Slice(combine_strings(prefix, start)),
+		      rocksdb::Slice(combine_strings(prefix, end)));
+    }
   }
 }
 
@@ -1774,13 +1835,62 @@ int RocksDBStore::get(
 {
   rocksdb::PinnableSlice value;
   utime_t start = ceph_clock_now();
-  if (cf_handles.count(prefix) > 0) {
+  if (keys.size() > 1 && !is_resharding(prefix)) {
+    // one batch, so that rocksdb reads the blocks of all keys in parallel
+    const bool sharded = cf_handles.count(prefix) > 0;
+    const size_t n = keys.size();
+    std::vector<std::string> combined;
+    std::vector<rocksdb::ColumnFamilyHandle*> cfs;
+    std::vector<rocksdb::Slice> slices;
+    cfs.reserve(n);
+    slices.reserve(n);
+    if (!sharded) {
+      combined.reserve(n);
+    }
+    for (auto& key : keys) {
+      if (sharded) {
+	cfs.push_back(get_cf_handle(prefix, key));
+	slices.emplace_back(key);
+      } else {
+	cfs.push_back(default_cf);
+	combined.push_back(combine_strings(prefix, key));
+	slices.emplace_back(combined.back());
+      }
+    }
+    std::vector<rocksdb::PinnableSlice> values(n);
+    std::vector<rocksdb::Status> statuses(n);
+    // the keys come sorted out of the set, and so do their combined keys,
+    // but the shards of a prefix interleave
+    db->MultiGet(rocksdb::ReadOptions(), n, cfs.data(), slices.data(),
+		 values.data(), statuses.data(), !sharded);
+    size_t i = 0;
+    for (auto& key : keys) {
+      if (statuses[i].ok()) {
+	(*out)[key].append(values[i].data(), values[i].size());
+      } else if (statuses[i].IsIOError()) {
+	ceph_abort_msg(statuses[i].getState());
+      }
+      ++i;
+    }
+  } else if (cf_handles.count(prefix) > 0) {
+    bool resharding = is_resharding(prefix);
     for (auto& key : keys) {
       auto cf_handle = get_cf_handle(prefix, key);
-      auto status = db->Get(rocksdb::ReadOptions(),
-			    cf_handle,
-			    rocksdb::Slice(key),
-			    &value);
+      auto status = rocksdb::Status::NotFound();
+      if (resharding) {
+	// the default column family first: a key moved after we miss it
+	// there is found in its new column family
+	status = db->Get(rocksdb::ReadOptions(),
+			 default_cf,
+			 rocksdb::Slice(combine_strings(prefix, key)),
+			 &value);
+      }
+      if (status.IsNotFound()) {
+	status = db->Get(rocksdb::ReadOptions(),
+			 cf_handle,
+			 rocksdb::Slice(key),
+			 &value);
+      }
       if (status.ok()) {
 	(*out)[key].append(value.data(), value.size());
       } else if (status.IsIOError()) {
@@ -1821,10 +1931,19 @@ int RocksDBStore::get(
   rocksdb::Status s;
   auto cf = get_cf_handle(prefix, key);
   if (cf) {
-    s = db->Get(rocksdb::ReadOptions(),
-		cf,
-		rocksdb::Slice(key),
-		&value);
+    s = rocksdb::Status::NotFound();
+    if (is_resharding(prefix)) {
+      s = db->Get(rocksdb::ReadOptions(),
+		  default_cf,
+		  rocksdb::Slice(combine_strings(prefix, key)),
+		  &value);
+    }
+    if (s.IsNotFound()) {
+      s = db->Get(rocksdb::ReadOptions(),
+		  cf,
+		  rocksdb::Slice(key),
+		  &value);
+    }
   } else {
     string k = combine_strings(prefix, key);
     s = db->Get(rocksdb::ReadOptions(),
@@ -1858,10 +1977,21 @@ int RocksDBStore::get(
   rocksdb::Status s;
   auto cf = get_cf_handle(prefix, key, keylen);
   if (cf) {
-    s = db->Get(rocksdb::ReadOptions(),
-		cf,
-		rocksdb::Slice(key, keylen),
-		&value);
+    s = rocksdb::Status::NotFound();
+    if (is_resharding(prefix)) {
+      string k;
+      combine_strings(prefix, key, keylen, &k);
+      s = db->Get(rocksdb::ReadOptions(),
+		  default_cf,
+		  rocksdb::Slice(k),
+		  &value);
+    }
+    if (s.IsNotFound()) {
+      s = db->Get(rocksdb::ReadOptions(),
+		  cf,
+		  rocksdb::Slice(key, keylen),
+		  &value);
+    }
   } else {
     string k;
     combine_strings(prefix, key, keylen, &k);
@@ -2169,6 +2299,38 @@ string RocksDBStore::past_prefix(const string &prefix)
   return limit;
 }
 
+// encode_range() straight from the slices of the rocksdb iterator
+// returned by cur, which valid() and next() move along
+template <typename Valid, typename Next, typename Cur>
+static size_t encode_slices(Valid&& valid, Next&& next, Cur&& cur,
+			    const std::string& end, size_t skip,
+			    size_t max_entries, size_t max_bytes,
+			    bufferlist* out, bool* more)
+{
+  size_t num = 0;
+  size_t start = out->length();
+  rocksdb::Slice end_slice(end);
+  *more = false;
+  for (; valid(); next()) {
+    rocksdb::Iterator* it = cur();
+    rocksdb::Slice k = it->key();
+    if (!end.empty() && k.compare(end_slice) >= 0) {
+      break;
+    }
+    if (num >= max_entries || out->length() - start >= max_bytes) {
+      *more = true;
+      break;
+    }
+    ceph_assert(k.size() >= skip);
+    rocksdb::Slice v = it->value();
+    encode(std::string_view(k.data() + skip, k.size() - skip), *out);
+    // the same encoding as a bufferlist
+    encode(std::string_view(v.data(), v.size()), *out);
+    ++num;
+  }
+  return num;
+}
+
 class CFIteratorImpl : public KeyValueDB::IteratorImpl {
 protected:
   string prefix;
@@ -2232,6 +2394,14 @@ public:
   int status() override {
     return dbiter->status().ok() ? 0 : -1;
   }
+  size_t encode_range(const std::string& end, size_t skip,
+		      size_t max_entries, size_t max_bytes,
+		      bufferlist* out, bool* more) override {
+    return encode_slices([this] { return valid(); },
+			 [this] { next(); },
+			 [this] { return dbiter; },
+			 end, skip, max_entries, max_bytes, out, more);
+  }
 };
 
 
@@ -2239,6 +2409,7 @@ public:
 class WholeMergeIteratorImpl : public KeyValueDB::WholeSpaceIteratorImpl {
 private:
   RocksDBStore* db;
+  const rocksdb::Snapshot* snapshot = nullptr;
   KeyValueDB::WholeSpaceIterator main;
   std::map<std::string, KeyValueDB::Iterator> shards;
   std::map<std::string, KeyValueDB::Iterator>::iterator current_shard;
@@ -2247,10 +2418,24 @@ private:
 public:
   WholeMergeIteratorImpl(RocksDBStore* db)
     : db(db)
-    , main(db->get_default_cf_iterator())
   {
+    rocksdb::ReadOptions ropts;
+    if (db->resharding_online) {
+      // keys are moving between column families; only in a common
+      // snapshot each of them is seen exactly once
+      snapshot = db->db->GetSnapshot();
+      ropts.snapshot = snapshot;
+    }
+    main = db->get_default_cf_iterator(ropts);
     for (auto& e : db->cf_handles) {
-      shards.emplace(e.first, db->get_iterator(e.first));
+      shards.emplace(e.first, db->get_cf_iterator(e.first, ropts));
+    }
+  }
+  ~WholeMergeIteratorImpl() override {
+    shards.clear();
+    main.reset();
+    if (snapshot) {
+      db->db->ReleaseSnapshot(snapshot);
     }
   }
 
@@ -2712,12 +2897,13 @@ private:
 public:
   explicit ShardMergeIteratorImpl(const RocksDBStore* db,
 				  const std::string& prefix,
-				  const std::vector<rocksdb::ColumnFamilyHandle*>& shards)
+				  const std::vector<rocksdb::ColumnFamilyHandle*>& shards,
+				  const rocksdb::ReadOptions& ropts)
     : db(db), keyless(db->comparator), prefix(prefix)
   {
     iters.reserve(shards.size());
     for (auto& s : shards) {
-      iters.push_back(db->db->NewIterator(rocksdb::ReadOptions(), s));
+      iters.push_back(db->db->NewIterator(ropts, s));
     }
   }
   ~ShardMergeIteratorImpl() {
@@ -2886,27 +3072,58 @@ public:
   int status() override {
     return iters[0]->status().ok() ? 0 : -1;
   }
+  size_t encode_range(const std::string& end, size_t skip,
+		      size_t max_entries, size_t max_bytes,
+		      bufferlist* out, bool* more) override {
+    return encode_slices([this] { return valid(); },
+			 [this] { next(); },
+			 [this] { return iters[0]; },
+			 end, skip, max_entries, max_bytes, out, more);
+  }
 };
 
+rocksdb::ReadOptions RocksDBStore::make_read_options(IteratorOpts opts)
+{
+  rocksdb::ReadOptions ropts;
+  if (opts & ITERATOR_NOCACHE) {
+    ropts.fill_cache = false;
+  }
+  if (opts & ITERATOR_READAHEAD) {
+    ropts.readahead_size =
+      cct->_conf.get_val<Option::size_t>("rocksdb_iterator_readahead_size");
+  }
+  return ropts;
+}
+
 KeyValueDB::Iterator RocksDBStore::get_iterator(const std::string& prefix, IteratorOpts opts)
 {
-  auto cf_it = cf_handles.find(prefix);
-  if (cf_it != cf_handles.end()) {
-    if (cf_it->second.handles.size() == 1) {
-      return std::make_shared<CFIteratorImpl>(
-        prefix,
-        db->NewIterator(rocksdb::ReadOptions(), cf_it->second.handles[0]));
-    } else {
-      return std::make_shared<ShardMergeIteratorImpl>(
-        this,
-        prefix,
-        cf_it->second.handles);
-    }
+  if (cf_handles.count(prefix) && !is_resharding(prefix)) {
+    return get_cf_iterator(prefix, make_read_options(opts));
   } else {
+    // while resharding, the whole space iterator merges the keys still
+    // in the default column family with those already moved
     return KeyValueDB::get_iterator(prefix, opts);
   }
 }
 
+KeyValueDB::Iterator RocksDBStore::get_cf_iterator(const std::string& prefix,
+						   const rocksdb::ReadOptions& ropts)
+{
+  auto cf_it = cf_handles.find(prefix);
+  ceph_assert(cf_it != cf_handles.end());
+  if (cf_it->second.handles.size() == 1) {
+    return std::make_shared<CFIteratorImpl>(
+      prefix,
+      db->NewIterator(ropts, cf_it->second.handles[0]));
+  } else {
+    return std::make_shared<ShardMergeIteratorImpl>(
+      this,
+      prefix,
+      cf_it->second.handles,
+      ropts);
+  }
+}
+
 rocksdb::Iterator* RocksDBStore::new_shard_iterator(rocksdb::ColumnFamilyHandle* cf)
 {
   return db->NewIterator(rocksdb::ReadOptions(), cf);
@@ -2915,20 +3132,18 @@ rocksdb::Iterator* RocksDBStore::new_shard_iterator(rocksdb::ColumnFamilyHandle*
 RocksDBStore::WholeSpaceIterator RocksDBStore::get_wholespace_iterator(IteratorOpts opts)
 {
   if (cf_handles.size() == 0) {
-    rocksdb::ReadOptions opt = rocksdb::ReadOptions();
-    if (opts & ITERATOR_NOCACHE)
-      opt.fill_cache=false;
     return std::make_shared<RocksDBWholeSpaceIteratorImpl>(
-      db->NewIterator(opt, default_cf));
+      db->NewIterator(make_read_options(opts), default_cf));
   } else {
     return std::make_shared<WholeMergeIteratorImpl>(this);
   }
 }
 
-RocksDBStore::WholeSpaceIterator RocksDBStore::get_default_cf_iterator()
+RocksDBStore::WholeSpaceIterator RocksDBStore::get_default_cf_iterator(
+  const rocksdb::ReadOptions& ropts)
 {
   return std::make_shared<RocksDBWholeSpaceIteratorImpl>(
-    db->NewIterator(rocksdb::ReadOptions(), default_cf));
+    db->NewIterator(ropts, default_cf));
 }
 
 int RocksDBStore::prepare_for_reshard(const std::string& new_sharding,
@@ -3327,10 +3542,248 @@ int RocksDBStore::reshard(const std::string& new_sharding, const RocksDBStore::r
     derr << __func__ << " cannot write to " << sharding_def_file << dendl;
     return -EIO;
   }
+  // every key is where the new sharding wants it, an interrupted online
+  // resharding included
+  env->DeleteFile(sharding_online);
 
   return r;
 }
 
+int RocksDBStore::reshard_online_prepare(const std::string& new_sharding)
+{
+  std::vector<ColumnFamily> new_sharding_def;
+  char const* error_position;
+  std::string error_msg;
+  if (!parse_sharding_def(new_sharding, new_sharding_def,
+			  &error_position, &error_msg)) {
+    dout(1) << __func__ << " bad sharding: " << dendl;
+    dout(1) << __func__ << new_sharding << dendl;
+    dout(1) << __func__ << std::string(error_position - &new_sharding[0], ' ')
+	    << "^" << error_msg << dendl;
+    return -EINVAL;
+  }
+
+  std::ostringstream out;
+  int r = do_open(out, false, false);
+  if (r < 0) {
+    return r;
+  }
+  auto close_db = make_scope_guard([this] {
+    close();
+  });
+  if (resharding_online) {
+    derr << __func__ << " an online resharding is already in progress" << dendl;
+    return -EBUSY;
+  }
+
+  std::string stored_sharding_text;
+  rocksdb::ReadFileToString(env, sharding_def_file, &stored_sharding_text);
+  std::vector<ColumnFamily> stored_sharding_def;
+  parse_sharding_def(stored_sharding_text, stored_sharding_def);
+
+  // existing columns must stay as they are, new ones must be fed from
+  // the default column family only
+  std::vector<ColumnFamily> to_create;
+  for (auto& n : new_sharding_def) {
+    auto o = std::find_if(stored_sharding_def.begin(), stored_sharding_def.end(),
+			  [&](const ColumnFamily& c) { return c.name == n.name; });
+    if (o != stored_sharding_def.end()) {
+      if (o->shard_cnt != n.shard_cnt ||
+	  o->hash_l != n.hash_l || o->hash_h != n.hash_h) {
+	derr << __func__ << " column " << n.name
+	     << " changes, only an offline reshard can do that" << dendl;
+	return -EINVAL;
+      }
+      continue;
+    }
+    for (auto& m : merge_ops) {
+      if (m.first == n.name) {
+	derr << __func__ << " column " << n.name
+	     << " has a merge operator, only an offline reshard can move it"
+	     << dendl;
+	return -EINVAL;
+      }
+    }
+    to_create.push_back(n);
+  }
+  for (auto& o : stored_sharding_def) {
+    if (std::find_if(new_sharding_def.begin(), new_sharding_def.end(),
+		     [&](const ColumnFamily& c) { return c.name == o.name; }) ==
+	new_sharding_def.end()) {
+      derr << __func__ << " column " << o.name
+	   << " goes away, only an offline reshard can do that" << dendl;
+      return -EINVAL;
+    }
+  }
+  if (to_create.empty()) {
+    dout(1) << __func__ << " no new column, nothing to do" << dendl;
+    return 0;
+  }
+
+  rocksdb::Options opt;
+  r = load_rocksdb_options(false, opt);
+  if (r) {
+    dout(1) << __func__ << " load rocksdb options failed" << dendl;
+    return r;
+  }
+  r = create_shards(opt, to_create);
+  if (r < 0) {
+    return r;
+  }
+  // record what is left to move before the new sharding, so that no
+  // open can see the new columns without knowing they are incomplete
+  for (auto& c : to_create) {
+    resharding_prefixes[c.name] = false;
+  }
+  r = store_online_resharding();
+  if (r < 0) {
+    return r;
+  }
+  env->CreateDir(sharding_def_dir);
+  if (auto status = rocksdb::WriteStringToFile(env, new_sharding,
+					       sharding_def_file, true);
+      !status.ok()) {
+    derr << __func__ << " cannot write to " << sharding_def_file << dendl;
+    return -EIO;
+  }
+  dout(1) << __func__ << " created " << to_create
+	  << ", their keys move on the next open" << dendl;
+  return 0;
+}
+
+int RocksDBStore::load_online_resharding(rocksdb::Env* env)
+{
+  std::string text;
+  auto status = rocksdb::ReadFileToString(env, sharding_online, &text);
+  if (!status.ok()) {
+    return 0;
+  }
+  for (auto& prefix : get_str_vec(text, " ")) {
+    if (cf_handles.count(prefix) == 0) {
+      // interrupted before the new sharding was stored
+      derr << __func__ << " resharding prefix " << prefix
+	   << " has no column family, ignoring" << dendl;
+      continue;
+    }
+    resharding_prefixes[prefix] = false;
+  }
+  resharding_online = !resharding_prefixes.empty();
+  dout(1) << __func__ << " moving " << text
+	  << " out of the default column family" << dendl;
+  return 0;
+}
+
+int RocksDBStore::store_online_resharding()
+{
+  std::string text;
+  for (auto& [prefix, done] : resharding_prefixes) {
+    if (!done) {
+      if (!text.empty()) {
+	text += " ";
+      }
+      text += prefix;
+    }
+  }
+  if (text.empty()) {
+    env->DeleteFile(sharding_online);
+    return 0;
+  }
+  env->CreateDir(sharding_def_dir);
+  auto status = rocksdb::WriteStringToFile(env, text, sharding_online, true);
+  if (!status.ok()) {
+    derr << __func__ << " cannot write to " << sharding_online << dendl;
+    return -EIO;
+  }
+  return 0;
+}
+
+void RocksDBStore::reshard_thread_entry()
+{
+  for (auto& [prefix, done] : resharding_prefixes) {
+    if (done) {
+      continue;
+    }
+    const std::string first = combine_strings(prefix, string());
+    std::string endprefix = prefix;
+    endprefix.push_back('\x01');
+    const std::string end = combine_strings(endprefix, string());
+    std::string next = first;
+    uint64_t keys_moved = 0;
+    dout(5) << __func__ << " moving " << prefix << dendl;
+    while (true) {
+      auto keys_per_batch =
+	cct->_conf.get_val<uint64_t>("rocksdb_online_reshard_keys_per_batch");
+      auto bytes_per_batch =
+	cct->_conf.get_val<Option::size_t>("rocksdb_online_reshard_bytes_per_batch");
+      auto interval = cct->_conf.get_val<double>("rocksdb_online_reshard_sleep");
+      {
+	std::unique_lock l{reshard_thread_lock};
+	if (interval > 0) {
+	  reshard_thread_cond.wait_for(
+	    l, ceph::make_timespan(interval), [this] { return reshard_thread_stop; });
+	}
+	if (reshard_thread_stop) {
+	  dout(5) << __func__ << " stopped, moved " << keys_moved << " keys of "
+		  << prefix << dendl;
+	  return;
+	}
+      }
+
+      rocksdb::WriteBatch bat;
+      size_t keys = 0, bytes = 0;
+      std::unique_lock l{reshard_lock};
+      std::unique_ptr<rocksdb::Iterator> it{
+	db->NewIterator(rocksdb::ReadOptions(), default_cf)};
+      for (it->Seek(next);
+	   it->Valid() && comparator->Compare(it->key(), end) < 0 &&
+	     keys < std::max<uint64_t>(keys_per_batch, 1) &&
+	     bytes < bytes_per_batch;
+	   it->Next()) {
+	rocksdb::Slice raw_key = it->key();
+	std::string key(raw_key.data() + first.size(),
+			raw_key.size() - first.size());
+	rocksdb::Slice value = it->value();
+	auto cf = get_cf_handle(prefix, key);
+	ceph_assert(cf);
+	bat.Put(cf, key, value);
+	bat.Delete(default_cf, raw_key);
+	keys++;
+	bytes += raw_key.size() + key.size() + value.size();
+	next = raw_key.ToString();
+      }
+      if (!it->status().ok()) {
+	derr << __func__ << " iterator error: " << it->status().ToString()
+	     << ", online resharding stops" << dendl;
+	return;
+      }
+      it.reset();
+      if (keys == 0) {
+	break;
+      }
+      rocksdb::WriteOptions woptions;
+      woptions.disableWAL = disableWAL;
+      auto s = db->Write(woptions, &bat);
+      l.unlock();
+      if (!s.ok()) {
+	derr << __func__ << " error: " << s.ToString()
+	     << ", online resharding stops" << dendl;
+	return;
+      }
+      keys_moved += keys;
+      dout(20) << __func__ << " moved " << keys_moved << " keys of "
+	       << prefix << dendl;
+    }
+    done = true;
+    dout(1) << __func__ << " moved " << keys_moved << " keys of " << prefix
+	    << " to its column family" << dendl;
+    store_online_resharding();
+    // get rid of the tombstones left behind
+    compact_range_async(first, end);
+  }
+  resharding_online = false;
+  dout(1) << __func__ << " online resharding done" << dendl;
+}
+
 bool RocksDBStore::get_sharding(std::string& sharding) {
   rocksdb::Status status;
   std::string stored_sharding_text;
@@ -6,6 +6,7 @@
 #include "include/types.h"
 #include "include/buffer_fwd.h"
 #include "KeyValueDB.h"
+#include <atomic>
 #include <set>
 #include <map>
 #include <string>
@@ -173,6 +174,42 @@ private:
 
   void compact_thread_entry();
 
+  // online resharding, see reshard_online_prepare()
+  /// prefixes being moved out of the default column family -> done;
+  /// the map itself is fixed while the db is open
+  std::map<std::string, std::atomic<bool>> resharding_prefixes;
+  std::atomic<bool> resharding_online = {false};
+  /// writers hold it shared while resharding_online, the resharding
+  /// thread exclusively while it moves a batch of keys
+  ceph::shared_mutex reshard_lock =
+    ceph::make_shared_mutex("RocksDBStore::reshard_lock");
+  ceph::mutex reshard_thread_lock =
+    ceph::make_mutex("RocksDBStore::reshard_thread_lock");
+  ceph::condition_variable reshard_thread_cond;
+  bool reshard_thread_stop = false;
+  class ReshardThread : public Thread {
+    RocksDBStore *db;
+  public:
+    explicit ReshardThread(RocksDBStore *d) : db(d) {}
+    void *entry() override {
+      db->reshard_thread_entry();
+      return NULL;
+    }
+    friend class RocksDBStore;
+  } reshard_thread;
+
+  void reshard_thread_entry();
+  int load_online_resharding(rocksdb::Env* env);
+  int store_online_resharding();
+  /// true if keys of @p prefix may still be found in the default column family
+  bool is_resharding(const std::string& prefix) const {
+    if (!resharding_online) {
+      return false;
+    }
+    auto p = resharding_prefixes.find(prefix);
+    return p != resharding_prefixes.end() && !p->second;
+  }
+
   void compact_range(const std::string& start, const std::string& end);
   void compact_range_async(const std::string& start, const std::string& end);
   int tryInterpret(const std::string& key, const std::string& val,
@@ -226,6 +263,7 @@ public:
     dbstats(NULL),
     compact_queue_stop(false),
     compact_thread(this),
+    reshard_thread(this),
     compact_on_mount(false),
     disableWAL(false),
     delete_range_threshold(cct->_conf.get_val<uint64_t>("rocksdb_delete_range_threshold"))
@@ -365,6 +403,10 @@ public:
 private:
   /// this iterator spans single cf
   rocksdb::Iterator* new_shard_iterator(rocksdb::ColumnFamilyHandle* cf);
+  rocksdb::ReadOptions make_read_options(IteratorOpts opts);
+  /// iterator over the column families of @p prefix only
+  KeyValueDB::Iterator get_cf_iterator(const std::string& prefix,
+				       const rocksdb::ReadOptions& ropts);
 public:
   /// Utility
   static std::string combine_strings(const std::string &prefix, const std::string &value) {
@@ -496,7 +538,7 @@ err:
 
   WholeSpaceIterator get_wholespace_iterator(IteratorOpts opts = 0) override;
 private:
-  WholeSpaceIterator get_default_cf_iterator();
+  WholeSpaceIterator get_default_cf_iterator(const rocksdb::ReadOptions& ropts);
 
   using cf_deleter_t = std::function<void(rocksdb::ColumnFamilyHandle*)>;
   using columns_t = std::map<std::string,
@@ -516,6 +558,16 @@ public:
     bool   unittest_fail_after_successful_processing = false;
   };
   int reshard(const std::string& new_sharding, const resharding_ctrl* ctrl = nullptr);
+  /**
+   * Prepare a reshard that completes while the db is in use.
+   *
+   * Only adding column families for prefixes that are in the default
+   * column family is supported, and not for prefixes with a merge
+   * operator.  The new column families are created and the new sharding
+   * is stored right away; the keys are moved by a background thread
+   * on the following opens, meanwhile reads look in both places.
+   */
+  int reshard_online_prepare(const std::string& new_sharding);
   bool get_sharding(std::string& sharding);
 
 };
@@ -47,13 +47,21 @@ rocksdb::Status ShardedCache::Insert(const rocksdb::Slice& key, void* value, siz
                             void (*deleter)(const rocksdb::Slice& key, void* value),
                             rocksdb::Cache::Handle** handle, Priority priority) {
   uint32_t hash = HashSlice(key);
+  if (mrc_enabled) {
+    // inserted after a miss
+    mrc.access(hash, charge);
+  }
   return GetShard(Shard(hash))
       ->Insert(key, hash, value, charge, deleter, handle, priority);
 }
 
 rocksdb::Cache::Handle* ShardedCache::Lookup(const rocksdb::Slice& key, rocksdb::Statistics* /*stats*/) {
   uint32_t hash = HashSlice(key);
-  return GetShard(Shard(hash))->Lookup(key, hash);
+  auto h = GetShard(Shard(hash))->Lookup(key, hash);
+  if (h && mrc_enabled) {
+    mrc.access(hash, GetCharge(h));
+  }
+  return h;
 }
 
 bool ShardedCache::Ref(rocksdb::Cache::Handle* handle) {
@@ -113,6 +113,15 @@ class ShardedCache : public rocksdb::Cache, public PriorityCache::PriCache {
     cache_ratio = ratio;
   }
   virtual std::string get_cache_name() const = 0;
+  virtual void set_miss_ratio_curve_enabled(bool enabled) {
+    if (!enabled) {
+      mrc.reset();
+    }
+    mrc_enabled = enabled;
+  }
+  virtual PriorityCache::MissRatioCurve* get_miss_ratio_curve() {
+    return mrc_enabled ? &mrc : nullptr;
+  }
 
  private:
   static inline uint32_t HashSlice(const rocksdb::Slice& s) {
@@ -127,6 +136,8 @@ class ShardedCache : public rocksdb::Cache, public PriorityCache::PriCache {
 
   int64_t cache_bytes[PriorityCache::Priority::LAST+1] = {0};
   double cache_ratio = 0;
+  std::atomic<bool> mrc_enabled = {false};
+  PriorityCache::MissRatioCurve mrc;
 
   int num_shard_bits_;
   mutable std::mutex capacity_mutex_;
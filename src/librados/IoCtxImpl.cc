@@ -780,6 +780,47 @@ int librados::IoCtxImpl::aio_operate(const object_t& oid,
   return 0;
 }
 
+int librados::IoCtxImpl::aio_operate_batch(
+  const std::vector<object_t>& oids,
+  const std::vector<::ObjectOperation*>& ops,
+  const std::vector<AioCompletionImpl*>& cs,
+  int flags,
+  const std::vector<bufferlist*> *pbls)
+{
+  FUNCTRACE(client->cct);
+  const bool is_read = pbls != nullptr;
+  /* can't write to a snapshot */
+  if (!is_read && snap_seq != CEPH_NOSNAP)
+    return -EROFS;
+  auto ut = ceph::real_clock::now();
+
+  std::vector<std::pair<Objecter::Op*, ceph_tid_t*>> batch;
+  batch.reserve(oids.size());
+  for (size_t i = 0; i < oids.size(); ++i) {
+    AioCompletionImpl *c = cs[i];
+    Context *oncomplete = new C_aio_Complete(c);
+#if defined(WITH_EVENTTRACE)
+    ((C_aio_Complete *) oncomplete)->oid = oids[i];
+#endif
+    c->io = this;
+    Objecter::Op *op;
+    if (is_read) {
+      c->is_read = true;
+      op = objecter->prepare_read_op(
+	oids[i], oloc, *ops[i], snap_seq, (*pbls)[i], flags | extra_op_flags,
+	oncomplete, &c->objver);
+    } else {
+      queue_aio_write(c);
+      op = objecter->prepare_mutate_op(
+	oids[i], oloc, *ops[i], snapc, ut, flags | extra_op_flags,
+	oncomplete, &c->objver);
+    }
+    batch.emplace_back(op, &c->tid);
+  }
+  objecter->op_submit(batch);
+  return 0;
+}
+
 int librados::IoCtxImpl::aio_read(const object_t oid, AioCompletionImpl *c,
 				  bufferlist *pbl, size_t len, uint64_t off,
 				  uint64_t snapid, const blkin_trace_info *info)
@@ -1672,6 +1672,52 @@ int librados::IoCtx::aio_operate(const std::string& oid, AioCompletion *c,
                translate_flags(flags), pbl, trace_info);
 }
 
+int librados::IoCtx::aio_operate(const std::vector<std::string>& oids,
+				 const std::vector<AioCompletion*>& cs,
+				 const std::vector<ObjectWriteOperation*>& ops,
+				 int flags)
+{
+  if (unlikely(oids.size() != cs.size() || oids.size() != ops.size()))
+    return -EINVAL;
+  std::vector<object_t> objs(oids.begin(), oids.end());
+  std::vector<::ObjectOperation*> os;
+  std::vector<AioCompletionImpl*> pcs;
+  os.reserve(ops.size());
+  pcs.reserve(cs.size());
+  for (size_t i = 0; i < ops.size(); ++i) {
+    if (unlikely(!ops[i]->impl))
+      return -EINVAL;
+    os.push_back(&ops[i]->impl->o);
+    pcs.push_back(cs[i]->pc);
+  }
+  return io_ctx_impl->aio_operate_batch(objs, os, pcs,
+					translate_flags(flags), nullptr);
+}
+
+int librados::IoCtx::aio_operate(const std::vector<std::string>& oids,
+				 const std::vector<AioCompletion*>& cs,
+				 const std::vector<ObjectReadOperation*>& ops,
+				 const std::vector<bufferlist*>& pbls,
+				 int flags)
+{
+  if (unlikely(oids.size() != cs.size() || oids.size() != ops.size() ||
+	       oids.size() != pbls.size()))
+    return -EINVAL;
+  std::vector<object_t> objs(oids.begin(), oids.end());
+  std::vector<::ObjectOperation*> os;
+  std::vector<AioCompletionImpl*> pcs;
+  os.reserve(ops.size());
+  pcs.reserve(cs.size());
+  for (size_t i = 0; i < ops.size(); ++i) {
+    if (unlikely(!ops[i]->impl))
+      return -EINVAL;
+    os.push_back(&ops[i]->impl->o);
+    pcs.push_back(cs[i]->pc);
+  }
+  return io_ctx_impl->aio_operate_batch(objs, os, pcs,
+					translate_flags(flags), &pbls);
+}
+
 void librados::IoCtx::snap_set_read(snap_t seq)
 {
   io_ctx_impl->set_snap_read(seq);
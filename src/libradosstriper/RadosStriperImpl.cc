@@ -58,6 +58,8 @@
  * data operations are happening and vice versa. It thus makes sure that the layout
  * of a striped object does not change during data operation, which is essential for
  * data consistency.
+ * Reads may be told to skip the lock with rados_striper_lockless_reads, trading
+ * that guarantee for two round trips less per read.
  *
  * Still the writing to a striped object is not atomic. This means in particular that
  * the size of an object may not be in sync with its content at all times.
@@ -355,6 +357,8 @@ struct RadosReadCompletionData : RefCountedObject {
   uint64_t m_expectedBytes;
   /// the bufferlist object where data have been written
   bufferlist *m_bl;
+  /// the throttle of the object ops in flight
+  Throttle *m_inflightOps;
 
 private:
   FRIEND_MAKE_REF(RadosReadCompletionData);
@@ -362,9 +366,30 @@ private:
   RadosReadCompletionData(MultiAioCompletionImplPtr multiAioCompl,
 			  uint64_t expectedBytes,
 			  bufferlist *bl,
+			  Throttle *inflightOps,
 			  CephContext *context) :
     RefCountedObject(context),
-    m_multiAioCompl(multiAioCompl), m_expectedBytes(expectedBytes), m_bl(bl) {}
+    m_multiAioCompl(multiAioCompl), m_expectedBytes(expectedBytes), m_bl(bl),
+    m_inflightOps(inflightOps) {}
+};
+
+/**
+ * struct handling the data needed to pass to the call back
+ * function in asynchronous write operations of a Rados File
+ */
+struct RadosWriteCompletionData : RefCountedObject {
+  /// the multi asynch io completion object to be used
+  MultiAioCompletionImplPtr m_multiAioCompl;
+  /// the throttle of the object ops in flight
+  Throttle *m_inflightOps;
+private:
+  FRIEND_MAKE_REF(RadosWriteCompletionData);
+  /// constructor
+  RadosWriteCompletionData(MultiAioCompletionImplPtr multiAioCompl,
+			   Throttle *inflightOps,
+			   CephContext *context) :
+    RefCountedObject(context),
+    m_multiAioCompl(multiAioCompl), m_inflightOps(inflightOps) {}
 };
 
 /**
@@ -450,7 +475,10 @@ private:
 
 libradosstriper::RadosStriperImpl::RadosStriperImpl(librados::IoCtx& ioctx, librados::IoCtxImpl *ioctx_impl) :
   m_refCnt(0), m_radosCluster(ioctx), m_ioCtx(ioctx), m_ioCtxImpl(ioctx_impl),
-  m_layout(default_file_layout) {}
+  m_layout(default_file_layout),
+  m_inflightOps(cct(), "libradosstriper-inflight-ops",
+		cct()->_conf.get_val<uint64_t>("rados_striper_max_inflight_ops"),
+		false) {}
 
 ///////////////////////// layout /////////////////////////////
 
@@ -634,11 +662,19 @@ static void rados_read_aio_unlock_complete(rados_striper_multi_completion_t c, v
 static void striper_read_aio_req_complete(rados_striper_multi_completion_t c, void *arg)
 {
   auto cdata = static_cast<ReadCompletionData*>(arg);
+  libradosstriper::MultiAioCompletionImpl *comp =
+    reinterpret_cast<libradosstriper::MultiAioCompletionImpl*>(c);
+  if (cdata->m_lockCookie.empty()) {
+    // lockless read, there is nothing to unlock
+    cdata->complete_read(comp->rval);
+    cdata->complete_unlock(0);
+    // drop the reference meant for the unlock completion
+    cdata->put();
+    return;
+  }
   // launch the async unlocking of the object
   cdata->m_striper->aio_unlockObject(cdata->m_soid, cdata->m_lockCookie, cdata->m_unlockCompletion);
   // complete the read part in parallel
-  libradosstriper::MultiAioCompletionImpl *comp =
-    reinterpret_cast<libradosstriper::MultiAioCompletionImpl*>(c);
   cdata->complete_read(comp->rval);
 }
 
@@ -669,6 +705,7 @@ static void rados_req_read_complete(rados_completion_t c, void *arg)
     }
     nread = data->m_expectedBytes;
   }
+  data->m_inflightOps->put(1);
   auto multi_aio_comp = data->m_multiAioCompl;
   multi_aio_comp->complete_request(nread);
   multi_aio_comp->safe_request(rc);
@@ -736,13 +773,17 @@ int libradosstriper::RadosStriperImpl::aio_read(const std::string& soid,
     nc->add_request();
     // we need 2 references on data as both rados_req_read_safe and rados_req_read_complete
     // will release one
-    auto data = ceph::make_ref<RadosReadCompletionData>(nc, p->length, oid_bl, cct());
+    auto data = ceph::make_ref<RadosReadCompletionData>(nc, p->length, oid_bl,
+							&m_inflightOps, cct());
     librados::AioCompletion *rados_completion =
       librados::Rados::aio_create_completion(data.detach(), rados_req_read_complete);
+    m_inflightOps.get(1);
     r = m_ioCtx.aio_read(p->oid.name, rados_completion, oid_bl, p->length, p->offset);
     rados_completion->release();
-    if (r < 0)
+    if (r < 0) {
+      m_inflightOps.put(1);
       break;
+    }
   }
   nc->finish_adding_requests();
   return r;
@@ -1206,7 +1247,9 @@ int libradosstriper::RadosStriperImpl::aio_write_in_open_object(const std::strin
 
 static void rados_req_write_complete(rados_completion_t c, void *arg)
 {
-  auto comp = reinterpret_cast<libradosstriper::MultiAioCompletionImpl*>(arg);
+  auto data = ceph::ref_t<RadosWriteCompletionData>(static_cast<RadosWriteCompletionData*>(arg), false);
+  data->m_inflightOps->put(1);
+  auto comp = data->m_multiAioCompl;
   comp->complete_request(rados_aio_get_return_value(c));
   comp->safe_request(rados_aio_get_return_value(c));
 }
@@ -1244,14 +1287,19 @@ libradosstriper::RadosStriperImpl::internal_aio_write(const std::string& soid,
       }
       // and write the object
       c->add_request();
+      auto data = ceph::make_ref<RadosWriteCompletionData>(c, &m_inflightOps,
+							   cct());
       librados::AioCompletion *rados_completion =
-        librados::Rados::aio_create_completion(c.get(),
+        librados::Rados::aio_create_completion(data.detach(),
 					       rados_req_write_complete);
+      m_inflightOps.get(1);
       r = m_ioCtx.aio_write(p->oid.name, rados_completion, oid_bl,
 			    p->length, p->offset);
       rados_completion->release();
-      if (r < 0)
+      if (r < 0) {
+        m_inflightOps.put(1);
         break;
+      }
     }
   }
   c->finish_adding_requests();
@@ -1336,6 +1384,13 @@ int libradosstriper::RadosStriperImpl::openStripedObjectForRead(
   uint64_t *size,
   std::string *lockCookie)
 {
+  std::string firstObjOid = getObjectId(soid, 0);
+  if (cct()->_conf.get_val<bool>("rados_striper_lockless_reads")) {
+    // no lock, so nothing to unlock either. the read of the attributes
+    // fails with -ENOENT if the striped object does not exist
+    lockCookie->clear();
+    return internal_get_layout_and_size(firstObjOid, layout, size);
+  }
   // take a lock the first rados object, if it exists and gets its size
   // check, lock and size reading must be atomic and are thus done within a single operation
   librados::ObjectWriteOperation op;
@@ -1343,7 +1398,6 @@ int libradosstriper::RadosStriperImpl::openStripedObjectForRead(
   *lockCookie = getUUID();
   utime_t dur = utime_t();
   rados::cls::lock::lock(&op, RADOS_LOCK_NAME, ClsLockType::SHARED, *lockCookie, "Tag", "", dur, 0);
-  std::string firstObjOid = getObjectId(soid, 0);
   int rc = m_ioCtx.operate(firstObjOid, &op);
   if (rc) {
     // error case (including -ENOENT)
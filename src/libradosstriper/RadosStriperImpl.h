@@ -28,6 +28,7 @@
 #include "librados/IoCtxImpl.h"
 #include "librados/AioCompletionImpl.h"
 #include "common/RefCountedObj.h"
+#include "common/Throttle.h"
 #include "common/ceph_context.h"
 
 namespace libradosstriper {
@@ -178,6 +179,8 @@ struct RadosStriperImpl {
 
   /**
    * opens an existing striped object and takes a shared lock on it
+   * With rados_striper_lockless_reads, no lock is taken and lockCookie is
+   * left empty
    * @return 0 if everything is ok and the lock was taken. -errcode otherwise
    * In particulae, if the striped object does not exists, -ENOENT is returned
    * In case the return code in not 0, no lock is taken
@@ -271,6 +274,9 @@ struct RadosStriperImpl {
 
   // Default layout
   ceph_file_layout m_layout;
+
+  // rados object ops in flight, see rados_striper_max_inflight_ops
+  Throttle m_inflightOps;
 };
 }
 #endif
@@ -790,9 +790,11 @@ librados::IoCtx duplicate_io_ctx(librados::IoCtx& io_ctx) {
     ASSIGN_OPTION(skip_partial_discard, bool);
     ASSIGN_OPTION(discard_granularity_bytes, uint64_t);
     ASSIGN_OPTION(blkin_trace_all, bool);
+    ASSIGN_OPTION(event_socket_coalesce, bool);
 
     auto cache_policy = config.get_val<std::string>("rbd_cache_policy");
-    if (cache_policy == "writethrough" || cache_policy == "writeback") {
+    if (cache_policy == "writethrough" || cache_policy == "writeback" ||
+        cache_policy == "writeback_sharded") {
       ASSIGN_OPTION(readahead_max_bytes, Option::size_t);
       ASSIGN_OPTION(readahead_disable_after_bytes, Option::size_t);
     }
@@ -827,6 +829,8 @@ librados::IoCtx duplicate_io_ctx(librados::IoCtx& io_ctx) {
       }
     }
 
+    io_image_dispatcher->apply_qos_group(
+      config.get_val<std::string>("rbd_qos_group"));
     io_image_dispatcher->apply_qos_schedule_tick_min(
       config.get_val<uint64_t>("rbd_qos_schedule_tick_min"));
 
@@ -206,6 +206,8 @@ namespace librbd {
 
     Completions event_socket_completions;
     EventSocket event_socket;
+    /// a notification is outstanding for event_socket_completions
+    std::atomic<bool> event_socket_notified = {false};
 
     bool ignore_migrating = false;
     bool disable_zero_copy = false;
@@ -223,6 +225,7 @@ namespace librbd {
     uint32_t read_flags = 0U;  // librados::OPERATION_*
     uint32_t discard_granularity_bytes = 0;
     bool blkin_trace_all;
+    bool event_socket_coalesce = false;
     uint64_t mirroring_replay_delay;
     uint64_t mtime_update_interval;
     uint64_t atime_update_interval;
@@ -13,6 +13,10 @@
 #include "osd/osd_types.h"
 #include "osdc/WritebackHandler.h"
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #include <vector>
 
 #define dout_subsys ceph_subsys_rbd
@@ -31,7 +35,9 @@ ParentCacheObjectDispatch<I>::ParentCacheObjectDispatch(
     I* image_ctx, plugin::Api<I>& plugin_api)
   : m_image_ctx(image_ctx), m_plugin_api(plugin_api),
     m_lock(ceph::make_mutex(
-      "librbd::cache::ParentCacheObjectDispatch::lock", true, false)) {
+      "librbd::cache::ParentCacheObjectDispatch::lock", true, false)),
+    m_max_mapped_objects(image_ctx->config.template get_val<uint64_t>(
+      "rbd_parent_cache_max_mapped_objects")) {
   ceph_assert(m_image_ctx->data_ctx.is_valid());
   auto controller_path = image_ctx->cct->_conf.template get_val<std::string>(
     "immutable_object_cache_sock");
@@ -230,6 +236,72 @@ void ParentCacheObjectDispatch<I>::create_cache_session(Context* on_finish,
   m_cache_client->connect(connect_ctx);
 }
 
+template <typename I>
+ParentCacheObjectDispatch<I>::MappedObject::~MappedObject() {
+  if (data != nullptr) {
+    munmap(data, length);
+  }
+}
+
+template <typename I>
+typename ParentCacheObjectDispatch<I>::MappedObjectRef
+ParentCacheObjectDispatch<I>::get_mapped_object(const std::string& file_path) {
+  auto cct = m_image_ctx->cct;
+  {
+    std::lock_guard locker{m_mapped_lock};
+    auto it = m_mapped_objects.find(file_path);
+    if (it != m_mapped_objects.end()) {
+      m_mapped_lru.splice(m_mapped_lru.begin(), m_mapped_lru, it->second);
+      return it->second->second;
+    }
+  }
+
+  // the daemon only ever unlinks the cache files, so what is mapped
+  // stays readable even once the object is evicted
+  int fd = ::open(file_path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    ldout(cct, 5) << "failed to open " << file_path << ": "
+                  << cpp_strerror(errno) << dendl;
+    return nullptr;
+  }
+
+  auto mapped_object = std::make_shared<MappedObject>();
+  struct stat st;
+  if (fstat(fd, &st) < 0) {
+    ldout(cct, 5) << "failed to stat " << file_path << ": "
+                  << cpp_strerror(errno) << dendl;
+    ::close(fd);
+    return nullptr;
+  }
+  if (st.st_size > 0) {
+    void* addr = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    if (addr == MAP_FAILED) {
+      ldout(cct, 5) << "failed to map " << file_path << ": "
+                    << cpp_strerror(errno) << dendl;
+      ::close(fd);
+      return nullptr;
+    }
+    mapped_object->data = static_cast<char*>(addr);
+    mapped_object->length = st.st_size;
+  }
+  ::close(fd);
+
+  std::lock_guard locker{m_mapped_lock};
+  auto it = m_mapped_objects.find(file_path);
+  if (it != m_mapped_objects.end()) {
+    // mapped by a racing read
+    return it->second->second;
+  }
+  m_mapped_lru.emplace_front(file_path, mapped_object);
+  m_mapped_objects[file_path] = m_mapped_lru.begin();
+  if (m_mapped_lru.size() > m_max_mapped_objects) {
+    // unmapped once the reads copying from it are done
+    m_mapped_objects.erase(m_mapped_lru.back().first);
+    m_mapped_lru.pop_back();
+  }
+  return mapped_object;
+}
+
 template <typename I>
 int ParentCacheObjectDispatch<I>::read_object(
     std::string file_path, ceph::bufferlist* read_data, uint64_t offset,
@@ -238,6 +310,17 @@ int ParentCacheObjectDispatch<I>::read_object(
   auto *cct = m_image_ctx->cct;
   ldout(cct, 20) << "file path: " << file_path << dendl;
 
+  if (m_max_mapped_objects > 0) {
+    auto mapped_object = get_mapped_object(file_path);
+    if (mapped_object) {
+      if (offset < mapped_object->length) {
+        read_data->append(mapped_object->data + offset,
+                          std::min(length, mapped_object->length - offset));
+      }
+      return read_data->length();
+    }
+  }
+
   std::string error;
   int ret = read_data->pread_file(file_path.c_str(), offset, length, &error);
   if (ret < 0) {
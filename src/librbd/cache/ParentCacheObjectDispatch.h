@@ -9,6 +9,9 @@
 #include "librbd/cache/TypeTraits.h"
 #include "tools/immutable_object_cache/CacheClient.h"
 #include "tools/immutable_object_cache/Types.h"
+#include <list>
+#include <memory>
+#include <unordered_map>
 
 namespace librbd {
 
@@ -133,7 +136,16 @@ public:
   }
 
 private:
+  struct MappedObject {
+    char* data = nullptr;
+    uint64_t length = 0;
 
+    ~MappedObject();
+  };
+  typedef std::shared_ptr<MappedObject> MappedObjectRef;
+  typedef std::list<std::pair<std::string, MappedObjectRef>> MappedObjects;
+
+  MappedObjectRef get_mapped_object(const std::string& file_path);
   int read_object(std::string file_path, ceph::bufferlist* read_data,
                   uint64_t offset, uint64_t length, Context *on_finish);
   void handle_read_cache(ceph::immutable_obj_cache::ObjectCacheRequest* ack,
@@ -151,6 +163,13 @@ private:
   ceph::mutex m_lock;
   CacheClient *m_cache_client = nullptr;
   bool m_connecting = false;
+
+  uint64_t m_max_mapped_objects;
+  ceph::mutex m_mapped_lock = ceph::make_mutex(
+    "librbd::cache::ParentCacheObjectDispatch::mapped_lock");
+  MappedObjects m_mapped_lru; ///< the most recently read first
+  std::unordered_map<std::string, typename MappedObjects::iterator>
+    m_mapped_objects;
 };
 
 } // namespace cache
@@ -0,0 +1,1092 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+
+#include "librbd/cache/ShardedObjectDispatch.h"
+#include "include/neorados/RADOS.hpp"
+#include "common/Timer.h"
+#include "common/dout.h"
+#include "common/errno.h"
+#include "librbd/AsioEngine.h"
+#include "librbd/ImageCtx.h"
+#include "librbd/Utils.h"
+#include "librbd/asio/ContextWQ.h"
+#include "librbd/io/ObjectDispatchSpec.h"
+#include "librbd/io/ObjectDispatcherInterface.h"
+#include "librbd/io/Utils.h"
+
+#define dout_subsys ceph_subsys_rbd
+#undef dout_prefix
+#define dout_prefix *_dout << "librbd::cache::ShardedObjectDispatch: " \
+                           << this << " " << __func__ << ": "
+
+namespace librbd {
+namespace cache {
+
+using librbd::util::data_object_name;
+
+template <typename I>
+ShardedObjectDispatch<I>::ShardedObjectDispatch(
+    I* image_ctx, size_t max_dirty, bool writethrough_until_flush)
+  : m_image_ctx(image_ctx), m_init_max_dirty(max_dirty), m_max_dirty(max_dirty),
+    m_lock(ceph::make_mutex(util::unique_lock_name(
+      "librbd::cache::ShardedObjectDispatch::lock", this))) {
+  if (writethrough_until_flush) {
+    m_max_dirty = 0;
+  }
+
+  auto& config = m_image_ctx->config;
+  uint64_t shards = std::max<uint64_t>(
+    1, config.template get_val<uint64_t>("rbd_cache_shards"));
+  m_target_dirty = std::min<uint64_t>(
+    config.template get_val<Option::size_t>("rbd_cache_target_dirty"),
+    max_dirty);
+  m_max_shard_bytes =
+    config.template get_val<Option::size_t>("rbd_cache_size") / shards;
+  m_max_dirty_age = config.template get_val<double>("rbd_cache_max_dirty_age");
+
+  m_shards.reserve(shards);
+  for (uint64_t i = 0; i < shards; ++i) {
+    m_shards.emplace_back(std::make_unique<Shard>());
+  }
+
+  I::get_timer_instance(m_image_ctx->cct, &m_timer, &m_timer_lock);
+}
+
+template <typename I>
+ShardedObjectDispatch<I>::~ShardedObjectDispatch() {
+}
+
+template <typename I>
+void ShardedObjectDispatch<I>::init() {
+  auto cct = m_image_ctx->cct;
+  ldout(cct, 5) << "shards=" << m_shards.size() << ", "
+                << "max_dirty=" << m_init_max_dirty << ", "
+                << "target_dirty=" << m_target_dirty << dendl;
+
+  // add ourself to the IO object dispatcher chain
+  if (m_init_max_dirty > 0) {
+    m_image_ctx->disable_zero_copy = true;
+  }
+  m_image_ctx->io_object_dispatcher->register_dispatch(this);
+}
+
+template <typename I>
+void ShardedObjectDispatch<I>::shut_down(Context* on_finish) {
+  auto cct = m_image_ctx->cct;
+  ldout(cct, 5) << dendl;
+
+  {
+    std::lock_guard timer_locker{*m_timer_lock};
+    m_shutting_down = true;
+    if (m_timer_task != nullptr) {
+      bool canceled = m_timer->cancel_event(m_timer_task);
+      ceph_assert(canceled);
+      m_timer_task = nullptr;
+    }
+  }
+
+  // write back whatever is still dirty
+  flush_all(util::create_async_context_callback(*m_image_ctx, on_finish));
+}
+
+template <typename I>
+bool ShardedObjectDispatch<I>::read(
+    uint64_t object_no, io::ReadExtents* extents, IOContext io_context,
+    int op_flags, int read_flags, const ZTracer::Trace &parent_trace,
+    uint64_t* version, int* object_dispatch_flags,
+    io::DispatchResult* dispatch_result, Context** on_finish,
+    Context* on_dispatched) {
+  auto cct = m_image_ctx->cct;
+  ldout(cct, 20) << data_object_name(m_image_ctx, object_no) << " "
+                 << *extents << dendl;
+
+  if (extents->empty() ||
+      io_context->read_snap().value_or(CEPH_NOSNAP) != CEPH_NOSNAP) {
+    // only the head of the objects is cached
+    return false;
+  }
+
+  if (version != nullptr || read_flags != 0) {
+    // not cached, but it mustn't overtake the dirty data
+    return wait_for_writeback(object_no, dispatch_result, on_dispatched);
+  }
+
+  auto& shard = get_shard(object_no);
+  uint64_t gen;
+  {
+    std::shared_lock locker{shard.lock};
+    auto it = shard.objects.find(object_no);
+    if (it != shard.objects.end()) {
+      auto& object = it->second;
+
+      bool hit = true;
+      std::vector<ceph::bufferlist> bls(extents->size());
+      for (size_t i = 0; i < extents->size() && hit; ++i) {
+        auto& extent = (*extents)[i];
+        hit = lookup(object, extent.offset, extent.length, &bls[i]);
+      }
+
+      if (hit) {
+        locker.unlock();
+
+        ldout(cct, 20) << "hit" << dendl;
+        for (size_t i = 0; i < extents->size(); ++i) {
+          auto& extent = (*extents)[i];
+          extent.bl = std::move(bls[i]);
+          extent.extent_map.clear();
+        }
+
+        *dispatch_result = io::DISPATCH_RESULT_COMPLETE;
+        on_dispatched = util::create_async_context_callback(*m_image_ctx,
+                                                            on_dispatched);
+        on_dispatched->complete(0);
+        return true;
+      }
+
+      bool dirty = false;
+      for (auto& extent : *extents) {
+        dirty |= intersects_dirty(object, extent.offset, extent.length);
+      }
+      if (dirty) {
+        locker.unlock();
+
+        ldout(cct, 20) << "miss on dirty data" << dendl;
+        return wait_for_writeback(object_no, dispatch_result, on_dispatched);
+      }
+    }
+
+    // any change from now on bumps the gen of the object past this one
+    gen = m_last_gen;
+  }
+
+  if ((op_flags & (LIBRADOS_OP_FLAG_FADVISE_DONTNEED |
+                   LIBRADOS_OP_FLAG_FADVISE_NOCACHE)) != 0) {
+    return false;
+  }
+
+  auto ctx = *on_finish;
+  *on_finish = new LambdaContext(
+    [this, object_no, gen, extents, ctx](int r) {
+      if (r >= 0 || r == -ENOENT) {
+        populate(object_no, gen, *extents, r);
+      }
+      ctx->complete(r);
+    });
+  return false;
+}
+
+template <typename I>
+bool ShardedObjectDispatch<I>::discard(
+    uint64_t object_no, uint64_t object_off, uint64_t object_len,
+    IOContext io_context, int discard_flags,
+    const ZTracer::Trace &parent_trace, int* object_dispatch_flags,
+    uint64_t* journal_tid, io::DispatchResult* dispatch_result,
+    Context** on_finish, Context* on_dispatched) {
+  auto cct = m_image_ctx->cct;
+  ldout(cct, 20) << data_object_name(m_image_ctx, object_no) << " "
+                 << object_off << "~" << object_len << dendl;
+
+  return dispatch_unoptimized_io(object_no, object_off, object_len,
+                                 dispatch_result, on_finish, on_dispatched);
+}
+
+template <typename I>
+bool ShardedObjectDispatch<I>::write(
+    uint64_t object_no, uint64_t object_off, ceph::bufferlist&& data,
+    IOContext io_context, int op_flags, int write_flags,
+    std::optional<uint64_t> assert_version,
+    const ZTracer::Trace &parent_trace, int* object_dispatch_flags,
+    uint64_t* journal_tid, io::DispatchResult* dispatch_result,
+    Context**on_finish, Context* on_dispatched) {
+  auto cct = m_image_ctx->cct;
+  ldout(cct, 20) << data_object_name(m_image_ctx, object_no) << " "
+                 << object_off << "~" << data.length() << dendl;
+
+  if (m_max_dirty == 0 || data.length() == 0 || assert_version ||
+      write_flags != 0 || (op_flags & LIBRADOS_OP_FLAG_FADVISE_FUA) != 0) {
+    // write-through mode, or the OSD has to see the write as it is
+    return dispatch_unoptimized_io(object_no, object_off, data.length(),
+                                   dispatch_result, on_finish, on_dispatched);
+  }
+
+  cache_write(object_no, object_off, std::move(data), io_context,
+              dispatch_result, on_dispatched);
+  return true;
+}
+
+template <typename I>
+bool ShardedObjectDispatch<I>::write_same(
+    uint64_t object_no, uint64_t object_off, uint64_t object_len,
+    io::LightweightBufferExtents&& buffer_extents, ceph::bufferlist&& data,
+    IOContext io_context, int op_flags,
+    const ZTracer::Trace &parent_trace, int* object_dispatch_flags,
+    uint64_t* journal_tid, io::DispatchResult* dispatch_result,
+    Context**on_finish, Context* on_dispatched) {
+  auto cct = m_image_ctx->cct;
+  ldout(cct, 20) << data_object_name(m_image_ctx, object_no) << " "
+                 << object_off << "~" << object_len << dendl;
+
+  if (m_max_dirty == 0 || (op_flags & LIBRADOS_OP_FLAG_FADVISE_FUA) != 0) {
+    return dispatch_unoptimized_io(object_no, object_off, object_len,
+                                   dispatch_result, on_finish, on_dispatched);
+  }
+
+  // cache what the write-same amounts to
+  io::LightweightObjectExtent extent(object_no, object_off, object_len, 0);
+  extent.buffer_extents = std::move(buffer_extents);
+  ceph::bufferlist ws_data;
+  io::util::assemble_write_same_extent(extent, data, &ws_data, true);
+
+  cache_write(object_no, object_off, std::move(ws_data), io_context,
+              dispatch_result, on_dispatched);
+  return true;
+}
+
+template <typename I>
+bool ShardedObjectDispatch<I>::compare_and_write(
+    uint64_t object_no, uint64_t object_off, ceph::bufferlist&& cmp_data,
+    ceph::bufferlist&& write_data, IOContext io_context, int op_flags,
+    const ZTracer::Trace &parent_trace, uint64_t* mismatch_offset,
+    int* object_dispatch_flags, uint64_t* journal_tid,
+    io::DispatchResult* dispatch_result, Context** on_finish,
+    Context* on_dispatched) {
+  return dispatch_unoptimized_io(object_no, object_off, cmp_data.length(),
+                                 dispatch_result, on_finish, on_dispatched);
+}
+
+template <typename I>
+bool ShardedObjectDispatch<I>::flush(
+    io::FlushSource flush_source, const ZTracer::Trace &parent_trace,
+    uint64_t* journal_tid, io::DispatchResult* dispatch_result,
+    Context** on_finish, Context* on_dispatched) {
+  auto cct = m_image_ctx->cct;
+  ldout(cct, 20) << dendl;
+
+  {
+    std::lock_guard locker{m_lock};
+    if (flush_source == io::FLUSH_SOURCE_USER && !m_user_flushed) {
+      m_user_flushed = true;
+      if (m_max_dirty == 0 && m_init_max_dirty > 0) {
+        ldout(cct, 5) << "first user flush: enabling write-back" << dendl;
+        m_max_dirty = m_init_max_dirty;
+      }
+    }
+
+    uint64_t seq = m_last_seq;
+    if (get_min_unclean_seq() > seq) {
+      if (m_flush_error == 0) {
+        // nothing dirty
+        return false;
+      }
+
+      // report the writeback that failed since the last flush
+      int r = 0;
+      std::swap(r, m_flush_error);
+      *dispatch_result = io::DISPATCH_RESULT_CONTINUE;
+      on_dispatched = util::create_async_context_callback(*m_image_ctx,
+                                                          on_dispatched);
+      on_dispatched->complete(r);
+      return true;
+    }
+
+    ldout(cct, 20) << "waiting for seq=" << seq << dendl;
+    *dispatch_result = io::DISPATCH_RESULT_CONTINUE;
+    m_flush_waiters[seq].push_back(
+      util::create_async_context_callback(*m_image_ctx, on_dispatched));
+  }
+
+  Writebacks writebacks;
+  writeback_all(&writebacks);
+  send_writebacks(writebacks);
+
+  check_flushes();
+  return true;
+}
+
+template <typename I>
+bool ShardedObjectDispatch<I>::invalidate_cache(Context* on_finish) {
+  auto cct = m_image_ctx->cct;
+  ldout(cct, 5) << dendl;
+
+  on_finish = util::create_async_context_callback(*m_image_ctx, on_finish);
+  flush_all(new LambdaContext([this, on_finish](int r) {
+      // drop everything written back, the dirty data left failed to be
+      for (auto& shard : m_shards) {
+        std::unique_lock locker{shard->lock};
+        for (auto it = shard->objects.begin();
+             it != shard->objects.end();) {
+          auto& object = it->second;
+          remove_range(*shard, object, 0, UINT64_MAX, false);
+          object.gen = ++m_last_gen;
+          update_lists(*shard, it->first, object);
+          it = trim_object(*shard, it);
+        }
+      }
+      on_finish->complete(r);
+    }));
+  return true;
+}
+
+template <typename I>
+bool ShardedObjectDispatch<I>::lookup(
+    const Object& object, uint64_t off, uint64_t len,
+    ceph::bufferlist* bl) const {
+  uint64_t end = off + len;
+  auto it = object.extents.upper_bound(off);
+  if (it == object.extents.begin()) {
+    return false;
+  }
+  --it;
+
+  uint64_t pos = off;
+  while (pos < end) {
+    if (it == object.extents.end() || it->first > pos) {
+      return false;
+    }
+    uint64_t extent_end = it->first + it->second.bl.length();
+    if (extent_end <= pos) {
+      return false;
+    }
+
+    uint64_t n = std::min(end, extent_end) - pos;
+    ceph::bufferlist sub;
+    sub.substr_of(it->second.bl, pos - it->first, n);
+    bl->claim_append(sub);
+    pos += n;
+    ++it;
+  }
+  return true;
+}
+
+template <typename I>
+bool ShardedObjectDispatch<I>::intersects_dirty(
+    const Object& object, uint64_t off, uint64_t len) const {
+  uint64_t end = off + len;
+  auto it = object.extents.upper_bound(off);
+  if (it != object.extents.begin()) {
+    auto prev = std::prev(it);
+    if (prev->first + prev->second.bl.length() > off) {
+      it = prev;
+    }
+  }
+  for (; it != object.extents.end() && it->first < end; ++it) {
+    if (it->second.dirty()) {
+      return true;
+    }
+  }
+  return false;
+}
+
+template <typename I>
+void ShardedObjectDispatch<I>::remove_range(
+    Shard& shard, Object& object, uint64_t off, uint64_t len, bool dirty) {
+  uint64_t end = len > UINT64_MAX - off ? UINT64_MAX : off + len;
+  auto it = object.extents.upper_bound(off);
+  if (it != object.extents.begin()) {
+    auto prev = std::prev(it);
+    if (prev->first + prev->second.bl.length() > off) {
+      it = prev;
+    }
+  }
+
+  while (it != object.extents.end() && it->first < end) {
+    uint64_t extent_off = it->first;
+    auto& extent = it->second;
+    if (extent.dirty() && !dirty) {
+      ++it;
+      continue;
+    }
+
+    uint64_t extent_len = extent.bl.length();
+    uint64_t extent_end = extent_off + extent_len;
+    uint64_t head = off > extent_off ? off - extent_off : 0;
+    uint64_t tail = extent_end > end ? extent_end - end : 0;
+    uint64_t removed = extent_len - head - tail;
+    shard.bytes -= removed;
+
+    // a writeback in flight keeps accounting for what it writes
+    if (extent.dirty() && !extent.flushing) {
+      m_dirty_bytes -= removed;
+      if (head == 0 && tail == 0) {
+        shard.unclean.erase(shard.unclean.find(extent.seq));
+        --object.dirty_extents;
+      } else if (head > 0 && tail > 0) {
+        shard.unclean.insert(extent.seq);
+        ++object.dirty_extents;
+      }
+    }
+
+    if (tail > 0) {
+      Extent tail_extent;
+      tail_extent.bl.substr_of(extent.bl, extent_len - tail, tail);
+      tail_extent.io_context = extent.io_context;
+      tail_extent.seq = extent.seq;
+      tail_extent.flushing = extent.flushing;
+      object.extents.emplace(end, std::move(tail_extent));
+    }
+
+    if (head > 0) {
+      ceph::bufferlist head_bl;
+      head_bl.substr_of(extent.bl, 0, head);
+      extent.bl = std::move(head_bl);
+      ++it;
+    } else {
+      it = object.extents.erase(it);
+    }
+  }
+}
+
+template <typename I>
+void ShardedObjectDispatch<I>::insert(
+    Shard& shard, Object& object, uint64_t off, ceph::bufferlist&& bl,
+    IOContext io_context, uint64_t seq) {
+  uint64_t len = bl.length();
+  remove_range(shard, object, off, len, true);
+
+  Extent extent;
+  extent.bl = std::move(bl);
+  if (seq != 0) {
+    extent.io_context = io_context;
+    extent.seq = seq;
+    shard.unclean.insert(seq);
+    ++object.dirty_extents;
+    m_dirty_bytes += len;
+  }
+  object.extents.emplace(off, std::move(extent));
+  shard.bytes += len;
+}
+
+template <typename I>
+bool ShardedObjectDispatch<I>::update_lists(
+    Shard& shard, uint64_t object_no, Object& object) {
+  bool newly_dirty = false;
+  if (object.dirty_extents > 0) {
+    if (!object.on_dirty_list) {
+      object.dirty_it = shard.dirty_objects.insert(shard.dirty_objects.end(),
+                                                   object_no);
+      object.on_dirty_list = true;
+      object.dirty_stamp = ceph::coarse_mono_clock::now();
+      newly_dirty = true;
+    }
+  } else if (object.on_dirty_list) {
+    shard.dirty_objects.erase(object.dirty_it);
+    object.on_dirty_list = false;
+  }
+
+  bool clean = object.idle() && !object.extents.empty();
+  if (clean && !object.on_clean_list) {
+    object.clean_it = shard.clean_objects.insert(shard.clean_objects.end(),
+                                                 object_no);
+    object.on_clean_list = true;
+  } else if (!clean && object.on_clean_list) {
+    shard.clean_objects.erase(object.clean_it);
+    object.on_clean_list = false;
+  }
+  return newly_dirty;
+}
+
+template <typename I>
+typename ShardedObjectDispatch<I>::Objects::iterator
+ShardedObjectDispatch<I>::trim_object(Shard& shard,
+                                      typename Objects::iterator it) {
+  auto& object = it->second;
+  if (!object.idle() || !object.extents.empty()) {
+    return ++it;
+  }
+
+  // reads that started before the object went away can't populate it
+  ceph_assert(!object.on_dirty_list && !object.on_clean_list);
+  shard.trimmed_gen = std::max(shard.trimmed_gen, object.gen);
+  return shard.objects.erase(it);
+}
+
+template <typename I>
+void ShardedObjectDispatch<I>::evict(Shard& shard) {
+  while (shard.bytes > m_max_shard_bytes && !shard.clean_objects.empty()) {
+    auto it = shard.objects.find(shard.clean_objects.front());
+    ceph_assert(it != shard.objects.end());
+
+    auto& object = it->second;
+    remove_range(shard, object, 0, UINT64_MAX, false);
+    update_lists(shard, it->first, object);
+    trim_object(shard, it);
+  }
+}
+
+template <typename I>
+void ShardedObjectDispatch<I>::cache_write(
+    uint64_t object_no, uint64_t object_off, ceph::bufferlist&& data,
+    IOContext io_context, io::DispatchResult* dispatch_result,
+    Context* on_dispatched) {
+  auto cct = m_image_ctx->cct;
+  auto& shard = get_shard(object_no);
+
+  Writebacks writebacks;
+  bool newly_dirty;
+  {
+    std::unique_lock locker{shard.lock};
+    auto& object = shard.objects[object_no];
+    object.gen = ++m_last_gen;
+    insert(shard, object, object_off, std::move(data), io_context,
+           ++m_last_seq);
+    newly_dirty = update_lists(shard, object_no, object);
+
+    if (m_dirty_bytes > m_target_dirty) {
+      writeback_oldest(shard, &writebacks);
+    }
+  }
+  send_writebacks(writebacks);
+
+  if (newly_dirty) {
+    schedule_timer();
+  }
+
+  *dispatch_result = io::DISPATCH_RESULT_COMPLETE;
+  on_dispatched = util::create_async_context_callback(*m_image_ctx,
+                                                      on_dispatched);
+  if (m_dirty_bytes <= m_max_dirty) {
+    on_dispatched->complete(0);
+    return;
+  }
+
+  ldout(cct, 20) << "throttled: dirty=" << m_dirty_bytes << dendl;
+  {
+    std::lock_guard locker{m_lock};
+    m_throttled.push_back(on_dispatched);
+  }
+
+  for (auto& s : m_shards) {
+    std::unique_lock locker{s->lock};
+    writeback_oldest(*s, &writebacks);
+  }
+  send_writebacks(writebacks);
+
+  // in case the writebacks completed before the write was queued
+  check_throttled();
+}
+
+template <typename I>
+void ShardedObjectDispatch<I>::populate(
+    uint64_t object_no, uint64_t gen, const io::ReadExtents& extents, int r) {
+  auto& shard = get_shard(object_no);
+  std::unique_lock locker{shard.lock};
+
+  auto it = shard.objects.find(object_no);
+  if (it == shard.objects.end()) {
+    if (shard.trimmed_gen > gen) {
+      return;
+    }
+    it = shard.objects.emplace(object_no, Object{}).first;
+    it->second.gen = gen;
+  } else if (it->second.gen > gen) {
+    // changed while being read
+    return;
+  }
+  auto& object = it->second;
+
+  for (auto& extent : extents) {
+    uint64_t end = extent.offset + extent.length;
+
+    // sparse and short reads leave out zeroes
+    ceph::bufferlist bl;
+    if (r == -ENOENT) {
+      bl.append_zero(extent.length);
+    } else if (extent.extent_map.empty()) {
+      bl.substr_of(extent.bl, 0, std::min<uint64_t>(extent.bl.length(),
+                                                    extent.length));
+      bl.append_zero(extent.length - bl.length());
+    } else {
+      uint64_t pos = extent.offset;
+      uint64_t bl_off = 0;
+      for (auto [map_off, map_len] : extent.extent_map) {
+        if (map_off > pos) {
+          bl.append_zero(map_off - pos);
+        }
+        ceph::bufferlist sub;
+        sub.substr_of(extent.bl, bl_off, map_len);
+        bl.claim_append(sub);
+        bl_off += map_len;
+        pos = map_off + map_len;
+      }
+      if (pos < end) {
+        bl.append_zero(end - pos);
+      }
+    }
+
+    // fill the holes only, what is there is at least as recent
+    uint64_t pos = extent.offset;
+    while (pos < end) {
+      auto next = object.extents.upper_bound(pos);
+      if (next != object.extents.begin()) {
+        auto prev = std::prev(next);
+        uint64_t prev_end = prev->first + prev->second.bl.length();
+        if (prev_end > pos) {
+          pos = prev_end;
+          continue;
+        }
+      }
+
+      uint64_t hole_end = next == object.extents.end() ?
+        end : std::min(end, next->first);
+      ceph::bufferlist sub;
+      sub.substr_of(bl, pos - extent.offset, hole_end - pos);
+      insert(shard, object, pos, std::move(sub), {}, 0);
+      pos = hole_end;
+    }
+  }
+
+  update_lists(shard, object_no, object);
+  trim_object(shard, it);
+  evict(shard);
+}
+
+template <typename I>
+void ShardedObjectDispatch<I>::writeback(
+    Shard& shard, uint64_t object_no, Object& object,
+    Writebacks* writebacks) {
+  if (object.in_flight > 0 || object.unoptimized_io > 0) {
+    // once what is in flight completes
+    object.writeback_pending = true;
+    return;
+  }
+  object.writeback_pending = false;
+  if (object.dirty_extents == 0) {
+    return;
+  }
+
+  auto cct = m_image_ctx->cct;
+  ldout(cct, 20) << data_object_name(m_image_ctx, object_no) << dendl;
+
+  uint64_t run_off = 0;
+  ceph::bufferlist run_bl;
+  IOContext run_io_context;
+  auto send_run = [&]() {
+    if (run_bl.length() == 0) {
+      return;
+    }
+    ++object.in_flight;
+    auto ctx = new LambdaContext([this, object_no](int r) {
+        handle_writeback(r, object_no);
+      });
+    auto req = io::ObjectDispatchSpec::create_write(
+      m_image_ctx, io::OBJECT_DISPATCH_LAYER_CACHE, object_no, run_off,
+      std::move(run_bl), run_io_context, 0, 0, std::nullopt, 0, {}, ctx);
+    req->object_dispatch_flags = (
+      io::OBJECT_DISPATCH_FLAG_FLUSH |
+      io::OBJECT_DISPATCH_FLAG_WILL_RETRY_ON_ERROR);
+    writebacks->push_back(req);
+    run_bl.clear();
+  };
+
+  // one write per contiguous run of dirty data of the same snap context
+  for (auto& [off, extent] : object.extents) {
+    if (!extent.dirty()) {
+      send_run();
+      continue;
+    }
+    if (run_bl.length() > 0 &&
+        (run_off + run_bl.length() != off ||
+         run_io_context != extent.io_context)) {
+      send_run();
+    }
+    if (run_bl.length() == 0) {
+      run_off = off;
+      run_io_context = extent.io_context;
+    }
+    run_bl.append(extent.bl);
+
+    extent.flushing = true;
+    object.flushing_seqs.push_back(extent.seq);
+    object.flushing_bytes += extent.bl.length();
+  }
+  send_run();
+
+  object.dirty_extents = 0;
+  update_lists(shard, object_no, object);
+}
+
+template <typename I>
+void ShardedObjectDispatch<I>::writeback_oldest(Shard& shard,
+                                                Writebacks* writebacks) {
+  for (auto object_no : shard.dirty_objects) {
+    auto& object = shard.objects[object_no];
+    if (object.in_flight == 0 && object.unoptimized_io == 0) {
+      writeback(shard, object_no, object, writebacks);
+      return;
+    }
+  }
+}
+
+template <typename I>
+void ShardedObjectDispatch<I>::writeback_all(Writebacks* writebacks) {
+  for (auto& shard : m_shards) {
+    std::unique_lock locker{shard->lock};
+    std::vector<uint64_t> object_nos{shard->dirty_objects.begin(),
+                                     shard->dirty_objects.end()};
+    for (auto object_no : object_nos) {
+      writeback(*shard, object_no, shard->objects[object_no], writebacks);
+    }
+  }
+}
+
+template <typename I>
+void ShardedObjectDispatch<I>::send_writebacks(Writebacks& writebacks) {
+  for (auto req : writebacks) {
+    req->send();
+  }
+  writebacks.clear();
+}
+
+template <typename I>
+void ShardedObjectDispatch<I>::handle_writeback(int r, uint64_t object_no) {
+  auto cct = m_image_ctx->cct;
+  ldout(cct, 20) << data_object_name(m_image_ctx, object_no) << ", r=" << r
+                 << dendl;
+
+  auto& shard = get_shard(object_no);
+  Writebacks writebacks;
+  Contexts waiters;
+  bool dirty;
+  {
+    std::unique_lock locker{shard.lock};
+    auto it = shard.objects.find(object_no);
+    ceph_assert(it != shard.objects.end());
+
+    auto& object = it->second;
+    if (r < 0 && object.writeback_r == 0) {
+      object.writeback_r = r;
+    }
+    ceph_assert(object.in_flight > 0);
+    if (--object.in_flight > 0) {
+      return;
+    }
+    r = object.writeback_r;
+    object.writeback_r = 0;
+
+    for (auto& [off, extent] : object.extents) {
+      if (!extent.flushing) {
+        continue;
+      }
+      extent.flushing = false;
+      if (r < 0) {
+        // still dirty, retried later
+        shard.unclean.insert(extent.seq);
+        ++object.dirty_extents;
+        m_dirty_bytes += extent.bl.length();
+      } else {
+        extent.seq = 0;
+        extent.io_context.reset();
+      }
+    }
+    for (auto seq : object.flushing_seqs) {
+      shard.unclean.erase(shard.unclean.find(seq));
+    }
+    m_dirty_bytes -= object.flushing_bytes;
+    object.flushing_seqs.clear();
+    object.flushing_bytes = 0;
+
+    if (r < 0) {
+      lderr(cct) << "failed to write back "
+                 << data_object_name(m_image_ctx, object_no) << ": "
+                 << cpp_strerror(r) << dendl;
+      object.writeback_pending = false;
+    } else if (object.writeback_pending || !object.waiters.empty()) {
+      writeback(shard, object_no, object, &writebacks);
+    }
+    if (object.in_flight == 0) {
+      waiters.swap(object.waiters);
+    }
+
+    dirty = object.dirty_extents > 0;
+    update_lists(shard, object_no, object);
+    trim_object(shard, it);
+    evict(shard);
+  }
+
+  if (r < 0) {
+    std::lock_guard locker{m_lock};
+    if (m_flush_error == 0) {
+      m_flush_error = r;
+    }
+  }
+
+  send_writebacks(writebacks);
+  for (auto ctx : waiters) {
+    ctx->complete(r);
+  }
+
+  check_throttled();
+  check_flushes();
+  if (dirty) {
+    schedule_timer();
+  }
+}
+
+template <typename I>
+bool ShardedObjectDispatch<I>::wait_for_writeback(
+    uint64_t object_no, io::DispatchResult* dispatch_result,
+    Context* on_dispatched) {
+  auto cct = m_image_ctx->cct;
+  auto& shard = get_shard(object_no);
+
+  Writebacks writebacks;
+  {
+    std::unique_lock locker{shard.lock};
+    auto it = shard.objects.find(object_no);
+    if (it == shard.objects.end() ||
+        (it->second.dirty_extents == 0 && it->second.in_flight == 0)) {
+      return false;
+    }
+
+    ldout(cct, 20) << "waiting for the writeback of "
+                   << data_object_name(m_image_ctx, object_no) << dendl;
+    auto& object = it->second;
+    *dispatch_result = io::DISPATCH_RESULT_CONTINUE;
+    object.waiters.push_back(
+      util::create_async_context_callback(*m_image_ctx, on_dispatched));
+    writeback(shard, object_no, object, &writebacks);
+    update_lists(shard, object_no, object);
+  }
+  send_writebacks(writebacks);
+  return true;
+}
+
+template <typename I>
+bool ShardedObjectDispatch<I>::dispatch_unoptimized_io(
+    uint64_t object_no, uint64_t object_off, uint64_t object_len,
+    io::DispatchResult* dispatch_result, Context** on_finish,
+    Context* on_dispatched) {
+  auto cct = m_image_ctx->cct;
+  auto& shard = get_shard(object_no);
+
+  // whatever got cached while the IO was in flight is stale
+  auto ctx = *on_finish;
+  *on_finish = new LambdaContext(
+    [this, object_no, object_off, object_len, ctx](int r) {
+      handle_unoptimized_io(object_no, object_off, object_len);
+      ctx->complete(r);
+    });
+  *dispatch_result = io::DISPATCH_RESULT_CONTINUE;
+
+  Writebacks writebacks;
+  {
+    std::unique_lock locker{shard.lock};
+    auto& object = shard.objects[object_no];
+    if (object.dirty_extents == 0 && object.in_flight == 0) {
+      ++object.unoptimized_io;
+      invalidate_range(shard, object, object_off, object_len);
+      update_lists(shard, object_no, object);
+      return false;
+    }
+
+    // the dirty data goes first
+    ldout(cct, 20) << "waiting for the writeback of "
+                   << data_object_name(m_image_ctx, object_no) << dendl;
+    on_dispatched = util::create_async_context_callback(*m_image_ctx,
+                                                        on_dispatched);
+    object.waiters.push_back(new LambdaContext(
+      [this, object_no, object_off, object_len, on_dispatched](int r) {
+        auto& shard = get_shard(object_no);
+        {
+          std::unique_lock locker{shard.lock};
+          auto& object = shard.objects[object_no];
+          ++object.unoptimized_io;
+          invalidate_range(shard, object, object_off, object_len);
+          update_lists(shard, object_no, object);
+        }
+        on_dispatched->complete(r);
+      }));
+    writeback(shard, object_no, object, &writebacks);
+    update_lists(shard, object_no, object);
+  }
+  send_writebacks(writebacks);
+  return true;
+}
+
+template <typename I>
+void ShardedObjectDispatch<I>::handle_unoptimized_io(
+    uint64_t object_no, uint64_t object_off, uint64_t object_len) {
+  auto& shard = get_shard(object_no);
+
+  Writebacks writebacks;
+  Contexts waiters;
+  {
+    std::unique_lock locker{shard.lock};
+    auto it = shard.objects.find(object_no);
+    ceph_assert(it != shard.objects.end());
+
+    auto& object = it->second;
+    ceph_assert(object.unoptimized_io > 0);
+    --object.unoptimized_io;
+    invalidate_range(shard, object, object_off, object_len);
+
+    if (object.unoptimized_io == 0 &&
+        (object.writeback_pending || !object.waiters.empty())) {
+      writeback(shard, object_no, object, &writebacks);
+    }
+    if (object.in_flight == 0 && object.dirty_extents == 0) {
+      waiters.swap(object.waiters);
+    }
+
+    update_lists(shard, object_no, object);
+    trim_object(shard, it);
+  }
+
+  send_writebacks(writebacks);
+  for (auto ctx : waiters) {
+    ctx->complete(0);
+  }
+}
+
+template <typename I>
+void ShardedObjectDispatch<I>::invalidate_range(
+    Shard& shard, Object& object, uint64_t object_off, uint64_t object_len) {
+  remove_range(shard, object, object_off, object_len, false);
+  object.gen = ++m_last_gen;
+}
+
+template <typename I>
+uint64_t ShardedObjectDispatch<I>::get_min_unclean_seq() {
+  ceph_assert(ceph_mutex_is_locked(m_lock));
+
+  uint64_t min_seq = UINT64_MAX;
+  for (auto& shard : m_shards) {
+    std::shared_lock locker{shard->lock};
+    if (!shard->unclean.empty()) {
+      min_seq = std::min(min_seq, *shard->unclean.begin());
+    }
+  }
+  return min_seq;
+}
+
+template <typename I>
+void ShardedObjectDispatch<I>::flush_all(Context* on_finish) {
+  {
+    std::unique_lock locker{m_lock};
+    uint64_t seq = m_last_seq;
+    if (get_min_unclean_seq() > seq) {
+      int r = 0;
+      std::swap(r, m_flush_error);
+      locker.unlock();
+
+      on_finish->complete(r);
+      return;
+    }
+    m_flush_waiters[seq].push_back(on_finish);
+  }
+
+  Writebacks writebacks;
+  writeback_all(&writebacks);
+  send_writebacks(writebacks);
+
+  check_flushes();
+}
+
+template <typename I>
+void ShardedObjectDispatch<I>::check_flushes() {
+  auto cct = m_image_ctx->cct;
+
+  Contexts ctxs;
+  int r = 0;
+  {
+    std::lock_guard locker{m_lock};
+    if (m_flush_waiters.empty()) {
+      return;
+    }
+
+    if (m_flush_error < 0) {
+      // fail all the flushes waiting, the dirty data is retried later
+      std::swap(r, m_flush_error);
+      for (auto& [seq, waiters] : m_flush_waiters) {
+        ctxs.splice(ctxs.end(), waiters);
+      }
+      m_flush_waiters.clear();
+    } else {
+      auto min_seq = get_min_unclean_seq();
+      for (auto it = m_flush_waiters.begin();
+           it != m_flush_waiters.end() && it->first < min_seq;
+           it = m_flush_waiters.erase(it)) {
+        ctxs.splice(ctxs.end(), it->second);
+      }
+    }
+  }
+
+  if (!ctxs.empty()) {
+    ldout(cct, 20) << "completing " << ctxs.size() << " flushes: r=" << r
+                   << dendl;
+  }
+  for (auto ctx : ctxs) {
+    ctx->complete(r);
+  }
+}
+
+template <typename I>
+void ShardedObjectDispatch<I>::check_throttled() {
+  Contexts ctxs;
+  {
+    std::lock_guard locker{m_lock};
+    if (m_throttled.empty() || m_dirty_bytes > m_max_dirty) {
+      return;
+    }
+    ctxs.swap(m_throttled);
+  }
+
+  for (auto ctx : ctxs) {
+    ctx->complete(0);
+  }
+}
+
+template <typename I>
+void ShardedObjectDispatch<I>::schedule_timer() {
+  auto cct = m_image_ctx->cct;
+
+  std::lock_guard timer_locker{*m_timer_lock};
+  if (m_shutting_down || m_timer_task != nullptr || m_max_dirty_age <= 0) {
+    return;
+  }
+
+  m_timer_task = new LambdaContext([this](int r) {
+      ceph_assert(ceph_mutex_is_locked(*m_timer_lock));
+      auto cct = m_image_ctx->cct;
+      ldout(cct, 20) << "running timer task " << m_timer_task << dendl;
+
+      m_timer_task = nullptr;
+      m_image_ctx->asio_engine->post([this]() { handle_timer(); });
+    });
+
+  ldout(cct, 20) << "scheduling task " << m_timer_task << " after "
+                 << m_max_dirty_age << "s" << dendl;
+  m_timer->add_event_after(m_max_dirty_age, m_timer_task);
+}
+
+template <typename I>
+void ShardedObjectDispatch<I>::handle_timer() {
+  auto now = ceph::coarse_mono_clock::now();
+  auto max_age = ceph::make_timespan(m_max_dirty_age);
+
+  // the dirty lists are in the order the objects got dirty
+  Writebacks writebacks;
+  for (auto& shard : m_shards) {
+    std::unique_lock locker{shard->lock};
+    std::vector<uint64_t> object_nos;
+    for (auto object_no : shard->dirty_objects) {
+      if (shard->objects[object_no].dirty_stamp + max_age > now) {
+        break;
+      }
+      object_nos.push_back(object_no);
+    }
+    for (auto object_no : object_nos) {
+      writeback(*shard, object_no, shard->objects[object_no], &writebacks);
+    }
+  }
+  send_writebacks(writebacks);
+
+  if (m_dirty_bytes > 0) {
+    schedule_timer();
+  }
+}
+
+} // namespace cache
+} // namespace librbd
+
+template class librbd::cache::ShardedObjectDispatch<librbd::ImageCtx>;
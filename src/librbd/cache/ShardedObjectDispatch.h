@@ -0,0 +1,274 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+
+#ifndef CEPH_LIBRBD_CACHE_SHARDED_OBJECT_DISPATCH_H
+#define CEPH_LIBRBD_CACHE_SHARDED_OBJECT_DISPATCH_H
+
+#include "librbd/io/ObjectDispatchInterface.h"
+#include "common/ceph_mutex.h"
+#include "common/ceph_time.h"
+#include "librbd/io/Types.h"
+#include "librbd/io/TypeTraits.h"
+#include <atomic>
+#include <list>
+#include <map>
+#include <memory>
+#include <set>
+#include <vector>
+
+struct Context;
+
+namespace librbd {
+
+struct ImageCtx;
+
+namespace io {
+struct ObjectDispatchSpec;
+} // namespace io
+
+namespace cache {
+
+/**
+ * In-memory write-back cache of the image objects, in front of the
+ * object dispatch layers below it.
+ *
+ * Objects are spread over several shards, each with its own lock, so
+ * that IO to different objects doesn't serialize on one cache lock.
+ * Reads fully covered by cached data complete from the cache holding
+ * the shard lock shared only; the rest go down the dispatch chain and,
+ * once read, populate the cache.  Writes are cached dirty and complete
+ * right away, unless more than max_dirty bytes are dirty.  All the dirty
+ * extents of an object are written back together, one write per
+ * contiguous run, once the cache holds more than target_dirty bytes,
+ * after max_dirty_age, or on flush.  Clean objects are evicted in the
+ * order they became clean, so that hits don't need to update anything.
+ */
+template <typename ImageCtxT = ImageCtx>
+class ShardedObjectDispatch : public io::ObjectDispatchInterface {
+private:
+  // mock unit testing support
+  typedef ::librbd::io::TypeTraits<ImageCtxT> TypeTraits;
+  typedef typename TypeTraits::SafeTimer SafeTimer;
+public:
+  static ShardedObjectDispatch* create(ImageCtxT* image_ctx,
+                                       size_t max_dirty,
+                                       bool writethrough_until_flush) {
+    return new ShardedObjectDispatch(image_ctx, max_dirty,
+                                     writethrough_until_flush);
+  }
+
+  ShardedObjectDispatch(ImageCtxT* image_ctx, size_t max_dirty,
+                        bool writethrough_until_flush);
+  ~ShardedObjectDispatch() override;
+
+  io::ObjectDispatchLayer get_dispatch_layer() const override {
+    return io::OBJECT_DISPATCH_LAYER_CACHE;
+  }
+
+  void init();
+  void shut_down(Context* on_finish) override;
+
+  bool read(
+      uint64_t object_no, io::ReadExtents* extents, IOContext io_context,
+      int op_flags, int read_flags, const ZTracer::Trace &parent_trace,
+      uint64_t* version, int* object_dispatch_flags,
+      io::DispatchResult* dispatch_result, Context** on_finish,
+      Context* on_dispatched) override;
+
+  bool discard(
+      uint64_t object_no, uint64_t object_off, uint64_t object_len,
+      IOContext io_context, int discard_flags,
+      const ZTracer::Trace &parent_trace, int* object_dispatch_flags,
+      uint64_t* journal_tid, io::DispatchResult* dispatch_result,
+      Context**on_finish, Context* on_dispatched) override;
+
+  bool write(
+      uint64_t object_no, uint64_t object_off, ceph::bufferlist&& data,
+      IOContext io_context, int op_flags, int write_flags,
+      std::optional<uint64_t> assert_version,
+      const ZTracer::Trace &parent_trace, int* object_dispatch_flags,
+      uint64_t* journal_tid, io::DispatchResult* dispatch_result,
+      Context**on_finish, Context* on_dispatched) override;
+
+  bool write_same(
+      uint64_t object_no, uint64_t object_off, uint64_t object_len,
+      io::LightweightBufferExtents&& buffer_extents, ceph::bufferlist&& data,
+      IOContext io_context, int op_flags,
+      const ZTracer::Trace &parent_trace, int* object_dispatch_flags,
+      uint64_t* journal_tid, io::DispatchResult* dispatch_result,
+      Context**on_finish, Context* on_dispatched) override;
+
+  bool compare_and_write(
+      uint64_t object_no, uint64_t object_off, ceph::bufferlist&& cmp_data,
+      ceph::bufferlist&& write_data, IOContext io_context, int op_flags,
+      const ZTracer::Trace &parent_trace, uint64_t* mismatch_offset,
+      int* object_dispatch_flags, uint64_t* journal_tid,
+      io::DispatchResult* dispatch_result, Context** on_finish,
+      Context* on_dispatched) override;
+
+  bool flush(
+      io::FlushSource flush_source, const ZTracer::Trace &parent_trace,
+      uint64_t* journal_tid, io::DispatchResult* dispatch_result,
+      Context** on_finish, Context* on_dispatched) override;
+
+  bool list_snaps(
+      uint64_t object_no, io::Extents&& extents, io::SnapIds&& snap_ids,
+      int list_snap_flags, const ZTracer::Trace &parent_trace,
+      io::SnapshotDelta* snapshot_delta, int* object_dispatch_flags,
+      io::DispatchResult* dispatch_result, Context** on_finish,
+      Context* on_dispatched) override {
+    return false;
+  }
+
+  bool invalidate_cache(Context* on_finish) override;
+
+  bool reset_existence_cache(Context* on_finish) override {
+    return false;
+  }
+
+  void extent_overwritten(
+      uint64_t object_no, uint64_t object_off, uint64_t object_len,
+      uint64_t journal_tid, uint64_t new_journal_tid) override {
+  }
+
+  int prepare_copyup(
+      uint64_t object_no,
+      io::SnapshotSparseBufferlist* snapshot_sparse_bufferlist) override {
+    return 0;
+  }
+
+private:
+  typedef std::list<Context*> Contexts;
+  typedef std::vector<io::ObjectDispatchSpec*> Writebacks;
+
+  struct Extent {
+    ceph::bufferlist bl;
+    IOContext io_context;   ///< of the write, while dirty
+    uint64_t seq = 0;       ///< of the write, 0 once clean
+    bool flushing = false;  ///< part of the writeback in flight
+
+    bool dirty() const {
+      return seq != 0;
+    }
+  };
+  typedef std::map<uint64_t, Extent> Extents;
+
+  struct Object {
+    Extents extents;
+    uint64_t gen = 0;             ///< bumped whenever the data changes
+    uint64_t dirty_extents = 0;   ///< dirty extents not being written back
+    uint64_t in_flight = 0;       ///< writes of the writeback in flight
+    uint64_t unoptimized_io = 0;  ///< IO passed down uncached, in flight
+    bool writeback_pending = false;
+    int writeback_r = 0;
+
+    /// seqs and bytes the writeback in flight holds in the dirty accounting
+    std::vector<uint64_t> flushing_seqs;
+    uint64_t flushing_bytes = 0;
+
+    Contexts waiters;             ///< for the dirty data to be written back
+
+    bool on_dirty_list = false;
+    std::list<uint64_t>::iterator dirty_it;
+    ceph::coarse_mono_time dirty_stamp;
+    bool on_clean_list = false;
+    std::list<uint64_t>::iterator clean_it;
+
+    bool idle() const {
+      return dirty_extents == 0 && in_flight == 0 && unoptimized_io == 0 &&
+             waiters.empty();
+    }
+  };
+  typedef std::map<uint64_t, Object> Objects;
+
+  struct alignas(64) Shard {
+    ceph::shared_mutex lock = ceph::make_shared_mutex(
+      "librbd::cache::ShardedObjectDispatch::Shard::lock");
+    Objects objects;
+    std::list<uint64_t> dirty_objects;  ///< oldest dirty first
+    std::list<uint64_t> clean_objects;  ///< idle objects, eviction order
+    std::multiset<uint64_t> unclean;    ///< seqs of the dirty extents
+    uint64_t bytes = 0;
+    uint64_t trimmed_gen = 0;           ///< newest gen of evicted objects
+  };
+
+  ImageCtxT* m_image_ctx;
+  size_t m_init_max_dirty;
+  std::atomic<uint64_t> m_max_dirty;
+  uint64_t m_target_dirty;
+  uint64_t m_max_shard_bytes;
+  double m_max_dirty_age;
+
+  std::vector<std::unique_ptr<Shard>> m_shards;
+  std::atomic<uint64_t> m_last_seq = {0};
+  std::atomic<uint64_t> m_last_gen = {0};
+  std::atomic<uint64_t> m_dirty_bytes = {0};
+
+  ceph::mutex m_lock;                   ///< taken before any shard lock
+  bool m_user_flushed = false;
+  std::map<uint64_t, Contexts> m_flush_waiters;  ///< by seq
+  int m_flush_error = 0;
+  Contexts m_throttled;                 ///< writes waiting for dirty room
+
+  SafeTimer* m_timer = nullptr;
+  ceph::mutex* m_timer_lock = nullptr;
+  Context* m_timer_task = nullptr;      ///< protected by m_timer_lock
+  bool m_shutting_down = false;         ///< protected by m_timer_lock
+
+  Shard& get_shard(uint64_t object_no) {
+    return *m_shards[object_no % m_shards.size()];
+  }
+
+  bool lookup(const Object& object, uint64_t off, uint64_t len,
+              ceph::bufferlist* bl) const;
+  bool intersects_dirty(const Object& object, uint64_t off,
+                        uint64_t len) const;
+  void remove_range(Shard& shard, Object& object, uint64_t off,
+                    uint64_t len, bool dirty);
+  void insert(Shard& shard, Object& object, uint64_t off,
+              ceph::bufferlist&& bl, IOContext io_context, uint64_t seq);
+  bool update_lists(Shard& shard, uint64_t object_no, Object& object);
+  typename Objects::iterator trim_object(Shard& shard,
+                                         typename Objects::iterator it);
+  void evict(Shard& shard);
+
+  void cache_write(uint64_t object_no, uint64_t object_off,
+                   ceph::bufferlist&& data, IOContext io_context,
+                   io::DispatchResult* dispatch_result,
+                   Context* on_dispatched);
+  void populate(uint64_t object_no, uint64_t gen,
+                const io::ReadExtents& extents, int r);
+
+  void writeback(Shard& shard, uint64_t object_no, Object& object,
+                 Writebacks* writebacks);
+  void writeback_oldest(Shard& shard, Writebacks* writebacks);
+  void writeback_all(Writebacks* writebacks);
+  void send_writebacks(Writebacks& writebacks);
+  void handle_writeback(int r, uint64_t object_no);
+
+  bool wait_for_writeback(uint64_t object_no,
+                          io::DispatchResult* dispatch_result,
+                          Context* on_dispatched);
+  bool dispatch_unoptimized_io(uint64_t object_no, uint64_t object_off,
+                               uint64_t object_len,
+                               io::DispatchResult* dispatch_result,
+                               Context** on_finish, Context* on_dispatched);
+  void handle_unoptimized_io(uint64_t object_no, uint64_t object_off,
+                             uint64_t object_len);
+  void invalidate_range(Shard& shard, Object& object, uint64_t object_off,
+                        uint64_t object_len);
+
+  uint64_t get_min_unclean_seq();
+  void flush_all(Context* on_finish);
+  void check_flushes();
+  void check_throttled();
+  void schedule_timer();
+  void handle_timer();
+};
+
+} // namespace cache
+} // namespace librbd
+
+extern template class librbd::cache::ShardedObjectDispatch<librbd::ImageCtx>;
+
+#endif // CEPH_LIBRBD_CACHE_SHARDED_OBJECT_DISPATCH_H
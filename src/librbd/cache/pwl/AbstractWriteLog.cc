@@ -1282,7 +1282,6 @@ void AbstractWriteLog<I>::complete_op_log_entries(GenericLogOperations &&ops,
   int published_reserves = 0;
   ldout(m_image_ctx.cct, 20) << __func__ << ": completing" << dendl;
   for (auto &op : ops) {
-    utime_t now = ceph_clock_now();
     auto log_entry = op->get_log_entry();
     log_entry->completed = true;
     if (op->is_writing_op()) {
@@ -1295,11 +1294,17 @@ void AbstractWriteLog<I>::complete_op_log_entries(GenericLogOperations &&ops,
     if (op->reserved_allocated()) {
       published_reserves++;
     }
-    {
-      std::lock_guard locker(m_lock);
-      m_unpublished_reserves -= published_reserves;
-      m_dirty_log_entries.splice(m_dirty_log_entries.end(), dirty_entries);
-    }
+  }
+  /* Publish the whole batch at once, so appenders and writers don't contend
+   * for m_lock once per op; every entry is dirty before its op completes */
+  {
+    std::lock_guard locker(m_lock);
+    m_unpublished_reserves -= published_reserves;
+    m_dirty_log_entries.splice(m_dirty_log_entries.end(), dirty_entries);
+  }
+  for (auto &op : ops) {
+    utime_t now = ceph_clock_now();
+    auto log_entry = op->get_log_entry();
     op->complete(result);
     m_perfcounter->tinc(l_librbd_pwl_log_op_dis_to_app_t,
                         op->log_append_time - op->dispatch_time);
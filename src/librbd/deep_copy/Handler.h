@@ -5,6 +5,7 @@
 #define CEPH_LIBRBD_DEEP_COPY_HANDLER_H
 
 #include "include/int_types.h"
+#include "include/Context.h"
 #include "include/rbd/librbd.hpp"
 
 namespace librbd {
@@ -15,6 +16,11 @@ struct Handler {
 
   virtual void handle_read(uint64_t bytes_read) = 0;
 
+  /// complete @p on_ready once @p bytes of the source image may be read
+  virtual void throttle_read(uint64_t bytes, Context* on_ready) {
+    on_ready->complete(0);
+  }
+
   virtual int update_progress(uint64_t object_number,
                               uint64_t object_count) = 0;
 };
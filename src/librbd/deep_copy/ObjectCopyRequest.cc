@@ -4,6 +4,7 @@
 #include "ObjectCopyRequest.h"
 #include "include/neorados/RADOS.hpp"
 #include "common/errno.h"
+#include "include/intarith.h"
 #include "librados/snap_set_diff.h"
 #include "librbd/ExclusiveLock.h"
 #include "librbd/ObjectMap.h"
@@ -146,6 +147,22 @@ void ObjectCopyRequest<I>::send_read() {
     return;
   }
 
+  if (m_handler != nullptr) {
+    auto ctx = new LambdaContext([this](int r) {
+        send_read_object();
+      });
+    m_handler->throttle_read(read_op.image_interval.size(), ctx);
+    return;
+  }
+
+  send_read_object();
+}
+
+template <typename I>
+void ObjectCopyRequest<I>::send_read_object() {
+  auto index = *m_read_snaps.begin();
+  auto& read_op = m_read_ops[index];
+
   auto io_context = m_src_image_ctx->duplicate_data_io_context();
   io_context->read_snap(index.second);
 
@@ -575,9 +592,16 @@ template <typename I>
 void ObjectCopyRequest<I>::merge_write_ops() {
   ldout(m_cct, 20) << dendl;
 
+  uint64_t sparse_size = m_dst_image_ctx->config.template get_val<
+    Option::size_t>("rbd_deep_copy_sparse_size");
   for (auto& [write_read_snap_ids, read_op] : m_read_ops) {
     auto src_snap_seq = write_read_snap_ids.first;
 
+    if (sparse_size > 0) {
+      // the zeroed data falls out of the extent map, and so is zeroed below
+      skip_zeroed_data(sparse_size, &read_op);
+    }
+
     // convert the the resulting sparse image extent map to an interval ...
     auto& image_data_interval = m_dst_data_interval[src_snap_seq];
     for (auto [image_offset, image_length] : read_op.image_extent_map) {
@@ -623,6 +647,42 @@ void ObjectCopyRequest<I>::merge_write_ops() {
   }
 }
 
+template <typename I>
+void ObjectCopyRequest<I>::skip_zeroed_data(uint64_t sparse_size,
+                                            ReadOp* read_op) {
+  io::Extents image_extent_map;
+  bufferlist out_bl;
+  uint64_t buffer_offset = 0;
+  for (auto [image_offset, image_length] : read_op->image_extent_map) {
+    uint64_t off = image_offset;
+    uint64_t end = image_offset + image_length;
+    while (off < end) {
+      uint64_t len = std::min(p2align(off, sparse_size) + sparse_size, end) -
+                     off;
+      bufferlist bl;
+      bl.substr_of(read_op->out_bl, buffer_offset, len);
+      if (bl.is_zero()) {
+        ldout(m_cct, 20) << "skipping zeroed data " << off << "~" << len
+                         << dendl;
+      } else {
+        if (!image_extent_map.empty() &&
+            image_extent_map.back().first +
+              image_extent_map.back().second == off) {
+          image_extent_map.back().second += len;
+        } else {
+          image_extent_map.emplace_back(off, len);
+        }
+        out_bl.claim_append(bl);
+      }
+      buffer_offset += len;
+      off += len;
+    }
+  }
+
+  read_op->image_extent_map = std::move(image_extent_map);
+  read_op->out_bl = std::move(out_bl);
+}
+
 template <typename I>
 void ObjectCopyRequest<I>::compute_zero_ops() {
   ldout(m_cct, 20) << dendl;
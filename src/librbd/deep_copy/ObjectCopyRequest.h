@@ -134,6 +134,7 @@ private:
   void handle_list_snaps(int r);
 
   void send_read();
+  void send_read_object();
   void handle_read(int r);
 
   void send_update_object_map();
@@ -147,6 +148,7 @@ private:
 
   void compute_read_ops();
   void merge_write_ops();
+  void skip_zeroed_data(uint64_t sparse_size, ReadOp* read_op);
   void compute_zero_ops();
 
   void compute_dst_object_may_exist();
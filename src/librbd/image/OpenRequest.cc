@@ -10,6 +10,7 @@
 #include "librbd/PluginRegistry.h"
 #include "librbd/Utils.h"
 #include "librbd/cache/ObjectCacherObjectDispatch.h"
+#include "librbd/cache/ShardedObjectDispatch.h"
 #include "librbd/cache/WriteAroundObjectDispatch.h"
 #include "librbd/image/CloseRequest.h"
 #include "librbd/image/RefreshRequest.h"
@@ -572,24 +573,42 @@ Context *OpenRequest<I>::send_init_cache(int *result) {
     "rbd_cache_writethrough_until_flush");
   auto cache_policy = m_image_ctx->config.template get_val<std::string>(
     "rbd_cache_policy");
+  if (cache_policy == "writeback_sharded" &&
+      m_image_ctx->test_features(RBD_FEATURE_JOURNALING)) {
+    // the journal needs the tids of the writes back for each writeback,
+    // which the sharded cache merges
+    ldout(cct, 5) << this << " " << __func__ << ": journaling enabled, "
+                  << "using the writeback cache policy" << dendl;
+    cache_policy = "writeback";
+  }
+
   if (cache_policy == "writearound") {
     auto cache = cache::WriteAroundObjectDispatch<I>::create(
       m_image_ctx, max_dirty, writethrough_until_flush);
     cache->init();
 
     m_image_ctx->readahead.set_max_readahead_size(0);
-  } else if (cache_policy == "writethrough" || cache_policy == "writeback") {
+  } else if (cache_policy == "writethrough" || cache_policy == "writeback" ||
+             cache_policy == "writeback_sharded") {
     if (cache_policy == "writethrough") {
       max_dirty = 0;
     }
 
-    auto cache = cache::ObjectCacherObjectDispatch<I>::create(
-      m_image_ctx, max_dirty, writethrough_until_flush);
-    cache->init();
+    if (cache_policy == "writeback_sharded") {
+      auto cache = cache::ShardedObjectDispatch<I>::create(
+        m_image_ctx, max_dirty, writethrough_until_flush);
+      cache->init();
+    } else {
+      auto cache = cache::ObjectCacherObjectDispatch<I>::create(
+        m_image_ctx, max_dirty, writethrough_until_flush);
+      cache->init();
+    }
 
-    // readahead requires the object cacher cache
+    // readahead requires a cache that keeps what is read
     m_image_ctx->readahead.set_trigger_requests(
       m_image_ctx->config.template get_val<uint64_t>("rbd_readahead_trigger_requests"));
+    m_image_ctx->readahead.set_max_streams(
+      m_image_ctx->config.template get_val<uint64_t>("rbd_readahead_max_streams"));
     m_image_ctx->readahead.set_max_readahead_size(
       m_image_ctx->config.template get_val<Option::size_t>("rbd_readahead_max_bytes"));
   }
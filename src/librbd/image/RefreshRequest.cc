@@ -368,6 +368,13 @@ void RefreshRequest<I>::send_v2_get_mutable_metadata() {
   cls_client::get_flags_start(&op, CEPH_NOSNAP);
   cls_client::get_snapcontext_start(&op);
   rados::cls::lock::get_lock_info_start(&op, RBD_LOCK_NAME);
+  // NOTE: remove legacy parent support when Mimic is EOLed
+  if (!m_legacy_parent) {
+    cls_client::parent_get_start(&op);
+    cls_client::parent_overlap_get_start(&op, CEPH_NOSNAP);
+  } else {
+    cls_client::get_parent_start(&op, CEPH_NOSNAP);
+  }
 
   using klass = RefreshRequest<I>;
   librados::AioCompletion *comp = create_rados_callback<
@@ -413,7 +420,30 @@ Context *RefreshRequest<I>::handle_v2_get_mutable_metadata(int *result) {
     }
   }
 
-  if (*result < 0) {
+  if (*result >= 0 && !m_legacy_parent) {
+    *result = cls_client::parent_get_finish(&it, &m_parent_md.spec);
+
+    std::optional<uint64_t> parent_overlap;
+    if (*result == 0) {
+      *result = cls_client::parent_overlap_get_finish(&it, &parent_overlap);
+    }
+
+    if (*result == 0 && parent_overlap) {
+      m_parent_md.overlap = *parent_overlap;
+      m_head_parent_overlap = true;
+    }
+  } else if (*result >= 0) {
+    *result = cls_client::get_parent_finish(&it, &m_parent_md.spec,
+                                            &m_parent_md.overlap);
+    m_head_parent_overlap = true;
+  }
+
+  if (*result == -EOPNOTSUPP && !m_legacy_parent) {
+    ldout(cct, 10) << "retrying using legacy parent method" << dendl;
+    m_legacy_parent = true;
+    send_v2_get_mutable_metadata();
+    return nullptr;
+  } else if (*result < 0) {
     lderr(cct) << "failed to retrieve mutable metadata: "
                << cpp_strerror(*result) << dendl;
     return m_on_finish;
@@ -453,71 +483,6 @@ Context *RefreshRequest<I>::handle_v2_get_mutable_metadata(int *result) {
   }
   m_read_only = (m_read_only_flags != 0U);
 
-  send_v2_get_parent();
-  return nullptr;
-}
-
-template <typename I>
-void RefreshRequest<I>::send_v2_get_parent() {
-  // NOTE: remove support when Mimic is EOLed
-  CephContext *cct = m_image_ctx.cct;
-  ldout(cct, 10) << this << " " << __func__ << ": legacy=" << m_legacy_parent
-                 << dendl;
-
-  librados::ObjectReadOperation op;
-  if (!m_legacy_parent) {
-    cls_client::parent_get_start(&op);
-    cls_client::parent_overlap_get_start(&op, CEPH_NOSNAP);
-  } else {
-    cls_client::get_parent_start(&op, CEPH_NOSNAP);
-  }
-
-  auto aio_comp = create_rados_callback<
-    RefreshRequest<I>, &RefreshRequest<I>::handle_v2_get_parent>(this);
-  m_out_bl.clear();
-  m_image_ctx.md_ctx.aio_operate(m_image_ctx.header_oid, aio_comp, &op,
-                                  &m_out_bl);
-  aio_comp->release();
-}
-
-template <typename I>
-Context *RefreshRequest<I>::handle_v2_get_parent(int *result) {
-  // NOTE: remove support when Mimic is EOLed
-  CephContext *cct = m_image_ctx.cct;
-  ldout(cct, 10) << this << " " << __func__ << ": r=" << *result << dendl;
-
-  auto it = m_out_bl.cbegin();
-  if (!m_legacy_parent) {
-    if (*result == 0) {
-      *result = cls_client::parent_get_finish(&it, &m_parent_md.spec);
-    }
-
-    std::optional<uint64_t> parent_overlap;
-    if (*result == 0) {
-      *result = cls_client::parent_overlap_get_finish(&it, &parent_overlap);
-    }
-
-    if (*result == 0 && parent_overlap) {
-      m_parent_md.overlap = *parent_overlap;
-      m_head_parent_overlap = true;
-    }
-  } else if (*result == 0) {
-    *result = cls_client::get_parent_finish(&it, &m_parent_md.spec,
-                                            &m_parent_md.overlap);
-    m_head_parent_overlap = true;
-  }
-
-  if (*result == -EOPNOTSUPP && !m_legacy_parent) {
-    ldout(cct, 10) << "retrying using legacy parent method" << dendl;
-    m_legacy_parent = true;
-    send_v2_get_parent();
-    return nullptr;
-  } if (*result < 0) {
-    lderr(cct) << "failed to retrieve parent: " << cpp_strerror(*result)
-               << dendl;
-    return m_on_finish;
-  }
-
   if ((m_features & RBD_FEATURE_MIGRATING) != 0) {
     ldout(cct, 1) << "migrating feature set" << dendl;
     send_get_migration_header();
@@ -49,13 +49,13 @@ private:
    *  * |-----> V1_READ_HEADER -------------> GET_MIGRATION_HEADER (skip if not
    *  * |                                                     |     migrating)
    *  * | (v2)                                                v
-   *  * \-----> V2_GET_MUTABLE_METADATA                   V1_GET_SNAPSHOTS
+   *  * \-----> V2_GET_MUTABLE_METADATA <-\               V1_GET_SNAPSHOTS
+   *  *             |     |                 | -EOPNOTSUPP     |
+   *  *             |     \-----------------/ (legacy         v
+   *  *             |                          parent)    V1_GET_LOCKS
    *  *             |                                         |
-   *  *             |     -EOPNOTSUPP                         v
-   *  *             |  * * *                              V1_GET_LOCKS
-   *  *             |  *   *                                  |
-   *  *             v  v   *                                  v
-   *  *         V2_GET_PARENT                              <apply>
+   *  *             |                                         v
+   *  *             |                                      <apply>
    *  *             |                                         |
    *  *             v                                         |
    *  * * * * * GET_MIGRATION_HEADER (skip if not             |
@@ -193,8 +193,6 @@ private:
   void send_v2_get_mutable_metadata();
   Context *handle_v2_get_mutable_metadata(int *result);
 
-  void send_v2_get_parent();
-  Context *handle_v2_get_parent(int *result);
 
   void send_v2_get_metadata();
   Context *handle_v2_get_metadata(int *result);
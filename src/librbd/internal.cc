@@ -1638,10 +1638,20 @@ int validate_pool(IoCtx &io_ctx, CephContext *cct) {
     CephContext *cct = ictx->cct;
     ldout(cct, 20) << __func__ << " " << ictx << " numcomp = " << numcomp
                    << dendl;
+    if (ictx->event_socket_coalesce) {
+      // completions queued from now on need a new notification
+      ictx->event_socket_notified = false;
+    }
     int i = 0;
     while (i < numcomp && ictx->event_socket_completions.pop(comps[i])) {
       ++i;
     }
+    if (ictx->event_socket_coalesce && i == numcomp &&
+        !ictx->event_socket_completions.empty() &&
+        !ictx->event_socket_notified.exchange(true)) {
+      // left some behind: wake the caller up for them
+      ictx->event_socket.notify();
+    }
 
     return i;
   }
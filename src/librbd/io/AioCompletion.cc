@@ -268,7 +268,10 @@ void AioCompletion::complete_external_callback() {
 void AioCompletion::complete_event_socket() {
   if (ictx != nullptr && event_notify && ictx->event_socket.is_valid()) {
     ictx->event_socket_completions.push(this);
-    ictx->event_socket.notify();
+    if (!ictx->event_socket_coalesce ||
+        !ictx->event_socket_notified.exchange(true)) {
+      ictx->event_socket.notify();
+    }
   }
 }
 
@@ -224,6 +224,11 @@ void ImageDispatcher<I>::shut_down(Context* on_finish) {
   async_op->flush(on_finish);
 }
 
+template <typename I>
+void ImageDispatcher<I>::apply_qos_group(const std::string& group) {
+  m_qos_image_dispatch->apply_qos_group(group);
+}
+
 template <typename I>
 void ImageDispatcher<I>::apply_qos_schedule_tick_min(uint64_t tick) {
   m_qos_image_dispatch->apply_qos_schedule_tick_min(tick);
@@ -8,6 +8,7 @@
 #include "librbd/io/DispatcherInterface.h"
 #include "librbd/io/ImageDispatchInterface.h"
 #include "librbd/io/Types.h"
+#include <string>
 
 struct Context;
 
@@ -17,6 +18,7 @@ namespace io {
 struct ImageDispatcherInterface
   : public DispatcherInterface<ImageDispatchInterface> {
 public:
+  virtual void apply_qos_group(const std::string& group) = 0;
   virtual void apply_qos_schedule_tick_min(uint64_t tick) = 0;
   virtual void apply_qos_limit(uint64_t flag, uint64_t limit,
                                uint64_t burst, uint64_t burst_seconds) = 0;
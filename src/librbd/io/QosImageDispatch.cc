@@ -47,27 +47,73 @@ static std::map<uint64_t, std::string> throttle_flags = {
 
 } // anonymous namespace
 
+struct QosThrottles {
+  std::list<std::pair<uint64_t, TokenBucketThrottle*> > throttles;
+
+  explicit QosThrottles(CephContext* cct) {
+    SafeTimer *timer;
+    ceph::mutex *timer_lock;
+    ImageCtx::get_timer_instance(cct, &timer, &timer_lock);
+    for (auto flag : throttle_flags) {
+      throttles.push_back(make_pair(
+        flag.first,
+        new TokenBucketThrottle(cct, flag.second, 0, 0, timer, timer_lock)));
+    }
+  }
+
+  ~QosThrottles() {
+    for (auto t : throttles) {
+      delete t.second;
+    }
+  }
+};
+
+namespace {
+
+// the throttles shared by the images of a QoS group, for as long as one
+// of them is open
+struct QosGroups {
+  ceph::mutex lock = ceph::make_mutex("librbd::io::QosGroups::lock");
+  std::map<std::string, std::weak_ptr<QosThrottles>> groups;
+
+  explicit QosGroups(CephContext*) {
+  }
+
+  std::shared_ptr<QosThrottles> get(CephContext* cct,
+                                    const std::string& group) {
+    std::lock_guard locker{lock};
+    for (auto it = groups.begin(); it != groups.end(); ) {
+      if (it->second.expired()) {
+        it = groups.erase(it);
+      } else {
+        ++it;
+      }
+    }
+
+    auto& throttles = groups[group];
+    auto group_throttles = throttles.lock();
+    if (!group_throttles) {
+      group_throttles = std::make_shared<QosThrottles>(cct);
+      throttles = group_throttles;
+    }
+    return group_throttles;
+  }
+};
+
+} // anonymous namespace
+
 template <typename I>
 QosImageDispatch<I>::QosImageDispatch(I* image_ctx)
-  : m_image_ctx(image_ctx), m_flush_tracker(new FlushTracker<I>(image_ctx)) {
+  : m_image_ctx(image_ctx),
+    m_lock(ceph::make_shared_mutex("librbd::io::QosImageDispatch::m_lock")),
+    m_throttles(std::make_shared<QosThrottles>(image_ctx->cct)),
+    m_flush_tracker(new FlushTracker<I>(image_ctx)) {
   auto cct = m_image_ctx->cct;
   ldout(cct, 5) << "ictx=" << image_ctx << dendl;
-
-  SafeTimer *timer;
-  ceph::mutex *timer_lock;
-  ImageCtx::get_timer_instance(cct, &timer, &timer_lock);
-  for (auto flag : throttle_flags) {
-    m_throttles.push_back(make_pair(
-      flag.first,
-      new TokenBucketThrottle(cct, flag.second, 0, 0, timer, timer_lock)));
-  }
 }
 
 template <typename I>
 QosImageDispatch<I>::~QosImageDispatch() {
-  for (auto t : m_throttles) {
-    delete t.second;
-  }
   delete m_flush_tracker;
 }
 
@@ -77,9 +123,30 @@ void QosImageDispatch<I>::shut_down(Context* on_finish) {
   on_finish->complete(0);
 }
 
+template <typename I>
+void QosImageDispatch<I>::apply_qos_group(const std::string& group) {
+  auto cct = m_image_ctx->cct;
+
+  std::unique_lock locker{m_lock};
+  if (group == m_qos_group) {
+    return;
+  }
+
+  ldout(cct, 5) << "group=" << group << dendl;
+  m_qos_group = group;
+  if (group.empty()) {
+    m_throttles = std::make_shared<QosThrottles>(cct);
+  } else {
+    auto& qos_groups = cct->template lookup_or_create_singleton_object<QosGroups>(
+      "librbd::io::QosGroups", false, cct);
+    m_throttles = qos_groups.get(cct, group);
+  }
+}
+
 template <typename I>
 void QosImageDispatch<I>::apply_qos_schedule_tick_min(uint64_t tick) {
-  for (auto pair : m_throttles) {
+  std::shared_lock locker{m_lock};
+  for (auto pair : m_throttles->throttles) {
     pair.second->set_schedule_tick_min(tick);
   }
 }
@@ -89,7 +156,8 @@ void QosImageDispatch<I>::apply_qos_limit(uint64_t flag, uint64_t limit,
                                           uint64_t burst, uint64_t burst_seconds) {
   auto cct = m_image_ctx->cct;
   TokenBucketThrottle *throttle = nullptr;
-  for (auto pair : m_throttles) {
+  std::shared_lock locker{m_lock};
+  for (auto pair : m_throttles->throttles) {
     if (flag == pair.first) {
       throttle = pair.second;
       break;
@@ -292,7 +360,8 @@ bool QosImageDispatch<I>::needs_throttle(
   *dispatch_result = DISPATCH_RESULT_CONTINUE;
 
   auto qos_enabled_flag = m_qos_enabled_flag;
-  for (auto [flag, throttle] : m_throttles) {
+  std::shared_lock locker{m_lock};
+  for (auto [flag, throttle] : m_throttles->throttles) {
     if ((qos_enabled_flag & flag) == 0) {
       all_qos_flags_set = set_throttle_flag(image_dispatch_flags, flag);
       continue;
@@ -7,11 +7,14 @@
 #include "librbd/io/ImageDispatchInterface.h"
 #include "include/int_types.h"
 #include "include/buffer.h"
+#include "common/ceph_mutex.h"
 #include "common/zipkin_trace.h"
 #include "common/Throttle.h"
 #include "librbd/io/ReadResult.h"
 #include "librbd/io/Types.h"
 #include <list>
+#include <memory>
+#include <string>
 
 struct Context;
 
@@ -22,6 +25,7 @@ struct ImageCtx;
 namespace io {
 
 struct AioCompletion;
+struct QosThrottles;
 template <typename> class FlushTracker;
 
 template <typename ImageCtxT>
@@ -46,6 +50,7 @@ public:
 
   void shut_down(Context* on_finish) override;
 
+  void apply_qos_group(const std::string& group);
   void apply_qos_schedule_tick_min(uint64_t tick);
   void apply_qos_limit(uint64_t flag, uint64_t limit, uint64_t burst,
                        uint64_t burst_seconds);
@@ -108,7 +113,9 @@ public:
 private:
   ImageCtxT* m_image_ctx;
 
-  std::list<std::pair<uint64_t, TokenBucketThrottle*> > m_throttles;
+  ceph::shared_mutex m_lock;
+  std::string m_qos_group;
+  std::shared_ptr<QosThrottles> m_throttles;
   uint64_t m_qos_enabled_flag = 0;
   uint64_t m_qos_exclude_ops = 0;
 
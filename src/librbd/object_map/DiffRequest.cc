@@ -20,6 +20,107 @@ namespace object_map {
 
 using util::create_rados_callback;
 
+namespace {
+
+// the diff state of an object that existed in the previous snapshot
+uint8_t overlap_diff_state(uint8_t object_map_state,
+                           uint8_t prev_object_diff_state) {
+  if (object_map_state == OBJECT_EXISTS ||
+      object_map_state == OBJECT_PENDING ||
+      (object_map_state == OBJECT_EXISTS_CLEAN &&
+       prev_object_diff_state != DIFF_STATE_DATA &&
+       prev_object_diff_state != DIFF_STATE_DATA_UPDATED)) {
+    return DIFF_STATE_DATA_UPDATED;
+  } else if (object_map_state == OBJECT_NONEXISTENT &&
+             prev_object_diff_state != DIFF_STATE_HOLE &&
+             prev_object_diff_state != DIFF_STATE_HOLE_UPDATED) {
+    return DIFF_STATE_HOLE_UPDATED;
+  }
+  return prev_object_diff_state;
+}
+
+// the diff state of an object past the end of the previous snapshot
+uint8_t resize_diff_state(uint8_t object_map_state, bool diff_from_start) {
+  if (object_map_state == OBJECT_NONEXISTENT) {
+    return DIFF_STATE_HOLE;
+  } else if (diff_from_start || object_map_state != OBJECT_EXISTS_CLEAN) {
+    return DIFF_STATE_DATA_UPDATED;
+  }
+  return DIFF_STATE_DATA;
+}
+
+// both maps pack four 2-bit states to a byte, and the state of an object
+// only depends on its own states: the new diff states of a byte are looked
+// up by the object map byte and the previous diff state byte
+struct DiffTables {
+  uint8_t overlap[256][256];
+  uint8_t resize[2][256];
+
+  DiffTables() {
+    for (uint32_t om = 0; om < 256; ++om) {
+      for (uint32_t prev = 0; prev < 256; ++prev) {
+        uint8_t b = 0;
+        for (uint32_t shift = 0; shift < 8; shift += 2) {
+          b |= overlap_diff_state((om >> shift) & 3, (prev >> shift) & 3)
+                 << shift;
+        }
+        overlap[om][prev] = b;
+      }
+      for (uint32_t from_start = 0; from_start < 2; ++from_start) {
+        uint8_t b = 0;
+        for (uint32_t shift = 0; shift < 8; shift += 2) {
+          b |= resize_diff_state((om >> shift) & 3, from_start) << shift;
+        }
+        resize[from_start][om] = b;
+      }
+    }
+  }
+};
+
+const DiffTables& diff_tables() {
+  static const DiffTables tables;
+  return tables;
+}
+
+void diff_bytes(const BitVector<2>& object_map, BitVector<2>* diff_state,
+                uint64_t start, uint64_t end, bool overlap,
+                bool diff_from_start) {
+  constexpr uint64_t per_byte = 4;
+  auto& tables = diff_tables();
+
+  // the objects up to the first whole byte, and past the last one
+  auto start_byte = (start + per_byte - 1) / per_byte;
+  auto end_byte = std::max(end / per_byte, start_byte);
+  auto diff_one = [&](uint64_t i) {
+    auto ref = (*diff_state)[i];
+    ref = overlap ? overlap_diff_state(object_map[i], ref) :
+                    resize_diff_state(object_map[i], diff_from_start);
+  };
+  for (uint64_t i = start; i < std::min(end, start_byte * per_byte); ++i) {
+    diff_one(i);
+  }
+  if (start_byte < end_byte) {
+    bufferlist om_bl = object_map.get_data();
+    auto om = reinterpret_cast<const uint8_t*>(om_bl.c_str());
+    auto diff = reinterpret_cast<uint8_t*>(diff_state->get_data().c_str());
+    if (overlap) {
+      for (auto b = start_byte; b < end_byte; ++b) {
+        diff[b] = tables.overlap[om[b]][diff[b]];
+      }
+    } else {
+      auto& resize = tables.resize[diff_from_start];
+      for (auto b = start_byte; b < end_byte; ++b) {
+        diff[b] = resize[om[b]];
+      }
+    }
+  }
+  for (uint64_t i = std::max(start, end_byte * per_byte); i < end; ++i) {
+    diff_one(i);
+  }
+}
+
+} // anonymous namespace
+
 template <typename I>
 void DiffRequest<I>::send() {
   auto cct = m_image_ctx->cct;
@@ -188,6 +289,21 @@ void DiffRequest<I>::handle_load_object_map(int r) {
   }
 
   uint64_t overlap = std::min(m_object_map.size(), prev_object_diff_state_size);
+  bool diff_from_start = (m_snap_id_start == 0);
+  if (!cct->_conf->subsys.should_gather(dout_subsys, 20)) {
+    diff_bytes(m_object_map, m_object_diff_state, 0, overlap, true, false);
+    if (m_object_map.size() > prev_object_diff_state_size) {
+      diff_bytes(m_object_map, m_object_diff_state, overlap,
+                 m_object_map.size(), false, diff_from_start);
+    }
+    m_object_diff_state_valid = true;
+
+    std::shared_lock image_locker{m_image_ctx->image_lock};
+    load_object_map(&image_locker);
+    return;
+  }
+
+  // the same, an object at a time, to log the state of each
   auto it = m_object_map.begin();
   auto overlap_end_it = it + overlap;
   auto diff_it = m_object_diff_state->begin();
@@ -195,17 +311,7 @@ void DiffRequest<I>::handle_load_object_map(int r) {
   for (; it != overlap_end_it; ++it, ++diff_it, ++i) {
     uint8_t object_map_state = *it;
     uint8_t prev_object_diff_state = *diff_it;
-    if (object_map_state == OBJECT_EXISTS ||
-        object_map_state == OBJECT_PENDING ||
-        (object_map_state == OBJECT_EXISTS_CLEAN &&
-         prev_object_diff_state != DIFF_STATE_DATA &&
-         prev_object_diff_state != DIFF_STATE_DATA_UPDATED)) {
-      *diff_it = DIFF_STATE_DATA_UPDATED;
-    } else if (object_map_state == OBJECT_NONEXISTENT &&
-               prev_object_diff_state != DIFF_STATE_HOLE &&
-               prev_object_diff_state != DIFF_STATE_HOLE_UPDATED) {
-      *diff_it = DIFF_STATE_HOLE_UPDATED;
-    }
+    *diff_it = overlap_diff_state(object_map_state, prev_object_diff_state);
 
     ldout(cct, 20) << "object state: " << i << " "
                    << static_cast<uint32_t>(prev_object_diff_state)
@@ -215,18 +321,10 @@ void DiffRequest<I>::handle_load_object_map(int r) {
   }
   ldout(cct, 20) << "computed overlap diffs" << dendl;
 
-  bool diff_from_start = (m_snap_id_start == 0);
   auto end_it = m_object_map.end();
   if (m_object_map.size() > prev_object_diff_state_size) {
     for (; it != end_it; ++it,++diff_it, ++i) {
-      uint8_t object_map_state = *it;
-      if (object_map_state == OBJECT_NONEXISTENT) {
-        *diff_it = DIFF_STATE_HOLE;
-      } else if (diff_from_start || object_map_state != OBJECT_EXISTS_CLEAN) {
-        *diff_it = DIFF_STATE_DATA_UPDATED;
-      } else {
-        *diff_it = DIFF_STATE_DATA;
-      }
+      *diff_it = resize_diff_state(*it, diff_from_start);
 
       ldout(cct, 20) << "object state: " << i << " "
                      << "->" << static_cast<uint32_t>(*diff_it) << " ("
@@ -21,6 +21,7 @@
 #include <fcntl.h>
 #include <syslog.h>
 
+#include <algorithm>
 #include <iostream>
 #include <set>
 
@@ -33,6 +34,14 @@ namespace logging {
 
 static OnExitManager exit_callbacks;
 
+static std::size_t new_shard_of_this_thread()
+{
+  // threads take the shards in turn
+  static std::atomic<std::size_t> next_shard{0};
+  static thread_local std::size_t shard = next_shard++;
+  return shard;
+}
+
 static void log_on_exit(void *p)
 {
   Log *l = *(Log **)p;
@@ -202,22 +211,68 @@ void Log::stop_journald_logger()
 
 void Log::submit_entry(Entry&& e)
 {
-  std::unique_lock lock(m_queue_mutex);
-  m_queue_mutex_holder = pthread_self();
+  // wait for flush to catch up
+  if (unlikely(is_started() && m_num_new > m_max_new)) {
+    std::unique_lock lock(m_queue_mutex);
+    m_queue_mutex_holder = pthread_self();
+    while (is_started() && m_num_new > m_max_new) {
+      if (m_stop) break; // force addition
+      m_cond_loggers.wait(lock);
+    }
+    m_queue_mutex_holder = 0;
+  }
 
-  if (unlikely(m_inject_segv))
-    *(volatile int *)(0) = 0xdead;
+  // the threads only share a shard when there are more of them than
+  // shards, so adding does not serialize all the loggers of a daemon.
+  bool was_empty = m_num_new++ == 0;
+  {
+    auto& shard = m_new[new_shard_of_this_thread() % NUM_NEW_SHARDS];
+    std::scoped_lock lock(shard.mutex);
+    shard.mutex_holder = pthread_self();
 
-  // wait for flush to catch up
-  while (is_started() &&
-	 m_new.size() > m_max_new) {
-    if (m_stop) break; // force addition
-    m_cond_loggers.wait(lock);
+    if (unlikely(m_inject_segv))
+      *(volatile int *)(0) = 0xdead;
+
+    shard.entries.emplace_back(std::move(e));
+    shard.mutex_holder = 0;
   }
 
-  m_new.emplace_back(std::move(e));
-  m_cond_flusher.notify_all();
-  m_queue_mutex_holder = 0;
+  // the flusher only sleeps when there is nothing new
+  if (was_empty) {
+    std::scoped_lock lock(m_queue_mutex);
+    m_cond_flusher.notify_all();
+  }
+}
+
+void Log::_take_new(EntryVector& q)
+{
+  assert(q.empty());
+  std::size_t shards = 0;
+  for (auto& shard : m_new) {
+    std::scoped_lock lock(shard.mutex);
+    shard.mutex_holder = pthread_self();
+    if (!shard.entries.empty()) {
+      if (q.empty()) {
+	q.swap(shard.entries);
+      } else {
+	q.insert(q.end(), std::make_move_iterator(shard.entries.begin()),
+		 std::make_move_iterator(shard.entries.end()));
+	shard.entries.clear();
+      }
+      ++shards;
+    }
+    shard.mutex_holder = 0;
+  }
+  if (shards > 1) {
+    std::stable_sort(q.begin(), q.end(),
+		     [](const ConcreteEntry& a, const ConcreteEntry& b) {
+		       return a.m_stamp < b.m_stamp;
+		     });
+  }
+
+  m_num_new -= q.size();
+  std::scoped_lock lock(m_queue_mutex);
+  m_cond_loggers.notify_all();
 }
 
 void Log::flush()
@@ -225,14 +280,7 @@ void Log::flush()
   std::scoped_lock lock1(m_flush_mutex);
   m_flush_mutex_holder = pthread_self();
 
-  {
-    std::scoped_lock lock2(m_queue_mutex);
-    m_queue_mutex_holder = pthread_self();
-    assert(m_flush.empty());
-    m_flush.swap(m_new);
-    m_cond_loggers.notify_all();
-    m_queue_mutex_holder = 0;
-  }
+  _take_new(m_flush);
 
   _flush(m_flush, false);
   m_flush_mutex_holder = 0;
@@ -372,13 +420,7 @@ void Log::dump_recent()
   std::scoped_lock lock1(m_flush_mutex);
   m_flush_mutex_holder = pthread_self();
 
-  {
-    std::scoped_lock lock2(m_queue_mutex);
-    m_queue_mutex_holder = pthread_self();
-    assert(m_flush.empty());
-    m_flush.swap(m_new);
-    m_queue_mutex_holder = 0;
-  }
+  _take_new(m_flush);
 
   _flush(m_flush, false);
 
@@ -456,7 +498,7 @@ void *Log::entry()
     std::unique_lock lock(m_queue_mutex);
     m_queue_mutex_holder = pthread_self();
     while (!m_stop) {
-      if (!m_new.empty()) {
+      if (m_num_new > 0) {
         m_queue_mutex_holder = 0;
         lock.unlock();
         flush();
@@ -475,9 +517,16 @@ void *Log::entry()
 
 bool Log::is_inside_log_lock()
 {
-  return
-    pthread_self() == m_queue_mutex_holder ||
-    pthread_self() == m_flush_mutex_holder;
+  if (pthread_self() == m_queue_mutex_holder ||
+      pthread_self() == m_flush_mutex_holder) {
+    return true;
+  }
+  for (auto& shard : m_new) {
+    if (pthread_self() == shard.mutex_holder) {
+      return true;
+    }
+  }
+  return false;
 }
 
 void Log::inject_segv()
@@ -6,6 +6,8 @@
 
 #include <boost/circular_buffer.hpp>
 
+#include <array>
+#include <atomic>
 #include <condition_variable>
 #include <memory>
 #include <mutex>
@@ -32,12 +34,20 @@ class Log : private Thread
 
   static const std::size_t DEFAULT_MAX_NEW = 100;
   static const std::size_t DEFAULT_MAX_RECENT = 10000;
+  static const std::size_t NUM_NEW_SHARDS = 8;
+
+  /// new entries of the threads mapped to one shard
+  struct alignas(64) NewShard {
+    std::mutex mutex;
+    pthread_t mutex_holder = 0;
+    EntryVector entries;
+  };
 
   Log **m_indirect_this;
 
   const SubsystemMap *m_subs;
 
-  std::mutex m_queue_mutex;
+  std::mutex m_queue_mutex; ///< for m_stop and waiting on the conds below
   std::mutex m_flush_mutex;
   std::condition_variable m_cond_loggers;
   std::condition_variable m_cond_flusher;
@@ -45,7 +55,8 @@ class Log : private Thread
   pthread_t m_queue_mutex_holder;
   pthread_t m_flush_mutex_holder;
 
-  EntryVector m_new;    ///< new entries
+  std::array<NewShard, NUM_NEW_SHARDS> m_new; ///< new entries
+  std::atomic<std::size_t> m_num_new{0};      ///< in m_new, or being added
   EntryRing m_recent; ///< recent (less new) entries we've already written at low detail
   EntryVector m_flush; ///< entries to be flushed (here to optimize heap allocations)
 
@@ -70,7 +81,7 @@ class Log : private Thread
 
   bool m_stop = false;
 
-  std::size_t m_max_new = DEFAULT_MAX_NEW;
+  std::atomic<std::size_t> m_max_new{DEFAULT_MAX_NEW};
   std::size_t m_max_recent = DEFAULT_MAX_RECENT;
 
   bool m_inject_segv = false;
@@ -79,6 +90,7 @@ class Log : private Thread
 
   void _log_safe_write(std::string_view sv);
   void _flush_logbuf();
+  void _take_new(EntryVector& q);
   void _flush(EntryVector& q, bool crash);
 
   void _log_message(std::string_view s, bool crash);
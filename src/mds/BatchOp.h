@@ -16,6 +16,8 @@
 #ifndef MDS_BATCHOP_H
 #define MDS_BATCHOP_H
 
+#include <memory>
+
 #include "common/ref.h"
 
 #include "mdstypes.h"
@@ -37,4 +39,8 @@ protected:
   virtual void _respond(mds_rank_t) = 0;
 };
 
+// the batched getattr/lookup ops on a cached inode or dentry, by mask;
+// empty on all but a few of them, so it takes no more than a pointer
+using batch_op_map_t = mempool::mds_co::compact_map<int, std::unique_ptr<BatchOp>>;
+
 #endif
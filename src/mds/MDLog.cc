@@ -374,67 +374,78 @@ void MDLog::_submit_thread()
     }
 
     int64_t features = mdsmap_up_features;
-    PendingEvent data = it->second.front();
-    it->second.pop_front();
+    // take whatever was queued for the segment meanwhile as one batch:
+    // it is appended without going back to submit_mutex for every event,
+    // and flushed by a single journaler write
+    list<PendingEvent> batch;
+    batch.swap(it->second);
 
     locker.unlock();
 
-    if (data.le) {
-      LogEvent *le = data.le;
-      LogSegment *ls = le->_segment;
-      // encode it, with event type
-      bufferlist bl;
-      le->encode_with_header(bl, features);
+    bool flush = false;
+    int batch_unflushed = 0;
+    for (auto& data : batch) {
+      if (data.le) {
+	LogEvent *le = data.le;
+	LogSegment *ls = le->_segment;
+	// encode it, with event type
+	bufferlist bl;
+	le->encode_with_header(bl, features);
 
-      uint64_t write_pos = journaler->get_write_pos();
+	uint64_t write_pos = journaler->get_write_pos();
 
-      le->set_start_off(write_pos);
-      if (le->get_type() == EVENT_SUBTREEMAP)
-	ls->offset = write_pos;
+	le->set_start_off(write_pos);
+	if (le->get_type() == EVENT_SUBTREEMAP)
+	  ls->offset = write_pos;
 
-      dout(5) << "_submit_thread " << write_pos << "~" << bl.length()
-	      << " : " << *le << dendl;
+	dout(5) << "_submit_thread " << write_pos << "~" << bl.length()
+		<< " : " << *le << dendl;
 
-      // journal it.
-      const uint64_t new_write_pos = journaler->append_entry(bl);  // bl is destroyed.
-      ls->end = new_write_pos;
+	// journal it.
+	const uint64_t new_write_pos = journaler->append_entry(bl);  // bl is destroyed.
+	ls->end = new_write_pos;
 
-      MDSLogContextBase *fin;
-      if (data.fin) {
-	fin = dynamic_cast<MDSLogContextBase*>(data.fin);
-	ceph_assert(fin);
-	fin->set_write_pos(new_write_pos);
-      } else {
-	fin = new C_MDL_Flushed(this, new_write_pos);
-      }
+	MDSLogContextBase *fin;
+	if (data.fin) {
+	  fin = dynamic_cast<MDSLogContextBase*>(data.fin);
+	  ceph_assert(fin);
+	  fin->set_write_pos(new_write_pos);
+	} else {
+	  fin = new C_MDL_Flushed(this, new_write_pos);
+	}
 
-      journaler->wait_for_flush(fin);
-
-      if (data.flush)
-	journaler->flush();
+	journaler->wait_for_flush(fin);
 
-      if (logger)
-	logger->set(l_mdl_wrpos, ls->end);
+	if (logger)
+	  logger->set(l_mdl_wrpos, ls->end);
 
-      delete le;
-    } else {
-      if (data.fin) {
-	MDSContext* fin =
-		dynamic_cast<MDSContext*>(data.fin);
-	ceph_assert(fin);
-	C_MDL_Flushed *fin2 = new C_MDL_Flushed(this, fin);
-	fin2->set_write_pos(journaler->get_write_pos());
-	journaler->wait_for_flush(fin2);
+	delete le;
+      } else {
+	if (data.fin) {
+	  MDSContext* fin =
+		  dynamic_cast<MDSContext*>(data.fin);
+	  ceph_assert(fin);
+	  C_MDL_Flushed *fin2 = new C_MDL_Flushed(this, fin);
+	  fin2->set_write_pos(journaler->get_write_pos());
+	  journaler->wait_for_flush(fin2);
+	}
       }
+
       if (data.flush)
-	journaler->flush();
+	flush = true;
+      else if (data.le)
+	batch_unflushed++;
     }
+    // flushing at the end of the batch also writes out whatever came
+    // after the flush was asked for
+    if (flush)
+      journaler->flush();
 
     locker.lock();
-    if (data.flush)
+    if (flush)
       unflushed = 0;
-    else if (data.le)
-      unflushed++;
+    else
+      unflushed += batch_unflushed;
   }
 }
 
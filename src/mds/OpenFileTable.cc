@@ -737,6 +737,7 @@ void OpenFileTable::_read_omap_values(const std::string& key, unsigned idx,
 		     &c->values, &c->more, &c->values_r);
     mds->objecter->read(oid, oloc, op, CEPH_NOSNAP, nullptr, 0,
 			new C_OnFinisher(c, mds->finisher));
+    ++num_loading;
 }
 
 void OpenFileTable::_load_finish(int op_r, int header_r, int values_r,
@@ -745,7 +746,9 @@ void OpenFileTable::_load_finish(int op_r, int header_r, int values_r,
 				 std::map<std::string, bufferlist> &values)
 {
   using ceph::decode;
-  int err = -CEPHFS_EINVAL;
+
+  ceph_assert(num_loading > 0);
+  --num_loading;
 
   auto decode_func = [this](unsigned idx, inodeno_t ino, bufferlist &bl) {
     auto p = bl.cbegin();
@@ -768,9 +771,13 @@ void OpenFileTable::_load_finish(int op_r, int header_r, int values_r,
       ++omap_num_items[idx];
   };
 
+  // an earlier read failed, just wait for the others
+  if (load_err < 0)
+    goto out;
+
   if (op_r < 0) {
     derr << __func__ << " got " << cpp_strerror(op_r) << dendl;
-    err = op_r;
+    load_err = op_r;
     goto out;
   }
 
@@ -817,13 +824,19 @@ void OpenFileTable::_load_finish(int op_r, int header_r, int values_r,
       if (version > omap_version) {
 	omap_version = version;
 	omap_num_objs = num_objs;
-	omap_num_items.resize(omap_num_objs);
+	// objects past a smaller count are still being read
+	if (omap_num_items.size() < omap_num_objs)
+	  omap_num_items.resize(omap_num_objs);
 	journal_state = jstate;
       } else if (version == omap_version) {
 	ceph_assert(omap_num_objs == num_objs);
 	if (jstate > journal_state)
 	  journal_state = jstate;
       }
+
+      // the objects are read in parallel once their count is known
+      while (num_load_issued < omap_num_objs)
+	_read_omap_values("", num_load_issued++, true);
     }
 
     for (auto& it : values) {
@@ -831,11 +844,9 @@ void OpenFileTable::_load_finish(int op_r, int header_r, int values_r,
 	if (idx >= loaded_journals.size())
 	  loaded_journals.resize(idx + 1);
 
-	if (journal_state == JOURNAL_FINISH) {
-	  loaded_journals[idx][it.first].swap(it.second);
-	} else { // incomplete journal
-	  loaded_journals[idx][it.first].length();
-	}
+	// kept even though the journal may look incomplete so far: the
+	// objects that tell it is complete may not be read yet.
+	loaded_journals[idx][it.first].swap(it.second);
 	continue;
       }
 
@@ -845,20 +856,30 @@ void OpenFileTable::_load_finish(int op_r, int header_r, int values_r,
     }
   } catch (buffer::error &e) {
     derr << __func__ << ": corrupted header/values: " << e.what() << dendl;
+    load_err = -CEPHFS_EINVAL;
     goto out;
   }
 
-  if (more || idx + 1 < omap_num_objs) {
+  if (more) {
     // Issue another read if we're not at the end of the omap
-    std::string last_key;
-    if (more)
-      last_key = values.rbegin()->first;
-    else
-      idx++;
-
-    _read_omap_values(last_key, idx, !more);
+    _read_omap_values(values.rbegin()->first, idx, false);
     return;
   }
+  if (num_loading > 0)
+    return;
+
+  // drop what the objects past the final count had
+  if (omap_num_items.size() > omap_num_objs) {
+    for (auto it = loaded_anchor_map.begin(); it != loaded_anchor_map.end(); ) {
+      if (it->second.omap_idx >= omap_num_objs)
+	it = loaded_anchor_map.erase(it);
+      else
+	++it;
+    }
+    omap_num_items.resize(omap_num_objs);
+  }
+  if (loaded_journals.size() > omap_num_objs)
+    loaded_journals.resize(omap_num_objs);
 
   // replay journal
   if (loaded_journals.size() > 0) {
@@ -915,6 +936,7 @@ void OpenFileTable::_load_finish(int op_r, int header_r, int values_r,
 	}
       } catch (buffer::error &e) {
 	derr << __func__ << ": corrupted journal: " << e.what() << dendl;
+	load_err = -CEPHFS_EINVAL;
 	goto out;
       }
 
@@ -948,11 +970,12 @@ void OpenFileTable::_load_finish(int op_r, int header_r, int values_r,
   }
 
   journal_state = JOURNAL_NONE;
-  err = 0;
   dout(10) << __func__ << ": load complete" << dendl;
 out:
+  if (num_loading > 0)
+    return;
 
-  if (err < 0)
+  if (load_err < 0)
     _reset_states();
 
   load_done = true;
@@ -967,6 +990,7 @@ void OpenFileTable::load(MDSContext *onload)
   if (onload)
     waiting_for_load.push_back(onload);
 
+  num_load_issued = 1;
   _read_omap_values("", 0, true);
 }
 
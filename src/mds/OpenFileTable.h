@@ -133,6 +133,9 @@ protected:
   map<inodeno_t, RecoveredAnchor> loaded_anchor_map;
   MDSContext::vec waiting_for_load;
   bool load_done = false;
+  unsigned num_load_issued = 0; // objects whose reads have been issued
+  unsigned num_loading = 0;	// reads in flight
+  int load_err = 0;
 
   enum {
     DIR_INODES = 1,
@@ -115,7 +115,8 @@ PurgeQueue::PurgeQueue(
     journaler("pq", MDS_INO_PURGE_QUEUE + rank, metadata_pool,
       CEPH_FS_ONDISK_MAGIC, objecter_, nullptr, 0,
       &finisher),
-    on_error(on_error_)
+    on_error(on_error_),
+    max_ranges_per_file(cct->_conf.get_val<uint64_t>("mds_purge_max_ranges_per_file"))
 {
   ceph_assert(cct != nullptr);
   ceph_assert(on_error != nullptr);
@@ -373,7 +374,8 @@ uint32_t PurgeQueue::_calculate_ops(const PurgeItem &item) const
     const uint64_t num = (item.size > 0) ?
       Striper::get_num_objects(item.layout, item.size) : 1;
 
-    ops_required = std::min(num, g_conf()->filer_max_purge_ops);
+    ops_required = std::min(num,
+			    g_conf()->filer_max_purge_ops * max_ranges_per_file);
 
     // Account for deletions for old pools
     if (item.action != PurgeItem::TRUNCATE_FILE) {
@@ -534,9 +536,18 @@ void PurgeQueue::_commit_ops(int r, const std::vector<PurgeItemCommitOp>& ops_ve
           continue;
       }
 
-      filer.purge_range(op.item.ino, &op.item.layout, op.item.snapc,
-                        first_obj, num_obj, ceph::real_clock::now(), op.flags,
-                        gather.new_sub());
+      // split a large file into ranges that are purged in parallel
+      uint64_t per_range = std::max<uint64_t>(g_conf()->filer_max_purge_ops, 1);
+      per_range = std::max(per_range,
+			   (num_obj + max_ranges_per_file - 1) / max_ranges_per_file);
+      while (num_obj > 0) {
+        uint64_t n = std::min(num_obj, per_range);
+        filer.purge_range(op.item.ino, &op.item.layout, op.item.snapc,
+                          first_obj, n, ceph::real_clock::now(), op.flags,
+                          gather.new_sub());
+        first_obj += n;
+        num_obj -= n;
+      }
     } else if (op.type == PurgeItemCommitOp::PURGE_OP_REMOVE) {
       if (op.item.action == PurgeItem::PURGE_DIR) {
         objecter->remove(op.oid, op.oloc, nullsnapc,
@@ -245,5 +245,8 @@ private:
 
   uint64_t ops_high_water = 0;
   uint64_t files_high_water = 0;
+
+  // Ranges of a large file purged in parallel
+  const uint64_t max_ranges_per_file;
 };
 #endif
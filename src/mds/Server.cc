@@ -1253,6 +1253,9 @@ void Server::handle_conf_change(const std::set<std::string>& changed) {
   if (changed.count("mds_alternate_name_max")) {
     alternate_name_max  = g_conf().get_val<Option::size_t>("mds_alternate_name_max");
   }
+  if (changed.count("mds_dir_prefetch_max")) {
+    dir_prefetch_max = g_conf().get_val<uint64_t>("mds_dir_prefetch_max");
+  }
 }
 
 /*
@@ -4722,6 +4725,9 @@ void Server::handle_client_readdir(MDRequestRef& mdr)
 
     // touch dn
     mdcache->lru.lru_touch(dn);
+
+    if (dnl->is_primary() && in->is_dir() && snapid == CEPH_NOSNAP)
+      prefetch_dirfrag(in);
   }
   
   session->touch_readdir_cap(numfiles);
@@ -4760,6 +4766,44 @@ void Server::handle_client_readdir(MDRequestRef& mdr)
 
 
 
+class C_MDS_DirPrefetched : public ServerContext {
+public:
+  explicit C_MDS_DirPrefetched(Server *s) : ServerContext(s) {}
+  void finish(int r) override {
+    ceph_assert(server->num_dir_prefetching > 0);
+    server->num_dir_prefetching--;
+  }
+};
+
+/*
+ * start loading the first dirfrag of a subdirectory a client has just
+ * listed, so that a tree walk does not wait for it when it descends.
+ */
+bool Server::prefetch_dirfrag(CInode *diri)
+{
+  if (num_dir_prefetching >= dir_prefetch_max || !mds->is_active())
+    return false;
+  if (!diri->is_auth() || diri->is_frozen() || diri->is_freezing())
+    return false;
+
+  frag_t fg = diri->dirfragtree[frag_t().value()];
+  CDir *dir = diri->get_dirfrag(fg);
+  if (dir) {
+    if (!dir->is_auth() || dir->is_complete() ||
+	dir->state_test(CDir::STATE_FETCHING) || !dir->can_auth_pin())
+      return false;
+  } else {
+    // not a subtree bound, or it would be in cache: the frag is ours
+    dir = diri->get_or_open_dirfrag(mdcache, fg);
+  }
+
+  dout(20) << __func__ << " " << *dir << dendl;
+  num_dir_prefetching++;
+  dir->fetch(new C_MDS_DirPrefetched(this));
+  return true;
+}
+
+
 // ===============================================================================
 // INODE UPDATES
 
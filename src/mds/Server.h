@@ -200,6 +200,7 @@ public:
   void _lookup_snap_ino(MDRequestRef& mdr);
   void _lookup_ino_2(MDRequestRef& mdr, int r);
   void handle_client_readdir(MDRequestRef& mdr);
+  bool prefetch_dirfrag(CInode *diri);
   void handle_client_file_setlock(MDRequestRef& mdr);
   void handle_client_file_readlock(MDRequestRef& mdr);
 
@@ -321,6 +322,7 @@ private:
   friend class ServerContext;
   friend class ServerLogContext;
   friend class Batch_Getattr_Lookup;
+  friend class C_MDS_DirPrefetched;
 
   // placeholder for validation handler to store xattr specific
   // data
@@ -471,6 +473,9 @@ private:
   double caps_throttle_retry_request_timeout;
 
   size_t alternate_name_max = g_conf().get_val<Option::size_t>("mds_alternate_name_max");
+
+  uint64_t dir_prefetch_max = g_conf().get_val<uint64_t>("mds_dir_prefetch_max");
+  uint64_t num_dir_prefetching = 0;
 };
 
 static inline constexpr auto operator|(Server::RecallFlags a, Server::RecallFlags b) {
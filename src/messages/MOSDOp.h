@@ -36,7 +36,7 @@ namespace _mosdop {
 template<typename V>
 class MOSDOp final : public MOSDFastDispatchOp {
 private:
-  static constexpr int HEAD_VERSION = 8;
+  static constexpr int HEAD_VERSION = 9;
   static constexpr int COMPAT_VERSION = 3;
 
 private:
@@ -65,9 +65,22 @@ private:
   bool bdata_encode;
   osd_reqid_t reqid; // reqid explicitly set by sender
 
+  // dmclock distributed tags: work completed by other osds since this
+  // client's last request to us, in total and in the reservation phase
+  uint32_t qos_delta = 0;
+  uint32_t qos_rho = 0;
+  // how the osd's mclock scheduler served this op; not encoded, but
+  // returned to the client in the reply
+  uint8_t qos_phase = 0;
+  uint32_t qos_cost = 0;
+
 public:
   friend MOSDOpReply;
 
+  static constexpr uint8_t QOS_PHASE_NONE = 0;
+  static constexpr uint8_t QOS_PHASE_RESERVATION = 1;
+  static constexpr uint8_t QOS_PHASE_PRIORITY = 2;
+
   ceph_tid_t get_client_tid() { return header.tid; }
   void set_snapid(const snapid_t& s) {
     hobj.snap = s;
@@ -169,6 +182,26 @@ public:
     return get_connection()->get_features();
   }
 
+  bool has_qos_params() const {
+    return qos_delta || qos_rho;
+  }
+  uint32_t get_qos_delta() const {
+    return qos_delta;
+  }
+  uint32_t get_qos_rho() const {
+    return qos_rho;
+  }
+  void set_qos_params(uint32_t delta, uint32_t rho) {
+    qos_delta = delta;
+    qos_rho = rho;
+  }
+  void set_qos_phase(uint8_t phase) {
+    qos_phase = phase;
+  }
+  void set_qos_cost(uint32_t cost) {
+    qos_cost = cost;
+  }
+
   MOSDOp()
     : MOSDFastDispatchOp(CEPH_MSG_OSD_OP, HEAD_VERSION, COMPAT_VERSION),
       partial_decode_needed(true),
@@ -361,9 +394,9 @@ struct ceph_osd_request_head {
       encode(retry_attempt, payload);
       encode(features, payload);
     } else {
-      // latest v8 encoding with hobject_t hash separate from pgid, no
-      // reassert version
-      header.version = HEAD_VERSION;
+      // v8 encoding with hobject_t hash separate from pgid, no
+      // reassert version; v9 adds the dmclock tags
+      header.version = HAVE_FEATURE(features, SERVER_QUINCY) ? HEAD_VERSION : 8;
 
       encode(pgid, payload);
       encode(hobj.get_hash(), payload);
@@ -371,6 +404,10 @@ struct ceph_osd_request_head {
       encode(flags, payload);
       encode(reqid, payload);
       encode_trace(payload, features);
+      if (header.version >= 9) {
+	encode(qos_delta, payload);
+	encode(qos_rho, payload);
+      }
 
       // -- above decoded up front; below decoded post-dispatch thread --
 
@@ -399,7 +436,7 @@ struct ceph_osd_request_head {
     p = std::cbegin(payload);
 
     // Always keep here the newest version of decoding order/rule
-    if (header.version == HEAD_VERSION) {
+    if (header.version >= 8) {
       decode(pgid, p);      // actual pgid
       uint32_t hash;
       decode(hash, p); // raw hash value
@@ -408,6 +445,10 @@ struct ceph_osd_request_head {
       decode(flags, p);
       decode(reqid, p);
       decode_trace(p);
+      if (header.version >= 9) {
+	decode(qos_delta, p);
+	decode(qos_rho, p);
+      }
     } else if (header.version == 7) {
       decode(pgid.pgid, p);      // raw pgid
       hobj.set_hash(pgid.pgid.ps());
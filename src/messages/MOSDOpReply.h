@@ -31,7 +31,7 @@
 
 class MOSDOpReply final : public Message {
 private:
-  static constexpr int HEAD_VERSION = 8;
+  static constexpr int HEAD_VERSION = 9;
   static constexpr int COMPAT_VERSION = 2;
 
   object_t oid;
@@ -47,6 +47,8 @@ private:
   int32_t retry_attempt = -1;
   bool do_redirect;
   request_redirect_t redirect;
+  uint8_t qos_phase = 0;  ///< MOSDOp::QOS_PHASE_*
+  uint32_t qos_cost = 0;
 
 public:
   const object_t& get_oid() const { return oid; }
@@ -57,6 +59,8 @@ public:
   bool     is_onnvram() const { return get_flags() & CEPH_OSD_FLAG_ONNVRAM; }
   
   int get_result() const { return result; }
+  uint8_t get_qos_phase() const { return qos_phase; }
+  uint32_t get_qos_cost() const { return qos_cost; }
   const eversion_t& get_replay_version() const { return replay_version; }
   const version_t& get_user_version() const { return user_version; }
   
@@ -154,6 +158,8 @@ public:
     user_version = 0;
     retry_attempt = req->get_retry_attempt();
     do_redirect = false;
+    qos_phase = req->qos_phase;
+    qos_cost = req->qos_cost;
 
     for (unsigned i = 0; i < ops.size(); i++) {
       // zero out input data
@@ -223,6 +229,8 @@ public:
         }
       }
       encode_trace(payload, features);
+      encode(qos_phase, payload);
+      encode(qos_cost, payload);
     }
   }
   void decode_payload() override {
@@ -256,6 +264,8 @@ public:
       if (do_redirect)
 	decode(redirect, p);
       decode_trace(p);
+      decode(qos_phase, p);
+      decode(qos_cost, p);
     } else if (header.version < 2) {
       ceph_osd_reply_head head;
       decode(head, p);
@@ -34,7 +34,7 @@
 
 class MOSDPing final : public Message {
 private:
-  static constexpr int HEAD_VERSION = 5;
+  static constexpr int HEAD_VERSION = 6;
   static constexpr int COMPAT_VERSION = 4;
 
  public:
@@ -66,6 +66,9 @@ private:
   ceph::signedspan mono_send_stamp; ///< replier's send stamp
   std::optional<ceph::signedspan> delta_ub;  ///< ping sender
   epoch_t up_from = 0;
+  /// PING: other osds of the replier's host to vouch for
+  /// PING_REPLY: those of them the replier heard from lately
+  std::vector<int32_t> host_peers;
 
   uint32_t min_message_size = 0;
 
@@ -110,6 +113,9 @@ public:
       decode(mono_send_stamp, p);
       decode(delta_ub, p);
     }
+    if (header.version >= 6) {
+      decode(host_peers, p);
+    }
 
     p += size;
     min_message_size = size + payload_mid_length;
@@ -131,6 +137,7 @@ public:
     encode(mono_ping_stamp, payload);
     encode(mono_send_stamp, payload);
     encode(delta_ub, payload);
+    encode(host_peers, payload);
 
     if (s) {
       // this should be big enough for normal min_message padding sizes. since
@@ -158,6 +165,9 @@ public:
     if (delta_ub) {
       out << " delta_ub " << *delta_ub;
     }
+    if (!host_peers.empty()) {
+      out << " host_peers " << host_peers;
+    }
     out << ")";
   }
 private:
@@ -946,6 +946,14 @@ PyObject* ActivePyModules::get_perf_schema_python(
   return f.get();
 }
 
+PyObject *ActivePyModules::get_native_metrics_python()
+{
+  without_gil_t no_gil;
+  std::string text = server.get_metrics();
+  with_gil_t with_gil{no_gil};
+  return PyUnicode_FromStringAndSize(text.data(), text.size());
+}
+
 PyObject *ActivePyModules::get_context()
 {
   auto l = without_gil([&] {
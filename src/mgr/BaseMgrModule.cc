@@ -649,6 +649,12 @@ get_latest_counter(BaseMgrModule *self, PyObject *args)
       svc_name, svc_id, counter_path);
 }
 
+static PyObject*
+get_native_metrics(BaseMgrModule *self, PyObject *args)
+{
+  return self->py_modules->get_native_metrics_python();
+}
+
 static PyObject*
 get_perf_schema(BaseMgrModule *self, PyObject *args)
 {
@@ -830,6 +836,8 @@ ceph_add_osd_perf_query(BaseMgrModule *self, PyObject *args)
     {"latency", PerformanceCounterType::LATENCY},
     {"write_latency", PerformanceCounterType::WRITE_LATENCY},
     {"read_latency", PerformanceCounterType::READ_LATENCY},
+    {"queue_latency", PerformanceCounterType::QUEUE_LATENCY},
+    {"process_latency", PerformanceCounterType::PROCESS_LATENCY},
   };
 
   PyObject *py_query = nullptr;
@@ -1434,6 +1442,9 @@ PyMethodDef BaseMgrModule_methods[] = {
   {"_ceph_get_latest_counter", (PyCFunction)get_latest_counter, METH_VARARGS,
     "Get the latest performance counter"},
 
+  {"_ceph_get_native_metrics", (PyCFunction)get_native_metrics, METH_NOARGS,
+    "Get perf counters and pg states in the Prometheus text format"},
+
   {"_ceph_get_perf_schema", (PyCFunction)get_perf_schema, METH_VARARGS,
     "Get the performance counter schema"},
 
@@ -635,6 +635,9 @@ bool DaemonServer::handle_report(const ref_t<MMgrReport>& m)
       std::lock_guard l(daemon->lock);
       auto &daemon_counters = daemon->perf_counters;
       daemon_counters.update(*m.get());
+      if (MetricsExporter::exports(key.type)) {
+        metrics_exporter.update_daemon(key, daemon_counters);
+      }
 
       auto p = m->config_bl.cbegin();
       if (p != m->config_bl.end()) {
@@ -2512,6 +2515,16 @@ void DaemonServer::_prune_pending_service_map()
   }
 }
 
+std::string DaemonServer::get_metrics()
+{
+  std::set<DaemonKey> live;
+  for (auto& [key, state] : daemon_state.get_all()) {
+    live.insert(key);
+  }
+  metrics_exporter.cull(live);
+  return metrics_exporter.dump();
+}
+
 void DaemonServer::send_report()
 {
   if (!pgmap_ready) {
@@ -2534,6 +2547,7 @@ void DaemonServer::send_report()
 
   cluster_state.with_mutable_pgmap([&](PGMap& pg_map) {
       cluster_state.update_delta_stats();
+      metrics_exporter.update_pgs(pg_map);
 
       if (pending_service_map.epoch) {
 	_prune_pending_service_map();
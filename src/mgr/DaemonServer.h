@@ -33,6 +33,7 @@
 #include "MetricCollector.h"
 #include "OSDPerfMetricCollector.h"
 #include "MDSPerfMetricCollector.h"
+#include "MetricsExporter.h"
 
 class MMgrReport;
 class MMgrOpen;
@@ -224,6 +225,8 @@ private:
   MDSPerfMetricCollector mds_perf_metric_collector;
   void handle_mds_perf_metric_query_updated();
 
+  MetricsExporter metrics_exporter;
+
   void handle_metric_payload(const OSDMetricPayload &payload) {
     osd_perf_metric_collector.process_reports(payload);
   }
@@ -281,6 +284,8 @@ public:
   bool handle_command(const ceph::ref_t<MMgrCommand>& m);
   bool _handle_command(std::shared_ptr<CommandContext>& cmdctx);
   void send_report();
+  /// perf counters and pg states in the Prometheus text format
+  std::string get_metrics();
   void got_service_map();
   void got_mgr_map();
   void adjust_pgs();
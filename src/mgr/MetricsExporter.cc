@@ -0,0 +1,226 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+
+#include "MetricsExporter.h"
+
+#include <regex>
+
+#include <fmt/format.h>
+
+#include "common/perf_counters.h"
+#include "mgr/DaemonState.h"
+#include "mon/PGMap.h"
+
+namespace {
+
+// as the prometheus module does
+std::string promethize(const std::string& path)
+{
+  std::string r = "ceph_";
+  for (size_t i = 0; i < path.size(); ++i) {
+    char c = path[i];
+    if (c == '.' || c == '/' || isspace(c)) {
+      r += '_';
+    } else if (c == ':' && i + 1 < path.size() && path[i + 1] == ':') {
+      r += '_';
+      ++i;
+    } else if (c == '+') {
+      r += "_plus";
+    } else if (c == '-') {
+      r += (i + 1 == path.size()) ? "_minus" : "_";
+    } else {
+      r += c;
+    }
+  }
+  return r;
+}
+
+/// the metric name and labels of counter @p path of daemon @p daemon
+std::pair<std::string, std::string> path_labels(const DaemonKey& key,
+						const std::string& path)
+{
+  std::string daemon = ceph::to_string(key);
+  std::string labels = fmt::format("ceph_daemon=\"{}\"", daemon);
+  if (key.type == "rbd-mirror") {
+    static const std::regex image_re(
+      "^rbd_mirror_image_([^/]+)/(?:(?:([^/]+)/)?)(.*)\\.(replay(?:_bytes|_latency)?)$");
+    std::smatch m;
+    if (std::regex_match(path, m, image_re)) {
+      labels += fmt::format(",pool=\"{}\",namespace=\"{}\",image=\"{}\"",
+			    m.str(1), m.str(2), m.str(3));
+      return {promethize("rbd_mirror_image_" + m.str(4)), labels};
+    }
+  }
+  return {promethize(path), labels};
+}
+
+std::string value_str(perfcounter_type_d type, uint64_t v)
+{
+  if (type & PERFCOUNTER_TIME) {
+    // ns to seconds
+    return fmt::format("{}", v / 1000000000.0);
+  }
+  return fmt::format("{}", v);
+}
+
+} // anonymous namespace
+
+bool MetricsExporter::exports(const std::string& type)
+{
+  static const std::set<std::string> types = {
+    "mds", "mon", "osd", "rbd-mirror", "rgw", "tcmu-runner"
+  };
+  return types.count(type);
+}
+
+void MetricsExporter::update_daemon(const DaemonKey& key,
+				    const DaemonPerfCounters& counters)
+{
+  if (!enabled) {
+    return;
+  }
+  struct built_t {
+    std::string type;
+    std::string help;
+    std::string samples;
+  };
+  std::map<std::string, built_t> built;
+  auto add = [&](const std::string& name, const char* type,
+		 const std::string& help, const std::string& labels,
+		 const std::string& value) {
+    auto& b = built[name];
+    if (b.type.empty()) {
+      b.type = type;
+      b.help = help;
+    }
+    b.samples += fmt::format("{}{{{}}} {}\n", name, labels, value);
+  };
+
+  for (auto& [path, instance] : counters.instances) {
+    auto t = counters.types.find(path);
+    if (t == counters.types.end() ||
+	t->second.priority < PerfCountersBuilder::PRIO_USEFUL) {
+      continue;
+    }
+    const auto& type = t->second;
+    auto [name, labels] = path_labels(key, path);
+    const int typeonly = type.type & ~(PERFCOUNTER_TIME | PERFCOUNTER_U64);
+    if (typeonly == PERFCOUNTER_LONGRUNAVG) {
+      // sum/count pairs
+      if (instance.get_data_avg().empty()) {
+	continue;
+      }
+      const auto& d = instance.get_latest_data_avg();
+      add(name + "_sum", "counter", type.description + " Total", labels,
+	  value_str(type.type, d.s));
+      add(name + "_count", "counter", type.description + " Count", labels,
+	  fmt::format("{}", d.c));
+    } else if (typeonly == PERFCOUNTER_NONE || typeonly == PERFCOUNTER_COUNTER) {
+      // histograms are represented by the long running avgs
+      if (instance.get_data().empty()) {
+	continue;
+      }
+      add(name, typeonly == PERFCOUNTER_NONE ? "gauge" : "counter",
+	  type.description, labels,
+	  value_str(type.type, instance.get_latest_data().v));
+    }
+  }
+
+  std::lock_guard l(lock);
+  _remove(key);
+  auto& mine = daemon_families[key];
+  for (auto& [name, b] : built) {
+    auto& f = families[name];
+    if (f.type.empty()) {
+      f.type = std::move(b.type);
+      f.help = std::move(b.help);
+    }
+    f.samples[key] = std::move(b.samples);
+    mine.insert(name);
+  }
+}
+
+void MetricsExporter::_remove(const DaemonKey& key)
+{
+  auto p = daemon_families.find(key);
+  if (p == daemon_families.end()) {
+    return;
+  }
+  for (auto& name : p->second) {
+    auto f = families.find(name);
+    if (f == families.end()) {
+      continue;
+    }
+    f->second.samples.erase(key);
+    if (f->second.samples.empty()) {
+      families.erase(f);
+    }
+  }
+  daemon_families.erase(p);
+}
+
+void MetricsExporter::update_pgs(const PGMap& pg_map)
+{
+  if (!enabled) {
+    return;
+  }
+  // state -> pool -> pgs, a pg counting once for each of its states
+  std::map<std::string, std::map<int64_t, int64_t>> by_state;
+  for (auto& [pool, states] : pg_map.num_pg_by_pool_state) {
+    int64_t total = 0;
+    for (auto& [state, num] : states) {
+      total += num;
+      if (state == 0) {
+	by_state["unknown"][pool] += num;
+      }
+      for (uint64_t bit = 1; bit && bit <= state; bit <<= 1) {
+	if (state & bit) {
+	  by_state[pg_state_string(bit)][pool] += num;
+	}
+      }
+    }
+    by_state["total"][pool] = total;
+  }
+
+  std::string text;
+  for (auto& [state, pools] : by_state) {
+    auto name = promethize("pg_" + state);
+    text += fmt::format("# HELP {} {}\n# TYPE {} gauge\n", name,
+			state == "total" ? std::string("PG Total Count per Pool") :
+			fmt::format("PG {} per pool", state),
+			name);
+    for (auto& [pool, num] : pools) {
+      text += fmt::format("{}{{pool_id=\"{}\"}} {}\n", name, pool, num);
+    }
+  }
+
+  std::lock_guard l(lock);
+  pgs.swap(text);
+}
+
+void MetricsExporter::cull(const std::set<DaemonKey>& live)
+{
+  std::lock_guard l(lock);
+  for (auto p = daemon_families.begin(); p != daemon_families.end(); ) {
+    auto key = (p++)->first;
+    if (!live.count(key)) {
+      _remove(key);
+    }
+  }
+}
+
+std::string MetricsExporter::dump()
+{
+  enabled = true;
+  std::lock_guard l(lock);
+  std::string out;
+  for (auto& [name, f] : families) {
+    out += fmt::format("# HELP {} {}\n# TYPE {} {}\n",
+		       name, f.help, name, f.type);
+    for (auto& [key, samples] : f.samples) {
+      out += samples;
+    }
+  }
+  out += pgs;
+  return out;
+}
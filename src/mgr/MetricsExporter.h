@@ -0,0 +1,53 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+
+#pragma once
+
+#include <atomic>
+#include <map>
+#include <set>
+#include <string>
+
+#include "common/ceph_mutex.h"
+#include "mgr/DaemonKey.h"
+
+class DaemonPerfCounters;
+class PGMap;
+
+/**
+ * Perf counters and pg states in the Prometheus text format.
+ *
+ * The samples of a daemon are rebuilt when it reports, and those of the
+ * pgs with each pg map digest, so a scrape only concatenates text and
+ * does not walk the daemon states under the GIL.  Names, labels and
+ * types are the ones the prometheus module uses for the same data.
+ *
+ * Nothing is cached until the first dump(): the daemons then show up as
+ * they next report.
+ */
+class MetricsExporter {
+public:
+  /// whether the perf counters of daemons of @p type are exported
+  static bool exports(const std::string& type);
+
+  void update_daemon(const DaemonKey& key, const DaemonPerfCounters& counters);
+  void update_pgs(const PGMap& pg_map);
+  /// forget the daemons not in @p live
+  void cull(const std::set<DaemonKey>& live);
+  std::string dump();
+
+private:
+  struct family_t {
+    std::string type;
+    std::string help;
+    std::map<DaemonKey, std::string> samples;  ///< lines, by daemon
+  };
+
+  std::atomic<bool> enabled = {false};
+  ceph::mutex lock = ceph::make_mutex("MetricsExporter::lock");
+  std::map<std::string, family_t> families;     ///< by metric name
+  std::map<DaemonKey, std::set<std::string>> daemon_families;
+  std::string pgs;  ///< the pg state families
+
+  void _remove(const DaemonKey& key);
+};
@@ -180,6 +180,7 @@ void MgrClient::reconnect()
   session.reset(new MgrSessionState());
   session->con = msgr->connect_to(CEPH_ENTITY_TYPE_MGR,
 				  map.get_active_addrs());
+  pgstats_full = true;
 
   if (service_daemon) {
     daemon_dirty_status = true;
@@ -364,10 +365,13 @@ void MgrClient::_send_report()
 	session->declared.insert(path);
       }
 
-      encode(static_cast<uint64_t>(data.u64), report->packed);
       if (data.type & PERFCOUNTER_LONGRUNAVG) {
-        encode(static_cast<uint64_t>(data.avgcount), report->packed);
-        encode(static_cast<uint64_t>(data.avgcount2), report->packed);
+        auto [sum, count] = data.read_avg();
+        encode(sum, report->packed);
+        encode(count, report->packed);
+        encode(count, report->packed);
+      } else {
+        encode(data.read_u64(), report->packed);
       }
     }
     ENCODE_FINISH(report->packed);
@@ -419,7 +423,8 @@ void MgrClient::send_pgstats()
 void MgrClient::_send_pgstats()
 {
   if (pgstats_cb && session) {
-    session->con->send_message(pgstats_cb());
+    session->con->send_message(pgstats_cb(pgstats_full));
+    pgstats_full = false;
   }
 }
 
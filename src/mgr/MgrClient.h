@@ -85,8 +85,10 @@ protected:
   Context *connect_retry_callback = nullptr;
 
   // If provided, use this to compose an MPGStats to send with
-  // our reports (hook for use by OSD)
-  std::function<MPGStats*()> pgstats_cb;
+  // our reports (hook for use by OSD); the stats of every pg are wanted
+  // when the argument is true, as for the first report of a session
+  std::function<MPGStats*(bool)> pgstats_cb;
+  bool pgstats_full = true;
   std::function<void(const ConfigPayload &)> set_perf_queries_cb;
   std::function<MetricPayload()> get_perf_report_cb;
 
@@ -141,7 +143,7 @@ public:
   }
 
   void send_pgstats();
-  void set_pgstats_cb(std::function<MPGStats*()>&& cb_)
+  void set_pgstats_cb(std::function<MPGStats*(bool)>&& cb_)
   {
     std::lock_guard l(lock);
     pgstats_cb = std::move(cb_);
@@ -55,6 +55,8 @@ void PerformanceCounterDescriptor::pack_counter(const PerformanceCounter &c,
   case PerformanceCounterType::LATENCY:
   case PerformanceCounterType::WRITE_LATENCY:
   case PerformanceCounterType::READ_LATENCY:
+  case PerformanceCounterType::QUEUE_LATENCY:
+  case PerformanceCounterType::PROCESS_LATENCY:
     encode(c.second, *bl);
     break;
   default:
@@ -77,6 +79,8 @@ void PerformanceCounterDescriptor::unpack_counter(
   case PerformanceCounterType::LATENCY:
   case PerformanceCounterType::WRITE_LATENCY:
   case PerformanceCounterType::READ_LATENCY:
+  case PerformanceCounterType::QUEUE_LATENCY:
+  case PerformanceCounterType::PROCESS_LATENCY:
     decode(c->second, bl);
     break;
   default:
@@ -105,6 +109,10 @@ std::ostream& operator<<(std::ostream& os,
     return os << "write latency";
   case PerformanceCounterType::READ_LATENCY:
     return os << "read latency";
+  case PerformanceCounterType::QUEUE_LATENCY:
+    return os << "queue latency";
+  case PerformanceCounterType::PROCESS_LATENCY:
+    return os << "process latency";
   default:
     return os << "unknown (" << static_cast<int>(d.type) << ")";
   }
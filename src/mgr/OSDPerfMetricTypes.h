@@ -138,6 +138,8 @@ enum class PerformanceCounterType : uint8_t {
   LATENCY = 6,
   WRITE_LATENCY = 7,
   READ_LATENCY = 8,
+  QUEUE_LATENCY = 9,   ///< from the receipt of an op to its dequeue
+  PROCESS_LATENCY = 10, ///< from the dequeue of an op to its completion
 };
 
 struct PerformanceCounterDescriptor {
@@ -154,6 +156,8 @@ struct PerformanceCounterDescriptor {
     case PerformanceCounterType::LATENCY:
     case PerformanceCounterType::WRITE_LATENCY:
     case PerformanceCounterType::READ_LATENCY:
+    case PerformanceCounterType::QUEUE_LATENCY:
+    case PerformanceCounterType::PROCESS_LATENCY:
       return true;
     default:
       return false;
@@ -3619,6 +3619,13 @@ void Monitor::handle_command(MonOpRequestRef op)
   } else if (prefix == "status" ||
 	     prefix == "health" ||
 	     prefix == "df") {
+    // as the services do for their reads: a peon serves these while its
+    // lease holds, so that they are at most a lease behind the leader
+    if (!paxos->is_readable(0)) {
+      dout(10) << " waiting for paxos -> readable" << dendl;
+      paxos->wait_for_readable(op, new C_RetryMessage(this, op));
+      return;
+    }
     string detail;
     cmd_getval(cmdmap, "detail", detail);
 
@@ -15,6 +15,7 @@
 
 #include "include/types.h"
 #include "include/buffer.h"
+#include "include/stringify.h"
 #include <set>
 #include <map>
 #include <string>
@@ -31,9 +32,22 @@
 #include "common/safe_io.h"
 #include "common/blkdev.h"
 #include "common/PriorityCache.h"
+#include "common/Thread.h"
+#include "common/ceph_time.h"
+#include "common/perf_counters.h"
 
 #define dout_context g_ceph_context
 
+enum {
+  l_monstore_first = 45900,
+  l_monstore_tombstones,
+  l_monstore_tombstones_pending,
+  l_monstore_compact_trim,
+  l_monstore_compact_trim_lat,
+  l_monstore_compact_trim_queue_len,
+  l_monstore_last,
+};
+
 class MonitorDBStore
 {
   std::string path;
@@ -48,6 +62,118 @@ class MonitorDBStore
 
   bool is_open;
 
+  PerfCounters *logger = nullptr;
+
+  /**
+   * TrimCompactor
+   *
+   * Compacts the key ranges the services trim, in the background and one
+   * range at a time, leaving the store at least
+   * mon_compact_on_trim_interval seconds between two compactions so that
+   * they don't starve the commits.  The ranges queued meanwhile for a
+   * prefix are merged, so a burst of trims turns into a few compactions
+   * of just the trimmed keys rather than a backlog of them.
+   */
+  struct TrimCompactor : public Thread {
+    struct Range {
+      std::string prefix;
+      std::string start;
+      std::string end;
+      uint64_t tombstones = 0;
+    };
+
+    MonitorDBStore *store;
+    ceph::mutex lock = ceph::make_mutex("MonitorDBStore::TrimCompactor::lock");
+    ceph::condition_variable cond;
+    std::list<Range> queue;
+    uint64_t tombstones_pending = 0;
+    bool stopping = false;
+
+    explicit TrimCompactor(MonitorDBStore *store) : store(store) {}
+
+    void queue_range(const std::string& prefix, const std::string& start,
+		     const std::string& end, uint64_t tombstones) {
+      std::lock_guard l(lock);
+      tombstones_pending += tombstones;
+      auto p = queue.begin();
+      for (; p != queue.end(); ++p) {
+	if (p->prefix == prefix && start <= p->end && p->start <= end) {
+	  p->start = std::min(p->start, start);
+	  p->end = std::max(p->end, end);
+	  p->tombstones += tombstones;
+	  break;
+	}
+      }
+      if (p == queue.end()) {
+	queue.push_back(Range{prefix, start, end, tombstones});
+      }
+      update_logger();
+      cond.notify_all();
+      if (!is_started()) {
+	create("mon_compact");
+      }
+    }
+
+    void stop() {
+      {
+	std::lock_guard l(lock);
+	stopping = true;
+	cond.notify_all();
+      }
+      if (is_started()) {
+	join();
+      }
+      // the tombstones left get compacted by the next trims, or rocksdb
+      std::lock_guard l(lock);
+      stopping = false;
+      queue.clear();
+      tombstones_pending = 0;
+    }
+
+    void update_logger() {
+      if (store->logger) {
+	store->logger->set(l_monstore_tombstones_pending, tombstones_pending);
+	store->logger->set(l_monstore_compact_trim_queue_len, queue.size());
+      }
+    }
+
+    void *entry() override {
+      std::unique_lock l(lock);
+      ceph::mono_time next;
+      while (!stopping) {
+	if (queue.empty()) {
+	  cond.wait(l);
+	  continue;
+	}
+	auto now = ceph::mono_clock::now();
+	if (now < next) {
+	  cond.wait_for(l, next - now);
+	  continue;
+	}
+
+	auto range = std::move(queue.front());
+	queue.pop_front();
+	l.unlock();
+	lsubdout(g_ceph_context, mon, 10) << "compacting trimmed "
+	  << range.prefix << " " << range.start << ".." << range.end
+	  << ", " << range.tombstones << " tombstones" << dendl;
+	store->db->compact_range(range.prefix, range.start, range.end);
+	auto end = ceph::mono_clock::now();
+	l.lock();
+
+	tombstones_pending -= range.tombstones;
+	if (store->logger) {
+	  store->logger->inc(l_monstore_compact_trim);
+	  store->logger->tinc(l_monstore_compact_trim_lat, end - now);
+	}
+	update_logger();
+	next = end + ceph::make_timespan(
+	  g_conf().get_val<double>("mon_compact_on_trim_interval"));
+      }
+      return nullptr;
+    }
+  } trim_compactor;
+
  public:
 
   std::string get_devname() {
@@ -182,6 +308,30 @@ class MonitorDBStore
       ops.push_back(Op(OP_COMPACT, prefix, start, end));
     }
 
+    /// compact the keys of versions [first, last], as put by put(prefix,
+    /// ver) if key_prefix is empty.  the keys are decimal and don't sort
+    /// like the versions across a change in the number of digits, so
+    /// each run of versions with as many digits gets its own range.
+    void compact_versions(const std::string& prefix,
+			  const std::string& key_prefix,
+			  version_t first, version_t last) {
+      while (first <= last) {
+	version_t run_last = 9;
+	while (run_last < first && run_last <= (UINT64_MAX - 9) / 10) {
+	  run_last = run_last * 10 + 9;
+	}
+	if (run_last < first || run_last > last) {
+	  run_last = last;
+	}
+	compact_range(prefix, key_prefix + stringify(first),
+		      key_prefix + stringify(run_last));
+	if (run_last == last) {
+	  break;
+	}
+	first = run_last + 1;
+      }
+    }
+
     void encode(ceph::buffer::list& bl) const {
       ENCODE_START(2, 1, bl);
       encode(ops, bl);
@@ -316,6 +466,7 @@ class MonitorDBStore
     }
 
     std::list<std::pair<std::string, std::pair<std::string,std::string>>> compact;
+    std::map<std::string, uint64_t> tombstones;
     for (auto it = t->ops.begin(); it != t->ops.end(); ++it) {
       const Op& op = *it;
       switch (op.type) {
@@ -324,9 +475,11 @@ class MonitorDBStore
 	break;
       case Transaction::OP_ERASE:
 	dbt->rmkey(op.prefix, op.key);
+	++tombstones[op.prefix];
 	break;
       case Transaction::OP_ERASE_RANGE:
 	dbt->rm_range_keys(op.prefix, op.key, op.endkey);
+	++tombstones[op.prefix];
 	break;
       case Transaction::OP_COMPACT:
 	compact.push_back(make_pair(op.prefix, make_pair(op.key, op.endkey)));
@@ -339,12 +492,26 @@ class MonitorDBStore
     }
     int r = db->submit_transaction_sync(dbt);
     if (r >= 0) {
+      if (logger) {
+	for (auto& [prefix, n] : tombstones) {
+	  logger->inc(l_monstore_tombstones, n);
+	}
+      }
       while (!compact.empty()) {
-	if (compact.front().second.first == std::string() &&
-	    compact.front().second.second == std::string())
-	  db->compact_prefix_async(compact.front().first);
-	else
-	  db->compact_range_async(compact.front().first, compact.front().second.first, compact.front().second.second);
+	auto& [prefix, range] = compact.front();
+	if (range.first == std::string() &&
+	    range.second == std::string()) {
+	  db->compact_prefix_async(prefix);
+	} else {
+	  // the tombstones of the transaction go to the first range of
+	  // their prefix
+	  auto p = tombstones.find(prefix);
+	  uint64_t n = 0;
+	  if (p != tombstones.end()) {
+	    std::swap(n, p->second);
+	  }
+	  trim_compactor.queue_range(prefix, range.first, range.second, n);
+	}
 	compact.pop_front();
       }
     } else {
@@ -680,6 +847,7 @@ class MonitorDBStore
           PerfCountersBuilder::PRIO_USEFUL - PerfCountersBuilder::PRIO_DEBUGONLY);
     }
 
+    init_logger();
     io_work.start();
     is_open = true;
     return 0;
@@ -699,6 +867,7 @@ class MonitorDBStore
     r = db->create_and_open(out);
     if (r < 0)
       return r;
+    init_logger();
     io_work.start();
     is_open = true;
     return 0;
@@ -707,10 +876,33 @@ class MonitorDBStore
   void close() {
     // there should be no work queued!
     io_work.stop();
+    trim_compactor.stop();
     is_open = false;
+    if (logger) {
+      g_ceph_context->get_perfcounters_collection()->remove(logger);
+      delete logger;
+      logger = nullptr;
+    }
     db.reset(NULL);
   }
 
+  void init_logger() {
+    PerfCountersBuilder pcb(g_ceph_context, "mon_store", l_monstore_first,
+			    l_monstore_last);
+    pcb.add_u64_counter(l_monstore_tombstones, "tombstones",
+			"Keys erased from the store");
+    pcb.add_u64(l_monstore_tombstones_pending, "tombstones_pending",
+		"Keys erased by trims, waiting for their range compaction");
+    pcb.add_u64_counter(l_monstore_compact_trim, "compact_trim",
+			"Compactions of trimmed key ranges");
+    pcb.add_time_avg(l_monstore_compact_trim_lat, "compact_trim_lat",
+		     "Latency of the compactions of trimmed key ranges");
+    pcb.add_u64(l_monstore_compact_trim_queue_len, "compact_trim_queue_len",
+		"Trimmed key ranges waiting to be compacted");
+    logger = pcb.create_perf_counters();
+    g_ceph_context->get_perfcounters_collection()->add(logger);
+  }
+
   void compact() {
     db->compact();
   }
@@ -786,7 +978,8 @@ class MonitorDBStore
       dump_fd_binary(-1),
       dump_fmt(true),
       io_work(g_ceph_context, "monstore", "fn_monstore"),
-      is_open(false) {
+      is_open(false),
+      trim_compactor(this) {
   }
   ~MonitorDBStore() {
     ceph_assert(!is_open);
@@ -816,6 +816,7 @@ void OSDMonitor::update_from_paxos(bool *need_bootstrap)
     OSDMap::Incremental inc(inc_bl);
     err = osdmap.apply_incremental(inc);
     ceph_assert(err == 0);
+    mapping.note_incremental(inc);
 
     if (!t)
       t.reset(new MonitorDBStore::Transaction);
@@ -4415,12 +4416,58 @@ void OSDMonitor::send_latest(MonOpRequestRef op, epoch_t start)
 }
 
 
+MOSDMap *OSDMonitor::lookup_osdmap_msg(const osdmap_msg_key_t& key,
+					 uint64_t features)
+{
+  auto& c = osdmap_msg_cache;
+  if (c.oldest != get_first_committed() ||
+      c.newest != osdmap.get_epoch()) {
+    c.msgs.clear();
+    c.oldest = get_first_committed();
+    c.newest = osdmap.get_epoch();
+    return nullptr;
+  }
+  auto p = c.msgs.find(key);
+  if (p == c.msgs.end()) {
+    return nullptr;
+  }
+  dout(20) << __func__ << " [" << std::get<0>(key) << ".."
+	   << std::get<1>(key) << "] cached" << dendl;
+  MOSDMap *m = new MOSDMap(mon.monmap->fsid, features);
+  m->oldest_map = c.oldest;
+  m->newest_map = c.newest;
+  m->maps = p->second.maps;
+  m->incremental_maps = p->second.incremental_maps;
+  return m;
+}
+
+void OSDMonitor::cache_osdmap_msg(const osdmap_msg_key_t& key,
+				  const MOSDMap *m)
+{
+  auto& c = osdmap_msg_cache;
+  if (c.msgs.size() >=
+      g_conf().get_val<uint64_t>("mon_osd_map_message_cache_size") ||
+      c.oldest != m->oldest_map ||
+      c.newest != m->newest_map) {
+    return;
+  }
+  auto& cached = c.msgs[key];
+  cached.maps = m->maps;
+  cached.incremental_maps = m->incremental_maps;
+}
+
 MOSDMap *OSDMonitor::build_latest_full(uint64_t features)
 {
+  osdmap_msg_key_t key{0, osdmap.get_epoch(),
+		       OSDMap::get_significant_features(features)};
+  if (MOSDMap *m = lookup_osdmap_msg(key, features); m) {
+    return m;
+  }
   MOSDMap *r = new MOSDMap(mon.monmap->fsid, features);
   get_version_full(osdmap.get_epoch(), features, r->maps[osdmap.get_epoch()]);
   r->oldest_map = get_first_committed();
   r->newest_map = osdmap.get_epoch();
+  cache_osdmap_msg(key, r);
   return r;
 }
 
@@ -4428,6 +4475,10 @@ MOSDMap *OSDMonitor::build_incremental(epoch_t from, epoch_t to, uint64_t featur
 {
   dout(10) << "build_incremental [" << from << ".." << to << "] with features "
 	   << std::hex << features << std::dec << dendl;
+  osdmap_msg_key_t key{from, to, OSDMap::get_significant_features(features)};
+  if (MOSDMap *m = lookup_osdmap_msg(key, features); m) {
+    return m;
+  }
   MOSDMap *m = new MOSDMap(mon.monmap->fsid, features);
   m->oldest_map = get_first_committed();
   m->newest_map = osdmap.get_epoch();
@@ -4455,6 +4506,7 @@ MOSDMap *OSDMonitor::build_incremental(epoch_t from, epoch_t to, uint64_t featur
       }
     }
   }
+  cache_osdmap_msg(key, m);
   return m;
 }
 
@@ -4505,6 +4557,28 @@ void OSDMonitor::send_incremental(epoch_t first,
     first = session->osd_epoch + 1;
   }
 
+  // a client only needs the latest map: rather than all the incrementals
+  // it missed, send a far behind one the latest full map, with the maps
+  // before it advertised as gone so that it jumps over them
+  auto catchup = g_conf().get_val<uint64_t>("mon_osd_client_full_map_catchup");
+  if (catchup > 0 &&
+      session->name.is_client() &&
+      first > 0 &&
+      first + catchup <= osdmap.get_epoch()) {
+    dout(10) << __func__ << " " << session->name << " is "
+	     << osdmap.get_epoch() - first + 1
+	     << " epochs behind, sending the latest full map" << dendl;
+    MOSDMap *m = build_latest_full(features);
+    m->oldest_map = osdmap.get_epoch();
+    if (req) {
+      mon.send_reply(req, m);
+    } else {
+      session->con->send_message(m);
+    }
+    session->osd_epoch = osdmap.get_epoch();
+    return;
+  }
+
   if (first < get_first_committed()) {
     MOSDMap *m = new MOSDMap(osdmap.get_fsid(), features);
     m->oldest_map = get_first_committed();
@@ -5383,7 +5457,7 @@ namespace {
     CSUM_TYPE, CSUM_MAX_BLOCK, CSUM_MIN_BLOCK, FINGERPRINT_ALGORITHM,
     PG_AUTOSCALE_MODE, PG_NUM_MIN, TARGET_SIZE_BYTES, TARGET_SIZE_RATIO,
     PG_AUTOSCALE_BIAS, DEDUP_TIER, DEDUP_CHUNK_ALGORITHM, 
-    DEDUP_CDC_CHUNK_SIZE };
+    DEDUP_CDC_CHUNK_SIZE, COMPRESSION_DICTIONARY };
 
   std::set<osd_pool_get_choices>
     subtract_second_from_first(const std::set<osd_pool_get_choices>& first,
@@ -6121,6 +6195,7 @@ bool OSDMonitor::preprocess_command(MonOpRequestRef op)
       {"dedup_tier", DEDUP_TIER},
       {"dedup_chunk_algorithm", DEDUP_CHUNK_ALGORITHM},
       {"dedup_cdc_chunk_size", DEDUP_CDC_CHUNK_SIZE},
+      {"compression_dictionary", COMPRESSION_DICTIONARY},
     };
 
     typedef std::set<osd_pool_get_choices> choices_set_t;
@@ -6340,6 +6415,7 @@ bool OSDMonitor::preprocess_command(MonOpRequestRef op)
 	  case DEDUP_TIER:
 	  case DEDUP_CHUNK_ALGORITHM:
 	  case DEDUP_CDC_CHUNK_SIZE:
+	  case COMPRESSION_DICTIONARY:
             pool_opts_t::key_t key = pool_opts_t::get_opt_desc(i->first).key;
             if (p->opts.is_set(key)) {
               if(*it == CSUM_TYPE) {
@@ -6500,6 +6576,7 @@ bool OSDMonitor::preprocess_command(MonOpRequestRef op)
 	  case DEDUP_TIER:
 	  case DEDUP_CHUNK_ALGORITHM:
 	  case DEDUP_CDC_CHUNK_SIZE:
+	  case COMPRESSION_DICTIONARY:
 	    for (i = ALL_CHOICES.begin(); i != ALL_CHOICES.end(); ++i) {
 	      if (i->second == *it)
 		break;
@@ -8698,6 +8775,30 @@ int OSDMonitor::prepare_command_pool_set(const cmdmap_t& cmdmap,
         ss << "error parsing int value '" << val << "': " << interr;
         return -EINVAL;
       }
+    } else if (var == "compression_dictionary") {
+      if (!unset) {
+        // every osdmap carries it, to clients as well
+        auto max = g_conf().get_val<Option::size_t>(
+          "mon_max_pool_compression_dictionary_size");
+        if (val.length() > max) {
+          ss << "compression_dictionary is " << val.length()
+             << " bytes, more than mon_max_pool_compression_dictionary_size "
+             << max;
+          return -EINVAL;
+        }
+        // the first dictionary is used for writes, all of them for reads
+        for (auto& d : get_str_vec(val, ",")) {
+          bufferlist in, raw;
+          in.append(d);
+          try {
+            raw.decode_base64(in);
+          } catch (const buffer::error&) {
+            ss << "compression_dictionary must be a comma separated list of "
+               << "base64 encoded dictionaries";
+            return -EINVAL;
+          }
+        }
+      }
     }
 
     pool_opts_t::opt_desc_t desc = pool_opts_t::get_opt_desc(var);
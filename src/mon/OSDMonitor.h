@@ -23,6 +23,7 @@
 
 #include <map>
 #include <set>
+#include <tuple>
 #include <utility>
 
 #include "include/types.h"
@@ -231,6 +232,25 @@ public:
   osdmap_cache_t inc_osd_cache;
   osdmap_cache_t full_osd_cache;
 
+  /// the maps of the MOSDMaps built for a range of epochs and the
+  /// significant features of a session, so that the sessions catching up
+  /// from the same epoch, as they all do after an election, share them
+  /// instead of each looking every epoch up again
+  using osdmap_msg_key_t = std::tuple<epoch_t, epoch_t, uint64_t>;
+  struct osdmap_msg_t {
+    std::map<epoch_t, ceph::buffer::list> maps;
+    std::map<epoch_t, ceph::buffer::list> incremental_maps;
+  };
+  struct {
+    // all the messages have the same oldest/newest maps
+    epoch_t oldest = 0;
+    epoch_t newest = 0;
+    std::map<osdmap_msg_key_t, osdmap_msg_t> msgs;
+  } osdmap_msg_cache;
+
+  MOSDMap *lookup_osdmap_msg(const osdmap_msg_key_t& key, uint64_t features);
+  void cache_osdmap_msg(const osdmap_msg_key_t& key, const MOSDMap *m);
+
   bool has_osdmap_manifest;
   osdmap_manifest_t osdmap_manifest;
 
@@ -872,6 +872,13 @@ void Paxos::commit_start()
 
   get_store()->queue_transaction(t, new C_Committed(this));
 
+  // every quorum member accepted the value: it is chosen whether or not
+  // our own write of the commit lands, so the peons need not wait for it
+  if (g_conf()->paxos_parallel_commit) {
+    send_commit(last_committed + 1);
+    commit_sent = true;
+  }
+
   if (is_updating_previous())
     state = STATE_WRITING_PREVIOUS;
   else if (is_updating())
@@ -909,20 +916,10 @@ void Paxos::commit_finish()
   _sanity_check_store();
 
   // tell everyone
-  for (auto p = mon.get_quorum().begin();
-       p != mon.get_quorum().end();
-       ++p) {
-    if (*p == mon.rank) continue;
-
-    dout(10) << " sending commit to mon." << *p << dendl;
-    MMonPaxos *commit = new MMonPaxos(mon.get_epoch(), MMonPaxos::OP_COMMIT,
-				      ceph_clock_now());
-    commit->values[last_committed] = new_value;
-    commit->pn = accepted_pn;
-    commit->last_committed = last_committed;
-
-    mon.send_mon_message(commit, *p);
+  if (!commit_sent) {
+    send_commit(last_committed);
   }
+  commit_sent = false;
 
   ceph_assert(g_conf()->paxos_kill_at != 9);
 
@@ -950,6 +947,23 @@ void Paxos::commit_finish()
   }
 }
 
+void Paxos::send_commit(version_t v)
+{
+  for (auto p = mon.get_quorum().begin();
+       p != mon.get_quorum().end();
+       ++p) {
+    if (*p == mon.rank) continue;
+
+    dout(10) << " sending commit " << v << " to mon." << *p << dendl;
+    MMonPaxos *commit = new MMonPaxos(mon.get_epoch(), MMonPaxos::OP_COMMIT,
+				      ceph_clock_now());
+    commit->values[v] = new_value;
+    commit->pn = accepted_pn;
+    commit->last_committed = v;
+
+    mon.send_mon_message(commit, *p);
+  }
+}
 
 void Paxos::handle_commit(MonOpRequestRef op)
 {
@@ -1251,7 +1265,7 @@ void Paxos::trim()
   t->put(get_name(), "first_committed", end);
   if (g_conf()->mon_compact_on_trim) {
     dout(10) << " compacting trimmed range" << dendl;
-    t->compact_range(get_name(), stringify(first_committed - 1), stringify(end));
+    t->compact_versions(get_name(), "", first_committed, end - 1);
   }
 
   trimming = true;
@@ -1403,6 +1417,7 @@ void Paxos::restart()
     mon.lock.lock();
     dout(10) << __func__ << " flushed" << dendl;
   }
+  commit_sent = false;
   state = STATE_RECOVERING;
 
   // discard pending transaction
@@ -873,6 +873,7 @@ private:
 
 
   utime_t commit_start_stamp;
+  bool commit_sent = false;  ///< peons told to commit before we wrote it
   friend struct C_Committed;
 
   /**
@@ -890,6 +891,7 @@ private:
    */
   void commit_start();
   void commit_finish();   ///< finish a commit after txn becomes durable
+  void send_commit(version_t v);  ///< tell the quorum to commit @p v
   void abort_commit();    ///< Handle commit finish after shutdown started
   /**
    * Commit the new value to stable storage as being the latest available
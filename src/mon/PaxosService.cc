@@ -444,10 +444,10 @@ void PaxosService::trim(MonitorDBStore::TransactionRef t,
   }
   if (g_conf()->mon_compact_on_trim) {
     dout(20) << " compacting prefix " << get_service_name() << dendl;
-    t->compact_range(get_service_name(), stringify(from - 1), stringify(to));
-    t->compact_range(get_service_name(),
-		     mon.store->combine_strings(full_prefix_name, from - 1),
-		     mon.store->combine_strings(full_prefix_name, to));
+    t->compact_versions(get_service_name(), "", from, to - 1);
+    t->compact_versions(get_service_name(),
+			mon.store->combine_strings(full_prefix_name, ""),
+			from, to - 1);
   }
 }
 
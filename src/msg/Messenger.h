@@ -556,6 +556,33 @@ public:
       bool anon=false, bool not_local_dest=false) {
 	return connect_to(CEPH_ENTITY_TYPE_OSD, dest, anon, not_local_dest);
   }
+  /**
+   * Get one of several parallel sessions with a peer.
+   *
+   * Messengers that support it keep up to ms_async_peer_lanes sessions
+   * with a peer, each with its own connection and worker thread, so that
+   * the traffic with one peer is not bound by a single thread and TCP
+   * flow.  Messages sent on one lane are delivered in order, those sent
+   * on different lanes are not.  Lane 0 is the session connect_to()
+   * returns, and is also used when the peer does not support lanes.
+   *
+   * @param type peer type
+   * @param dest peer address(es)
+   * @param lane index of the session, taken modulo the number of lanes
+   */
+  virtual ConnectionRef connect_to_lane(int type,
+					const entity_addrvec_t& dest,
+					unsigned lane) {
+    return connect_to(type, dest, false, true);
+  }
+  ConnectionRef connect_to_osd_lane(const entity_addrvec_t& dest,
+				    unsigned lane) {
+    return connect_to_lane(CEPH_ENTITY_TYPE_OSD, dest, lane);
+  }
+  /// the number of sessions connect_to_lane() spreads a peer over
+  virtual unsigned get_num_lanes() const {
+    return 1;
+  }
   ConnectionRef connect_to_mgr(const entity_addrvec_t& dest,
       bool anon=false, bool not_local_dest=false) {
 	return connect_to(CEPH_ENTITY_TYPE_MGR, dest, anon, not_local_dest);
@@ -148,6 +148,11 @@ public:
     unregistered = true;
   }
 
+  /// which of the sessions with the peer this is, see connect_to_lane()
+  unsigned lane = 0;
+  /// set once the peer tells it supports lanes
+  std::atomic<bool> peer_supports_lanes = {false};
+
  private:
   enum {
     STATE_NONE,
@@ -197,6 +202,8 @@ private:
   uint32_t recv_max_prefetch;
   uint32_t recv_start;
   uint32_t recv_end;
+  /// read no more than asked for: kernel TLS may take over the stream
+  bool no_prefetch = false;
   std::set<uint64_t> register_time_events; // need to delete it if stop
   ceph::coarse_mono_clock::time_point last_connect_started;
   ceph::coarse_mono_clock::time_point last_active;
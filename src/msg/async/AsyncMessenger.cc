@@ -175,6 +175,7 @@ void Processor::accept()
   opts.nodelay = msgr->cct->_conf->ms_tcp_nodelay;
   opts.rcbuf_size = msgr->cct->_conf->ms_tcp_rcvbuf;
   opts.priority = msgr->get_socket_priority();
+  opts.zerocopy_min_size = msgr->cct->_conf->ms_tcp_zerocopy_min_size;
 
   for (auto& listen_socket : listen_sockets) {
     ldout(msgr->cct, 10) << __func__ << " listen_fd=" << listen_socket.fd()
@@ -281,7 +282,9 @@ AsyncMessenger::AsyncMessenger(CephContext *cct, entity_name_t name,
                                const std::string &type, std::string mname, uint64_t _nonce)
   : SimplePolicyMessenger(cct, name),
     dispatch_queue(cct, this, mname),
-    nonce(_nonce)
+    nonce(_nonce),
+    num_lanes(std::max<unsigned>(
+      1, cct->_conf.get_val<uint64_t>("ms_async_peer_lanes")))
 {
   std::string transport_type = "posix";
   if (type.find("rdma") != std::string::npos)
@@ -584,7 +587,7 @@ void AsyncMessenger::add_accept(Worker *w, ConnectedSocket cli_socket,
 }
 
 AsyncConnectionRef AsyncMessenger::create_connect(
-  const entity_addrvec_t& addrs, int type, bool anon)
+  const entity_addrvec_t& addrs, int type, bool anon, unsigned lane)
 {
   ceph_assert(ceph_mutex_is_locked(lock));
 
@@ -609,14 +612,15 @@ AsyncConnectionRef AsyncMessenger::create_connect(
   auto conn = ceph::make_ref<AsyncConnection>(cct, this, &dispatch_queue, w,
 						target.is_msgr2(), false);
   conn->anon = anon;
+  conn->lane = lane;
   conn->connect(addrs, type, target);
   if (anon) {
     anon_conns.insert(conn);
   } else {
-    ceph_assert(!conns.count(addrs));
+    ceph_assert(!conns.count(conn_key_t(addrs, lane)));
     ldout(cct, 10) << __func__ << " " << conn << " " << addrs << " "
-		   << *conn->peer_addrs << dendl;
-    conns[addrs] = conn;
+		   << *conn->peer_addrs << " lane " << lane << dendl;
+    conns[conn_key_t(addrs, lane)] = conn;
   }
   w->get_perf_counter()->inc(l_msgr_active_connections);
 
@@ -727,6 +731,51 @@ ConnectionRef AsyncMessenger::connect_to(int type,
   return conn;
 }
 
+ConnectionRef AsyncMessenger::connect_to_lane(int type,
+					      const entity_addrvec_t& addrs,
+					      unsigned lane)
+{
+  lane %= num_lanes;
+  if (lane == 0) {
+    return connect_to(type, addrs, false, true);
+  }
+
+  auto av = _filter_addrs(addrs);
+  std::lock_guard l{lock};
+  AsyncConnectionRef conn = _lookup_conn(av, lane);
+  if (conn) {
+    return conn;
+  }
+  AsyncConnectionRef first = _lookup_conn(av);
+  if (!first) {
+    first = create_connect(av, type, false);
+    ldout(cct, 10) << __func__ << " " << av << " new " << first << dendl;
+  }
+  // until the first session is up and tells whether the peer supports
+  // lanes, all the messages go through it: what it queued before is sent
+  // before the new lane is even connected
+  if (!first->peer_supports_lanes || !first->is_connected()) {
+    return first;
+  }
+  conn = create_connect(av, type, false, lane);
+  ldout(cct, 10) << __func__ << " " << av << " lane " << lane
+		 << " new " << conn << dendl;
+  return conn;
+}
+
+std::vector<AsyncConnectionRef> AsyncMessenger::lookup_lane_conns(
+  const entity_addrvec_t& k)
+{
+  std::vector<AsyncConnectionRef> ls;
+  std::lock_guard l{lock};
+  for (auto& [key, c] : conns) {
+    if (key.second != 0 && key.first == k && !c->is_unregistered()) {
+      ls.push_back(c);
+    }
+  }
+  return ls;
+}
+
 /**
  * If my_addr doesn't have an IP set, this function
  * will fill it in from the passed addr. Otherwise it does nothing and returns.
@@ -787,7 +836,8 @@ void AsyncMessenger::shutdown_connections(bool queue_reset)
   accepting_conns.clear();
 
   for (const auto& [e, c] : conns) {
-    ldout(cct, 5) << __func__ << " mark down " << e << " " << c << dendl;
+    ldout(cct, 5) << __func__ << " mark down " << e.first << " lane "
+		  << e.second << " " << c << dendl;
     c->stop(queue_reset);
   }
   conns.clear();
@@ -818,6 +868,13 @@ void AsyncMessenger::mark_down_addrs(const entity_addrvec_t& addrs)
   } else {
     ldout(cct, 1) << __func__ << " " << addrs << " -- connection dne" << dendl;
   }
+  for (auto& [key, c] : conns) {
+    if (key.second != 0 && key.first == addrs && !c->is_unregistered()) {
+      ldout(cct, 1) << __func__ << " " << addrs << " lane " << key.second
+		    << " -- " << c << dendl;
+      c->stop(true);
+    }
+  }
 }
 
 int AsyncMessenger::get_proto_version(int peer_type, bool connect) const
@@ -849,7 +906,7 @@ int AsyncMessenger::accept_conn(const AsyncConnectionRef& conn)
     conn->get_perf_counter()->inc(l_msgr_active_connections);
     return 0;
   }
-  auto it = conns.find(*conn->peer_addrs);
+  auto it = conns.find(conn_key_t(*conn->peer_addrs, conn->lane));
   if (it != conns.end()) {
     auto& existing = it->second;
 
@@ -863,8 +920,9 @@ int AsyncMessenger::accept_conn(const AsyncConnectionRef& conn)
       return -1;
     }
   }
-  ldout(cct, 10) << __func__ << " " << conn << " " << *conn->peer_addrs << dendl;
-  conns[*conn->peer_addrs] = conn;
+  ldout(cct, 10) << __func__ << " " << conn << " " << *conn->peer_addrs
+		 << " lane " << conn->lane << dendl;
+  conns[conn_key_t(*conn->peer_addrs, conn->lane)] = conn;
   conn->get_perf_counter()->inc(l_msgr_active_connections);
   accepting_conns.erase(conn);
   return 0;
@@ -932,7 +990,7 @@ void AsyncMessenger::reap_dead()
     std::lock_guard l2{deleted_lock};
     for (auto& c : deleted_conns) {
       ldout(cct, 5) << __func__ << " delete " << c << dendl;
-      auto conns_it = conns.find(*c->peer_addrs);
+      auto conns_it = conns.find(conn_key_t(*c->peer_addrs, c->lane));
       if (conns_it != conns.end() && conns_it->second == c)
         conns.erase(conns_it);
       accepting_conns.erase(c);
@@ -151,6 +151,12 @@ public:
   ConnectionRef connect_to(int type,
 			   const entity_addrvec_t& addrs,
 			   bool anon, bool not_local_dest=false) override;
+  ConnectionRef connect_to_lane(int type,
+				const entity_addrvec_t& addrs,
+				unsigned lane) override;
+  unsigned get_num_lanes() const override {
+    return num_lanes;
+  }
   ConnectionRef get_loopback_connection() override;
   void mark_down(const entity_addr_t& addr) override {
     mark_down_addrs(entity_addrvec_t(addr));
@@ -200,7 +206,7 @@ private:
    * reference; take one if you need it.
    */
   AsyncConnectionRef create_connect(const entity_addrvec_t& addrs, int type,
-				    bool anon);
+				    bool anon, unsigned lane = 0);
 
 
   void _finish_bind(const entity_addrvec_t& bind_addrs,
@@ -252,18 +258,29 @@ private:
    *  and set false again by Accepter::stop().
    */
   bool did_bind = false;
+  /// sessions connect_to_lane() opens per peer
+  const unsigned num_lanes;
+
   /// counter for the global seq our connection protocol uses
   __u32 global_seq = 0;
   /// lock to protect the global_seq
   ceph::spinlock global_seq_lock;
 
+  /// peer addresses and lane of a session
+  typedef std::pair<entity_addrvec_t, unsigned> conn_key_t;
+  struct conn_key_hash {
+    size_t operator()(const conn_key_t& k) const {
+      return std::hash<entity_addrvec_t>()(k.first) ^ k.second;
+    }
+  };
+
   /**
-   * hash map of addresses to Asyncconnection
+   * hash map of addresses and lanes to Asyncconnection
    *
    * NOTE: a Asyncconnection* with state CLOSED may still be in the map but is considered
    * invalid and can be replaced by anyone holding the msgr lock
    */
-  ceph::unordered_map<entity_addrvec_t, AsyncConnectionRef> conns;
+  ceph::unordered_map<conn_key_t, AsyncConnectionRef, conn_key_hash> conns;
 
   /**
    * list of connection are in the process of accepting
@@ -298,10 +315,10 @@ private:
   bool stopped = true;
 
   /* You must hold this->lock for the duration of use! */
-  const auto& _lookup_conn(const entity_addrvec_t& k) {
+  const auto& _lookup_conn(const entity_addrvec_t& k, unsigned lane = 0) {
     static const AsyncConnectionRef nullref;
     ceph_assert(ceph_mutex_is_locked(lock));
-    auto p = conns.find(k);
+    auto p = conns.find(conn_key_t(k, lane));
     if (p == conns.end()) {
       return nullref;
     }
@@ -342,11 +359,15 @@ public:
   /**
    * This wraps _lookup_conn.
    */
-  AsyncConnectionRef lookup_conn(const entity_addrvec_t& k) {
+  AsyncConnectionRef lookup_conn(const entity_addrvec_t& k,
+				 unsigned lane = 0) {
     std::lock_guard l{lock};
-    return _lookup_conn(k); /* make new ref! */
+    return _lookup_conn(k, lane); /* make new ref! */
   }
 
+  /// the sessions with @p k on lanes other than 0
+  std::vector<AsyncConnectionRef> lookup_lane_conns(const entity_addrvec_t& k);
+
   int accept_conn(const AsyncConnectionRef& conn);
   bool learned_addr(const entity_addr_t &peer_addr_for_me);
   void add_accept(Worker *w, ConnectedSocket cli_socket,
@@ -111,6 +111,7 @@ int EventCenter::init(int nevent, unsigned center_id, const std::string &type)
 
   this->type = type;
   this->center_id = center_id;
+  busy_poll = std::chrono::microseconds(cct->_conf->ms_async_busy_poll_us);
 
   if (type == "dpdk") {
 #ifdef HAVE_DPDK
@@ -398,6 +399,13 @@ int EventCenter::process_events(unsigned timeout_microseconds,  ceph::timespan *
   }
 
   bool blocking = pollers.empty() && !external_num_events.load();
+  // spin while the traffic keeps coming, rather than paying the wakeup
+  bool spinning = false;
+  if (blocking && busy_poll != ceph::timespan::zero() &&
+      ceph::mono_clock::now() - last_event < busy_poll) {
+    blocking = false;
+    spinning = true;
+  }
   if (!blocking)
     timeout_microseconds = 0;
   tv.tv_sec = timeout_microseconds / 1000000;
@@ -407,6 +415,15 @@ int EventCenter::process_events(unsigned timeout_microseconds,  ceph::timespan *
   std::vector<FiredFileEvent> fired_events;
   numevents = driver->event_wait(fired_events, &tv);
   auto working_start = ceph::mono_clock::now();
+  if (busy_poll != ceph::timespan::zero()) {
+    if (spinning) {
+      ++busy_polls;
+    }
+    if (numevents > 0) {
+      busy_poll_hits += spinning;
+      last_event = working_start;
+    }
+  }
   for (int event_id = 0; event_id < numevents; event_id++) {
     int rfired = 0;
     FileEvent *event;
@@ -175,6 +175,11 @@ class EventCenter {
   EventCallbackRef notify_handler;
   unsigned center_id;
   AssociatedCenters *global_centers = nullptr;
+  /// poll without blocking for that long after the last event
+  ceph::timespan busy_poll = ceph::timespan::zero();
+  ceph::mono_time last_event;
+  uint64_t busy_polls = 0;      ///< non blocking waits for busy_poll
+  uint64_t busy_poll_hits = 0;  ///< those that found an event
 
   int process_time_events();
   FileEvent *_get_file_event(int fd) {
@@ -206,6 +211,15 @@ class EventCenter {
   void delete_time_event(uint64_t id);
   int process_events(unsigned timeout_microseconds, ceph::timespan *working_dur = nullptr);
   void wakeup();
+  /// the busy polls and hits since the last call, batched
+  std::pair<uint64_t, uint64_t> take_busy_poll_stats(bool force = false) {
+    if (!force && busy_polls < 1024) {
+      return {0, 0};
+    }
+    std::pair<uint64_t, uint64_t> r(busy_polls, busy_poll_hits);
+    busy_polls = busy_poll_hits = 0;
+    return r;
+  }
 
   // Used by external thread
   void dispatch_event_external(EventCallbackRef e);
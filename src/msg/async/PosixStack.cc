@@ -21,11 +21,28 @@
 #include <errno.h>
 
 #include <algorithm>
+#include <deque>
+#include <map>
+#ifdef __linux__
+#include <linux/errqueue.h>
+#endif
+
+#include "acconfig.h"
+#ifdef HAVE_LINUX_TLS_H
+#include <linux/tls.h>
+#ifndef SOL_TLS
+#define SOL_TLS 282
+#endif
+#ifndef TCP_ULP
+#define TCP_ULP 31
+#endif
+#endif
 
 #include "PosixStack.h"
 
 #include "include/buffer.h"
 #include "include/str_list.h"
+#include "common/ceph_crypto.h"
 #include "common/errno.h"
 #include "common/strtol.h"
 #include "common/dout.h"
@@ -37,16 +54,87 @@
 #undef dout_prefix
 #define dout_prefix *_dout << "PosixStack "
 
+#if defined(SO_ZEROCOPY) && defined(MSG_ZEROCOPY) && defined(SO_EE_ORIGIN_ZEROCOPY)
+#define HAVE_MSG_ZEROCOPY
+#endif
+
 class PosixConnectedSocketImpl final : public ConnectedSocketImpl {
   ceph::NetHandler &handler;
   int _fd;
   entity_addr_t sa;
   bool connected;
+  /// sends of at least this many bytes are MSG_ZEROCOPY, 0 if none is
+  uint64_t zerocopy_min_size = 0;
+#ifdef HAVE_MSG_ZEROCOPY
+  /// the kernel numbers the MSG_ZEROCOPY sendmsg calls of a socket
+  uint32_t zerocopy_next_id = 0;
+  /// all the calls before this one are complete
+  uint32_t zerocopy_done_id = 0;
+  /// completions that came out of order, first id -> last id
+  std::map<uint32_t, uint32_t> zerocopy_done_ooo;
+  /// what was sent, by the id of the last call that sent it: the kernel
+  /// reads the pages until the call is complete
+  std::deque<std::pair<uint32_t, ceph::buffer::list>> zerocopy_pinned;
+
+  void _zerocopy_done(uint32_t lo, uint32_t hi) {
+    if (lo != zerocopy_done_id) {
+      zerocopy_done_ooo[lo] = hi;
+      return;
+    }
+    zerocopy_done_id = hi + 1;
+    for (auto p = zerocopy_done_ooo.begin();
+	 p != zerocopy_done_ooo.end() && p->first == zerocopy_done_id;
+	 p = zerocopy_done_ooo.erase(p)) {
+      zerocopy_done_id = p->second + 1;
+    }
+    while (!zerocopy_pinned.empty() &&
+	   (int32_t)(zerocopy_pinned.front().first - zerocopy_done_id) < 0) {
+      zerocopy_pinned.pop_front();
+    }
+  }
+#endif
 
  public:
   explicit PosixConnectedSocketImpl(ceph::NetHandler &h, const entity_addr_t &sa,
-				    int f, bool connected)
-      : handler(h), _fd(f), sa(sa), connected(connected) {}
+				    int f, bool connected,
+				    uint64_t zerocopy_min_size = 0)
+      : handler(h), _fd(f), sa(sa), connected(connected) {
+#ifdef HAVE_MSG_ZEROCOPY
+    int on = 1;
+    if (zerocopy_min_size &&
+	::setsockopt(_fd, SOL_SOCKET, SO_ZEROCOPY, &on, sizeof(on)) == 0) {
+      this->zerocopy_min_size = zerocopy_min_size;
+    }
+#endif
+  }
+
+  void reap_zerocopy() override {
+#ifdef HAVE_MSG_ZEROCOPY
+    while (!zerocopy_pinned.empty()) {
+      char control[CMSG_SPACE(sizeof(struct sock_extended_err))];
+      struct msghdr msg;
+      // FIPS zeroization audit 20191115: this memset is not security related.
+      memset(&msg, 0, sizeof(msg));
+      msg.msg_control = control;
+      msg.msg_controllen = sizeof(control);
+      if (::recvmsg(_fd, &msg, MSG_ERRQUEUE | MSG_DONTWAIT) < 0) {
+	return;
+      }
+      for (auto cm = CMSG_FIRSTHDR(&msg); cm; cm = CMSG_NXTHDR(&msg, cm)) {
+	auto serr = reinterpret_cast<struct sock_extended_err*>(CMSG_DATA(cm));
+	if (serr->ee_errno != 0 || serr->ee_origin != SO_EE_ORIGIN_ZEROCOPY) {
+	  continue;
+	}
+	if (serr->ee_code & SO_EE_CODE_ZEROCOPY_COPIED) {
+	  // the kernel copied anyway, e.g. over loopback: stop paying the
+	  // page pinning for nothing
+	  zerocopy_min_size = 0;
+	}
+	_zerocopy_done(serr->ee_info, serr->ee_data);
+      }
+    }
+#endif
+  }
 
   int is_connected() override {
     if (connected)
@@ -77,22 +165,30 @@ class PosixConnectedSocketImpl final : public ConnectedSocketImpl {
   // return the sent length
   // < 0 means error occurred
   #ifndef _WIN32
-  static ssize_t do_sendmsg(int fd, struct msghdr &msg, unsigned len, bool more)
+  static ssize_t do_sendmsg(int fd, struct msghdr &msg, unsigned len, bool more,
+			    int flags = 0, uint32_t* calls = nullptr)
   {
     size_t sent = 0;
     while (1) {
       MSGR_SIGPIPE_STOPPER;
       ssize_t r;
-      r = ::sendmsg(fd, &msg, MSG_NOSIGNAL | (more ? MSG_MORE : 0));
+      r = ::sendmsg(fd, &msg, MSG_NOSIGNAL | (more ? MSG_MORE : 0) | flags);
       if (r < 0) {
         int err = ceph_sock_errno();
         if (err == EINTR) {
           continue;
         } else if (err == EAGAIN) {
           break;
+        } else if (err == ENOBUFS && flags) {
+          // out of memory to pin pages, copy this time
+          flags = 0;
+          continue;
         }
         return -err;
       }
+      if (calls && flags) {
+        ++*calls;
+      }
 
       sent += r;
       if (len == sent) break;
@@ -114,6 +210,14 @@ class PosixConnectedSocketImpl final : public ConnectedSocketImpl {
   }
 
   ssize_t send(ceph::buffer::list &bl, bool more) override {
+    int flags = 0;
+    uint32_t zerocopy_calls = 0;
+#ifdef HAVE_MSG_ZEROCOPY
+    reap_zerocopy();
+    if (zerocopy_min_size && bl.length() >= zerocopy_min_size) {
+      flags = MSG_ZEROCOPY;
+    }
+#endif
     size_t sent_bytes = 0;
     auto pb = std::cbegin(bl.buffers());
     uint64_t left_pbrs = bl.get_num_buffers();
@@ -133,7 +237,8 @@ class PosixConnectedSocketImpl final : public ConnectedSocketImpl {
 	msglen += pb->length();
 	++pb;
       }
-      ssize_t r = do_sendmsg(_fd, msg, msglen, left_pbrs || more);
+      ssize_t r = do_sendmsg(_fd, msg, msglen, left_pbrs || more,
+			     flags, &zerocopy_calls);
       if (r < 0)
         return r;
 
@@ -150,8 +255,14 @@ class PosixConnectedSocketImpl final : public ConnectedSocketImpl {
         bl.splice(sent_bytes, bl.length()-sent_bytes, &swapped);
         bl.swap(swapped);
       } else {
-        bl.clear();
+        swapped.swap(bl);
       }
+#ifdef HAVE_MSG_ZEROCOPY
+      if (zerocopy_calls) {
+        zerocopy_next_id += zerocopy_calls;
+        zerocopy_pinned.emplace_back(zerocopy_next_id - 1, std::move(swapped));
+      }
+#endif
     }
 
     return static_cast<ssize_t>(sent_bytes);
@@ -209,6 +320,34 @@ class PosixConnectedSocketImpl final : public ConnectedSocketImpl {
   int fd() const override {
     return _fd;
   }
+#ifdef HAVE_LINUX_TLS_H
+  int enable_ktls() override {
+    if (::setsockopt(_fd, SOL_TCP, TCP_ULP, "tls", sizeof("tls")) < 0) {
+      return -errno;
+    }
+    return 0;
+  }
+  int set_ktls_key(bool tx, const unsigned char* key,
+		   const unsigned char* nonce) override {
+    struct tls12_crypto_info_aes_gcm_128 ci;
+    // FIPS zeroization audit: the key is zeroized below
+    memset(&ci, 0, sizeof(ci));
+    ci.info.version = TLS_1_2_VERSION;
+    ci.info.cipher_type = TLS_CIPHER_AES_GCM_128;
+    memcpy(ci.key, key, TLS_CIPHER_AES_GCM_128_KEY_SIZE);
+    memcpy(ci.salt, nonce, TLS_CIPHER_AES_GCM_128_SALT_SIZE);
+    memcpy(ci.iv, nonce + TLS_CIPHER_AES_GCM_128_SALT_SIZE,
+	   TLS_CIPHER_AES_GCM_128_IV_SIZE);
+    int r = ::setsockopt(_fd, SOL_TLS, tx ? TLS_TX : TLS_RX, &ci, sizeof(ci));
+    r = r < 0 ? -errno : 0;
+    if (r == 0 && tx) {
+      // kernel TLS encrypts into its own buffers
+      zerocopy_min_size = 0;
+    }
+    ::TOPNSPC::crypto::zeroize_for_security(&ci, sizeof(ci));
+    return r;
+  }
+#endif
   friend class PosixServerSocketImpl;
   friend class PosixNetworkStack;
 };
@@ -259,7 +398,8 @@ int PosixServerSocketImpl::accept(ConnectedSocket *sock, const SocketOptions &op
   out->set_sockaddr((sockaddr*)&ss);
   handler.set_priority(sd, opt.priority, out->get_family());
 
-  std::unique_ptr<PosixConnectedSocketImpl> csi(new PosixConnectedSocketImpl(handler, *out, sd, true));
+  std::unique_ptr<PosixConnectedSocketImpl> csi(new PosixConnectedSocketImpl(
+    handler, *out, sd, true, opt.zerocopy_min_size));
   *sock = ConnectedSocket(std::move(csi));
   return 0;
 }
@@ -328,7 +468,8 @@ int PosixWorker::connect(const entity_addr_t &addr, const SocketOptions &opts, C
 
   net.set_priority(sd, opts.priority, addr.get_family());
   *socket = ConnectedSocket(
-      std::unique_ptr<PosixConnectedSocketImpl>(new PosixConnectedSocketImpl(net, addr, sd, !opts.nonblock)));
+      std::unique_ptr<PosixConnectedSocketImpl>(new PosixConnectedSocketImpl(
+        net, addr, sd, !opts.nonblock, opts.zerocopy_min_size)));
   return 0;
 }
 
@@ -36,6 +36,10 @@ using namespace ceph::msgr::v2;
 using CtPtr = Ct<ProtocolV2> *;
 using CtRef = Ct<ProtocolV2> &;
 
+// set once a socket refused the session keys, not to offer kernel TLS
+// to peers again and again
+static std::atomic<bool> ktls_failed = {false};
+
 void ProtocolV2::run_continuation(CtPtr pcontinuation) {
   if (pcontinuation) {
     run_continuation(*pcontinuation);
@@ -98,6 +102,8 @@ ProtocolV2::ProtocolV2(AsyncConnection *connection)
       rx_frame_asm(&session_stream_handlers, false),
       next_tag(static_cast<Tag>(0)),
       keepalive(false) {
+  tx_frame_asm.set_compression(&session_compression_handlers);
+  rx_frame_asm.set_compression(&session_compression_handlers);
 }
 
 ProtocolV2::~ProtocolV2() {
@@ -232,6 +238,8 @@ void ProtocolV2::reset_security() {
   auth_meta.reset(new AuthConnectionMeta);
   session_stream_handlers.rx.reset(nullptr);
   session_stream_handlers.tx.reset(nullptr);
+  session_compression_handlers.rx.reset(nullptr);
+  session_compression_handlers.tx.reset(nullptr);
   pre_auth.rxbuf.clear();
   pre_auth.txbuf.clear();
 }
@@ -551,6 +559,12 @@ ssize_t ProtocolV2::write_message(Message *m, bool more) {
                  << " off=" << header2.data_off
                  << dendl;
   ssize_t total_send_size = connection->outgoing_bl.length();
+  if (more && (uint64_t)total_send_size < cct->_conf->ms_send_coalesce_size) {
+    // sent along with the messages that follow, in one call
+    ldout(cct, 10) << __func__ << " queued " << m << dendl;
+    m->put();
+    return 0;
+  }
   ssize_t rc = connection->_try_send(more);
   if (rc < 0) {
     ldout(cct, 1) << __func__ << " error sending " << m << ", "
@@ -821,9 +835,20 @@ CtPtr ProtocolV2::_banner_exchange(CtRef callback) {
   ldout(cct, 20) << __func__ << dendl;
   bannerExchangeCallback = &callback;
 
+  uint64_t supported_features =
+    CEPH_MSGR2_SUPPORTED_FEATURES | CEPH_MSGR2_FEATURE_LANES |
+    CEPH_MSGR2_FEATURE_COMPRESSION;
+  ktls_offered = cct->_conf->ms_secure_mode_ktls && !ktls_failed &&
+    connection->cs.enable_ktls() == 0;
+  if (ktls_offered) {
+    supported_features |= CEPH_MSGR2_FEATURE_KTLS;
+  }
+  // what follows the auth frames is kernel business if it takes over
+  connection->no_prefetch = ktls_offered;
+
   ceph::bufferlist banner_payload;
   using ceph::encode;
-  encode((uint64_t)CEPH_MSGR2_SUPPORTED_FEATURES, banner_payload, 0);
+  encode(supported_features, banner_payload, 0);
   encode((uint64_t)CEPH_MSGR2_REQUIRED_FEATURES, banner_payload, 0);
 
   ceph::bufferlist bl;
@@ -911,7 +936,9 @@ CtPtr ProtocolV2::_handle_peer_banner_payload(rx_buffer_t &&buffer, int r) {
 
   // Check feature bit compatibility
 
-  uint64_t supported_features = CEPH_MSGR2_SUPPORTED_FEATURES;
+  uint64_t supported_features =
+    CEPH_MSGR2_SUPPORTED_FEATURES | CEPH_MSGR2_FEATURE_LANES |
+    CEPH_MSGR2_FEATURE_KTLS | CEPH_MSGR2_FEATURE_COMPRESSION;
   uint64_t required_features = CEPH_MSGR2_REQUIRED_FEATURES;
 
   if ((required_features & peer_supported_features) != required_features) {
@@ -932,6 +959,20 @@ CtPtr ProtocolV2::_handle_peer_banner_payload(rx_buffer_t &&buffer, int r) {
     return nullptr;
   }
 
+  bool has_lanes = HAVE_MSGR2_FEATURE(peer_supported_features, LANES);
+  if (connection->lane && !has_lanes) {
+    // the peer was replaced by one that keeps a single session
+    ldout(cct, 1) << __func__ << " peer does not support lanes, lane "
+                  << connection->lane << " is closed" << dendl;
+    stop();
+    connection->dispatch_queue->queue_reset(connection);
+    return nullptr;
+  }
+  connection->peer_supports_lanes = has_lanes;
+  if (!HAVE_MSGR2_FEATURE(peer_supported_features, KTLS)) {
+    connection->no_prefetch = false;
+  }
+
   this->peer_supported_features = peer_supported_features;
   if (peer_required_features == 0) {
     this->connection_features = msgr2_required;
@@ -1149,6 +1190,23 @@ CtPtr ProtocolV2::handle_read_frame_dispatch() {
   return nullptr;
 }
 
+unsigned ProtocolV2::get_rx_data_page_off() {
+  // in secure mode the header segment is still encrypted at this point
+  // and the payload is decrypted into a new buffer anyway, as is a
+  // compressed one.
+  if (session_stream_handlers.rx || rx_frame_asm.is_compressed() ||
+      !cct->_conf.get_val<bool>("ms_rx_data_align_to_offset")) {
+    return 0;
+  }
+  const auto& header_bl = rx_segments_data[SegmentIndex::Msg::HEADER];
+  if (header_bl.length() < sizeof(ceph_msg_header2)) {
+    return 0;
+  }
+  ceph_msg_header2 header;
+  header_bl.begin().copy(sizeof(header), reinterpret_cast<char*>(&header));
+  return header.data_off & ~CEPH_PAGE_MASK;
+}
+
 CtPtr ProtocolV2::read_frame_segment() {
   size_t seg_idx = rx_segments_data.size();
   ldout(cct, 20) << __func__ << " seg_idx=" << seg_idx << dendl;
@@ -1162,8 +1220,26 @@ CtPtr ProtocolV2::read_frame_segment() {
   rx_buffer_t rx_buffer;
   uint16_t align = rx_frame_asm.get_segment_align(seg_idx);
   try {
-    rx_buffer = ceph::buffer::ptr_node::create(ceph::buffer::create_aligned(
-        onwire_len, align));
+    unsigned page_off = 0;
+    if (next_tag == Tag::MESSAGE &&
+        seg_idx == SegmentIndex::Msg::DATA &&
+        align == segment_t::PAGE_SIZE_ALIGNMENT) {
+      page_off = get_rx_data_page_off();
+    }
+    if (page_off) {
+      // place the payload so that it shares its page offset with the
+      // object extent it carries (like msgr1 does), so that the block
+      // aligned part of a write is also memory aligned and can be
+      // handed to the block device without being rebuilt.
+      ceph::bufferptr ptr(ceph::buffer::create_aligned(
+          page_off + onwire_len, CEPH_PAGE_SIZE));
+      ptr.set_offset(page_off);
+      ptr.set_length(onwire_len);
+      rx_buffer = ceph::buffer::ptr_node::create(std::move(ptr));
+    } else {
+      rx_buffer = ceph::buffer::ptr_node::create(ceph::buffer::create_aligned(
+          onwire_len, align));
+    }
   } catch (const ceph::buffer::bad_alloc&) {
     // Catching because of potential issues with satisfying alignment.
     ldout(cct, 1) << __func__ << " can't allocate aligned rx_buffer"
@@ -1270,6 +1346,12 @@ CtPtr ProtocolV2::ready() {
 
   {
     std::lock_guard<std::mutex> l(connection->write_lock);
+    // the peer type and address are known by now
+    session_compression_handlers =
+      ceph::compression::onwire::rxtx_t::create_handler_pair(
+        cct, HAVE_MSGR2_FEATURE(peer_supported_features, COMPRESSION),
+        auth_meta->is_mode_secure(), connection->get_peer_type(),
+        connection->target_addr);
     can_write = true;
     if (!out_queue.empty()) {
       connection->center->dispatch_event_external(connection->write_handler);
@@ -1279,7 +1361,9 @@ CtPtr ProtocolV2::ready() {
   connection->maybe_start_delay_thread();
 
   state = READY;
-  ldout(cct, 1) << __func__ << " entity=" << peer_name << " client_cookie="
+  ldout(cct, 1) << __func__ << " entity=" << peer_name
+                << " compress=" << (session_compression_handlers.tx ? 1 : 0)
+                << " client_cookie="
                 << std::hex << client_cookie << " server_cookie="
                 << server_cookie << std::dec << " in_seq=" << in_seq
                 << " out_seq=" << out_seq << dendl;
@@ -1816,6 +1900,9 @@ CtPtr ProtocolV2::handle_auth_done(ceph::bufferlist &payload)
   bool is_rev1 = HAVE_MSGR2_FEATURE(peer_supported_features, REVISION_1);
   session_stream_handlers = ceph::crypto::onwire::rxtx_t::create_handler_pair(
       cct, *auth_meta, /*new_nonce_format=*/is_rev1, /*crossed=*/false);
+  if (!maybe_handover_to_ktls(/*crossed=*/false)) {
+    return _fault();
+  }
 
   state = AUTH_CONNECTING_SIGN;
 
@@ -1850,6 +1937,8 @@ CtPtr ProtocolV2::send_client_ident() {
   if (connection->policy.lossy) {
     flags |= CEPH_MSG_CONNECT_LOSSY;
   }
+  // only set on sessions to peers known to support lanes
+  flags |= (uint64_t)connection->lane << CEPH_MSG_CONNECT_LANE_SHIFT;
 
   auto client_ident = ClientIdentFrame::Encode(
       messenger->get_myaddrs(),
@@ -2189,6 +2278,34 @@ CtPtr ProtocolV2::_handle_auth_request(ceph::bufferlist& auth_payload, bool more
   }
 }
 
+bool ProtocolV2::maybe_handover_to_ktls(bool crossed)
+{
+  connection->no_prefetch = false;
+  if (!ktls_offered ||
+      !auth_meta->is_mode_secure() ||
+      !HAVE_MSGR2_FEATURE(peer_supported_features, KTLS)) {
+    return true;
+  }
+  // both peers switch right after the last plaintext frame: none of the
+  // bytes that follow may have been sent or read by us
+  int r = -EINVAL;
+  if (connection->recv_start == connection->recv_end &&
+      connection->outgoing_bl.length() == 0) {
+    r = ceph::crypto::onwire::install_ktls(connection->cs, *auth_meta,
+					   crossed);
+  }
+  if (r < 0) {
+    lderr(cct) << __func__ << " failed to install the session keys: "
+	       << cpp_strerror(r) << ", not offering kernel TLS anymore"
+	       << dendl;
+    ktls_failed = true;
+    return false;
+  }
+  ldout(cct, 5) << __func__ << " stream is encrypted by the kernel" << dendl;
+  session_stream_handlers = { nullptr, nullptr };
+  return true;
+}
+
 CtPtr ProtocolV2::finish_auth()
 {
   ceph_assert(auth_meta);
@@ -2197,6 +2314,9 @@ CtPtr ProtocolV2::finish_auth()
   bool is_rev1 = HAVE_MSGR2_FEATURE(peer_supported_features, REVISION_1);
   session_stream_handlers = ceph::crypto::onwire::rxtx_t::create_handler_pair(
       cct, *auth_meta, /*new_nonce_format=*/is_rev1, /*crossed=*/true);
+  if (!maybe_handover_to_ktls(/*crossed=*/true)) {
+    return _fault();
+  }
 
   const auto sig = auth_meta->session_key.empty() ? sha256_digest_t() :
     auth_meta->session_key.hmac_sha256(cct, pre_auth.rxbuf);
@@ -2305,6 +2425,10 @@ CtPtr ProtocolV2::handle_client_ident(ceph::bufferlist &payload)
   connection->set_peer_id(client_ident.gid());
 
   client_cookie = client_ident.cookie();
+  if (HAVE_MSGR2_FEATURE(peer_supported_features, LANES)) {
+    connection->lane = (client_ident.flags() >> CEPH_MSG_CONNECT_LANE_SHIFT) &
+      CEPH_MSG_CONNECT_LANE_MASK;
+  }
 
   uint64_t feat_missing =
     (connection->policy.features_required | msgr2_required) &
@@ -2332,7 +2456,7 @@ CtPtr ProtocolV2::handle_client_ident(ceph::bufferlist &payload)
     // to this peer.
     connection->lock.unlock();
     AsyncConnectionRef existing = messenger->lookup_conn(
-      *connection->peer_addrs);
+      *connection->peer_addrs, connection->lane);
 
     if (existing &&
 	existing->protocol->proto_type != 2) {
@@ -2403,6 +2527,30 @@ CtPtr ProtocolV2::handle_reconnect(ceph::bufferlist &payload)
     existing = nullptr;
   }
 
+  if (HAVE_MSGR2_FEATURE(peer_supported_features, LANES)) {
+    // the reconnect frame carries no lane: the session it resumes is the
+    // one of the same client cookie
+    bool found = false;
+    if (existing) {
+      std::lock_guard<std::mutex> l(existing->lock);
+      auto exproto = static_cast<ProtocolV2 *>(existing->protocol.get());
+      found = exproto->client_cookie == reconnect.client_cookie();
+    }
+    if (!found) {
+      for (auto& c : messenger->lookup_lane_conns(*connection->peer_addrs)) {
+        std::lock_guard<std::mutex> l(c->lock);
+        auto cproto = dynamic_cast<ProtocolV2 *>(c->protocol.get());
+        if (cproto && cproto->client_cookie == reconnect.client_cookie()) {
+          ldout(cct, 5) << __func__ << " session is on lane " << c->lane
+                        << dendl;
+          existing = c;
+          connection->lane = c->lane;
+          break;
+        }
+      }
+    }
+  }
+
   connection->inject_delay();
 
   connection->lock.lock();
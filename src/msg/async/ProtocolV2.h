@@ -5,6 +5,7 @@
 #define _MSG_ASYNC_PROTOCOL_V2_
 
 #include "Protocol.h"
+#include "compression_onwire.h"
 #include "crypto_onwire.h"
 #include "frames_v2.h"
 
@@ -67,10 +68,12 @@ private:
 
   // TODO: move into auth_meta?
   ceph::crypto::onwire::rxtx_t session_stream_handlers;
+  ceph::compression::onwire::rxtx_t session_compression_handlers;
 
   entity_name_t peer_name;
   State state;
   uint64_t peer_supported_features;  // CEPH_MSGR2_FEATURE_*
+  bool ktls_offered = false;  // we advertised CEPH_MSGR2_FEATURE_KTLS
 
   uint64_t client_cookie;
   uint64_t server_cookie;
@@ -166,7 +169,9 @@ private:
   Ct<ProtocolV2> *read_frame();
   Ct<ProtocolV2> *finish_auth();
   Ct<ProtocolV2> *finish_client_auth();
+  bool maybe_handover_to_ktls(bool crossed);
   Ct<ProtocolV2> *handle_read_frame_preamble_main(rx_buffer_t &&buffer, int r);
+  unsigned get_rx_data_page_off();
   Ct<ProtocolV2> *read_frame_segment();
   Ct<ProtocolV2> *handle_read_frame_segment(rx_buffer_t &&rx_buffer, int r);
   Ct<ProtocolV2> *_handle_read_frame_segment();
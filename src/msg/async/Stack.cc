@@ -56,6 +56,11 @@ std::function<void ()> NetworkStack::add_thread(Worker* w)
           // TODO do something?
         }
         w->perf_logger->tinc(l_msgr_running_total_time, dur);
+        auto [polls, hits] = w->center.take_busy_poll_stats();
+        if (polls) {
+          w->perf_logger->inc(l_msgr_busy_polls, polls);
+          w->perf_logger->inc(l_msgr_busy_poll_hits, hits);
+        }
       }
       w->reset();
       w->destroy();
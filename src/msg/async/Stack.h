@@ -32,6 +32,14 @@ class ConnectedSocketImpl {
   virtual void shutdown() = 0;
   virtual void close() = 0;
   virtual int fd() const = 0;
+  virtual void reap_zerocopy() {}
+  virtual int enable_ktls() {
+    return -EOPNOTSUPP;
+  }
+  virtual int set_ktls_key(bool tx, const unsigned char* key,
+			   const unsigned char* nonce) {
+    return -EOPNOTSUPP;
+  }
 };
 
 class ConnectedSocket;
@@ -40,6 +48,7 @@ struct SocketOptions {
   bool nodelay = true;
   int rcbuf_size = 0;
   int priority = -1;
+  uint64_t zerocopy_min_size = 0;  ///< 0 if no send is MSG_ZEROCOPY
   entity_addr_t connect_bind_addr;
 };
 
@@ -123,6 +132,32 @@ class ConnectedSocket {
     return _csi->fd();
   }
 
+  /// Releases the buffers of the zero-copy sends the kernel is done with.
+  ///
+  /// Sends do it too, but the socket also polls as readable while no
+  /// completion is taken.
+  void reap_zerocopy() {
+    _csi->reap_zerocopy();
+  }
+
+  /// Prepares the socket for kernel TLS.
+  ///
+  /// The stream is unchanged until set_ktls_key() is called.  Returns
+  /// 0 if the kernel, and the stack, can take over the encryption.
+  int enable_ktls() {
+    return _csi->enable_ktls();
+  }
+  /// Let the kernel encrypt the data sent from now on (\c tx), or
+  /// decrypt that received, as TLS 1.2 records of AES-128-GCM.
+  ///
+  /// \param key the 16 bytes AES key
+  /// \param nonce the 4 bytes salt then the 8 bytes of the first
+  ///              explicit nonce
+  int set_ktls_key(bool tx, const unsigned char* key,
+		   const unsigned char* nonce) {
+    return _csi->set_ktls_key(tx, key, nonce);
+  }
+
   explicit operator bool() const {
     return _csi.get();
   }
@@ -203,6 +238,9 @@ enum {
   l_msgr_send_messages_queue_lat,
   l_msgr_handle_ack_lat,
 
+  l_msgr_busy_polls,
+  l_msgr_busy_poll_hits,
+
   l_msgr_last,
 };
 
@@ -246,6 +284,9 @@ class Worker {
     plb.add_time_avg(l_msgr_send_messages_queue_lat, "msgr_send_messages_queue_lat", "Network sent messages lat");
     plb.add_time_avg(l_msgr_handle_ack_lat, "msgr_handle_ack_lat", "Connection handle ack lat");
 
+    plb.add_u64_counter(l_msgr_busy_polls, "msgr_busy_polls", "Event waits that did not block, after recent events");
+    plb.add_u64_counter(l_msgr_busy_poll_hits, "msgr_busy_poll_hits", "Busy polls that found an event");
+
     perf_logger = plb.create_perf_counters();
     cct->get_perfcounters_collection()->add(perf_logger);
   }
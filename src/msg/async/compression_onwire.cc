@@ -0,0 +1,157 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+
+#include <map>
+
+#include "compression_onwire.h"
+
+#include "common/debug.h"
+#include "compressor/Compressor.h"
+#include "include/encoding.h"
+#include "include/ipaddr.h"
+#include "include/str_list.h"
+#include "msg/msg_types.h"
+
+#define dout_subsys ceph_subsys_ms
+
+namespace ceph::compression::onwire {
+
+// A compressed segment starts with the compressor_message of the
+// compressor, which some of them need back to decompress.
+class Compressor_OnWireTxHandler : public TxHandler {
+  CephContext* const cct;
+  CompressorRef compressor;
+  const std::uint32_t min_size;
+
+public:
+  Compressor_OnWireTxHandler(CephContext* cct, CompressorRef compressor,
+                             std::uint32_t min_size)
+    : cct(cct), compressor(std::move(compressor)), min_size(min_size) {
+  }
+
+  std::uint8_t get_algorithm() const override {
+    return compressor->get_type();
+  }
+
+  std::uint32_t get_min_size() const override {
+    return min_size;
+  }
+
+  bool compress(const ceph::bufferlist& in, ceph::bufferlist& out) override {
+    boost::optional<int32_t> compressor_message;
+    ceph::bufferlist compressed;
+    int r = compressor->compress(in, compressed, compressor_message);
+    if (r < 0) {
+      ldout(cct, 5) << __func__ << " " << compressor->get_type_name()
+                    << " failed: " << r << dendl;
+      return false;
+    }
+    using ceph::encode;
+    encode(compressor_message, out);
+    out.claim_append(compressed);
+    return true;
+  }
+};
+
+class Compressor_OnWireRxHandler : public RxHandler {
+  CephContext* const cct;
+  // peers may change their mind on ms_compression_algorithm
+  std::map<std::uint8_t, CompressorRef> compressors;
+
+public:
+  explicit Compressor_OnWireRxHandler(CephContext* cct)
+    : cct(cct) {
+  }
+
+  int decompress(std::uint8_t algorithm, const ceph::bufferlist& in,
+                 ceph::bufferlist& out) override {
+    auto& compressor = compressors[algorithm];
+    if (!compressor) {
+      compressor = Compressor::create(cct, algorithm);
+      if (!compressor) {
+        compressors.erase(algorithm);
+        ldout(cct, 1) << __func__ << " no compressor for algorithm "
+                      << (int)algorithm << dendl;
+        return -EOPNOTSUPP;
+      }
+    }
+    try {
+      auto p = in.cbegin();
+      boost::optional<int32_t> compressor_message;
+      using ceph::decode;
+      decode(compressor_message, p);
+      return compressor->decompress(p, p.get_remaining(), out,
+                                    compressor_message);
+    } catch (const ceph::buffer::error&) {
+      return -EIO;
+    }
+  }
+};
+
+static bool is_peer_listed(CephContext* cct, int peer_type,
+                           const entity_addr_t& peer_addr)
+{
+  auto& conf = cct->_conf;
+  bool listed = false;
+  for (auto& type : get_str_list(
+         conf.get_val<std::string>("ms_compress_peer_types"))) {
+    if (type == ceph_entity_type_name(peer_type)) {
+      listed = true;
+      break;
+    }
+  }
+  if (!listed) {
+    return false;
+  }
+  auto networks = get_str_list(
+    conf.get_val<std::string>("ms_compress_networks"));
+  if (networks.empty()) {
+    return true;
+  }
+  for (auto& s : networks) {
+    entity_addr_t network;
+    unsigned prefix_len;
+    if (!parse_network(s.c_str(), &network, &prefix_len)) {
+      ldout(cct, 1) << __func__ << " ignoring bad network " << s << dendl;
+      continue;
+    }
+    if (network_contains(network, prefix_len, peer_addr)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+rxtx_t rxtx_t::create_handler_pair(
+  CephContext* cct,
+  bool peer_supports_compression,
+  bool is_secure,
+  int peer_type,
+  const entity_addr_t& peer_addr)
+{
+  if (!peer_supports_compression) {
+    return {};
+  }
+  rxtx_t handlers;
+  handlers.rx = std::make_unique<Compressor_OnWireRxHandler>(cct);
+
+  auto& conf = cct->_conf;
+  if (conf.get_val<std::string>("ms_compress_mode") != "force" ||
+      (is_secure && !conf.get_val<bool>("ms_compress_secure")) ||
+      !is_peer_listed(cct, peer_type, peer_addr)) {
+    return handlers;
+  }
+  auto algorithm = conf.get_val<std::string>("ms_compression_algorithm");
+  auto compressor = Compressor::create(cct, algorithm);
+  if (!compressor) {
+    lderr(cct) << __func__ << " cannot load compressor " << algorithm
+               << ", not compressing" << dendl;
+    return handlers;
+  }
+  handlers.tx = std::make_unique<Compressor_OnWireTxHandler>(
+    cct, std::move(compressor),
+    conf.get_val<Option::size_t>("ms_compress_min_size"));
+  return handlers;
+}
+
+} // namespace ceph::compression::onwire
@@ -0,0 +1,69 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+/*
+ * Ceph - scalable distributed file system
+ *
+ * This is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License version 2.1, as published by the Free Software
+ * Foundation. See file COPYING.
+ *
+ */
+
+#ifndef CEPH_COMPRESSION_ONWIRE_H
+#define CEPH_COMPRESSION_ONWIRE_H
+
+#include <cstdint>
+#include <memory>
+
+#include "include/buffer.h"
+#include "include/common_fwd.h"
+
+struct entity_addr_t;
+
+namespace ceph::compression::onwire {
+
+struct TxHandler {
+  virtual ~TxHandler() = default;
+
+  // Compressor::CompressionAlgorithm recorded in the preamble of the
+  // frames this handler compresses.
+  virtual std::uint8_t get_algorithm() const = 0;
+
+  // Frames whose payload is smaller than this go out as they are.
+  virtual std::uint32_t get_min_size() const = 0;
+
+  // Compresses in into out.  Returns false if it failed, in which case
+  // in should be sent as it is.
+  virtual bool compress(const ceph::bufferlist& in,
+                        ceph::bufferlist& out) = 0;
+};
+
+struct RxHandler {
+  virtual ~RxHandler() = default;
+
+  // Decompresses in, compressed by a TxHandler of the given algorithm,
+  // into out.  Returns a negative error code on failure.
+  virtual int decompress(std::uint8_t algorithm,
+                         const ceph::bufferlist& in,
+                         ceph::bufferlist& out) = 0;
+};
+
+struct rxtx_t {
+  std::unique_ptr<RxHandler> rx;
+  std::unique_ptr<TxHandler> tx;
+
+  // rx is set if the peer may compress what it sends us, tx if we are
+  // to compress what we send to a peer of peer_type at peer_addr, as
+  // per the ms_compress_* options.
+  static rxtx_t create_handler_pair(
+    CephContext* cct,
+    bool peer_supports_compression,
+    bool is_secure,
+    int peer_type,
+    const entity_addr_t& peer_addr);
+};
+
+} // namespace ceph::compression::onwire
+
+#endif // CEPH_COMPRESSION_ONWIRE_H
@@ -5,6 +5,7 @@
 #include <openssl/evp.h>
 
 #include "crypto_onwire.h"
+#include "Stack.h"
 
 #include "common/debug.h"
 #include "common/ceph_crypto.h"
@@ -306,4 +307,26 @@ ceph::crypto::onwire::rxtx_t ceph::crypto::onwire::rxtx_t::create_handler_pair(
   }
 }
 
+int install_ktls(
+  ConnectedSocket& cs,
+  const AuthConnectionMeta& auth_meta,
+  bool crossed)
+{
+  ceph_assert_always(auth_meta.is_mode_secure());
+  ceph_assert_always(auth_meta.connection_secret.length() >= \
+    sizeof(key_t) + 2 * sizeof(nonce_t));
+  const auto key = reinterpret_cast<const unsigned char*>(
+    auth_meta.connection_secret.c_str());
+  const auto rx_nonce = key + sizeof(key_t);
+  const auto tx_nonce = rx_nonce + sizeof(nonce_t);
+  static_assert(sizeof(nonce_t::fixed) == 4 && sizeof(nonce_t::counter) == 8,
+		"the salt and explicit nonce of TLS 1.2 AES-GCM");
+
+  int r = cs.set_ktls_key(true, key, crossed ? rx_nonce : tx_nonce);
+  if (r < 0) {
+    return r;
+  }
+  return cs.set_ktls_key(false, key, crossed ? tx_nonce : rx_nonce);
+}
+
 } // namespace ceph::crypto::onwire
@@ -22,6 +22,8 @@
 #include "auth/Auth.h"
 #include "include/buffer.h"
 
+class ConnectedSocket;
+
 namespace ceph::math {
 
 // TODO
@@ -125,6 +127,15 @@ struct rxtx_t {
     bool crossed);
 };
 
+// Hand the stream of a secure mode session over to kernel TLS: the key
+// and the nonces of create_handler_pair() are installed on the socket,
+// and no handler is needed anymore.  The nonces start from the same
+// values, but move on at each TLS record, not at each frame.
+int install_ktls(
+  ConnectedSocket& cs,
+  const class AuthConnectionMeta& auth_meta,
+  bool crossed);
+
 } // namespace ceph::crypto::onwire
 
 #endif // CEPH_CRYPTO_ONWIRE_H
@@ -72,6 +72,7 @@ void FrameAssembler::fill_preamble(Tag tag,
     preamble.segments[i].alignment = m_descs[i].align;
   }
   preamble.num_segments = m_descs.size();
+  preamble.compression = m_compression_alg;
   preamble.crc = ceph_crc32c(
       0, reinterpret_cast<const unsigned char*>(&preamble),
       sizeof(preamble) - sizeof(preamble.crc));
@@ -237,10 +238,64 @@ bufferlist FrameAssembler::asm_secure_rev1(const preamble_block_t& preamble,
   return frame_bl;
 }
 
+// The first segment of a message frame (the header) is left out, so
+// that msgr2.1 can still interpret it before reading in the rest.
+// Frames that would not get any smaller go out as they are.
+void FrameAssembler::asm_compress(Tag tag, bufferlist segment_bls[]) {
+  m_compression_alg = 0;
+  if (tag != Tag::MESSAGE || !m_compression || !m_compression->tx) {
+    return;
+  }
+  auto& tx = m_compression->tx;
+  uint64_t raw_len = 0;
+  for (size_t i = 1; i < m_descs.size(); i++) {
+    raw_len += segment_bls[i].length();
+  }
+  if (raw_len == 0 || raw_len < tx->get_min_size()) {
+    return;
+  }
+
+  bufferlist compressed_bls[MAX_NUM_SEGMENTS];
+  uint64_t compressed_len = 0;
+  for (size_t i = 1; i < m_descs.size(); i++) {
+    if (segment_bls[i].length() == 0) {
+      continue;
+    }
+    if (!tx->compress(segment_bls[i], compressed_bls[i])) {
+      return;
+    }
+    compressed_len += compressed_bls[i].length();
+  }
+  if (compressed_len >= raw_len) {
+    return;
+  }
+  for (size_t i = 1; i < m_descs.size(); i++) {
+    segment_bls[i].swap(compressed_bls[i]);
+  }
+  m_compression_alg = tx->get_algorithm();
+}
+
+void FrameAssembler::disasm_decompress(bufferlist segment_bls[]) const {
+  for (size_t i = 1; i < m_descs.size(); i++) {
+    if (segment_bls[i].length() == 0) {
+      continue;
+    }
+    bufferlist decompressed;
+    int r = m_compression->rx->decompress(m_compression_alg, segment_bls[i],
+                                          decompressed);
+    if (r < 0) {
+      throw FrameError(fmt::format(
+          "failed to decompress segment {} r={}", i, r));
+    }
+    segment_bls[i].swap(decompressed);
+  }
+}
+
 bufferlist FrameAssembler::assemble_frame(Tag tag, bufferlist segment_bls[],
                                           const uint16_t segment_aligns[],
                                           size_t segment_count) {
   m_descs.resize(calc_num_segments(segment_bls, segment_count));
+  asm_compress(tag, segment_bls);
   for (size_t i = 0; i < m_descs.size(); i++) {
     m_descs[i].logical_len = segment_bls[i].length();
     m_descs[i].align = segment_aligns[i];
@@ -311,6 +366,13 @@ Tag FrameAssembler::disassemble_preamble(bufferlist& preamble_bl) {
       preamble->segments[preamble->num_segments - 1].length == 0) {
     throw FrameError("last segment empty");
   }
+  if (preamble->compression &&
+      (static_cast<Tag>(preamble->tag) != Tag::MESSAGE ||
+       !m_compression || !m_compression->rx)) {
+    throw FrameError(fmt::format(
+        "unexpected compressed frame compression={}", preamble->compression));
+  }
+  m_compression_alg = preamble->compression;
 
   m_descs.resize(preamble->num_segments);
   for (size_t i = 0; i < m_descs.size(); i++) {
@@ -440,21 +502,26 @@ void FrameAssembler::disassemble_first_segment(bufferlist& preamble_bl,
 bool FrameAssembler::disassemble_remaining_segments(
     bufferlist segment_bls[], bufferlist& epilogue_bl) const {
   ceph_assert(!m_descs.empty());
+  bool complete;
   if (m_is_rev1) {
     if (m_descs.size() == 1) {
       // no epilogue if only one segment
       ceph_assert(epilogue_bl.length() == 0);
-      return true;
-    }
-    if (m_crypto->rx) {
-      return disasm_remaining_secure_rev1(segment_bls, epilogue_bl);
+      complete = true;
+    } else if (m_crypto->rx) {
+      complete = disasm_remaining_secure_rev1(segment_bls, epilogue_bl);
+    } else {
+      complete = disasm_remaining_crc_rev1(segment_bls, epilogue_bl);
     }
-    return disasm_remaining_crc_rev1(segment_bls, epilogue_bl);
+  } else if (m_crypto->rx) {
+    complete = disasm_all_secure_rev0(segment_bls, epilogue_bl);
+  } else {
+    complete = disasm_all_crc_rev0(segment_bls, epilogue_bl);
   }
-  if (m_crypto->rx) {
-    return disasm_all_secure_rev0(segment_bls, epilogue_bl);
+  if (complete && is_compressed()) {
+    disasm_decompress(segment_bls);
   }
-  return disasm_all_crc_rev0(segment_bls, epilogue_bl);
+  return complete;
 }
 
 std::ostream& operator<<(std::ostream& os, const FrameAssembler& frame_asm) {
@@ -468,6 +535,7 @@ std::ostream& operator<<(std::ostream& os, const FrameAssembler& frame_asm) {
     os << " + " << frame_asm.get_epilogue_onwire_len() << " ";
   }
   os << "rev1=" << frame_asm.m_is_rev1
+     << " compression=" << static_cast<int>(frame_asm.m_compression_alg)
      << " rx=" << frame_asm.m_crypto->rx.get()
      << " tx=" << frame_asm.m_crypto->tx.get();
   return os;
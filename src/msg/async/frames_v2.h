@@ -4,6 +4,7 @@
 #include "include/types.h"
 #include "common/Clock.h"
 #include "crypto_onwire.h"
+#include "compression_onwire.h"
 #include <array>
 #include <iosfwd>
 #include <utility>
@@ -102,7 +103,13 @@ struct preamble_block_t {
   __u8 num_segments;
 
   segment_t segments[MAX_NUM_SEGMENTS];
-  __u8 _reserved[2];
+
+  // Compressor::CompressionAlgorithm the segments past the first one
+  // are compressed with, COMP_ALG_NONE (always, for peers without
+  // CEPH_MSGR2_FEATURE_COMPRESSION) if they are not.  The lengths
+  // above are those of the compressed segments.
+  __u8 compression;
+  __u8 _reserved;
 
   // CRC32 for this single preamble block.
   ceph_le32 crc;
@@ -188,6 +195,17 @@ public:
     return m_is_rev1;
   }
 
+  // compression may be null, as may be its handlers
+  void set_compression(const ceph::compression::onwire::rxtx_t* compression) {
+    m_compression = compression;
+  }
+
+  // whether the segments past the first one of the frame whose
+  // preamble was disassembled last are compressed
+  bool is_compressed() const {
+    return m_compression_alg != 0;
+  }
+
   size_t get_num_segments() const {
     ceph_assert(!m_descs.empty());
     return m_descs.size();
@@ -368,11 +386,15 @@ private:
                                     bufferlist& epilogue_bl) const;
 
   void fill_preamble(Tag tag, preamble_block_t& preamble) const;
+  void asm_compress(Tag tag, bufferlist segment_bls[]);
+  void disasm_decompress(bufferlist segment_bls[]) const;
   friend std::ostream& operator<<(std::ostream& os,
                                   const FrameAssembler& frame_asm);
 
   boost::container::static_vector<segment_desc_t, MAX_NUM_SEGMENTS> m_descs;
   const ceph::crypto::onwire::rxtx_t* m_crypto;
+  const ceph::compression::onwire::rxtx_t* m_compression = nullptr;
+  __u8 m_compression_alg = 0;  // of the current frame
   bool m_is_rev1;  // msgr2.1?
 };
 
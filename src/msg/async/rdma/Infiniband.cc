@@ -779,6 +779,7 @@ int Infiniband::MemoryManager::Cluster::fill(uint32_t num)
   // FIPS zeroization audit 20191115: this memset is not security related.
   memset(static_cast<void*>(chunk_base), 0, sizeof(Chunk) * num);
   free_chunks.reserve(num);
+  zero_copy.resize(num);
   ibv_mr* m = ibv_reg_mr(manager.pd->pd, base, bytes, IBV_ACCESS_REMOTE_WRITE | IBV_ACCESS_LOCAL_WRITE);
   ceph_assert(m);
   Chunk* chunk = chunk_base;
@@ -794,6 +795,11 @@ void Infiniband::MemoryManager::Cluster::take_back(std::vector<Chunk*> &ck)
 {
   std::lock_guard l{lock};
   for (auto c : ck) {
+    auto& z = get_zero_copy(c);
+    if (z.region) {
+      manager.reg_cache.put(z.region);
+      z = zero_copy_t();
+    }
     c->reset_write_chunk();
     free_chunks.push_back(c);
   }
@@ -813,6 +819,114 @@ int Infiniband::MemoryManager::Cluster::get_buffers(std::vector<Chunk*> &chunks,
   return r;
 }
 
+Infiniband::MemoryManager::RegistrationCache::RegistrationCache(
+  CephContext* c, ProtectionDomain* p)
+  : cct(c), pd(p)
+{
+}
+
+Infiniband::MemoryManager::RegistrationCache::~RegistrationCache()
+{
+  // the queue pairs are gone, nothing reads the regions any more
+  for (auto& [start, r] : regions) {
+    int ret = ibv_dereg_mr(r.mr);
+    ceph_assert(ret == 0);
+  }
+}
+
+Infiniband::MemoryManager::RegistrationCache::region_t*
+Infiniband::MemoryManager::RegistrationCache::get(const ceph::buffer::ptr& bp)
+{
+  const uint64_t max_bytes = cct->_conf->ms_async_rdma_reg_cache_size;
+  const uintptr_t start = reinterpret_cast<uintptr_t>(bp.c_str());
+  const uintptr_t end = start + bp.length();
+  std::lock_guard l{lock};
+  auto p = regions.upper_bound(start);
+  if (p != regions.begin()) {
+    --p;
+    if (end <= p->first + p->second.bp.length()) {
+      auto& r = p->second;
+      ++r.inflight;
+      lru.splice(lru.begin(), lru, r.lru_pos);
+      return &r;
+    }
+  }
+  if (bp.length() > max_bytes) {
+    return nullptr;
+  }
+
+  // register the whole buffer, the rest of it is likely sent next
+  ceph::buffer::ptr whole(bp);
+  if (bp.raw_length() <= max_bytes) {
+    whole.set_offset(0);
+    whole.set_length(whole.raw_length());
+  }
+  const uintptr_t whole_start = reinterpret_cast<uintptr_t>(whole.c_str());
+  auto q = regions.find(whole_start);
+  if (q != regions.end()) {
+    if (q->second.inflight) {
+      return nullptr;
+    }
+    _dereg(q);
+  }
+  _trim(max_bytes - whole.length());
+  ibv_mr* mr = ibv_reg_mr(pd->pd, const_cast<char*>(whole.c_str()),
+                          whole.length(), IBV_ACCESS_LOCAL_WRITE);
+  if (!mr) {
+    ldout(cct, 5) << __func__ << " failed to register " << whole.length()
+                  << " bytes: " << cpp_strerror(errno) << dendl;
+    return nullptr;
+  }
+  ldout(cct, 20) << __func__ << " registered " << whole.length()
+                 << " bytes at " << (void*)whole.c_str() << dendl;
+  bytes += whole.length();
+  auto& r = regions[whole_start];
+  r.bp = std::move(whole);
+  r.mr = mr;
+  r.inflight = 1;
+  lru.push_front(&r);
+  r.lru_pos = lru.begin();
+  return &r;
+}
+
+void Infiniband::MemoryManager::RegistrationCache::pin(region_t* r)
+{
+  std::lock_guard l{lock};
+  ++r->inflight;
+}
+
+void Infiniband::MemoryManager::RegistrationCache::put(region_t* r)
+{
+  std::lock_guard l{lock};
+  ceph_assert(r->inflight > 0);
+  --r->inflight;
+}
+
+void Infiniband::MemoryManager::RegistrationCache::_trim(uint64_t max_bytes)
+{
+  auto p = lru.end();
+  while (p != lru.begin() && bytes > max_bytes) {
+    region_t* r = *--p;
+    if (!r->inflight) {
+      ++p;
+      _dereg(regions.find(reinterpret_cast<uintptr_t>(r->bp.c_str())));
+    }
+  }
+}
+
+void Infiniband::MemoryManager::RegistrationCache::_dereg(
+  std::map<uintptr_t, region_t>::iterator p)
+{
+  ceph_assert(p != regions.end());
+  auto& r = p->second;
+  ceph_assert(r.inflight == 0);
+  int ret = ibv_dereg_mr(r.mr);
+  ceph_assert(ret == 0);
+  bytes -= r.bp.length();
+  lru.erase(r.lru_pos);
+  regions.erase(p);
+}
+
 bool Infiniband::MemoryManager::MemPoolContext::can_alloc(unsigned nbufs)
 {
   /* unlimited */
@@ -935,7 +1049,8 @@ Infiniband::MemoryManager::MemoryManager(CephContext *c, Device *d, ProtectionDo
                    c->_conf->ms_async_rdma_receive_buffers :  2 * c->_conf->ms_async_rdma_receive_queue_len) :
                   // rx pool is infinite, we can set any initial size that we want
                    2 * c->_conf->ms_async_rdma_receive_queue_len,
-                   device->device_attr.max_mr_size / (sizeof(Chunk) + cct->_conf->ms_async_rdma_buffer_size))
+                   device->device_attr.max_mr_size / (sizeof(Chunk) + cct->_conf->ms_async_rdma_buffer_size)),
+    reg_cache(c, p)
 {
 }
 
@@ -996,6 +1111,19 @@ void Infiniband::MemoryManager::create_tx_pool(uint32_t size, uint32_t tx_num)
   send->fill(tx_num);
 }
 
+void Infiniband::MemoryManager::set_zero_copy(
+  Chunk* c, RegistrationCache::region_t* r, const char* addr, uint32_t len)
+{
+  ceph_assert(len <= c->bytes);
+  auto& z = send->get_zero_copy(c);
+  ceph_assert(!z.region);
+  reg_cache.pin(r);
+  z.region = r;
+  z.addr = addr;
+  // the length posted, as if it had been copied in
+  c->offset = len;
+}
+
 void Infiniband::MemoryManager::return_tx(std::vector<Chunk*> &chunks)
 {
   send->take_back(chunks);
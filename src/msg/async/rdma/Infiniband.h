@@ -26,9 +26,12 @@
 
 #include <atomic>
 #include <functional>
+#include <list>
+#include <map>
 #include <string>
 #include <vector>
 
+#include "include/buffer.h"
 #include "include/common_fwd.h"
 #include "include/int_types.h"
 #include "include/page.h"
@@ -186,6 +189,8 @@ enum {
   l_msgr_rdma_rx_chunks,
   l_msgr_rdma_rx_bytes,
   l_msgr_rdma_pending_sent_conns,
+  l_msgr_rdma_tx_zero_copy_bytes,
+  l_msgr_rdma_tx_zero_copy_fallbacks,
 
   l_msgr_rdma_last,
 };
@@ -234,6 +239,44 @@ class Infiniband {
       char  data[0];
     };
 
+    /**
+     * memory regions registered for sending buffers in place
+     *
+     * A registered region holds a reference to the buffer it covers, so
+     * the memory cannot be freed while the NIC may read it.  Regions no
+     * send uses are deregistered least recently used first once more than
+     * max_bytes are registered.
+     */
+    class RegistrationCache {
+     public:
+      struct region_t {
+        ceph::buffer::ptr bp;
+        ibv_mr* mr = nullptr;
+        unsigned inflight = 0;  ///< chunks sending from it
+        std::list<region_t*>::iterator lru_pos;
+      };
+
+      RegistrationCache(CephContext* c, ProtectionDomain* p);
+      ~RegistrationCache();
+
+      /// the region covering @p bp, pinned until put(); nullptr if it
+      /// cannot be registered
+      region_t* get(const ceph::buffer::ptr& bp);
+      void pin(region_t* r);
+      void put(region_t* r);
+
+     private:
+      CephContext* cct;
+      ProtectionDomain* pd;
+      ceph::mutex lock = ceph::make_mutex("RegistrationCache::lock");
+      std::map<uintptr_t, region_t> regions;  ///< by start address
+      std::list<region_t*> lru;               ///< most recently used first
+      uint64_t bytes = 0;
+
+      void _trim(uint64_t max_bytes);
+      void _dereg(std::map<uintptr_t, region_t>::iterator p);
+    };
+
     class Cluster {
      public:
       Cluster(MemoryManager& m, uint32_t s);
@@ -254,6 +297,14 @@ class Infiniband {
       bool is_valid_chunk(const Chunk* c) const {
         return c >= chunk_base && c < chunk_base + num_chunk;
       }
+      /// what a chunk sends in place of its own buffer
+      struct zero_copy_t {
+        RegistrationCache::region_t* region = nullptr;
+        const char* addr = nullptr;
+      };
+      zero_copy_t& get_zero_copy(const Chunk* c) {
+        return zero_copy[c - chunk_base];
+      }
       MemoryManager& manager;
       uint32_t buffer_size;
       uint32_t num_chunk = 0;
@@ -262,6 +313,7 @@ class Infiniband {
       char *base = nullptr;
       char *end = nullptr;
       Chunk* chunk_base = nullptr;
+      std::vector<zero_copy_t> zero_copy;  ///< by chunk
     };
 
     class MemPoolContext {
@@ -356,6 +408,20 @@ class Infiniband {
     uint32_t get_tx_buffer_size() const {
       return send->buffer_size;
     }
+    RegistrationCache& get_reg_cache() {
+      return reg_cache;
+    }
+    /**
+     * send @p len bytes at @p addr out of @p r with the tx chunk @p c,
+     * in place of the chunk's own buffer, until @p c is returned
+     */
+    void set_zero_copy(Chunk* c, RegistrationCache::region_t* r,
+                       const char* addr, uint32_t len);
+    /// nullptr unless @p c sends in place
+    const Cluster::zero_copy_t* get_zero_copy(const Chunk* c) {
+      auto& z = send->get_zero_copy(c);
+      return z.region ? &z : nullptr;
+    }
 
     Chunk *get_rx_buffer() {
        std::lock_guard l{rxbuf_pool.lock};
@@ -382,6 +448,7 @@ class Infiniband {
     ProtectionDomain *pd;
     MemPoolContext rxbuf_pool_ctx;
     mem_pool     rxbuf_pool;
+    RegistrationCache reg_cache;
 
 
     void* huge_pages_malloc(size_t size);
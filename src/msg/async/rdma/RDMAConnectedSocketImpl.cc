@@ -415,22 +415,41 @@ ssize_t RDMAConnectedSocketImpl::submit(bool more)
   if (!bytes)
     return 0;
 
+  const uint64_t zero_copy_min_size = cct->_conf->ms_async_rdma_zero_copy_min_size;
   std::vector<Chunk*> tx_buffers;
   auto it = std::cbegin(pending_bl.buffers());
   auto copy_start = it;
   size_t total_copied = 0, wait_copy_len = 0;
   while (it != pending_bl.buffers().end()) {
-    if (ib->is_tx_buffer(it->raw_c_str())) {
+    bool is_tx_buffer = ib->is_tx_buffer(it->raw_c_str());
+    Infiniband::MemoryManager::RegistrationCache::region_t* region = nullptr;
+    if (!is_tx_buffer && zero_copy_min_size &&
+        it->length() >= zero_copy_min_size) {
+      region = ib->get_memory_manager()->get_reg_cache().get(*it);
+      if (!region)
+        worker->perf_logger->inc(l_msgr_rdma_tx_zero_copy_fallbacks);
+    }
+    if (is_tx_buffer || region) {
       if (wait_copy_len) {
         size_t copied = tx_copy_chunk(tx_buffers, wait_copy_len, copy_start, it);
         total_copied += copied;
-        if (copied < wait_copy_len)
+        if (copied < wait_copy_len) {
+          if (region)
+            ib->get_memory_manager()->get_reg_cache().put(region);
           goto sending;
+        }
         wait_copy_len = 0;
       }
       ceph_assert(copy_start == it);
-      tx_buffers.push_back(ib->get_tx_chunk_by_buffer(it->raw_c_str()));
-      total_copied += it->length();
+      if (region) {
+        size_t sent = tx_zero_copy(tx_buffers, *it, region);
+        total_copied += sent;
+        if (sent < it->length())
+          goto sending;
+      } else {
+        tx_buffers.push_back(ib->get_tx_chunk_by_buffer(it->raw_c_str()));
+        total_copied += it->length();
+      }
       ++copy_start;
     } else {
       wait_copy_len += it->length();
@@ -464,6 +483,31 @@ ssize_t RDMAConnectedSocketImpl::submit(bool more)
   return pending_bl.length() ? -EAGAIN : 0;
 }
 
+size_t RDMAConnectedSocketImpl::tx_zero_copy(std::vector<Chunk*> &tx_buffers,
+    const ceph::buffer::ptr& bp,
+    Infiniband::MemoryManager::RegistrationCache::region_t* region)
+{
+  auto mm = ib->get_memory_manager();
+  // every piece still takes a tx chunk, which stands for its place in the
+  // send queue and lands in one rx buffer of the peer
+  auto chunk_idx = tx_buffers.size();
+  worker->get_reged_mem(this, tx_buffers, bp.length());
+  const size_t chunk_size = mm->get_tx_buffer_size();
+  size_t sent = 0;
+  for (; chunk_idx < tx_buffers.size(); ++chunk_idx) {
+    size_t len = std::min(chunk_size, bp.length() - sent);
+    mm->set_zero_copy(tx_buffers[chunk_idx], region, bp.c_str() + sent, len);
+    sent += len;
+  }
+  mm->get_reg_cache().put(region);
+  if (!sent) {
+    ldout(cct, 1) << __func__ << " no enough buffers in worker " << worker << dendl;
+    worker->perf_logger->inc(l_msgr_rdma_tx_no_mem);
+  }
+  worker->perf_logger->inc(l_msgr_rdma_tx_zero_copy_bytes, sent);
+  return sent;
+}
+
 int RDMAConnectedSocketImpl::post_work_request(std::vector<Chunk*> &tx_buffers)
 {
   ldout(cct, 20) << __func__ << " QP: " << local_qpn << " " << tx_buffers[0] << dendl;
@@ -479,10 +523,16 @@ int RDMAConnectedSocketImpl::post_work_request(std::vector<Chunk*> &tx_buffers)
   memset(iswr, 0, sizeof(iswr));
   memset(isge, 0, sizeof(isge));
  
+  auto mm = ib->get_memory_manager();
   while (current_buffer != tx_buffers.end()) {
-    isge[current_sge].addr = reinterpret_cast<uint64_t>((*current_buffer)->buffer);
     isge[current_sge].length = (*current_buffer)->get_offset();
-    isge[current_sge].lkey = (*current_buffer)->mr->lkey;
+    if (auto z = mm->get_zero_copy(*current_buffer); z) {
+      isge[current_sge].addr = reinterpret_cast<uint64_t>(z->addr);
+      isge[current_sge].lkey = z->region->mr->lkey;
+    } else {
+      isge[current_sge].addr = reinterpret_cast<uint64_t>((*current_buffer)->buffer);
+      isge[current_sge].lkey = (*current_buffer)->mr->lkey;
+    }
     ldout(cct, 25) << __func__ << " sending buffer: " << *current_buffer << " length: " << isge[current_sge].length  << dendl;
 
     iswr[current_swr].wr_id = reinterpret_cast<uint64_t>(*current_buffer);
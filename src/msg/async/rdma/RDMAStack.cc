@@ -673,6 +673,8 @@ RDMAWorker::RDMAWorker(CephContext *c, unsigned worker_id)
   plb.add_u64_counter(l_msgr_rdma_rx_chunks, "rx_chunks", "The number of rx chunks transmitted");
   plb.add_u64_counter(l_msgr_rdma_rx_bytes, "rx_bytes", "The bytes of rx chunks transmitted", NULL, 0, unit_t(UNIT_BYTES));
   plb.add_u64_counter(l_msgr_rdma_pending_sent_conns, "pending_sent_conns", "The count of pending sent conns");
+  plb.add_u64_counter(l_msgr_rdma_tx_zero_copy_bytes, "tx_zero_copy_bytes", "The bytes sent in place without copying", NULL, 0, unit_t(UNIT_BYTES));
+  plb.add_u64_counter(l_msgr_rdma_tx_zero_copy_fallbacks, "tx_zero_copy_fallbacks", "The count of large buffers copied since they could not be registered");
 
   perf_logger = plb.create_perf_counters();
   cct->get_perfcounters_collection()->add(perf_logger);
@@ -203,6 +203,8 @@ class RDMAConnectedSocketImpl : public ConnectedSocketImpl {
   size_t tx_copy_chunk(std::vector<Chunk*> &tx_buffers, size_t req_copy_len,
       decltype(std::cbegin(pending_bl.buffers()))& start,
       const decltype(std::cbegin(pending_bl.buffers()))& end);
+  size_t tx_zero_copy(std::vector<Chunk*> &tx_buffers, const ceph::buffer::ptr& bp,
+      Infiniband::MemoryManager::RegistrationCache::region_t* region);
 
  public:
   RDMAConnectedSocketImpl(CephContext *cct, std::shared_ptr<Infiniband>& ib,
@@ -778,6 +778,19 @@ RADOS::executor_type RADOS::get_executor() const {
   return impl->ioctx.get_executor();
 }
 
+RADOS::executor_type RADOS::get_executor(const Object& o) const {
+  const auto& ioctxs = impl->completion_ioctxs;
+  if (ioctxs.empty()) {
+    return impl->ioctx.get_executor();
+  }
+  return ioctxs[std::hash<Object>{}(o) % ioctxs.size()]->get_executor();
+}
+
+void RADOS::set_completion_io_contexts(
+  std::vector<boost::asio::io_context*> ioctxs) {
+  impl->completion_ioctxs = std::move(ioctxs);
+}
+
 boost::asio::io_context& RADOS::get_io_context() {
   return impl->ioctx;
 }
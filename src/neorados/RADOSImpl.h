@@ -85,6 +85,8 @@ public:
   Client& operator=(const Client&) = delete;
 
   boost::asio::io_context& ioctx;
+  /// where the completions go instead of ioctx, by object
+  std::vector<boost::asio::io_context*> completion_ioctxs;
 
   boost::intrusive_ptr<CephContext> cct;
   MonClient& monclient;
@@ -104,6 +104,44 @@ int ObjectStore::probe_block_device_fsid(
   return -EINVAL;
 }
 
+int ObjectStore::omap_get_vals_encoded(
+  CollectionHandle &c,
+  const ghobject_t &oid,
+  const std::string &start_after,
+  const std::string &filter_prefix,
+  uint64_t max_entries,
+  uint64_t max_bytes,
+  ceph::buffer::list *out,
+  uint32_t *num,
+  bool *more)
+{
+  *num = 0;
+  *more = false;
+  ObjectMap::ObjectMapIterator iter = get_omap_iterator(c, oid);
+  if (!iter) {
+    return -ENOENT;
+  }
+  iter->upper_bound(start_after);
+  if (filter_prefix > start_after) {
+    iter->lower_bound(filter_prefix);
+  }
+  size_t start = out->length();
+  for (; iter->valid(); iter->next()) {
+    string key = iter->key();
+    if (key.compare(0, filter_prefix.size(), filter_prefix) != 0) {
+      break;
+    }
+    if (*num >= max_entries || out->length() - start >= max_bytes) {
+      *more = true;
+      break;
+    }
+    encode(key, *out);
+    encode(iter->value(), *out);
+    ++*num;
+  }
+  return 0;
+}
+
 int ObjectStore::write_meta(const std::string& key,
 			    const std::string& value)
 {
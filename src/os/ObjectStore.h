@@ -745,6 +745,29 @@ public:
     const ghobject_t &oid  ///< [in] object
     ) = 0;
 
+  /**
+   * Get a range of omap keys and values at once
+   *
+   * The pairs are appended to @p out the way the entries of a
+   * std::map<std::string, ceph::buffer::list> are encoded, without the
+   * leading count, so that listings need not build the map.  Pairs are
+   * added until @p max_entries of them, or @p max_bytes added to @p out,
+   * are reached.
+   *
+   * @return 0 on success, -ENOENT if the object does not exist
+   */
+  virtual int omap_get_vals_encoded(
+    CollectionHandle &c,             ///< [in] Collection containing oid
+    const ghobject_t &oid,           ///< [in] Object containing omap
+    const std::string &start_after,  ///< [in] list keys after this one
+    const std::string &filter_prefix, ///< [in] list keys with this prefix
+    uint64_t max_entries,            ///< [in] max pairs to return
+    uint64_t max_bytes,              ///< [in] max bytes to return
+    ceph::buffer::list *out,         ///< [out] encoded pairs
+    uint32_t *num,                   ///< [out] number of pairs
+    bool *more                       ///< [out] true if pairs are left
+    );
+
   virtual int flush_journal() { return -EOPNOTSUPP; }
 
   virtual int dump_journal(std::ostream& out) { return -EOPNOTSUPP; }
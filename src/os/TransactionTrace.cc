@@ -0,0 +1,226 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+/*
+ * Ceph - scalable distributed file system
+ *
+ * This is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License version 2.1, as published by the Free Software
+ * Foundation.  See file COPYING.
+ *
+ */
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "common/safe_io.h"
+#include "include/compat.h"
+#include "os/TransactionTrace.h"
+
+using std::string;
+using std::vector;
+
+using ceph::bufferlist;
+using ceph::mono_clock;
+
+namespace ceph::os {
+
+static const char TRACE_MAGIC[] = "ceph os trace v1\n";
+static constexpr unsigned TRACE_MAGIC_LEN = sizeof(TRACE_MAGIC) - 1;
+/// write the records out once this much of them is pending
+static constexpr unsigned TRACE_FLUSH_BYTES = 1 << 20;
+
+TransactionTraceWriter::~TransactionTraceWriter()
+{
+  close();
+}
+
+int TransactionTraceWriter::open(const string& path)
+{
+  std::lock_guard l(lock);
+  ceph_assert(fd < 0);
+  fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (fd < 0) {
+    return -errno;
+  }
+  start = mono_clock::now();
+  pending.append(TRACE_MAGIC, TRACE_MAGIC_LEN);
+  return _flush();
+}
+
+int TransactionTraceWriter::_flush()
+{
+  if (!pending.length()) {
+    return 0;
+  }
+  int r = pending.write_fd(fd);
+  pending.clear();
+  return r;
+}
+
+int TransactionTraceWriter::close()
+{
+  std::lock_guard l(lock);
+  if (fd < 0) {
+    return 0;
+  }
+  int r = _flush();
+  VOID_TEMP_FAILURE_RETRY(::close(fd));
+  fd = -1;
+  return r;
+}
+
+void TransactionTraceWriter::record(vector<Transaction>& tls)
+{
+  using ceph::encode;
+  std::hash<coll_t> hash_cid;
+  std::hash<ghobject_t> hash_oid;
+  const uint64_t stamp =
+    std::chrono::duration_cast<std::chrono::microseconds>(
+      mono_clock::now() - start).count();
+
+  bufferlist bl;
+  for (auto& t : tls) {
+    trace_txn_t txn;
+    txn.stamp = stamp;
+    uint64_t data_bytes = 0;
+    auto i = t.begin();
+    while (i.have_op()) {
+      auto op = i.decode_op();
+      trace_op_t top;
+      top.op = op->op;
+      switch (op->op) {
+      case Transaction::OP_WRITE:
+	data_bytes += op->len;
+	// fall through
+      case Transaction::OP_ZERO:
+      case Transaction::OP_TRUNCATE:
+	top.off = op->off;
+	top.len = op->len;
+	break;
+      case Transaction::OP_CLONERANGE2:
+	top.off = op->off;
+	top.len = op->len;
+	top.dest_off = op->dest_off;
+	// fall through
+      case Transaction::OP_CLONE:
+	top.dest_oid = hash_oid(i.get_oid(op->dest_oid));
+	break;
+      case Transaction::OP_SETALLOCHINT:
+	top.off = op->expected_object_size;
+	top.len = op->expected_write_size;
+	break;
+      case Transaction::OP_CREATE:
+	top.op = Transaction::OP_TOUCH;
+	break;
+      case Transaction::OP_TOUCH:
+      case Transaction::OP_REMOVE:
+      case Transaction::OP_SETATTR:
+      case Transaction::OP_SETATTRS:
+      case Transaction::OP_RMATTR:
+      case Transaction::OP_RMATTRS:
+      case Transaction::OP_OMAP_CLEAR:
+      case Transaction::OP_OMAP_SETKEYS:
+      case Transaction::OP_OMAP_RMKEYS:
+      case Transaction::OP_OMAP_RMKEYRANGE:
+      case Transaction::OP_OMAP_SETHEADER:
+	break;
+      default:
+	// collection ops: the replay brings its own collections
+	continue;
+      }
+      top.cid = hash_cid(i.get_cid(op->cid));
+      top.oid = hash_oid(i.get_oid(op->oid));
+      txn.ops.push_back(top);
+    }
+    // what is left once the ops and the data of the writes are taken out
+    // is roughly the attrs and the omap the transaction sets
+    uint64_t overhead = sizeof(Transaction::TransactionData) +
+      t.get_num_ops() * sizeof(Transaction::Op) + data_bytes;
+    uint64_t encoded = t.get_encoded_bytes();
+    txn.meta_bytes = encoded > overhead ? encoded - overhead : 0;
+
+    bufferlist tbl;
+    encode(txn, tbl);
+    encode((uint32_t)tbl.length(), bl);
+    bl.claim_append(tbl);
+  }
+
+  std::lock_guard l(lock);
+  if (fd < 0) {
+    return;
+  }
+  pending.claim_append(bl);
+  if (pending.length() >= TRACE_FLUSH_BYTES) {
+    _flush();
+  }
+}
+
+TransactionTraceReader::~TransactionTraceReader()
+{
+  if (fd >= 0) {
+    VOID_TEMP_FAILURE_RETRY(::close(fd));
+  }
+}
+
+int TransactionTraceReader::open(const string& path)
+{
+  ceph_assert(fd < 0);
+  fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return -errno;
+  }
+  char magic[TRACE_MAGIC_LEN];
+  int r = safe_read_exact(fd, magic, TRACE_MAGIC_LEN);
+  if (r < 0) {
+    return r == -EDOM ? -EINVAL : r;
+  }
+  if (memcmp(magic, TRACE_MAGIC, TRACE_MAGIC_LEN) != 0) {
+    return -EINVAL;
+  }
+  return 0;
+}
+
+int TransactionTraceReader::rewind()
+{
+  if (::lseek(fd, TRACE_MAGIC_LEN, SEEK_SET) < 0) {
+    return -errno;
+  }
+  return 0;
+}
+
+int TransactionTraceReader::next(trace_txn_t* txn)
+{
+  ceph_le32 len;
+  ssize_t r = safe_read(fd, &len, sizeof(len));
+  if (r == 0) {
+    return 0;
+  }
+  if (r < 0) {
+    return r;
+  }
+  if (r != sizeof(len)) {
+    // a record cut short by the end of the capture
+    return 0;
+  }
+  ceph::bufferptr bp = ceph::buffer::create(len);
+  r = safe_read_exact(fd, bp.c_str(), len);
+  if (r == -EDOM) {
+    return 0;
+  }
+  if (r < 0) {
+    return r;
+  }
+  bufferlist bl;
+  bl.append(std::move(bp));
+  using ceph::decode;
+  try {
+    auto p = bl.cbegin();
+    decode(*txn, p);
+  } catch (ceph::buffer::error&) {
+    return -EIO;
+  }
+  return 1;
+}
+
+} // namespace ceph::os
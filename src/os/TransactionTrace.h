@@ -0,0 +1,106 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+/*
+ * Ceph - scalable distributed file system
+ *
+ * This is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License version 2.1, as published by the Free Software
+ * Foundation.  See file COPYING.
+ *
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "include/buffer.h"
+#include "include/denc.h"
+#include "common/ceph_mutex.h"
+#include "common/ceph_time.h"
+#include "os/Transaction.h"
+
+namespace ceph::os {
+
+/**
+ * trace_op_t
+ *
+ * An op of a traced transaction.  The collections and objects are
+ * hashed, which is enough to replay the same access pattern against
+ * other ones, and the data of the writes, the attrs and the omap are
+ * left out.
+ */
+struct trace_op_t {
+  uint8_t op = 0;        ///< Transaction::OP_*
+  uint64_t cid = 0;      ///< hash of the collection
+  uint64_t oid = 0;      ///< hash of the object
+  uint64_t dest_oid = 0; ///< hash of the new object, OP_CLONE*
+  uint64_t off = 0;      ///< expected object size for OP_SETALLOCHINT
+  uint64_t len = 0;      ///< expected write size for OP_SETALLOCHINT
+  uint64_t dest_off = 0; ///< OP_CLONERANGE2
+
+  DENC(trace_op_t, v, p) {
+    DENC_START(1, 1, p);
+    denc(v.op, p);
+    denc_varint(v.cid, p);
+    denc_varint(v.oid, p);
+    denc_varint(v.dest_oid, p);
+    denc_varint(v.off, p);
+    denc_varint(v.len, p);
+    denc_varint(v.dest_off, p);
+    DENC_FINISH(p);
+  }
+};
+
+struct trace_txn_t {
+  uint64_t stamp = 0;      ///< usec since the trace started
+  uint64_t meta_bytes = 0; ///< bytes of the attrs, omap keys and values
+  std::vector<trace_op_t> ops;
+
+  DENC(trace_txn_t, v, p) {
+    DENC_START(1, 1, p);
+    denc_varint(v.stamp, p);
+    denc_varint(v.meta_bytes, p);
+    denc(v.ops, p);
+    DENC_FINISH(p);
+  }
+};
+
+/// appends the transactions an ObjectStore is given to a trace file
+class TransactionTraceWriter {
+  ceph::mutex lock = ceph::make_mutex("TransactionTraceWriter::lock");
+  int fd = -1;
+  ceph::mono_time start;
+  ceph::buffer::list pending;
+
+  int _flush();
+
+public:
+  TransactionTraceWriter() = default;
+  ~TransactionTraceWriter();
+
+  int open(const std::string& path);
+  int close();
+  void record(std::vector<Transaction>& tls);
+};
+
+/// reads a trace file back, one transaction at a time
+class TransactionTraceReader {
+  int fd = -1;
+
+public:
+  TransactionTraceReader() = default;
+  ~TransactionTraceReader();
+
+  int open(const std::string& path);
+  /// go back to the first transaction of the trace
+  int rewind();
+  /// @returns 1 if @p txn is the next transaction, 0 at the end of the trace
+  int next(trace_txn_t* txn);
+};
+
+} // namespace ceph::os
+
+WRITE_CLASS_DENC(ceph::os::trace_op_t)
+WRITE_CLASS_DENC(ceph::os::trace_txn_t)
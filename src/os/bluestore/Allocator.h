@@ -47,6 +47,27 @@ public:
     return allocate(want_size, block_size, want_size, hint, extents);
   }
 
+  /// how long the data being allocated for is expected to live
+  enum class lifetime_t : uint8_t {
+    unknown = 0,
+    short_lived,
+    long_lived,
+  };
+  static constexpr size_t LIFETIME_COUNT = 3;
+
+  /*
+   * Allocate for one of several streams of writes, e.g. those of a
+   * collection.  The data of a stream, and of a lifetime, tends to be
+   * released together, so allocators that keep streams apart leave fewer
+   * and larger holes behind as the device ages.  Others just allocate.
+   */
+  virtual int64_t allocate_stream(uint64_t stream, lifetime_t lifetime,
+				  uint64_t want_size, uint64_t block_size,
+				  uint64_t max_alloc_size,
+				  PExtentVector *extents) {
+    return allocate(want_size, block_size, max_alloc_size, 0, extents);
+  }
+
   /* Bulk release. Implementations may override this method to handle the whole
    * set at once. This could save e.g. unnecessary mutex dance. */
   virtual void release(const interval_set<uint64_t>& release_set) = 0;
@@ -185,6 +185,7 @@ private:
 
 BlueFS::BlueFS(CephContext* cct)
   : cct(cct),
+    compact_log_thread(this),
     bdev(MAX_BDEV),
     ioc(MAX_BDEV),
     block_reserved(MAX_BDEV),
@@ -815,6 +816,7 @@ int BlueFS::mount()
            << std::hex << log_writer->pos << std::dec
            << dendl;
 
+  _start_compact_log_thread();
   return 0;
 
  out:
@@ -843,6 +845,8 @@ void BlueFS::umount(bool avoid_compact)
 {
   dout(1) << __func__ << dendl;
 
+  // a compaction still due is done inline below
+  _stop_compact_log_thread();
   sync_metadata(avoid_compact);
 
   _close_writer(log_writer);
@@ -2108,6 +2112,10 @@ void BlueFS::compact_log()
 {
   std::unique_lock<ceph::mutex> l(lock);
   if (!cct->_conf->bluefs_replay_recovery_disable_compact) {
+    // let a background compaction finish first
+    while (new_log) {
+      log_cond.wait(l);
+    }
     if (cct->_conf->bluefs_compact_log_sync) {
       _compact_log_sync();
     } else {
@@ -2320,6 +2328,13 @@ void BlueFS::_compact_log_async(std::unique_lock<ceph::mutex>& l)
   new_log = ceph::make_ref<File>();
   new_log->fnode.ino = 0;   // so that _flush_range won't try to log the fnode
 
+  // make what was written before the compaction stable, without holding
+  // the lock: flushing every device can take long and fsyncs of other
+  // files need the lock meanwhile.
+  l.unlock();
+  flush_bdev();
+  l.lock();
+
   // 0. wait for any racing flushes to complete.  (We do not want to block
   // in _flush_sync_log with jump_to set or else a racing thread might flush
   // our entries and our jump_to update won't be correct.)
@@ -2347,8 +2362,6 @@ void BlueFS::_compact_log_async(std::unique_lock<ceph::mutex>& l)
   log_t.op_file_update(log_file->fnode);
   log_t.op_jump(log_seq, old_log_jump_to);
 
-  flush_bdev();  // FIXME?
-
   _flush_and_sync_log(l, 0, old_log_jump_to);
 
   // 2. prepare compacted log
@@ -3157,7 +3170,9 @@ void BlueFS::sync_metadata(bool avoid_compact)
     lgeneric_subdout(cct, bluefs, 10) << __func__;
     start = ceph_clock_now();
     *_dout <<  dendl;
+    l.unlock();
     flush_bdev(); // FIXME?
+    l.lock();
     _flush_and_sync_log(l);
     dout(10) << __func__ << " done in " << (ceph_clock_now() - start) << dendl;
   }
@@ -3173,12 +3188,57 @@ void BlueFS::_maybe_compact_log(std::unique_lock<ceph::mutex>& l)
       _should_compact_log()) {
     if (cct->_conf->bluefs_compact_log_sync) {
       _compact_log_sync();
+    } else if (compact_log_thread.is_started()) {
+      if (!compact_log_queued) {
+	dout(10) << __func__ << " queueing async compaction" << dendl;
+	compact_log_queued = true;
+	compact_log_cond.notify_one();
+      }
     } else {
       _compact_log_async(l);
     }
   }
 }
 
+void BlueFS::_compact_log_thread()
+{
+  std::unique_lock l(lock);
+  while (true) {
+    compact_log_cond.wait(l, [this] {
+      return compact_log_queued || compact_log_stop;
+    });
+    if (compact_log_stop) {
+      break;
+    }
+    compact_log_queued = false;
+    // the log may have been compacted by compact_log() meanwhile
+    if (!cct->_conf->bluefs_replay_recovery_disable_compact &&
+	_should_compact_log()) {
+      _compact_log_async(l);
+    }
+  }
+}
+
+void BlueFS::_start_compact_log_thread()
+{
+  compact_log_stop = false;
+  compact_log_queued = false;
+  compact_log_thread.create("bluefs_compact");
+}
+
+void BlueFS::_stop_compact_log_thread()
+{
+  if (!compact_log_thread.is_started()) {
+    return;
+  }
+  {
+    std::lock_guard l(lock);
+    compact_log_stop = true;
+    compact_log_cond.notify_one();
+  }
+  compact_log_thread.join();
+}
+
 int BlueFS::open_for_write(
   std::string_view dirname,
   std::string_view filename,
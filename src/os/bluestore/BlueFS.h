@@ -11,6 +11,7 @@
 #include "blk/BlockDevice.h"
 
 #include "common/RefCountedObj.h"
+#include "common/Thread.h"
 #include "common/ceph_context.h"
 #include "global/global_context.h"
 #include "include/common_fwd.h"
@@ -329,6 +330,20 @@ private:
   FileRef new_log = nullptr;
   FileWriter *new_log_writer = nullptr;
 
+  /// runs async log compactions, so that the flush or fsync which finds
+  /// the log too big does not have to wait for the compaction
+  struct CompactLogThread : public Thread {
+    BlueFS *bluefs;
+    explicit CompactLogThread(BlueFS *b) : bluefs(b) {}
+    void *entry() override {
+      bluefs->_compact_log_thread();
+      return NULL;
+    }
+  } compact_log_thread;
+  bool compact_log_queued = false;
+  bool compact_log_stop = false;
+  ceph::condition_variable compact_log_cond;
+
   /*
    * There are up to 3 block devices:
    *
@@ -410,6 +425,9 @@ private:
 				  int flags);
   void _compact_log_sync();
   void _compact_log_async(std::unique_lock<ceph::mutex>& l);
+  void _compact_log_thread();
+  void _start_compact_log_thread();
+  void _stop_compact_log_thread();
 
   void _rewrite_log_and_layout_sync(bool allocate_with_fallback,
 				    int super_dev,
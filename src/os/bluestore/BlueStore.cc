@@ -12,6 +12,7 @@
  *
  */
 
+#include <cmath>
 #include <unistd.h>
 #include <stdlib.h>
 #include <sys/types.h>
@@ -29,12 +30,15 @@
 #include "include/compat.h"
 #include "include/intarith.h"
 #include "include/stringify.h"
+#include "include/str_list.h"
 #include "include/str_map.h"
 #include "include/util.h"
 #include "common/errno.h"
 #include "common/safe_io.h"
 #include "common/PriorityCache.h"
 #include "Allocator.h"
+#include "CachedAllocator.h"
+#include "StreamAllocator.h"
 #include "FreelistManager.h"
 #include "BlueFS.h"
 #include "BlueRocksEnv.h"
@@ -70,6 +74,10 @@ using bid_t = decltype(BlueStore::Blob::id);
 MEMPOOL_DEFINE_OBJECT_FACTORY(BlueStore::Onode, bluestore_onode,
 			      bluestore_cache_onode);
 
+// bluestore_cache_encoded_onode
+MEMPOOL_DEFINE_OBJECT_FACTORY(BlueStore::EncodedOnode, bluestore_encoded_onode,
+			      bluestore_cache_encoded_onode);
+
 // bluestore_cache_other
 MEMPOOL_DEFINE_OBJECT_FACTORY(BlueStore::Buffer, bluestore_buffer,
 			      bluestore_Buffer);
@@ -1113,8 +1121,12 @@ struct LruOnodeCacheShard : public BlueStore::OnodeCacheShard {
       }
       auto pinned = !o->pop_cache();
       ceph_assert(!pinned);
+      if (new_size && encoded_max_bytes) {
+	o->c->onode_map._stash_encoded(o);
+      }
       o->c->onode_map._remove(o->oid);
     }
+    _trim_encoded();
   }
   void move_pinned(OnodeCacheShard *to, BlueStore::Onode *o) override
   {
@@ -1135,9 +1147,43 @@ struct LruOnodeCacheShard : public BlueStore::OnodeCacheShard {
     *onodes += num;
     *pinned_onodes += num_pinned;
   }
+  void _get_hot(size_t max,
+    std::vector<std::pair<coll_t, ghobject_t>>* hot) override
+  {
+    for (auto p = lru.begin(); p != lru.end() && max > 0; ++p, --max) {
+      hot->emplace_back(p->c->cid, p->oid);
+    }
+  }
 };
 
 // OnodeCacheShard
+void BlueStore::OnodeCacheShard::_add_encoded(EncodedOnode *e)
+{
+  encoded_lru.push_front(*e);
+  ++num_encoded;
+  encoded_bytes += e->get_bytes();
+}
+
+void BlueStore::OnodeCacheShard::_rm_encoded(EncodedOnode *e)
+{
+  encoded_lru.erase(encoded_lru.iterator_to(*e));
+  ceph_assert(num_encoded);
+  --num_encoded;
+  encoded_bytes -= e->get_bytes();
+}
+
+void BlueStore::OnodeCacheShard::_trim_encoded()
+{
+  while (encoded_bytes > encoded_max_bytes) {
+    ceph_assert(!encoded_lru.empty());
+    EncodedOnode *e = &encoded_lru.back();
+    dout(20) << __func__ << "  rm encoded " << e->oid << dendl;
+    e->space->encoded_map.erase(e->oid);
+    _rm_encoded(e);
+    delete e;
+  }
+}
+
 BlueStore::OnodeCacheShard *BlueStore::OnodeCacheShard::create(
     CephContext* cct,
     string type,
@@ -1560,6 +1606,240 @@ public:
 #endif
 };
 
+// ArcBufferCacheShard
+
+/*
+ * Adaptive replacement cache (Megiddo and Modha, FAST '03), in bytes.
+ *
+ * Buffers read once live in t1, buffers hit again in t2.  Evicted
+ * buffers stay behind as empty "ghosts" in b1 or b2, and a read that
+ * lands on a ghost tells which of t1 and t2 should have been larger:
+ * the target size of t1 moves accordingly.  A scan only ever fills t1
+ * and b1, so it cannot push the hot buffers of t2 out of the cache like
+ * it does with a plain LRU.
+ */
+struct ArcBufferCacheShard : public BlueStore::BufferCacheShard {
+  typedef boost::intrusive::list<
+    BlueStore::Buffer,
+    boost::intrusive::member_hook<
+      BlueStore::Buffer,
+      boost::intrusive::list_member_hook<>,
+      &BlueStore::Buffer::lru_item> > list_t;
+
+  // ordered so that BufferSpace::_discard() hints with the most
+  // valuable of the lists the discarded buffers were on
+  enum {
+    BUFFER_NEW = 0,
+    BUFFER_T1,        ///< in t1, seen once
+    BUFFER_B1,        ///< in b1, ghost of t1
+    BUFFER_B2,        ///< in b2, ghost of t2
+    BUFFER_T2,        ///< in t2, seen more than once
+    BUFFER_TYPE_MAX
+  };
+
+  list_t lists[BUFFER_TYPE_MAX];
+  /// bytes per list; for ghosts, the bytes they stood for
+  uint64_t list_bytes[BUFFER_TYPE_MAX] = {0};
+  uint64_t t1_target = 0;  ///< "p", target bytes of t1
+
+public:
+  explicit ArcBufferCacheShard(CephContext *cct) : BufferCacheShard(cct) {}
+
+  void _link(BlueStore::Buffer *b, bool front) {
+    ceph_assert(b->cache_private > BUFFER_NEW &&
+		b->cache_private < BUFFER_TYPE_MAX);
+    ceph_assert(b->is_empty() == (b->cache_private == BUFFER_B1 ||
+				  b->cache_private == BUFFER_B2));
+    auto& l = lists[b->cache_private];
+    if (front) {
+      l.push_front(*b);
+    } else {
+      l.push_back(*b);
+    }
+    list_bytes[b->cache_private] += b->length;
+    if (!b->is_empty()) {
+      buffer_bytes += b->length;
+    }
+    num = lists[BUFFER_T1].size() + lists[BUFFER_T2].size();
+  }
+  void _unlink(BlueStore::Buffer *b) {
+    ceph_assert(list_bytes[b->cache_private] >= b->length);
+    list_bytes[b->cache_private] -= b->length;
+    if (!b->is_empty()) {
+      ceph_assert(buffer_bytes >= b->length);
+      buffer_bytes -= b->length;
+    }
+    auto& l = lists[b->cache_private];
+    l.erase(l.iterator_to(*b));
+    num = lists[BUFFER_T1].size() + lists[BUFFER_T2].size();
+  }
+
+  void _add(BlueStore::Buffer *b, int level, BlueStore::Buffer *near) override
+  {
+    dout(20) << __func__ << " level " << level << " near " << near
+             << " on " << *b
+             << " which has cache_private " << b->cache_private << dendl;
+    if (near) {
+      b->cache_private = near->cache_private;
+      ceph_assert(b->cache_private > BUFFER_NEW &&
+		  b->cache_private < BUFFER_TYPE_MAX);
+      auto& l = lists[b->cache_private];
+      l.insert(l.iterator_to(*near), *b);
+      list_bytes[b->cache_private] += b->length;
+      if (!b->is_empty()) {
+	buffer_bytes += b->length;
+      }
+      num = lists[BUFFER_T1].size() + lists[BUFFER_T2].size();
+      return;
+    }
+    // the hint is where the data we replace was
+    uint64_t b1 = std::max<uint64_t>(list_bytes[BUFFER_B1], 1);
+    uint64_t b2 = std::max<uint64_t>(list_bytes[BUFFER_B2], 1);
+    switch (b->cache_private) {
+    case BUFFER_NEW:
+      b->cache_private = BUFFER_T1;
+      // take caller hint to start at the back of t1
+      _link(b, level > 0);
+      return;
+    case BUFFER_B1:
+      // t1 was too small for this one
+      t1_target = std::min<uint64_t>(
+	max, t1_target + std::max<uint64_t>(b->length, b->length * b2 / b1));
+      break;
+    case BUFFER_B2:
+      // t2 was too small for this one
+      t1_target -= std::min<uint64_t>(
+	t1_target, std::max<uint64_t>(b->length, b->length * b1 / b2));
+      break;
+    case BUFFER_T1:
+    case BUFFER_T2:
+      break;
+    default:
+      ceph_abort_msg("bad cache_private");
+    }
+    dout(20) << __func__ << " move to front of t2 " << *b
+	     << ", t1 target " << t1_target << dendl;
+    b->cache_private = BUFFER_T2;
+    _link(b, true);
+  }
+
+  void _rm(BlueStore::Buffer *b) override
+  {
+    dout(20) << __func__ << " " << *b << dendl;
+    _unlink(b);
+  }
+
+  void _move(BlueStore::BufferCacheShard *srcc, BlueStore::Buffer *b) override
+  {
+    ArcBufferCacheShard *src = static_cast<ArcBufferCacheShard*>(srcc);
+    src->_rm(b);
+    // preserve which list we're on (even if we can't preserve the order!)
+    _link(b, false);
+  }
+
+  void _adjust_size(BlueStore::Buffer *b, int64_t delta) override
+  {
+    dout(20) << __func__ << " delta " << delta << " on " << *b << dendl;
+    ceph_assert((int64_t)list_bytes[b->cache_private] + delta >= 0);
+    list_bytes[b->cache_private] += delta;
+    if (!b->is_empty()) {
+      ceph_assert((int64_t)buffer_bytes + delta >= 0);
+      buffer_bytes += delta;
+    }
+  }
+
+  void _touch(BlueStore::Buffer *b) override {
+    switch (b->cache_private) {
+    case BUFFER_T1:
+    case BUFFER_T2:
+      // move to front of t2
+      _unlink(b);
+      b->cache_private = BUFFER_T2;
+      _link(b, true);
+      break;
+    default:
+      ceph_abort_msg("ghosts are hit via discard hint");
+    }
+    _audit("_touch_buffer end");
+  }
+
+  void _evict(int from, int to) {
+    BlueStore::Buffer *b = &*lists[from].rbegin();
+    ceph_assert(b->is_clean());
+    dout(20) << __func__ << " " << from << " -> " << to << " " << *b << dendl;
+    _unlink(b);
+    b->state = BlueStore::Buffer::STATE_EMPTY;
+    b->data.clear();
+    b->cache_private = to;
+    _link(b, true);
+  }
+
+  void _trim_to(uint64_t max) override
+  {
+    while (buffer_bytes > max) {
+      if (lists[BUFFER_T1].empty() && lists[BUFFER_T2].empty()) {
+	break;
+      }
+      if (lists[BUFFER_T2].empty() ||
+	  (!lists[BUFFER_T1].empty() && list_bytes[BUFFER_T1] > t1_target)) {
+	_evict(BUFFER_T1, BUFFER_B1);
+      } else {
+	_evict(BUFFER_T2, BUFFER_B2);
+      }
+    }
+
+    // t1 + b1 and t2 + b2 each remember up to ghost_ratio * max bytes
+    double ghost_ratio = cct->_conf->bluestore_arc_cache_ghost_ratio;
+    uint64_t ghost_max = max * ghost_ratio;
+    uint64_t b1_max = ghost_max -
+      std::min(ghost_max, uint64_t(list_bytes[BUFFER_T1] * ghost_ratio));
+    uint64_t b2_max = ghost_max -
+      std::min(ghost_max, uint64_t(list_bytes[BUFFER_T2] * ghost_ratio));
+    for (auto [which, most] : { std::make_pair(BUFFER_B1, b1_max),
+				std::make_pair(BUFFER_B2, b2_max) }) {
+      auto& l = lists[which];
+      while (list_bytes[which] > most && !l.empty()) {
+	BlueStore::Buffer *b = &*l.rbegin();
+	ceph_assert(b->is_empty());
+	dout(20) << __func__ << " ghost rm " << *b << dendl;
+	b->space->_rm_buffer(this, b);
+      }
+    }
+    num = lists[BUFFER_T1].size() + lists[BUFFER_T2].size();
+  }
+
+  void add_stats(uint64_t *extents,
+                 uint64_t *blobs,
+                 uint64_t *buffers,
+                 uint64_t *bytes) override {
+    *extents += num_extents;
+    *blobs += num_blobs;
+    *buffers += num;
+    *bytes += buffer_bytes;
+  }
+
+#ifdef DEBUG_CACHE
+  void _audit(const char *when) override
+  {
+    dout(10) << __func__ << " " << when << " start" << dendl;
+    uint64_t s = 0;
+    for (int t = BUFFER_T1; t < BUFFER_TYPE_MAX; ++t) {
+      uint64_t ls = 0;
+      for (auto& b : lists[t]) {
+	ls += b.length;
+      }
+      ceph_assert(ls == list_bytes[t]);
+      if (t == BUFFER_T1 || t == BUFFER_T2) {
+	s += ls;
+      }
+    }
+    ceph_assert(s == buffer_bytes);
+    dout(20) << __func__ << " " << when << " buffer_bytes " << buffer_bytes
+             << " ok" << dendl;
+  }
+#endif
+};
+
 // BuferCacheShard
 
 BlueStore::BufferCacheShard *BlueStore::BufferCacheShard::create(
@@ -1572,6 +1852,8 @@ BlueStore::BufferCacheShard *BlueStore::BufferCacheShard::create(
     c = new LruBufferCacheShard(cct);
   else if (type == "2q")
     c = new TwoQBufferCacheShard(cct);
+  else if (type == "arc")
+    c = new ArcBufferCacheShard(cct);
   else
     ceph_abort_msg("unrecognized cache type");
   c->logger = logger;
@@ -1702,7 +1984,7 @@ void BlueStore::BufferSpace::read(
 	  res_intervals.insert(offset, l);
 	  offset += l;
 	  length -= l;
-	  if (!b->is_writing()) {
+	  if (!b->is_writing() && !(flags & SEQUENTIAL_READ)) {
 	    cache->_touch(b);
           }
 	  continue;
@@ -1715,7 +1997,7 @@ void BlueStore::BufferSpace::read(
 	  offset += gap;
 	  length -= gap;
         }
-        if (!b->is_writing()) {
+        if (!b->is_writing() && !(flags & SEQUENTIAL_READ)) {
 	  cache->_touch(b);
         }
         if (b->length > length) {
@@ -1739,6 +2021,10 @@ void BlueStore::BufferSpace::read(
   uint64_t miss_bytes = want_bytes - hit_bytes;
   cache->logger->inc(l_bluestore_buffer_hit_bytes, hit_bytes);
   cache->logger->inc(l_bluestore_buffer_miss_bytes, miss_bytes);
+  if (flags & SEQUENTIAL_READ) {
+    cache->logger->inc(l_bluestore_buffer_seq_hit_bytes, hit_bytes);
+    cache->logger->inc(l_bluestore_buffer_seq_miss_bytes, miss_bytes);
+  }
 }
 
 void BlueStore::BufferSpace::_finish_write(BufferCacheShard* cache, uint64_t seq)
@@ -1843,6 +2129,7 @@ BlueStore::OnodeRef BlueStore::OnodeSpace::add(const ghobject_t& oid,
     return p->second;
   }
   ldout(cache->cct, 20) << __func__ << " " << oid << " " << o << dendl;
+  _drop_encoded(oid);
   onode_map[oid] = o;
   cache->_add(o.get(), 1);
   cache->_trim();
@@ -1855,6 +2142,59 @@ void BlueStore::OnodeSpace::_remove(const ghobject_t& oid)
   onode_map.erase(oid);
 }
 
+void BlueStore::OnodeSpace::_stash_encoded(Onode *o)
+{
+  // an unpinned onode has no uncommitted changes, so re-encoding it
+  // gives what is stored in the kv.
+  if (!o->exists || o->flushing_count.load()) {
+    return;
+  }
+  bufferlist bl;
+  o->encode_value(bl);
+  bl.reassign_to_mempool(mempool::mempool_bluestore_cache_encoded_onode);
+  auto e = new EncodedOnode(this, o->oid, std::move(bl));
+  auto r = encoded_map.emplace(o->oid, e);
+  if (!r.second) {
+    cache->_rm_encoded(r.first->second);
+    delete r.first->second;
+    r.first->second = e;
+  }
+  cache->_add_encoded(e);
+  ldout(cache->cct, 20) << __func__ << " " << o->oid << " "
+			<< e->bl.length() << " bytes" << dendl;
+}
+
+void BlueStore::OnodeSpace::_drop_encoded(const ghobject_t& oid)
+{
+  auto p = encoded_map.find(oid);
+  if (p == encoded_map.end()) {
+    return;
+  }
+  cache->_rm_encoded(p->second);
+  delete p->second;
+  encoded_map.erase(p);
+}
+
+bool BlueStore::OnodeSpace::lookup_encoded(const ghobject_t& oid,
+					   bufferlist *v)
+{
+  {
+    std::lock_guard l(cache->lock);
+    auto p = encoded_map.find(oid);
+    if (p == encoded_map.end()) {
+      return false;
+    }
+    EncodedOnode *e = p->second;
+    cache->_rm_encoded(e);
+    encoded_map.erase(p);
+    v->claim_append(e->bl);
+    delete e;
+  }
+  ldout(cache->cct, 30) << __func__ << " " << oid << " hit" << dendl;
+  cache->logger->inc(l_bluestore_encoded_onode_hits);
+  return true;
+}
+
 BlueStore::OnodeRef BlueStore::OnodeSpace::lookup(const ghobject_t& oid)
 {
   ldout(cache->cct, 30) << __func__ << dendl;
@@ -1892,11 +2232,23 @@ BlueStore::OnodeRef BlueStore::OnodeSpace::lookup(const ghobject_t& oid)
 void BlueStore::OnodeSpace::clear()
 {
   std::lock_guard l(cache->lock);
-  ldout(cache->cct, 10) << __func__ << " " << onode_map.size()<< dendl;
+  ldout(cache->cct, 10) << __func__ << " " << onode_map.size()
+			<< " encoded " << encoded_map.size() << dendl;
   for (auto &p : onode_map) {
     cache->_rm(p.second.get());
   }
   onode_map.clear();
+  for (auto &p : encoded_map) {
+    cache->_rm_encoded(p.second);
+    delete p.second;
+  }
+  encoded_map.clear();
+}
+
+bool BlueStore::OnodeSpace::contains(const ghobject_t& oid)
+{
+  std::lock_guard l(cache->lock);
+  return onode_map.count(oid);
 }
 
 bool BlueStore::OnodeSpace::empty()
@@ -1915,6 +2267,8 @@ void BlueStore::OnodeSpace::rename(
   ldout(cache->cct, 30) << __func__ << " " << old_oid << " -> " << new_oid
 			<< dendl;
   ceph::unordered_map<ghobject_t,OnodeRef>::iterator po, pn;
+  _drop_encoded(old_oid);
+  _drop_encoded(new_oid);
   po = onode_map.find(old_oid);
   pn = onode_map.find(new_oid);
   ceph_assert(po != pn);
@@ -3197,25 +3551,51 @@ void BlueStore::ExtentMap::fault_range(
 
   ceph_assert(last >= start);
   string key;
+  // the shards missing from the range are read in one batch
+  map<int, string> shard_keys;
+  for (auto i = start; i <= last; ++i) {
+    ceph_assert((size_t)i < shards.size());
+    if (!shards[i].loaded) {
+      generate_extent_shard_key_and_apply(
+	onode->key, shards[i].shard_info->offset, &key,
+        [&](const string& final_key) {
+	  shard_keys.emplace(i, final_key);
+        }
+      );
+    }
+  }
+  map<string, bufferlist> shard_values;
+  if (shard_keys.size() > 1) {
+    set<string> keys;
+    for (auto& [i, k] : shard_keys) {
+      keys.insert(k);
+    }
+    db->get(PREFIX_OBJ, keys, &shard_values);
+  }
   while (start <= last) {
-    ceph_assert((size_t)start < shards.size());
     auto p = &shards[start];
     if (!p->loaded) {
       dout(30) << __func__ << " opening shard 0x" << std::hex
 	       << p->shard_info->offset << std::dec << dendl;
       bufferlist v;
-      generate_extent_shard_key_and_apply(
-	onode->key, p->shard_info->offset, &key,
-        [&](const string& final_key) {
-          int r = db->get(PREFIX_OBJ, final_key, &v);
-          if (r < 0) {
-	    derr << __func__ << " missing shard 0x" << std::hex
-		 << p->shard_info->offset << std::dec << " for " << onode->oid
-		 << dendl;
-	    ceph_assert(r >= 0);
-          }
-        }
-      );
+      const string& final_key = shard_keys[start];
+      int r = 0;
+      if (shard_keys.size() > 1) {
+	auto q = shard_values.find(final_key);
+	if (q == shard_values.end()) {
+	  r = -ENOENT;
+	} else {
+	  v = std::move(q->second);
+	}
+      } else {
+	r = db->get(PREFIX_OBJ, final_key, &v);
+      }
+      if (r < 0) {
+	derr << __func__ << " missing shard 0x" << std::hex
+	     << p->shard_info->offset << std::dec << " for " << onode->oid
+	     << dendl;
+	ceph_assert(r >= 0);
+      }
       p->extents = decode_some(v);
       p->loaded = true;
       dout(20) << __func__ << " open shard 0x" << std::hex
@@ -3599,6 +3979,42 @@ BlueStore::Onode* BlueStore::Onode::decode(
   return on;
 }
 
+void BlueStore::Onode::encode_value(bufferlist& bl,
+				    unsigned *onode_part,
+				    unsigned *blob_part,
+				    unsigned *extent_part)
+{
+  // bound encode
+  size_t bound = 0;
+  denc(onode, bound);
+  extent_map.bound_encode_spanning_blobs(bound);
+  if (onode.extent_map_shards.empty()) {
+    denc(extent_map.inline_bl, bound);
+  }
+
+  // encode
+  unsigned o_part, b_part;
+  {
+    auto p = bl.get_contiguous_appender(bound, true);
+    denc(onode, p);
+    o_part = p.get_logical_offset();
+    extent_map.encode_spanning_blobs(p);
+    b_part = p.get_logical_offset() - o_part;
+    if (onode.extent_map_shards.empty()) {
+      denc(extent_map.inline_bl, p);
+    }
+    if (extent_part) {
+      *extent_part = p.get_logical_offset() - o_part - b_part;
+    }
+  }
+  if (onode_part) {
+    *onode_part = o_part;
+  }
+  if (blob_part) {
+    *blob_part = b_part;
+  }
+}
+
 void BlueStore::Onode::flush()
 {
   if (flushing_count.load()) {
@@ -3874,6 +4290,27 @@ void BlueStore::Collection::flush_all_but_last()
   osr->flush_all_but_last();
 }
 
+bool BlueStore::Collection::note_listed(const std::vector<ghobject_t>& ls)
+{
+  uint64_t min_accessed = store->cct->_conf->bluestore_onode_prefetch_min_accessed;
+  if (min_accessed == 0) {
+    return false;
+  }
+  std::lock_guard l(listed_lock);
+  bool prefetch = listed_accessed >= min_accessed;
+  listed_accessed = 0;
+  if (ls.empty()) {
+    listed = false;
+    return false;
+  }
+  // legacy listings are not in ghobject_t order
+  auto [first, last] = std::minmax_element(ls.begin(), ls.end());
+  listed_first = *first;
+  listed_last = *last;
+  listed = true;
+  return prefetch;
+}
+
 void BlueStore::Collection::open_shared_blob(uint64_t sbid, BlobRef b)
 {
   ceph_assert(!b->shared_blob);
@@ -3974,6 +4411,16 @@ BlueStore::OnodeRef BlueStore::Collection::get_onode(
     }
   }
 
+  if (listed && !create) {
+    std::lock_guard l(listed_lock);
+    if (listed && oid >= listed_first && oid <= listed_last &&
+	++listed_accessed >= store->cct->_conf->bluestore_onode_prefetch_min_accessed) {
+      // enough to prefetch the next listing, stop counting
+      listed = false;
+    }
+  }
+
+  store->mempool_thread.meta_cache->note_access(oid);
   OnodeRef o = onode_map.lookup(oid);
   if (o)
     return o;
@@ -3988,7 +4435,11 @@ BlueStore::OnodeRef BlueStore::Collection::get_onode(
   int r = -ENOENT;
   Onode *on;
   if (!is_createop) {
-    r = store->db->get(PREFIX_OBJ, key.c_str(), key.size(), &v);
+    if (onode_map.lookup_encoded(oid, &v)) {
+      r = 0;
+    } else {
+      r = store->db->get(PREFIX_OBJ, key.c_str(), key.size(), &v);
+    }
     ldout(store->cct, 20) << " r " << r << " v.len " << v.length() << dendl;
   }
   if (v.length() == 0) {
@@ -4087,6 +4538,22 @@ void BlueStore::Collection::split_cache(
       }
     }
   }
+
+  // encoded onodes go along with the objects they describe
+  auto q = onode_map.encoded_map.begin();
+  while (q != onode_map.encoded_map.end()) {
+    EncodedOnode *e = q->second;
+    if (!e->oid.match(destbits, destpg.pgid.ps())) {
+      ++q;
+      continue;
+    }
+    q = onode_map.encoded_map.erase(q);
+    ocache->_rm_encoded(e);
+    e->space = &dest->onode_map;
+    dest->onode_map.encoded_map[e->oid] = e;
+    ocache_dest->_add_encoded(e);
+  }
+  ocache_dest->_trim_encoded();
   dest->cache->_trim();
 }
 
@@ -4129,6 +4596,7 @@ void *BlueStore::MempoolThread::entry()
     if (binned_kv_onode_cache != nullptr) {
       pcm->insert("kv_onode", binned_kv_onode_cache, true);
     }
+    pcm->set_hit_gain_balance(store->cache_autotune_hit_gain);
   }
 
   utime_t next_balance = ceph_clock_now();
@@ -4268,15 +4736,24 @@ void BlueStore::MempoolThread::_resize_shards(bool interval_stats)
                    << " data_used: " << data_used << dendl;
   }
 
+  double encoded_ratio = store->cct->_conf.get_val<double>(
+    "bluestore_onode_cache_encoded_ratio");
+  double shard_meta_alloc = meta_alloc / (double) onode_shards;
+  double bytes_per_onode = meta_cache->get_bytes_per_onode();
+  meta_cache->bytes_per_onode = bytes_per_onode;
   uint64_t max_shard_onodes = static_cast<uint64_t>(
-      (meta_alloc / (double) onode_shards) / meta_cache->get_bytes_per_onode());
+      shard_meta_alloc * (1.0 - encoded_ratio) / bytes_per_onode);
+  uint64_t max_shard_encoded = static_cast<uint64_t>(
+      shard_meta_alloc * encoded_ratio);
   uint64_t max_shard_buffer = static_cast<uint64_t>(data_alloc / buffer_shards);
 
   dout(30) << __func__ << " max_shard_onodes: " << max_shard_onodes
+                 << " max_shard_encoded: " << max_shard_encoded
                  << " max_shard_buffer: " << max_shard_buffer << dendl;
 
   for (auto i : store->onode_cache_shards) {
     i->set_max(max_shard_onodes);
+    i->set_encoded_max_bytes(max_shard_encoded);
   }
   for (auto i : store->buffer_cache_shards) {
     i->set_max(max_shard_buffer);
@@ -4496,7 +4973,8 @@ BlueStore::BlueStore(CephContext *cct,
   uint64_t _min_alloc_size)
   : ObjectStore(cct, path),
     throttle(cct),
-    finisher(cct, "commit_finisher", "cfin"),
+    finisher(cct, "commit_finisher", "cfin",
+	     cct->_conf->bluestore_finisher_shards),
     kv_sync_thread(this),
     kv_finalize_thread(this),
 #ifdef HAVE_LIBZBD
@@ -4698,6 +5176,65 @@ void BlueStore::_set_compression()
 	   << dendl;
 }
 
+Compressor::DictionaryRef BlueStore::_load_compression_dicts(
+  const pool_opts_t& opts)
+{
+  string val;
+  if (!opts.get(pool_opts_t::COMPRESSION_DICTIONARY, &val)) {
+    return nullptr;
+  }
+  // a comma separated list of base64 encoded zstd dictionaries, the
+  // first one is for new writes
+  Compressor::DictionaryRef first;
+  CompressorRef zstd;
+  std::lock_guard l(compression_dicts_lock);
+  for (auto& text : get_str_vec(val, ",")) {
+    Compressor::DictionaryRef d;
+    auto p = compression_dicts_by_text.find(text);
+    if (p != compression_dicts_by_text.end()) {
+      d = p->second;
+    } else {
+      if (!zstd) {
+	zstd = Compressor::create(cct, "zstd");
+	if (!zstd) {
+	  derr << __func__ << " unable to load zstd for compression dictionaries"
+	       << dendl;
+	  return nullptr;
+	}
+      }
+      bufferlist in, raw;
+      in.append(text);
+      try {
+	raw.decode_base64(in);
+	d = zstd->load_dictionary(raw);
+      } catch (const buffer::error&) {
+      }
+      if (!d) {
+	derr << __func__ << " ignoring invalid compression dictionary" << dendl;
+	continue;
+      }
+      dout(10) << __func__ << " loaded compression dictionary " << d->get_id()
+	       << " (" << raw.length() << " bytes)" << dendl;
+      compression_dicts_by_text[text] = d;
+      compression_dicts[d->get_id()] = d;
+    }
+    if (!first) {
+      first = d;
+    }
+  }
+  return first;
+}
+
+Compressor::DictionaryRef BlueStore::_get_compression_dict(uint32_t id)
+{
+  std::lock_guard l(compression_dicts_lock);
+  auto p = compression_dicts.find(id);
+  if (p == compression_dicts.end()) {
+    return nullptr;
+  }
+  return p->second;
+}
+
 void BlueStore::_set_csum()
 {
   csum_type = Checksummer::CSUM_NONE;
@@ -4761,6 +5298,8 @@ int BlueStore::_set_cache_sizes()
 {
   ceph_assert(bdev);
   cache_autotune = cct->_conf.get_val<bool>("bluestore_cache_autotune");
+  cache_autotune_hit_gain =
+      cct->_conf.get_val<bool>("bluestore_cache_autotune_hit_gain");
   cache_autotune_interval =
       cct->_conf.get_val<double>("bluestore_cache_autotune_interval");
   osd_memory_target = cct->_conf.get_val<Option::size_t>("osd_memory_target");
@@ -4862,6 +5401,8 @@ void BlueStore::_init_logger()
 {
   PerfCountersBuilder b(cct, "bluestore",
                         l_bluestore_first, l_bluestore_last);
+  // updated from every op shard thread
+  b.set_sharded(true);
   b.add_time_avg(l_bluestore_kv_flush_lat, "kv_flush_lat",
 		 "Average kv_thread flush latency",
 		 "fl_l", PerfCountersBuilder::PRIO_INTERESTING);
@@ -4922,12 +5463,24 @@ void BlueStore::_init_logger()
     "Sum for beneficial compress ops");
   b.add_u64_counter(l_bluestore_compress_rejected_count, "compress_rejected_count",
     "Sum for compress ops rejected due to low net gain of space");
+  b.add_u64_counter(l_bluestore_compress_skipped_count, "compress_skipped_count",
+    "Sum for blobs not compressed as their data looked incompressible");
   b.add_u64_counter(l_bluestore_write_pad_bytes, "write_pad_bytes",
 		    "Sum for write-op padded bytes", NULL, 0, unit_t(UNIT_BYTES));
   b.add_u64_counter(l_bluestore_deferred_write_ops, "deferred_write_ops",
 		    "Sum for deferred write op");
   b.add_u64_counter(l_bluestore_deferred_write_bytes, "deferred_write_bytes",
 		    "Sum for deferred write bytes", "def", 0, unit_t(UNIT_BYTES));
+  b.add_u64_avg(l_bluestore_deferred_aggregate_batches,
+		"deferred_aggregate_batches",
+		"Average number of deferred batches per aggregated submit");
+  b.add_u64_avg(l_bluestore_deferred_aggregate_extents,
+		"deferred_aggregate_extents",
+		"Average number of deferred extents per aggregated submit");
+  b.add_u64_avg(l_bluestore_deferred_aggregate_bytes,
+		"deferred_aggregate_bytes",
+		"Average bytes per aggregated deferred submit",
+		NULL, 0, unit_t(UNIT_BYTES));
   b.add_u64_counter(l_bluestore_write_penalty_read_ops, "write_penalty_read_ops",
 		    "Sum for write penalty read ops");
   b.add_u64(l_bluestore_allocated, "bluestore_allocated",
@@ -4947,10 +5500,20 @@ void BlueStore::_init_logger()
 	    "Number of onodes in cache");
   b.add_u64(l_bluestore_pinned_onodes, "bluestore_pinned_onodes",
             "Number of pinned onodes in cache");
+  b.add_u64(l_bluestore_encoded_onodes, "bluestore_encoded_onodes",
+	    "Number of trimmed onodes kept encoded in cache");
+  b.add_u64(l_bluestore_encoded_onode_bytes, "bluestore_encoded_onode_bytes",
+	    "Bytes used by trimmed onodes kept encoded in cache",
+	    NULL, 0, unit_t(UNIT_BYTES));
+  b.add_u64_counter(l_bluestore_encoded_onode_hits,
+		    "bluestore_encoded_onode_hits",
+		    "Sum for onode-lookups served from encoded onodes");
   b.add_u64_counter(l_bluestore_onode_hits, "bluestore_onode_hits",
 		    "Sum for onode-lookups hit in the cache");
   b.add_u64_counter(l_bluestore_onode_misses, "bluestore_onode_misses",
 		    "Sum for onode-lookups missed in the cache");
+  b.add_u64_counter(l_bluestore_onode_prefetched, "bluestore_onode_prefetched",
+		    "Sum for onodes prefetched by collection listings");
   b.add_u64_counter(l_bluestore_onode_shard_hits, "bluestore_onode_shard_hits",
 		    "Sum for onode-shard lookups hit in the cache");
   b.add_u64_counter(l_bluestore_onode_shard_misses,
@@ -4968,6 +5531,14 @@ void BlueStore::_init_logger()
 	    "Sum for bytes of read hit in the cache", NULL, 0, unit_t(UNIT_BYTES));
   b.add_u64_counter(l_bluestore_buffer_miss_bytes, "bluestore_buffer_miss_bytes",
 	    "Sum for bytes of read missed in the cache", NULL, 0, unit_t(UNIT_BYTES));
+  b.add_u64_counter(l_bluestore_buffer_seq_hit_bytes,
+	    "bluestore_buffer_seq_hit_bytes",
+	    "Sum for bytes of sequential reads (scrub, recovery, backfill) "
+	    "hit in the cache", NULL, 0, unit_t(UNIT_BYTES));
+  b.add_u64_counter(l_bluestore_buffer_seq_miss_bytes,
+	    "bluestore_buffer_seq_miss_bytes",
+	    "Sum for bytes of sequential reads (scrub, recovery, backfill) "
+	    "missed in the cache", NULL, 0, unit_t(UNIT_BYTES));
 
   b.add_u64_counter(l_bluestore_write_big, "bluestore_write_big",
 		    "Large aligned writes into fresh blobs");
@@ -5302,6 +5873,20 @@ int BlueStore::_open_fm(KeyValueDB::Transaction t, bool read_only)
       bl.append(freelist_type);
       t->set(PREFIX_SUPER, "freelist_type", bl);
     }
+    if (cct->_conf->bluestore_allocation_from_file) {
+      if (bluefs && freelist_type == "bitmap") {
+	dout(1) << __func__ << " null freelist" << dendl;
+	null_freelist = true;
+	bufferlist bl;
+	t->set(PREFIX_SUPER, "null_freelist", bl);
+      } else {
+	derr << __func__ << " bluestore_allocation_from_file needs bluefs"
+	     << " and a bitmap freelist, ignored" << dendl;
+      }
+    }
+    if (null_freelist) {
+      fm->set_null_manager();
+    }
     // being able to allocate in units less than bdev block size 
     // seems to be a bad idea.
     ceph_assert(cct->_conf->bdev_block_size <= min_alloc_size);
@@ -5374,6 +5959,9 @@ int BlueStore::_open_fm(KeyValueDB::Transaction t, bool read_only)
       fm = NULL;
       return r;
     }
+    if (null_freelist) {
+      fm->set_null_manager();
+    }
   }
   // if space size tracked by free list manager is that higher than actual
   // dev size one can hit out-of-space allocation which will result
@@ -5441,6 +6029,22 @@ int BlueStore::_create_alloc()
       << dendl;
     return -EINVAL;
   }
+  if (auto streams = cct->_conf.get_val<uint64_t>("bluestore_allocator_streams");
+      streams > 0 && !bdev->is_smr()) {
+    shared_alloc.a = new StreamAllocator(
+      cct, shared_alloc.a, streams,
+      cct->_conf.get_val<Option::size_t>("bluestore_allocator_stream_region"),
+      cct->_conf.get_val<Option::size_t>("bluestore_allocator_stream_max_alloc"),
+      cct->_conf.get_val<double>("bluestore_allocator_stream_max_age"));
+  }
+  if (auto shards = cct->_conf.get_val<uint64_t>("bluestore_allocator_cache_shards");
+      shards > 0 && !bdev->is_smr()) {
+    shared_alloc.a = new CachedAllocator(
+      cct, shared_alloc.a, shards,
+      cct->_conf.get_val<Option::size_t>("bluestore_allocator_cache_size"),
+      cct->_conf.get_val<Option::size_t>("bluestore_allocator_cache_max_alloc"),
+      cct->_conf.get_val<double>("bluestore_allocator_cache_max_age"));
+  }
   return 0;
 }
 
@@ -5466,16 +6070,29 @@ int BlueStore::_init_alloc()
   
   uint64_t num = 0, bytes = 0;
 
-  dout(1) << __func__ << " opening allocation metadata" << dendl;
-  // initialize from freelist
-  fm->enumerate_reset();
-  uint64_t offset, length;
-  while (fm->enumerate_next(db, &offset, &length)) {
-    shared_alloc.a->init_add_free(offset, length);
-    ++num;
-    bytes += length;
+  if (fm->is_null_manager()) {
+    r = _restore_allocator_from_file(&num, &bytes);
+    if (r < 0) {
+      dout(1) << __func__ << " no saved allocator state: " << cpp_strerror(r)
+	      << dendl;
+      r = _restore_allocator_from_onodes(&num, &bytes);
+      if (r < 0) {
+	_close_alloc();
+	return r;
+      }
+    }
+  } else {
+    dout(1) << __func__ << " opening allocation metadata" << dendl;
+    // initialize from freelist
+    fm->enumerate_reset();
+    uint64_t offset, length;
+    while (fm->enumerate_next(db, &offset, &length)) {
+      shared_alloc.a->init_add_free(offset, length);
+      ++num;
+      bytes += length;
+    }
+    fm->enumerate_reset();
   }
-  fm->enumerate_reset();
 
   dout(1) << __func__
           << " loaded " << byte_u_t(bytes) << " in " << num << " extents"
@@ -5501,15 +6118,277 @@ void BlueStore::_close_alloc()
   shared_alloc.reset();
 }
 
-int BlueStore::_open_fsid(bool create)
+// With a null freelist the allocator state lives in this BlueFS file
+// from a clean umount to the next mount, which removes it.
+static const string ALLOCATOR_DIR = "bluestore";
+static const string ALLOCATOR_FILE = "allocator";
+
+int BlueStore::_restore_allocator_from_file(uint64_t* num, uint64_t* bytes)
 {
-  ceph_assert(fsid_fd < 0);
-  int flags = O_RDWR|O_CLOEXEC;
-  if (create)
-    flags |= O_CREAT;
-  fsid_fd = ::openat(path_fd, "fsid", flags, 0644);
-  if (fsid_fd < 0) {
-    int err = -errno;
+  ceph_assert(bluefs);
+  uint64_t size;
+  utime_t mtime;
+  int r = bluefs->stat(ALLOCATOR_DIR, ALLOCATOR_FILE, &size, &mtime);
+  if (r < 0) {
+    return r;
+  }
+  BlueFS::FileReader *h;
+  r = bluefs->open_for_read(ALLOCATOR_DIR, ALLOCATOR_FILE, &h);
+  if (r < 0) {
+    return r;
+  }
+  bufferlist bl;
+  int64_t got = bluefs->read(h, 0, size, &bl, nullptr);
+  delete h;
+  if (got != (int64_t)size || size <= sizeof(uint32_t)) {
+    derr << __func__ << " short read of " << got << " of " << size << dendl;
+    return -EIO;
+  }
+
+  bufferlist payload;
+  payload.substr_of(bl, 0, size - sizeof(uint32_t));
+  uint32_t crc;
+  auto c = bl.cbegin();
+  c.seek(payload.length());
+  decode(crc, c);
+  if (crc != payload.crc32c(-1)) {
+    derr << __func__ << " bad crc" << dendl;
+    return -EIO;
+  }
+  uint64_t capacity, alloc_size;
+  interval_set<uint64_t> free;
+  try {
+    auto p = payload.cbegin();
+    DECODE_START(1, p);
+    decode(capacity, p);
+    decode(alloc_size, p);
+    decode(free, p);
+    DECODE_FINISH(p);
+  } catch (ceph::buffer::error& e) {
+    derr << __func__ << " failed to decode: " << e.what() << dendl;
+    return -EIO;
+  }
+  if (capacity != fm->get_size() || alloc_size != fm->get_alloc_size()) {
+    // e.g., expanded since
+    dout(1) << __func__ << " saved for 0x" << std::hex << capacity
+	    << "/0x" << alloc_size << ", not 0x" << fm->get_size()
+	    << "/0x" << fm->get_alloc_size() << std::dec << dendl;
+    return -ESTALE;
+  }
+  for (auto p = free.begin(); p != free.end(); ++p) {
+    shared_alloc.a->init_add_free(p.get_start(), p.get_len());
+    ++*num;
+    *bytes += p.get_len();
+  }
+  return 0;
+}
+
+int BlueStore::_restore_allocator_from_onodes(uint64_t* num, uint64_t* bytes)
+{
+  // what the freelist would hold: everything but the space that the
+  // onodes and pending deferred releases reference.  bluefs takes its
+  // own space out at mount, as it does with the freelist.
+  auto alloc_size = fm->get_alloc_size();
+  interval_set<uint64_t> used;
+  auto add = [&](uint64_t offset, uint64_t length) {
+    uint64_t start = p2align(offset, alloc_size);
+    used.union_insert(start, p2roundup(offset + length, alloc_size) - start);
+  };
+  auto add_blob = [&](const bluestore_blob_t& b) {
+    for (auto& e : b.get_extents()) {
+      if (e.is_valid()) {
+	add(e.offset, e.length);
+      }
+    }
+  };
+  // the blobs of an encoded extent map, see ExtentMap::decode_some()
+  auto add_extent_map = [&](bufferptr::const_iterator& p) {
+    __u8 struct_v;
+    denc(struct_v, p);
+    ceph_assert(struct_v == 1 || struct_v == 2);
+    uint32_t n;
+    denc_varint(n, p);
+    while (!p.end()) {
+      uint64_t blobid, v;
+      denc_varint(blobid, p);
+      if ((blobid & BLOBID_FLAG_CONTIGUOUS) == 0) {
+	denc_varint_lowz(v, p);
+      }
+      if ((blobid & BLOBID_FLAG_ZEROOFFSET) == 0) {
+	denc_varint_lowz(v, p);
+      }
+      if ((blobid & BLOBID_FLAG_SAMELENGTH) == 0) {
+	denc_varint_lowz(v, p);
+      }
+      if ((blobid & BLOBID_FLAG_SPANNING) == 0 &&
+	  (blobid >> BLOBID_SHIFT_BITS) == 0) {
+	bluestore_blob_t b;
+	denc(b, p, struct_v);
+	if (b.is_shared()) {
+	  denc(v, p);
+	}
+	add_blob(b);
+      }
+    }
+  };
+
+  dout(1) << __func__ << " rebuilding allocation metadata from onodes"
+	  << dendl;
+  auto start = mono_clock::now();
+  add(0, _get_ondisk_reserved());
+  uint64_t onodes = 0;
+  try {
+    auto it = db->get_iterator(PREFIX_OBJ, KeyValueDB::ITERATOR_NOCACHE);
+    for (it->lower_bound(string()); it->valid(); it->next()) {
+      bufferlist v = it->value();
+      if (v.get_num_buffers() > 1) {
+	v.rebuild();
+      }
+      auto p = v.front().begin_deep();
+      if (is_extent_shard_key(it->key())) {
+	add_extent_map(p);
+	continue;
+      }
+      ++onodes;
+      bluestore_onode_t onode;
+      onode.decode(p);
+      // spanning blobs, see ExtentMap::decode_spanning_blobs()
+      __u8 struct_v;
+      denc(struct_v, p);
+      ceph_assert(struct_v == 1 || struct_v == 2);
+      unsigned n;
+      denc_varint(n, p);
+      while (n--) {
+	int16_t id;
+	uint64_t sbid;
+	denc_varint(id, p);
+	bluestore_blob_t b;
+	denc(b, p, struct_v);
+	if (b.is_shared()) {
+	  denc(sbid, p);
+	}
+	if (struct_v > 1) {
+	  bluestore_blob_use_tracker_t used_in_blob;
+	  used_in_blob.decode(p);
+	} else {
+	  bluestore_extent_ref_map_t legacy_ref_map;
+	  legacy_ref_map.decode(p);
+	}
+	add_blob(b);
+      }
+      if (onode.extent_map_shards.empty()) {
+	bufferlist inline_bl;
+	denc(inline_bl, p);
+	if (inline_bl.length()) {
+	  auto q = inline_bl.front().begin_deep();
+	  add_extent_map(q);
+	}
+      }
+    }
+    it = db->get_iterator(PREFIX_DEFERRED, KeyValueDB::ITERATOR_NOCACHE);
+    for (it->lower_bound(string()); it->valid(); it->next()) {
+      bufferlist bl = it->value();
+      auto p = bl.cbegin();
+      bluestore_deferred_transaction_t wt;
+      decode(wt, p);
+      // released once replayed
+      for (auto e = wt.released.begin(); e != wt.released.end(); ++e) {
+	add(e.get_start(), e.get_len());
+      }
+    }
+  } catch (ceph::buffer::error& e) {
+    derr << __func__ << " failed to decode: " << e.what() << dendl;
+    return -EIO;
+  }
+
+  uint64_t pos = 0, size = fm->get_size();
+  auto add_free = [&](uint64_t end) {
+    if (end > pos) {
+      shared_alloc.a->init_add_free(pos, end - pos);
+      ++*num;
+      *bytes += end - pos;
+    }
+  };
+  for (auto p = used.begin(); p != used.end() && p.get_start() < size; ++p) {
+    add_free(p.get_start());
+    pos = p.get_start() + p.get_len();
+  }
+  add_free(size);
+  dout(1) << __func__ << " " << onodes << " onodes in "
+	  << ceph::to_seconds<double>(mono_clock::now() - start) << "s" << dendl;
+  return 0;
+}
+
+int BlueStore::_store_allocator_to_file()
+{
+  ceph_assert(bluefs);
+  ceph_assert(fm->is_null_manager());
+  // space still being discarded, or pending release by bluefs, is
+  // neither free nor ours: flush it back first
+  bdev->discard_drain();
+  bluefs->sync_metadata(false);
+
+  // save all but the space used by bluestore.  whatever bluefs
+  // allocates or releases while writing this only moves space between
+  // the two sets.
+  interval_set<uint64_t> free;
+  bluefs->get_block_extents(bluefs_layout.shared_bdev, &free);
+  shared_alloc.a->dump([&](uint64_t offset, uint64_t length) {
+    free.union_insert(offset, length);
+  });
+
+  bufferlist bl;
+  ENCODE_START(1, 1, bl);
+  encode(fm->get_size(), bl);
+  encode(fm->get_alloc_size(), bl);
+  encode(free, bl);
+  ENCODE_FINISH(bl);
+  uint32_t crc = bl.crc32c(-1);
+  encode(crc, bl);
+
+  if (!bluefs->dir_exists(ALLOCATOR_DIR)) {
+    bluefs->mkdir(ALLOCATOR_DIR);
+  }
+  BlueFS::FileWriter *h;
+  int r = bluefs->open_for_write(ALLOCATOR_DIR, ALLOCATOR_FILE, &h, false);
+  if (r < 0) {
+    derr << __func__ << " failed to create: " << cpp_strerror(r) << dendl;
+    return r;
+  }
+  bluefs->append_try_flush(h, bl.c_str(), bl.length());
+  r = bluefs->fsync(h);
+  bluefs->close_writer(h);
+  if (r < 0) {
+    derr << __func__ << " failed to sync: " << cpp_strerror(r) << dendl;
+    _remove_allocator_file();
+    return r;
+  }
+  dout(1) << __func__ << " saved 0x" << std::hex << free.size() << std::dec
+	  << " in " << free.num_intervals() << " extents" << dendl;
+  return 0;
+}
+
+void BlueStore::_remove_allocator_file()
+{
+  ceph_assert(bluefs);
+  int r = bluefs->unlink(ALLOCATOR_DIR, ALLOCATOR_FILE);
+  if (r == -ENOENT) {
+    return;
+  }
+  ceph_assert(r == 0);
+  // once we allocate, a crash must not find it back
+  bluefs->sync_metadata(false);
+}
+
+int BlueStore::_open_fsid(bool create)
+{
+  ceph_assert(fsid_fd < 0);
+  int flags = O_RDWR|O_CLOEXEC;
+  if (create)
+    flags |= O_CREAT;
+  fsid_fd = ::openat(path_fd, "fsid", flags, 0644);
+  if (fsid_fd < 0) {
+    int err = -errno;
     derr << __func__ << " " << cpp_strerror(err) << dendl;
     return err;
   }
@@ -5926,6 +6805,10 @@ int BlueStore::_open_db_and_around(bool read_only, bool to_repair)
   if (r < 0) {
     goto out_alloc;
   }
+  if (!read_only && fm->is_null_manager()) {
+    // stale as soon as we allocate or release
+    _remove_allocator_file();
+  }
   return 0;
 
 out_alloc:
@@ -6254,6 +7137,79 @@ void BlueStore::_fsck_collections(int64_t* errors)
   }
 }
 
+void BlueStore::_save_hot_onodes()
+{
+  uint64_t max = cct->_conf->bluestore_onode_warmup_max;
+  KeyValueDB::Transaction t = db->get_transaction();
+  if (max == 0 || onode_cache_shards.empty()) {
+    t->rmkey(PREFIX_SUPER, "hot_onodes");
+    db->submit_transaction_sync(t);
+    return;
+  }
+  // the most recently used onodes of every shard, alike in number
+  std::vector<std::pair<coll_t, ghobject_t>> hot;
+  size_t per_shard = std::max<size_t>(1, max / onode_cache_shards.size());
+  for (auto s : onode_cache_shards) {
+    std::lock_guard l(s->lock);
+    s->_get_hot(per_shard, &hot);
+  }
+  dout(10) << __func__ << " " << hot.size() << " onodes" << dendl;
+  bufferlist bl;
+  encode(hot, bl);
+  t->set(PREFIX_SUPER, "hot_onodes", bl);
+  db->submit_transaction_sync(t);
+}
+
+void BlueStore::_onode_warmup_start()
+{
+  if (cct->_conf->bluestore_onode_warmup_max == 0) {
+    return;
+  }
+  bufferlist bl;
+  db->get(PREFIX_SUPER, "hot_onodes", &bl);
+  if (!bl.length()) {
+    return;
+  }
+  std::vector<std::pair<coll_t, ghobject_t>> hot;
+  try {
+    auto p = bl.cbegin();
+    decode(hot, p);
+  } catch (ceph::buffer::error& e) {
+    derr << __func__ << " failed to decode hot onodes" << dendl;
+    return;
+  }
+  dout(10) << __func__ << " loading " << hot.size() << " onodes" << dendl;
+  onode_warmup_stop = false;
+  onode_warmup_thread = make_named_thread(
+    "bstore_warmup",
+    [this, hot = std::move(hot)] {
+      size_t loaded = 0;
+      for (auto& [cid, oid] : hot) {
+	if (onode_warmup_stop) {
+	  break;
+	}
+	CollectionRef c = _get_collection(cid);
+	if (!c) {
+	  continue;
+	}
+	std::shared_lock l(c->lock);
+	if (c->get_onode(oid, false)) {
+	  ++loaded;
+	}
+      }
+      dout(10) << "_onode_warmup loaded " << loaded << " of " << hot.size()
+	       << " onodes" << dendl;
+    });
+}
+
+void BlueStore::_onode_warmup_stop()
+{
+  if (onode_warmup_thread.joinable()) {
+    onode_warmup_stop = true;
+    onode_warmup_thread.join();
+  }
+}
+
 void BlueStore::_set_per_pool_omap()
 {
   per_pool_omap = OMAP_BULK;
@@ -7066,6 +8022,25 @@ int BlueStore::_mount()
     }
   }
 
+  // the onodes hot at the last umount are read back in the background
+  _onode_warmup_start();
+
+  {
+    auto trace_file = cct->_conf.get_val<std::string>("bluestore_trace_file");
+    if (!trace_file.empty()) {
+      txn_trace = std::make_unique<ceph::os::TransactionTraceWriter>();
+      int rt = txn_trace->open(trace_file);
+      if (rt < 0) {
+	derr << __func__ << " unable to open transaction trace " << trace_file
+	     << ": " << cpp_strerror(rt) << dendl;
+	txn_trace.reset();
+      } else {
+	dout(1) << __func__ << " tracing transactions to " << trace_file
+		<< dendl;
+      }
+    }
+  }
+
   mounted = true;
   return 0;
 
@@ -7090,8 +8065,14 @@ int BlueStore::umount()
 
   _osr_drain_all();
 
+  if (txn_trace) {
+    txn_trace->close();
+    txn_trace.reset();
+  }
+
   mounted = false;
   if (!_kv_only) {
+    _onode_warmup_stop();
     mempool_thread.shutdown();
 #ifdef HAVE_LIBZBD
     if (bdev->is_smr()) {
@@ -7101,10 +8082,14 @@ int BlueStore::umount()
 #endif
     dout(20) << __func__ << " stopping kv thread" << dendl;
     _kv_stop();
+    _save_hot_onodes();
     _shutdown_cache();
     dout(20) << __func__ << " closing" << dendl;
 
   }
+  if (fm->is_null_manager()) {
+    _store_allocator_to_file();
+  }
   _close_db_and_around(false);
 
   if (cct->_conf->bluestore_fsck_on_umount) {
@@ -7359,12 +8344,14 @@ BlueStore::OnodeRef BlueStore::fsck_check_objects_shallow(
   if (!o->extent_map.shards.empty()) {
     ++num_sharded_objects;
     if (depth != FSCK_SHALLOW) {
-      ceph_assert(expecting_shards);
       for (auto& s : o->extent_map.shards) {
         dout(20) << __func__ << "    shard " << *s.shard_info << dendl;
-        expecting_shards->push_back(string());
-        get_extent_shard_key(o->key, s.shard_info->offset,
-          &expecting_shards->back());
+        // not collected in multithreading mode
+        if (expecting_shards) {
+          expecting_shards->push_back(string());
+          get_extent_shard_key(o->key, s.shard_info->offset,
+            &expecting_shards->back());
+        }
         if (s.shard_info->offset >= o->onode.size) {
           derr << "fsck error: " << oid << " shard 0x" << std::hex
             << s.shard_info->offset << " past EOF at 0x" << o->onode.size
@@ -7487,6 +8474,11 @@ BlueStore::OnodeRef BlueStore::fsck_check_objects_shallow(
       }
     } else if (depth != FSCK_SHALLOW) {
       ceph_assert(used_blocks);
+      // the below lock is optional and provided in multithreading mode only
+      std::unique_lock<ceph::mutex> l;
+      if (ctx.used_lock) {
+        l = std::unique_lock(*ctx.used_lock);
+      }
       errors += _fsck_check_extents(c->cid, oid, blob.get_extents(),
         blob.is_compressed(),
         *used_blocks,
@@ -7524,6 +8516,10 @@ BlueStore::OnodeRef BlueStore::fsck_check_objects_shallow(
            << " zombie spanning blob(s) found, the first one: "
            << *first_broken << dendl;
       if(repairer) {
+        std::unique_lock<ceph::mutex> l;
+        if (ctx.used_lock) {
+          l = std::unique_lock(*ctx.used_lock);
+        }
         auto txn = repairer->fix_spanning_blobs(db);
 	_record_onode(o, txn);
       }
@@ -7539,10 +8535,10 @@ BlueStore::OnodeRef BlueStore::fsck_check_objects_shallow(
 
 #include "common/WorkQueue.h"
 
-class ShallowFSCKThreadPool : public ThreadPool
+class FSCKThreadPool : public ThreadPool
 {
 public:
-  ShallowFSCKThreadPool(CephContext* cct_, std::string nm, std::string tn, int n) :
+  FSCKThreadPool(CephContext* cct_, std::string nm, std::string tn, int n) :
     ThreadPool(cct_, nm, tn, n) {
   }
   void worker(ThreadPool::WorkThread* wt) override {
@@ -7588,11 +8584,18 @@ public:
 
     size_t batchCount;
     BlueStore* store = nullptr;
+    BlueStore::FSCKDepth depth;
 
     ceph::mutex* sb_info_lock = nullptr;
     BlueStore::sb_info_map_t* sb_info = nullptr;
     BlueStoreRepairer* repairer = nullptr;
 
+    // shared with the other threads, beyond shallow fsck only
+    BlueStore::mempool_dynamic_bitset* used_blocks = nullptr;
+    BlueStore::uint64_t_btree_t* used_omap_head = nullptr;
+    BlueStore::uint64_t_btree_t* used_nids = nullptr;
+    ceph::mutex* used_lock = nullptr;
+
     Batch* batches = nullptr;
     size_t last_batch_pos = 0;
     bool batch_acquired = false;
@@ -7600,16 +8603,22 @@ public:
     FSCKWorkQueue(std::string n,
                   size_t _batchCount,
                   BlueStore* _store,
-                  ceph::mutex* _sb_info_lock,
-                  BlueStore::sb_info_map_t& _sb_info,
-                  BlueStoreRepairer* _repairer) :
+                  BlueStore::FSCKDepth _depth,
+                  const BlueStore::FSCK_ObjectCtx& ctx) :
       WorkQueue_(n, ceph::timespan::zero(), ceph::timespan::zero()),
       batchCount(_batchCount),
       store(_store),
-      sb_info_lock(_sb_info_lock),
-      sb_info(&_sb_info),
-      repairer(_repairer)
+      depth(_depth),
+      sb_info_lock(ctx.sb_info_lock),
+      sb_info(&ctx.sb_info),
+      repairer(ctx.repairer)
     {
+      if (depth != BlueStore::FSCK_SHALLOW) {
+        used_blocks = ctx.used_blocks;
+        used_omap_head = ctx.used_omap_head;
+        used_nids = ctx.used_nids;
+        used_lock = ctx.used_lock;
+      }
       batches = new Batch[batchCount];
     }
     ~FSCKWorkQueue() {
@@ -7656,27 +8665,33 @@ public:
         batch->num_blobs,
         batch->num_sharded_objects,
         batch->num_spanning_blobs,
-        nullptr, // used_blocks
-        nullptr, //used_omap_head
+        used_blocks,
+        used_omap_head,
         sb_info_lock,
         *sb_info,
         batch->expected_store_statfs,
         batch->expected_pool_statfs,
         repairer);
+      ctx.used_nids = used_nids;
+      ctx.used_lock = used_lock;
 
       for (size_t i = 0; i < batch->entry_count; i++) {
         auto& entry = batch->entries[i];
 
-        store->fsck_check_objects_shallow(
-          BlueStore::FSCK_SHALLOW,
+        map<BlueStore::BlobRef, bluestore_blob_t::unused_t> referenced;
+        auto o = store->fsck_check_objects_shallow(
+          depth,
           entry.pool_id,
           entry.c,
           entry.oid,
           entry.key,
           entry.value,
           nullptr, // expecting_shards - this will need a protection if passed
-          nullptr, // referenced
+          depth == BlueStore::FSCK_SHALLOW ? nullptr : &referenced,
           ctx);
+        if (depth != BlueStore::FSCK_SHALLOW) {
+          store->fsck_check_objects_regular(depth, entry.c, o, referenced, ctx);
+        }
       }
       //std::cout << "processed " << batch << std::endl;
       batch->entry_count = 0;
@@ -7887,6 +8902,111 @@ void BlueStore::_fsck_check_object_omap(FSCKDepth depth,
   }
 }
 
+void BlueStore::fsck_check_objects_regular(
+  BlueStore::FSCKDepth depth,
+  BlueStore::CollectionRef& c,
+  BlueStore::OnodeRef& o,
+  const map<BlobRef, bluestore_blob_t::unused_t>& referenced,
+  const BlueStore::FSCK_ObjectCtx& ctx)
+{
+  auto& errors = ctx.errors;
+  auto& oid = o->oid;
+
+  if (o->onode.nid || o->onode.has_omap()) {
+    // the below lock is optional and provided in multithreading mode only
+    std::unique_lock<ceph::mutex> l;
+    if (ctx.used_lock) {
+      l = std::unique_lock(*ctx.used_lock);
+    }
+    if (o->onode.nid) {
+      if (o->onode.nid > nid_max) {
+        derr << "fsck error: " << oid << " nid " << o->onode.nid
+          << " > nid_max " << nid_max << dendl;
+        ++errors;
+      }
+      ceph_assert(ctx.used_nids);
+      if (ctx.used_nids->count(o->onode.nid)) {
+        derr << "fsck error: " << oid << " nid " << o->onode.nid
+          << " already in use" << dendl;
+        ++errors;
+        return; // go for next object
+      }
+      ctx.used_nids->insert(o->onode.nid);
+    }
+    // omap
+    if (o->onode.has_omap()) {
+      ceph_assert(ctx.used_omap_head);
+      if (ctx.used_omap_head->count(o->onode.nid)) {
+        derr << "fsck error: " << o->oid << " omap_head " << o->onode.nid
+             << " already in use" << dendl;
+        ++errors;
+      } else {
+        ctx.used_omap_head->insert(o->onode.nid);
+      }
+    } // if (o->onode.has_omap())
+  }
+  for (auto& i : referenced) {
+    dout(20) << __func__ << "  referenced 0x" << std::hex << i.second
+      << std::dec << " for " << *i.first << dendl;
+    const bluestore_blob_t& blob = i.first->get_blob();
+    if (i.second & blob.unused) {
+      derr << "fsck error: " << oid << " blob claims unused 0x"
+        << std::hex << blob.unused
+        << " but extents reference 0x" << i.second << std::dec
+        << " on blob " << *i.first << dendl;
+      ++errors;
+    }
+    if (blob.has_csum()) {
+      uint64_t blob_len = blob.get_logical_length();
+      uint64_t unused_chunk_size = blob_len / (sizeof(blob.unused) * 8);
+      unsigned csum_count = blob.get_csum_count();
+      unsigned csum_chunk_size = blob.get_csum_chunk_size();
+      for (unsigned p = 0; p < csum_count; ++p) {
+        unsigned pos = p * csum_chunk_size;
+        unsigned firstbit = pos / unused_chunk_size;    // [firstbit,lastbit]
+        unsigned lastbit = (pos + csum_chunk_size - 1) / unused_chunk_size;
+        unsigned mask = 1u << firstbit;
+        for (unsigned b = firstbit + 1; b <= lastbit; ++b) {
+          mask |= 1u << b;
+        }
+        if ((blob.unused & mask) == mask) {
+          // this csum chunk region is marked unused
+          if (blob.get_csum_item(p) != 0) {
+            derr << "fsck error: " << oid
+              << " blob claims csum chunk 0x" << std::hex << pos
+              << "~" << csum_chunk_size
+              << " is unused (mask 0x" << mask << " of unused 0x"
+              << blob.unused << ") but csum is non-zero 0x"
+              << blob.get_csum_item(p) << std::dec << " on blob "
+              << *i.first << dendl;
+            ++errors;
+          }
+        }
+      }
+    }
+  }
+  if (depth == FSCK_DEEP) {
+    bufferlist bl;
+    uint64_t max_read_block = cct->_conf->bluestore_fsck_read_bytes_cap;
+    uint64_t offset = 0;
+    do {
+      uint64_t l = std::min(uint64_t(o->onode.size - offset), max_read_block);
+      int r = _do_read(c.get(), o, offset, l, bl,
+        CEPH_OSD_OP_FLAG_FADVISE_NOCACHE);
+      if (r < 0) {
+        ++errors;
+        derr << "fsck error: " << oid << std::hex
+          << " error during read: "
+          << " " << offset << "~" << l
+          << " " << cpp_strerror(r) << std::dec
+          << dendl;
+        break;
+      }
+      offset += l;
+    } while (offset < o->onode.size);
+  } // deep
+}
+
 void BlueStore::_fsck_check_objects(FSCKDepth depth,
   BlueStore::FSCK_ObjectCtx& ctx)
 {
@@ -7896,27 +9016,35 @@ void BlueStore::_fsck_check_objects(FSCKDepth depth,
   auto repairer = ctx.repairer;
 
   uint64_t_btree_t used_nids;
+  ceph::mutex used_lock = ceph::make_mutex("BlueStore::fsck::used_lock");
 
   size_t processed_myself = 0;
 
   auto it = db->get_iterator(PREFIX_OBJ, KeyValueDB::ITERATOR_NOCACHE);
   mempool::bluestore_fsck::list<string> expecting_shards;
+  string last_onode_key;
   if (it) {
-    const size_t thread_count = cct->_conf->bluestore_fsck_quick_fix_threads;
-    typedef ShallowFSCKThreadPool::FSCKWorkQueue<256> WQ;
+    const size_t thread_count = depth == FSCK_SHALLOW ?
+      cct->_conf->bluestore_fsck_quick_fix_threads :
+      cct->_conf->bluestore_fsck_threads;
+    ctx.used_nids = &used_nids;
+    if (thread_count > 0) {
+      // we check objects along with the pool threads
+      ctx.used_lock = &used_lock;
+    }
+    typedef FSCKThreadPool::FSCKWorkQueue<256> WQ;
     std::unique_ptr<WQ> wq(
       new WQ(
         "FSCKWorkQueue",
         (thread_count ? : 1) * 32,
         this,
-        sb_info_lock,
-        sb_info,
-        repairer));
+        depth,
+        ctx));
 
-    ShallowFSCKThreadPool thread_pool(cct, "ShallowFSCKThreadPool", "ShallowFSCK", thread_count);
+    FSCKThreadPool thread_pool(cct, "FSCKThreadPool", "FSCK", thread_count);
 
     thread_pool.add_work_queue(wq.get());
-    if (depth == FSCK_SHALLOW && thread_count > 0) {
+    if (thread_count > 0) {
       //not the best place but let's check anyway
       ceph_assert(sb_info_lock);
       thread_pool.start();
@@ -7933,6 +9061,20 @@ void BlueStore::_fsck_check_objects(FSCKDepth depth,
         if (depth == FSCK_SHALLOW) {
           continue;
         }
+        if (thread_count > 0) {
+          // the shards are loaded along with their onode, out of
+          // order: only look for strays here
+          uint32_t offset;
+          string okey;
+          get_key_extent_shard(it->key(), &okey, &offset);
+          if (okey != last_onode_key) {
+            derr << "fsck error: stray shard 0x" << std::hex << offset
+              << std::dec << " " << pretty_binary_string(it->key())
+              << dendl;
+            ++errors;
+          }
+          continue;
+        }
         while (!expecting_shards.empty() &&
           expecting_shards.front() < it->key()) {
           derr << "fsck error: missing shard key "
@@ -7981,6 +9123,9 @@ void BlueStore::_fsck_check_objects(FSCKDepth depth,
         ++errors;
         continue;
       }
+      if (thread_count > 0 && depth != FSCK_SHALLOW) {
+        last_onode_key = it->key();
+      }
       if (!c ||
         oid.shard_id != pgid.shard ||
         oid.hobj.get_logical_pool() != (int64_t)pgid.pool() ||
@@ -8014,7 +9159,7 @@ void BlueStore::_fsck_check_objects(FSCKDepth depth,
       }
 
       bool queued = false;
-      if (depth == FSCK_SHALLOW && thread_count > 0) {
+      if (thread_count > 0) {
         queued = wq->queue(
           pool_id,
           c,
@@ -8022,114 +9167,26 @@ void BlueStore::_fsck_check_objects(FSCKDepth depth,
           it->key(),
           it->value());
       }
-      OnodeRef o;
-      map<BlobRef, bluestore_blob_t::unused_t> referenced;
-
       if (!queued) {
         ++processed_myself;
 
-         o = fsck_check_objects_shallow(
+        map<BlobRef, bluestore_blob_t::unused_t> referenced;
+        OnodeRef o = fsck_check_objects_shallow(
           depth,
           pool_id,
           c,
           oid,
           it->key(),
           it->value(),
-          &expecting_shards,
+          thread_count > 0 ? nullptr : &expecting_shards,
           &referenced,
           ctx);
-      }
-
-      if (depth != FSCK_SHALLOW) {
-        ceph_assert(o != nullptr);
-        if (o->onode.nid) {
-          if (o->onode.nid > nid_max) {
-            derr << "fsck error: " << oid << " nid " << o->onode.nid
-              << " > nid_max " << nid_max << dendl;
-            ++errors;
-          }
-          if (used_nids.count(o->onode.nid)) {
-            derr << "fsck error: " << oid << " nid " << o->onode.nid
-              << " already in use" << dendl;
-            ++errors;
-            continue; // go for next object
-          }
-          used_nids.insert(o->onode.nid);
-        }
-        for (auto& i : referenced) {
-          dout(20) << __func__ << "  referenced 0x" << std::hex << i.second
-            << std::dec << " for " << *i.first << dendl;
-          const bluestore_blob_t& blob = i.first->get_blob();
-          if (i.second & blob.unused) {
-            derr << "fsck error: " << oid << " blob claims unused 0x"
-              << std::hex << blob.unused
-              << " but extents reference 0x" << i.second << std::dec
-              << " on blob " << *i.first << dendl;
-            ++errors;
-          }
-          if (blob.has_csum()) {
-            uint64_t blob_len = blob.get_logical_length();
-            uint64_t unused_chunk_size = blob_len / (sizeof(blob.unused) * 8);
-            unsigned csum_count = blob.get_csum_count();
-            unsigned csum_chunk_size = blob.get_csum_chunk_size();
-            for (unsigned p = 0; p < csum_count; ++p) {
-              unsigned pos = p * csum_chunk_size;
-              unsigned firstbit = pos / unused_chunk_size;    // [firstbit,lastbit]
-              unsigned lastbit = (pos + csum_chunk_size - 1) / unused_chunk_size;
-              unsigned mask = 1u << firstbit;
-              for (unsigned b = firstbit + 1; b <= lastbit; ++b) {
-                mask |= 1u << b;
-              }
-              if ((blob.unused & mask) == mask) {
-                // this csum chunk region is marked unused
-                if (blob.get_csum_item(p) != 0) {
-                  derr << "fsck error: " << oid
-                    << " blob claims csum chunk 0x" << std::hex << pos
-                    << "~" << csum_chunk_size
-                    << " is unused (mask 0x" << mask << " of unused 0x"
-                    << blob.unused << ") but csum is non-zero 0x"
-                    << blob.get_csum_item(p) << std::dec << " on blob "
-                    << *i.first << dendl;
-                  ++errors;
-                }
-              }
-            }
-          }
+        if (depth != FSCK_SHALLOW) {
+          fsck_check_objects_regular(depth, c, o, referenced, ctx);
         }
-        // omap
-        if (o->onode.has_omap()) {
-          ceph_assert(ctx.used_omap_head);
-          if (ctx.used_omap_head->count(o->onode.nid)) {
-            derr << "fsck error: " << o->oid << " omap_head " << o->onode.nid
-                 << " already in use" << dendl;
-            ++errors;
-          } else {
-            ctx.used_omap_head->insert(o->onode.nid);
-          }
-        } // if (o->onode.has_omap())
-        if (depth == FSCK_DEEP) {
-          bufferlist bl;
-          uint64_t max_read_block = cct->_conf->bluestore_fsck_read_bytes_cap;
-          uint64_t offset = 0;
-          do {
-            uint64_t l = std::min(uint64_t(o->onode.size - offset), max_read_block);
-            int r = _do_read(c.get(), o, offset, l, bl,
-              CEPH_OSD_OP_FLAG_FADVISE_NOCACHE);
-            if (r < 0) {
-              ++errors;
-              derr << "fsck error: " << oid << std::hex
-                << " error during read: "
-                << " " << offset << "~" << l
-                << " " << cpp_strerror(r) << std::dec
-                << dendl;
-              break;
-            }
-            offset += l;
-          } while (offset < o->onode.size);
-        } // deep
-      } //if (depth != FSCK_SHALLOW)
+      }
     } // for (it->lower_bound(string()); it->valid(); it->next())
-    if (depth == FSCK_SHALLOW && thread_count > 0) {
+    if (thread_count > 0) {
       wq->finalize(thread_pool, ctx);
       if (processed_myself) {
         // may be needs more threads?
@@ -8356,9 +9413,7 @@ int BlueStore::_fsck_on_open(BlueStore::FSCKDepth depth, bool repair)
       num_spanning_blobs,
       &used_blocks,
       &used_omap_head,
-      //no need for the below lock when in non-shallow mode as
-      // there is no multithreading in this case
-      depth == FSCK_SHALLOW ? &sb_info_lock : nullptr,
+      &sb_info_lock,
       sb_info,
       expected_store_statfs,
       expected_pool_statfs,
@@ -8803,9 +9858,7 @@ int BlueStore::_fsck_on_open(BlueStore::FSCKDepth depth, bool repair)
 
     dout(1) << __func__ << " checking freelist vs allocated" << dendl;
     {
-      fm->enumerate_reset();
-      uint64_t offset, length;
-      while (fm->enumerate_next(db, &offset, &length)) {
+      auto check_free = [&](uint64_t offset, uint64_t length) {
         bool intersects = false;
         apply_for_bitset_range(
           offset, length, alloc_size, used_blocks,
@@ -8841,8 +9894,18 @@ int BlueStore::_fsck_on_open(BlueStore::FSCKDepth depth, bool repair)
 	        << " intersects allocated blocks" << dendl;
 	  ++errors;
         }
+      };
+      if (fm->is_null_manager()) {
+	// nothing on disk, check what the allocator was loaded with
+	shared_alloc.a->dump(check_free);
+      } else {
+	fm->enumerate_reset();
+	uint64_t offset, length;
+	while (fm->enumerate_next(db, &offset, &length)) {
+	  check_free(offset, length);
+	}
+	fm->enumerate_reset();
       }
-      fm->enumerate_reset();
       size_t count = used_blocks.count();
       if (used_blocks.size() != count) {
         ceph_assert(used_blocks.size() > count);
@@ -9361,8 +10424,9 @@ BlueStore::CollectionRef BlueStore::_get_collection(const coll_t& cid)
 void BlueStore::_queue_reap_collection(CollectionRef& c)
 {
   dout(10) << __func__ << " " << c << " " << c->cid << dendl;
-  // _reap_collections and this in the same thread,
-  // so no need a lock.
+  // with several kv lanes txcs are finished (and collections reaped)
+  // on more than one finalize thread.
+  std::lock_guard l(reap_lock);
   removed_collections.push_back(c);
 }
 
@@ -9371,8 +10435,7 @@ void BlueStore::_reap_collections()
 
   list<CollectionRef> removed_colls;
   {
-    // _queue_reap_collection and this in the same thread.
-    // So no need a lock.
+    std::lock_guard l(reap_lock);
     if (!removed_collections.empty())
       removed_colls.swap(removed_collections);
     else
@@ -9402,6 +10465,7 @@ void BlueStore::_reap_collections()
   if (removed_colls.empty()) {
     dout(10) << __func__ << " all reaped" << dendl;
   } else {
+    std::lock_guard l(reap_lock);
     removed_collections.splice(removed_collections.begin(), removed_colls);
   }
 }
@@ -9414,8 +10478,11 @@ void BlueStore::_update_cache_logger()
   uint64_t num_blobs = 0;
   uint64_t num_buffers = 0;
   uint64_t num_buffer_bytes = 0;
+  uint64_t num_encoded_onodes = 0;
+  uint64_t num_encoded_onode_bytes = 0;
   for (auto c : onode_cache_shards) {
     c->add_stats(&num_onodes, &num_pinned_onodes);
+    c->add_encoded_stats(&num_encoded_onodes, &num_encoded_onode_bytes);
   }
   for (auto c : buffer_cache_shards) {
     c->add_stats(&num_extents, &num_blobs,
@@ -9423,6 +10490,8 @@ void BlueStore::_update_cache_logger()
   }
   logger->set(l_bluestore_onodes, num_onodes);
   logger->set(l_bluestore_pinned_onodes, num_pinned_onodes);
+  logger->set(l_bluestore_encoded_onodes, num_encoded_onodes);
+  logger->set(l_bluestore_encoded_onode_bytes, num_encoded_onode_bytes);
   logger->set(l_bluestore_extents, num_extents);
   logger->set(l_bluestore_blobs, num_blobs);
   logger->set(l_bluestore_buffers, num_buffers);
@@ -9522,8 +10591,10 @@ int BlueStore::set_collection_opts(
   dout(15) << __func__ << " " << ch->cid << " options " << opts << dendl;
   if (!c->exists)
     return -ENOENT;
+  auto dict = _load_compression_dicts(opts);
   std::unique_lock l{c->lock};
   c->pool_opts = opts;
+  c->compression_dict = dict;
   return 0;
 }
 
@@ -9901,10 +10972,16 @@ int BlueStore::_do_read(
     dout(20) << __func__ << " will bypass cache and do direct read" << dendl;
     read_cache_policy = BufferSpace::BYPASS_CLEAN_CACHE;
   }
+  if (op_flags & CEPH_OSD_OP_FLAG_FADVISE_SEQUENTIAL) {
+    read_cache_policy |= BufferSpace::SEQUENTIAL_READ;
+  }
 
   // build blob-wise list to of stuff read (that isn't cached)
   ready_regions_t ready_regions;
   blobs2read_t blobs2read;
+  if (read_cache_policy == 0) {
+    mempool_thread.data_cache->note_access(o->oid, offset, length);
+  }
   _read_cache(o, offset, length, read_cache_policy, ready_regions, blobs2read);
 
 
@@ -10038,6 +11115,21 @@ int BlueStore::_decompress(bufferlist& source, bufferlist* result)
     derr << __func__ << " can't load decompressor " << alg_name << dendl;
     _set_compression_alert(false, alg_name);
     r = -EIO;
+  } else if (uint32_t id = cp->get_dictionary_id(chdr.compressor_message);
+	     id) {
+    auto dict = _get_compression_dict(id);
+    if (!dict) {
+      derr << __func__ << " compression dictionary " << id
+	   << " is not loaded" << dendl;
+      r = -EIO;
+    } else {
+      r = cp->decompress_with_dictionary(i, chdr.length, *result,
+					 chdr.compressor_message, *dict);
+      if (r < 0) {
+	derr << __func__ << " decompression failed with exit code " << r << dendl;
+	r = -EIO;
+      }
+    }
   } else {
     r = cp->decompress(i, chdr.length, *result, chdr.compressor_message);
     if (r < 0) {
@@ -10227,6 +11319,9 @@ int BlueStore::_do_readv(
   FUNCTRACE(cct);
   int r = 0;
   int read_cache_policy = 0; // do not bypass clean or dirty cache
+  if (op_flags & CEPH_OSD_OP_FLAG_FADVISE_SEQUENTIAL) {
+    read_cache_policy |= BufferSpace::SEQUENTIAL_READ;
+  }
 
   dout(20) << __func__ << " fiemap " << m << std::hex
            << " size 0x" << o->onode.size << " (" << std::dec
@@ -10265,6 +11360,9 @@ int BlueStore::_do_readv(
   int i = 0;
   for (auto p = m.begin(); p != m.end(); p++, i++) {
     raw_results.push_back({});
+    if (read_cache_policy == 0) {
+      mempool_thread.data_cache->note_access(o->oid, p.get_start(), p.get_len());
+    }
     _read_cache(o, p.get_start(), p.get_len(), read_cache_policy,
                 std::get<0>(raw_results[i]), std::get<2>(raw_results[i]));
     r = _prepare_read_ioc(std::get<2>(raw_results[i]), &std::get<1>(raw_results[i]), &ioc);
@@ -10489,6 +11587,9 @@ int BlueStore::collection_list(
   {
     std::shared_lock l(c->lock);
     r = _collection_list(c, start, end, max, false, ls, pnext);
+    if (r == 0 && c->note_listed(*ls)) {
+      _prefetch_onodes(c, *ls);
+    }
   }
 
   dout(10) << __func__ << " " << c->cid
@@ -10510,6 +11611,9 @@ int BlueStore::collection_list_legacy(
   {
     std::shared_lock l(c->lock);
     r = _collection_list(c, start, end, max, true, ls, pnext);
+    if (r == 0 && c->note_listed(*ls)) {
+      _prefetch_onodes(c, *ls);
+    }
   }
 
   dout(10) << __func__ << " " << c->cid
@@ -10648,6 +11752,45 @@ out:
   return r;
 }
 
+void BlueStore::_prefetch_onodes(Collection *c, const vector<ghobject_t>& ls)
+{
+  // the keys of the listed objects not cached yet.  temp objects sort
+  // apart from the others, leave them out of the range we iterate.
+  map<string, const ghobject_t*> keys;
+  for (auto& oid : ls) {
+    if (oid.hobj.is_temp() || c->onode_map.contains(oid)) {
+      continue;
+    }
+    string key;
+    get_object_key(cct, oid, &key);
+    keys.emplace(std::move(key), &oid);
+  }
+  // never let one listing displace more than half of the cache shard
+  if (keys.empty() || keys.size() > c->get_onode_cache()->max / 2) {
+    dout(20) << __func__ << " " << c->cid << " skipping " << keys.size()
+	     << " onodes" << dendl;
+    return;
+  }
+  const string& last = keys.rbegin()->first;
+  unsigned n = 0;
+  KeyValueDB::Iterator it = db->get_iterator(PREFIX_OBJ);
+  for (it->lower_bound(keys.begin()->first);
+       it->valid() && it->key() <= last;
+       it->next()) {
+    auto p = keys.find(it->key());
+    if (p == keys.end()) {
+      // an extent shard
+      continue;
+    }
+    OnodeRef o(Onode::decode(c, *p->second, p->first, it->value()));
+    c->onode_map.add(*p->second, o);
+    ++n;
+  }
+  dout(20) << __func__ << " " << c->cid << " " << n << " of " << keys.size()
+	   << " onodes" << dendl;
+  logger->inc(l_bluestore_onode_prefetched, n);
+}
+
 int BlueStore::omap_get(
   CollectionHandle &c_,    ///< [in] Collection containing oid
   const ghobject_t &oid,   ///< [in] Object containing omap
@@ -10842,15 +11985,20 @@ int BlueStore::omap_get_values(
     const string& prefix = o->get_omap_prefix();
     o->get_omap_key(string(), &final_key);
     size_t base_key_len = final_key.size();
+    // looked up in one batch; the keys share the object's prefix, so
+    // they are in the same order as the user keys
+    set<string> final_keys;
     for (set<string>::const_iterator p = keys.begin(); p != keys.end(); ++p) {
       final_key.resize(base_key_len); // keep prefix
       final_key += *p;
-      bufferlist val;
-      if (db->get(prefix, final_key, &val) >= 0) {
-	dout(30) << __func__ << "  got " << pretty_binary_string(final_key)
-		 << " -> " << *p << dendl;
-	out->insert(make_pair(*p, val));
-      }
+      final_keys.insert(final_keys.end(), final_key);
+    }
+    map<string, bufferlist> vals;
+    db->get(prefix, final_keys, &vals);
+    for (auto& [k, val] : vals) {
+      dout(30) << __func__ << "  got " << pretty_binary_string(k)
+	       << " -> " << k.substr(base_key_len) << dendl;
+      out->emplace_hint(out->end(), k.substr(base_key_len), std::move(val));
     }
   }
  out:
@@ -10976,14 +12124,86 @@ ObjectMap::ObjectMapIterator BlueStore::get_omap_iterator(
   return ObjectMap::ObjectMapIterator(new OmapIteratorImpl(c, o, it));
 }
 
-// -----------------
-// write helpers
-
-uint64_t BlueStore::_get_ondisk_reserved() const {
-  ceph_assert(min_alloc_size);
-  return round_up_to(
-    std::max<uint64_t>(SUPER_RESERVED, min_alloc_size), min_alloc_size);
-}
+int BlueStore::omap_get_vals_encoded(
+  CollectionHandle &c_,
+  const ghobject_t &oid,
+  const string &start_after,
+  const string &filter_prefix,
+  uint64_t max_entries,
+  uint64_t max_bytes,
+  bufferlist *out,
+  uint32_t *num,
+  bool *more)
+{
+  Collection *c = static_cast<Collection *>(c_.get());
+  dout(15) << __func__ << " " << c->get_cid() << " oid " << oid
+	   << " after " << start_after << " prefix " << filter_prefix << dendl;
+  *num = 0;
+  *more = false;
+  if (!c->exists)
+    return -ENOENT;
+  std::shared_lock l(c->lock);
+  auto start1 = mono_clock::now();
+  int r = 0;
+  OnodeRef o = c->get_onode(oid, false);
+  if (!o || !o->exists) {
+    r = -ENOENT;
+    goto out;
+  }
+  if (!o->onode.has_omap()) {
+    goto out;
+  }
+  o->flush();
+  {
+    string head, end, key;
+    o->get_omap_key(string(), &head);
+    o->get_omap_tail(&end);
+    if (!filter_prefix.empty()) {
+      // the keys with filter_prefix are all below its successor
+      string past = filter_prefix;
+      while (!past.empty() && (unsigned char)past.back() == 0xff) {
+	past.pop_back();
+      }
+      if (!past.empty()) {
+	past.back()++;
+	o->get_omap_key(past, &key);
+	if (key < end) {
+	  end.swap(key);
+	}
+      }
+    }
+    KeyValueDB::Iterator it = db->get_iterator(o->get_omap_prefix(),
+					       KeyValueDB::ITERATOR_READAHEAD);
+    o->get_omap_key(std::max(start_after, filter_prefix), &key);
+    if (filter_prefix > start_after) {
+      it->lower_bound(key);
+    } else {
+      it->upper_bound(key);
+    }
+    *num = it->encode_range(end, head.size(), max_entries, max_bytes,
+			    out, more);
+  }
+ out:
+  c->store->log_latency(
+    __func__,
+    l_bluestore_omap_get_values_lat,
+    mono_clock::now() - start1,
+    c->store->cct->_conf->bluestore_log_omap_iterator_age);
+
+  dout(10) << __func__ << " " << c->get_cid() << " oid " << oid
+	   << " = " << r << ", " << *num << " pairs" << (*more ? ", more" : "")
+	   << dendl;
+  return r;
+}
+
+// -----------------
+// write helpers
+
+uint64_t BlueStore::_get_ondisk_reserved() const {
+  ceph_assert(min_alloc_size);
+  return round_up_to(
+    std::max<uint64_t>(SUPER_RESERVED, min_alloc_size), min_alloc_size);
+}
 
 void BlueStore::_prepare_ondisk_format_super(KeyValueDB::Transaction& t)
 {
@@ -11051,6 +12271,11 @@ int BlueStore::_open_super_meta()
     } else {
       ceph_abort_msg("Not Support extent freelist manager");
     }
+    bufferlist nbl;
+    null_freelist = db->get(PREFIX_SUPER, "null_freelist", &nbl) == 0;
+    if (null_freelist) {
+      dout(1) << __func__ << " null freelist" << dendl;
+    }
   }
 
   // ondisk format
@@ -11349,6 +12574,22 @@ void BlueStore::_txc_state_proc(TransContext *txc)
 	  _txc_apply_kv(txc, true);
 	}
       }
+      if (auto lane = _kv_lane_for(txc->osr.get()); lane) {
+	std::lock_guard l(lane->lock);
+	lane->queue.push_back(txc);
+	if (!lane->in_progress) {
+	  lane->in_progress = true;
+	  lane->cond.notify_one();
+	}
+	if (txc->get_state() != TransContext::STATE_KV_SUBMITTED) {
+	  lane->queue_unsubmitted.push_back(txc);
+	  ++txc->osr->kv_committing_serially;
+	}
+	if (txc->had_ios)
+	  lane->ios++;
+	lane->throttle_costs += txc->cost;
+	return;
+      }
       {
 	std::lock_guard l(kv_lock);
 	kv_queue.push_back(txc);
@@ -11571,42 +12812,45 @@ void BlueStore::_txc_finalize_kv(TransContext *txc, KeyValueDB::Transaction t)
 	   << " released 0x" << txc->released
 	   << std::dec << dendl;
 
-  // We have to handle the case where we allocate *and* deallocate the
-  // same region in this transaction.  The freelist doesn't like that.
-  // (Actually, the only thing that cares is the BitmapFreelistManager
-  // debug check. But that's important.)
-  interval_set<uint64_t> tmp_allocated, tmp_released;
-  interval_set<uint64_t> *pallocated = &txc->allocated;
-  interval_set<uint64_t> *preleased = &txc->released;
-  if (!txc->allocated.empty() && !txc->released.empty()) {
-    interval_set<uint64_t> overlap;
-    overlap.intersection_of(txc->allocated, txc->released);
-    if (!overlap.empty()) {
-      tmp_allocated = txc->allocated;
-      tmp_allocated.subtract(overlap);
-      tmp_released = txc->released;
-      tmp_released.subtract(overlap);
-      dout(20) << __func__ << "  overlap 0x" << std::hex << overlap
+  // a null freelist records nothing
+  if (!fm->is_null_manager()) {
+    // We have to handle the case where we allocate *and* deallocate the
+    // same region in this transaction.  The freelist doesn't like that.
+    // (Actually, the only thing that cares is the BitmapFreelistManager
+    // debug check. But that's important.)
+    interval_set<uint64_t> tmp_allocated, tmp_released;
+    interval_set<uint64_t> *pallocated = &txc->allocated;
+    interval_set<uint64_t> *preleased = &txc->released;
+    if (!txc->allocated.empty() && !txc->released.empty()) {
+      interval_set<uint64_t> overlap;
+      overlap.intersection_of(txc->allocated, txc->released);
+      if (!overlap.empty()) {
+	tmp_allocated = txc->allocated;
+	tmp_allocated.subtract(overlap);
+	tmp_released = txc->released;
+	tmp_released.subtract(overlap);
+	dout(20) << __func__ << "  overlap 0x" << std::hex << overlap
 	       << ", new allocated 0x" << tmp_allocated
 	       << " released 0x" << tmp_released << std::dec
 	       << dendl;
-      pallocated = &tmp_allocated;
-      preleased = &tmp_released;
+	pallocated = &tmp_allocated;
+	preleased = &tmp_released;
+      }
     }
-  }
 
-  // update freelist with non-overlap sets
-  for (interval_set<uint64_t>::iterator p = pallocated->begin();
-       p != pallocated->end();
-       ++p) {
-    fm->allocate(p.get_start(), p.get_len(), t);
-  }
-  for (interval_set<uint64_t>::iterator p = preleased->begin();
-       p != preleased->end();
-       ++p) {
-    dout(20) << __func__ << " release 0x" << std::hex << p.get_start()
+    // update freelist with non-overlap sets
+    for (interval_set<uint64_t>::iterator p = pallocated->begin();
+	 p != pallocated->end();
+	 ++p) {
+      fm->allocate(p.get_start(), p.get_len(), t);
+    }
+    for (interval_set<uint64_t>::iterator p = preleased->begin();
+	 p != preleased->end();
+	 ++p) {
+      dout(20) << __func__ << " release 0x" << std::hex << p.get_start()
 	     << "~" << p.get_len() << std::dec << dendl;
-    fm->release(p.get_start(), p.get_len(), t);
+      fm->release(p.get_start(), p.get_len(), t);
+    }
   }
 
 #ifdef HAVE_LIBZBD
@@ -11675,7 +12919,7 @@ void BlueStore::_txc_committed_kv(TransContext *txc)
     if (txc->ch->commit_queue) {
       txc->ch->commit_queue->queue(txc->oncommits);
     } else {
-      finisher.queue(txc->oncommits);
+      finisher.queue(txc->osr.get(), txc->oncommits);
     }
   }
   throttle.log_state_latency(*txc, logger, l_bluestore_state_kv_committing_lat);
@@ -11960,11 +13204,56 @@ void BlueStore::_kv_start()
   finisher.start();
   kv_sync_thread.create("bstore_kv_sync");
   kv_finalize_thread.create("bstore_kv_final");
+
+  kv_nid_reserved = 0;
+  kv_blobid_reserved = 0;
+  auto lanes = cct->_conf.get_val<uint64_t>("bluestore_kv_sync_lanes");
+  for (unsigned i = 1; i < lanes; ++i) {
+    kv_lanes.emplace_back(std::make_unique<KVSyncLane>(this, i));
+    kv_lanes.back()->sync_thread.create("bstore_kv_sync");
+    kv_lanes.back()->finalize_thread.create("bstore_kv_final");
+  }
+  dout(10) << __func__ << " " << lanes << " kv sync lane(s)" << dendl;
+
+  auto compress_threads =
+    cct->_conf.get_val<uint64_t>("bluestore_compression_threads");
+  if (compress_threads) {
+    compress_tp = std::make_unique<ThreadPool>(
+      cct, "BlueStore::compress_tp", "bstore_compress", compress_threads);
+    compress_wq = std::make_unique<ContextWQ>(
+      "BlueStore::compress_wq", ceph::timespan::zero(), compress_tp.get());
+    compress_tp->start();
+  }
 }
 
 void BlueStore::_kv_stop()
 {
   dout(10) << __func__ << dendl;
+  // stop the extra lanes first; lane 0 may still have deferred
+  // cleanup to do for the txcs they committed.
+  for (auto& lane : kv_lanes) {
+    {
+      std::unique_lock l{lane->lock};
+      while (!lane->started) {
+	lane->cond.wait(l);
+      }
+      lane->stop = true;
+      lane->cond.notify_all();
+    }
+    {
+      std::unique_lock l{lane->finalize_lock};
+      while (!lane->finalize_started) {
+	lane->finalize_cond.wait(l);
+      }
+      lane->finalize_stop = true;
+      lane->finalize_cond.notify_all();
+    }
+  }
+  for (auto& lane : kv_lanes) {
+    lane->sync_thread.join();
+    lane->finalize_thread.join();
+  }
+  kv_lanes.clear();
   {
     std::unique_lock l{kv_lock};
     while (!kv_sync_started) {
@@ -11995,6 +13284,11 @@ void BlueStore::_kv_stop()
   dout(10) << __func__ << " stopping finishers" << dendl;
   finisher.wait_for_empty();
   finisher.stop();
+  if (compress_tp) {
+    compress_tp->stop();
+    compress_wq.reset();
+    compress_tp.reset();
+  }
   dout(10) << __func__ << " stopped" << dendl;
 }
 
@@ -12103,29 +13397,10 @@ void BlueStore::_kv_sync_thread()
       // we will use one final transaction to force a sync
       KeyValueDB::Transaction synct = db->get_transaction();
 
-      // increase {nid,blobid}_max?  note that this covers both the
-      // case where we are approaching the max and the case we passed
-      // it.  in either case, we increase the max in the earlier txn
-      // we submit.
+      std::unique_lock idl{kv_id_lock, std::defer_lock};
       uint64_t new_nid_max = 0, new_blobid_max = 0;
-      if (nid_last + cct->_conf->bluestore_nid_prealloc/2 > nid_max) {
-	KeyValueDB::Transaction t =
-	  kv_submitting.empty() ? synct : kv_submitting.front()->t;
-	new_nid_max = nid_last + cct->_conf->bluestore_nid_prealloc;
-	bufferlist bl;
-	encode(new_nid_max, bl);
-	t->set(PREFIX_SUPER, "nid_max", bl);
-	dout(10) << __func__ << " new_nid_max " << new_nid_max << dendl;
-      }
-      if (blobid_last + cct->_conf->bluestore_blobid_prealloc/2 > blobid_max) {
-	KeyValueDB::Transaction t =
-	  kv_submitting.empty() ? synct : kv_submitting.front()->t;
-	new_blobid_max = blobid_last + cct->_conf->bluestore_blobid_prealloc;
-	bufferlist bl;
-	encode(new_blobid_max, bl);
-	t->set(PREFIX_SUPER, "blobid_max", bl);
-	dout(10) << __func__ << " new_blobid_max " << new_blobid_max << dendl;
-      }
+      _kv_reserve_ids(kv_submitting.empty() ? synct : kv_submitting.front()->t,
+		      idl, &new_nid_max, &new_blobid_max);
 
       for (auto txc : kv_committing) {
 	throttle.log_state_latency(*txc, logger, l_bluestore_state_kv_queued_lat);
@@ -12166,6 +13441,9 @@ void BlueStore::_kv_sync_thread()
       // submit synct synchronously (block and wait for it to commit)
       int r = cct->_conf->bluestore_debug_omit_kv_commit ? 0 : db->submit_transaction_sync(synct);
       ceph_assert(r == 0);
+      if (idl.owns_lock()) {
+	idl.unlock();
+      }
 
 #ifdef WITH_BLKIN
       for (auto txc : kv_committing) {
@@ -12222,14 +13500,7 @@ void BlueStore::_kv_sync_thread()
 	}
       }
 
-      if (new_nid_max) {
-	nid_max = new_nid_max;
-	dout(10) << __func__ << " nid_max now " << nid_max << dendl;
-      }
-      if (new_blobid_max) {
-	blobid_max = new_blobid_max;
-	dout(10) << __func__ << " blobid_max now " << blobid_max << dendl;
-      }
+      _kv_publish_ids(new_nid_max, new_blobid_max);
 
       {
 	auto finish = mono_clock::now();
@@ -12337,6 +13608,247 @@ void BlueStore::_kv_finalize_thread()
   kv_finalize_started = false;
 }
 
+BlueStore::KVSyncLane *BlueStore::_kv_lane_for(OpSequencer *osr)
+{
+  if (kv_lanes.empty()) {
+    return nullptr;
+  }
+  // all txcs of a sequencer go through the same lane, which keeps the
+  // per-collection commit order.
+  unsigned i = osr->get_sequencer_id() % (kv_lanes.size() + 1);
+  return i ? kv_lanes[i - 1].get() : nullptr;
+}
+
+void BlueStore::_kv_reserve_ids(
+  KeyValueDB::Transaction t,
+  std::unique_lock<ceph::mutex>& idl,
+  uint64_t *new_nid_max,
+  uint64_t *new_blobid_max)
+{
+  // increase {nid,blobid}_max?  note that this covers both the
+  // case where we are approaching the max and the case we passed
+  // it.  in either case, we increase the max in the earlier txn
+  // we submit.
+  if (nid_last + cct->_conf->bluestore_nid_prealloc/2 <= nid_max &&
+      blobid_last + cct->_conf->bluestore_blobid_prealloc/2 <= blobid_max) {
+    return;
+  }
+  // another lane may already have queued a new max.  idl stays locked
+  // until t is submitted so that the kv sees the updates in order and
+  // no lane relies on a reservation that has not reached the kv yet.
+  idl.lock();
+  if (nid_last + cct->_conf->bluestore_nid_prealloc/2 >
+      std::max<uint64_t>(nid_max, kv_nid_reserved)) {
+    *new_nid_max = nid_last + cct->_conf->bluestore_nid_prealloc;
+    bufferlist bl;
+    encode(*new_nid_max, bl);
+    t->set(PREFIX_SUPER, "nid_max", bl);
+    kv_nid_reserved = *new_nid_max;
+    dout(10) << __func__ << " new_nid_max " << *new_nid_max << dendl;
+  }
+  if (blobid_last + cct->_conf->bluestore_blobid_prealloc/2 >
+      std::max<uint64_t>(blobid_max, kv_blobid_reserved)) {
+    *new_blobid_max = blobid_last + cct->_conf->bluestore_blobid_prealloc;
+    bufferlist bl;
+    encode(*new_blobid_max, bl);
+    t->set(PREFIX_SUPER, "blobid_max", bl);
+    kv_blobid_reserved = *new_blobid_max;
+    dout(10) << __func__ << " new_blobid_max " << *new_blobid_max << dendl;
+  }
+  if (!*new_nid_max && !*new_blobid_max) {
+    idl.unlock();
+  }
+}
+
+void BlueStore::_kv_publish_ids(uint64_t new_nid_max, uint64_t new_blobid_max)
+{
+  if (!new_nid_max && !new_blobid_max) {
+    return;
+  }
+  // lanes may commit out of order; never move a max backwards
+  std::lock_guard l(kv_id_lock);
+  if (new_nid_max > nid_max) {
+    nid_max = new_nid_max;
+    dout(10) << __func__ << " nid_max now " << nid_max << dendl;
+  }
+  if (new_blobid_max > blobid_max) {
+    blobid_max = new_blobid_max;
+    dout(10) << __func__ << " blobid_max now " << blobid_max << dendl;
+  }
+}
+
+void BlueStore::_kv_lane_sync_thread(KVSyncLane *lane)
+{
+  dout(10) << __func__ << " lane " << lane->id << " start" << dendl;
+  deque<TransContext*> committing;
+  std::unique_lock l{lane->lock};
+  ceph_assert(!lane->started);
+  lane->started = true;
+  lane->cond.notify_all();
+
+  while (true) {
+    ceph_assert(committing.empty());
+    if (lane->queue.empty()) {
+      if (lane->stop)
+	break;
+      dout(20) << __func__ << " lane " << lane->id << " sleep" << dendl;
+      lane->in_progress = false;
+      lane->cond.wait(l);
+      dout(20) << __func__ << " lane " << lane->id << " wake" << dendl;
+    } else {
+      deque<TransContext*> submitting;
+      dout(20) << __func__ << " lane " << lane->id
+	       << " committing " << lane->queue.size()
+	       << " submitting " << lane->queue_unsubmitted.size()
+	       << dendl;
+      committing.swap(lane->queue);
+      submitting.swap(lane->queue_unsubmitted);
+      uint64_t aios = lane->ios;
+      uint64_t costs = lane->throttle_costs;
+      lane->ios = 0;
+      lane->throttle_costs = 0;
+      l.unlock();
+
+      auto start = mono_clock::now();
+
+      // the data written by our txcs must be stable before the kv
+      // commit that references it.  deferred ios are left to lane 0.
+      if (aios) {
+	dout(20) << __func__ << " lane " << lane->id
+		 << " num_aios=" << aios << ", flushing" << dendl;
+	bdev->flush();
+      }
+      auto after_flush = mono_clock::now();
+
+      KeyValueDB::Transaction synct = db->get_transaction();
+
+      std::unique_lock idl{kv_id_lock, std::defer_lock};
+      uint64_t new_nid_max = 0, new_blobid_max = 0;
+      _kv_reserve_ids(submitting.empty() ? synct : submitting.front()->t,
+		      idl, &new_nid_max, &new_blobid_max);
+
+      for (auto txc : committing) {
+	throttle.log_state_latency(*txc, logger, l_bluestore_state_kv_queued_lat);
+	if (txc->get_state() == TransContext::STATE_KV_QUEUED) {
+	  _txc_apply_kv(txc, false);
+	  --txc->osr->kv_committing_serially;
+	} else {
+	  ceph_assert(txc->get_state() == TransContext::STATE_KV_SUBMITTED);
+	}
+	if (txc->had_ios) {
+	  --txc->osr->txc_with_unstable_io;
+	}
+      }
+
+      throttle.release_kv_throttle(costs);
+
+      int r = cct->_conf->bluestore_debug_omit_kv_commit ? 0 : db->submit_transaction_sync(synct);
+      ceph_assert(r == 0);
+      if (idl.owns_lock()) {
+	idl.unlock();
+      }
+
+      int committing_size = committing.size();
+      {
+	std::unique_lock m{lane->finalize_lock};
+	lane->committing_to_finalize.insert(
+	  lane->committing_to_finalize.end(),
+	  committing.begin(),
+	  committing.end());
+	committing.clear();
+	if (!lane->finalize_in_progress) {
+	  lane->finalize_in_progress = true;
+	  lane->finalize_cond.notify_one();
+	}
+      }
+
+      _kv_publish_ids(new_nid_max, new_blobid_max);
+
+      {
+	auto finish = mono_clock::now();
+	ceph::timespan dur_flush = after_flush - start;
+	ceph::timespan dur_kv = finish - after_flush;
+	ceph::timespan dur = finish - start;
+	dout(20) << __func__ << " lane " << lane->id
+		 << " committed " << committing_size
+		 << " in " << dur
+		 << " (" << dur_flush << " flush + " << dur_kv << " kv commit)"
+		 << dendl;
+	log_latency("kv_flush",
+	  l_bluestore_kv_flush_lat,
+	  dur_flush,
+	  cct->_conf->bluestore_log_op_age);
+	log_latency("kv_commit",
+	  l_bluestore_kv_commit_lat,
+	  dur_kv,
+	  cct->_conf->bluestore_log_op_age);
+	log_latency("kv_sync",
+	  l_bluestore_kv_sync_lat,
+	  dur,
+	  cct->_conf->bluestore_log_op_age);
+      }
+
+      l.lock();
+    }
+  }
+  dout(10) << __func__ << " lane " << lane->id << " finish" << dendl;
+  lane->started = false;
+}
+
+void BlueStore::_kv_lane_finalize_thread(KVSyncLane *lane)
+{
+  deque<TransContext*> kv_committed;
+  dout(10) << __func__ << " lane " << lane->id << " start" << dendl;
+  std::unique_lock l(lane->finalize_lock);
+  ceph_assert(!lane->finalize_started);
+  lane->finalize_started = true;
+  lane->finalize_cond.notify_all();
+  while (true) {
+    ceph_assert(kv_committed.empty());
+    if (lane->committing_to_finalize.empty()) {
+      if (lane->finalize_stop)
+	break;
+      dout(20) << __func__ << " lane " << lane->id << " sleep" << dendl;
+      lane->finalize_in_progress = false;
+      lane->finalize_cond.wait(l);
+      dout(20) << __func__ << " lane " << lane->id << " wake" << dendl;
+    } else {
+      kv_committed.swap(lane->committing_to_finalize);
+      l.unlock();
+      dout(20) << __func__ << " lane " << lane->id
+	       << " kv_committed " << kv_committed << dendl;
+
+      auto start = mono_clock::now();
+
+      while (!kv_committed.empty()) {
+	TransContext *txc = kv_committed.front();
+	ceph_assert(txc->get_state() == TransContext::STATE_KV_SUBMITTED);
+	_txc_state_proc(txc);
+	kv_committed.pop_front();
+      }
+
+      // lane 0 may be idle; do not let our deferred txcs wait for it
+      if (!deferred_aggressive) {
+	if (deferred_queue_size >= deferred_batch_ops.load() ||
+	    throttle.should_submit_deferred()) {
+	  deferred_try_submit();
+	}
+      }
+
+      _reap_collections();
+
+      log_latency("kv_final",
+	l_bluestore_kv_final_lat,
+	mono_clock::now() - start,
+	cct->_conf->bluestore_log_op_age);
+
+      l.lock();
+    }
+  }
+  dout(10) << __func__ << " lane " << lane->id << " finish" << dendl;
+  lane->finalize_started = false;
+}
+
 #ifdef HAVE_LIBZBD
 void BlueStore::_zoned_cleaner_start() {
   dout(10) << __func__ << dendl;
@@ -12383,9 +13895,35 @@ void BlueStore::_zoned_cleaner_thread() {
       dout(20) << __func__ << " wake" << dendl;
     } else {
       l.unlock();
+      // the writes allocated in these zones before they were picked are all
+      // committed, with the cleaning metadata of their objects, past this
+      _osr_drain_all();
       for (auto zone_num : *zones_to_clean) {
 	_zoned_clean_zone(zone_num);
+	if (_zoned_cleaner_stopping()) {
+	  break;
+	}
+      }
+      // and so are the relocations, before the zones are reset
+      _osr_drain_all();
+      if (_zoned_cleaner_stopping()) {
+	// the zones are taken again at the next mount
+	l.lock();
+	break;
+      }
+      uint64_t zone_size = bdev->get_zone_size();
+      KeyValueDB::Transaction t = db->get_transaction();
+      for (auto zone_num : *zones_to_clean) {
+	int r = bdev->reset_zone(zone_num);
+	if (r < 0) {
+	  derr << __func__ << " failed to reset zone " << zone_num << ": "
+	       << cpp_strerror(r) << dendl;
+	  ceph_abort_msg("unable to reset a zone");
+	}
+	// what is left is about the objects gone or moved meanwhile
+	t->rmkeys_by_prefix(_zoned_get_prefix(zone_num * zone_size));
       }
+      db->submit_transaction_sync(t);
       f->mark_zones_to_clean_free(zones_to_clean, db);
       a->mark_zones_to_clean_free();
       l.lock();
@@ -12395,10 +13933,129 @@ void BlueStore::_zoned_cleaner_thread() {
   zoned_cleaner_started = false;
 }
 
+bool BlueStore::_zoned_cleaner_stopping() {
+  std::lock_guard l{zoned_cleaner_lock};
+  return zoned_cleaner_stop;
+}
+
+// Relocate the live objects of a zone, in the order of their offsets in it
+// so that the zone is read back sequentially.  The cleaner takes part in
+// the throttle of the store like the foreground transactions, and backs
+// off further when the throttle is more than half full.
 void BlueStore::_zoned_clean_zone(uint64_t zone_num) {
   dout(10) << __func__ << " cleaning zone " << zone_num << dendl;
-  // TODO: (1) copy live objects from zone_num to a new zone, (2) issue a RESET
-  // ZONE operation to the device for the corresponding zone.
+
+  std::multimap<int64_t, ghobject_t> objects;
+  KeyValueDB::Iterator it =
+    db->get_iterator(_zoned_get_prefix(zone_num * bdev->get_zone_size()));
+  for (it->seek_to_first(); it->valid(); it->next()) {
+    ghobject_t oid;
+    if (get_key_object(it->key(), &oid) < 0) {
+      derr << __func__ << " unable to decode key "
+	   << pretty_binary_string(it->key()) << dendl;
+      continue;
+    }
+    int64_t offset;
+    auto p = it->value().cbegin();
+    decode(offset, p);
+    objects.emplace(offset, oid);
+  }
+  dout(10) << __func__ << " zone " << zone_num << " has " << objects.size()
+	   << " objects to relocate" << dendl;
+
+  for (auto& [offset, oid] : objects) {
+    if (_zoned_cleaner_stopping()) {
+      return;
+    }
+    if (throttle.kv_past_midpoint()) {
+      double sleep = cct->_conf->bluestore_zoned_cleaner_sleep;
+      if (sleep > 0) {
+	std::this_thread::sleep_for(ceph::make_timespan(sleep));
+      }
+    }
+    CollectionRef c;
+    {
+      std::shared_lock l(coll_lock);
+      for (auto& [cid, coll] : coll_map) {
+	if (coll->contains(oid)) {
+	  c = coll;
+	  break;
+	}
+      }
+    }
+    if (!c) {
+      dout(20) << __func__ << " no collection for " << oid
+	       << ", it is gone" << dendl;
+      continue;
+    }
+    _zoned_clean_object(c, oid, zone_num);
+  }
+}
+
+void BlueStore::_zoned_clean_object(
+  CollectionRef& c,
+  const ghobject_t& oid,
+  uint64_t zone_num)
+{
+  // serialize io dispatch vs the other transactions, see queue_transactions()
+  std::lock_guard l(atomic_alloc_and_submit_lock);
+  std::unique_lock l2(c->lock);
+  OnodeRef o = c->get_onode(oid, false);
+  if (!o || !o->exists) {
+    dout(20) << __func__ << " " << oid << " is gone" << dendl;
+    return;
+  }
+  o->extent_map.fault_range(db, 0, OBJECT_MAX_SIZE);
+
+  // the parts of the object with data in the zone, merged into the longest
+  // runs.  NB: the blobs shared with clones are rewritten for this object
+  // only, the clones keep referencing the zone until they are cleaned too.
+  const uint64_t zone_size = bdev->get_zone_size();
+  const uint64_t zone_start = zone_num * zone_size;
+  const uint64_t zone_end = zone_start + zone_size;
+  interval_set<uint64_t> to_move;
+  for (auto& e : o->extent_map.extent_map) {
+    for (auto& pe : e.blob->get_blob().get_extents()) {
+      if (pe.is_valid() && pe.offset < zone_end && pe.end() > zone_start) {
+	to_move.union_insert(e.logical_offset, e.length);
+	break;
+      }
+    }
+  }
+  if (to_move.empty()) {
+    dout(20) << __func__ << " " << oid << " has no data left in zone "
+	     << zone_num << dendl;
+    return;
+  }
+  dout(20) << __func__ << " " << oid << " relocating 0x" << std::hex
+	   << to_move << std::dec << dendl;
+
+  TransContext *txc = _txc_create(c.get(), c->osr.get(), nullptr);
+  spg_t pgid;
+  if (c->cid.is_pg(&pgid)) {
+    txc->osd_pool_id = pgid.pool();
+  }
+  for (auto p = to_move.begin(); p != to_move.end(); ++p) {
+    bufferlist bl;
+    int r = _do_read(c.get(), o, p.get_start(), p.get_len(), bl, 0);
+    ceph_assert(r == (int)p.get_len());
+    r = _do_write(txc, c, o, p.get_start(), p.get_len(), bl, 0);
+    ceph_assert(r >= 0);
+    txc->bytes += p.get_len();
+  }
+  txc->write_onode(o);
+  l2.unlock();
+
+  _txc_calc_cost(txc);
+  _txc_write_nodes(txc, txc->t);
+  _txc_finalize_kv(txc, txc->t);
+
+  auto tstart = mono_clock::now();
+  if (!throttle.try_start_transaction(*db, *txc, tstart)) {
+    throttle.finish_start_transaction(*db, *txc, tstart);
+  }
+  logger->inc(l_bluestore_txc);
+  _txc_state_proc(txc);
 }
 #endif
 
@@ -12471,19 +14128,23 @@ void BlueStore::deferred_try_submit()
     }
   }
 
-  for (auto& osr : osrs) {
-    osr->deferred_lock.lock();
-    if (osr->deferred_pending) {
-      if (!osr->deferred_running) {
-	_deferred_submit_unlock(osr.get());
+  if (cct->_conf.get_val<bool>("bluestore_deferred_aggregate")) {
+    _deferred_submit_aggregate(osrs);
+  } else {
+    for (auto& osr : osrs) {
+      osr->deferred_lock.lock();
+      if (osr->deferred_pending) {
+	if (!osr->deferred_running) {
+	  _deferred_submit_unlock(osr.get());
+	} else {
+	  osr->deferred_lock.unlock();
+	  dout(20) << __func__ << "  osr " << osr << " already has running"
+		   << dendl;
+	}
       } else {
 	osr->deferred_lock.unlock();
-	dout(20) << __func__ << "  osr " << osr << " already has running"
-		 << dendl;
+	dout(20) << __func__ << "  osr " << osr << " has no pending" << dendl;
       }
-    } else {
-      osr->deferred_lock.unlock();
-      dout(20) << __func__ << "  osr " << osr << " has no pending" << dendl;
     }
   }
 
@@ -12550,6 +14211,86 @@ void BlueStore::_deferred_submit_unlock(OpSequencer *osr)
   bdev->aio_submit(&b->ioc);
 }
 
+void BlueStore::_deferred_submit_aggregate(vector<OpSequencerRef>& osrs)
+{
+  auto g = new DeferredGroup(cct);
+  for (auto& osr : osrs) {
+    osr->deferred_lock.lock();
+    if (!osr->deferred_pending || osr->deferred_running) {
+      osr->deferred_lock.unlock();
+      dout(20) << __func__ << "  osr " << osr << " has no pending or"
+	       << " already has running" << dendl;
+      continue;
+    }
+    auto b = osr->deferred_pending;
+    deferred_queue_size -= b->seq_bytes.size();
+    ceph_assert(deferred_queue_size >= 0);
+    osr->deferred_running = b;
+    osr->deferred_pending = nullptr;
+    osr->deferred_lock.unlock();
+    g->batches.push_back(b);
+  }
+  if (g->batches.empty()) {
+    delete g;
+    return;
+  }
+
+  // the extents of pending deferred writes stay allocated until the
+  // writes complete, so batches of different sequencers never overlap.
+  std::map<uint64_t, bufferlist*> ios;
+  for (auto b : g->batches) {
+    for (auto& txc : b->txcs) {
+      throttle.log_state_latency(txc, logger,
+				 l_bluestore_state_deferred_queued_lat);
+    }
+    for (auto& i : b->iomap) {
+      auto r = ios.emplace(i.first, &i.second.bl);
+      ceph_assert(r.second);
+    }
+  }
+  dout(10) << __func__ << " " << g->batches.size() << " batches, "
+	   << ios.size() << " extents" << dendl;
+
+  uint64_t max_write =
+    cct->_conf.get_val<Option::size_t>("bluestore_deferred_aggregate_max_write");
+  uint64_t start = 0, pos = 0, total = 0;
+  bufferlist bl;
+  auto i = ios.begin();
+  while (true) {
+    if (i == ios.end() || i->first != pos ||
+	(max_write && bl.length() + i->second->length() > max_write)) {
+      if (bl.length()) {
+	dout(20) << __func__ << " write 0x" << std::hex
+		 << start << "~" << bl.length() << std::dec << dendl;
+	total += bl.length();
+	if (!g_conf()->bluestore_debug_omit_block_device_write) {
+	  logger->inc(l_bluestore_deferred_write_ops);
+	  logger->inc(l_bluestore_deferred_write_bytes, bl.length());
+	  int r = bdev->aio_write(start, bl, &g->ioc, false);
+	  ceph_assert(r == 0);
+	}
+      }
+      if (i == ios.end()) {
+	break;
+      }
+      ceph_assert(i->first >= pos);
+      pos = i->first;
+      bl.clear();
+    }
+    if (!bl.length()) {
+      start = pos;
+    }
+    pos += i->second->length();
+    bl.claim_append(*i->second);
+    ++i;
+  }
+  logger->inc(l_bluestore_deferred_aggregate_batches, g->batches.size());
+  logger->inc(l_bluestore_deferred_aggregate_extents, ios.size());
+  logger->inc(l_bluestore_deferred_aggregate_bytes, total);
+
+  bdev->aio_submit(&g->ioc);
+}
+
 struct C_DeferredTrySubmit : public Context {
   BlueStore *store;
   C_DeferredTrySubmit(BlueStore *s) : store(s) {}
@@ -12581,7 +14322,7 @@ void BlueStore::_deferred_aio_finish(OpSequencer *osr)
       osr->deferred_lock.unlock();
       if (deferred_aggressive) {
 	dout(20) << __func__ << " queuing async deferred_try_submit" << dendl;
-	finisher.queue(new C_DeferredTrySubmit(this));
+	finisher.queue(osr, new C_DeferredTrySubmit(this));
       } else {
 	dout(20) << __func__ << " leaving queued, more pending" << dendl;
       }
@@ -12676,6 +14417,10 @@ int BlueStore::queue_transactions(
 
   auto start = mono_clock::now();
 
+  if (txn_trace) {
+    txn_trace->record(tls);
+  }
+
   Collection *c = static_cast<Collection*>(ch.get());
   OpSequencer *osr = c->osr.get();
   dout(10) << __func__ << " ch " << c << " " << c->cid << dendl;
@@ -12766,7 +14511,7 @@ int BlueStore::queue_transactions(
     if (c->commit_queue) {
       c->commit_queue->queue(on_applied);
     } else {
-      finisher.queue(on_applied);
+      finisher.queue(txc->osr.get(), on_applied);
     }
   }
 
@@ -13922,6 +15667,168 @@ void BlueStore::_do_write_big(
   }
 }
 
+// estimate the entropy of bl, in bits per byte, from the bytes of a few
+// short runs spread evenly over it
+static double estimate_entropy(const bufferlist& bl)
+{
+  constexpr unsigned SAMPLES = 64;
+  constexpr unsigned SAMPLE_LEN = 64;
+  const unsigned stride = std::max(bl.length() / SAMPLES, 1u);
+  const unsigned want = std::min(stride, SAMPLE_LEN);
+  std::array<uint32_t, 256> hist = {};
+  unsigned total = 0;
+  auto p = bl.cbegin();
+  while (!p.end()) {
+    const char *data;
+    size_t l = p.get_ptr_and_advance(want, &data);
+    for (size_t i = 0; i < l; ++i) {
+      ++hist[(unsigned char)data[i]];
+    }
+    total += l;
+    if (p.get_remaining() <= stride - l) {
+      break;
+    }
+    p += stride - l;
+  }
+  if (!total) {
+    return 0;
+  }
+  double entropy = 0;
+  for (auto n : hist) {
+    if (n) {
+      double f = (double)n / total;
+      entropy -= f * std::log2(f);
+    }
+  }
+  return entropy;
+}
+
+void BlueStore::_do_compress_blob(
+  CompressorRef& c,
+  const Compressor::Dictionary* dict,
+  double crr,
+  WriteContext::write_item& wi)
+{
+  auto start = mono_clock::now();
+
+  // compress
+  ceph_assert(wi.b_off == 0);
+  ceph_assert(wi.blob_length == wi.bl.length());
+
+  double max_entropy = cct->_conf->bluestore_compression_max_entropy;
+  if (max_entropy < 8) {
+    double entropy = estimate_entropy(wi.bl);
+    if (entropy > max_entropy) {
+      dout(20) << __func__ << std::hex << "  0x" << wi.blob_length << std::dec
+	       << " bytes with an estimated entropy of " << entropy
+	       << " bits per byte, leaving uncompressed" << dendl;
+      logger->inc(l_bluestore_compress_skipped_count);
+      return;
+    }
+  }
+
+  // FIXME: memory alignment here is bad
+  bufferlist t;
+  boost::optional<int32_t> compressor_message;
+  int r;
+  if (dict && wi.blob_length <=
+      cct->_conf->bluestore_compression_dictionary_max_blob_size) {
+    r = c->compress_with_dictionary(wi.bl, t, compressor_message, *dict);
+  } else {
+    r = c->compress(wi.bl, t, compressor_message);
+  }
+  uint64_t want_len_raw = wi.blob_length * crr;
+  uint64_t want_len = p2roundup(want_len_raw, min_alloc_size);
+  bool rejected = false;
+  uint64_t compressed_len = t.length();
+  // do an approximate (fast) estimation for resulting blob size
+  // that doesn't take header overhead  into account
+  uint64_t result_len = p2roundup(compressed_len, min_alloc_size);
+  if (r == 0 && result_len <= want_len && result_len < wi.blob_length) {
+    bluestore_compression_header_t chdr;
+    chdr.type = c->get_type();
+    chdr.length = t.length();
+    chdr.compressor_message = compressor_message;
+    encode(chdr, wi.compressed_bl);
+    wi.compressed_bl.claim_append(t);
+
+    compressed_len = wi.compressed_bl.length();
+    result_len = p2roundup(compressed_len, min_alloc_size);
+    if (result_len <= want_len && result_len < wi.blob_length) {
+      // Cool. We compressed at least as much as we were hoping to.
+      // pad out to min_alloc_size
+      wi.compressed_bl.append_zero(result_len - compressed_len);
+      wi.compressed_len = compressed_len;
+      wi.compressed = true;
+      logger->inc(l_bluestore_write_pad_bytes, result_len - compressed_len);
+      dout(20) << __func__ << std::hex << "  compressed 0x" << wi.blob_length
+	       << " -> 0x" << compressed_len << " => 0x" << result_len
+	       << " with " << c->get_type()
+	       << std::dec << dendl;
+      logger->inc(l_bluestore_compress_success_count);
+    } else {
+      rejected = true;
+    }
+  } else if (r != 0) {
+    dout(5) << __func__ << std::hex << "  0x" << wi.blob_length
+	     << " bytes compressed using " << c->get_type_name()
+	     << std::dec
+	     << " failed with errcode = " << r
+	     << ", leaving uncompressed"
+	     << dendl;
+    logger->inc(l_bluestore_compress_rejected_count);
+  } else {
+    rejected = true;
+  }
+
+  if (rejected) {
+    dout(20) << __func__ << std::hex << "  0x" << wi.blob_length
+	     << " compressed to 0x" << compressed_len << " -> 0x" << result_len
+	     << " with " << c->get_type()
+	     << ", which is more than required 0x" << want_len_raw
+	     << " -> 0x" << want_len
+	     << ", leaving uncompressed"
+	     << std::dec << dendl;
+    logger->inc(l_bluestore_compress_rejected_count);
+  }
+  log_latency("compress@_do_alloc_write",
+    l_bluestore_compress_lat,
+    mono_clock::now() - start,
+    cct->_conf->bluestore_log_op_age );
+}
+
+void BlueStore::_compress_blobs(
+  CompressorRef& c,
+  const Compressor::Dictionary* dict,
+  double crr,
+  const std::vector<WriteContext::write_item*>& items)
+{
+  if (items.size() < 2 || !compress_wq) {
+    for (auto wi : items) {
+      _do_compress_blob(c, dict, crr, *wi);
+    }
+    return;
+  }
+  // hand all but the first blob to the compression threads, compress
+  // that one here and wait for the others
+  ceph::mutex lock = ceph::make_mutex("BlueStore::_compress_blobs::lock");
+  ceph::condition_variable cond;
+  size_t pending = items.size() - 1;
+  for (size_t i = 1; i < items.size(); ++i) {
+    compress_wq->queue(new LambdaContext(
+      [this, &c, dict, crr, wi = items[i], &lock, &cond, &pending](int) {
+	_do_compress_blob(c, dict, crr, *wi);
+	std::lock_guard l{lock};
+	if (--pending == 0) {
+	  cond.notify_all();
+	}
+      }));
+  }
+  _do_compress_blob(c, dict, crr, *items[0]);
+  std::unique_lock l{lock};
+  cond.wait(l, [&pending] { return pending == 0; });
+}
+
 int BlueStore::_do_alloc_write(
   TransContext *txc,
   CollectionRef coll,
@@ -13990,92 +15897,75 @@ int BlueStore::_do_alloc_write(
   // compress (as needed) and calc needed space
   uint64_t need = 0;
   auto max_bsize = std::max(wctx->target_blob_size, min_alloc_size);
+  std::vector<WriteContext::write_item*> to_compress;
+  bool skip_compress = false;
+  if (c && o->compress_skips) {
+    // its last writes did not compress, do not try this one
+    --o->compress_skips;
+    skip_compress = true;
+  }
   for (auto& wi : wctx->writes) {
     if (c && wi.blob_length > min_alloc_size) {
-      auto start = mono_clock::now();
-
-      // compress
-      ceph_assert(wi.b_off == 0);
-      ceph_assert(wi.blob_length == wi.bl.length());
-
-      // FIXME: memory alignment here is bad
-      bufferlist t;
-      boost::optional<int32_t> compressor_message;
-      int r = c->compress(wi.bl, t, compressor_message);
-      uint64_t want_len_raw = wi.blob_length * crr;
-      uint64_t want_len = p2roundup(want_len_raw, min_alloc_size);
-      bool rejected = false;
-      uint64_t compressed_len = t.length();
-      // do an approximate (fast) estimation for resulting blob size
-      // that doesn't take header overhead  into account
-      uint64_t result_len = p2roundup(compressed_len, min_alloc_size);
-      if (r == 0 && result_len <= want_len && result_len < wi.blob_length) {
-	bluestore_compression_header_t chdr;
-	chdr.type = c->get_type();
-	chdr.length = t.length();
-	chdr.compressor_message = compressor_message;
-	encode(chdr, wi.compressed_bl);
-	wi.compressed_bl.claim_append(t);
-
-	compressed_len = wi.compressed_bl.length();
-	result_len = p2roundup(compressed_len, min_alloc_size);
-	if (result_len <= want_len && result_len < wi.blob_length) {
-	  // Cool. We compressed at least as much as we were hoping to.
-	  // pad out to min_alloc_size
-	  wi.compressed_bl.append_zero(result_len - compressed_len);
-	  wi.compressed_len = compressed_len;
-	  wi.compressed = true;
-	  logger->inc(l_bluestore_write_pad_bytes, result_len - compressed_len);
-	  dout(20) << __func__ << std::hex << "  compressed 0x" << wi.blob_length
-		   << " -> 0x" << compressed_len << " => 0x" << result_len
-		   << " with " << c->get_type()
-		   << std::dec << dendl;
-	  txc->statfs_delta.compressed() += compressed_len;
-	  txc->statfs_delta.compressed_original() += wi.blob_length;
-	  txc->statfs_delta.compressed_allocated() += result_len;
-	  logger->inc(l_bluestore_compress_success_count);
-	  need += result_len;
-	} else {
-	  rejected = true;
-	}
-      } else if (r != 0) {
-	dout(5) << __func__ << std::hex << "  0x" << wi.blob_length
-		 << " bytes compressed using " << c->get_type_name()
-		 << std::dec
-		 << " failed with errcode = " << r
-		 << ", leaving uncompressed"
-		 << dendl;
-	logger->inc(l_bluestore_compress_rejected_count);
-	need += wi.blob_length;
-      } else {
-	rejected = true;
-      }
-
-      if (rejected) {
-	dout(20) << __func__ << std::hex << "  0x" << wi.blob_length
-		 << " compressed to 0x" << compressed_len << " -> 0x" << result_len
-		 << " with " << c->get_type()
-		 << ", which is more than required 0x" << want_len_raw
-		 << " -> 0x" << want_len
-		 << ", leaving uncompressed"
-		 << std::dec << dendl;
-	logger->inc(l_bluestore_compress_rejected_count);
+      if (skip_compress) {
+	logger->inc(l_bluestore_compress_skipped_count);
 	need += wi.blob_length;
+	continue;
       }
-      log_latency("compress@_do_alloc_write",
-	l_bluestore_compress_lat,
-        mono_clock::now() - start,
-	cct->_conf->bluestore_log_op_age );
+      to_compress.push_back(&wi);
     } else {
       need += wi.blob_length;
     }
   }
+  const Compressor::Dictionary* dict = nullptr;
+  if (c && coll->compression_dict &&
+      coll->compression_dict->get_type() == c->get_type()) {
+    dict = coll->compression_dict.get();
+  }
+  _compress_blobs(c, dict, crr, to_compress);
+  if (!to_compress.empty()) {
+    uint64_t max_rejects = cct->_conf->bluestore_compression_max_rejects;
+    bool any = std::any_of(to_compress.begin(), to_compress.end(),
+			   [](auto wi) { return wi->compressed; });
+    if (any || !max_rejects) {
+      o->compress_rejects = 0;
+    } else if (++o->compress_rejects >= max_rejects) {
+      // back off, twice as long after each failed attempt
+      unsigned shift = std::min<uint64_t>(o->compress_rejects - max_rejects, 6);
+      o->compress_skips = 1u << shift;
+      dout(20) << __func__ << " " << o->oid << " " << o->compress_rejects
+	       << " writes in a row not compressed, skipping the next "
+	       << o->compress_skips << dendl;
+      if (o->compress_rejects > max_rejects + 6) {
+	o->compress_rejects = max_rejects + 6;
+      }
+    }
+  }
+  for (auto wi : to_compress) {
+    if (wi->compressed) {
+      uint64_t result_len = wi->compressed_bl.length();
+      txc->statfs_delta.compressed() += wi->compressed_len;
+      txc->statfs_delta.compressed_original() += wi->blob_length;
+      txc->statfs_delta.compressed_allocated() += result_len;
+      need += result_len;
+    } else {
+      need += wi->blob_length;
+    }
+  }
+  // keep the data of a collection together, apart by expected lifetime
+  auto lifetime = Allocator::lifetime_t::unknown;
+  if (o->onode.alloc_hint_flags & CEPH_OSD_ALLOC_HINT_FLAG_SHORTLIVED) {
+    lifetime = Allocator::lifetime_t::short_lived;
+  } else if (o->onode.alloc_hint_flags & (CEPH_OSD_ALLOC_HINT_FLAG_LONGLIVED |
+					  CEPH_OSD_ALLOC_HINT_FLAG_IMMUTABLE)) {
+    lifetime = Allocator::lifetime_t::long_lived;
+  }
   PExtentVector prealloc;
   prealloc.reserve(2 * wctx->writes.size());;
   int64_t prealloc_left = 0;
-  prealloc_left = shared_alloc.a->allocate(
+  prealloc_left = shared_alloc.a->allocate_stream(
+    std::hash<coll_t>{}(coll->cid), lifetime,
     need, min_alloc_size, need,
-    0, &prealloc);
+    &prealloc);
   if (prealloc_left < 0 || prealloc_left < (int64_t)need) {
     derr << __func__ << " failed to allocate 0x" << std::hex << need
          << " allocated 0x " << (prealloc_left < 0 ? 0 : prealloc_left)
@@ -15980,28 +17870,9 @@ void BlueStore::_record_onode(OnodeRef &o, KeyValueDB::Transaction &txn)
     logger->inc(l_bluestore_onode_reshard);
   }
 
-  // bound encode
-  size_t bound = 0;
-  denc(o->onode, bound);
-  o->extent_map.bound_encode_spanning_blobs(bound);
-  if (o->onode.extent_map_shards.empty()) {
-    denc(o->extent_map.inline_bl, bound);
-  }
-
-  // encode
   bufferlist bl;
   unsigned onode_part, blob_part, extent_part;
-  {
-    auto p = bl.get_contiguous_appender(bound, true);
-    denc(o->onode, p);
-    onode_part = p.get_logical_offset();
-    o->extent_map.encode_spanning_blobs(p);
-    blob_part = p.get_logical_offset() - onode_part;
-    if (o->onode.extent_map_shards.empty()) {
-      denc(o->extent_map.inline_bl, p);
-    }
-    extent_part = p.get_logical_offset() - onode_part - blob_part;
-  }
+  o->encode_value(bl, &onode_part, &blob_part, &extent_part);
 
   dout(20) << __func__  << " onode " << o->oid << " is " << bl.length()
 	    << " (" << onode_part << " bytes onode + "
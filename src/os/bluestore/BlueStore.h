@@ -47,6 +47,7 @@
 #include "common/PriorityCache.h"
 #include "compressor/Compressor.h"
 #include "os/ObjectStore.h"
+#include "os/TransactionTrace.h"
 
 #include "bluestore_types.h"
 #include "BlueFS.h"
@@ -97,9 +98,13 @@ enum {
   l_bluestore_csum_lat,
   l_bluestore_compress_success_count,
   l_bluestore_compress_rejected_count,
+  l_bluestore_compress_skipped_count,
   l_bluestore_write_pad_bytes,
   l_bluestore_deferred_write_ops,
   l_bluestore_deferred_write_bytes,
+  l_bluestore_deferred_aggregate_batches,
+  l_bluestore_deferred_aggregate_extents,
+  l_bluestore_deferred_aggregate_bytes,
   l_bluestore_write_penalty_read_ops,
   l_bluestore_allocated,
   l_bluestore_stored,
@@ -108,8 +113,12 @@ enum {
   l_bluestore_compressed_original,
   l_bluestore_onodes,
   l_bluestore_pinned_onodes,
+  l_bluestore_encoded_onodes,
+  l_bluestore_encoded_onode_bytes,
+  l_bluestore_encoded_onode_hits,
   l_bluestore_onode_hits,
   l_bluestore_onode_misses,
+  l_bluestore_onode_prefetched,
   l_bluestore_onode_shard_hits,
   l_bluestore_onode_shard_misses,
   l_bluestore_extents,
@@ -118,6 +127,8 @@ enum {
   l_bluestore_buffer_bytes,
   l_bluestore_buffer_hit_bytes,
   l_bluestore_buffer_miss_bytes,
+  l_bluestore_buffer_seq_hit_bytes,
+  l_bluestore_buffer_seq_miss_bytes,
   l_bluestore_write_big,
   l_bluestore_write_big_bytes,
   l_bluestore_write_big_blobs,
@@ -164,6 +175,8 @@ public:
 
   void _set_csum();
   void _set_compression();
+  Compressor::DictionaryRef _load_compression_dicts(const pool_opts_t& opts);
+  Compressor::DictionaryRef _get_compression_dict(uint32_t id);
   void _set_throttle_params();
   int _set_cache_sizes();
   void _set_max_defer_interval() {
@@ -278,6 +291,7 @@ public:
   struct BufferSpace {
     enum {
       BYPASS_CLEAN_CACHE = 0x1,  // bypass clean cache
+      SEQUENTIAL_READ = 0x2,     // part of a scan, hits are not reuse
     };
 
     typedef boost::intrusive::list<
@@ -1081,6 +1095,11 @@ public:
                               /// (or should be pinned when cached)
     ExtentMap extent_map;
 
+    /// writes in a row left uncompressed, and writes still to be left
+    /// uncompressed without trying (in memory only, under the collection lock)
+    uint16_t compress_rejects = 0;
+    uint16_t compress_skips = 0;
+
     // track txc's that have not been committed to kv store (and whose
     // effects cannot be read via the kvdb read methods)
     std::atomic<int> flushing_count = {0};
@@ -1128,6 +1147,12 @@ public:
       const ghobject_t& oid,
       const std::string& key,
       const ceph::buffer::list& v);
+    /// encode the value stored under PREFIX_OBJ: onode, spanning blobs
+    /// and, if the extent map is not sharded, the inline extents
+    void encode_value(ceph::buffer::list& bl,
+		      unsigned *onode_part = nullptr,
+		      unsigned *blob_part = nullptr,
+		      unsigned *extent_part = nullptr);
 
     void dump(ceph::Formatter* f) const;
 
@@ -1218,10 +1243,39 @@ public:
 #endif
   };
 
+  /// a cold onode kept in its encoded (kv value) form
+  struct EncodedOnode {
+    MEMPOOL_CLASS_HELPERS();
+
+    OnodeSpace *space;
+    ghobject_t oid;
+    ceph::buffer::list bl;
+    boost::intrusive::list_member_hook<> lru_item;
+
+    EncodedOnode(OnodeSpace *s, const ghobject_t& o, ceph::buffer::list&& v)
+      : space(s), oid(o), bl(std::move(v)) {}
+
+    uint64_t get_bytes() const {
+      return sizeof(*this) + bl.length();
+    }
+  };
+
   /// A Generic onode Cache Shard
   struct OnodeCacheShard : public CacheShard {
     std::atomic<uint64_t> num_pinned = {0};
 
+    /// trimmed onodes that are still kept encoded, most recent first
+    typedef boost::intrusive::list<
+      EncodedOnode,
+      boost::intrusive::member_hook<
+	EncodedOnode,
+	boost::intrusive::list_member_hook<>,
+	&EncodedOnode::lru_item> > encoded_list_t;
+    encoded_list_t encoded_lru;
+    std::atomic<uint64_t> encoded_max_bytes = {0};
+    std::atomic<uint64_t> num_encoded = {0};
+    std::atomic<uint64_t> encoded_bytes = {0};
+
     std::array<std::pair<ghobject_t, ceph::mono_clock::time_point>, 64> dumped_onodes;
 
     virtual void _pin(Onode* o) = 0;
@@ -1237,9 +1291,23 @@ public:
 
     virtual void move_pinned(OnodeCacheShard *to, Onode *o) = 0;
     virtual void add_stats(uint64_t *onodes, uint64_t *pinned_onodes) = 0;
+    /// the @p max most recently used onodes
+    virtual void _get_hot(size_t max,
+      std::vector<std::pair<coll_t, ghobject_t>>* hot) = 0;
     bool empty() {
       return _get_num() == 0;
     }
+
+    void set_encoded_max_bytes(uint64_t bytes) {
+      encoded_max_bytes = bytes;
+    }
+    void _add_encoded(EncodedOnode *e);
+    void _rm_encoded(EncodedOnode *e);
+    void _trim_encoded();
+    void add_encoded_stats(uint64_t *onodes, uint64_t *bytes) {
+      *onodes += num_encoded;
+      *bytes += encoded_bytes;
+    }
   };
 
   /// A Generic buffer Cache Shard
@@ -1293,11 +1361,17 @@ public:
   private:
     /// forward lookups
     mempool::bluestore_cache_meta::unordered_map<ghobject_t,OnodeRef> onode_map;
+    /// onodes trimmed from the cache that are kept encoded
+    mempool::bluestore_cache_encoded_onode::unordered_map<
+      ghobject_t,EncodedOnode*> encoded_map;
 
     friend struct Collection; // for split_cache()
     friend struct Onode; // for put()
+    friend struct OnodeCacheShard; // for _trim_encoded()
     friend struct LruOnodeCacheShard;
     void _remove(const ghobject_t& oid);
+    void _stash_encoded(Onode *o);
+    void _drop_encoded(const ghobject_t& oid);
   public:
     OnodeSpace(OnodeCacheShard *c) : cache(c) {}
     ~OnodeSpace() {
@@ -1306,6 +1380,9 @@ public:
 
     OnodeRef add(const ghobject_t& oid, OnodeRef& o);
     OnodeRef lookup(const ghobject_t& o);
+    bool contains(const ghobject_t& oid);
+    /// take the encoded copy of a trimmed onode, if we kept one
+    bool lookup_encoded(const ghobject_t& oid, ceph::buffer::list *v);
     void rename(OnodeRef& o, const ghobject_t& old_oid,
 		const ghobject_t& new_oid,
 		const mempool::bluestore_cache_meta::string& new_okey);
@@ -1338,8 +1415,21 @@ public:
     // contention.
     OnodeSpace onode_map;
 
+    /// range of the last listing, and how many of its objects were
+    /// accessed since, until that is enough to prefetch the next one
+    ceph::mutex listed_lock =
+      ceph::make_mutex("BlueStore::Collection::listed_lock");
+    ghobject_t listed_first, listed_last;
+    std::atomic<bool> listed = {false};
+    std::atomic<uint32_t> listed_accessed = {0};
+
+    /// record the listing @p ls, return true to prefetch its onodes
+    bool note_listed(const std::vector<ghobject_t>& ls);
+
     //pool options
     pool_opts_t pool_opts;
+    /// dictionary to compress small blobs with, from pool_opts
+    Compressor::DictionaryRef compression_dict;
     ContextQueue *commit_queue;
 
     OnodeCacheShard* get_onode_cache() const {
@@ -1796,6 +1886,9 @@ public:
     bool should_submit_deferred() {
       return throttle_deferred_bytes.past_midpoint();
     }
+    bool kv_past_midpoint() {
+      return throttle_bytes.past_midpoint();
+    }
     void reset_throttle(const ConfigProxy &conf) {
       throttle_bytes.reset_max(conf->bluestore_throttle_bytes);
       throttle_deferred_bytes.reset_max(
@@ -1843,6 +1936,23 @@ public:
     }
   };
 
+  /// deferred batches of several OpSequencers that are submitted as one
+  /// set of sorted, coalesced ios (see bluestore_deferred_aggregate)
+  struct DeferredGroup final : public AioContext {
+    std::vector<DeferredBatch*> batches;
+    IOContext ioc;
+
+    explicit DeferredGroup(CephContext *cct)
+      : ioc(cct, this) {}
+
+    void aio_finish(BlueStore *store) override {
+      for (auto b : batches) {
+	store->_deferred_aio_finish(b->osr);
+      }
+      delete this;
+    }
+  };
+
   class OpSequencer : public RefCountedObject {
   public:
     ceph::mutex qlock = ceph::make_mutex("BlueStore::OpSequencer::qlock");
@@ -1996,6 +2106,56 @@ public:
     }
   };
 
+  /// an additional kv commit lane (see bluestore_kv_sync_lanes).  lane 0
+  /// is the kv_sync_thread/kv_finalize_thread pair, which also owns the
+  /// deferred write cleanup; the other lanes only commit and finalize
+  /// the txcs of the OpSequencers mapped to them.
+  struct KVSyncLane {
+    struct SyncThread : public Thread {
+      BlueStore *store;
+      KVSyncLane *lane;
+      SyncThread(BlueStore *s, KVSyncLane *l) : store(s), lane(l) {}
+      void *entry() override {
+	store->_kv_lane_sync_thread(lane);
+	return NULL;
+      }
+    };
+    struct FinalizeThread : public Thread {
+      BlueStore *store;
+      KVSyncLane *lane;
+      FinalizeThread(BlueStore *s, KVSyncLane *l) : store(s), lane(l) {}
+      void *entry() override {
+	store->_kv_lane_finalize_thread(lane);
+	return NULL;
+      }
+    };
+
+    const unsigned id;
+    SyncThread sync_thread;
+    FinalizeThread finalize_thread;
+
+    ceph::mutex lock = ceph::make_mutex("BlueStore::KVSyncLane::lock");
+    ceph::condition_variable cond;
+    bool started = false;
+    bool stop = false;
+    bool in_progress = false;
+    std::deque<TransContext*> queue;             ///< ready, already submitted
+    std::deque<TransContext*> queue_unsubmitted; ///< ready, need submit by lane
+    uint64_t ios = 0;
+    uint64_t throttle_costs = 0;
+
+    ceph::mutex finalize_lock =
+      ceph::make_mutex("BlueStore::KVSyncLane::finalize_lock");
+    ceph::condition_variable finalize_cond;
+    bool finalize_started = false;
+    bool finalize_stop = false;
+    bool finalize_in_progress = false;
+    std::deque<TransContext*> committing_to_finalize; ///< pending finalization
+
+    KVSyncLane(BlueStore *s, unsigned i)
+      : id(i), sync_thread(s, this), finalize_thread(s, this) {}
+  };
+
 #ifdef HAVE_LIBZBD
   struct ZonedCleanerThread : public Thread {
     BlueStore *store;
@@ -2039,6 +2199,7 @@ private:
   KeyValueDB *db = nullptr;
   BlockDevice *bdev = nullptr;
   std::string freelist_type;
+  bool null_freelist = false;  ///< allocator state is saved at umount instead
   FreelistManager *fm = nullptr;
 
   bluefs_shared_alloc_context_t shared_alloc;
@@ -2073,9 +2234,13 @@ private:
   deferred_osr_queue_t deferred_queue; ///< osr's with deferred io pending
   std::atomic_int deferred_queue_size = {0};         ///< num txc's queued across all osrs
   std::atomic_int deferred_aggressive = {0}; ///< aggressive wakeup of kv thread
-  Finisher  finisher;
+  ShardedFinisher finisher; ///< by OpSequencer
   utime_t  deferred_last_submitted = utime_t();
 
+  /// compresses the blobs of a write in parallel, see _compress_blobs()
+  std::unique_ptr<ThreadPool> compress_tp;
+  std::unique_ptr<ContextWQ> compress_wq;
+
   KVSyncThread kv_sync_thread;
   ceph::mutex kv_lock = ceph::make_mutex("BlueStore::kv_lock");
   ceph::condition_variable kv_cond;
@@ -2097,6 +2262,13 @@ private:
   std::deque<DeferredBatch*> deferred_stable_to_finalize; ///< pending finalization
   bool kv_finalize_in_progress = false;
 
+  std::vector<std::unique_ptr<KVSyncLane>> kv_lanes; ///< lanes 1..n-1
+
+  /// serializes {nid,blobid}_max preallocation across kv lanes
+  ceph::mutex kv_id_lock = ceph::make_mutex("BlueStore::kv_id_lock");
+  uint64_t kv_nid_reserved = 0;    ///< highest nid_max submitted to the kv
+  uint64_t kv_blobid_reserved = 0; ///< highest blobid_max submitted to the kv
+
 #ifdef HAVE_LIBZBD
   ZonedCleanerThread zoned_cleaner_thread;
   ceph::mutex zoned_cleaner_lock = ceph::make_mutex("BlueStore::zoned_cleaner_lock");
@@ -2106,9 +2278,17 @@ private:
   std::deque<uint64_t> zoned_cleaner_queue;
 #endif
 
+  /// loads back the onodes hot at the last umount
+  std::thread onode_warmup_thread;
+  std::atomic<bool> onode_warmup_stop = {false};
+
+  /// the transactions queued while mounted, see bluestore_trace_file
+  std::unique_ptr<ceph::os::TransactionTraceWriter> txn_trace;
+
   PerfCounters *logger = nullptr;
 
-  std::list<CollectionRef> removed_collections;
+  ceph::mutex reap_lock = ceph::make_mutex("BlueStore::reap_lock");
+  std::list<CollectionRef> removed_collections; ///< protected by reap_lock
 
   ceph::shared_mutex debug_read_error_lock =
     ceph::make_shared_mutex("BlueStore::debug_read_error_lock");
@@ -2153,6 +2333,13 @@ private:
   std::atomic<uint64_t> comp_min_blob_size = {0};
   std::atomic<uint64_t> comp_max_blob_size = {0};
 
+  /// the dictionaries of every pool seen since mount; they are never
+  /// dropped, blobs compressed with a rotated out one remain readable
+  ceph::mutex compression_dicts_lock =
+    ceph::make_mutex("BlueStore::compression_dicts_lock");
+  std::map<std::string, Compressor::DictionaryRef> compression_dicts_by_text;
+  std::map<uint32_t, Compressor::DictionaryRef> compression_dicts;
+
   std::atomic<uint64_t> max_blob_size = {0};  ///< maximum blob size
 
   uint64_t kv_ios = 0;
@@ -2165,6 +2352,7 @@ private:
   double cache_kv_onode_ratio = 0; ///< cache ratio dedicated to kv onodes (e.g., rocksdb onode CF)
   double cache_data_ratio = 0;   ///< cache ratio dedicated to object data
   bool cache_autotune = false;   ///< cache autotune setting
+  bool cache_autotune_hit_gain = false; ///< autotune by estimated hit gains
   double cache_autotune_interval = 0; ///< time to wait between cache rebalancing
   uint64_t osd_memory_target = 0;   ///< OSD memory target when autotuning cache
   uint64_t osd_memory_base = 0;     ///< OSD base memory when autotuning cache
@@ -2198,6 +2386,8 @@ private:
       int64_t cache_bytes[PriorityCache::Priority::LAST+1] = {0};
       int64_t committed_bytes = 0;
       double cache_ratio = 0;
+      std::atomic<bool> mrc_enabled = {false};
+      PriorityCache::MissRatioCurve mrc;
 
       MempoolCache(BlueStore *s) : store(s) {};
 
@@ -2252,12 +2442,30 @@ private:
       virtual void set_cache_ratio(double ratio) {
         cache_ratio = ratio;
       }
+      virtual void set_miss_ratio_curve_enabled(bool enabled) {
+        if (!enabled) {
+          mrc.reset();
+        }
+        mrc_enabled = enabled;
+      }
+      virtual PriorityCache::MissRatioCurve* get_miss_ratio_curve() {
+        return mrc_enabled ? &mrc : nullptr;
+      }
       virtual std::string get_cache_name() const = 0;
     };
 
     struct MetaCache : public MempoolCache {
+      /// as of the last resize of the shards
+      std::atomic<uint64_t> bytes_per_onode = {0};
+
       MetaCache(BlueStore *s) : MempoolCache(s) {};
 
+      void note_access(const ghobject_t& oid) {
+        if (mrc_enabled) {
+          mrc.access(std::hash<ghobject_t>()(oid), bytes_per_onode);
+        }
+      }
+
       virtual uint64_t _get_used_bytes() const {
         return mempool::bluestore_Buffer::allocated_bytes() +
           mempool::bluestore_Blob::allocated_bytes() +
@@ -2266,7 +2474,8 @@ private:
           mempool::bluestore_cache_other::allocated_bytes() +
 	   mempool::bluestore_cache_onode::allocated_bytes() +
           mempool::bluestore_SharedBlob::allocated_bytes() +
-          mempool::bluestore_inline_bl::allocated_bytes();
+          mempool::bluestore_inline_bl::allocated_bytes() +
+          mempool::bluestore_cache_encoded_onode::allocated_bytes();
       }
 
       virtual std::string get_cache_name() const {
@@ -2279,8 +2488,11 @@ private:
         return (2 > onode_num) ? 2 : onode_num;
       }
 
+      /// bytes per decoded onode; the encoded tier is budgeted separately
       double get_bytes_per_onode() const {
-        return (double)_get_used_bytes() / (double)_get_num_onodes();
+        return (double)(_get_used_bytes() -
+			mempool::bluestore_cache_encoded_onode::allocated_bytes()) /
+	  (double)_get_num_onodes();
       }
     };
     std::shared_ptr<MetaCache> meta_cache;
@@ -2288,6 +2500,18 @@ private:
     struct DataCache : public MempoolCache {
       DataCache(BlueStore *s) : MempoolCache(s) {};
 
+      void note_access(const ghobject_t& oid, uint64_t offset,
+                       uint64_t length) {
+        if (!mrc_enabled) {
+          return;
+        }
+        uint64_t h = std::hash<ghobject_t>()(oid);
+        uint64_t bs = store->block_size;
+        for (uint64_t b = offset / bs; b * bs < offset + length; ++b) {
+          mrc.access(h + b * 0x9e3779b97f4a7c15ull, bs);
+        }
+      }
+
       virtual uint64_t _get_used_bytes() const {
         uint64_t bytes = 0;
         for (auto i : store->buffer_cache_shards) {
@@ -2388,9 +2612,17 @@ private:
   int _create_alloc();
   int _init_alloc();
   void _close_alloc();
+  // with a null freelist
+  int _restore_allocator_from_file(uint64_t* num, uint64_t* bytes);
+  int _restore_allocator_from_onodes(uint64_t* num, uint64_t* bytes);
+  int _store_allocator_to_file();
+  void _remove_allocator_file();
   int _open_collections();
   void _fsck_collections(int64_t* errors);
   void _close_collections();
+  void _save_hot_onodes();
+  void _onode_warmup_start();
+  void _onode_warmup_stop();
 
   int _setup_block_symlink_or_file(std::string name, std::string path, uint64_t size,
 				   bool create);
@@ -2471,12 +2703,23 @@ private:
   void _kv_stop();
   void _kv_sync_thread();
   void _kv_finalize_thread();
+  KVSyncLane *_kv_lane_for(OpSequencer *osr);
+  void _kv_reserve_ids(KeyValueDB::Transaction t,
+		       std::unique_lock<ceph::mutex>& idl,
+		       uint64_t *new_nid_max,
+		       uint64_t *new_blobid_max);
+  void _kv_publish_ids(uint64_t new_nid_max, uint64_t new_blobid_max);
+  void _kv_lane_sync_thread(KVSyncLane *lane);
+  void _kv_lane_finalize_thread(KVSyncLane *lane);
 
 #ifdef HAVE_LIBZBD
   void _zoned_cleaner_start();
   void _zoned_cleaner_stop();
   void _zoned_cleaner_thread();
+  bool _zoned_cleaner_stopping();
   void _zoned_clean_zone(uint64_t zone_num);
+  void _zoned_clean_object(CollectionRef& c, const ghobject_t& oid,
+			   uint64_t zone_num);
 #endif
 
   bluestore_deferred_op_t *_get_deferred_op(TransContext *txc);
@@ -2485,6 +2728,7 @@ public:
   void deferred_try_submit();
 private:
   void _deferred_submit_unlock(OpSequencer *osr);
+  void _deferred_submit_aggregate(std::vector<OpSequencerRef>& osrs);
   void _deferred_aio_finish(OpSequencer *osr);
   int _deferred_replay();
 
@@ -2539,6 +2783,7 @@ private:
   int _collection_list(
     Collection *c, const ghobject_t& start, const ghobject_t& end,
     int max, bool legacy, std::vector<ghobject_t> *ls, ghobject_t *next);
+  void _prefetch_onodes(Collection *c, const std::vector<ghobject_t>& ls);
 
   template <typename T, typename F>
   T select_option(const std::string& opt_name, T val1, F f) {
@@ -2926,6 +3171,18 @@ public:
     const ghobject_t &oid  ///< [in] object
     ) override;
 
+  int omap_get_vals_encoded(
+    CollectionHandle &c,             ///< [in] Collection containing oid
+    const ghobject_t &oid,           ///< [in] Object containing omap
+    const std::string &start_after,  ///< [in] list keys after this one
+    const std::string &filter_prefix, ///< [in] list keys with this prefix
+    uint64_t max_entries,            ///< [in] max pairs to return
+    uint64_t max_bytes,              ///< [in] max bytes to return
+    ceph::buffer::list *out,         ///< [out] encoded pairs
+    uint32_t *num,                   ///< [out] number of pairs
+    bool *more                       ///< [out] true if pairs are left
+    ) override;
+
   void set_fsid(uuid_d u) override {
     fsid = u;
   }
@@ -3206,6 +3463,16 @@ private:
     uint64_t offset, uint64_t length,
     ceph::buffer::list::iterator& blp,
     WriteContext *wctx);
+  void _do_compress_blob(
+    CompressorRef& c,
+    const Compressor::Dictionary* dict,
+    double crr,
+    WriteContext::write_item& wi);
+  void _compress_blobs(
+    CompressorRef& c,
+    const Compressor::Dictionary* dict,
+    double crr,
+    const std::vector<WriteContext::write_item*>& items);
   int _do_alloc_write(
     TransContext *txc,
     CollectionRef c,
@@ -3404,6 +3671,11 @@ public:
     per_pool_statfs& expected_pool_statfs;
     BlueStoreRepairer* repairer;
 
+    uint64_t_btree_t* used_nids = nullptr;
+    // guards used_blocks, used_nids, used_omap_head and repairer,
+    // in multithreading mode only
+    ceph::mutex* used_lock = nullptr;
+
     FSCK_ObjectCtx(int64_t& e,
                    int64_t& w,
                    uint64_t& _num_objects,
@@ -3445,6 +3717,13 @@ public:
     mempool::bluestore_fsck::list<std::string>* expecting_shards,
     std::map<BlobRef, bluestore_blob_t::unused_t>* referenced,
     const BlueStore::FSCK_ObjectCtx& ctx);
+  /// the checks of regular and deep fsck past fsck_check_objects_shallow()
+  void fsck_check_objects_regular(
+    FSCKDepth depth,
+    CollectionRef& c,
+    OnodeRef& o,
+    const std::map<BlobRef, bluestore_blob_t::unused_t>& referenced,
+    const BlueStore::FSCK_ObjectCtx& ctx);
 
 private:
   void _fsck_check_object_omap(FSCKDepth depth,
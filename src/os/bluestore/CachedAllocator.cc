@@ -0,0 +1,238 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+
+#include "CachedAllocator.h"
+
+#include "common/debug.h"
+
+#define dout_context cct
+#define dout_subsys ceph_subsys_bluestore
+#undef  dout_prefix
+#define dout_prefix *_dout << "CachedAllocator(" << get_name() << ") "
+
+CachedAllocator::CachedAllocator(CephContext* cct, Allocator* _backend,
+				 size_t num_shards, uint64_t _max_cached,
+				 uint64_t _max_request, double _max_age)
+  // the backend keeps the admin socket commands of the name
+  : Allocator(_backend->get_name(), _backend->get_capacity(),
+	      _backend->get_block_size()),
+    cct(cct),
+    backend(_backend),
+    max_cached(p2align(_max_cached, (uint64_t)_backend->get_block_size())),
+    max_request(_max_request),
+    max_age(ceph::make_timespan(_max_age))
+{
+  ceph_assert(num_shards > 0);
+  shards.reserve(num_shards);
+  for (size_t i = 0; i < num_shards; ++i) {
+    shards.emplace_back(std::make_unique<shard_t>());
+  }
+  ldout(cct, 1) << __func__ << " " << num_shards << " shards of 0x"
+		<< std::hex << max_cached << " for allocations up to 0x"
+		<< max_request << std::dec << dendl;
+}
+
+CachedAllocator::~CachedAllocator()
+{
+  shutdown();
+}
+
+CachedAllocator::shard_t& CachedAllocator::my_shard()
+{
+  static std::atomic<unsigned> next_thread = {0};
+  thread_local const unsigned thread_idx = next_thread++;
+  return *shards[thread_idx % shards.size()];
+}
+
+uint64_t CachedAllocator::_take(shard_t& s, uint64_t want,
+				uint64_t max_alloc_size,
+				PExtentVector* extents)
+{
+  uint64_t got = 0;
+  while (got < want && !s.extents.empty()) {
+    auto& e = s.extents.back();
+    uint64_t l = std::min<uint64_t>(want - got, e.length);
+    if (max_alloc_size >= (uint64_t)block_size) {
+      l = std::min(l, p2align(max_alloc_size, (uint64_t)block_size));
+    }
+    if (!extents->empty() &&
+	extents->back().end() == e.offset &&
+	(max_alloc_size == 0 || extents->back().length + l <= max_alloc_size)) {
+      extents->back().length += l;
+    } else {
+      extents->emplace_back(e.offset, l);
+    }
+    e.offset += l;
+    e.length -= l;
+    if (e.length == 0) {
+      s.extents.pop_back();
+    }
+    got += l;
+  }
+  s.bytes -= got;
+  cached -= got;
+  return got;
+}
+
+void CachedAllocator::_give_back(shard_t& s, interval_set<uint64_t>* to)
+{
+  for (auto& e : s.extents) {
+    to->insert(e.offset, e.length);
+  }
+  cached -= s.bytes;
+  s.extents.clear();
+  s.bytes = 0;
+}
+
+void CachedAllocator::flush()
+{
+  interval_set<uint64_t> to_release;
+  for (auto& s : shards) {
+    std::lock_guard l(s->lock);
+    _give_back(*s, &to_release);
+  }
+  if (!to_release.empty()) {
+    ldout(cct, 10) << __func__ << " 0x" << std::hex << to_release.size()
+		   << std::dec << dendl;
+    backend->release(to_release);
+  }
+}
+
+int64_t CachedAllocator::allocate(
+  uint64_t want,
+  uint64_t unit,
+  uint64_t max_alloc_size,
+  int64_t hint,
+  PExtentVector *extents)
+{
+  if (unit == (uint64_t)block_size && want <= max_request &&
+      want % unit == 0) {
+    auto& s = my_shard();
+    std::lock_guard l(s.lock);
+    s.last_use = ceph::mono_clock::now();
+    if (s.bytes < want) {
+      PExtentVector refill;
+      int64_t r = backend->allocate(std::max(max_cached - s.bytes, want),
+				    unit, 0, hint, &refill);
+      if (r > 0) {
+	s.extents.insert(s.extents.begin(), refill.begin(), refill.end());
+	s.bytes += r;
+	cached += r;
+      }
+    }
+    if (s.bytes >= want) {
+      return _take(s, want, max_alloc_size, extents);
+    }
+  }
+  int64_t r = backend->allocate(want, unit, max_alloc_size, hint, extents);
+  if (r < (int64_t)want && cached > 0) {
+    // short of space while some is cached, retry without caches
+    ldout(cct, 5) << __func__ << " short of 0x" << std::hex << want
+		  << ", flushing 0x" << cached << std::dec << dendl;
+    if (r > 0) {
+      backend->release(*extents);
+      extents->clear();
+    }
+    flush();
+    r = backend->allocate(want, unit, max_alloc_size, hint, extents);
+  }
+  return r;
+}
+
+int64_t CachedAllocator::allocate_stream(
+  uint64_t stream,
+  lifetime_t lifetime,
+  uint64_t want,
+  uint64_t unit,
+  uint64_t max_alloc_size,
+  PExtentVector *extents)
+{
+  // per-thread caches would mix the streams up again
+  int64_t r = backend->allocate_stream(stream, lifetime, want, unit,
+				       max_alloc_size, extents);
+  if (r < (int64_t)want && cached > 0) {
+    if (r > 0) {
+      backend->release(*extents);
+      extents->clear();
+    }
+    flush();
+    r = backend->allocate_stream(stream, lifetime, want, unit,
+				 max_alloc_size, extents);
+  }
+  return r;
+}
+
+void CachedAllocator::release(const interval_set<uint64_t>& release_set)
+{
+  uint64_t now = ceph::mono_clock::now().time_since_epoch().count();
+  uint64_t last = last_trim_ns;
+  if (cached == 0 || now - last < (uint64_t)max_age.count() ||
+      !last_trim_ns.compare_exchange_strong(last, now)) {
+    backend->release(release_set);
+    return;
+  }
+  // give back what shards unused for a while hold
+  interval_set<uint64_t> to_release;
+  auto too_old = ceph::mono_clock::now() - max_age;
+  for (auto& s : shards) {
+    std::unique_lock l(s->lock, std::try_to_lock);
+    if (l.owns_lock() && s->bytes && s->last_use < too_old) {
+      _give_back(*s, &to_release);
+    }
+  }
+  if (to_release.empty()) {
+    backend->release(release_set);
+    return;
+  }
+  ldout(cct, 10) << __func__ << " unused 0x" << std::hex << to_release.size()
+		 << std::dec << dendl;
+  to_release.insert(release_set);
+  backend->release(to_release);
+}
+
+uint64_t CachedAllocator::get_free()
+{
+  return backend->get_free() + cached;
+}
+
+void CachedAllocator::dump()
+{
+  backend->dump();
+  for (size_t i = 0; i < shards.size(); ++i) {
+    std::lock_guard l(shards[i]->lock);
+    ldout(cct, 0) << __func__ << " shard " << i << " caches 0x" << std::hex
+		  << shards[i]->bytes << std::dec << " in "
+		  << shards[i]->extents.size() << " extents" << dendl;
+  }
+}
+
+void CachedAllocator::dump(std::function<void(uint64_t offset, uint64_t length)> notify)
+{
+  backend->dump(notify);
+  for (auto& s : shards) {
+    std::lock_guard l(s->lock);
+    for (auto& e : s->extents) {
+      notify(e.offset, e.length);
+    }
+  }
+}
+
+void CachedAllocator::init_add_free(uint64_t offset, uint64_t length)
+{
+  backend->init_add_free(offset, length);
+}
+
+void CachedAllocator::init_rm_free(uint64_t offset, uint64_t length)
+{
+  // the range may be cached
+  flush();
+  backend->init_rm_free(offset, length);
+}
+
+void CachedAllocator::shutdown()
+{
+  if (backend) {
+    flush();
+    backend->shutdown();
+  }
+}
@@ -0,0 +1,92 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "Allocator.h"
+#include "common/ceph_mutex.h"
+#include "common/ceph_time.h"
+
+/*
+ * Per-shard caches of free extents in front of another allocator.
+ *
+ * Every allocation of the wrapped allocator serializes on its lock.  Here
+ * each thread allocates from one of several shards, each holding up to
+ * max_cached bytes of free extents taken from the backend in one go, so
+ * small allocations of concurrent threads mostly touch different locks.
+ * Only allocations in units of the backend block size, up to max_request
+ * bytes, use the caches.
+ *
+ * Releases go straight to the backend, along with the extents of shards
+ * unused for max_age.  Caches are also returned before the backend is
+ * asked for space it may not have: nothing fails with ENOSPC while free
+ * space sits in a cache.
+ */
+class CachedAllocator : public Allocator {
+  CephContext* cct;
+  std::unique_ptr<Allocator> backend;
+  const uint64_t max_cached;   ///< per shard
+  const uint64_t max_request;  ///< larger allocations skip the caches
+  const ceph::timespan max_age;
+
+  struct alignas(64) shard_t {
+    ceph::mutex lock = ceph::make_mutex("CachedAllocator::shard_t::lock");
+    PExtentVector extents;     ///< free, in units of block_size
+    uint64_t bytes = 0;
+    ceph::mono_time last_use;
+  };
+  std::vector<std::unique_ptr<shard_t>> shards;
+  std::atomic<uint64_t> cached = {0};
+  std::atomic<uint64_t> last_trim_ns = {0};  ///< last look for unused shards
+
+  shard_t& my_shard();
+  uint64_t _take(shard_t& s, uint64_t want, uint64_t max_alloc_size,
+		 PExtentVector* extents);
+  void _give_back(shard_t& s, interval_set<uint64_t>* to);
+  /// return all the caches to the backend
+  void flush();
+
+public:
+  /// takes ownership of @p backend
+  CachedAllocator(CephContext* cct, Allocator* backend,
+		  size_t num_shards, uint64_t max_cached,
+		  uint64_t max_request, double max_age);
+  ~CachedAllocator() override;
+
+  const char* get_type() const override {
+    return backend->get_type();
+  }
+  int64_t allocate(
+    uint64_t want,
+    uint64_t unit,
+    uint64_t max_alloc_size,
+    int64_t hint,
+    PExtentVector *extents) override;
+  int64_t allocate_stream(
+    uint64_t stream,
+    lifetime_t lifetime,
+    uint64_t want,
+    uint64_t unit,
+    uint64_t max_alloc_size,
+    PExtentVector *extents) override;
+  void release(const interval_set<uint64_t>& release_set) override;
+  using Allocator::release;
+  uint64_t get_free() override;
+  double get_fragmentation() override {
+    return backend->get_fragmentation();
+  }
+
+  void dump() override;
+  void dump(std::function<void(uint64_t offset, uint64_t length)> notify) override;
+  void init_add_free(uint64_t offset, uint64_t length) override;
+  void init_rm_free(uint64_t offset, uint64_t length) override;
+  void shutdown() override;
+
+  uint64_t get_cached() const {
+    return cached;
+  }
+};
@@ -50,6 +50,18 @@ public:
 
   virtual void get_meta(uint64_t target_size,
     std::vector<std::pair<string, string>>*) const = 0;
+
+  /// record no allocations nor releases, the allocator state is
+  /// persisted some other way (see bluestore_allocation_from_file)
+  void set_null_manager() {
+    null_manager = true;
+  }
+  bool is_null_manager() const {
+    return null_manager;
+  }
+
+protected:
+  bool null_manager = false;
 };
 
 
@@ -0,0 +1,233 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+
+#include "StreamAllocator.h"
+
+#include "common/debug.h"
+
+#define dout_context cct
+#define dout_subsys ceph_subsys_bluestore
+#undef  dout_prefix
+#define dout_prefix *_dout << "StreamAllocator(" << get_name() << ") "
+
+StreamAllocator::StreamAllocator(CephContext* cct, Allocator* _backend,
+				 size_t _num_streams, uint64_t _region_size,
+				 uint64_t _max_request, double _max_age)
+  // the backend keeps the admin socket commands of the name
+  : Allocator(_backend->get_name(), _backend->get_capacity(),
+	      _backend->get_block_size()),
+    cct(cct),
+    backend(_backend),
+    region_size(p2roundup(_region_size, (uint64_t)_backend->get_block_size())),
+    max_request(std::min(_max_request, region_size)),
+    max_age(ceph::make_timespan(_max_age)),
+    num_streams(_num_streams)
+{
+  ceph_assert(num_streams > 0);
+  streams.reserve(num_streams * LIFETIME_COUNT);
+  for (size_t i = 0; i < num_streams * LIFETIME_COUNT; ++i) {
+    streams.emplace_back(std::make_unique<stream_t>());
+  }
+  ldout(cct, 1) << __func__ << " " << num_streams << " streams of 0x"
+		<< std::hex << region_size << " regions for allocations up to 0x"
+		<< max_request << std::dec << dendl;
+}
+
+StreamAllocator::~StreamAllocator()
+{
+  shutdown();
+}
+
+StreamAllocator::stream_t& StreamAllocator::get_stream(uint64_t stream,
+							lifetime_t lifetime)
+{
+  return *streams[(size_t)lifetime * num_streams + stream % num_streams];
+}
+
+uint64_t StreamAllocator::_take(stream_t& s, uint64_t want,
+				uint64_t max_alloc_size,
+				PExtentVector* extents)
+{
+  uint64_t got = 0;
+  while (got < want && !s.extents.empty()) {
+    auto& e = s.extents.back();
+    uint64_t l = std::min<uint64_t>(want - got, e.length);
+    if (max_alloc_size >= (uint64_t)block_size) {
+      l = std::min(l, p2align(max_alloc_size, (uint64_t)block_size));
+    }
+    if (!extents->empty() &&
+	extents->back().end() == e.offset &&
+	(max_alloc_size == 0 || extents->back().length + l <= max_alloc_size)) {
+      extents->back().length += l;
+    } else {
+      extents->emplace_back(e.offset, l);
+    }
+    e.offset += l;
+    e.length -= l;
+    if (e.length == 0) {
+      s.extents.pop_back();
+    }
+    got += l;
+  }
+  s.bytes -= got;
+  reserved -= got;
+  return got;
+}
+
+void StreamAllocator::_give_back(stream_t& s, interval_set<uint64_t>* to)
+{
+  for (auto& e : s.extents) {
+    to->insert(e.offset, e.length);
+  }
+  reserved -= s.bytes;
+  s.extents.clear();
+  s.bytes = 0;
+}
+
+void StreamAllocator::flush()
+{
+  interval_set<uint64_t> to_release;
+  for (auto& s : streams) {
+    std::lock_guard l(s->lock);
+    _give_back(*s, &to_release);
+  }
+  if (!to_release.empty()) {
+    ldout(cct, 10) << __func__ << " 0x" << std::hex << to_release.size()
+		   << std::dec << dendl;
+    backend->release(to_release);
+  }
+}
+
+int64_t StreamAllocator::allocate(
+  uint64_t want,
+  uint64_t unit,
+  uint64_t max_alloc_size,
+  int64_t hint,
+  PExtentVector *extents)
+{
+  int64_t r = backend->allocate(want, unit, max_alloc_size, hint, extents);
+  if (r < (int64_t)want && reserved > 0) {
+    // short of space while some is reserved, retry without the regions
+    ldout(cct, 5) << __func__ << " short of 0x" << std::hex << want
+		  << ", flushing 0x" << reserved << std::dec << dendl;
+    if (r > 0) {
+      backend->release(*extents);
+      extents->clear();
+    }
+    flush();
+    r = backend->allocate(want, unit, max_alloc_size, hint, extents);
+  }
+  return r;
+}
+
+int64_t StreamAllocator::allocate_stream(
+  uint64_t stream,
+  lifetime_t lifetime,
+  uint64_t want,
+  uint64_t unit,
+  uint64_t max_alloc_size,
+  PExtentVector *extents)
+{
+  if (unit == (uint64_t)block_size && want <= max_request &&
+      want % unit == 0) {
+    auto& s = get_stream(stream, lifetime);
+    std::lock_guard l(s.lock);
+    s.last_use = ceph::mono_clock::now();
+    if (s.bytes < want) {
+      // carry on from where the last region ended, if the backend can
+      PExtentVector region;
+      int64_t r = backend->allocate(region_size - s.bytes, unit, 0,
+				    s.next, &region);
+      if (r > 0) {
+	s.extents.insert(s.extents.begin(), region.rbegin(), region.rend());
+	s.bytes += r;
+	reserved += r;
+	s.next = region.back().end();
+	ldout(cct, 20) << __func__ << " stream " << stream << " lifetime "
+		       << (int)lifetime << " region " << region << dendl;
+      }
+    }
+    if (s.bytes >= want) {
+      return _take(s, want, max_alloc_size, extents);
+    }
+  }
+  return allocate(want, unit, max_alloc_size, 0, extents);
+}
+
+void StreamAllocator::release(const interval_set<uint64_t>& release_set)
+{
+  uint64_t now = ceph::mono_clock::now().time_since_epoch().count();
+  uint64_t last = last_trim_ns;
+  if (reserved == 0 || now - last < (uint64_t)max_age.count() ||
+      !last_trim_ns.compare_exchange_strong(last, now)) {
+    backend->release(release_set);
+    return;
+  }
+  // give back what streams idle for a while still hold
+  interval_set<uint64_t> to_release;
+  auto too_old = ceph::mono_clock::now() - max_age;
+  for (auto& s : streams) {
+    std::unique_lock l(s->lock, std::try_to_lock);
+    if (l.owns_lock() && s->bytes && s->last_use < too_old) {
+      _give_back(*s, &to_release);
+    }
+  }
+  if (to_release.empty()) {
+    backend->release(release_set);
+    return;
+  }
+  ldout(cct, 10) << __func__ << " unused 0x" << std::hex << to_release.size()
+		 << std::dec << dendl;
+  to_release.insert(release_set);
+  backend->release(to_release);
+}
+
+uint64_t StreamAllocator::get_free()
+{
+  return backend->get_free() + reserved;
+}
+
+void StreamAllocator::dump()
+{
+  backend->dump();
+  for (size_t i = 0; i < streams.size(); ++i) {
+    std::lock_guard l(streams[i]->lock);
+    if (streams[i]->bytes) {
+      ldout(cct, 0) << __func__ << " stream " << i % num_streams
+		    << " lifetime " << i / num_streams << " reserves 0x"
+		    << std::hex << streams[i]->bytes << std::dec << " in "
+		    << streams[i]->extents.size() << " extents" << dendl;
+    }
+  }
+}
+
+void StreamAllocator::dump(std::function<void(uint64_t offset, uint64_t length)> notify)
+{
+  backend->dump(notify);
+  for (auto& s : streams) {
+    std::lock_guard l(s->lock);
+    for (auto& e : s->extents) {
+      notify(e.offset, e.length);
+    }
+  }
+}
+
+void StreamAllocator::init_add_free(uint64_t offset, uint64_t length)
+{
+  backend->init_add_free(offset, length);
+}
+
+void StreamAllocator::init_rm_free(uint64_t offset, uint64_t length)
+{
+  // the range may be reserved
+  flush();
+  backend->init_rm_free(offset, length);
+}
+
+void StreamAllocator::shutdown()
+{
+  if (backend) {
+    flush();
+    backend->shutdown();
+  }
+}
@@ -0,0 +1,94 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "Allocator.h"
+#include "common/ceph_mutex.h"
+#include "common/ceph_time.h"
+
+/*
+ * Contiguous regions per stream of writes in front of another allocator.
+ *
+ * When the writes of all the collections and of data of any lifetime take
+ * their space from the same free extents, they interleave on the device,
+ * and whatever is deleted first leaves small holes between what stays.
+ * Here each stream, hashed into one of num_streams slots per lifetime,
+ * takes a region of region_size bytes from the backend at once and
+ * allocates from it in order, so its data stays together and frees up
+ * together.
+ *
+ * Plain allocations, and those of streams larger than max_request, go
+ * straight to the backend.  The unused part of the regions goes back to it
+ * once a stream is idle for max_age, and before the backend is asked for
+ * space it may not have.
+ */
+class StreamAllocator : public Allocator {
+  CephContext* cct;
+  std::unique_ptr<Allocator> backend;
+  const uint64_t region_size;
+  const uint64_t max_request;  ///< larger allocations skip the regions
+  const ceph::timespan max_age;
+
+  struct alignas(64) stream_t {
+    ceph::mutex lock = ceph::make_mutex("StreamAllocator::stream_t::lock");
+    PExtentVector extents;     ///< what is left of the region, last first
+    uint64_t bytes = 0;
+    uint64_t next = 0;         ///< where the last region ended
+    ceph::mono_time last_use;
+  };
+  const size_t num_streams;    ///< per lifetime
+  std::vector<std::unique_ptr<stream_t>> streams;
+  std::atomic<uint64_t> reserved = {0};
+  std::atomic<uint64_t> last_trim_ns = {0};  ///< last look for idle streams
+
+  stream_t& get_stream(uint64_t stream, lifetime_t lifetime);
+  uint64_t _take(stream_t& s, uint64_t want, uint64_t max_alloc_size,
+		 PExtentVector* extents);
+  void _give_back(stream_t& s, interval_set<uint64_t>* to);
+  /// return all the regions to the backend
+  void flush();
+
+public:
+  /// takes ownership of @p backend
+  StreamAllocator(CephContext* cct, Allocator* backend,
+		  size_t num_streams, uint64_t region_size,
+		  uint64_t max_request, double max_age);
+  ~StreamAllocator() override;
+
+  const char* get_type() const override {
+    return backend->get_type();
+  }
+  int64_t allocate(
+    uint64_t want,
+    uint64_t unit,
+    uint64_t max_alloc_size,
+    int64_t hint,
+    PExtentVector *extents) override;
+  int64_t allocate_stream(
+    uint64_t stream,
+    lifetime_t lifetime,
+    uint64_t want,
+    uint64_t unit,
+    uint64_t max_alloc_size,
+    PExtentVector *extents) override;
+  void release(const interval_set<uint64_t>& release_set) override;
+  using Allocator::release;
+  uint64_t get_free() override;
+  double get_fragmentation() override {
+    return backend->get_fragmentation();
+  }
+  uint64_t get_reserved() const {
+    return reserved;
+  }
+
+  void dump() override;
+  void dump(std::function<void(uint64_t offset, uint64_t length)> notify) override;
+  void init_add_free(uint64_t offset, uint64_t length) override;
+  void init_rm_free(uint64_t offset, uint64_t length) override;
+  void shutdown() override;
+};
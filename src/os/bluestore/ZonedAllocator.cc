@@ -192,8 +192,7 @@ bool ZonedAllocator::low_on_space(void) {
 		 << " total size " << sequential_size
 		 << " free ratio is " << free_ratio << dendl;
 
-   // TODO: make 0.25 tunable
-  return free_ratio <= 0.25;
+  return free_ratio <= cct->_conf->bluestore_zoned_cleaner_free_ratio;
 }
 
 void ZonedAllocator::find_zones_to_clean(void) {
@@ -203,35 +202,44 @@ void ZonedAllocator::find_zones_to_clean(void) {
     return;
 
   ceph_assert(zones_to_clean.empty());
-  
-  // TODO: make this tunable; handle the case when there aren't this many zones
-  // to clean.
-  const int64_t num_zones_to_clean_at_once = 1;
-
-  std::vector<uint64_t> idx(num_zones);
-  std::iota(idx.begin(), idx.end(), 0);
-  
+
   if (cct->_conf->subsys.should_gather<ceph_subsys_bluestore, 40>()) {
     for (size_t i = 0; i < zone_states.size(); ++i) {
       dout(40) << __func__ << " zone " << i << zone_states[i] << dendl;
     }
   }
 
-  std::partial_sort(idx.begin(), idx.begin() + num_zones_to_clean_at_once, idx.end(),
-		    [this](uint64_t i1, uint64_t i2) {
-		      return zone_states[i1].num_dead_bytes > zone_states[i2].num_dead_bytes;
-		    });
-
-  ldout(cct, 10) << __func__ << " the zone that needs cleaning is "
-		 << *idx.begin() << " num_dead_bytes = " << zone_states[*idx.begin()].num_dead_bytes
-		 << dendl;
-
-  zones_to_clean = {idx.begin(), idx.begin() + num_zones_to_clean_at_once};
-  num_zones_to_clean = num_zones_to_clean_at_once;
-
-  // TODO: handle the case of disk being full.
-  ceph_assert(!zones_to_clean.empty());
-  ceph_assert(num_zones_to_clean != 0);
+  // the sequential zones written to, but the one being filled, by the part
+  // of what was written to them that is dead: those have the least live
+  // data to relocate for the space they give back
+  const double min_garbage_ratio =
+    cct->_conf->bluestore_zoned_cleaner_min_garbage_ratio;
+  std::vector<std::pair<double, uint64_t>> candidates;
+  for (uint64_t zone_num = first_seq_zone_num; zone_num < num_zones; ++zone_num) {
+    const auto &zone_state = zone_states[zone_num];
+    if (zone_num == starting_zone_num || !zone_state.write_pointer) {
+      continue;
+    }
+    double garbage_ratio = static_cast<double>(zone_state.num_dead_bytes) /
+      zone_state.write_pointer;
+    if (garbage_ratio >= min_garbage_ratio) {
+      candidates.emplace_back(garbage_ratio, zone_num);
+    }
+  }
+  if (candidates.empty()) {
+    ldout(cct, 10) << __func__ << " no zone has enough garbage to clean" << dendl;
+    return;
+  }
+  auto n = std::min<size_t>(
+    candidates.size(), cct->_conf->bluestore_zoned_cleaner_zones_per_pass);
+  std::partial_sort(candidates.begin(), candidates.begin() + n, candidates.end(),
+		    std::greater<>{});
+  for (auto p = candidates.begin(); p != candidates.begin() + n; ++p) {
+    ldout(cct, 10) << __func__ << " zone " << p->second
+		   << " needs cleaning, garbage ratio " << p->first << dendl;
+    zones_to_clean.insert(p->second);
+  }
+  num_zones_to_clean = n;
 
   cleaner_lock->lock();
   cleaner_cond->notify_one();
@@ -256,6 +264,8 @@ void ZonedAllocator::mark_zones_to_clean_free(void) {
     num_free += zone_states[zone_num].write_pointer;
     zone_states[zone_num].num_dead_bytes = 0;
     zone_states[zone_num].write_pointer = 0;
+    // the allocator may fill it again
+    starting_zone_num = std::min(starting_zone_num, zone_num);
   }
   zones_to_clean.clear();
   num_zones_to_clean = 0;
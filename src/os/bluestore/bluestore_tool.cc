@@ -285,6 +285,7 @@ int main(int argc, char **argv)
   string empty_sharding(1, '\0');
   string new_sharding = empty_sharding;
   string resharding_ctrl;
+  bool reshard_online = false;
   int log_level = 30;
   bool fsck_deep = false;
   po::options_description po_options("Options");
@@ -305,6 +306,7 @@ int main(int argc, char **argv)
     ("allocator", po::value<vector<string>>(&allocs_name), "allocator to inspect: 'block'/'bluefs-wal'/'bluefs-db'")
     ("sharding", po::value<string>(&new_sharding), "new sharding to apply")
     ("resharding-ctrl", po::value<string>(&resharding_ctrl), "gives control over resharding procedure details")
+    ("online", po::bool_switch(&reshard_online), "only prepare the reshard, the OSD moves the keys while running")
     ;
   po::options_description po_positional("Positional options");
   po_positional.add_options()
@@ -1012,9 +1014,15 @@ int main(int argc, char **argv)
     ceph_assert(db_ptr);
     RocksDBStore* rocks_db = dynamic_cast<RocksDBStore*>(db_ptr);
     ceph_assert(rocks_db);
-    r = rocks_db->reshard(new_sharding, &ctrl);
+    if (reshard_online) {
+      r = rocks_db->reshard_online_prepare(new_sharding);
+    } else {
+      r = rocks_db->reshard(new_sharding, &ctrl);
+    }
     if (r < 0) {
       cerr << "error resharding: " << cpp_strerror(r) << std::endl;
+    } else if (reshard_online) {
+      cout << "reshard prepared, keys move when the OSD starts" << std::endl;
     } else {
       cout << "reshard success" << std::endl;
     }
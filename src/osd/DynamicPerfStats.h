@@ -4,6 +4,8 @@
 #ifndef DYNAMIC_PERF_STATS_H
 #define DYNAMIC_PERF_STATS_H
 
+#include <algorithm>
+
 #include "include/random.h"
 #include "messages/MOSDOp.h"
 #include "mgr/OSDPerfMetricTypes.h"
@@ -15,7 +17,9 @@ public:
   DynamicPerfStats() {
   }
 
-  DynamicPerfStats(const std::list<OSDPerfMetricQuery> &queries) {
+  DynamicPerfStats(const std::list<OSDPerfMetricQuery> &queries,
+                   size_t max_keys = 0)
+    : max_keys(max_keys) {
     for (auto &query : queries) {
       data[query];
     }
@@ -38,16 +42,20 @@ public:
         ceph_assert(key_it.second.size() >= data[query][key].size());
         query.update_counters(update_counter_fnc, &data[query][key]);
       }
+      maybe_trim(&data[query]);
     }
   }
 
-  void set_queries(const std::list<OSDPerfMetricQuery> &queries) {
+  /// @p max_keys bounds the keys tracked per query, 0 for no bound
+  void set_queries(const std::list<OSDPerfMetricQuery> &queries,
+                   size_t max_keys = 0) {
     std::map<OSDPerfMetricQuery,
              std::map<OSDPerfMetricKey, PerformanceCounters>> new_data;
     for (auto &query : queries) {
       std::swap(new_data[query], data[query]);
     }
     std::swap(data, new_data);
+    this->max_keys = max_keys;
   }
 
   bool is_enabled() {
@@ -55,11 +63,13 @@ public:
   }
 
   void add(const OSDService *osd, const pg_info_t &pg_info, const OpRequest& op,
-           uint64_t inb, uint64_t outb, const utime_t &latency) {
+           uint64_t inb, uint64_t outb, const utime_t &latency,
+           const utime_t &process_latency) {
 
     auto update_counter_fnc =
-        [&op, inb, outb, &latency](const PerformanceCounterDescriptor &d,
-                                   PerformanceCounter *c) {
+        [&op, inb, outb, &latency, &process_latency](
+            const PerformanceCounterDescriptor &d,
+            PerformanceCounter *c) {
           ceph_assert(d.is_supported());
 
           switch(d.type) {
@@ -105,6 +115,14 @@ public:
               c->second++;
             }
             return;
+          case PerformanceCounterType::QUEUE_LATENCY:
+            c->first += (latency - process_latency).to_nsec();
+            c->second++;
+            return;
+          case PerformanceCounterType::PROCESS_LATENCY:
+            c->first += process_latency.to_nsec();
+            c->second++;
+            return;
           default:
             ceph_abort_msg("unknown counter type");
           }
@@ -164,6 +182,7 @@ public:
       OSDPerfMetricKey key;
       if (query.get_key(get_subkey_fnc, &key)) {
         query.update_counters(update_counter_fnc, &it.second[key]);
+        maybe_trim(&it.second);
       }
     }
   }
@@ -180,6 +199,9 @@ public:
       auto &query_limits = limit_it->second;
       auto &counters = it.second;
       auto &report = (*reports)[query];
+      if (max_keys > 0 && counters.size() > max_keys) {
+        trim(&counters, max_keys);
+      }
 
       query.get_performance_counter_descriptors(
           &report.performance_counter_descriptors);
@@ -245,6 +267,52 @@ public:
   }
 
 private:
+  /**
+   * Keep the heavy hitters of a query once it has too many keys.
+   *
+   * The keys are let grow to twice max_keys, then those with the least
+   * of the first counter of the query are dropped down to max_keys, so
+   * that the cost is amortized over the keys added since.  A key that
+   * stays among the busiest, the ones any limit of the query would
+   * report, is never dropped; a dropped key starts over if it shows up
+   * again.
+   */
+  void maybe_trim(std::map<OSDPerfMetricKey, PerformanceCounters> *counters) {
+    if (max_keys > 0 && counters->size() > 2 * max_keys) {
+      trim(counters, max_keys);
+    }
+  }
+
+  static void trim(std::map<OSDPerfMetricKey, PerformanceCounters> *counters,
+                   size_t max_keys) {
+    auto weight = [](const PerformanceCounters &c) {
+      return c.empty() ? 0 : c[0].first;
+    };
+    std::vector<uint64_t> weights;
+    weights.reserve(counters->size());
+    for (auto &it : *counters) {
+      weights.push_back(weight(it.second));
+    }
+    // the weight of the max_keys-th busiest key
+    auto nth = weights.begin() + max_keys - 1;
+    std::nth_element(weights.begin(), nth, weights.end(),
+                     std::greater<uint64_t>());
+    uint64_t min_weight = *nth;
+    size_t at_min = std::count(weights.begin(), weights.begin() + max_keys,
+                               min_weight);
+    for (auto it = counters->begin(); it != counters->end(); ) {
+      auto w = weight(it->second);
+      if (w > min_weight || (w == min_weight && at_min > 0)) {
+        if (w == min_weight) {
+          at_min--;
+        }
+        ++it;
+      } else {
+        it = counters->erase(it);
+      }
+    }
+  }
+
   static bool is_limited(const OSDPerfMetricLimits &limits,
                          size_t counters_size) {
     if (limits.empty()) {
@@ -262,6 +330,7 @@ private:
 
   std::map<OSDPerfMetricQuery,
            std::map<OSDPerfMetricKey, PerformanceCounters>> data;
+  size_t max_keys = 0;
 };
 
 #endif // DYNAMIC_PERF_STATS_H
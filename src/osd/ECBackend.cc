@@ -1040,24 +1040,19 @@ void ECBackend::handle_sub_read(
         dout(25) << __func__ << " case2: going to do fragmented read." << dendl;
         int subchunk_size =
           sinfo.get_chunk_size() / ec_impl->get_sub_chunk_count();
-        bool error = false;
-        for (int m = 0; m < (int)j->get<1>() && !error;
-             m += sinfo.get_chunk_size()) {
+        // the sub-chunks of every chunk of the extent, issued at once
+        // rather than one read after the other
+        interval_set<uint64_t> m;
+        for (uint64_t c = 0; c < j->get<1>(); c += sinfo.get_chunk_size()) {
           for (auto &&k:op.subchunks.find(i->first)->second) {
-            bufferlist bl0;
-            r = store->read(
-                ch,
-                ghobject_t(i->first, ghobject_t::NO_GEN, shard),
-                j->get<0>() + m + (k.first)*subchunk_size,
-                (k.second)*subchunk_size,
-                bl0, j->get<2>());
-            if (r < 0) {
-              error = true;
-              break;
-            }
-            bl.claim_append(bl0);
+            m.insert(j->get<0>() + c + (k.first)*subchunk_size,
+                     (k.second)*subchunk_size);
           }
         }
+        r = store->readv(
+            ch,
+            ghobject_t(i->first, ghobject_t::NO_GEN, shard),
+            m, bl, j->get<2>());
       }
 
       if (r < 0) {
@@ -1252,6 +1247,11 @@ void ECBackend::handle_sub_read_reply(
 
   ceph_assert(rop.in_progress.count(from));
   rop.in_progress.erase(from);
+  if (auto sent = rop.sent.find(from);
+      sent != rop.sent.end() && op.errors.empty()) {
+    update_shard_read_latency(
+      from, ceph::to_seconds<double>(ceph::mono_clock::now() - sent->second));
+  }
   unsigned is_complete = 0;
   bool need_resend = false;
   // For redundant reads check for completion as each shard comes in,
@@ -1462,6 +1462,7 @@ void ECBackend::on_change()
   waiting_reads.clear();
   waiting_state.clear();
   waiting_commit.clear();
+  rmw_reads_to_start.clear();
   for (auto &&op: tid_to_op_map) {
     cache.release_write_pin(op.second.pin);
   }
@@ -1645,7 +1646,13 @@ int ECBackend::get_min_avail_to_read_shards(
   get_all_avail_shards(hoid, error_shards, have, shards, for_recovery);
 
   map<int, vector<pair<int, int>>> need;
-  int r = ec_impl->minimum_to_decode(want, have, &need);
+  int r;
+  if (!for_recovery && !do_redundant_reads &&
+      cct->_conf->osd_ec_read_latency_aware) {
+    r = get_fastest_to_decode(want, have, shards, &need);
+  } else {
+    r = ec_impl->minimum_to_decode(want, have, &need);
+  }
   if (r < 0)
     return r;
 
@@ -1667,6 +1674,140 @@ int ECBackend::get_min_avail_to_read_shards(
   return 0;
 }
 
+double ECBackend::get_shard_read_latency(const pg_shard_t &shard) const
+{
+  auto p = osd_read_lat.find(shard.osd);
+  // an osd we have not read from yet is tried first, to get a sample
+  return p == osd_read_lat.end() ? 0 : p->second;
+}
+
+void ECBackend::update_shard_read_latency(const pg_shard_t &shard, double lat)
+{
+  auto [p, inserted] = osd_read_lat.emplace(shard.osd, lat);
+  if (!inserted) {
+    p->second = p->second * 0.8 + lat * 0.2;
+  }
+}
+
+int ECBackend::get_fastest_to_decode(
+  const set<int> &want,
+  const set<int> &have,
+  const map<shard_id_t, pg_shard_t> &shards,
+  map<int, vector<pair<int, int>>> *need)
+{
+  // grow the set of shards from the fastest one until it either holds
+  // want or can decode it: that bounds the read by the slowest shard
+  // it has to wait for, and still reads want directly when it is fast
+  bool degraded = std::any_of(want.begin(), want.end(),
+			      [&have](int i) { return !have.count(i); });
+  map<int, vector<pair<int, int>>> planned;
+  if (degraded) {
+    // a plugin with local groups (lrc) repairs from the group of the
+    // missing shard; a set of fast shards that decodes only through the
+    // global code reads more of them, often from further away
+    int r = ec_impl->minimum_to_decode(want, have, &planned);
+    if (r < 0) {
+      return r;
+    }
+  }
+  vector<pair<double, int>> by_latency;
+  by_latency.reserve(have.size());
+  for (auto i : have) {
+    by_latency.emplace_back(
+      get_shard_read_latency(shards.at(shard_id_t(i))), i);
+  }
+  std::sort(by_latency.begin(), by_latency.end());
+  set<int> fastest;
+  for (auto &p : by_latency) {
+    fastest.insert(p.second);
+    need->clear();
+    if (ec_impl->minimum_to_decode(want, fastest, need) == 0) {
+      if (degraded && need->size() > planned.size()) {
+	dout(20) << __func__ << " want " << want << " reading the "
+		 << planned.size() << " shards planned rather than "
+		 << need->size() << " fastest ones" << dendl;
+	need->swap(planned);
+	return 0;
+      }
+      dout(20) << __func__ << " want " << want << " reading " << fastest
+	       << dendl;
+      return 0;
+    }
+  }
+  need->clear();
+  return ec_impl->minimum_to_decode(want, have, need);
+}
+
+void ECBackend::maybe_schedule_hedge(const ReadOp &rop)
+{
+  double factor = cct->_conf->osd_ec_read_hedge_factor;
+  if (rop.for_recovery || rop.do_redundant_reads || factor <= 0 ||
+      !cct->_conf->osd_ec_read_latency_aware) {
+    return;
+  }
+  double expected = 0;
+  for (auto &shard : rop.in_progress) {
+    expected = std::max(expected, get_shard_read_latency(shard));
+  }
+  if (expected == 0) {
+    // no samples yet for at least one shard
+    return;
+  }
+  dout(20) << __func__ << " tid " << rop.tid << " after "
+	   << expected * factor << "s" << dendl;
+  ceph_tid_t tid = rop.tid;
+  get_parent()->schedule_event_after(
+    expected * factor,
+    new LambdaContext([this, tid](int) {
+      hedge_read_op(tid);
+    }));
+}
+
+void ECBackend::hedge_read_op(ceph_tid_t tid)
+{
+  auto iter = tid_to_read_map.find(tid);
+  if (iter == tid_to_read_map.end()) {
+    // completed in time
+    return;
+  }
+  ReadOp &rop = iter->second;
+  if (rop.do_redundant_reads) {
+    return;
+  }
+  vector<pair<int, int>> subchunks;
+  subchunks.push_back(make_pair(0, ec_impl->get_sub_chunk_count()));
+  bool hedged = false;
+  for (auto &[hoid, req] : rop.to_read) {
+    set<int> have;
+    map<shard_id_t, pg_shard_t> shards;
+    set<pg_shard_t> error_shards;
+    for (auto &p : rop.complete[hoid].errors) {
+      error_shards.insert(p.first);
+    }
+    get_all_avail_shards(hoid, error_shards, have, shards, false);
+    const set<pg_shard_t> &sources = rop.obj_to_source[hoid];
+    map<pg_shard_t, vector<pair<int, int>>> extra;
+    for (auto &p : shards) {
+      if (!sources.count(p.second)) {
+	extra.insert(make_pair(p.second, subchunks));
+      }
+    }
+    if (!extra.empty()) {
+      hedged = true;
+    }
+    req.need.swap(extra);
+    req.want_attrs = req.want_attrs &&
+      (!rop.complete[hoid].attrs || rop.complete[hoid].attrs->empty());
+  }
+  if (!hedged) {
+    return;
+  }
+  dout(10) << __func__ << " hedging " << rop << dendl;
+  // complete as soon as enough shards have answered, like fast_read
+  rop.do_redundant_reads = true;
+  do_read_op(rop);
+}
+
 int ECBackend::get_remaining_shards(
   const hobject_t &hoid,
   const set<int> &avail,
@@ -1739,6 +1880,7 @@ void ECBackend::start_read_op(
     op.trace.event("start ec read");
   }
   do_read_op(op);
+  maybe_schedule_hedge(op);
 }
 
 void ECBackend::do_read_op(ReadOp &op)
@@ -1786,10 +1928,12 @@ void ECBackend::do_read_op(ReadOp &op)
 
   std::vector<std::pair<int, Message*>> m;
   m.reserve(messages.size());
+  auto now = ceph::mono_clock::now();
   for (map<pg_shard_t, ECSubRead>::iterator i = messages.begin();
        i != messages.end();
        ++i) {
     op.in_progress.insert(i->first);
+    op.sent[i->first] = now;
     shard_to_read_map[i->first].insert(op.tid);
     i->second.tid = tid;
     MOSDECSubOpRead *msg = new MOSDECSubOpRead;
@@ -1960,19 +2104,49 @@ bool ECBackend::try_state_to_reads()
 
   if (!op->remote_read.empty()) {
     ceph_assert(get_parent()->get_pool().allows_ecoverwrites());
-    objects_read_async_no_cache(
-      op->remote_read,
-      [this, op](map<hobject_t,pair<int, extent_map> > &&results) {
-	for (auto &&i: results) {
-	  op->remote_read_result.emplace(i.first, i.second.second);
-	}
-	check_ops();
-      });
+    // sent by check_ops() along with the reads of the other ops let
+    // through in the same pass, see start_rmw_reads()
+    rmw_reads_to_start.push_back(op);
   }
 
   return true;
 }
 
+void ECBackend::start_rmw_reads()
+{
+  if (rmw_reads_to_start.empty())
+    return;
+  // Writes commit in order, so an op cannot leave waiting_reads before
+  // the ops ahead of it have their reads back anyway: one read for all
+  // of them costs none of them any latency, and spares the shards a
+  // sub read per op when a burst of small writes is let through at once
+  // (e.g. once an invalidated pipeline drains).
+  vector<Op*> ops;
+  ops.swap(rmw_reads_to_start);
+  map<hobject_t, extent_set> to_read;
+  for (auto op : ops) {
+    for (auto &&hpair : op->remote_read) {
+      to_read[hpair.first].union_of(hpair.second);
+    }
+  }
+  dout(10) << __func__ << ": " << ops.size() << " ops reading " << to_read
+	   << dendl;
+  objects_read_async_no_cache(
+    to_read,
+    [this, ops=std::move(ops)](map<hobject_t,pair<int, extent_map> > &&results) {
+      for (auto op : ops) {
+	for (auto &&hpair : op->remote_read) {
+	  const extent_map &got = results[hpair.first].second;
+	  extent_map &result = op->remote_read_result[hpair.first];
+	  for (auto &&extent : hpair.second) {
+	    result.insert(got.intersect(extent.first, extent.second));
+	  }
+	}
+      }
+      check_ops();
+    });
+}
+
 bool ECBackend::try_reads_to_commit()
 {
   if (waiting_reads.empty())
@@ -2196,6 +2370,7 @@ void ECBackend::check_ops()
   while (try_state_to_reads() ||
 	 try_reads_to_commit() ||
 	 try_finish_rmw());
+  start_rmw_reads();
 }
 
 int ECBackend::objects_read_sync(
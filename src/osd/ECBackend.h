@@ -385,6 +385,8 @@ public:
     void dump(ceph::Formatter *f) const;
 
     std::set<pg_shard_t> in_progress;
+    /// when each shard's sub read was sent, for the shard latency averages
+    std::map<pg_shard_t, ceph::mono_time> sent;
 
     ReadOp(
       int priority,
@@ -432,6 +434,26 @@ public:
     const hobject_t &hoid,
     ReadOp &rop);
 
+  /**
+   * Latency aware reads
+   *
+   * With osd_ec_read_latency_aware, the sub read latency of each OSD
+   * is averaged here and client reads go to the fastest shards that
+   * can decode the object.  A read still in flight after
+   * osd_ec_read_hedge_factor times the expected latency is turned into
+   * a redundant read of all the remaining shards (see hedge_read_op).
+   */
+  std::map<int, double> osd_read_lat; ///< osd -> avg sub read latency (s)
+  double get_shard_read_latency(const pg_shard_t &shard) const;
+  void update_shard_read_latency(const pg_shard_t &shard, double lat);
+  int get_fastest_to_decode(
+    const std::set<int> &want,
+    const std::set<int> &have,
+    const std::map<shard_id_t, pg_shard_t> &shards,
+    std::map<int, std::vector<std::pair<int, int>>> *need);
+  void maybe_schedule_hedge(const ReadOp &rop);
+  void hedge_read_op(ceph_tid_t tid);
+
 
   /**
    * Client writes
@@ -558,12 +580,14 @@ public:
   op_list waiting_state;        /// writes waiting on pipe_state
   op_list waiting_reads;        /// writes waiting on partial stripe reads
   op_list waiting_commit;       /// writes waiting on initial commit
+  std::vector<Op*> rmw_reads_to_start; /// waiting_reads not yet sent
   eversion_t completed_to;
   eversion_t committed_to;
   void start_rmw(Op *op, PGTransactionUPtr &&t);
   bool try_state_to_reads();
   bool try_reads_to_commit();
   bool try_finish_rmw();
+  void start_rmw_reads();
   void check_ops();
 
   ceph::ErasureCodeInterfaceRef ec_impl;
@@ -136,14 +136,17 @@ int ECUtil::encode(
   if (logical_size == 0)
     return 0;
 
-  for (uint64_t i = 0; i < logical_size; i += sinfo.get_stripe_width()) {
-    map<int, bufferlist> encoded;
-    bufferlist buf;
-    buf.substr_of(in, i, sinfo.get_stripe_width());
-    int r = ec_impl->encode(want, buf, &encoded);
-    ceph_assert(r == 0);
-    for (map<int, bufferlist>::iterator i = encoded.begin();
-	 i != encoded.end();
+  vector<bufferlist> stripes(logical_size / sinfo.get_stripe_width());
+  for (uint64_t i = 0; i < stripes.size(); i++) {
+    stripes[i].substr_of(in, i * sinfo.get_stripe_width(),
+			 sinfo.get_stripe_width());
+  }
+  vector<map<int, bufferlist>> encoded;
+  int r = ec_impl->encode_batch(want, stripes, &encoded);
+  ceph_assert(r == 0);
+  for (auto &stripe : encoded) {
+    for (map<int, bufferlist>::iterator i = stripe.begin();
+	 i != stripe.end();
 	 ++i) {
       ceph_assert(i->second.length() == sinfo.get_chunk_size());
       (*out)[i->first].claim_append(i->second);
@@ -1049,6 +1049,23 @@ float OSDService::compute_adjusted_ratio(osd_stat_t new_stat, float *pratio,
   return ((float)new_stat.statfs.get_used_raw()) / ((float)new_stat.statfs.total);
 }
 
+unsigned OSDService::get_cluster_lane(const spg_t& pgid) const
+{
+  return (pgid.pool() * 0x9e3779b9u + pgid.ps()) %
+    osd->cluster_messenger->get_num_lanes();
+}
+
+unsigned OSDService::get_cluster_lane(const Message* m) const
+{
+  if (auto op = dynamic_cast<const MOSDFastDispatchOp*>(m); op) {
+    return get_cluster_lane(op->get_spg());
+  }
+  if (auto op = dynamic_cast<const MOSDPeeringOp*>(m); op) {
+    return get_cluster_lane(op->get_spg());
+  }
+  return 0;
+}
+
 void OSDService::send_message_osd_cluster(int peer, Message *m, epoch_t from_epoch)
 {
   OSDMapRef next_map = get_nextmap_reserved();
@@ -1065,8 +1082,8 @@ void OSDService::send_message_osd_cluster(int peer, Message *m, epoch_t from_epo
   if (peer == whoami) {
     peer_con = osd->cluster_messenger->get_loopback_connection();
   } else {
-    peer_con = osd->cluster_messenger->connect_to_osd(
-	next_map->get_cluster_addrs(peer), false, true);
+    peer_con = osd->cluster_messenger->connect_to_osd_lane(
+	next_map->get_cluster_addrs(peer), get_cluster_lane(m));
   }
   maybe_share_map(peer_con.get(), next_map);
   peer_con->send_message(m);
@@ -1089,15 +1106,16 @@ void OSDService::send_message_osd_cluster(std::vector<std::pair<int, Message*>>&
     if (iter.first == whoami) {
       peer_con = osd->cluster_messenger->get_loopback_connection();
     } else {
-      peer_con = osd->cluster_messenger->connect_to_osd(
-	  next_map->get_cluster_addrs(iter.first), false, true);
+      peer_con = osd->cluster_messenger->connect_to_osd_lane(
+	  next_map->get_cluster_addrs(iter.first), get_cluster_lane(iter.second));
     }
     maybe_share_map(peer_con.get(), next_map);
     peer_con->send_message(iter.second);
   }
   release_map(next_map);
 }
-ConnectionRef OSDService::get_con_osd_cluster(int peer, epoch_t from_epoch)
+ConnectionRef OSDService::get_con_osd_cluster(int peer, epoch_t from_epoch,
+					       unsigned lane)
 {
   OSDMapRef next_map = get_nextmap_reserved();
   // service map is always newer/newest
@@ -1112,8 +1130,8 @@ ConnectionRef OSDService::get_con_osd_cluster(int peer, epoch_t from_epoch)
   if (peer == whoami) {
     con = osd->cluster_messenger->get_loopback_connection();
   } else {
-    con = osd->cluster_messenger->connect_to_osd(
-	next_map->get_cluster_addrs(peer), false, true);
+    con = osd->cluster_messenger->connect_to_osd_lane(
+	next_map->get_cluster_addrs(peer), lane);
   }
   release_map(next_map);
   return con;
@@ -1736,7 +1754,9 @@ void OSDService::queue_for_snap_trim(PG *pg)
     OpSchedulerItem(
       unique_ptr<OpSchedulerItem::OpQueueable>(
 	new PGSnapTrim(pg->get_pgid(), pg->get_osdmap_epoch())),
-      cct->_conf->osd_snap_trim_cost,
+      // what a work item may trim
+      cct->_conf->osd_snap_trim_cost *
+	cct->_conf->osd_pg_max_concurrent_snap_trims,
       cct->_conf->osd_snap_trim_priority,
       ceph_clock_now(),
       0,
@@ -2306,6 +2326,8 @@ OSD::OSD(CephContext *cct_, ObjectStore *store_,
                                            cct->_conf->osd_op_history_duration);
   op_tracker.set_history_slow_op_size_and_threshold(cct->_conf->osd_op_history_slow_op_size,
                                                     cct->_conf->osd_op_history_slow_op_threshold);
+  op_tracker.set_sample_interval(cct->_conf->osd_op_tracker_sample_interval);
+  op_tracker.set_log_slow_ops(cct->_conf->osd_op_history_slow_op_log);
   ObjectCleanRegions::set_max_num_intervals(cct->_conf->osd_object_clean_region_max_num_intervals);
 #ifdef WITH_BLKIN
   std::stringstream ss;
@@ -2408,6 +2430,10 @@ int OSD::set_numa_affinity()
       } else {
 	dout(1) << __func__ << " objectstore and network numa nodes do not match"
 		<< dendl;
+	if (store_node >= 0 &&
+	    g_conf().get_val<bool>("osd_numa_split_affinity")) {
+	  set_split_numa_affinity(front_node, store_node);
+	}
       }
     } else if (back_node == -2) {
       dout(1) << __func__ << " cluster network " << back_iface
@@ -2452,6 +2478,32 @@ int OSD::set_numa_affinity()
   return 0;
 }
 
+void OSD::set_split_numa_affinity(int net_node, int store_node)
+{
+  // the threads allocate from the memory of their own node first, so the
+  // messenger's buffers are near the nic as well
+  const std::pair<int, std::set<std::string>> placements[] = {
+    {net_node, {"msgr-worker-"}},
+    {store_node, {"tp_osd_tp", "bstore_"}},
+  };
+  for (auto& [node, prefixes] : placements) {
+    size_t cpu_set_size;
+    cpu_set_t cpu_set;
+    int r = get_numa_node_cpu_set(node, &cpu_set_size, &cpu_set);
+    if (r >= 0) {
+      r = set_cpu_affinity_named_threads(prefixes, cpu_set_size, &cpu_set);
+    }
+    if (r < 0) {
+      derr << __func__ << " failed to set the affinity of " << prefixes
+	   << " to numa node " << node << ": " << cpp_strerror(r) << dendl;
+      continue;
+    }
+    dout(1) << __func__ << " set the affinity of " << prefixes
+	    << " to numa node " << node << " cpus "
+	    << cpu_set_to_str_list(cpu_set_size, &cpu_set) << dendl;
+  }
+}
+
 // asok
 
 class OSDSocketHook : public AdminSocketHook {
@@ -3653,7 +3705,7 @@ int OSD::init()
   if (r < 0)
     goto out;
 
-  mgrc.set_pgstats_cb([this]() { return collect_pg_stats(); });
+  mgrc.set_pgstats_cb([this](bool full) { return collect_pg_stats(full); });
   mgrc.set_perf_metric_query_cb(
     [this](const ConfigPayload &config_payload) {
         set_perf_queries(config_payload);
@@ -4794,7 +4846,9 @@ void OSD::load_pgs()
     derr << "failed to list pgs: " << cpp_strerror(-r) << dendl;
   }
 
-  int num = 0;
+  // open the pgs first, then read their state in parallel: most of the
+  // time of a large osd's startup goes into reading pg logs
+  vector<PGRef> pgs;
   for (vector<coll_t>::iterator it = ls.begin();
        it != ls.end();
        ++it) {
@@ -4852,15 +4906,41 @@ void OSD::load_pgs()
 
     pg->lock();
     pg->ch = store->open_collection(pg->coll);
+    pg->unlock();
+    pgs.push_back(pg);
+  }
 
-    // read pg state, log
-    pg->read_state(store);
+  // read pg state, log
+  {
+    std::atomic<size_t> next = {0};
+    auto read_states = [&] {
+      for (size_t i = next++; i < pgs.size(); i = next++) {
+	pgs[i]->lock();
+	pgs[i]->read_state(store);
+	pgs[i]->unlock();
+      }
+    };
+    size_t num_threads = std::min<size_t>(
+      cct->_conf.get_val<uint64_t>("osd_load_pgs_threads"), pgs.size());
+    vector<std::thread> threads;
+    for (size_t i = 1; i < num_threads; ++i) {
+      threads.push_back(make_named_thread("osd_load_pgs", read_states));
+    }
+    read_states();
+    for (auto& t : threads) {
+      t.join();
+    }
+  }
 
+  int num = 0;
+  for (auto& pg : pgs) {
+    spg_t pgid = pg->get_pgid();
+    pg->lock();
     if (pg->dne())  {
-      dout(10) << "load_pgs " << *it << " deleting dne" << dendl;
+      dout(10) << "load_pgs " << pg->coll << " deleting dne" << dendl;
       pg->ch = nullptr;
       pg->unlock();
-      recursive_remove_collection(cct, store, pgid, *it);
+      recursive_remove_collection(cct, store, pgid, pg->coll);
       continue;
     }
     {
@@ -5195,6 +5275,49 @@ void OSD::_add_heartbeat_peer(int p)
     hi = &i->second;
   }
   hi->epoch = get_osdmap_epoch();
+  hi->host = _get_heartbeat_host(p);
+}
+
+int OSD::_get_heartbeat_host(int p)
+{
+  auto osdmap = get_osdmap();
+  if (!osdmap) {
+    return 0;
+  }
+  int type = osdmap->crush->get_type_id("host");
+  if (type < 0) {
+    return 0;
+  }
+  return osdmap->crush->get_parent_of_type(p, type);
+}
+
+void OSD::_cancel_failure_report(int p, epoch_t e)
+{
+  auto failure_queue_entry = failure_queue.find(p);
+  if (failure_queue_entry != failure_queue.end()) {
+    dout(10) << "handle_osd_ping canceling queued "
+             << "failure report for osd." << p << dendl;
+    failure_queue.erase(failure_queue_entry);
+  }
+
+  auto failure_pending_entry = failure_pending.find(p);
+  if (failure_pending_entry != failure_pending.end()) {
+    dout(10) << "handle_osd_ping canceling in-flight "
+             << "failure report for osd." << p << dendl;
+    send_still_alive(e, p, failure_pending_entry->second.second);
+    failure_pending.erase(failure_pending_entry);
+  }
+}
+
+void OSD::_vouched_for(HeartbeatInfo& hi, utime_t now, epoch_t e)
+{
+  dout(25) << __func__ << " osd." << hi.peer << dendl;
+  hi.last_vouched = now;
+  hi.last_rx_back = now;
+  hi.last_rx_front = now;
+  // the pings in flight are answered for as well
+  hi.ping_history.clear();
+  _cancel_failure_report(hi.peer, e);
 }
 
 void OSD::_remove_heartbeat_peer(int n)
@@ -5270,6 +5393,19 @@ void OSD::maybe_update_heartbeat_peers()
   if (prev >= 0 && prev != next)
     want.insert(prev);
 
+  // the osds of our host, to vouch for them to the others
+  if (cct->_conf->osd_heartbeat_aggregate_hosts) {
+    int host = _get_heartbeat_host(whoami);
+    std::list<int> mates;
+    if (host < 0 && get_osdmap()->crush->get_children(host, &mates) > 0) {
+      for (auto o : mates) {
+	if (o >= 0 && o != whoami && get_osdmap()->is_up(o)) {
+	  want.insert(o);
+	}
+      }
+    }
+  }
+
   // make sure we have at least **min_down** osds coming from different
   // subtree level (e.g., hosts) for fast failure detection.
   auto min_down = cct->_conf.get_val<uint64_t>("mon_osd_min_down_reporters");
@@ -5440,15 +5576,24 @@ void OSD::handle_osd_ping(MOSDPing *m)
 	break;
       }
 
-      Message *r = new MOSDPing(monc->get_fsid(),
-				curmap->get_epoch(),
-				MOSDPing::PING_REPLY,
-				m->ping_stamp,
-				m->mono_ping_stamp,
-				mnow,
-				service.get_up_epoch(),
-				cct->_conf->osd_heartbeat_min_size,
-				sender_delta_ub);
+      auto r = new MOSDPing(monc->get_fsid(),
+			    curmap->get_epoch(),
+			    MOSDPing::PING_REPLY,
+			    m->ping_stamp,
+			    m->mono_ping_stamp,
+			    mnow,
+			    service.get_up_epoch(),
+			    cct->_conf->osd_heartbeat_min_size,
+			    sender_delta_ub);
+      // vouch for the osds of our host we heard from lately
+      for (auto p : m->host_peers) {
+	auto i = heartbeat_peers.find(p);
+	if (i != heartbeat_peers.end() && i->second.is_healthy(now) &&
+	    now - std::min(i->second.last_rx_back, i->second.last_rx_front) <
+	      2 * cct->_conf->osd_heartbeat_interval) {
+	  r->host_peers.push_back(p);
+	}
+      }
       con->send_message(r);
 
       if (curmap->is_up(from)) {
@@ -5499,6 +5644,13 @@ void OSD::handle_osd_ping(MOSDPing *m)
               ceph_assert(unacknowledged > 0);
               --unacknowledged;
             }
+            for (auto p : m->host_peers) {
+              auto v = heartbeat_peers.find(p);
+              if (p != from && v != heartbeat_peers.end() &&
+                  v->second.host == i->second.host) {
+                _vouched_for(v->second, now, curmap->get_epoch());
+              }
+            }
           } else if (con == i->second.con_front) {
             dout(25) << "handle_osd_ping got reply from osd." << from
                      << " first_tx " << i->second.first_tx
@@ -5648,22 +5800,7 @@ void OSD::handle_osd_ping(MOSDPing *m)
 
           if (i->second.is_healthy(now)) {
             // Cancel false reports
-            auto failure_queue_entry = failure_queue.find(from);
-            if (failure_queue_entry != failure_queue.end()) {
-              dout(10) << "handle_osd_ping canceling queued "
-                       << "failure report for osd." << from << dendl;
-              failure_queue.erase(failure_queue_entry);
-            }
-
-            auto failure_pending_entry = failure_pending.find(from);
-            if (failure_pending_entry != failure_pending.end()) {
-              dout(10) << "handle_osd_ping canceling in-flight "
-                       << "failure report for osd." << from << dendl;
-              send_still_alive(curmap->get_epoch(),
-                               from,
-                               failure_pending_entry->second.second);
-              failure_pending.erase(failure_pending_entry);
-            }
+            _cancel_failure_report(from, curmap->get_epoch());
           }
         } else {
           // old replies, deprecated by newly sent pings.
@@ -5820,6 +5957,28 @@ void OSD::heartbeat()
   utime_t deadline = now;
   deadline += cct->_conf->osd_heartbeat_grace;
 
+  // with host aggregation the first healthy peer of each other host is
+  // asked about the rest of them, which are not pinged while it vouches
+  std::map<int, std::vector<int32_t>> vouch_for;  ///< peer -> its host mates
+  std::set<int> vouched;
+  if (cct->_conf->osd_heartbeat_aggregate_hosts) {
+    const int my_host = _get_heartbeat_host(whoami);
+    std::map<int, int> host_peer;
+    for (auto& [peer, hi] : heartbeat_peers) {
+      if (hi.host >= 0 || hi.host == my_host || !hi.is_healthy(now)) {
+	continue;
+      }
+      auto [p, inserted] = host_peer.emplace(hi.host, peer);
+      if (inserted) {
+	continue;
+      }
+      vouch_for[p->second].push_back(peer);
+      if (now - hi.last_vouched < cct->_conf->osd_heartbeat_interval) {
+	vouched.insert(peer);
+      }
+    }
+  }
+
   // send heartbeats
   for (map<int,HeartbeatInfo>::iterator i = heartbeat_peers.begin();
        i != heartbeat_peers.end();
@@ -5830,6 +5989,11 @@ void OSD::heartbeat()
       dout(30) << "heartbeat osd." << peer << " has no open con" << dendl;
       continue;
     }
+    if (vouched.count(peer)) {
+      dout(30) << "heartbeat osd." << peer << " vouched for at "
+	       << i->second.last_vouched << dendl;
+      continue;
+    }
     dout(30) << "heartbeat sending ping to osd." << peer << dendl;
 
     i->second.last_tx = now;
@@ -5843,16 +6007,19 @@ void OSD::heartbeat()
     std::optional<ceph::signedspan> delta_ub;
     s->stamps->sent_ping(&delta_ub);
 
-    i->second.con_back->send_message(
-      new MOSDPing(monc->get_fsid(),
-		   service.get_osdmap_epoch(),
-		   MOSDPing::PING,
-		   now,
-		   mnow,
-		   mnow,
-		   service.get_up_epoch(),
-		   cct->_conf->osd_heartbeat_min_size,
-		   delta_ub));
+    auto ping = new MOSDPing(monc->get_fsid(),
+			     service.get_osdmap_epoch(),
+			     MOSDPing::PING,
+			     now,
+			     mnow,
+			     mnow,
+			     service.get_up_epoch(),
+			     cct->_conf->osd_heartbeat_min_size,
+			     delta_ub);
+    if (auto v = vouch_for.find(peer); v != vouch_for.end()) {
+      ping->host_peers = v->second;
+    }
+    i->second.con_back->send_message(ping);
 
     if (i->second.con_front)
       i->second.con_front->send_message(
@@ -7707,14 +7874,25 @@ void OSD::resched_all_scrubs()
   dout(10) << __func__ << ": done" << dendl;
 }
 
-MPGStats* OSD::collect_pg_stats()
+MPGStats* OSD::collect_pg_stats(bool full)
 {
-  // This implementation unconditionally sends every is_primary PG's
-  // stats every time we're called.  This has equivalent cost to the
-  // previous implementation's worst case where all PGs are busy and
-  // their stats are always enqueued for sending.
+  // Every is_primary PG's stats are sent on a new mgr session and every
+  // osd_pg_stats_full_interval.  In between, only those of PGs that
+  // published new stats since they were last sent: the mgr keeps the
+  // others, and PGs publish at least every osd_pg_stat_report_interval_max.
   std::shared_lock l{map_lock};
 
+  auto now = ceph::coarse_mono_clock::now();
+  auto full_interval = cct->_conf.get_val<double>("osd_pg_stats_full_interval");
+  if (full_interval <= 0 ||
+      now - last_full_pg_stats >= ceph::make_timespan(full_interval)) {
+    full = true;
+  }
+  if (full) {
+    last_full_pg_stats = now;
+    pg_stats_sent.clear();
+  }
+
   osd_stat_t cur_stat = service.get_osd_stat();
   cur_stat.os_perf_stat = store->get_cur_stats();
 
@@ -7735,11 +7913,29 @@ MPGStats* OSD::collect_pg_stats()
       continue;
     }
     pg->with_pg_stats([&](const pg_stat_t& s, epoch_t lec) {
-	m->pg_stat[pg->pg_id.pgid] = s;
+	auto [p, inserted] = pg_stats_sent.try_emplace(pg->pg_id.pgid);
+	if (inserted || p->second != s.get_version_pair()) {
+	  p->second = s.get_version_pair();
+	  m->pg_stat[pg->pg_id.pgid] = s;
+	}
 	min_last_epoch_clean = std::min(min_last_epoch_clean, lec);
 	min_last_epoch_clean_pgs.push_back(pg->pg_id.pgid);
       });
   }
+  if (!full && pg_stats_sent.size() > min_last_epoch_clean_pgs.size()) {
+    // forget the pgs we are no longer primary for
+    std::set<pg_t> reported(min_last_epoch_clean_pgs.begin(),
+			    min_last_epoch_clean_pgs.end());
+    for (auto p = pg_stats_sent.begin(); p != pg_stats_sent.end(); ) {
+      if (reported.count(p->first)) {
+	++p;
+      } else {
+	p = pg_stats_sent.erase(p);
+      }
+    }
+  }
+  dout(20) << __func__ << (full ? " full, " : " ") << m->pg_stat.size()
+	   << " of " << min_last_epoch_clean_pgs.size() << " pgs" << dendl;
   store_statfs_t st;
   bool per_pool_stats = false;
   bool per_pool_omap_stats = false;
@@ -8729,10 +8925,12 @@ bool OSD::advance_pg(
 	    unsigned new_pg_num = nextmap->get_pg_num(pg->pg_id.pool());
 	    unsigned split_bits = pg->pg_id.get_split_bits(new_pg_num);
 	    dout(1) << __func__ << " merging " << pg->pg_id << dendl;
+	    utime_t start = ceph_clock_now();
 	    pg->merge_from(
 	      sources, rctx, split_bits,
 	      nextmap->get_pg_pool(
 		pg->pg_id.pool())->last_pg_merge_meta);
+	    logger->tinc(l_osd_pg_merge_lat, ceph_clock_now() - start);
 	    pg->pg_slot->waiting_for_merge_epoch = 0;
 	  } else {
 	    dout(20) << __func__ << " not ready to merge yet" << dendl;
@@ -9097,6 +9295,7 @@ void OSD::split_pgs(
   OSDMapRef nextmap,
   PeeringCtx &rctx)
 {
+  utime_t start = ceph_clock_now();
   unsigned pg_num = nextmap->get_pg_num(parent->pg_id.pool());
   parent->update_snap_mapper_bits(parent->get_pgid().get_split_bits(pg_num));
 
@@ -9142,6 +9341,7 @@ void OSD::split_pgs(
   }
   ceph_assert(stat_iter != updated_stats.end());
   parent->finish_split_stats(*stat_iter, rctx.transaction);
+  logger->tinc(l_osd_pg_split_lat, ceph_clock_now() - start);
 }
 
 /*
@@ -9261,7 +9461,8 @@ void OSD::dispatch_context(PeeringCtx &ctx, PG *pg, OSDMapRef curmap,
 	continue;
       }
       ConnectionRef con = service.get_con_osd_cluster(
-	osd, curmap->get_epoch());
+	osd, curmap->get_epoch(),
+	pg ? service.get_cluster_lane(pg->pg_id) : 0);
       if (!con) {
 	dout(20) << __func__ << " skipping osd." << osd << " (NULL con)"
 		 << dendl;
@@ -9914,6 +10115,8 @@ const char** OSD::get_tracked_conf_keys() const
     "osd_op_history_slow_op_size",
     "osd_op_history_slow_op_threshold",
     "osd_enable_op_tracker",
+    "osd_op_tracker_sample_interval",
+    "osd_op_history_slow_op_log",
     "osd_map_cache_size",
     "osd_pg_epoch_max_lag_factor",
     "osd_pg_epoch_persisted_max_stale",
@@ -10011,6 +10214,12 @@ void OSD::handle_conf_change(const ConfigProxy& conf,
   if (changed.count("osd_enable_op_tracker")) {
       op_tracker.set_tracking(cct->_conf->osd_enable_op_tracker);
   }
+  if (changed.count("osd_op_tracker_sample_interval")) {
+    op_tracker.set_sample_interval(cct->_conf->osd_op_tracker_sample_interval);
+  }
+  if (changed.count("osd_op_history_slow_op_log")) {
+    op_tracker.set_log_slow_ops(cct->_conf->osd_op_history_slow_op_log);
+  }
   if (changed.count("osd_map_cache_size")) {
     service.map_cache.set_size(cct->_conf->osd_map_cache_size);
     service.map_bl_cache.set_size(cct->_conf->osd_map_cache_size);
@@ -10210,13 +10419,14 @@ MetricPayload OSD::get_perf_reports() {
 
   std::vector<PGRef> pgs;
   _get_pgs(&pgs);
-  DynamicPerfStats dps;
+  auto max_keys = cct->_conf.get_val<uint64_t>("osd_perf_query_max_keys");
+  DynamicPerfStats dps(m_perf_queries, max_keys);
   for (auto& pg : pgs) {
     // m_perf_queries can be modified only in set_perf_queries by mgr client
     // request, and it is protected by by mgr client's lock, which is held
     // when set_perf_queries/get_perf_reports are called, so we may not hold
     // m_perf_queries_lock here.
-    DynamicPerfStats pg_dps(m_perf_queries);
+    DynamicPerfStats pg_dps(m_perf_queries, max_keys);
     pg->lock();
     pg->get_dynamic_perf_stats(&pg_dps);
     pg->unlock();
@@ -10674,10 +10884,27 @@ void OSD::ShardedOpWQ::_add_slot_waiter(
 #undef dout_prefix
 #define dout_prefix *_dout << "osd." << osd->whoami << " op_wq(" << shard_index << ") "
 
+OSDShard *OSD::ShardedOpWQ::_try_steal_shard(uint32_t shard_index)
+{
+  // only look at shards we can lock right away; a shard whose lock is
+  // busy has threads of its own making progress.
+  for (uint32_t i = 1; i < osd->num_shards; i++) {
+    OSDShard *victim = osd->shards[(shard_index + i) % osd->num_shards];
+    if (!victim->shard_lock.try_lock()) {
+      continue;
+    }
+    if (!victim->scheduler->empty()) {
+      return victim;  // with shard_lock held
+    }
+    victim->shard_lock.unlock();
+  }
+  return nullptr;
+}
+
 void OSD::ShardedOpWQ::_process(uint32_t thread_index, heartbeat_handle_d *hb)
 {
   uint32_t shard_index = thread_index % osd->num_shards;
-  auto& sdata = osd->shards[shard_index];
+  OSDShard *sdata = osd->shards[shard_index];
   ceph_assert(sdata);
 
   // If all threads of shards do oncommits, there is a out-of-order
@@ -10686,8 +10913,30 @@ void OSD::ShardedOpWQ::_process(uint32_t thread_index, heartbeat_handle_d *hb)
   // callback.
   bool is_smallest_thread_index = thread_index < osd->num_shards;
 
+  // true if we are helping another shard with its queue
+  bool stolen = false;
+
   // peek at spg_t
   sdata->shard_lock.lock();
+  if (sdata->scheduler->empty() &&
+      (!is_smallest_thread_index || sdata->context_queue.empty())) {
+    OSDShard *victim = nullptr;
+    if (osd->num_shards > 1 && !sdata->stop_waiting &&
+	osd->cct->_conf.get_val<bool>("osd_op_shard_steal")) {
+      victim = _try_steal_shard(shard_index);
+    }
+    if (victim) {
+      // items of a pg are still ordered by its slot and pg lock, so we
+      // simply act as one more thread of the victim shard for this item
+      dout(20) << __func__ << " empty q, stealing from shard "
+	       << victim->shard_id << dendl;
+      sdata->shard_lock.unlock();
+      sdata = victim;
+      is_smallest_thread_index = false;
+      stolen = true;
+      osd->logger->inc(l_osd_op_wq_steal);
+    }
+  }
   if (sdata->scheduler->empty() &&
       (!is_smallest_thread_index || sdata->context_queue.empty())) {
     std::unique_lock wait_lock{sdata->sdata_wait_lock};
@@ -10751,7 +11000,7 @@ void OSD::ShardedOpWQ::_process(uint32_t thread_index, heartbeat_handle_d *hb)
     // If the work item is scheduled in the future, wait until
     // the time returned in the dequeue response before retrying.
     if (auto when_ready = std::get_if<double>(&work_item)) {
-      if (is_smallest_thread_index) {
+      if (is_smallest_thread_index || stolen) {
         sdata->shard_lock.unlock();
         handle_oncommits(oncommits);
         return;
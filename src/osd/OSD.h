@@ -245,7 +245,12 @@ public:
   MOSDMap *build_incremental_map_msg(epoch_t from, epoch_t to,
                                        OSDSuperblock& superblock);
 
-  ConnectionRef get_con_osd_cluster(int peer, epoch_t from_epoch);
+  /// messages of a PG all go through the same session with a peer, so
+  /// that they stay ordered: the cluster messenger may open several
+  unsigned get_cluster_lane(const spg_t& pgid) const;
+  unsigned get_cluster_lane(const Message* m) const;
+  ConnectionRef get_con_osd_cluster(int peer, epoch_t from_epoch,
+				    unsigned lane = 0);
   std::pair<ConnectionRef,ConnectionRef> get_con_osd_hb(int peer, epoch_t from_epoch);  // (back, front)
   void send_message_osd_cluster(int peer, Message *m, epoch_t from_epoch);
   void send_message_osd_cluster(std::vector<std::pair<int, Message*>>& messages, epoch_t from_epoch);
@@ -1394,6 +1399,8 @@ private:
     utime_t last_rx_front;  ///< last time we got a ping reply on the front side
     utime_t last_rx_back;   ///< last time we got a ping reply on the back side
     epoch_t epoch;      ///< most recent epoch we wanted this peer
+    int host = 0;       ///< crush host of the peer, 0 if unknown
+    utime_t last_vouched;  ///< last time an osd of its host vouched for it
     /// number of connections we send and receive heartbeat pings/replies
     static constexpr int HEARTBEAT_MAX_CONN = 2;
     /// history of inflight pings, arranging by timestamp we sent
@@ -1481,6 +1488,9 @@ private:
 
   void _add_heartbeat_peer(int p);
   void _remove_heartbeat_peer(int p);
+  int _get_heartbeat_host(int p);
+  void _cancel_failure_report(int p, epoch_t e);
+  void _vouched_for(HeartbeatInfo& hi, utime_t now, epoch_t e);
   bool heartbeat_reset(Connection *con);
   void maybe_update_heartbeat_peers();
   void reset_heartbeat_peers(bool all);
@@ -1612,6 +1622,9 @@ protected:
       OSDShardPGSlot *slot,
       OpSchedulerItem&& qi);
 
+    /// lock and return another shard with queued work, if any
+    OSDShard *_try_steal_shard(uint32_t shard_index);
+
     /// try to do some work
     void _process(uint32_t thread_index, ceph::heartbeat_handle_d *hb) override;
 
@@ -1944,7 +1957,11 @@ protected:
   bool scrub_time_permit(utime_t now);
 
   // -- status reporting --
-  MPGStats *collect_pg_stats();
+  /// the stats of all primary pgs if @p full, else of those changed since
+  MPGStats *collect_pg_stats(bool full);
+  /// (reported_epoch, reported_seq) of the pg stats last sent to the mgr
+  std::map<pg_t, std::pair<epoch_t, version_t>> pg_stats_sent;
+  ceph::coarse_mono_clock::time_point last_full_pg_stats;
   std::vector<DaemonHealthMetric> get_health_metrics();
 
 
@@ -2080,6 +2097,7 @@ public:
 
   int enable_disable_fuse(bool stop);
   int set_numa_affinity();
+  void set_split_numa_affinity(int net_node, int store_node);
 
   void suicide(int exitcode);
   int shutdown();
@@ -18,6 +18,7 @@
 #include <algorithm>
 #include <optional>
 #include <random>
+#include <thread>
 
 #include <boost/algorithm/string.hpp>
 
@@ -1401,6 +1402,9 @@ void OSDMap::set_max_osd(int m)
   osd_weight.resize(max_osd, CEPH_OSD_OUT);
   osd_info.resize(max_osd);
   osd_xinfo.resize(max_osd);
+  _cow(osd_addrs);
+  _cow(osd_uuid);
+  _cow(osd_primary_affinity);
   osd_addrs->client_addrs.resize(max_osd);
   osd_addrs->cluster_addrs.resize(max_osd);
   osd_addrs->hb_back_addrs.resize(max_osd);
@@ -1741,6 +1745,7 @@ void OSDMap::dedup(const OSDMap *o, OSDMap *n)
   // do addrs match?
   if (o->max_osd != n->max_osd)
     diff++;
+  _cow(n->osd_addrs);
   for (int i = 0; i < o->max_osd && i < n->max_osd; i++) {
     if ( n->osd_addrs->client_addrs[i] &&  o->osd_addrs->client_addrs[i] &&
 	*n->osd_addrs->client_addrs[i] == *o->osd_addrs->client_addrs[i])
@@ -2172,6 +2177,21 @@ int OSDMap::apply_incremental(const Incremental &inc)
     set_erasure_code_profile(profile.first, profile.second);
   }
   
+  if (!inc.new_state.empty() ||
+      !inc.new_up_client.empty() ||
+      !inc.new_up_cluster.empty()) {
+    _cow(osd_addrs);
+  }
+  if (!inc.new_state.empty() || !inc.new_uuid.empty()) {
+    _cow(osd_uuid);
+  }
+  if (!inc.new_pg_temp.empty()) {
+    _cow(pg_temp);
+  }
+  if (!inc.new_primary_temp.empty()) {
+    _cow(primary_temp);
+  }
+
   // up/down
   for (const auto &state : inc.new_state) {
     const auto osd = state.first;
@@ -2667,11 +2687,14 @@ void OSDMap::pg_to_raw_up(pg_t pg, vector<int> *up, int *primary) const
 void OSDMap::_pg_to_up_acting_osds(
   const pg_t& pg, vector<int> *up, int *up_primary,
   vector<int> *acting, int *acting_primary,
-  bool raw_pg_to_pg) const
+  bool raw_pg_to_pg,
+  vector<int> *raw_upmap) const
 {
   const pg_pool_t *pool = get_pg_pool(pg.pool());
   if (!pool ||
       (!raw_pg_to_pg && pg.ps() >= pool->get_pg_num())) {
+    if (raw_upmap)
+      raw_upmap->clear();
     if (up)
       up->clear();
     if (up_primary)
@@ -2689,10 +2712,12 @@ void OSDMap::_pg_to_up_acting_osds(
   int _acting_primary;
   ps_t pps;
   _get_temp_osds(*pool, pg, &_acting, &_acting_primary);
-  if (_acting.empty() || up || up_primary) {
+  if (_acting.empty() || up || up_primary || raw_upmap) {
     _pg_to_raw_osds(*pool, pg, &raw, &pps);
     _apply_upmap(*pool, pg, &raw);
     _raw_to_up_osds(*pool, raw, &_up);
+    if (raw_upmap)
+      *raw_upmap = raw;
     _up_primary = _pick_primary(_up);
     _apply_primary_affinity(pps, *pool, &_up, &_up_primary);
     if (_acting.empty()) {
@@ -3249,6 +3274,11 @@ void OSDMap::decode_classic(ceph::buffer::list::const_iterator& p)
 void OSDMap::decode(ceph::buffer::list::const_iterator& bl)
 {
   using ceph::decode;
+  // we decode into these in place
+  _cow(osd_addrs);
+  _cow(pg_temp);
+  _cow(primary_temp);
+  _cow(osd_uuid);
   /**
    * Older encodings of the OSDMap had a single struct_v which
    * covered the whole encoding, and was prior to our modern
@@ -4631,6 +4661,33 @@ bool OSDMap::try_pg_upmap(
   return true;
 }
 
+// run f(i) for each i in [0, n), spread over up to @p threads threads
+template<typename F>
+static void parallel_for(unsigned threads, size_t n, F&& f)
+{
+  threads = std::min<size_t>(threads, n);
+  if (threads <= 1) {
+    for (size_t i = 0; i < n; ++i) {
+      f(i);
+    }
+    return;
+  }
+  std::atomic<size_t> next = 0;
+  auto worker = [&] {
+    for (size_t i = next++; i < n; i = next++) {
+      f(i);
+    }
+  };
+  vector<std::thread> workers;
+  for (unsigned t = 1; t < threads; ++t) {
+    workers.emplace_back(worker);
+  }
+  worker();
+  for (auto& t : workers) {
+    t.join();
+  }
+}
+
 int OSDMap::calc_pg_upmaps(
   CephContext *cct,
   uint32_t max_deviation,
@@ -4644,6 +4701,8 @@ int OSDMap::calc_pg_upmaps(
   if (max_deviation < 1)
     max_deviation = 1;
   tmp.deepish_copy_from(*this);
+  const unsigned threads = std::max<uint64_t>(
+    cct->_conf.get_val<uint64_t>("osd_calc_pg_upmaps_threads"), 1);
   int num_changed = 0;
   map<int,set<pg_t>> pgs_by_osd;
   int total_pgs = 0;
@@ -4652,10 +4711,14 @@ int OSDMap::calc_pg_upmaps(
   for (auto& i : pools) {
     if (!only_pools.empty() && !only_pools.count(i.first))
       continue;
+    vector<vector<int>> pool_up(i.second.get_pg_num());
+    parallel_for(threads, pool_up.size(), [&](size_t ps) {
+      tmp.pg_to_up_acting_osds(pg_t(ps, i.first), &pool_up[ps],
+			       nullptr, nullptr, nullptr);
+    });
     for (unsigned ps = 0; ps < i.second.get_pg_num(); ++ps) {
       pg_t pg(ps, i.first);
-      vector<int> up;
-      tmp.pg_to_up_acting_osds(pg, &up, nullptr, nullptr, nullptr);
+      auto& up = pool_up[ps];
       ldout(cct, 20) << __func__ << " " << pg << " up " << up << dendl;
       for (auto osd : up) {
         if (osd != CRUSH_ITEM_NONE)
@@ -4870,7 +4933,29 @@ int OSDMap::calc_pg_upmaps(
       }
 
       // try upmap
-      for (auto pg : pgs) {
+      // crush works out the alternatives for a window of pgs at a time,
+      // on several threads, and they are then looked at in order.  the
+      // first one that helps is taken, just as if they were done one by
+      // one.
+      struct remap_t {
+        bool found = false;
+        vector<int> orig, out;
+      };
+      const size_t window = threads > 1 ? threads * 4 : 1;
+      vector<remap_t> remaps;
+      for (size_t n = 0; n < pgs.size(); ++n) {
+        if (n % window == 0) {
+          remaps.assign(std::min(window, pgs.size() - n), remap_t());
+          parallel_for(threads, remaps.size(), [&](size_t k) {
+            auto& r = remaps[k];
+            vector<int> raw;
+            // including existing upmaps too
+            tmp.pg_to_raw_upmap(pgs[n + k], &raw, &r.orig);
+            r.found = try_pg_upmap(cct, pgs[n + k], overfull, underfull,
+                                   more_underfull, &r.orig, &r.out);
+          });
+        }
+        auto pg = pgs[n];
         auto temp_it = tmp.pg_upmap.find(pg);
         if (temp_it != tmp.pg_upmap.end()) {
           // leave pg_upmap alone
@@ -4905,9 +4990,8 @@ int OSDMap::calc_pg_upmaps(
           // to see if we can append more remapping pairs
         }
 	ldout(cct, 10) << " trying " << pg << dendl;
-        vector<int> raw, orig, out;
-        tmp.pg_to_raw_upmap(pg, &raw, &orig); // including existing upmaps too
-	if (!try_pg_upmap(cct, pg, overfull, underfull, more_underfull, &orig, &out)) {
+        auto& [found, orig, out] = remaps[n % window];
+	if (!found) {
 	  continue;
 	}
 	ldout(cct, 10) << " " << pg << " " << orig << " -> " << out << dendl;
@@ -619,6 +619,16 @@ private:
   uint32_t get_crc() const { return crc; }
 
   std::shared_ptr<CrushWrapper> crush;       // hierarchical map
+
+  /// copy a member that may be shared with another epoch before
+  /// modifying it.  copies of a map are only ever made by the thread
+  /// that owns it, so a use_count of 1 cannot go up behind our back.
+  template <typename T>
+  static void _cow(std::shared_ptr<T>& p) {
+    if (p && p.use_count() > 1) {
+      p.reset(new T(*p));
+    }
+  }
   bool stretch_mode_enabled; // we are in stretch mode, requiring multiple sites
   uint32_t stretch_bucket_count; // number of sites we expect to be in
   uint32_t degraded_stretch_mode; // 0 if not degraded; else count of up sites
@@ -662,15 +672,9 @@ public:
 
   void deepish_copy_from(const OSDMap& o) {
     *this = o;
-    primary_temp.reset(new mempool::osdmap::map<pg_t,int32_t>(*o.primary_temp));
-    pg_temp.reset(new PGTempMap(*o.pg_temp));
-    osd_uuid.reset(new mempool::osdmap::vector<uuid_d>(*o.osd_uuid));
-
-    if (o.osd_primary_affinity)
-      osd_primary_affinity.reset(new mempool::osdmap::vector<__u32>(*o.osd_primary_affinity));
-
-    // NOTE: this still references shared entity_addrvec_t's.
-    osd_addrs.reset(new addrs_s(*o.osd_addrs));
+    // NOTE: primary_temp, pg_temp, osd_uuid, osd_primary_affinity and
+    // osd_addrs stay shared with o until we modify them (see _cow()), so
+    // that consecutive epochs only pay for what actually changed.
 
     // NOTE: we do not copy crush.  note that apply_incremental will
     // allocate a new CrushWrapper, though.
@@ -789,6 +793,8 @@ public:
       osd_primary_affinity.reset(
 	new mempool::osdmap::vector<__u32>(
 	  max_osd, CEPH_OSD_DEFAULT_PRIMARY_AFFINITY));
+    else
+      _cow(osd_primary_affinity);
     (*osd_primary_affinity)[o] = w;
   }
   unsigned get_primary_affinity(int o) const {
@@ -1205,7 +1211,8 @@ private:
    */
   void _pg_to_up_acting_osds(const pg_t& pg, std::vector<int> *up, int *up_primary,
                              std::vector<int> *acting, int *acting_primary,
-			     bool raw_pg_to_pg = true) const;
+			     bool raw_pg_to_pg = true,
+			     std::vector<int> *raw_upmap = nullptr) const;
 
 public:
   /***
@@ -1245,6 +1252,14 @@ public:
     int up_primary, acting_primary;
     pg_to_up_acting_osds(pg, &up, &up_primary, &acting, &acting_primary);
   }
+  /// as above, also returning the raw mapping with upmaps applied
+  void pg_to_raw_upmap_up_acting_osds(
+    pg_t pg, std::vector<int> *raw_upmap,
+    std::vector<int> *up, int *up_primary,
+    std::vector<int> *acting, int *acting_primary) const {
+    _pg_to_up_acting_osds(pg, up, up_primary, acting, acting_primary,
+			  true, raw_upmap);
+  }
   bool pg_is_ec(pg_t pg) const {
     auto i = pools.find(pg.pool());
     ceph_assert(i != pools.end());
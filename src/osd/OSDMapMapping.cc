@@ -15,7 +15,8 @@ MEMPOOL_DEFINE_OBJECT_FACTORY(OSDMapMapping, osdmapmapping,
 
 // ensure that we have a PoolMappings for each pool and that
 // the dimensions (pg_num and size) match up.
-void OSDMapMapping::_init_mappings(const OSDMap& osdmap)
+void OSDMapMapping::_init_mappings(const OSDMap& osdmap,
+				   std::set<int64_t> *new_pools)
 {
   num_pgs = 0;
   auto q = pools.begin();
@@ -39,6 +40,9 @@ void OSDMapMapping::_init_mappings(const OSDMap& osdmap)
     pools.emplace(p.first, PoolMapping(p.second.get_size(),
 				       p.second.get_pg_num(),
 				       p.second.is_erasure()));
+    if (new_pools) {
+      new_pools->insert(p.first);
+    }
   }
   pools.erase(q, pools.end());
   ceph_assert(pools.size() == osdmap.get_pools().size());
@@ -59,13 +63,152 @@ void OSDMapMapping::update(const OSDMap& osdmap, pg_t pgid)
   _update_range(osdmap, pgid.pool(), pgid.ps(), pgid.ps() + 1);
 }
 
+void OSDMapMapping::note_incremental(const OSDMap::Incremental& inc)
+{
+  if (pending.last && inc.epoch != pending.last + 1) {
+    pending.full = true;
+  }
+  if (!pending.first) {
+    pending.first = inc.epoch;
+  }
+  pending.last = inc.epoch;
+  if (pending.full) {
+    return;
+  }
+
+  // anything that changes the crush inputs may move any pg
+  if (inc.fullmap.length() ||
+      inc.crush.length() ||
+      inc.new_max_osd >= 0 ||
+      !inc.new_weight.empty()) {
+    pending.full = true;
+    return;
+  }
+  for (auto& [osd, new_state] : inc.new_state) {
+    // a 0 state means CEPH_OSD_UP for compatibility, see apply_incremental()
+    uint32_t state = new_state ? new_state : CEPH_OSD_UP;
+    if (state & CEPH_OSD_EXISTS) {
+      pending.full = true;
+      return;
+    }
+    if (state & CEPH_OSD_UP) {
+      pending.osds.insert(osd);
+    }
+  }
+  for (auto& p : inc.new_up_client) {
+    pending.osds.insert(p.first);
+  }
+  for (auto& p : inc.new_primary_affinity) {
+    pending.osds.insert(p.first);
+  }
+  for (auto& p : inc.new_pools) {
+    pending.pools.insert(p.first);
+  }
+  for (auto& p : inc.new_pg_temp) {
+    pending.pgs.insert(p.first);
+  }
+  for (auto& p : inc.new_primary_temp) {
+    pending.pgs.insert(p.first);
+  }
+  for (auto& p : inc.new_pg_upmap) {
+    pending.pgs.insert(p.first);
+  }
+  for (auto& p : inc.new_pg_upmap_items) {
+    pending.pgs.insert(p.first);
+  }
+  pending.pgs.insert(inc.old_pg_upmap.begin(), inc.old_pg_upmap.end());
+  pending.pgs.insert(inc.old_pg_upmap_items.begin(),
+		     inc.old_pg_upmap_items.end());
+}
+
+void OSDMapMapping::_get_pending_pgs(
+  std::set<int64_t>& new_pools,
+  std::vector<pg_t> *pgs)
+{
+  new_pools.insert(pending.pools.begin(), pending.pools.end());
+  std::set<pg_t> affected;
+  for (auto& pgid : pending.pgs) {
+    if (!new_pools.count(pgid.pool())) {
+      affected.insert(pgid);
+    }
+  }
+  // the up set and primary of a pg only depend on the state of the osds
+  // crush picked for it; a pg_temp may also name the osd.  the rmaps
+  // still describe the last complete mapping, which every pg we do not
+  // remap keeps.
+  for (auto osd : pending.osds) {
+    if (osd < 0 || (unsigned)osd >= raw_rmap.size()) {
+      continue;
+    }
+    for (auto& pgid : raw_rmap[osd]) {
+      if (!new_pools.count(pgid.pool())) {
+	affected.insert(pgid);
+      }
+    }
+    for (auto& pgid : acting_rmap[osd]) {
+      if (!new_pools.count(pgid.pool())) {
+	affected.insert(pgid);
+      }
+    }
+  }
+  for (auto& pgid : affected) {
+    auto p = pools.find(pgid.pool());
+    if (p != pools.end() && pgid.ps() < p->second.pg_num) {
+      pgs->push_back(pgid);
+    }
+  }
+  for (auto pool : new_pools) {
+    auto p = pools.find(pool);
+    if (p == pools.end()) {
+      continue;
+    }
+    for (unsigned ps = 0; ps < p->second.pg_num; ++ps) {
+      pgs->push_back(pg_t(ps, pool));
+    }
+  }
+}
+
+std::unique_ptr<OSDMapMapping::MappingJob> OSDMapMapping::start_update(
+  const OSDMap& map,
+  ParallelPGMapper& mapper,
+  unsigned pgs_per_item)
+{
+  bool incremental = valid && !pending.full &&
+    (pending.first ?
+     (pending.first == epoch + 1 && pending.last == map.get_epoch()) :
+     epoch == map.get_epoch());
+  if (!incremental) {
+    pending = pending_t();
+    std::unique_ptr<MappingJob> job(new MappingJob(&map, this));
+    mapper.queue(job.get(), pgs_per_item, {});
+    return job;
+  }
+
+  std::set<int64_t> new_pools;
+  std::unique_ptr<MappingJob> job(new MappingJob(&map, this, &new_pools));
+  std::vector<pg_t> pgs;
+  _get_pending_pgs(new_pools, &pgs);
+  pending = pending_t();
+  if (pgs.empty()) {
+    job->finish = ceph_clock_now();
+    job->complete();
+  } else {
+    mapper.queue(job.get(), pgs_per_item, pgs);
+  }
+  return job;
+}
+
 void OSDMapMapping::_build_rmap(const OSDMap& osdmap)
 {
   acting_rmap.resize(osdmap.get_max_osd());
+  raw_rmap.resize(osdmap.get_max_osd());
   //up_rmap.resize(osdmap.get_max_osd());
   for (auto& v : acting_rmap) {
     v.resize(0);
   }
+  for (auto& v : raw_rmap) {
+    v.resize(0);
+  }
   //for (auto& v : up_rmap) {
   //  v.resize(0);
   //}
@@ -79,6 +222,13 @@ void OSDMapMapping::_build_rmap(const OSDMap& osdmap)
 	  acting_rmap[row[4 + i]].push_back(pgid);
 	}
       }
+      int32_t *raw_row = &row[4 + 2 * p.second.size];
+      for (int i = 0; i < raw_row[0]; ++i) {
+	if (raw_row[1 + i] >= 0 &&
+	    (unsigned)raw_row[1 + i] < raw_rmap.size()) {
+	  raw_rmap[raw_row[1 + i]].push_back(pgid);
+	}
+      }
       //for (int i = 0; i < row[3]; ++i) {
       //up_rmap[row[4 + p.second.size + i]].push_back(pgid);
       //}
@@ -90,6 +240,7 @@ void OSDMapMapping::_finish(const OSDMap& osdmap)
 {
   _build_rmap(osdmap);
   epoch = osdmap.get_epoch();
+  valid = true;
 }
 
 void OSDMapMapping::_dump()
@@ -115,12 +266,12 @@ void OSDMapMapping::_update_range(
   ceph_assert(pg_begin <= pg_end);
   ceph_assert(pg_end <= i->second.pg_num);
   for (unsigned ps = pg_begin; ps < pg_end; ++ps) {
-    std::vector<int> up, acting;
+    std::vector<int> raw, up, acting;
     int up_primary, acting_primary;
-    osdmap.pg_to_up_acting_osds(
+    osdmap.pg_to_raw_upmap_up_acting_osds(
       pg_t(ps, pool),
-      &up, &up_primary, &acting, &acting_primary);
-    i->second.set(ps, std::move(up), up_primary,
+      &raw, &up, &up_primary, &acting, &acting_primary);
+    i->second.set(ps, raw, std::move(up), up_primary,
 		  std::move(acting), acting_primary);
   }
 }
@@ -7,13 +7,13 @@
 
 #include <vector>
 #include <map>
+#include <set>
 
 #include "osd/osd_types.h"
+#include "osd/OSDMap.h"
 #include "common/WorkQueue.h"
 #include "common/Cond.h"
 
-class OSDMap;
-
 /// work queue to perform work on batches of pgids on multiple CPUs
 class ParallelPGMapper {
 public:
@@ -190,7 +190,9 @@ private:
 	1 + // num acting
 	1 + // num up
 	size + // acting
-	size;  // up
+	size + // up
+	1 + // num raw
+	size;  // raw (with upmaps applied)
     }
 
     PoolMapping(int s, int p, bool e)
@@ -227,6 +229,7 @@ private:
     }
 
     void set(size_t ps,
+	     const std::vector<int>& raw,
 	     const std::vector<int>& up,
 	     int up_primary,
 	     const std::vector<int>& acting,
@@ -245,17 +248,39 @@ private:
       for (int i = 0; i < row[3]; ++i) {
 	row[4 + size + i] = up[i];
       }
+      int32_t *raw_row = &row[4 + 2 * size];
+      raw_row[0] = std::min<int32_t>(raw.size(), size);
+      for (int i = 0; i < raw_row[0]; ++i) {
+	raw_row[1 + i] = raw[i];
+      }
     }
   };
 
   mempool::osdmap_mapping::map<int64_t,PoolMapping> pools;
   mempool::osdmap_mapping::vector<
     mempool::osdmap_mapping::vector<pg_t>> acting_rmap;  // osd -> pg
+  mempool::osdmap_mapping::vector<
+    mempool::osdmap_mapping::vector<pg_t>> raw_rmap;  // osd -> pg
   //unused: mempool::osdmap_mapping::vector<std::vector<pg_t>> up_rmap;  // osd -> pg
   epoch_t epoch = 0;
   uint64_t num_pgs = 0;
 
-  void _init_mappings(const OSDMap& osdmap);
+  /// true while the table matches epoch (no update started since)
+  bool valid = false;
+
+  /// changes noted since epoch, see note_incremental()
+  struct pending_t {
+    epoch_t first = 0, last = 0;  ///< noted incremental epochs
+    bool full = false;            ///< a change may affect every pg
+    std::set<int64_t> pools;
+    std::set<int> osds;
+    std::set<pg_t> pgs;
+  } pending;
+
+  void _init_mappings(const OSDMap& osdmap,
+		      std::set<int64_t> *new_pools = nullptr);
+  void _get_pending_pgs(std::set<int64_t>& new_pools,
+			std::vector<pg_t> *pgs);
   void _update_range(
     const OSDMap& map,
     int64_t pool,
@@ -263,8 +288,10 @@ private:
 
   void _build_rmap(const OSDMap& osdmap);
 
-  void _start(const OSDMap& osdmap) {
-    _init_mappings(osdmap);
+  void _start(const OSDMap& osdmap,
+	      std::set<int64_t> *new_pools = nullptr) {
+    valid = false;
+    _init_mappings(osdmap, new_pools);
   }
   void _finish(const OSDMap& osdmap);
 
@@ -274,11 +301,16 @@ private:
 
   struct MappingJob : public ParallelPGMapper::Job {
     OSDMapMapping *mapping;
-    MappingJob(const OSDMap *osdmap, OSDMapMapping *m)
+    MappingJob(const OSDMap *osdmap, OSDMapMapping *m,
+	       std::set<int64_t> *new_pools = nullptr)
       : Job(osdmap), mapping(m) {
-      mapping->_start(*osdmap);
+      mapping->_start(*osdmap, new_pools);
+    }
+    void process(const std::vector<pg_t>& pgs) override {
+      for (auto& pgid : pgs) {
+	mapping->_update_range(*osdmap, pgid.pool(), pgid.ps(), pgid.ps() + 1);
+      }
     }
-    void process(const std::vector<pg_t>& pgs) override {}
     void process(int64_t pool, unsigned ps_begin, unsigned ps_end) override {
       mapping->_update_range(*osdmap, pool, ps_begin, ps_end);
     }
@@ -331,14 +363,21 @@ public:
 
   void update(const OSDMap& map, pg_t pgid);
 
+  /// remember what inc changes, so that the next start_update() can
+  /// remap only the pgs it affects instead of every pg
+  void note_incremental(const OSDMap::Incremental& inc);
+
+  /**
+   * remap pgs for map in the background
+   *
+   * If the mapping is complete for an earlier epoch and every
+   * incremental since then was passed to note_incremental(), only the
+   * pgs those incrementals may have moved are recalculated.
+   */
   std::unique_ptr<MappingJob> start_update(
     const OSDMap& map,
     ParallelPGMapper& mapper,
-    unsigned pgs_per_item) {
-    std::unique_ptr<MappingJob> job(new MappingJob(&map, this));
-    mapper.queue(job.get(), pgs_per_item, {});
-    return job;
-  }
+    unsigned pgs_per_item);
 
   epoch_t get_epoch() const {
     return epoch;
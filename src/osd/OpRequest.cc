@@ -28,6 +28,8 @@ using std::set;
 using std::string;
 using std::stringstream;
 
+MEMPOOL_DEFINE_OBJECT_FACTORY(OpRequest, oprequest, osd);
+
 using ceph::Formatter;
 
 OpRequest::OpRequest(Message* req, OpTracker* tracker)
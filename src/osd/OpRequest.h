@@ -17,6 +17,7 @@
 #include "osd/osd_op_util.h"
 #include "osd/osd_types.h"
 #include "common/TrackedOp.h"
+#include "include/mempool.h"
 #ifdef HAVE_JAEGER
 #include "common/tracer.h"
 #endif
@@ -28,6 +29,9 @@
 struct OpRequest : public TrackedOp {
   friend class OpTracker;
 
+public:
+  MEMPOOL_CLASS_HELPERS();
+
 private:
   OpInfo op_info;
 
@@ -763,7 +763,7 @@ void PG::send_cluster_message(
   epoch_t epoch, bool share_map_update=false)
 {
   ConnectionRef con = osd->get_con_osd_cluster(
-    target, get_osdmap_epoch());
+    target, get_osdmap_epoch(), osd->get_cluster_lane(pg_id));
   if (!con) {
     return;
   }
@@ -634,7 +634,12 @@ int PGBackend::be_scan_list(
       o.attrs);
 
     if (pos.deep) {
+      auto start = ceph::mono_clock::now();
       r = be_deep_scrub(poid, map, pos, o);
+      double lat = std::chrono::duration<double>(
+	ceph::mono_clock::now() - start).count();
+      deep_scrub_step_lat = deep_scrub_step_lat ?
+	0.8 * deep_scrub_step_lat + 0.2 * lat : lat;
     }
     dout(25) << __func__ << "  " << poid << dendl;
   } else if (r == -ENOENT) {
@@ -57,7 +57,13 @@ typedef std::shared_ptr<const OSDMap> OSDMapRef;
    ObjectStore *store;
    const coll_t coll;
    ObjectStore::CollectionHandle &ch;
+   /// moving average of how long one deep scrub step (a stride of
+   /// data or a batch of omap keys) takes to read
+   double deep_scrub_step_lat = 0;
  public:
+   double get_deep_scrub_step_latency() const {
+     return deep_scrub_step_lat;
+   }
    /**
     * Provides interfaces for PGBackend callbacks
     *
@@ -262,6 +268,10 @@ typedef std::shared_ptr<const OSDMap> OSDMapRef;
      virtual void schedule_recovery_work(
        GenContext<ThreadPool::TPHandle&> *c) = 0;
 
+     /// complete @p c with the pg locked after @p delay seconds, unless
+     /// the pg has been reset in the meantime
+     virtual void schedule_event_after(double delay, Context *c) = 0;
+
      virtual pg_shard_t whoami_shard() const = 0;
      int whoami() const {
        return whoami_shard().osd;
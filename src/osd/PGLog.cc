@@ -641,7 +641,8 @@ void PGLog::write_log_and_missing(
       dirty_from_dups,
       write_from_dups,
       &may_include_deletes_in_missing_dirty,
-      (pg_log_debug ? &log_keys_debug : nullptr));
+      (pg_log_debug ? &log_keys_debug : nullptr),
+      log_batch);
     undirty();
   } else {
     dout(10) << "log is not dirty" << dendl;
@@ -713,6 +714,12 @@ void PGLog::_write_log_and_missing_wo_missing(
   // dout(10) << "write_log_and_missing, clearing up to " << dirty_to << dendl;
   if (touch_log)
     t.touch(coll, log_oid);
+  if (dirty_to == eversion_t::max()) {
+    t.omap_rmkeyrange(
+      coll, log_oid,
+      get_log_batch_key(0), get_log_batch_key(UINT64_MAX));
+    t.omap_rmkey(coll, log_oid, "log_batch_entries");
+  }
   if (dirty_to != eversion_t()) {
     t.omap_rmkeyrange(
       coll, log_oid,
@@ -825,63 +832,82 @@ void PGLog::_write_log_and_missing(
   eversion_t dirty_from_dups,
   eversion_t write_from_dups,
   bool *may_include_deletes_in_missing_dirty, // in/out param
-  set<string> *log_keys_debug
+  set<string> *log_keys_debug,
+  unsigned log_batch
   ) {
   set<string> to_remove;
   to_remove.swap(trimmed_dups);
-  for (auto& t : trimmed) {
-    string key = t.get_key_name();
-    if (log_keys_debug) {
-      auto it = log_keys_debug->find(key);
-      ceph_assert(it != log_keys_debug->end());
-      log_keys_debug->erase(it);
+  if (log_batch) {
+    if (touch_log)
+      t.touch(coll, log_oid);
+    _write_log_batches(
+      t, km, log, coll, log_oid, log_batch,
+      dirty_to, dirty_from, writeout_from, trimmed, &to_remove);
+    trimmed.clear();
+    if (touch_log || dirty_to == eversion_t::max())
+      encode(log_batch, (*km)["log_batch_entries"]);
+  } else {
+    for (auto& t : trimmed) {
+      string key = t.get_key_name();
+      if (log_keys_debug) {
+	auto it = log_keys_debug->find(key);
+	ceph_assert(it != log_keys_debug->end());
+	log_keys_debug->erase(it);
+      }
+      to_remove.emplace(std::move(key));
+    }
+    trimmed.clear();
+
+    if (touch_log)
+      t.touch(coll, log_oid);
+    if (dirty_to == eversion_t::max()) {
+      // drop any batched keys left by a previous osd_pg_log_batch_entries
+      t.omap_rmkeyrange(
+	coll, log_oid,
+	get_log_batch_key(0), get_log_batch_key(UINT64_MAX));
+      to_remove.insert("log_batch_entries");
+    }
+    if (dirty_to != eversion_t()) {
+      t.omap_rmkeyrange(
+	coll, log_oid,
+	eversion_t().get_key_name(), dirty_to.get_key_name());
+      clear_up_to(log_keys_debug, dirty_to.get_key_name());
+    }
+    if (dirty_to != eversion_t::max() && dirty_from != eversion_t::max()) {
+      //   dout(10) << "write_log_and_missing, clearing from " << dirty_from << dendl;
+      t.omap_rmkeyrange(
+	coll, log_oid,
+	dirty_from.get_key_name(), eversion_t::max().get_key_name());
+      clear_after(log_keys_debug, dirty_from.get_key_name());
     }
-    to_remove.emplace(std::move(key));
-  }
-  trimmed.clear();
-
-  if (touch_log)
-    t.touch(coll, log_oid);
-  if (dirty_to != eversion_t()) {
-    t.omap_rmkeyrange(
-      coll, log_oid,
-      eversion_t().get_key_name(), dirty_to.get_key_name());
-    clear_up_to(log_keys_debug, dirty_to.get_key_name());
-  }
-  if (dirty_to != eversion_t::max() && dirty_from != eversion_t::max()) {
-    //   dout(10) << "write_log_and_missing, clearing from " << dirty_from << dendl;
-    t.omap_rmkeyrange(
-      coll, log_oid,
-      dirty_from.get_key_name(), eversion_t::max().get_key_name());
-    clear_after(log_keys_debug, dirty_from.get_key_name());
-  }
 
-  for (auto p = log.log.begin();
-       p != log.log.end() && p->version <= dirty_to;
-       ++p) {
-    bufferlist bl(sizeof(*p) * 2);
-    p->encode_with_checksum(bl);
-    (*km)[p->get_key_name()] = std::move(bl);
-  }
+    for (auto p = log.log.begin();
+	 p != log.log.end() && p->version <= dirty_to;
+	 ++p) {
+      bufferlist bl(sizeof(*p) * 2);
+      p->encode_with_checksum(bl);
+      (*km)[p->get_key_name()] = std::move(bl);
+    }
 
-  for (auto p = log.log.rbegin();
-       p != log.log.rend() &&
-	 (p->version >= dirty_from || p->version >= writeout_from) &&
-	 p->version >= dirty_to;
-       ++p) {
-    bufferlist bl(sizeof(*p) * 2);
-    p->encode_with_checksum(bl);
-    (*km)[p->get_key_name()] = std::move(bl);
-  }
+    for (auto p = log.log.rbegin();
+	 p != log.log.rend() &&
+	   (p->version >= dirty_from || p->version >= writeout_from) &&
+	   p->version >= dirty_to;
+	 ++p) {
+      bufferlist bl(sizeof(*p) * 2);
+      p->encode_with_checksum(bl);
+      (*km)[p->get_key_name()] = std::move(bl);
+    }
 
-  if (log_keys_debug) {
-    for (auto i = (*km).begin();
-	 i != (*km).end();
-	 ++i) {
-      if (i->first[0] == '_')
-	continue;
-      ceph_assert(!log_keys_debug->count(i->first));
-      log_keys_debug->insert(i->first);
+    if (log_keys_debug) {
+      for (auto i = (*km).begin();
+	   i != (*km).end();
+	   ++i) {
+	if (i->first[0] == '_')
+	  continue;
+	ceph_assert(!log_keys_debug->count(i->first));
+	log_keys_debug->insert(i->first);
+      }
     }
   }
 
@@ -955,6 +981,92 @@ void PGLog::_write_log_and_missing(
     t.omap_rmkeys(coll, log_oid, to_remove);
 }
 
+// static
+void PGLog::_write_log_batches(
+  ObjectStore::Transaction& t,
+  map<string,bufferlist>* km,
+  pg_log_t &log,
+  const coll_t& coll, const ghobject_t &log_oid,
+  unsigned log_batch,
+  eversion_t dirty_to,
+  eversion_t dirty_from,
+  eversion_t writeout_from,
+  const set<eversion_t> &trimmed,
+  set<string> *to_remove)
+{
+  auto batch_of = [log_batch](const eversion_t &v) {
+    return v.version / log_batch;
+  };
+
+  // batches <= tail_to and >= head_from are rewritten from the log
+  bool rewrite_tail = false;
+  uint64_t tail_to = 0;
+  uint64_t head_from = UINT64_MAX;
+  if (dirty_to == eversion_t::max()) {
+    // full rewrite, also dropping per-entry keys from an earlier format
+    t.omap_rmkeyrange(
+      coll, log_oid,
+      eversion_t().get_key_name(), eversion_t::max().get_key_name());
+    t.omap_rmkeyrange(
+      coll, log_oid,
+      get_log_batch_key(0), get_log_batch_key(UINT64_MAX));
+    rewrite_tail = true;
+    tail_to = UINT64_MAX;
+  } else {
+    if (dirty_to != eversion_t()) {
+      t.omap_rmkeyrange(
+	coll, log_oid,
+	get_log_batch_key(0), get_log_batch_key(batch_of(dirty_to) + 1));
+      rewrite_tail = true;
+      tail_to = batch_of(dirty_to);
+    }
+    if (dirty_from != eversion_t::max()) {
+      t.omap_rmkeyrange(
+	coll, log_oid,
+	get_log_batch_key(batch_of(dirty_from)), get_log_batch_key(UINT64_MAX));
+      head_from = batch_of(dirty_from);
+    }
+    if (writeout_from != eversion_t::max()) {
+      head_from = std::min(head_from, batch_of(writeout_from));
+    }
+    // trimming drops versions from the tail: every batch below the new
+    // tail is removed with a single key delete, and the one it falls in
+    // (if any) is rewritten without the trimmed entries
+    uint64_t first_kept = log.log.empty() ?
+      UINT64_MAX : batch_of(log.log.front().version);
+    for (auto& v : trimmed) {
+      uint64_t b = batch_of(v);
+      if (b < first_kept) {
+	to_remove->insert(get_log_batch_key(b));
+      } else {
+	rewrite_tail = true;
+	tail_to = std::max(tail_to, b);
+      }
+    }
+  }
+
+  map<uint64_t, list<const pg_log_entry_t*>> batches;
+  for (auto p = log.log.begin();
+       rewrite_tail && p != log.log.end() && batch_of(p->version) <= tail_to;
+       ++p) {
+    batches[batch_of(p->version)].push_back(&*p);
+  }
+  for (auto p = log.log.rbegin();
+       p != log.log.rend() && batch_of(p->version) >= head_from &&
+	 !(rewrite_tail && batch_of(p->version) <= tail_to);
+       ++p) {
+    batches[batch_of(p->version)].push_front(&*p);
+  }
+  for (auto& [b, entries] : batches) {
+    bufferlist bl;
+    encode((uint32_t)entries.size(), bl);
+    for (auto e : entries) {
+      e->encode_with_checksum(bl);
+    }
+    (*km)[get_log_batch_key(b)] = std::move(bl);
+  }
+}
+
 void PGLog::rebuild_missing_set_with_deletes(
   ObjectStore *store,
   ObjectStore::CollectionHandle& ch,
@@ -1067,18 +1179,27 @@ namespace {
           ceph_assert(dups.back().version < dup.version);
         }
         dups.push_back(dup);
+      } else if (p->key() == "log_batch_entries") {
+        // the batch size only matters when writing
       } else {
-        pg_log_entry_t e;
-        e.decode_with_checksum(bp);
-        ldpp_dout(dpp, 20) << "read_log_and_missing " << e << dendl;
-        if (!entries.empty()) {
-          pg_log_entry_t last_e(entries.back());
-          ceph_assert(last_e.version.version < e.version.version);
-          ceph_assert(last_e.version.epoch <= e.version.epoch);
+        // either a single entry or a batch of them
+        uint32_t n = 1;
+        bool batch = p->key().compare(0, 10, "log_batch_") == 0;
+        if (batch)
+          decode(n, bp);
+        while (n--) {
+          pg_log_entry_t e;
+          e.decode_with_checksum(bp);
+          ldpp_dout(dpp, 20) << "read_log_and_missing " << e << dendl;
+          if (!entries.empty()) {
+            pg_log_entry_t last_e(entries.back());
+            ceph_assert(last_e.version.version < e.version.version);
+            ceph_assert(last_e.version.epoch <= e.version.epoch);
+          }
+          entries.push_back(e);
+          if (log_keys_debug && !batch)
+            log_keys_debug->insert(e.get_key_name());
         }
-        entries.push_back(e);
-        if (log_keys_debug)
-          log_keys_debug->insert(e.get_key_name());
       }
     }
 
@@ -20,6 +20,7 @@
 #include "include/ceph_assert.h"
 #include "include/common_fwd.h"
 #include "osd_types.h"
+#include "PGLogDupIndex.h"
 #include "os/ObjectStore.h"
 #include <list>
 
@@ -149,7 +150,7 @@ public:
     mutable ceph::unordered_map<hobject_t,pg_log_entry_t*> objects;  // ptrs into log.  be careful!
     mutable ceph::unordered_map<osd_reqid_t,pg_log_entry_t*> caller_ops;
     mutable ceph::unordered_multimap<osd_reqid_t,pg_log_entry_t*> extra_caller_ops;
-    mutable ceph::unordered_map<osd_reqid_t,pg_log_dup_t*> dup_index;
+    mutable PGLogDupIndex dup_index;
 
     // recovery pointers
     std::list<pg_log_entry_t>::iterator complete_to; // not inclusive of referenced item
@@ -389,12 +390,11 @@ public:
       if (!(indexed_data & PGLOG_INDEXED_DUPS)) {
         index_dups();
       }
-      auto q = dup_index.find(r);
-      if (q != dup_index.end()) {
-	*version = q->second->version;
-	*user_version = q->second->user_version;
-	*return_code = q->second->return_code;
-	*op_returns = q->second->op_returns;
+      if (auto q = dup_index.find(r); q) {
+	*version = q->version;
+	*user_version = q->user_version;
+	*return_code = q->return_code;
+	*op_returns = q->op_returns;
 	return true;
       }
 
@@ -458,8 +458,9 @@ public:
 	extra_caller_ops.clear();
       if (to_index & PGLOG_INDEXED_DUPS) {
 	dup_index.clear();
+	dup_index.reserve(dups.size());
 	for (auto& i : dups) {
-	  dup_index[i.reqid] = const_cast<pg_log_dup_t*>(&i);
+	  dup_index.insert(const_cast<pg_log_dup_t*>(&i));
 	}
       }
 
@@ -574,16 +575,13 @@ public:
 
     void index(pg_log_dup_t& e) {
       if (indexed_data & PGLOG_INDEXED_DUPS) {
-	dup_index[e.reqid] = &e;
+	dup_index.insert(&e);
       }
     }
 
     void unindex(const pg_log_dup_t& e) {
       if (indexed_data & PGLOG_INDEXED_DUPS) {
-	auto i = dup_index.find(e.reqid);
-	if (i != dup_index.end()) {
-	  dup_index.erase(i);
-	}
+	dup_index.erase(e.reqid);
       }
     }
 
@@ -656,6 +654,7 @@ protected:
   eversion_t write_from_dups;  ///< must write keys >= write_from_dups
   std::set<std::string> trimmed_dups;    ///< must clear keys in trimmed_dups
   CephContext *cct;
+  unsigned log_batch;          ///< entries per omap key, 0 for one key each
   bool pg_log_debug;
   /// Log is clean on [dirty_to, dirty_from)
   bool touched_log;
@@ -755,7 +754,10 @@ public:
     dirty_from_dups(eversion_t::max()),
     write_from_dups(eversion_t::max()),
     cct(cct),
-    pg_log_debug(!(cct && !(cct->_conf->osd_debug_pg_log_writeout))),
+    log_batch(cct ? cct->_conf->osd_pg_log_batch_entries : 0),
+    // log_keys_debug tracks per-entry keys only
+    pg_log_debug(!(cct && !(cct->_conf->osd_debug_pg_log_writeout)) &&
+		 !log_batch),
     touched_log(false),
     dirty_log(false),
     clear_divergent_priors(false)
@@ -1382,9 +1384,30 @@ public:
     eversion_t dirty_from_dups,
     eversion_t write_from_dups,
     bool *may_include_deletes_in_missing_dirty,
-    std::set<std::string> *log_keys_debug
+    std::set<std::string> *log_keys_debug,
+    unsigned log_batch = 0
     );
 
+  static void _write_log_batches(
+    ObjectStore::Transaction& t,
+    std::map<std::string,ceph::buffer::list>* km,
+    pg_log_t &log,
+    const coll_t& coll, const ghobject_t &log_oid,
+    unsigned log_batch,
+    eversion_t dirty_to,
+    eversion_t dirty_from,
+    eversion_t writeout_from,
+    const std::set<eversion_t> &trimmed,
+    std::set<std::string> *to_remove
+    );
+
+  /// omap key of the batch holding versions [b * log_batch, (b + 1) * log_batch)
+  static std::string get_log_batch_key(uint64_t b) {
+    char key[32];
+    snprintf(key, sizeof(key), "log_batch_%020llu", (unsigned long long)b);
+    return key;
+  }
+
   void read_log_and_missing(
     ObjectStore *store,
     ObjectStore::CollectionHandle& ch,
@@ -1394,14 +1417,20 @@ public:
     bool tolerate_divergent_missing_log,
     bool debug_verify_stored_missing = false
     ) {
-    return read_log_and_missing(
+    unsigned on_disk_log_batch = 0;
+    read_log_and_missing(
       store, ch, pgmeta_oid, info,
       log, missing, oss,
       tolerate_divergent_missing_log,
       &clear_divergent_priors,
       this,
       (pg_log_debug ? &log_keys_debug : nullptr),
-      debug_verify_stored_missing);
+      debug_verify_stored_missing,
+      &on_disk_log_batch);
+    if (on_disk_log_batch != log_batch) {
+      // keys are laid out for another batch size; rewrite them all
+      mark_log_for_rewrite();
+    }
   }
 
   template <typename missing_type>
@@ -1417,7 +1446,8 @@ public:
     bool *clear_divergent_priors = nullptr,
     const DoutPrefixProvider *dpp = nullptr,
     std::set<std::string> *log_keys_debug = nullptr,
-    bool debug_verify_stored_missing = false
+    bool debug_verify_stored_missing = false,
+    unsigned *on_disk_log_batch = nullptr
     ) {
     ldpp_dout(dpp, 20) << "read_log_and_missing coll " << ch->cid
 		       << " " << pgmeta_oid << dendl;
@@ -1431,34 +1461,30 @@ public:
     // will get overridden below if it had been recorded
     eversion_t on_disk_can_rollback_to = info.last_update;
     eversion_t on_disk_rollback_info_trimmed_to = eversion_t();
-    ObjectMap::ObjectMapIterator p = store->get_omap_iterator(ch,
-							      pgmeta_oid);
     std::map<eversion_t, hobject_t> divergent_priors;
     bool must_rebuild = false;
     missing.may_include_deletes = false;
     std::list<pg_log_entry_t> entries;
     std::list<pg_log_dup_t> dups;
-    if (p) {
-      using ceph::decode;
-      for (p->seek_to_first(); p->valid() ; p->next()) {
+    using ceph::decode;
+    auto handle_key = [&](const std::string& key, const ceph::buffer::list& bl) {
 	// non-log pgmeta_oid keys are prefixed with _; skip those
-	if (p->key()[0] == '_')
-	  continue;
-	auto bl = p->value();//Copy ceph::buffer::list before creating iterator
+	if (key[0] == '_')
+	  return;
 	auto bp = bl.cbegin();
-	if (p->key() == "divergent_priors") {
+	if (key == "divergent_priors") {
 	  decode(divergent_priors, bp);
 	  ldpp_dout(dpp, 20) << "read_log_and_missing " << divergent_priors.size()
 			     << " divergent_priors" << dendl;
 	  must_rebuild = true;
 	  debug_verify_stored_missing = false;
-	} else if (p->key() == "can_rollback_to") {
+	} else if (key == "can_rollback_to") {
 	  decode(on_disk_can_rollback_to, bp);
-	} else if (p->key() == "rollback_info_trimmed_to") {
+	} else if (key == "rollback_info_trimmed_to") {
 	  decode(on_disk_rollback_info_trimmed_to, bp);
-	} else if (p->key() == "may_include_deletes_in_missing") {
+	} else if (key == "may_include_deletes_in_missing") {
 	  missing.may_include_deletes = true;
-	} else if (p->key().substr(0, 7) == std::string("missing")) {
+	} else if (key.substr(0, 7) == std::string("missing")) {
 	  hobject_t oid;
 	  pg_missing_item item;
 	  decode(oid, bp);
@@ -1468,25 +1494,65 @@ public:
 	    ceph_assert(missing.may_include_deletes);
 	  }
 	  missing.add(oid, std::move(item));
-	} else if (p->key().substr(0, 4) == std::string("dup_")) {
+	} else if (key.substr(0, 4) == std::string("dup_")) {
 	  pg_log_dup_t dup;
 	  decode(dup, bp);
 	  if (!dups.empty()) {
 	    ceph_assert(dups.back().version < dup.version);
 	  }
 	  dups.push_back(dup);
+	} else if (key == "log_batch_entries") {
+	  unsigned n;
+	  decode(n, bp);
+	  if (on_disk_log_batch)
+	    *on_disk_log_batch = n;
 	} else {
-	  pg_log_entry_t e;
-	  e.decode_with_checksum(bp);
-	  ldpp_dout(dpp, 20) << "read_log_and_missing " << e << dendl;
-	  if (!entries.empty()) {
-	    pg_log_entry_t last_e(entries.back());
-	    ceph_assert(last_e.version.version < e.version.version);
-	    ceph_assert(last_e.version.epoch <= e.version.epoch);
+	  // either a single entry or a batch of them
+	  uint32_t n = 1;
+	  bool batch = key.compare(0, 10, "log_batch_") == 0;
+	  if (batch)
+	    decode(n, bp);
+	  while (n--) {
+	    pg_log_entry_t e;
+	    e.decode_with_checksum(bp);
+	    ldpp_dout(dpp, 20) << "read_log_and_missing " << e << dendl;
+	    if (!entries.empty()) {
+	      pg_log_entry_t last_e(entries.back());
+	      ceph_assert(last_e.version.version < e.version.version);
+	      ceph_assert(last_e.version.epoch <= e.version.epoch);
+	    }
+	    entries.push_back(e);
+	    if (log_keys_debug && !batch)
+	      log_keys_debug->insert(e.get_key_name());
 	  }
-	  entries.push_back(e);
-	  if (log_keys_debug)
-	    log_keys_debug->insert(e.get_key_name());
+	}
+    };
+    // in large batches, read ahead from the store: long logs make most
+    // of the time of an osd's startup
+    std::string after;
+    for (bool more = true; more; ) {
+      ceph::buffer::list chunk;
+      uint32_t num = 0;
+      r = store->omap_get_vals_encoded(ch, pgmeta_oid, after, "",
+				       1024, 4 << 20, &chunk, &num, &more);
+      if (r == -ENOENT) {
+	break;
+      }
+      ceph_assert(r == 0);
+      auto cp = chunk.cbegin();
+      while (num--) {
+	std::string key;
+	decode(key, cp);
+	// a copy of its own, not to pin the chunk with what is kept of it
+	uint32_t len;
+	decode(len, cp);
+	ceph::buffer::ptr value;
+	cp.copy_deep(len, value);
+	ceph::buffer::list bl;
+	bl.push_back(std::move(value));
+	handle_key(key, bl);
+	if (!num) {
+	  after.swap(key);
 	}
       }
     }
@@ -0,0 +1,147 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+/*
+ * Ceph - scalable distributed file system
+ *
+ * This is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License version 2.1, as published by the Free Software
+ * Foundation. See file COPYING.
+ *
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+
+#include "include/ceph_assert.h"
+#include "osd/osd_types.h"
+
+/**
+ * PGLogDupIndex - reqid -> dup index for PGLog::IndexedLog
+ *
+ * A PG may keep thousands of dup entries, and an OSD hundreds of PGs,
+ * so a node-based unordered_map (~64 bytes per dup, outside of any
+ * mempool) is a sizeable part of the pglog footprint.  This is an
+ * open-addressing table of pointers into pg_log_t::dups instead: the
+ * key is read back from the dup itself, so a slot is just one pointer,
+ * and the table is accounted in mempool::osd_pglog.
+ *
+ * Linear probing with backward-shift deletion keeps lookups O(1)
+ * without tombstones, which matters because dups are trimmed from the
+ * tail as fast as they are added at the head.
+ */
+class PGLogDupIndex {
+  mempool::osd_pglog::vector<pg_log_dup_t*> slots;
+  size_t num = 0;
+
+  static constexpr size_t MIN_SLOTS = 8;
+
+  static size_t hash(const osd_reqid_t& r) {
+    // std::hash<osd_reqid_t> only xors the fields; mix it so that the
+    // low bits we mask with are usable.
+    uint64_t h = std::hash<osd_reqid_t>()(r);
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdull;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ull;
+    h ^= h >> 33;
+    return h;
+  }
+
+  size_t mask() const {
+    return slots.size() - 1;
+  }
+
+  size_t find_slot(const osd_reqid_t& r) const {
+    for (size_t i = hash(r) & mask(); ; i = (i + 1) & mask()) {
+      if (!slots[i] || slots[i]->reqid == r) {
+	return i;
+      }
+    }
+  }
+
+  void rehash(size_t n) {
+    mempool::osd_pglog::vector<pg_log_dup_t*> old(n, nullptr);
+    old.swap(slots);
+    for (auto p : old) {
+      if (p) {
+	slots[find_slot(p->reqid)] = p;
+      }
+    }
+  }
+
+public:
+  size_t size() const {
+    return num;
+  }
+  bool empty() const {
+    return num == 0;
+  }
+  size_t count(const osd_reqid_t& r) const {
+    return find(r) ? 1 : 0;
+  }
+
+  /// return the dup indexed for @p r, or nullptr
+  pg_log_dup_t* find(const osd_reqid_t& r) const {
+    if (num == 0) {
+      return nullptr;
+    }
+    return slots[find_slot(r)];
+  }
+
+  /// index @p d, replacing any dup already indexed under the same reqid
+  void insert(pg_log_dup_t* d) {
+    ceph_assert(d);
+    // keep the load factor under 3/4
+    if ((num + 1) * 4 > slots.size() * 3) {
+      rehash(slots.empty() ? MIN_SLOTS : slots.size() * 2);
+    }
+    size_t i = find_slot(d->reqid);
+    if (!slots[i]) {
+      ++num;
+    }
+    slots[i] = d;
+  }
+
+  /// unindex the dup indexed for @p r, if any
+  void erase(const osd_reqid_t& r) {
+    if (num == 0) {
+      return;
+    }
+    size_t i = find_slot(r);
+    if (!slots[i]) {
+      return;
+    }
+    slots[i] = nullptr;
+    --num;
+    // shift back the following run so no probe chain crosses a hole
+    for (size_t j = (i + 1) & mask(); slots[j]; j = (j + 1) & mask()) {
+      size_t home = hash(slots[j]->reqid) & mask();
+      // move slots[j] into the hole unless its home lies in (i, j]
+      if (((j - home) & mask()) >= ((j - i) & mask())) {
+	slots[i] = slots[j];
+	slots[j] = nullptr;
+	i = j;
+      }
+    }
+  }
+
+  void clear() {
+    slots.clear();
+    slots.shrink_to_fit();
+    num = 0;
+  }
+
+  /// size the table for @p n dups up front
+  void reserve(size_t n) {
+    size_t want = MIN_SLOTS;
+    while (want * 3 < n * 4) {
+      want *= 2;
+    }
+    if (want > slots.size()) {
+      rehash(want);
+    }
+  }
+};
@@ -523,6 +523,12 @@ void PrimaryLogPG::schedule_recovery_work(
   osd->queue_recovery_context(this, c);
 }
 
+void PrimaryLogPG::schedule_event_after(double delay, Context *c)
+{
+  std::lock_guard l(osd->sleep_lock);
+  osd->sleep_timer.add_event_after(delay, bless_context(c));
+}
+
 void PrimaryLogPG::replica_clear_repop_obc(
   const vector<pg_log_entry_t> &logv,
   ObjectStore::Transaction &t)
@@ -571,7 +577,8 @@ bool PrimaryLogPG::should_send_op(
 ConnectionRef PrimaryLogPG::get_con_osd_cluster(
   int peer, epoch_t from_epoch)
 {
-  return osd->get_con_osd_cluster(peer, from_epoch);
+  return osd->get_con_osd_cluster(peer, from_epoch,
+				 osd->get_cluster_lane(pg_id));
 }
 
 PerfCounters *PrimaryLogPG::get_logger()
@@ -4367,14 +4374,16 @@ void PrimaryLogPG::log_op_stats(const OpRequest& op,
 	   << " lat " << latency << dendl;
 
   if (m_dynamic_perf_stats.is_enabled()) {
-    m_dynamic_perf_stats.add(osd, info, op, inb, outb, latency);
+    m_dynamic_perf_stats.add(osd, info, op, inb, outb, latency,
+			     process_latency);
   }
 }
 
 void PrimaryLogPG::set_dynamic_perf_stats_queries(
     const std::list<OSDPerfMetricQuery> &queries)
 {
-  m_dynamic_perf_stats.set_queries(queries);
+  m_dynamic_perf_stats.set_queries(
+    queries, cct->_conf.get_val<uint64_t>("osd_perf_query_max_keys"));
 }
 
 void PrimaryLogPG::get_dynamic_perf_stats(DynamicPerfStats *stats)
@@ -7661,28 +7670,14 @@ int PrimaryLogPG::do_osd_ops(OpContext *ctx, vector<OSDOp>& ops)
 	bool truncated = false;
 	bufferlist bl;
 	if (oi.is_omap()) {
-	  ObjectMap::ObjectMapIterator iter = osd->store->get_omap_iterator(
-	    ch, ghobject_t(soid)
-	    );
-          if (!iter) {
-            result = -ENOENT;
-            goto fail;
-          }
-	  iter->upper_bound(start_after);
-	  if (filter_prefix > start_after) iter->lower_bound(filter_prefix);
-	  for (num = 0;
-	       iter->valid() &&
-		 iter->key().substr(0, filter_prefix.size()) == filter_prefix;
-	       ++num, iter->next()) {
-	    dout(20) << "Found key " << iter->key() << dendl;
-	    if (num >= max_return ||
-		bl.length() >= cct->_conf->osd_max_omap_bytes_per_request) {
-	      truncated = true;
-	      break;
-	    }
-	    encode(iter->key(), bl);
-	    encode(iter->value(), bl);
+	  int r = osd->store->omap_get_vals_encoded(
+	    ch, ghobject_t(soid), start_after, filter_prefix, max_return,
+	    cct->_conf->osd_max_omap_bytes_per_request, &bl, &num, &truncated);
+	  if (r < 0) {
+	    result = r;
+	    goto fail;
 	  }
+	  dout(20) << "Found " << num << " keys" << dendl;
 	} // else return empty out_set
 	encode(num, osd_op.outdata);
 	osd_op.outdata.claim_append(bl);
@@ -8765,6 +8760,15 @@ void PrimaryLogPG::do_osd_op_effects(OpContext *ctx, const ConnectionRef& conn)
       dout(10) << "notify_ack " << make_pair(*(p->watch_cookie), p->notify_id) << dendl;
     else
       dout(10) << "notify_ack " << make_pair("NULL", p->notify_id) << dendl;
+    if (p->watch_cookie) {
+      // a lookup rather than a scan: each of many watchers acks on its own
+      auto i = ctx->obc->watchers.find(make_pair(*(p->watch_cookie), entity));
+      if (i != ctx->obc->watchers.end()) {
+	dout(10) << "acking notify on watch " << i->first << dendl;
+	i->second->notify_ack(p->notify_id, p->reply_bl);
+      }
+      continue;
+    }
     for (map<pair<uint64_t, entity_name_t>, WatchRef>::iterator i =
 	   ctx->obc->watchers.begin();
 	 i != ctx->obc->watchers.end();
@@ -13511,7 +13515,8 @@ int PrimaryLogPG::prep_object_replica_deletes(
 int PrimaryLogPG::prep_object_replica_pushes(
   const hobject_t& soid, eversion_t v,
   PGBackend::RecoveryHandle *h,
-  bool *work_started)
+  bool *work_started,
+  bool *batched)
 {
   ceph_assert(is_primary());
   dout(10) << __func__ << ": on " << soid << dendl;
@@ -13551,6 +13556,24 @@ int PrimaryLogPG::prep_object_replica_pushes(
 	     << dendl;
   }
 
+  // small objects ride along in the pushes of this pass, charged
+  // against the batch's byte budget rather than osd_recovery_max_active
+  if (batched) {
+    *batched = false;
+    auto small_size = cct->_conf.get_val<Option::size_t>(
+      "osd_recovery_batch_small_object_size");
+    uint64_t charge = obc->obs.oi.size + cct->_conf->osd_push_per_object_cost;
+    if (small_size &&
+	obc->obs.oi.size <= small_size &&
+	!obc->obs.oi.is_omap() &&
+	recovery_batch_bytes + charge <= cct->_conf.get_val<Option::size_t>(
+	  "osd_recovery_batch_max_bytes")) {
+      recovery_batch_bytes += charge;
+      *batched = true;
+      *work_started = true;
+    }
+  }
+
   start_recovery_op(soid);
   ceph_assert(!recovering.count(soid));
   recovering.insert(make_pair(soid, obc));
@@ -13574,6 +13597,7 @@ uint64_t PrimaryLogPG::recover_replicas(uint64_t max, ThreadPool::TPHandle &hand
 {
   dout(10) << __func__ << "(" << max << ")" << dendl;
   uint64_t started = 0;
+  recovery_batch_bytes = 0;
 
   PGBackend::RecoveryHandle *h = pgbackend->open_recovery_op();
 
@@ -13672,9 +13696,18 @@ uint64_t PrimaryLogPG::recover_replicas(uint64_t max, ThreadPool::TPHandle &hand
 
       dout(10) << __func__ << ": recover_object_replicas(" << soid << ")" << dendl;
       map<hobject_t,pg_missing_item>::const_iterator r = m.get_items().find(soid);
-      started += prep_object_replica_pushes(soid, r->second.need, h, work_started);
+      bool batched = false;
+      int n = prep_object_replica_pushes(soid, r->second.need, h, work_started,
+					 &batched);
+      if (!batched) {
+	started += n;
+      }
     }
   }
+  if (recovery_batch_bytes) {
+    dout(10) << __func__ << ": batched " << recovery_batch_bytes
+	     << " bytes of small objects" << dendl;
+  }
 
   pgbackend->run_recovery_op(h, get_recovery_op_priority());
   return started;
@@ -14207,7 +14240,8 @@ void PrimaryLogPG::scan_range(
 	 */
 	continue;
       }
-      bi->objects[*p] = obc->obs.oi.version;
+      // listed in order: each one goes at the end
+      bi->objects.emplace_hint(bi->objects.end(), *p, obc->obs.oi.version);
       dout(20) << "  " << *p << " " << obc->obs.oi.version << dendl;
     } else {
       bufferlist bl;
@@ -14221,7 +14255,7 @@ void PrimaryLogPG::scan_range(
 
       ceph_assert(r >= 0);
       object_info_t oi(bl);
-      bi->objects[*p] = oi.version;
+      bi->objects.emplace_hint(bi->objects.end(), *p, oi.version);
       dout(20) << "  " << *p << " " << oi.version << dendl;
     }
   }
@@ -15642,6 +15676,7 @@ boost::statechart::result PrimaryLogPG::AwaitAsyncWork::react(const DoSnapWork&)
       [pg, object, &in_flight]() {
 	ceph_assert(in_flight.find(object) != in_flight.end());
 	in_flight.erase(object);
+	pg->osd->logger->inc(l_osd_snap_trim_objects);
 	if (in_flight.empty()) {
 	  if (pg->state_test(PG_STATE_SNAPTRIM_ERROR)) {
 	    pg->snap_trimmer_machine.process_event(Reset());
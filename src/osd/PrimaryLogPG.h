@@ -546,6 +546,7 @@ public:
 
   void schedule_recovery_work(
     GenContext<ThreadPool::TPHandle&> *c) override;
+  void schedule_event_after(double delay, Context *c) override;
 
   pg_shard_t whoami_shard() const override {
     return pg_whoami;
@@ -1127,10 +1128,13 @@ protected:
   /// last backfill operation started
   hobject_t last_backfill_started;
   bool new_backfill;
+  /// cost of the small objects batched in the current recover_replicas pass
+  uint64_t recovery_batch_bytes = 0;
 
   int prep_object_replica_pushes(const hobject_t& soid, eversion_t v,
 				 PGBackend::RecoveryHandle *h,
-				 bool *work_started);
+				 bool *work_started,
+				 bool *batched = nullptr);
   int prep_object_replica_deletes(const hobject_t& soid, eversion_t v,
 				  PGBackend::RecoveryHandle *h,
 				  bool *work_started);
@@ -1772,6 +1776,7 @@ private:
 	pg->get_pgid(),
 	pending,
 	0);
+      pg->osd->logger->inc(l_osd_pg_snaptrim_wait);
       pg->state_set(PG_STATE_SNAPTRIM_WAIT);
       pg->publish_stats_to_osd();
     }
@@ -1782,6 +1787,7 @@ private:
 	pending->cancel();
       pending = nullptr;
       auto *pg = context< SnapTrimmer >().pg;
+      pg->osd->logger->dec(l_osd_pg_snaptrim_wait);
       pg->state_clear(PG_STATE_SNAPTRIM_WAIT);
       pg->state_clear(PG_STATE_SNAPTRIM_ERROR);
       pg->publish_stats_to_osd();
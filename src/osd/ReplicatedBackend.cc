@@ -1957,6 +1957,11 @@ void ReplicatedBackend::send_pushes(int prio, map<pg_shard_t, vector<PushOp> > &
       get_osdmap_epoch());
     if (!con)
       continue;
+    // with small object batching, pack messages by cost alone
+    uint64_t max_pushes =
+      cct->_conf.get_val<Option::size_t>("osd_recovery_batch_small_object_size") ?
+      std::numeric_limits<uint64_t>::max() :
+      cct->_conf->osd_max_push_objects;
     vector<PushOp>::iterator j = i->second.begin();
     while (j != i->second.end()) {
       uint64_t cost = 0;
@@ -1971,7 +1976,7 @@ void ReplicatedBackend::send_pushes(int prio, map<pg_shard_t, vector<PushOp> > &
       for (;
            (j != i->second.end() &&
 	    cost < cct->_conf->osd_max_push_cost &&
-	    pushes < cct->_conf->osd_max_push_objects) ;
+	    pushes < max_pushes) ;
 	   ++j) {
 	dout(20) << __func__ << ": sending push " << *j
 		 << " to osd." << i->first << dendl;
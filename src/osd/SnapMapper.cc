@@ -97,6 +97,25 @@ int OSDriver::get_next(
   }
 }
 
+int OSDriver::get_next_batch(
+  const std::string &key,
+  unsigned max,
+  vector<pair<std::string, bufferlist>> *out)
+{
+  ObjectMap::ObjectMapIterator iter =
+    os->get_omap_iterator(ch, hoid);
+  if (!iter) {
+    ceph_abort();
+    return -EINVAL;
+  }
+  for (iter->upper_bound(key);
+       iter->valid() && out->size() < max;
+       iter->next()) {
+    out->emplace_back(iter->key(), iter->value());
+  }
+  return 0;
+}
+
 string SnapMapper::get_prefix(int64_t pool, snapid_t snap)
 {
   char buf[100];
@@ -328,29 +347,39 @@ int SnapMapper::get_next_objects_to_trim(
        ++i) {
     string prefix(get_prefix(pool, snap) + *i);
     string pos = prefix;
-    while (out->size() < max) {
-      pair<string, bufferlist> next;
-      r = backend.get_next(pos, &next);
-      dout(20) << __func__ << " get_next(" << pos << ") returns " << r
-	       << " " << next << dendl;
+    bool prefix_done = false;
+    while (!prefix_done && out->size() < max) {
+      // one scan of the omap for the whole batch
+      unsigned want = max - out->size();
+      vector<pair<string, bufferlist>> next;
+      r = backend.get_next_batch(pos, want, &next);
+      dout(20) << __func__ << " get_next_batch(" << pos << ", " << want
+	       << ") returns " << r << " with " << next.size() << " keys"
+	       << dendl;
       if (r != 0) {
-	break; // Done
-      }
-
-      if (next.first.substr(0, prefix.size()) !=
-	  prefix) {
-	break; // Done with this prefix
+	break;
       }
+      for (auto& n : next) {
+	if (n.first.substr(0, prefix.size()) != prefix) {
+	  prefix_done = true; // Done with this prefix
+	  break;
+	}
 
-      ceph_assert(is_mapping(next.first));
+	ceph_assert(is_mapping(n.first));
 
-      dout(20) << __func__ << " " << next.first << dendl;
-      pair<snapid_t, hobject_t> next_decoded(from_raw(next));
-      ceph_assert(next_decoded.first == snap);
-      ceph_assert(check(next_decoded.second));
+	dout(20) << __func__ << " " << n.first << dendl;
+	pair<snapid_t, hobject_t> next_decoded(from_raw(n));
+	ceph_assert(next_decoded.first == snap);
+	ceph_assert(check(next_decoded.second));
 
-      out->push_back(next_decoded.second);
-      pos = next.first;
+	out->push_back(next_decoded.second);
+	pos = n.first;
+      }
+      if (!prefix_done && next.size() < want) {
+	// no more keys, for the next prefixes either
+	prefix_done = true;
+	r = -ENOENT;
+      }
     }
   }
   if (out->size() == 0) {
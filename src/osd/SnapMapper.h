@@ -75,6 +75,10 @@ public:
   int get_next(
     const std::string &key,
     std::pair<std::string, ceph::buffer::list> *next) override;
+  int get_next_batch(
+    const std::string &key,
+    unsigned max,
+    std::vector<std::pair<std::string, ceph::buffer::list>> *out) override;
 };
 
 /**
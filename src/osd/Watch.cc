@@ -167,9 +167,17 @@ void Notify::complete_watcher(WatchRef watch, bufferlist& reply_bl)
     return;
   ceph_assert(watchers.count(watch));
   watchers.erase(watch);
-  notify_replies.insert(make_pair(make_pair(watch->get_watcher_gid(),
-					    watch->get_cookie()),
-				  reply_bl));
+  auto key = make_pair(watch->get_watcher_gid(), watch->get_cookie());
+  if (notify_replies_bytes + reply_bl.length() >
+      osd->cct->_conf->osd_notify_max_reply_bytes) {
+    dout(1) << __func__ << " dropping the " << reply_bl.length()
+	    << " byte reply of " << key << ", already holding "
+	    << notify_replies_bytes << " bytes of replies" << dendl;
+    notify_replies.emplace(key, bufferlist());
+  } else {
+    notify_replies_bytes += reply_bl.length();
+    notify_replies.emplace(key, reply_bl);
+  }
   maybe_complete_notify();
 }
 
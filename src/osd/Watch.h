@@ -68,6 +68,8 @@ class Notify {
 
   /// (gid,cookie) -> reply_bl for everyone who acked the notify
   std::multimap<std::pair<uint64_t,uint64_t>, ceph::buffer::list> notify_replies;
+  /// bytes of notify_replies, up to osd_notify_max_reply_bytes
+  uint64_t notify_replies_bytes = 0;
 
   /// true if this notify is being discarded
   bool is_discarded() {
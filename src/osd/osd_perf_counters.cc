@@ -27,6 +27,9 @@ PerfCounters *build_osd_logger(CephContext *cct) {
   };
 
 
+  // updated from every op shard thread
+  osd_plb.set_sharded(true);
+
   // All the basic OSD operation stats are to be considered useful
   osd_plb.set_prio_default(PerfCountersBuilder::PRIO_USEFUL);
 
@@ -186,6 +189,9 @@ PerfCounters *build_osd_logger(CephContext *cct) {
     l_osd_pg_removing, "numpg_removing",
     "Placement groups queued for local deletion", "pgsr",
     PerfCountersBuilder::PRIO_USEFUL);
+  osd_plb.add_u64(
+    l_osd_pg_snaptrim_wait, "numpg_snaptrim_wait",
+    "Placement groups waiting for a snap trim reservation");
   osd_plb.add_u64(
     l_osd_hb_to, "heartbeat_to_peers", "Heartbeat (ping) peers we send to");
   osd_plb.add_u64_counter(l_osd_map, "map_messages", "OSD map messages");
@@ -257,6 +263,10 @@ PerfCounters *build_osd_logger(CephContext *cct) {
   osd_plb.add_u64_counter(
     l_osd_agent_evict, "agent_evict", "Tiering agent evictions");
 
+  osd_plb.add_u64_counter(
+    l_osd_snap_trim_objects, "snap_trim_objects",
+    "Objects trimmed of removed snapshots");
+
   osd_plb.add_u64_counter(
     l_osd_object_ctx_cache_hit, "object_ctx_cache_hit", "Object context cache hits");
   osd_plb.add_u64_counter(
@@ -278,6 +288,17 @@ PerfCounters *build_osd_logger(CephContext *cct) {
   osd_plb.add_u64_counter(
     l_osd_pg_biginfo, "osd_pg_biginfo", "PG updated its biginfo attr");
 
+  osd_plb.add_time_avg(
+    l_osd_pg_split_lat, "pg_split_lat",
+    "Time to split a PG into its children");
+  osd_plb.add_time_avg(
+    l_osd_pg_merge_lat, "pg_merge_lat",
+    "Time to merge the source PGs into a PG");
+
+  osd_plb.add_u64_counter(
+    l_osd_op_wq_steal, "op_wq_steal",
+    "Work items an idle shard thread took from another shard");
+
   return osd_plb.create_perf_counters();
 }
  
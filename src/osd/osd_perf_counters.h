@@ -68,6 +68,7 @@ enum {
   l_osd_pg_replica,
   l_osd_pg_stray,
   l_osd_pg_removing,
+  l_osd_pg_snaptrim_wait,
   l_osd_hb_to,
   l_osd_map,
   l_osd_mape,
@@ -106,6 +107,8 @@ enum {
   l_osd_agent_flush,
   l_osd_agent_evict,
 
+  l_osd_snap_trim_objects,
+
   l_osd_object_ctx_cache_hit,
   l_osd_object_ctx_cache_total,
 
@@ -118,6 +121,11 @@ enum {
   l_osd_pg_fastinfo,
   l_osd_pg_biginfo,
 
+  l_osd_pg_split_lat,
+  l_osd_pg_merge_lat,
+
+  l_osd_op_wq_steal,
+
   l_osd_last,
 };
 
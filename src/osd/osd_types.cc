@@ -1359,7 +1359,9 @@ static opt_mapping_t opt_mapping = boost::assign::map_list_of
            ("dedup_chunk_algorithm", pool_opts_t::opt_desc_t(
 	     pool_opts_t::DEDUP_CHUNK_ALGORITHM, pool_opts_t::STR))
            ("dedup_cdc_chunk_size", pool_opts_t::opt_desc_t(
-	     pool_opts_t::DEDUP_CDC_CHUNK_SIZE, pool_opts_t::INT));
+	     pool_opts_t::DEDUP_CDC_CHUNK_SIZE, pool_opts_t::INT))
+           ("compression_dictionary", pool_opts_t::opt_desc_t(
+	     pool_opts_t::COMPRESSION_DICTIONARY, pool_opts_t::STR));
 
 bool pool_opts_t::is_opt_name(const std::string& name)
 {
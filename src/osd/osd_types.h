@@ -1100,6 +1100,7 @@ public:
     DEDUP_TIER,
     DEDUP_CHUNK_ALGORITHM,
     DEDUP_CDC_CHUNK_SIZE,
+    COMPRESSION_DICTIONARY,
   };
 
   enum type_t {
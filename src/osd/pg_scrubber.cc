@@ -605,6 +605,25 @@ bool PgScrubber::write_blocked_by_scrub(const hobject_t& soid)
   return true;
 }
 
+double PgScrubber::deep_scrub_latency_sleep() const
+{
+  const auto& conf = get_pg_cct()->_conf;
+  double target = conf.get_val<double>("osd_deep_scrub_latency_target");
+  if (!m_is_deep || target <= 0) {
+    return 0;
+  }
+  double lat = m_pg->get_pgbackend()->get_deep_scrub_step_latency();
+  if (lat <= target) {
+    return 0;
+  }
+  // back off in proportion to how far over target the device is
+  double max_sleep = conf.get_val<double>("osd_deep_scrub_latency_max_sleep");
+  double sleep = std::min(max_sleep, max_sleep * (lat - target) / target);
+  dout(15) << __func__ << " step latency " << lat << " > " << target
+	   << ", sleeping " << sleep << dendl;
+  return sleep;
+}
+
 bool PgScrubber::range_intersects_scrub(const hobject_t& start, const hobject_t& end)
 {
   // does [start, end] intersect [scrubber.start, scrubber.m_max_end)
@@ -624,7 +643,9 @@ void PgScrubber::add_delayed_scheduling()
 
   milliseconds sleep_time{0ms};
   if (m_needs_sleep) {
-    double scrub_sleep = 1000.0 * m_osds->osd->scrub_sleep_time(m_flags.required);
+    double scrub_sleep = 1000.0 * std::max(
+      m_osds->osd->scrub_sleep_time(m_flags.required),
+      deep_scrub_latency_sleep());
     sleep_time = milliseconds{long(scrub_sleep)};
   }
   dout(15) << __func__ << " sleep: " << sleep_time.count() << "ms. needed? "
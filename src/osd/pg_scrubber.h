@@ -347,6 +347,9 @@ class PgScrubber : public ScrubPgIF, public ScrubMachineListener {
 
   void add_delayed_scheduling() final;
 
+  /// extra sleep between deep scrub chunks while reads are slow
+  double deep_scrub_latency_sleep() const;
+
   /**
    * @returns have we asked at least one replica?
    * 'false' means we are configured with no replicas, and
@@ -382,6 +382,20 @@ void mClockScheduler::dump(ceph::Formatter &f) const
 {
 }
 
+// client op carried by item, if any
+static MOSDOp *maybe_get_mosd_op(const OpSchedulerItem &item)
+{
+  auto op = item.maybe_get_op();
+  if (!op) {
+    return nullptr;
+  }
+  auto req = (*op)->get_nonconst_req();
+  if (req->get_type() != CEPH_MSG_OSD_OP) {
+    return nullptr;
+  }
+  return static_cast<MOSDOp*>(req);
+}
+
 void mClockScheduler::enqueue(OpSchedulerItem&& item)
 {
   auto id = get_scheduler_id(item);
@@ -391,11 +405,25 @@ void mClockScheduler::enqueue(OpSchedulerItem&& item)
     immediate.push_front(std::move(item));
   } else {
     int cost = calc_scaled_cost(item.get_cost());
+    MOSDOp *m = maybe_get_mosd_op(item);
+    if (m) {
+      // reported back so that the client can tag its next requests
+      m->set_qos_cost(cost);
+    }
     // Add item to scheduler queue
-    scheduler.add_request(
-      std::move(item),
-      id,
-      cost);
+    if (m && m->has_qos_params()) {
+      // the client's distributed tags: service it got from other osds
+      scheduler.add_request(
+	std::move(item),
+	id,
+	dmc::ReqParams(m->get_qos_delta(), m->get_qos_rho()),
+	cost);
+    } else {
+      scheduler.add_request(
+	std::move(item),
+	id,
+	cost);
+    }
   }
 }
 
@@ -424,6 +452,11 @@ WorkItem mClockScheduler::dequeue()
       ceph_assert(result.is_retn());
 
       auto &retn = result.get_retn();
+      if (MOSDOp *m = maybe_get_mosd_op(*retn.request); m) {
+	m->set_qos_phase(
+	  retn.phase == dmc::PhaseType::reservation ?
+	    MOSDOp::QOS_PHASE_RESERVATION : MOSDOp::QOS_PHASE_PRIORITY);
+      }
       return std::move(*retn.request);
     }
   }
@@ -96,6 +96,9 @@ void Journaler::_set_layout(file_layout_t const *l)
   // (watch out, this is big if you use big objects or weird striping)
   uint64_t periods = cct->_conf.get_val<uint64_t>("journaler_prefetch_periods");
   fetch_len = layout.get_period() * periods;
+  uint64_t max_periods =
+    cct->_conf.get_val<uint64_t>("journaler_prefetch_max_periods");
+  max_fetch_len = layout.get_period() * std::max(periods, max_periods);
 }
 
 
@@ -1295,6 +1298,14 @@ void Journaler::wait_for_readable(Context *onreadable)
     ldout(cct, 10) << "wait_for_readable at " << read_pos << " onreadable "
 		   << onreadable << dendl;
     on_readable = wrap_finisher(onreadable);
+    if (requested_pos > received_pos && fetch_len < max_fetch_len) {
+      // the reader caught up with the reads in flight: it is bound by
+      // their latency, so keep more of them in flight
+      fetch_len = std::min(fetch_len * 2, max_fetch_len);
+      ldout(cct, 10) << "wait_for_readable raising fetch_len to " << fetch_len
+		     << dendl;
+      _prefetch();
+    }
   } else {
     // race with OSD reply
     finisher->queue(onreadable, 0);
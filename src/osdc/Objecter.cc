@@ -526,7 +526,7 @@ void Objecter::shutdown()
 }
 
 void Objecter::_send_linger(LingerOp *info,
-			    ceph::shunique_lock<ceph::shared_mutex>& sul)
+			    ceph::shunique_lock<ceph::sharded_shared_mutex>& sul)
 {
   ceph_assert(sul.owns_lock() && sul.mutex() == &rwlock);
 
@@ -860,7 +860,7 @@ ceph_tid_t Objecter::linger_notify(LingerOp *info,
 }
 
 void Objecter::_linger_submit(LingerOp *info,
-			      ceph::shunique_lock<ceph::shared_mutex>& sul)
+			      ceph::shunique_lock<ceph::sharded_shared_mutex>& sul)
 {
   ceph_assert(sul.owns_lock() && sul.mutex() == &rwlock);
   ceph_assert(info->linger_id);
@@ -1023,7 +1023,7 @@ void Objecter::_scan_requests(
   map<ceph_tid_t, Op*>& need_resend,
   list<LingerOp*>& need_resend_linger,
   map<ceph_tid_t, CommandOp*>& need_resend_command,
-  ceph::shunique_lock<ceph::shared_mutex>& sul)
+  ceph::shunique_lock<ceph::sharded_shared_mutex>& sul)
 {
   ceph_assert(sul.owns_lock() && sul.mutex() == &rwlock);
 
@@ -1761,7 +1761,7 @@ void Objecter::_command_cancel_map_check(CommandOp *c)
  * promotion to write.
  */
 int Objecter::_get_session(int osd, OSDSession **session,
-			   shunique_lock<ceph::shared_mutex>& sul)
+			   shunique_lock<ceph::sharded_shared_mutex>& sul)
 {
   ceph_assert(sul && sul.mutex() == &rwlock);
 
@@ -1916,7 +1916,7 @@ void Objecter::wait_for_osd_map(epoch_t e)
 
 void Objecter::_get_latest_version(epoch_t oldest, epoch_t newest,
 				   std::unique_ptr<OpCompletion> fin,
-				   std::unique_lock<ceph::shared_mutex>&& l)
+				   std::unique_lock<ceph::sharded_shared_mutex>&& l)
 {
   ceph_assert(fin);
   if (osdmap->get_epoch() >= newest) {
@@ -2038,7 +2038,7 @@ void Objecter::_kick_requests(OSDSession *session,
 }
 
 void Objecter::_linger_ops_resend(map<uint64_t, LingerOp *>& lresend,
-				  unique_lock<ceph::shared_mutex>& ul)
+				  unique_lock<ceph::sharded_shared_mutex>& ul)
 {
   ceph_assert(ul.owns_lock());
   shunique_lock sul(std::move(ul));
@@ -2198,8 +2198,24 @@ void Objecter::op_submit(Op *op, ceph_tid_t *ptid, int *ctx_budget)
   _op_submit_with_budget(op, rl, ptid, ctx_budget);
 }
 
+void Objecter::op_submit(const std::vector<std::pair<Op*, ceph_tid_t*>>& ops)
+{
+  // the ops go out in the order they are given here, so those on the
+  // same object keep it.  the ones to the same osd are queued on its
+  // connection back to back and are written out together.
+  shunique_lock rl(rwlock, ceph::acquire_shared);
+  for (auto [op, ptid] : ops) {
+    ceph_tid_t tid = 0;
+    if (!ptid)
+      ptid = &tid;
+    op->trace.event("op submit");
+    _op_submit_with_budget(op, rl, ptid, nullptr);
+  }
+  ldout(cct, 10) << __func__ << " submitted " << ops.size() << " ops" << dendl;
+}
+
 void Objecter::_op_submit_with_budget(Op *op,
-				      shunique_lock<ceph::shared_mutex>& sul,
+				      shunique_lock<ceph::sharded_shared_mutex>& sul,
 				      ceph_tid_t *ptid,
 				      int *ctx_budget)
 {
@@ -2303,7 +2319,7 @@ void Objecter::_send_op_account(Op *op)
   }
 }
 
-void Objecter::_op_submit(Op *op, shunique_lock<ceph::shared_mutex>& sul, ceph_tid_t *ptid)
+void Objecter::_op_submit(Op *op, shunique_lock<ceph::sharded_shared_mutex>& sul, ceph_tid_t *ptid)
 {
   // rwlock is locked
 
@@ -2685,6 +2701,15 @@ void Objecter::_prune_snapc(
   }
 }
 
+uint64_t Objecter::_get_read_latency(int osd) const
+{
+  // rwlock is locked; an osd we have not read from yet looks fastest
+  auto p = osd_sessions.find(osd);
+  if (p == osd_sessions.end())
+    return 0;
+  return p->second->read_latency.load(std::memory_order_relaxed);
+}
+
 int Objecter::_calc_target(op_target_t *t, Connection *con, bool any_change)
 {
   // rwlock is locked
@@ -2874,11 +2899,17 @@ int Objecter::_calc_target(op_target_t *t, Connection *con, bool any_change)
       int osd;
       ceph_assert(is_read && acting[0] == acting_primary);
       if (t->flags & CEPH_OSD_FLAG_BALANCE_READS) {
+	// the faster of two random replicas, so that a slow or busy osd
+	// gets fewer reads without all of them going to the fastest one
 	int p = rand() % acting.size();
+	int q = rand() % acting.size();
+	if (_get_read_latency(acting[q]) < _get_read_latency(acting[p]))
+	  p = q;
 	if (p)
 	  t->used_replica = true;
 	osd = acting[p];
-	ldout(cct, 10) << " chose random osd." << osd << " of " << acting
+	ldout(cct, 10) << " chose osd." << osd << " of " << acting
+		       << " read latency " << _get_read_latency(osd) << "ns"
 		       << dendl;
       } else {
 	// look for a local replica.  prefer the primary if the
@@ -2922,7 +2953,7 @@ int Objecter::_calc_target(op_target_t *t, Connection *con, bool any_change)
 }
 
 int Objecter::_map_session(op_target_t *target, OSDSession **s,
-			   shunique_lock<ceph::shared_mutex>& sul)
+			   shunique_lock<ceph::sharded_shared_mutex>& sul)
 {
   _calc_target(target, nullptr);
   return _get_session(target->osd, s, sul);
@@ -3029,7 +3060,7 @@ void Objecter::_session_command_op_assign(OSDSession *to, CommandOp *op)
 }
 
 int Objecter::_recalc_linger_op_target(LingerOp *linger_op,
-				       shunique_lock<ceph::shared_mutex>& sul)
+				       shunique_lock<ceph::sharded_shared_mutex>& sul)
 {
   // rwlock is locked unique
 
@@ -3116,6 +3147,8 @@ Objecter::MOSDOp *Objecter::_prepare_osd_op(Op *op)
 
   op->target.paused = false;
   op->stamp = ceph::coarse_mono_clock::now();
+  if (op->target.flags & CEPH_OSD_FLAG_BALANCE_READS)
+    op->sent = ceph::mono_clock::now();
 
   hobject_t hobj = op->target.get_hobj();
   auto m = new MOSDOp(client_inc, op->tid,
@@ -3144,6 +3177,11 @@ Objecter::MOSDOp *Objecter::_prepare_osd_op(Op *op)
     m->set_reqid(op->reqid);
   }
 
+  if (qos_tracker && op->target.osd >= 0) {
+    auto [delta, rho] = qos_tracker->get_req_params(op->target.osd);
+    m->set_qos_params(delta, rho);
+  }
+
   logger->inc(l_osdc_op_send);
   ssize_t sum = 0;
   for (unsigned i = 0; i < m->ops.size(); i++) {
@@ -3246,7 +3284,7 @@ int Objecter::calc_op_budget(const bc::small_vector_base<OSDOp>& ops)
 }
 
 void Objecter::_throttle_op(Op *op,
-			    shunique_lock<ceph::shared_mutex>& sul,
+			    shunique_lock<ceph::sharded_shared_mutex>& sul,
 			    int op_budget)
 {
   ceph_assert(sul && sul.mutex() == &rwlock);
@@ -3323,6 +3361,10 @@ void Objecter::handle_osd_op_reply(MOSDOpReply *m)
   Op *op = iter->second;
   op->trace.event("osd op reply");
 
+  if (qos_tracker && m->get_qos_phase() != MOSDOp::QOS_PHASE_NONE) {
+    qos_tracker->track_resp(s->osd, m->get_qos_phase(), m->get_qos_cost());
+  }
+
   if (retry_writes_after_first_reply && op->attempts == 1 &&
       (op->target.flags & CEPH_OSD_FLAG_WRITE)) {
     ldout(cct, 7) << "retrying write after first reply: " << tid << dendl;
@@ -3358,6 +3400,11 @@ void Objecter::handle_osd_op_reply(MOSDOpReply *m)
 
   int rc = m->get_result();
 
+  if ((op->target.flags & CEPH_OSD_FLAG_BALANCE_READS) &&
+      rc != -EAGAIN && !m->is_redirect_reply()) {
+    s->note_read_latency(ceph::mono_clock::now() - op->sent);
+  }
+
   if (m->is_redirect_reply()) {
     ldout(cct, 5) << " got redirect reply; redirecting" << dendl;
     if (op->has_completion())
@@ -4759,7 +4806,7 @@ void Objecter::submit_command(CommandOp *c, ceph_tid_t *ptid)
 }
 
 int Objecter::_calc_command_target(CommandOp *c,
-				   shunique_lock<ceph::shared_mutex>& sul)
+				   shunique_lock<ceph::sharded_shared_mutex>& sul)
 {
   ceph_assert(sul.owns_lock() && sul.mutex() == &rwlock);
 
@@ -4815,7 +4862,7 @@ int Objecter::_calc_command_target(CommandOp *c,
 }
 
 void Objecter::_assign_command_session(CommandOp *c,
-				       shunique_lock<ceph::shared_mutex>& sul)
+				       shunique_lock<ceph::sharded_shared_mutex>& sul)
 {
   ceph_assert(sul.owns_lock() && sul.mutex() == &rwlock);
 
@@ -4907,10 +4954,47 @@ Objecter::OSDSession::~OSDSession()
 Objecter::Objecter(CephContext *cct,
 		   Messenger *m, MonClient *mc,
 		   boost::asio::io_context& service) :
-  Dispatcher(cct), messenger(m), monc(mc), service(service)
+  Dispatcher(cct), messenger(m), monc(mc), service(service),
+  pg_mapping_lock("Objecter::pg_mapping_lock",
+		  cct->_conf.get_val<uint64_t>("objecter_rwlock_shards")),
+  rwlock("Objecter::rwlock",
+	 cct->_conf.get_val<uint64_t>("objecter_rwlock_shards"))
 {
   mon_timeout = cct->_conf.get_val<std::chrono::seconds>("rados_mon_op_timeout");
   osd_timeout = cct->_conf.get_val<std::chrono::seconds>("rados_osd_op_timeout");
+  if (cct->_conf.get_val<bool>("objecter_mclock_service_tracker")) {
+    qos_tracker = std::make_unique<QoSTracker>();
+  }
+}
+
+std::pair<uint32_t, uint32_t> Objecter::QoSTracker::get_req_params(int osd)
+{
+  std::lock_guard l{lock};
+  auto [it, inserted] = servers.try_emplace(osd, delta_counter, rho_counter);
+  if (inserted) {
+    // first request to this osd
+    return {1, 1};
+  }
+  auto& s = it->second;
+  uint32_t delta = delta_counter - s.delta_prev_req - s.my_delta;
+  uint32_t rho = rho_counter - s.rho_prev_req - s.my_rho;
+  s.delta_prev_req = delta_counter;
+  s.rho_prev_req = rho_counter;
+  s.my_delta = 0;
+  s.my_rho = 0;
+  return {delta, rho};
+}
+
+void Objecter::QoSTracker::track_resp(int osd, uint8_t phase, uint32_t cost)
+{
+  std::lock_guard l{lock};
+  auto& s = servers.try_emplace(osd, delta_counter, rho_counter).first->second;
+  delta_counter += cost;
+  s.my_delta += cost;
+  if (phase == MOSDOp::QOS_PHASE_RESERVATION) {
+    rho_counter += cost;
+    s.my_rho += cost;
+  }
 }
 
 Objecter::~Objecter()
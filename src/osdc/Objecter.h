@@ -47,6 +47,7 @@
 #include "common/ceph_mutex.h"
 #include "common/ceph_timer.h"
 #include "common/config_obs.h"
+#include "common/sharded_shared_mutex.h"
 #include "common/shunique_lock.h"
 #include "common/zipkin_trace.h"
 #include "common/Throttle.h"
@@ -1658,6 +1659,34 @@ private:
   // to be drained by consume_blocklist_events.
   bool blocklist_events_enabled = false;
   std::set<entity_addr_t> blocklist_events;
+
+  // Per-osd dmclock request parameters, tracked as dmclock's
+  // ServiceTracker does: for each osd, delta is the work any osd has
+  // completed for us since our last request to it, and rho that part
+  // of it served in the reservation phase.  An osd's mclock scheduler
+  // uses these to account for the service we got elsewhere, so our
+  // reservation and limit hold across the cluster rather than per osd.
+  class QoSTracker {
+    struct server_t {
+      uint64_t delta_prev_req;
+      uint64_t rho_prev_req;
+      uint32_t my_delta = 0;
+      uint32_t my_rho = 0;
+      server_t(uint64_t delta, uint64_t rho)
+	: delta_prev_req(delta), rho_prev_req(rho) {}
+    };
+    ceph::mutex lock = ceph::make_mutex("Objecter::QoSTracker::lock");
+    uint64_t delta_counter = 1;
+    uint64_t rho_counter = 1;
+    std::map<int, server_t> servers;
+
+  public:
+    /// (delta, rho) to send with our next request to @p osd
+    std::pair<uint32_t, uint32_t> get_req_params(int osd);
+    /// note a reply from @p osd, served in @p phase (MOSDOp::QOS_PHASE_*)
+    void track_resp(int osd, uint8_t phase, uint32_t cost);
+  };
+  std::unique_ptr<QoSTracker> qos_tracker;
   struct pg_mapping_t {
     epoch_t epoch = 0;
     std::vector<int> up;
@@ -1671,8 +1700,8 @@ private:
                : epoch(epoch), up(up), up_primary(up_primary),
                  acting(acting), acting_primary(acting_primary) {}
   };
-  ceph::shared_mutex pg_mapping_lock =
-    ceph::make_shared_mutex("Objecter::pg_mapping_lock");
+  // looked up by every op submission, updated on cache misses
+  ceph::sharded_shared_mutex pg_mapping_lock;
   // pool -> pg mapping
   std::map<int64_t, std::vector<pg_mapping_t>> pg_mappings;
 
@@ -1727,8 +1756,9 @@ private:
   version_t last_seen_osdmap_version = 0;
   version_t last_seen_pgmap_version = 0;
 
-  mutable ceph::shared_mutex rwlock =
-	   ceph::make_shared_mutex("Objecter::rwlock");
+  // protects the osdmap and the session/op bookkeeping.  op submission
+  // only needs it shared, so it is sharded to let submitters scale.
+  mutable ceph::sharded_shared_mutex rwlock;
   ceph::timer<ceph::coarse_mono_clock> timer;
 
   PerfCounters* logger = nullptr;
@@ -1928,6 +1958,8 @@ public:
     epoch_t *reply_epoch = nullptr;
 
     ceph::coarse_mono_time stamp;
+    /// when a balanced read was last sent, to the precision of its latency
+    ceph::mono_time sent;
 
     epoch_t map_dne_bound = 0;
 
@@ -2240,9 +2272,9 @@ public:
 
   void submit_command(CommandOp *c, ceph_tid_t *ptid);
   int _calc_command_target(CommandOp *c,
-			   ceph::shunique_lock<ceph::shared_mutex> &sul);
+			   ceph::shunique_lock<ceph::sharded_shared_mutex> &sul);
   void _assign_command_session(CommandOp *c,
-			       ceph::shunique_lock<ceph::shared_mutex> &sul);
+			       ceph::shunique_lock<ceph::sharded_shared_mutex> &sul);
   void _send_command(CommandOp *c);
   int command_op_cancel(OSDSession *s, ceph_tid_t tid,
 			boost::system::error_code ec);
@@ -2390,6 +2422,9 @@ public:
     ConnectionRef con;
     int num_locks;
     std::unique_ptr<std::mutex[]> completion_locks;
+    /// moving average of the latency of the balanced reads it served, in
+    /// ns; updated under lock, read by _calc_target without it
+    std::atomic<uint64_t> read_latency{0};
 
     OSDSession(CephContext *cct, int o) :
       osd(o), incarnation(0), con(NULL),
@@ -2401,6 +2436,14 @@ public:
     bool is_homeless() { return (osd == -1); }
 
     std::unique_lock<std::mutex> get_lock(object_t& oid);
+
+    void note_read_latency(ceph::timespan lat) {
+      uint64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+	lat).count();
+      uint64_t avg = read_latency.load(std::memory_order_relaxed);
+      read_latency.store(avg ? avg - avg / 8 + ns / 8 : ns,
+			 std::memory_order_relaxed);
+    }
   };
   std::map<int,OSDSession*> osd_sessions;
 
@@ -2474,8 +2517,9 @@ public:
   bool target_should_be_paused(op_target_t *op);
   int _calc_target(op_target_t *t, Connection *con,
 		   bool any_change = false);
+  uint64_t _get_read_latency(int osd) const;
   int _map_session(op_target_t *op, OSDSession **s,
-		   ceph::shunique_lock<ceph::shared_mutex>& lc);
+		   ceph::shunique_lock<ceph::sharded_shared_mutex>& lc);
 
   void _session_op_assign(OSDSession *s, Op *op);
   void _session_op_remove(OSDSession *s, Op *op);
@@ -2484,16 +2528,16 @@ public:
   void _session_command_op_assign(OSDSession *to, CommandOp *op);
   void _session_command_op_remove(OSDSession *from, CommandOp *op);
 
-  int _assign_op_target_session(Op *op, ceph::shunique_lock<ceph::shared_mutex>& lc,
+  int _assign_op_target_session(Op *op, ceph::shunique_lock<ceph::sharded_shared_mutex>& lc,
 				bool src_session_locked,
 				bool dst_session_locked);
   int _recalc_linger_op_target(LingerOp *op,
-			       ceph::shunique_lock<ceph::shared_mutex>& lc);
+			       ceph::shunique_lock<ceph::sharded_shared_mutex>& lc);
 
   void _linger_submit(LingerOp *info,
-		      ceph::shunique_lock<ceph::shared_mutex>& sul);
+		      ceph::shunique_lock<ceph::sharded_shared_mutex>& sul);
   void _send_linger(LingerOp *info,
-		    ceph::shunique_lock<ceph::shared_mutex>& sul);
+		    ceph::shunique_lock<ceph::sharded_shared_mutex>& sul);
   void _linger_commit(LingerOp *info, boost::system::error_code ec,
 		      ceph::buffer::list& outbl);
   void _linger_reconnect(LingerOp *info, boost::system::error_code ec);
@@ -2525,10 +2569,10 @@ private:
 
   void _kick_requests(OSDSession *session, std::map<uint64_t, LingerOp *>& lresend);
   void _linger_ops_resend(std::map<uint64_t, LingerOp *>& lresend,
-			  std::unique_lock<ceph::shared_mutex>& ul);
+			  std::unique_lock<ceph::sharded_shared_mutex>& ul);
 
   int _get_session(int osd, OSDSession **session,
-		   ceph::shunique_lock<ceph::shared_mutex>& sul);
+		   ceph::shunique_lock<ceph::sharded_shared_mutex>& sul);
   void put_session(OSDSession *s);
   void get_session(OSDSession *s);
   void _reopen_session(OSDSession *session);
@@ -2546,9 +2590,9 @@ private:
    * If throttle_op needs to throttle it will unlock client_lock.
    */
   int calc_op_budget(const boost::container::small_vector_base<OSDOp>& ops);
-  void _throttle_op(Op *op, ceph::shunique_lock<ceph::shared_mutex>& sul,
+  void _throttle_op(Op *op, ceph::shunique_lock<ceph::sharded_shared_mutex>& sul,
 		    int op_size = 0);
-  int _take_op_budget(Op *op, ceph::shunique_lock<ceph::shared_mutex>& sul) {
+  int _take_op_budget(Op *op, ceph::shunique_lock<ceph::sharded_shared_mutex>& sul) {
     ceph_assert(sul && sul.mutex() == &rwlock);
     int op_budget = calc_op_budget(op->ops);
     if (keep_balanced_budget) {
@@ -2622,7 +2666,7 @@ private:
     std::map<ceph_tid_t, Op*>& need_resend,
     std::list<LingerOp*>& need_resend_linger,
     std::map<ceph_tid_t, CommandOp*>& need_resend_command,
-    ceph::shunique_lock<ceph::shared_mutex>& sul);
+    ceph::shunique_lock<ceph::sharded_shared_mutex>& sul);
 
   int64_t get_object_hash_position(int64_t pool, const std::string& key,
 				   const std::string& ns);
@@ -2701,15 +2745,17 @@ private:
                              const OSDMap &new_osd_map);
 
   // low-level
-  void _op_submit(Op *op, ceph::shunique_lock<ceph::shared_mutex>& lc,
+  void _op_submit(Op *op, ceph::shunique_lock<ceph::sharded_shared_mutex>& lc,
 		  ceph_tid_t *ptid);
   void _op_submit_with_budget(Op *op,
-			      ceph::shunique_lock<ceph::shared_mutex>& lc,
+			      ceph::shunique_lock<ceph::sharded_shared_mutex>& lc,
 			      ceph_tid_t *ptid,
 			      int *ctx_budget = NULL);
   // public interface
 public:
   void op_submit(Op *op, ceph_tid_t *ptid = NULL, int *ctx_budget = NULL);
+  /// submit each op with its tid pointer, under a single hold of rwlock
+  void op_submit(const std::vector<std::pair<Op*, ceph_tid_t*>>& ops);
   bool is_active() {
     std::shared_lock l(rwlock);
     return !((!inflight_ops) && linger_ops.empty() &&
@@ -2822,7 +2868,7 @@ public:
 
   void _get_latest_version(epoch_t oldest, epoch_t neweset,
 			   std::unique_ptr<OpCompletion> fin,
-			   std::unique_lock<ceph::shared_mutex>&& ul);
+			   std::unique_lock<ceph::sharded_shared_mutex>&& ul);
 
   /** Get the current set of global op flags */
   int get_global_op_flags() const { return global_op_flags; }
@@ -16,6 +16,7 @@
 
 #include "include/types.h"
 #include "include/buffer.h"
+#include "include/intarith.h"
 #include "osd/OSDMap.h"
 
 #include "common/config.h"
@@ -130,7 +131,8 @@ void Striper::file_to_extents(CephContext *cct, const char *object_format,
                   &lightweight_object_extents);
 
   // convert lightweight object extents to heavyweight version
-  extents.reserve(lightweight_object_extents.size());
+  const auto oloc = OSDMap::file_to_object_locator(*layout);
+  extents.reserve(extents.size() + lightweight_object_extents.size());
   for (auto& lightweight_object_extent : lightweight_object_extents) {
     auto& object_extent = extents.emplace_back(
       object_t(format_oid(object_format, lightweight_object_extent.object_no)),
@@ -138,7 +140,7 @@ void Striper::file_to_extents(CephContext *cct, const char *object_format,
       lightweight_object_extent.offset, lightweight_object_extent.length,
       lightweight_object_extent.truncate_size);
 
-    object_extent.oloc = OSDMap::file_to_object_locator(*layout);
+    object_extent.oloc = oloc;
     object_extent.buffer_extents.reserve(
       lightweight_object_extent.buffer_extents.size());
     object_extent.buffer_extents.insert(
@@ -161,6 +163,7 @@ void Striper::file_to_extents(
                   &lightweight_object_extents);
 
   // convert lightweight object extents to heavyweight version
+  const auto oloc = OSDMap::file_to_object_locator(*layout);
   for (auto& lightweight_object_extent : lightweight_object_extents) {
     auto oid = format_oid(object_format, lightweight_object_extent.object_no);
     auto& object_extent = object_extents[oid].emplace_back(
@@ -168,7 +171,7 @@ void Striper::file_to_extents(
       lightweight_object_extent.offset, lightweight_object_extent.length,
       lightweight_object_extent.truncate_size);
 
-      object_extent.oloc = OSDMap::file_to_object_locator(*layout);
+      object_extent.oloc = oloc;
       object_extent.buffer_extents.reserve(
         lightweight_object_extent.buffer_extents.size());
       object_extent.buffer_extents.insert(
@@ -206,6 +209,31 @@ void Striper::file_to_extents(
 
   uint64_t cur = offset;
   uint64_t left = len;
+  if (stripe_count == 1 && object_extents->empty()) {
+    // the range maps onto consecutive objects, one extent each, so they
+    // are appended in order without looking for one to extend.  the
+    // usual power of two object sizes make it shifts and masks.
+    const bool pow2 = isp2(object_size);
+    const unsigned order = pow2 ? ctz(object_size) : 0;
+    auto object_of = [&](uint64_t off) {
+      return pow2 ? off >> order : off / object_size;
+    };
+    object_extents->reserve(object_of(offset + len - 1) - object_of(offset) + 1);
+    while (left > 0) {
+      uint64_t objectno = object_of(cur);
+      uint64_t x_offset = pow2 ? cur & (object_size - 1) : cur % object_size;
+      uint64_t x_len = std::min<uint64_t>(left, object_size - x_offset);
+      auto& ex = object_extents->emplace_back(
+        objectno, x_offset, x_len,
+        object_truncate_size(cct, layout, objectno, trunc_size));
+      ex.buffer_extents.emplace_back(cur - offset + buffer_offset, x_len);
+      ldout(cct, 15) << "file_to_extents  " << ex << dendl;
+      left -= x_len;
+      cur += x_len;
+    }
+    return;
+  }
+
   while (left > 0) {
     // layout into objects
     uint64_t blockno = cur / su; // which block
@@ -1622,6 +1622,16 @@ class MgrModule(ceph_module.BaseMgrModule, MgrModuleLoggingMixin):
 
         return result
 
+    def get_native_metrics(self) -> str:
+        """
+        Return the perf counters of the daemons get_all_perf_counters()
+        covers, at its default priority, and the PG states per pool, in
+        the Prometheus text format.  ceph-mgr keeps this text up to date
+        as daemons report, without holding the GIL; it starts doing so on
+        the first call, so daemons show up as they next report.
+        """
+        return self._ceph_get_native_metrics()
+
     def set_uri(self, uri: str) -> None:
         """
         If the module exposes a service, then call this to publish the
@@ -1735,7 +1745,8 @@ class MgrModule(ceph_module.BaseMgrModule, MgrModuleLoggingMixin):
            'pg_id', 'object_name', 'snap_id'
         Valid performance counter types:
            'ops', 'write_ops', 'read_ops', 'bytes', 'write_bytes', 'read_bytes',
-           'latency', 'write_latency', 'read_latency'
+           'latency', 'write_latency', 'read_latency', 'queue_latency',
+           'process_latency'
 
         :param object query: query
         :rtype: int (query id)
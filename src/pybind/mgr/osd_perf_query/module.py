@@ -20,12 +20,15 @@ def get_human_readable(bytes, precision=2):
         bytes = bytes / 1024.0
     return '%.*f%s' % (precision, bytes, suffixes[suffix_index])
 
+LATENCY_COUNTERS = ['write_latency', 'read_latency', 'queue_latency',
+                    'process_latency']
+
 class OSDPerfQuery(MgrModule):
     COMMANDS = [
         {
             "cmd": "osd perf query add "
                    "name=query,type=CephChoices,"
-                   "strings=client_id|rbd_image_id|all_subkeys",
+                   "strings=client_id|rbd_image_id|pool_id|all_subkeys",
             "desc": "add osd perf query",
             "perm": "w"
         },
@@ -67,6 +70,17 @@ class OSDPerfQuery(MgrModule):
         'limit': {'order_by': 'bytes', 'max_count': 10},
     }
 
+    POOL_ID_QUERY = {
+        'key_descriptor': [
+            {'type': 'pool_id', 'regex': '^(.+)$'},
+        ],
+        'performance_counter_descriptors': [
+            'ops', 'write_ops', 'read_ops', 'write_latency', 'read_latency',
+            'queue_latency', 'process_latency',
+        ],
+        'limit': {'order_by': 'ops', 'max_count': 10},
+    }
+
     ALL_SUBKEYS_QUERY = {
         'key_descriptor': [
             {'type': 'client_id', 'regex': '^(.*)$'},
@@ -91,6 +105,8 @@ class OSDPerfQuery(MgrModule):
                 query = self.RBD_IMAGE_ID_QUERY
             elif cmd['query'] == 'client_id':
                 query = self.CLIENT_ID_QUERY
+            elif cmd['query'] == 'pool_id':
+                query = self.POOL_ID_QUERY
             else:
                 query = self.ALL_SUBKEYS_QUERY
             query_id = self.add_osd_perf_query(query)
@@ -124,7 +140,7 @@ class OSDPerfQuery(MgrModule):
                     continue
                 elif d in ['write_bytes', 'read_bytes']:
                     desc += '/sec'
-                elif d in ['write_latency', 'read_latency']:
+                elif d in LATENCY_COUNTERS:
                     desc += '(msec)'
                 column_names.append(desc.upper())
 
@@ -177,7 +193,7 @@ class OSDPerfQuery(MgrModule):
                     elif descriptors[i] in ['write_bytes', 'read_bytes']:
                         bps = counters[i][0] / (now - last_update)
                         row.append(get_human_readable(bps))
-                    elif descriptors[i] in ['write_latency', 'read_latency']:
+                    elif descriptors[i] in LATENCY_COUNTERS:
                         lat = 0
                         if counters[i][1] > 0:
                             lat = 1.0 * counters[i][0] / counters[i][1] / 1000000
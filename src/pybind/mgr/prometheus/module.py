@@ -292,6 +292,13 @@ class Module(MgrModule):
             name='rbd_stats_pools_refresh_interval',
             type='int',
             default=300
+        ),
+        Option(
+            name='native_exporter',
+            type='bool',
+            default=False,
+            desc='Take the perf counters and PG states from ceph-mgr\'s '
+                 'own cache rather than walking them at each scrape'
         )
     ]
 
@@ -1189,23 +1196,8 @@ class Module(MgrModule):
                 cast(MetricCounter, sum_metric).add(duration, (method_name,))
                 cast(MetricCounter, count_metric).add(1, (method_name,))
 
-    @profile_method(True)
-    def collect(self) -> str:
-        # Clear the metrics before scraping
-        for k in self.metrics.keys():
-            self.metrics[k].clear()
-
-        self.get_health()
-        self.get_df()
-        self.get_pool_stats()
-        self.get_fs()
-        self.get_osd_stats()
-        self.get_quorum_status()
-        self.get_mgr_status()
-        self.get_metadata_and_osd_status()
-        self.get_pg_status()
-        self.get_num_objects()
-
+    @profile_method()
+    def get_perf_counters(self) -> None:
         for daemon, counters in self.get_all_perf_counters().items():
             for path, counter_info in counters.items():
                 # Skip histograms, they are represented by long running avgs
@@ -1252,15 +1244,41 @@ class Module(MgrModule):
                         )
                     self.metrics[path].set(value, labels)
 
+    @profile_method(True)
+    def collect(self) -> str:
+        # Clear the metrics before scraping
+        for k in self.metrics.keys():
+            self.metrics[k].clear()
+        native = self.get_module_option('native_exporter')
+
+        self.get_health()
+        self.get_df()
+        self.get_pool_stats()
+        self.get_fs()
+        self.get_osd_stats()
+        self.get_quorum_status()
+        self.get_mgr_status()
+        self.get_metadata_and_osd_status()
+        if not native:
+            self.get_pg_status()
+        self.get_num_objects()
+
+        if not native:
+            self.get_perf_counters()
+
         self.add_fixed_name_metrics()
         self.get_rbd_stats()
 
         self.get_collect_time_metrics()
 
         # Return formatted metrics and clear no longer used data
-        _metrics = [m.str_expfmt() for m in self.metrics.values()]
+        _metrics = [m.str_expfmt() for k, m in self.metrics.items()
+                    if not (native and k.startswith('pg_'))]
         for k in self.metrics.keys():
             self.metrics[k].clear()
+        if native:
+            # the perf counters and PG states, from ceph-mgr's own cache
+            _metrics.append('\n' + self.get_native_metrics())
 
         return ''.join(_metrics) + '\n'
 
@@ -51,6 +51,10 @@ class ClientIO : public io::RestfulClient,
     return write_data(buf, len);
   }
 
+  size_t send_body_bl(const ceph::bufferlist& bl) override {
+    return write_data_bl(bl);
+  }
+
   RGWEnv& get_env() noexcept override {
     return env;
   }
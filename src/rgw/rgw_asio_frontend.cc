@@ -56,6 +56,7 @@ class StreamIO : public rgw::asio::ClientIO {
   spawn::yield_context yield;
   parse_buffer& buffer;
   ceph::timespan request_timeout;
+  std::vector<boost::asio::const_buffer> buffers;
  public:
   StreamIO(CephContext *cct, Stream& stream, rgw::asio::parser_type& parser,
            spawn::yield_context yield,
@@ -67,14 +68,14 @@ class StreamIO : public rgw::asio::ClientIO {
         cct(cct), stream(stream), yield(yield), buffer(buffer), request_timeout(request_timeout)
   {}
 
-  size_t write_data(const char* buf, size_t len) override {
+  template <typename ConstBufferSequence>
+  size_t write_buffers(const ConstBufferSequence& buffers) {
     boost::system::error_code ec;
     auto& timeout = get_lowest_layer(stream);
     if (request_timeout.count()) {
       timeout.expires_after(request_timeout);
     }
-    auto bytes = boost::asio::async_write(stream, boost::asio::buffer(buf, len),
-                                          yield[ec]);
+    auto bytes = boost::asio::async_write(stream, buffers, yield[ec]);
     if (ec) {
       ldout(cct, 4) << "write_data failed: " << ec.message() << dendl;
       if (ec==boost::asio::error::broken_pipe) {
@@ -86,6 +87,22 @@ class StreamIO : public rgw::asio::ClientIO {
     return bytes;
   }
 
+  size_t write_data(const char* buf, size_t len) override {
+    return write_buffers(boost::asio::buffer(buf, len));
+  }
+
+  // gather the segments of bl into one write instead of copying them into
+  // a contiguous buffer. the coroutine is suspended until the write
+  // completes, so the caller's references keep the segments alive
+  size_t write_data_bl(const ceph::bufferlist& bl) override {
+    buffers.clear();
+    buffers.reserve(bl.get_num_buffers());
+    for (const auto& ptr : bl.buffers()) {
+      buffers.emplace_back(ptr.c_str(), ptr.length());
+    }
+    return write_buffers(buffers);
+  }
+
   size_t recv_body(char* buf, size_t max) override {
     auto& timeout = get_lowest_layer(stream);
     auto& message = parser.get();
@@ -16,6 +16,7 @@
 #include "rgw_client_io.h"
 #include "rgw_rest.h"
 #include "rgw_crypt_sanitize.h"
+#include "common/lru_map.h"
 
 #include <boost/container/small_vector.hpp>
 #include <boost/algorithm/string.hpp>
@@ -871,6 +872,25 @@ get_v4_signing_key(CephContext* const cct,
                    const std::string_view& secret_access_key,
                    const DoutPrefixProvider *dpp)
 {
+  /* The key only changes with the date, region and service of the scope,
+   * so a client signing many requests would have us redo the four HMACs
+   * for each of them. Keep the ones derived, by their scope and secret. */
+  static const uint64_t max =
+    cct->_conf.get_val<uint64_t>("rgw_sigv4_signing_key_cache_size");
+  static lru_map<std::string, sha256_digest_t> signing_keys(max);
+  std::string cache_key;
+  if (max) {
+    cache_key.reserve(credential_scope.size() + 1 + secret_access_key.size());
+    cache_key.append(credential_scope);
+    cache_key.push_back('\0');
+    cache_key.append(secret_access_key);
+    sha256_digest_t signing_key;
+    if (signing_keys.find(cache_key, signing_key)) {
+      ldpp_dout(dpp, 10) << "signing_k = " << signing_key << " (cached)" << dendl;
+      return signing_key;
+    }
+  }
+
   std::string_view date, region, service;
   std::tie(date, region, service) = parse_cred_scope(credential_scope);
 
@@ -888,6 +908,10 @@ get_v4_signing_key(CephContext* const cct,
   ldpp_dout(dpp, 10) << "service_k = " << service_k << dendl;
   ldpp_dout(dpp, 10) << "signing_k = " << signing_key << dendl;
 
+  if (max) {
+    auto v = signing_key;
+    signing_keys.add(cache_key, v);
+  }
   return signing_key;
 }
 
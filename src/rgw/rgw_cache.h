@@ -6,6 +6,7 @@
 
 #include <string>
 #include <map>
+#include <memory>
 #include <unordered_map>
 #include "include/types.h"
 #include "include/utime.h"
@@ -154,29 +155,53 @@ struct ObjectCacheEntry {
   ObjectCacheEntry() : lru_promotion_ts(0), gen(0) {}
 };
 
+/*
+ * The entries are spread over shards by the hash of their name, each with
+ * its own map, lru and lock, so that requests for different metadata
+ * objects don't serialize on one lock.  rgw_cache_lru_size bounds the sum
+ * of the shards.  The chained caches and the enabled flag are shared:
+ * enabled only changes with all the shard locks held.
+ */
 class ObjectCache {
-  std::unordered_map<string, ObjectCacheEntry> cache_map;
-  std::list<string> lru;
-  unsigned long lru_size;
-  unsigned long lru_counter;
-  unsigned long lru_window;
-  ceph::shared_mutex lock = ceph::make_shared_mutex("ObjectCache");
+  struct Shard {
+    std::unordered_map<string, ObjectCacheEntry> cache_map;
+    std::list<string> lru;
+    unsigned long lru_size = 0;
+    unsigned long lru_counter = 0;
+    unsigned long lru_window = 0;
+    unsigned long lru_max = 0;
+    ceph::shared_mutex lock = ceph::make_shared_mutex("ObjectCache::Shard");
+  };
+  std::vector<std::unique_ptr<Shard>> shards;
   CephContext *cct;
 
+  ceph::mutex chained_lock = ceph::make_mutex("ObjectCache::chained_lock");
   vector<RGWChainedCache *> chained_cache;
 
   bool enabled;
   ceph::timespan expiry;
 
-  void touch_lru(const DoutPrefixProvider *dpp, const string& name, ObjectCacheEntry& entry,
+  size_t shard_index(const string& name) const {
+    return std::hash<string>{}(name) % shards.size();
+  }
+  Shard& get_shard(const string& name) {
+    return *shards[shard_index(name)];
+  }
+  std::vector<std::unique_lock<ceph::shared_mutex>> lock_all();
+
+  void touch_lru(const DoutPrefixProvider *dpp, Shard& shard,
+		 const string& name, ObjectCacheEntry& entry,
 		 std::list<string>::iterator& lru_iter);
-  void remove_lru(const string& name, std::list<string>::iterator& lru_iter);
+  void remove_lru(Shard& shard, const string& name,
+		  std::list<string>::iterator& lru_iter);
   void invalidate_lru(ObjectCacheEntry& entry);
 
   void do_invalidate_all();
 
 public:
-  ObjectCache() : lru_size(0), lru_counter(0), lru_window(0), cct(NULL), enabled(false) { }
+  ObjectCache() : cct(NULL), enabled(false) {
+    shards.push_back(std::make_unique<Shard>());
+  }
   ~ObjectCache();
   int get(const DoutPrefixProvider *dpp, const std::string& name, ObjectCacheInfo& bl, uint32_t mask, rgw_cache_entry_info *cache_info);
   std::optional<ObjectCacheInfo> get(const DoutPrefixProvider *dpp, const std::string& name) {
@@ -187,12 +212,14 @@ public:
 
   template<typename F>
   void for_each(const F& f) {
-    std::shared_lock l{lock};
-    if (enabled) {
-      auto now  = ceph::coarse_mono_clock::now();
-      for (const auto& [name, entry] : cache_map) {
-        if (expiry.count() && (now - entry.info.time_added) < expiry) {
-          f(name, entry);
+    for (auto& shard : shards) {
+      std::shared_lock l{shard->lock};
+      if (enabled) {
+        auto now  = ceph::coarse_mono_clock::now();
+        for (const auto& [name, entry] : shard->cache_map) {
+          if (expiry.count() && (now - entry.info.time_added) < expiry) {
+            f(name, entry);
+          }
         }
       }
     }
@@ -200,12 +227,8 @@ public:
 
   void put(const DoutPrefixProvider *dpp, const std::string& name, ObjectCacheInfo& bl, rgw_cache_entry_info *cache_info);
   bool remove(const DoutPrefixProvider *dpp, const std::string& name);
-  void set_ctx(CephContext *_cct) {
-    cct = _cct;
-    lru_window = cct->_conf->rgw_cache_lru_size / 2;
-    expiry = std::chrono::seconds(cct->_conf.get_val<uint64_t>(
-						"rgw_cache_expiry_interval"));
-  }
+  // not safe to call once the cache is in use
+  void set_ctx(CephContext *_cct);
   bool chain_cache_entry(const DoutPrefixProvider *dpp,
                          std::initializer_list<rgw_cache_entry_info*> cache_info_entries,
 			 RGWChainedCache::Entry *chained_entry);
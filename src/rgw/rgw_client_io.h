@@ -146,6 +146,18 @@ public:
    * of response's body. On failure throws rgw::io::Exception. */
   virtual size_t send_body(const char* buf, size_t len) = 0;
 
+  /* Generate a part of response's body by taking all of @bl. The buffers
+   * of @bl are handed over as they are, without flattening them first.
+   * On success returns number of generated bytes of response's body.
+   * On failure throws rgw::io::Exception. */
+  virtual size_t send_body_bl(const ceph::bufferlist& bl) {
+    size_t sent = 0;
+    for (const auto& ptr : bl.buffers()) {
+      sent += send_body(ptr.c_str(), ptr.length());
+    }
+    return sent;
+  }
+
   /* Flushes all already generated data to a direct client of RadosGW.
    * On failure throws rgw::io::Exception containing errno. */
   virtual void flush() = 0;
@@ -240,6 +252,10 @@ public:
     return get_decoratee().send_body(buf, len);
   }
 
+  size_t send_body_bl(const ceph::bufferlist& bl) override {
+    return get_decoratee().send_body_bl(bl);
+  }
+
   void flush() override {
     return get_decoratee().flush();
   }
@@ -263,6 +279,17 @@ public:
   /* Send exactly @len bytes from the memory location pointed by @buf.
    * On success returns @len. On failure throws rgw::io::Exception. */
   virtual size_t write_data(const char *buf, size_t len) = 0;
+
+  /* Send all the buffers of @bl, ideally in a single gathering write.
+   * On success returns the length of @bl. On failure throws
+   * rgw::io::Exception. */
+  virtual size_t write_data_bl(const ceph::bufferlist& bl) {
+    size_t sent = 0;
+    for (const auto& ptr : bl.buffers()) {
+      sent += write_data(ptr.c_str(), ptr.length());
+    }
+    return sent;
+  }
 };
 
 /* Utility class providing RestfulClient's implementations with facilities
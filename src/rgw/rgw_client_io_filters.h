@@ -122,6 +122,17 @@ public:
     return sent;
   }
 
+  size_t send_body_bl(const ceph::bufferlist& bl) override {
+    const auto sent = DecoratedRestfulClient<T>::send_body_bl(bl);
+    lsubdout(cct, rgw, 30) << "AccountingFilter::send_body_bl: e="
+        << (enabled ? "1" : "0") << ", sent=" << sent << ", total="
+        << total_sent << dendl;
+    if (enabled) {
+      total_sent += sent;
+    }
+    return sent;
+  }
+
   size_t complete_request() override {
     const auto sent = DecoratedRestfulClient<T>::complete_request();
     lsubdout(cct, rgw, 30) << "AccountingFilter::complete_request: e="
@@ -173,6 +184,7 @@ public:
   size_t send_chunked_transfer_encoding() override;
   size_t complete_header() override;
   size_t send_body(const char* buf, size_t len) override;
+  size_t send_body_bl(const ceph::bufferlist& bl) override;
   size_t complete_request() override;
 };
 
@@ -191,6 +203,21 @@ size_t BufferingFilter<T>::send_body(const char* const buf,
   return DecoratedRestfulClient<T>::send_body(buf, len);
 }
 
+template <typename T>
+size_t BufferingFilter<T>::send_body_bl(const ceph::bufferlist& bl)
+{
+  if (buffer_data) {
+    /* Take references on the buffers instead of copying them. */
+    data.append(bl);
+
+    lsubdout(cct, rgw, 30) << "BufferingFilter<T>::send_body_bl: defer count = "
+        << bl.length() << dendl;
+    return 0;
+  }
+
+  return DecoratedRestfulClient<T>::send_body_bl(bl);
+}
+
 template <typename T>
 size_t BufferingFilter<T>::send_content_length(const uint64_t len)
 {
@@ -238,12 +265,9 @@ size_t BufferingFilter<T>::complete_request()
   }
 
   if (buffer_data) {
-    /* We are sending each buffer separately to avoid extra memory shuffling
+    /* We are sending the buffers as they are to avoid extra memory shuffling
      * that would occur on data.c_str() to provide a continuous memory area. */
-    for (const auto& ptr : data.buffers()) {
-      sent += DecoratedRestfulClient<T>::send_body(ptr.c_str(),
-                                                   ptr.length());
-    }
+    sent += DecoratedRestfulClient<T>::send_body_bl(data);
     data.clear();
     buffer_data = false;
     lsubdout(cct, rgw, 30) << "BufferingFilter::complete_request: buffer_data: sent="
@@ -267,6 +291,22 @@ class ChunkingFilter : public DecoratedRestfulClient<T> {
 protected:
   bool chunking_enabled;
 
+  size_t send_chunk_header(const size_t len) {
+    /* https://www.w3.org/Protocols/rfc2616/rfc2616-sec3.html#sec3.6.1 */
+    // TODO: we have no support for sending chunked-encoding
+    // extensions/trailing headers.
+    char chunk_size[32];
+    const auto chunk_size_len = snprintf(chunk_size, sizeof(chunk_size),
+                                         "%zx\r\n", len);
+    return DecoratedRestfulClient<T>::send_body(chunk_size, chunk_size_len);
+  }
+
+  size_t send_chunk_trailer() {
+    static constexpr char HEADER_END[] = "\r\n";
+    return DecoratedRestfulClient<T>::send_body(HEADER_END,
+                                                sizeof(HEADER_END) - 1);
+  }
+
 public:
   template <typename U>
   explicit ChunkingFilter(U&& decoratee)
@@ -285,19 +325,20 @@ public:
     if (! chunking_enabled) {
       return DecoratedRestfulClient<T>::send_body(buf, len);
     } else {
-      static constexpr char HEADER_END[] = "\r\n";
-      /* https://www.w3.org/Protocols/rfc2616/rfc2616-sec3.html#sec3.6.1 */
-      // TODO: we have no support for sending chunked-encoding
-      // extensions/trailing headers.
-      char chunk_size[32];
-      const auto chunk_size_len = snprintf(chunk_size, sizeof(chunk_size),
-                                           "%zx\r\n", len);
-      size_t sent = 0;
-
-      sent += DecoratedRestfulClient<T>::send_body(chunk_size, chunk_size_len);
+      size_t sent = send_chunk_header(len);
       sent += DecoratedRestfulClient<T>::send_body(buf, len);
-      sent += DecoratedRestfulClient<T>::send_body(HEADER_END,
-                                                   sizeof(HEADER_END) - 1);
+      sent += send_chunk_trailer();
+      return sent;
+    }
+  }
+
+  size_t send_body_bl(const ceph::bufferlist& bl) override {
+    if (! chunking_enabled) {
+      return DecoratedRestfulClient<T>::send_body_bl(bl);
+    } else {
+      size_t sent = send_chunk_header(bl.length());
+      sent += DecoratedRestfulClient<T>::send_body_bl(bl);
+      sent += send_chunk_trailer();
       return sent;
     }
   }
@@ -675,7 +675,8 @@ int RGWAsyncFetchRemoteObj::_send_request(const DoutPrefixProvider *dpp)
                        dpp,
                        filter.get(),
                        &zones_trace,
-                       &bytes_transferred);
+                       &bytes_transferred,
+                       prefetched.get());
 
   if (r < 0) {
     ldpp_dout(dpp, 0) << "store->fetch_remote_obj() returned r=" << r << dendl;
@@ -17,6 +17,8 @@
 #include "services/svc_sys_obj.h"
 #include "services/svc_bucket.h"
 
+struct rgw_sync_fetched_obj;
+
 #define dout_subsys ceph_subsys_rgw
 
 class RGWAsyncRadosRequest : public RefCountedObject {
@@ -945,6 +947,7 @@ class RGWAsyncFetchRemoteObj : public RGWAsyncRadosRequest {
   rgw_zone_set zones_trace;
   PerfCounters* counters;
   const DoutPrefixProvider *dpp;
+  std::shared_ptr<const rgw_sync_fetched_obj> prefetched;
 
 protected:
   int _send_request(const DoutPrefixProvider *dpp) override;
@@ -961,7 +964,8 @@ public:
                          bool _if_newer,
                          std::shared_ptr<RGWFetchObjFilter> _filter,
                          rgw_zone_set *_zones_trace,
-                         PerfCounters* counters, const DoutPrefixProvider *dpp)
+                         PerfCounters* counters, const DoutPrefixProvider *dpp,
+                         std::shared_ptr<const rgw_sync_fetched_obj> _prefetched = nullptr)
     : RGWAsyncRadosRequest(caller, cn), store(_store),
       source_zone(_source_zone),
       user_id(_user_id),
@@ -974,7 +978,8 @@ public:
       copy_if_newer(_if_newer),
       filter(_filter),
       counters(counters),
-      dpp(dpp)
+      dpp(dpp),
+      prefetched(std::move(_prefetched))
   {
     if (_zones_trace) {
       zones_trace = *_zones_trace;
@@ -1008,6 +1013,7 @@ class RGWFetchRemoteObjCR : public RGWSimpleCoroutine {
   rgw_zone_set *zones_trace;
   PerfCounters* counters;
   const DoutPrefixProvider *dpp;
+  std::shared_ptr<const rgw_sync_fetched_obj> prefetched;
 
 public:
   RGWFetchRemoteObjCR(RGWAsyncRadosProcessor *_async_rados, rgw::sal::RadosStore* _store,
@@ -1022,7 +1028,8 @@ public:
                       bool _if_newer,
                       std::shared_ptr<RGWFetchObjFilter> _filter,
                       rgw_zone_set *_zones_trace,
-                      PerfCounters* counters, const DoutPrefixProvider *dpp)
+                      PerfCounters* counters, const DoutPrefixProvider *dpp,
+                      std::shared_ptr<const rgw_sync_fetched_obj> _prefetched = nullptr)
     : RGWSimpleCoroutine(_store->ctx()), cct(_store->ctx()),
       async_rados(_async_rados), store(_store),
       source_zone(_source_zone),
@@ -1036,7 +1043,8 @@ public:
       copy_if_newer(_if_newer),
       filter(_filter),
       req(NULL),
-      zones_trace(_zones_trace), counters(counters), dpp(dpp) {}
+      zones_trace(_zones_trace), counters(counters), dpp(dpp),
+      prefetched(std::move(_prefetched)) {}
 
 
   ~RGWFetchRemoteObjCR() override {
@@ -1054,7 +1062,7 @@ public:
     req = new RGWAsyncFetchRemoteObj(this, stack->create_completion_notifier(), store,
 				     source_zone, user_id, src_bucket, dest_placement_rule, dest_bucket_info,
                                      key, dest_key, versioned_epoch, copy_if_newer, filter,
-                                     zones_trace, counters, dpp);
+                                     zones_trace, counters, dpp, prefetched);
     async_rados->queue(req);
     return 0;
   }
@@ -1964,6 +1964,9 @@ class RGWDefaultDataSyncModule : public RGWDataSyncModule {
 public:
   RGWDefaultDataSyncModule() {}
 
+  bool fetches_objects() override {
+    return true;
+  }
   RGWCoroutine *sync_object(RGWDataSyncCtx *sc, rgw_bucket_sync_pipe& sync_pipe, rgw_obj_key& key, std::optional<uint64_t> versioned_epoch, rgw_zone_set *zones_trace) override;
   RGWCoroutine *remove_object(RGWDataSyncCtx *sc, rgw_bucket_sync_pipe& sync_pipe, rgw_obj_key& key, real_time& mtime, bool versioned, uint64_t versioned_epoch, rgw_zone_set *zones_trace) override;
   RGWCoroutine *create_delete_marker(RGWDataSyncCtx *sc, rgw_bucket_sync_pipe& sync_pipe, rgw_obj_key& key, real_time& mtime,
@@ -2423,6 +2426,12 @@ public:
                                                             source_bucket_perms,
                                                             std::move(dest_params),
                                                             need_retry);
+          std::shared_ptr<const rgw_sync_fetched_obj> prefetched;
+          if (auto p = sync_pipe.prefetched.find(key);
+              p != sync_pipe.prefetched.end()) {
+            prefetched = std::move(p->second);
+            sync_pipe.prefetched.erase(p);
+          }
 
           call(new RGWFetchRemoteObjCR(sync_env->async_rados, sync_env->store, sc->source_zone,
                                        nullopt,
@@ -2431,7 +2440,8 @@ public:
                                        key, dest_key, versioned_epoch,
                                        true,
                                        std::static_pointer_cast<RGWFetchObjFilter>(filter),
-                                       zones_trace, sync_env->counters, dpp));
+                                       zones_trace, sync_env->counters, dpp,
+                                       std::move(prefetched)));
         }
         if (retcode < 0) {
           if (*need_retry) {
@@ -3333,6 +3343,58 @@ public:
   }
 };
 
+/*
+ * reads small objects of a bucket shard from the source zone, many in a
+ * single request, for the fetches of their sync to find them in
+ * @prefetched
+ */
+class RGWFetchBucketObjsCR : public RGWCoroutine {
+  RGWDataSyncCtx *sc;
+  RGWDataSyncEnv *sync_env;
+  const string instance_key;
+  const string max_size;
+  std::vector<rgw_obj_key> keys;
+  std::map<rgw_obj_key, std::shared_ptr<rgw_sync_fetched_obj>> *prefetched;
+  std::vector<rgw_sync_fetched_obj> result;
+
+public:
+  RGWFetchBucketObjsCR(RGWDataSyncCtx *_sc, const rgw_bucket_shard& bs,
+                       uint64_t max_size, std::vector<rgw_obj_key>&& keys,
+                       std::map<rgw_obj_key, std::shared_ptr<rgw_sync_fetched_obj>> *prefetched)
+    : RGWCoroutine(_sc->cct), sc(_sc), sync_env(_sc->env),
+      instance_key(bs.get_key()), max_size(std::to_string(max_size)),
+      keys(std::move(keys)), prefetched(prefetched) {}
+
+  int operate(const DoutPrefixProvider *dpp) override {
+    reenter(this) {
+      yield {
+        rgw_http_param_pair pairs[] = { { "bucket-instance", instance_key.c_str() },
+                                        { "fetch", nullptr },
+                                        { "format" , "json" },
+                                        { "max-size", max_size.c_str() },
+                                        { "type", "bucket-index" },
+                                        { NULL, NULL } };
+
+        call(new RGWPostRESTResourceCR<std::vector<rgw_obj_key>, std::vector<rgw_sync_fetched_obj>>(
+               sync_env->cct, sc->conn, sync_env->http_manager, "/admin/log", pairs,
+               keys, &result));
+      }
+      if (retcode < 0) {
+        return set_cr_error(retcode);
+      }
+      for (auto& o : result) {
+        if (o.status < 0) {
+          continue;
+        }
+        auto key = o.key;
+        (*prefetched)[key] = std::make_shared<rgw_sync_fetched_obj>(std::move(o));
+      }
+      return set_cr_done();
+    }
+    return 0;
+  }
+};
+
 #define BUCKET_SYNC_UPDATE_MARKER_WINDOW 10
 
 class RGWBucketFullSyncShardMarkerTrack : public RGWSyncShardMarkerTrack<rgw_obj_key, rgw_obj_key> {
@@ -3890,6 +3952,12 @@ class RGWBucketShardIncrementalSyncCR : public RGWCoroutine {
   RGWSyncTraceNodeRef tn;
   RGWBucketIncSyncShardMarkerTrack marker_tracker;
 
+  bool prefetch_enabled{false};
+  uint64_t prefetch_max_entries;
+  uint64_t prefetch_max_size;
+  list<rgw_bi_log_entry>::iterator prefetch_iter; // the next entry to consider
+  std::vector<rgw_obj_key> prefetch_keys;
+
 public:
   RGWBucketShardIncrementalSyncCR(RGWDataSyncCtx *_sc,
                                   rgw_bucket_sync_pipe& _sync_pipe,
@@ -3913,6 +3981,10 @@ public:
     set_status("init");
     rules = sync_pipe.get_rules();
     target_location_key = sync_pipe.info.dest_bs.bucket.get_key();
+    prefetch_max_entries = cct->_conf.get_val<uint64_t>("rgw_sync_fetch_batch_max_entries");
+    prefetch_max_size = cct->_conf.get_val<Option::size_t>("rgw_sync_fetch_batch_obj_max_size");
+    prefetch_enabled = prefetch_max_entries > 0 &&
+      sync_env->sync_module->get_data_handler()->fetches_objects();
   }
 
   bool check_key_handled(const rgw_obj_key& key) {
@@ -3926,6 +3998,37 @@ public:
     return boost::starts_with(key.name, iter->first);
   }
 
+  /* the objects the next entries will fetch, up to a batch of them */
+  std::vector<rgw_obj_key> next_prefetch_keys() {
+    std::vector<rgw_obj_key> keys;
+    std::set<rgw_obj_key> seen;
+    for (; prefetch_iter != entries_end && keys.size() < prefetch_max_entries;
+         ++prefetch_iter) {
+      auto& e = *prefetch_iter;
+      if (e.op != CLS_RGW_OP_ADD && e.op != CLS_RGW_OP_LINK_OLH) {
+        continue;
+      }
+      if (e.state != CLS_RGW_STATE_COMPLETE ||
+          e.zones_trace.exists(zone_id.id, target_location_key)) {
+        continue;
+      }
+      auto squash_entry = squash_map.find(make_pair(e.object, e.instance));
+      if (squash_entry == squash_map.end() ||
+          squash_entry->second != make_pair(e.timestamp, e.op)) {
+        continue;
+      }
+      rgw_obj_key k;
+      if (!k.set(rgw_obj_index_key{e.object, e.instance}) ||
+          !k.ns.empty() || !check_key_handled(k)) {
+        continue;
+      }
+      if (seen.insert(k).second) {
+        keys.push_back(std::move(k));
+      }
+    }
+    return keys;
+  }
+
   int operate(const DoutPrefixProvider *dpp) override;
 };
 
@@ -3981,12 +4084,29 @@ int RGWBucketShardIncrementalSyncCR::operate(const DoutPrefixProvider *dpp)
         }
       }
 
+      sync_pipe.prefetched.clear();
+      prefetch_iter = list_result.begin();
       entries_iter = list_result.begin();
       for (; entries_iter != entries_end; ++entries_iter) {
         if (lease_cr && !lease_cr->is_locked()) {
           drain_all();
           return set_cr_error(-ECANCELED);
         }
+        if (prefetch_enabled && entries_iter == prefetch_iter) {
+          prefetch_keys = next_prefetch_keys();
+          if (!prefetch_keys.empty()) {
+            tn->log(20, SSTR("fetching " << prefetch_keys.size() << " objects ahead"));
+            yield call(new RGWFetchBucketObjsCR(sc, bs, prefetch_max_size,
+                                                std::move(prefetch_keys),
+                                                &sync_pipe.prefetched));
+            if (retcode < 0) {
+              /* e.g., a source zone that does not serve them; fetch them
+               * one at a time from now on */
+              tn->log(5, SSTR("failed to fetch objects ahead, retcode=" << retcode));
+              prefetch_enabled = false;
+            }
+          }
+        }
         entry = &(*entries_iter);
         {
           ssize_t p = entry->id.find('#'); /* entries might have explicit shard info in them, e.g., 6#00000000004.94.3 */
@@ -62,12 +62,32 @@ inline ostream& operator<<(ostream& out, const rgw_bucket_sync_pair_info& p) {
   return out;
 }
 
+/*
+ * an object read from the source zone ahead of its sync, by a request for
+ * many small objects at once, with what a fetch of it alone would get
+ */
+struct rgw_sync_fetched_obj {
+  rgw_obj_key key;
+  int status{0}; // or why the object is left to a fetch of its own
+  ceph::real_time mtime;
+  uint32_t zone_short_id{0};
+  uint64_t pg_ver{0};
+  std::string etag;
+  bufferlist meta; // embedded ahead of the data by a fetch
+  bufferlist data;
+
+  void dump(Formatter *f) const;
+  void decode_json(JSONObj *obj);
+};
+
 struct rgw_bucket_sync_pipe {
   rgw_bucket_sync_pair_info info;
   RGWBucketInfo source_bucket_info;
   map<string, bufferlist> source_bucket_attrs;
   RGWBucketInfo dest_bucket_info;
   map<string, bufferlist> dest_bucket_attrs;
+  /* objects fetched ahead by the incremental sync of the shard */
+  std::map<rgw_obj_key, std::shared_ptr<rgw_sync_fetched_obj>> prefetched;
 
   RGWBucketSyncFlowManager::pipe_rules_ref& get_rules() {
     return info.handler.rules;
@@ -0,0 +1,195 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab ft=cpp
+
+#include "rgw_datacache.h"
+
+#include <system_error>
+#if __has_include(<filesystem>)
+#include <filesystem>
+namespace fs = std::filesystem;
+#else
+#include <experimental/filesystem>
+namespace fs = std::experimental::filesystem;
+#endif
+
+#include "common/Thread.h"
+#include "common/ceph_context.h"
+#include "common/dout.h"
+#include "common/errno.h"
+#include "rgw_perf_counters.h"
+
+#define dout_subsys ceph_subsys_rgw
+#undef dout_prefix
+#define dout_prefix *_dout << "rgw datacache: "
+
+RGWDataCache::RGWDataCache(CephContext *cct)
+  : cct(cct),
+    path(cct->_conf.get_val<std::string>("rgw_datacache_path") + "/" +
+	 cct->_conf->name.to_str()),
+    max_size(cct->_conf.get_val<Option::size_t>("rgw_datacache_size")),
+    max_pending(cct->_conf.get_val<Option::size_t>("rgw_datacache_max_pending"))
+{}
+
+RGWDataCache::~RGWDataCache()
+{
+  stop();
+}
+
+int RGWDataCache::start()
+{
+  std::error_code ec;
+  fs::create_directories(path, ec);
+  if (ec) {
+    lderr(cct) << "failed to create " << path << ": " << ec.message() << dendl;
+    return -ec.value();
+  }
+  // what is left there belongs to a previous run, and is not indexed
+  for (auto& f : fs::directory_iterator(path, ec)) {
+    fs::remove_all(f.path(), ec);
+  }
+  if (ec) {
+    lderr(cct) << "failed to clean up " << path << ": " << ec.message() << dendl;
+    return -ec.value();
+  }
+  writer = make_named_thread("rgw_datacache", &RGWDataCache::write_pending, this);
+  ldout(cct, 1) << "caching up to " << max_size << " bytes in " << path << dendl;
+  return 0;
+}
+
+void RGWDataCache::stop()
+{
+  {
+    std::lock_guard l{lock};
+    stopping = true;
+  }
+  cond.notify_all();
+  if (writer.joinable()) {
+    writer.join();
+  }
+}
+
+std::string RGWDataCache::make_key(const std::string& pool,
+				   const std::string& oid,
+				   const std::string& tag,
+				   uint64_t ofs, uint64_t len)
+{
+  std::string key = pool;
+  key.push_back('\0');
+  key.append(oid);
+  key.push_back('\0');
+  key.append(tag);
+  key.push_back('\0');
+  key.append(std::to_string(ofs));
+  key.push_back('\0');
+  key.append(std::to_string(len));
+  return key;
+}
+
+std::string RGWDataCache::file_path(uint64_t id) const
+{
+  return path + "/" + std::to_string(id);
+}
+
+bool RGWDataCache::get(const std::string& key, ceph::bufferlist *bl)
+{
+  uint64_t id, expected;
+  {
+    std::lock_guard l{lock};
+    auto p = entries.find(key);
+    if (p == entries.end()) {
+      if (perfcounter) {
+	perfcounter->inc(l_rgw_datacache_miss);
+      }
+      return false;
+    }
+    lru.splice(lru.end(), lru, p->second.lru_iter);
+    id = p->second.id;
+    expected = p->second.size;
+  }
+  // an eviction racing with us unlinks the file, which is a miss
+  std::string err;
+  ceph::bufferlist data;
+  int r = data.read_file(file_path(id).c_str(), &err);
+  if (r < 0 || data.length() != expected) {
+    ldout(cct, 5) << "failed to read " << file_path(id) << ": " << err << dendl;
+    if (perfcounter) {
+      perfcounter->inc(l_rgw_datacache_miss);
+    }
+    return false;
+  }
+  if (perfcounter) {
+    perfcounter->inc(l_rgw_datacache_hit);
+  }
+  bl->claim_append(data);
+  return true;
+}
+
+void RGWDataCache::put(const std::string& key, const ceph::bufferlist& bl)
+{
+  if (bl.length() == 0 || bl.length() > max_size) {
+    return;
+  }
+  std::lock_guard l{lock};
+  if (stopping || entries.count(key) ||
+      pending_size + bl.length() > max_pending) {
+    return;
+  }
+  pending.emplace_back(key, bl);
+  pending_size += bl.length();
+  cond.notify_one();
+}
+
+void RGWDataCache::_evict(uint64_t want)
+{
+  while (!lru.empty() && size + want > max_size) {
+    auto p = entries.find(lru.front());
+    lru.pop_front();
+    if (p == entries.end()) {
+      continue;
+    }
+    std::error_code ec;
+    fs::remove(file_path(p->second.id), ec);
+    size -= p->second.size;
+    entries.erase(p);
+  }
+}
+
+void RGWDataCache::write_pending()
+{
+  std::unique_lock l{lock};
+  while (!stopping) {
+    if (pending.empty()) {
+      cond.wait(l);
+      continue;
+    }
+    auto [key, bl] = std::move(pending.front());
+    pending.pop_front();
+    pending_size -= bl.length();
+    if (entries.count(key)) {
+      continue;
+    }
+    uint64_t id = next_id++;
+    l.unlock();
+
+    // written in full before it is indexed, so get() never sees a part
+    int r = bl.write_file(file_path(id).c_str(), 0600);
+
+    l.lock();
+    if (r < 0) {
+      ldout(cct, 1) << "failed to write " << file_path(id) << ": "
+		    << cpp_strerror(r) << dendl;
+      std::error_code ec;
+      fs::remove(file_path(id), ec);
+      continue;
+    }
+    if (entries.count(key)) {
+      std::error_code ec;
+      fs::remove(file_path(id), ec);
+      continue;
+    }
+    _evict(bl.length());
+    lru.push_back(key);
+    entries[key] = entry_t{id, bl.length(), std::prev(lru.end())};
+    size += bl.length();
+  }
+}
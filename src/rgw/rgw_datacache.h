@@ -0,0 +1,75 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab ft=cpp
+
+#pragma once
+
+#include <list>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+#include "include/buffer.h"
+#include "include/common_fwd.h"
+#include "common/ceph_mutex.h"
+
+/*
+ * A cache of object data on a local disk of the gateway.
+ *
+ * The reads of tail rados objects are kept in files under a directory of
+ * rgw_datacache_path named after the daemon, keyed by the tail object,
+ * the tag of the object they belong to and the range read.  Tail
+ * objects are only written
+ * once, under a prefix chosen for each upload, and the tag changes with
+ * every write of the object, so a cached range never goes stale: an
+ * overwritten object reads other keys, and the old ones age out.
+ *
+ * The files are written by a thread of their own, so a miss does not
+ * wait for the disk; fills are dropped when more than
+ * rgw_datacache_max_pending bytes are waiting.  The least recently read
+ * files are removed once they take more than rgw_datacache_size bytes.
+ * Whatever is in the directory at startup is removed.
+ */
+class RGWDataCache {
+public:
+  explicit RGWDataCache(CephContext *cct);
+  ~RGWDataCache();
+
+  int start();
+  void stop();
+
+  static std::string make_key(const std::string& pool, const std::string& oid,
+			      const std::string& tag, uint64_t ofs, uint64_t len);
+
+  /// read the range cached under @p key into @p bl
+  bool get(const std::string& key, ceph::bufferlist *bl);
+  /// cache @p bl under @p key, once written in the background
+  void put(const std::string& key, const ceph::bufferlist& bl);
+
+private:
+  struct entry_t {
+    uint64_t id;
+    uint64_t size;
+    std::list<std::string>::iterator lru_iter;
+  };
+
+  CephContext *cct;
+  const std::string path;
+  const uint64_t max_size;
+  const uint64_t max_pending;
+
+  ceph::mutex lock = ceph::make_mutex("RGWDataCache::lock");
+  std::unordered_map<std::string, entry_t> entries;
+  std::list<std::string> lru;  ///< the least recently read first
+  uint64_t size = 0;
+  uint64_t next_id = 0;
+
+  ceph::condition_variable cond;
+  std::list<std::pair<std::string, ceph::bufferlist>> pending;
+  uint64_t pending_size = 0;
+  bool stopping = false;
+  std::thread writer;
+
+  std::string file_path(uint64_t id) const;
+  void write_pending();
+  void _evict(uint64_t want);
+};
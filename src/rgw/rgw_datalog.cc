@@ -1,6 +1,7 @@
 // -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
 // vim: ts=8 sw=2 smarttab ft=cpp
 
+#include <thread>
 #include <vector>
 
 #include "common/debug.h"
@@ -385,7 +386,8 @@ RGWDataChangesLog::RGWDataChangesLog(CephContext* cct)
   : cct(cct),
     num_shards(cct->_conf->rgw_data_log_num_shards),
     prefix(get_prefix()),
-    changes(cct->_conf->rgw_data_log_changes_size) {}
+    changes(cct->_conf->rgw_data_log_changes_size),
+    pushers(std::make_unique<ShardPusher[]>(num_shards)) {}
 
 bs::error_code DataLogBackends::handle_init(entries_t e) noexcept {
   std::unique_lock l(m);
@@ -677,8 +679,7 @@ int RGWDataChangesLog::add_entry(const DoutPrefixProvider *dpp, const RGWBucketI
 
     ldpp_dout(dpp, 20) << "RGWDataChangesLog::add_entry() sending update with now=" << now << " cur_expiration=" << expiration << dendl;
 
-    auto be = bes->head();
-    ret = be->push(dpp, index, now, change.key, std::move(bl));
+    ret = push_change(dpp, index, now, change.key, std::move(bl));
 
     now = real_clock::now();
 
@@ -701,6 +702,61 @@ int RGWDataChangesLog::add_entry(const DoutPrefixProvider *dpp, const RGWBucketI
   return ret;
 }
 
+int RGWDataChangesLog::push_change(const DoutPrefixProvider *dpp, int index,
+				   ceph::real_time now, const std::string& key,
+				   ceph::buffer::list&& bl)
+{
+  auto& p = pushers[index];
+  std::unique_lock l(p.lock);
+  if (!p.next) {
+    p.next = std::make_shared<PushBatch>();
+  }
+  auto batch = p.next;
+  batch->changes.push_back({now, key, std::move(bl)});
+  while (p.pushing && !batch->done) {
+    p.cond.wait(l);
+  }
+  if (batch->done) {
+    return batch->r;
+  }
+
+  // nobody pushes the batch we are in, so it is ours to send
+  p.pushing = true;
+  const auto window = cct->_conf.get_val<std::chrono::milliseconds>(
+    "rgw_data_log_push_window");
+  if (window.count() > 0) {
+    l.unlock();
+    std::this_thread::sleep_for(window);
+    l.lock();
+  }
+  p.next.reset();
+  l.unlock();
+
+  ldpp_dout(dpp, 20) << "RGWDataChangesLog::push_change() pushing "
+		     << batch->changes.size() << " entries to shard " << index
+		     << dendl;
+  auto be = bes->head();
+  int r;
+  if (batch->changes.size() == 1) {
+    auto& c = batch->changes.front();
+    r = be->push(dpp, index, c.now, c.key, std::move(c.bl));
+  } else {
+    RGWDataChangesBE::entries items;
+    for (auto& c : batch->changes) {
+      be->prepare(c.now, c.key, std::move(c.bl), items);
+    }
+    r = be->push(dpp, index, std::move(items));
+  }
+
+  l.lock();
+  batch->r = r;
+  batch->done = true;
+  p.pushing = false;
+  l.unlock();
+  p.cond.notify_all();
+  return r;
+}
+
 int DataLogBackends::list(const DoutPrefixProvider *dpp, int shard, int max_entries,
 			  std::vector<rgw_data_change_log_entry>& entries,
 			  std::optional<std::string_view> marker,
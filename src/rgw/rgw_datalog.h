@@ -202,6 +202,30 @@ class RGWDataChangesLog {
 
   lru_map<rgw_bucket_shard, ChangeStatusPtr> changes;
 
+  /* the changes to a log shard that arrive while a push to it is in
+   * flight go out together in the next one */
+  struct PushBatch {
+    struct change_t {
+      ceph::real_time now;
+      std::string key;
+      ceph::buffer::list bl;
+    };
+    std::vector<change_t> changes;
+    bool done = false;
+    int r = 0;
+  };
+  struct ShardPusher {
+    ceph::mutex lock = ceph::make_mutex("RGWDataChangesLog::ShardPusher");
+    ceph::condition_variable cond;
+    std::shared_ptr<PushBatch> next;
+    bool pushing = false;
+  };
+  std::unique_ptr<ShardPusher[]> pushers;
+
+  int push_change(const DoutPrefixProvider *dpp, int index,
+		  ceph::real_time now, const std::string& key,
+		  ceph::buffer::list&& bl);
+
   bc::flat_set<rgw_bucket_shard> cur_cycle;
 
   void _get_change(const rgw_bucket_shard& bs, ChangeStatusPtr& status);
@@ -16,6 +16,9 @@
 
 #ifndef RGW_DMCLOCK_H
 #define RGW_DMCLOCK_H
+#include <ostream>
+#include <string>
+#include <tuple>
 #include "dmclock/src/dmclock_server.h"
 
 namespace rgw::dmclock {
@@ -28,6 +31,32 @@ enum class client_id {
                       count
 };
 
+/// a client of the scheduler: the class of the request and, with
+/// rgw_dmclock_per_user, the user it comes from.  The user is empty for
+/// the requests scheduled by class only
+struct client_key_t {
+  client_id type;
+  std::string user;
+
+  client_key_t(client_id type) : type(type) {}
+  client_key_t(client_id type, std::string user)
+    : type(type), user(std::move(user)) {}
+
+  friend bool operator==(const client_key_t& l, const client_key_t& r) {
+    return l.type == r.type && l.user == r.user;
+  }
+  friend bool operator<(const client_key_t& l, const client_key_t& r) {
+    return std::tie(l.type, l.user) < std::tie(r.type, r.user);
+  }
+  friend std::ostream& operator<<(std::ostream& out, const client_key_t& c) {
+    out << static_cast<int>(c.type);
+    if (!c.user.empty()) {
+      out << "/" << c.user;
+    }
+    return out;
+  }
+};
+
 // TODO move these to dmclock/types or so in submodule
 using crimson::dmclock::Cost;
 using crimson::dmclock::ClientInfo;
@@ -38,7 +38,7 @@ void AsyncScheduler::handle_conf_change(const ConfigProxy& conf,
   schedule(crimson::dmclock::TimeZero);
 }
 
-int AsyncScheduler::schedule_request_impl(const client_id& client,
+int AsyncScheduler::schedule_request_impl(const client_key_t& client,
                                           const ReqParams& params,
                                           const Time& time, const Cost& cost,
                                           optional_yield yield_ctx)
@@ -89,7 +89,7 @@ void AsyncScheduler::cancel()
   }
 }
 
-void AsyncScheduler::cancel(const client_id& client)
+void AsyncScheduler::cancel(const client_key_t& client)
 {
   ClientSum sum;
 
@@ -101,7 +101,7 @@ void AsyncScheduler::cancel(const client_id& client)
                            boost::asio::error::operation_aborted,
                            PhaseType::priority);
     });
-  if (auto c = counters(client)) {
+  if (auto c = counters(client.type)) {
     on_cancel(c, sum);
   }
   schedule(crimson::dmclock::TimeZero);
@@ -147,7 +147,7 @@ void AsyncScheduler::process(const Time& now)
 
     // complete the request
     auto& r = pull.get_retn();
-    auto client = r.client;
+    auto client = r.client.type;
     auto phase = r.phase;
     auto started = r.request->started;
     auto cost = r.request->cost;
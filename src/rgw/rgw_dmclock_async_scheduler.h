@@ -50,7 +50,7 @@ class AsyncScheduler : public md_config_obs_t, public Scheduler {
   /// is ready or canceled. on success, this grants a throttle unit that must
   /// be returned with a call to request_complete()
   template <typename CompletionToken>
-  auto async_request(const client_id& client, const ReqParams& params,
+  auto async_request(const client_key_t& client, const ReqParams& params,
                      const Time& time, Cost cost, CompletionToken&& token);
 
   /// returns a throttle unit granted by async_request()
@@ -62,19 +62,22 @@ class AsyncScheduler : public md_config_obs_t, public Scheduler {
 
   /// cancel all queued requests for a given client, invoking their completion
   /// handler with an operation_aborted error and default-constructed result
-  void cancel(const client_id& client);
+  void cancel(const client_key_t& client);
 
   const char** get_tracked_conf_keys() const override;
   void handle_conf_change(const ConfigProxy& conf,
                           const std::set<std::string>& changed) override;
 
  private:
-  int schedule_request_impl(const client_id& client, const ReqParams& params,
+  int schedule_request_impl(const client_key_t& client, const ReqParams& params,
                             const Time& time, const Cost& cost,
                             optional_yield yield_ctx) override;
 
   static constexpr bool IsDelayed = false;
-  using Queue = crimson::dmclock::PullPriorityQueue<client_id, Request, IsDelayed>;
+  // the queue creates the record of a client with its first request and
+  // drops it once idle, and keeps the clients in heaps: it takes as many
+  // users as there are with logarithmic costs
+  using Queue = crimson::dmclock::PullPriorityQueue<client_key_t, Request, IsDelayed>;
   using RequestRef = typename Queue::RequestRef;
   Queue queue; //< dmclock priority queue
 
@@ -120,7 +123,7 @@ AsyncScheduler::AsyncScheduler(CephContext *cct, boost::asio::io_context& contex
 }
 
 template <typename CompletionToken>
-auto AsyncScheduler::async_request(const client_id& client,
+auto AsyncScheduler::async_request(const client_key_t& client,
                               const ReqParams& params,
                               const Time& time, Cost cost,
                               CompletionToken&& token)
@@ -132,14 +135,14 @@ auto AsyncScheduler::async_request(const client_id& client,
 
   // allocate the Request and add it to the queue
   auto completion = Completion::create(ex1, std::move(handler),
-                                       Request{client, time, cost});
+                                       Request{client.type, time, cost});
   // cast to unique_ptr<Request>
   auto req = RequestRef{std::move(completion)};
   int r = queue.add_request(std::move(req), client, params, time, cost);
   if (r == 0) {
     // schedule an immediate call to process() on the executor
     schedule(crimson::dmclock::TimeZero);
-    if (auto c = counters(client)) {
+    if (auto c = counters(client.type)) {
       c->inc(queue_counters::l_qlen);
       c->inc(queue_counters::l_cost, cost);
     }
@@ -150,7 +153,7 @@ auto AsyncScheduler::async_request(const client_id& client,
     auto completion = static_cast<Completion*>(req.release());
     async::post(std::unique_ptr<Completion>{completion},
                 ec, PhaseType::priority);
-    if (auto c = counters(client)) {
+    if (auto c = counters(client.type)) {
       c->inc(queue_counters::l_limit);
       c->inc(queue_counters::l_limit_cost, cost);
     }
@@ -195,7 +198,7 @@ public:
   }
 
 private:
-  int schedule_request_impl(const client_id&, const ReqParams&,
+  int schedule_request_impl(const client_key_t&, const ReqParams&,
                             const Time&, const Cost&,
                             optional_yield) override {
     if (outstanding_requests++ >= max_requests) {
@@ -25,6 +25,14 @@ ClientInfo* ClientConfig::operator()(client_id client)
   return &clients[static_cast<size_t>(client)];
 }
 
+ClientInfo* ClientConfig::operator()(const client_key_t& client)
+{
+  if (client.user.empty()) {
+    return (*this)(client.type);
+  }
+  return &user;
+}
+
 const char** ClientConfig::get_tracked_conf_keys() const
 {
   static const char* keys[] = {
@@ -40,6 +48,9 @@ const char** ClientConfig::get_tracked_conf_keys() const
     "rgw_dmclock_metadata_res",
     "rgw_dmclock_metadata_wgt",
     "rgw_dmclock_metadata_lim",
+    "rgw_dmclock_user_res",
+    "rgw_dmclock_user_wgt",
+    "rgw_dmclock_user_lim",
     "rgw_max_concurrent_requests",
     nullptr
   };
@@ -65,6 +76,10 @@ void ClientConfig::update(const ConfigProxy& conf)
   clients.emplace_back(conf.get_val<double>("rgw_dmclock_metadata_res"),
                        conf.get_val<double>("rgw_dmclock_metadata_wgt"),
                        conf.get_val<double>("rgw_dmclock_metadata_lim"));
+  // assigned in place, the queue keeps pointers to it
+  user = ClientInfo(conf.get_val<double>("rgw_dmclock_user_res"),
+                    conf.get_val<double>("rgw_dmclock_user_wgt"),
+                    conf.get_val<double>("rgw_dmclock_user_lim"));
 }
 
 void ClientConfig::handle_conf_change(const ConfigProxy& conf,
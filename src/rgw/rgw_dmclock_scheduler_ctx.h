@@ -85,6 +85,7 @@ void on_process(PerfCounters* c, const ClientSum& rsum, const ClientSum& psum);
 
 class ClientConfig : public md_config_obs_t {
   std::vector<ClientInfo> clients;
+  ClientInfo user{0, 1, 0}; //< shared by the clients of every user
 
   void update(const ConfigProxy &conf);
 
@@ -92,6 +93,7 @@ public:
   ClientConfig(CephContext *cct);
 
   ClientInfo* operator()(client_id client);
+  ClientInfo* operator()(const client_key_t& client);
 
   const char** get_tracked_conf_keys() const override;
   void handle_conf_change(const ConfigProxy& conf,
@@ -52,11 +52,12 @@ public:
   static void handle_request_cb(const client_id& c, std::unique_ptr<SyncRequest> req,
 				PhaseType phase, Cost cost);
 private:
-  int schedule_request_impl(const client_id& client, const ReqParams& params,
+  // scheduled by class only
+  int schedule_request_impl(const client_key_t& client, const ReqParams& params,
 			    const Time& time, const Cost& cost,
 			    optional_yield _y [[maybe_unused]]) override
   {
-    return add_request(client, params, time, cost);
+    return add_request(client.type, params, time, cost);
   }
 
   static constexpr bool IsDelayed = false;
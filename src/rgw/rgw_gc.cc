@@ -374,6 +374,10 @@ public:
       goto done;
     }
 
+    if (perfcounter) {
+      perfcounter->inc(l_rgw_gc_tail_remove);
+    }
+
     if (! gc->transitioned_objects_cache[io.index]) {
       schedule_tag_removal(io.index, io.tag);
     }
@@ -527,6 +531,11 @@ int RGWGC::process(int index, int max_secs, bool expired_only,
   string next_marker;
   bool truncated;
   IoCtx *ctx = new IoCtx;
+  /* queue entries whose tail deletions were all scheduled, trimmed once
+   * there are trim_batch of them, so the deletions of the next pages need
+   * not wait for those of the previous ones */
+  const uint64_t trim_batch = cct->_conf.get_val<uint64_t>("rgw_gc_queue_trim_batch");
+  uint64_t pending_trim = 0;
   do {
     int max = 100;
     std::list<cls_rgw_gc_obj_info> entries;
@@ -646,22 +655,34 @@ int RGWGC::process(int index, int max_secs, bool expired_only,
       } // else -- chains not empty
     } // entries loop
     if (transitioned_objects_cache[index] && entries.size() > 0) {
-      ret = io_manager.drain_ios();
-      if (ret < 0) {
-        goto done;
-      }
-      //Remove the entries from the queue
-      ldpp_dout(this, 5) << "RGWGC::process removing entries, marker: " << marker << dendl;
-      ret = io_manager.remove_queue_entries(index, entries.size());
-      if (ret < 0) {
-        ldpp_dout(this, 0) <<
-          "WARNING: failed to remove queue entries" << dendl;
-        goto done;
+      pending_trim += entries.size();
+      if (pending_trim >= trim_batch || !truncated) {
+        ret = io_manager.drain_ios();
+        if (ret < 0) {
+          goto done;
+        }
+        //Remove the entries from the queue
+        ldpp_dout(this, 5) << "RGWGC::process removing " << pending_trim <<
+          " entries, marker: " << marker << dendl;
+        ret = io_manager.remove_queue_entries(index, pending_trim);
+        pending_trim = 0;
+        if (ret < 0) {
+          ldpp_dout(this, 0) <<
+            "WARNING: failed to remove queue entries" << dendl;
+          goto done;
+        }
       }
     }
   } while (truncated);
 
 done:
+  if (pending_trim > 0 && !going_down()) {
+    /* the entries of the pages fully scheduled, unless one of their
+     * deletions failed; the others are listed again next time */
+    if (io_manager.drain_ios() == 0) {
+      io_manager.remove_queue_entries(index, pending_trim);
+    }
+  }
   /* we don't drain here, because if we're going down we don't want to
    * hold the system if backend is unresponsive
    */
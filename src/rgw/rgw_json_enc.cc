@@ -1824,6 +1824,36 @@ void rgw_bucket_shard_sync_info::dump(Formatter *f) const
   encode_json("inc_marker", inc_marker, f);
 }
 
+void rgw_sync_fetched_obj::dump(Formatter *f) const
+{
+  encode_json("key", key, f);
+  encode_json("status", status, f);
+  if (status < 0) {
+    return;
+  }
+  encode_json("mtime", mtime, f);
+  encode_json("zone_short_id", zone_short_id, f);
+  encode_json("pg_ver", pg_ver, f);
+  encode_json("etag", etag, f);
+  encode_json("meta", meta, f);
+  encode_json("data", data, f);
+}
+
+void rgw_sync_fetched_obj::decode_json(JSONObj *obj)
+{
+  JSONDecoder::decode_json("key", key, obj);
+  JSONDecoder::decode_json("status", status, obj);
+  if (status < 0) {
+    return;
+  }
+  JSONDecoder::decode_json("mtime", mtime, obj);
+  JSONDecoder::decode_json("zone_short_id", zone_short_id, obj);
+  JSONDecoder::decode_json("pg_ver", pg_ver, obj);
+  JSONDecoder::decode_json("etag", etag, obj);
+  JSONDecoder::decode_json("meta", meta, obj);
+  JSONDecoder::decode_json("data", data, obj);
+}
+
 /* This utility function shouldn't conflict with the overload of std::to_string
  * provided by string_ref since Boost 1.54 as it's defined outside of the std
  * namespace. I hope we'll remove it soon - just after merging the Matt's PR
@@ -3,6 +3,7 @@
 
 #include <string.h>
 #include <iostream>
+#include <deque>
 #include <map>
 #include <algorithm>
 #include <tuple>
@@ -16,6 +17,7 @@
 #include "include/scope_guard.h"
 #include "common/Formatter.h"
 #include "common/containers.h"
+#include "common/Thread.h"
 #include <common/errno.h>
 #include "include/random.h"
 #include "cls/lock/cls_lock_client.h"
@@ -438,6 +440,13 @@ public:
     list_params.prefix = prefix;
   }
 
+  /* list only the index shard @shard_id, from its start */
+  void set_shard(int shard_id) {
+    list_params.shard_id = shard_id;
+    list_params.marker = rgw_obj_key();
+    pre_obj = rgw_bucket_dir_entry();
+  }
+
   int init(const DoutPrefixProvider *dpp) {
     return fetch(dpp);
   }
@@ -770,7 +779,7 @@ class RGWLC::WorkPool
 {
   using TVector = ceph::containers::tiny_vector<WorkQ, 3>;
   TVector wqs;
-  uint64_t ix;
+  std::atomic<uint64_t> ix;
 
 public:
   WorkPool(RGWLC::LCWorker* wk, uint16_t n_threads, uint32_t qmax)
@@ -795,8 +804,8 @@ public:
   }
 
   void enqueue(WorkItem item) {
-    const auto tix = ix;
-    ix = (ix+1) % wqs.size();
+    /* n.b., the shards of a bucket may be listed by several threads */
+    const auto tix = ix++ % wqs.size();
     (wqs[tix]).enqueue(std::move(item));
   }
 
@@ -1505,6 +1514,32 @@ int RGWLC::bucket_lc_process(string& shard_id, LCWorker* worker,
 		      << prefix_map.size()
 		      << dendl;
 
+  /* the versions of an object are all in the index shard of its name, so
+   * the shards can be listed apart, each by a thread of its own */
+  const int num_shards =
+    bucket->get_info().layout.current_index.layout.normal.num_shards;
+  const int num_listers =
+    std::min<int64_t>(num_shards,
+		      cct->_conf.get_val<int64_t>("rgw_lc_max_list_worker"));
+
+  auto list_objs = [&](lc_op& op, LCObjsLister& ol) {
+    int ret = ol.init(this);
+    if (ret < 0) {
+      return ret;
+    }
+
+    op_env oenv(op, store, worker, bucket.get(), ol);
+    LCOpRule orule(oenv);
+    orule.build(); // why can't ctor do it?
+    rgw_bucket_dir_entry* o{nullptr};
+    for (; ol.get_obj(this, &o /* , fetch_barrier */); ol.next()) {
+      orule.update();
+      std::tuple<LCOpRule, rgw_bucket_dir_entry> t1 = {orule, *o};
+      worker->workpool->enqueue(WorkItem{t1});
+    }
+    return 0;
+  };
+
   rgw_obj_key pre_marker;
   rgw_obj_key next_marker;
   for(auto prefix_iter = prefix_map.begin(); prefix_iter != prefix_map.end();
@@ -1531,27 +1566,47 @@ int RGWLC::bucket_lc_process(string& shard_id, LCWorker* worker,
       pre_marker = next_marker;
     }
 
-    LCObjsLister ol(store, bucket.get());
-    ol.set_prefix(prefix_iter->first);
-
-    ret = ol.init(this);
+    if (num_listers <= 1) {
+      LCObjsLister ol(store, bucket.get());
+      ol.set_prefix(prefix_iter->first);
+      ret = list_objs(op, ol);
+      worker->workpool->drain();
+    } else {
+      std::atomic<int> next_shard = 0;
+      std::atomic<int> list_ret = 0;
+      /* the listers outlive their threads, until the workpool is drained */
+      std::deque<LCObjsLister> listers;
+      std::vector<std::thread> threads;
+      for (int i = 0; i < num_listers; ++i) {
+	auto& ol = listers.emplace_back(store, bucket.get());
+	ol.set_prefix(prefix_iter->first);
+	threads.push_back(make_named_thread("lc_list", [&, &ol = ol] {
+	  for (int shard = next_shard++;
+	       shard < num_shards && list_ret == 0 && !going_down();
+	       shard = next_shard++) {
+	    ldpp_dout(this, 20) << __func__ << "(): listing shard=" << shard
+				<< dendl;
+	    ol.set_shard(shard);
+	    int r = list_objs(op, ol);
+	    if (r < 0) {
+	      int none = 0;
+	      list_ret.compare_exchange_strong(none, r);
+	    }
+	  }
+	}));
+      }
+      for (auto& t : threads) {
+	t.join();
+      }
+      ret = list_ret;
+      worker->workpool->drain();
+    }
     if (ret < 0) {
       if (ret == (-ENOENT))
         return 0;
       ldpp_dout(this, 0) << "ERROR: store->list_objects():" <<dendl;
       return ret;
     }
-
-    op_env oenv(op, store, worker, bucket.get(), ol);
-    LCOpRule orule(oenv);
-    orule.build(); // why can't ctor do it?
-    rgw_bucket_dir_entry* o{nullptr};
-    for (; ol.get_obj(this, &o /* , fetch_barrier */); ol.next()) {
-      orule.update();
-      std::tuple<LCOpRule, rgw_bucket_dir_entry> t1 = {orule, *o};
-      worker->workpool->enqueue(WorkItem{t1});
-    }
-    worker->workpool->drain();
   }
 
   ret = handle_multipart_expiration(bucket.get(), prefix_map, worker, stop_at, once);
@@ -1,6 +1,8 @@
+#include <map>
 #include <sstream>
 #include <stdexcept>
 #include <lua.hpp>
+#include "include/scope_guard.h"
 #include "common/dout.h"
 #include "services/svc_zone.h"
 #include "rgw_lua_utils.h"
@@ -768,6 +770,73 @@ struct RequestMetaTable : public EmptyMetaTable {
   }
 };
 
+namespace {
+
+// a lua state kept by each thread across the requests it runs, with the
+// scripts it compiled, so that a request only pays for running its script
+class thread_state {
+  static constexpr auto max_chunks = 16;
+
+  lua_State* L = nullptr;
+  CephContext* cct = nullptr;
+  std::string package_path;
+  std::map<std::string, int> chunks; // registry refs, by script text
+
+public:
+  bool busy = false;
+
+  ~thread_state() { reset(); }
+
+  void reset() {
+    if (L) {
+      lua_close(L);
+      L = nullptr;
+    }
+    chunks.clear();
+  }
+
+  lua_State* get(CephContext* _cct, const std::string& _package_path) {
+    if (L && (cct != _cct || package_path != _package_path)) {
+      reset();
+    }
+    if (!L) {
+      L = luaL_newstate();
+      cct = _cct;
+      package_path = _package_path;
+      open_standard_libs(L);
+      set_package_path(L, package_path);
+      create_debug_action(L, cct);
+      lua_settop(L, 0);
+    }
+    return L;
+  }
+
+  // push the compiled script, a chunk taking its globals from its first upvalue
+  int push_chunk(const std::string& script) {
+    if (auto i = chunks.find(script); i != chunks.end()) {
+      lua_rawgeti(L, LUA_REGISTRYINDEX, i->second);
+      return LUA_OK;
+    }
+    const auto rc = luaL_loadstring(L, script.c_str());
+    if (rc != LUA_OK) {
+      return rc;
+    }
+    if (chunks.size() >= max_chunks) {
+      for (const auto& [text, ref] : chunks) {
+        luaL_unref(L, LUA_REGISTRYINDEX, ref);
+      }
+      chunks.clear();
+    }
+    lua_pushvalue(L, -1);
+    chunks.emplace(script, luaL_ref(L, LUA_REGISTRYINDEX));
+    return LUA_OK;
+  }
+};
+
+thread_local thread_state state;
+
+} // anonymous namespace
+
 int execute(
     rgw::sal::Store* store,
     RGWREST* rest,
@@ -777,16 +846,16 @@ int execute(
     const std::string& script)
 
 {
-  auto L = luaL_newstate();
-  lua_state_guard lguard(L);
-
-  open_standard_libs(L);
-  set_package_path(L, store ?
-      store->get_luarocks_path() : 
-      "");
-
-  create_debug_action(L, s->cct);  
-
+  // a script that yields the frontend coroutine would let another one run
+  // on this thread: that one gets a state of its own
+  thread_state local;
+  auto& st = state.busy ? local : state;
+  st.busy = true;
+  auto unbusy = make_scope_guard([&st] { st.busy = false; });
+  auto L = st.get(s->cct, store ? store->get_luarocks_path() : "");
+
+  // the Request table, and the closures of its metatables, point to this
+  // request
   create_metatable<RequestMetaTable>(L, true, s, const_cast<char*>(op_name));
   
   // add the ops log action
@@ -800,18 +869,37 @@ int execute(
   lua_pushlightuserdata(L, const_cast<char*>(op_name));
   lua_pushcclosure(L, RequestLog, FIVE_UPVALS);
   lua_rawset(L, -3);
+  lua_settop(L, 0);
 
   try {
+    if (st.push_chunk(script) != LUA_OK) {
+      const std::string err(lua_tostring(L, -1));
+      ldpp_dout(s, 1) << "Lua ERROR: " << err << dendl;
+      st.reset();
+      return -1;
+    }
+    // the globals the script sets go to a table of this request, that
+    // falls back to the shared ones
+    lua_newtable(L);
+    lua_newtable(L);
+    lua_pushglobaltable(L);
+    lua_setfield(L, -2, "__index");
+    lua_setmetatable(L, -2);
+    lua_setupvalue(L, -2, 1);
     // execute the lua script
-    if (luaL_dostring(L, script.c_str()) != LUA_OK) {
+    if (lua_pcall(L, 0, LUA_MULTRET, 0) != LUA_OK) {
       const std::string err(lua_tostring(L, -1));
       ldpp_dout(s, 1) << "Lua ERROR: " << err << dendl;
+      st.reset();
       return -1;
     }
   } catch (const std::runtime_error& e) {
     ldpp_dout(s, 1) << "Lua ERROR: " << e.what() << dendl;
+    // the state may have been left in the middle of a call
+    st.reset();
     return -1;
   }
+  lua_settop(L, 0);
 
   return 0;
 }
@@ -4,6 +4,7 @@
 #include <string.h>
 
 #include <iostream>
+#include <limits>
 #include <map>
 
 #include "include/types.h"
@@ -195,6 +196,96 @@ int list_multipart_parts(const DoutPrefixProvider *dpp, struct req_state *s,
 			      next_marker, truncated, assume_unsorted);
 }
 
+static string part_key(int num)
+{
+  char buf[32];
+  snprintf(buf, sizeof(buf), "part.%08d", num);
+  return buf;
+}
+
+int list_multipart_parts(const DoutPrefixProvider *dpp, struct req_state *s,
+			 const string& upload_id, const string& meta_oid,
+			 const std::vector<int>& part_nums,
+			 map<uint32_t, RGWUploadPartInfo>& parts,
+			 optional_yield y)
+{
+  bool truncated;
+  if (!is_v2_upload_id(upload_id)) {
+    // the keys don't sort, all of them are read at once anyway
+    return list_multipart_parts(dpp, s, upload_id, meta_oid,
+				std::numeric_limits<int>::max(), 0, parts,
+				nullptr, &truncated);
+  }
+
+  const uint64_t max_per_op = s->cct->_conf->osd_max_omap_entries_per_request;
+  const uint64_t max_aio =
+    s->cct->_conf.get_val<uint64_t>("rgw_multipart_complete_max_aio");
+
+  std::unique_ptr<rgw::sal::Object> obj = s->bucket->get_object(
+		      rgw_obj_key(meta_oid, std::string(), RGW_OBJ_NS_MULTIPART));
+  obj->set_in_extra_data(true);
+
+  // every max_per_op-th requested part starts a range, so each of them
+  // usually fits in one listing
+  std::vector<rgw::sal::Object::OmapRange> ranges;
+  std::vector<int> ends;  // the last part number of each range
+  for (size_t i = 0; i < part_nums.size(); i += max_per_op) {
+    int first = (i == 0 ? 0 : part_nums[i] - 1);
+    if (!ends.empty()) {
+      ends.back() = first;
+    }
+    ranges.emplace_back();
+    ranges.back().marker = part_key(first);
+    ends.push_back(std::numeric_limits<int>::max());
+  }
+
+  parts.clear();
+  while (!ranges.empty()) {
+    int ret = obj->omap_get_vals(dpp, ranges, max_per_op, max_aio, y);
+    if (ret < 0) {
+      return ret;
+    }
+    std::vector<rgw::sal::Object::OmapRange> next;
+    std::vector<int> next_ends;
+    for (size_t i = 0; i < ranges.size(); ++i) {
+      int last = -1;
+      bool past_end = false;
+      for (auto& [key, bl] : ranges[i].vals) {
+	RGWUploadPartInfo info;
+	auto bli = bl.cbegin();
+	try {
+	  decode(info, bli);
+	} catch (buffer::error& err) {
+	  ldpp_dout(dpp, 0) << "ERROR: could not part info, caught buffer::error" <<
+	    dendl;
+	  return -EIO;
+	}
+	if (key != part_key(info.num)) {
+	  // written by a gateway that doesn't sort the part keys
+	  return list_multipart_parts(dpp, s, upload_id, meta_oid,
+				      std::numeric_limits<int>::max(), 0,
+				      parts, nullptr, &truncated, true);
+	}
+	if ((int)info.num > ends[i]) {
+	  past_end = true;
+	  break;
+	}
+	last = info.num;
+	parts[info.num] = std::move(info);
+      }
+      if (ranges[i].more && !past_end && last >= 0) {
+	// more parts than requested in this range, go on listing it
+	next.emplace_back();
+	next.back().marker = part_key(last);
+	next_ends.push_back(ends[i]);
+      }
+    }
+    ranges.swap(next);
+    ends.swap(next_ends);
+  }
+  return 0;
+}
+
 int abort_multipart_upload(const DoutPrefixProvider *dpp,
 			   rgw::sal::Store* store, CephContext *cct,
 			   RGWObjectCtx *obj_ctx, rgw::sal::Bucket* bucket,
@@ -126,6 +126,17 @@ extern int list_multipart_parts(const DoutPrefixProvider *dpp,
                                 int *next_marker, bool *truncated,
                                 bool assume_unsorted = false);
 
+/* all the uploaded parts of a completion of the parts @p part_nums,
+ * sorted: the key space is split by the requested parts into ranges,
+ * which are listed in parallel */
+extern int list_multipart_parts(const DoutPrefixProvider *dpp,
+                                struct req_state *s,
+                                const string& upload_id,
+                                const string& meta_oid,
+                                const std::vector<int>& part_nums,
+                                map<uint32_t, RGWUploadPartInfo>& parts,
+                                optional_yield y);
+
 extern int abort_multipart_upload(const DoutPrefixProvider *dpp, rgw::sal::Store* store,
 				  CephContext *cct, RGWObjectCtx *obj_ctx,
 				  rgw::sal::Bucket* bucket, RGWMPObj& mp_obj);
@@ -68,6 +68,7 @@ class Manager : public DoutPrefixProvider {
   std::vector<std::thread> workers;
   const uint32_t stale_reservations_period_s;
   const uint32_t reservations_cleanup_period_s;
+  const size_t max_batch_size;
  
   const std::string Q_LIST_OBJECT_NAME = "queues_list_object";
 
@@ -159,38 +160,39 @@ class Manager : public DoutPrefixProvider {
     }   
   };
 
-  // processing of a specific entry
+  // consecutive entries of a queue going to the same endpoint
+  struct entries_batch_t {
+    std::string marker; // of the first entry
+    std::string last_marker;
+    std::string push_endpoint;
+    std::string push_endpoint_args;
+    std::string arn_topic;
+    std::vector<rgw_pubsub_s3_event> events;
+  };
+
+  // processing of a batch of entries, sent to their endpoint together
   // return whether processing was successfull (true) or not (false)
-  bool process_entry(const cls_queue_entry& entry, spawn::yield_context yield) {
-    event_entry_t event_entry;
-    auto iter = entry.data.cbegin();
-    try {
-      decode(event_entry, iter);
-    } catch (buffer::error& err) {
-      ldpp_dout(this, 5) << "WARNING: failed to decode entry. error: " << err.what() << dendl;
-      return false;
-    }
+  bool process_batch(const entries_batch_t& batch, spawn::yield_context yield) {
     try {
-      // TODO move endpoint creation to queue level
-      const auto push_endpoint = RGWPubSubEndpoint::create(event_entry.push_endpoint, event_entry.arn_topic,
-          RGWHTTPArgs(event_entry.push_endpoint_args, this), 
+      const auto push_endpoint = RGWPubSubEndpoint::create(batch.push_endpoint, batch.arn_topic,
+          RGWHTTPArgs(batch.push_endpoint_args, this), 
           cct);
-      ldpp_dout(this, 20) << "INFO: push endpoint created: " << event_entry.push_endpoint <<
-        " for entry: " << entry.marker << dendl;
-      const auto ret = push_endpoint->send_to_completion_async(cct, event_entry.event, optional_yield(io_context, yield));
+      ldpp_dout(this, 20) << "INFO: push endpoint created: " << batch.push_endpoint <<
+        " for entries: " << batch.marker << ".." << batch.last_marker << dendl;
+      const auto ret = push_endpoint->send_batch_to_completion_async(cct, batch.events, optional_yield(io_context, yield));
       if (ret < 0) {
-        ldpp_dout(this, 5) << "WARNING: push entry: " << entry.marker << " to endpoint: " << event_entry.push_endpoint 
-          << " failed. error: " << ret << " (will retry)" << dendl;
+        ldpp_dout(this, 5) << "WARNING: push entries: " << batch.marker << ".." << batch.last_marker
+          << " to endpoint: " << batch.push_endpoint << " failed. error: " << ret << " (will retry)" << dendl;
         return false;
       } else {
-        ldpp_dout(this, 20) << "INFO: push entry: " << entry.marker << " to endpoint: " << event_entry.push_endpoint 
-          << " ok" <<  dendl;
-        if (perfcounter) perfcounter->inc(l_rgw_pubsub_push_ok);
+        ldpp_dout(this, 20) << "INFO: push entries: " << batch.marker << ".." << batch.last_marker
+          << " to endpoint: " << batch.push_endpoint << " ok" <<  dendl;
+        if (perfcounter) perfcounter->inc(l_rgw_pubsub_push_ok, batch.events.size());
         return true;
       }
     } catch (const RGWPubSubEndpoint::configuration_error& e) {
       ldpp_dout(this, 5) << "WARNING: failed to create push endpoint: " 
-          << event_entry.push_endpoint << " for entry: " << entry.marker << ". error: " << e.what() << " (will retry) " << dendl;
+          << batch.push_endpoint << " for entry: " << batch.marker << ". error: " << e.what() << " (will retry) " << dendl;
       return false;
     }
   }
@@ -303,32 +305,61 @@ class Manager : public DoutPrefixProvider {
       is_idle = false;
       auto has_error = false;
       auto remove_entries = false;
-      auto entry_idx = 1U;
-      tokens_waiter waiter(io_context);
+
+      // up to max_batch_size consecutive entries to the same endpoint are
+      // sent together, the batches in parallel
+      std::vector<entries_batch_t> batches;
       for (auto& entry : entries) {
-        if (has_error) {
-          // bail out on first error
+        event_entry_t event_entry;
+        auto iter = entry.data.cbegin();
+        try {
+          decode(event_entry, iter);
+        } catch (buffer::error& err) {
+          ldpp_dout(this, 5) << "WARNING: failed to decode entry: " << entry.marker << ". error: " << err.what() << dendl;
+          // the entries from this one on are left in the queue
+          if (set_min_marker(end_marker, entry.marker) < 0) {
+            ldpp_dout(this, 1) << "ERROR: cannot determin minimum between malformed markers: " << end_marker << ", " << entry.marker << dendl;
+          }
+          has_error = true;
           break;
         }
-        // TODO pass entry pointer instead of by-value
-        spawn::spawn(yield, [this, &queue_name, entry_idx, total_entries, &end_marker, &remove_entries, &has_error, &waiter, entry](spawn::yield_context yield) {
+        if (batches.empty() ||
+            batches.back().events.size() >= max_batch_size ||
+            batches.back().push_endpoint != event_entry.push_endpoint ||
+            batches.back().push_endpoint_args != event_entry.push_endpoint_args ||
+            batches.back().arn_topic != event_entry.arn_topic) {
+          auto& batch = batches.emplace_back();
+          batch.marker = entry.marker;
+          batch.push_endpoint = std::move(event_entry.push_endpoint);
+          batch.push_endpoint_args = std::move(event_entry.push_endpoint_args);
+          batch.arn_topic = std::move(event_entry.arn_topic);
+        }
+        batches.back().last_marker = entry.marker;
+        batches.back().events.push_back(std::move(event_entry.event));
+      }
+
+      auto batch_idx = 1U;
+      const auto total_batches = batches.size();
+      tokens_waiter waiter(io_context);
+      for (const auto& batch : batches) {
+        spawn::spawn(yield, [this, &queue_name, batch_idx, total_batches, &end_marker, &remove_entries, &has_error, &waiter, &batch](spawn::yield_context yield) {
             const auto token = waiter.make_token();
-            if (process_entry(entry, yield)) {
-              ldpp_dout(this, 20) << "INFO: processing of entry: " << 
-                entry.marker << " (" << entry_idx << "/" << total_entries << ") from: " << queue_name << " ok" << dendl;
+            if (process_batch(batch, yield)) {
+              ldpp_dout(this, 20) << "INFO: processing of entries: " << 
+                batch.marker << ".." << batch.last_marker << " (" << batch_idx << "/" << total_batches << ") from: " << queue_name << " ok" << dendl;
               remove_entries = true;
             }  else {
-              if (set_min_marker(end_marker, entry.marker) < 0) {
-                ldpp_dout(this, 1) << "ERROR: cannot determin minimum between malformed markers: " << end_marker << ", " << entry.marker << dendl;
+              if (set_min_marker(end_marker, batch.marker) < 0) {
+                ldpp_dout(this, 1) << "ERROR: cannot determin minimum between malformed markers: " << end_marker << ", " << batch.marker << dendl;
               } else {
                 ldpp_dout(this, 20) << "INFO: new end marker for removal: " << end_marker << " from: " << queue_name << dendl;
               }
               has_error = true;
-              ldpp_dout(this, 20) << "INFO: processing of entry: " << 
-                entry.marker << " (" << entry_idx << "/" << total_entries << ") from: " << queue_name << " failed" << dendl;
+              ldpp_dout(this, 20) << "INFO: processing of entries: " << 
+                batch.marker << ".." << batch.last_marker << " (" << batch_idx << "/" << total_batches << ") from: " << queue_name << " failed" << dendl;
             } 
         }, make_stack_allocator());
-        ++entry_idx;
+        ++batch_idx;
       }
 
       // wait for all pending work to finish
@@ -474,7 +505,7 @@ public:
   Manager(CephContext* _cct, uint32_t _max_queue_size, uint32_t _queues_update_period_ms, 
           uint32_t _queues_update_retry_ms, uint32_t _queue_idle_sleep_us, u_int32_t failover_time_ms, 
           uint32_t _stale_reservations_period_s, uint32_t _reservations_cleanup_period_s,
-          uint32_t _worker_count, rgw::sal::RadosStore* store) :
+          uint32_t _worker_count, size_t _max_batch_size, rgw::sal::RadosStore* store) :
     max_queue_size(_max_queue_size),
     queues_update_period_ms(_queues_update_period_ms),
     queues_update_retry_ms(_queues_update_retry_ms),
@@ -486,7 +517,8 @@ public:
     work_guard(boost::asio::make_work_guard(io_context)),
     worker_count(_worker_count),
     stale_reservations_period_s(_stale_reservations_period_s),
-    reservations_cleanup_period_s(_reservations_cleanup_period_s)
+    reservations_cleanup_period_s(_reservations_cleanup_period_s),
+    max_batch_size(_max_batch_size)
     {
       spawn::spawn(io_context, [this](spawn::yield_context yield) {
             process_queues(yield);
@@ -582,6 +614,7 @@ constexpr uint32_t FAILOVER_TIME_MSEC = 3*Q_LIST_UPDATE_MSEC; // FAILOVER TIME 3
 constexpr uint32_t WORKER_COUNT = 1;                 // 1 worker thread
 constexpr uint32_t STALE_RESERVATIONS_PERIOD_S = 120;   // cleanup reservations that are more than 2 minutes old
 constexpr uint32_t RESERVATIONS_CLEANUP_PERIOD_S = 30; // reservation cleanup every 30 seconds
+constexpr size_t MAX_BATCH_SIZE = 100;                  // send up to 100 entries together
 
 bool init(CephContext* cct, rgw::sal::RadosStore* store, const DoutPrefixProvider *dpp) {
   if (s_manager) {
@@ -593,6 +626,7 @@ bool init(CephContext* cct, rgw::sal::RadosStore* store, const DoutPrefixProvide
       IDLE_TIMEOUT_USEC, FAILOVER_TIME_MSEC, 
       STALE_RESERVATIONS_PERIOD_S, RESERVATIONS_CLEANUP_PERIOD_S,
       WORKER_COUNT,
+      MAX_BATCH_SIZE,
       store);
   return true;
 }
@@ -21,6 +21,7 @@
 #include "common/utf8.h"
 #include "common/ceph_json.h"
 #include "common/static_ptr.h"
+#include "common/lru_map.h"
 
 #include "rgw_rados.h"
 #include "rgw_zone.h"
@@ -284,12 +285,36 @@ static int get_obj_policy_from_attr(const DoutPrefixProvider *dpp,
 }
 
 
+/*
+ * the policies are parsed again on every request that reads them from
+ * the bucket or user attrs; keep the parsed ones, by their tenant and
+ * text, which is all a parse depends on
+ */
+static Policy parse_cached_policy(CephContext* cct, const string& tenant,
+				  const bufferlist& text)
+{
+  static const uint64_t max = cct->_conf.get_val<uint64_t>("rgw_iam_policy_cache_size");
+  static lru_map<string, std::shared_ptr<const Policy>> policies(max);
+  if (!max) {
+    return Policy(cct, tenant, text);
+  }
+  string key = tenant;
+  key.push_back('\0');
+  key.append(text.to_str());
+  std::shared_ptr<const Policy> p;
+  if (!policies.find(key, p)) {
+    p = std::make_shared<const Policy>(cct, tenant, text);
+    policies.add(key, p);
+  }
+  return *p;
+}
+
 static boost::optional<Policy> get_iam_policy_from_attr(CephContext* cct,
 							map<string, bufferlist>& attrs,
 							const string& tenant) {
   auto i = attrs.find(RGW_ATTR_IAM_POLICY);
   if (i != attrs.end()) {
-    return Policy(cct, tenant, i->second);
+    return parse_cached_policy(cct, tenant, i->second);
   } else {
     return none;
   }
@@ -322,8 +347,7 @@ vector<Policy> get_iam_user_policy_from_attr(CephContext* cct,
    decode(policy_map, out_bl);
    for (auto& it : policy_map) {
      bufferlist bl = bufferlist::static_from_string(it.second);
-     Policy p(cct, tenant, bl);
-     policies.push_back(std::move(p));
+     policies.push_back(parse_cached_policy(cct, tenant, bl));
    }
   }
   return policies;
@@ -3880,6 +3904,11 @@ void RGWPutObj::execute(optional_yield y)
       }
     }
   }
+  std::optional<rgw::putobj::MD5Filter> md5;
+  if (need_calc_md5) {
+    md5.emplace(filter, hash);
+    filter = &*md5;
+  }
   tracepoint(rgw_op, before_data_transfer, s->req_id.c_str());
   do {
     bufferlist data;
@@ -3904,10 +3933,6 @@ void RGWPutObj::execute(optional_yield y)
       break;
     }
 
-    if (need_calc_md5) {
-      hash.Update((const unsigned char *)data.c_str(), data.length());
-    }
-
     /* update torrrent */
     torrent.update(data);
 
@@ -4190,6 +4215,9 @@ void RGWPostObj::execute(optional_yield y)
       }
     }
 
+    rgw::putobj::MD5Filter md5(filter, hash);
+    filter = &md5;
+
     bool again;
     do {
       ceph::bufferlist data;
@@ -4204,7 +4232,6 @@ void RGWPostObj::execute(optional_yield y)
         break;
       }
 
-      hash.Update((const unsigned char *)data.c_str(), data.length());
       op_ret = filter->process(std::move(data), ofs);
 
       ofs += len;
@@ -5909,9 +5936,6 @@ void RGWCompleteMultipart::execute(optional_yield y)
 
   int total_parts = 0;
   int handled_parts = 0;
-  int max_parts = 1000;
-  int marker = 0;
-  bool truncated;
   RGWCompressionInfo cs_info;
   bool compressed = false;
   uint64_t accounted_size = 0;
@@ -5956,17 +5980,22 @@ void RGWCompleteMultipart::execute(optional_yield y)
   }
   attrs = meta_obj->get_attrs();
 
-  do {
-    op_ret = list_multipart_parts(this, s, upload_id, meta_oid, max_parts,
-				  marker, obj_parts, &marker, &truncated);
+  {
+    std::vector<int> part_nums;
+    part_nums.reserve(parts->parts.size());
+    for (auto& p : parts->parts) {
+      part_nums.push_back(p.first);
+    }
+    op_ret = list_multipart_parts(this, s, upload_id, meta_oid, part_nums,
+				  obj_parts, y);
     if (op_ret == -ENOENT) {
       op_ret = -ERR_NO_SUCH_UPLOAD;
     }
     if (op_ret < 0)
       return;
 
-    total_parts += obj_parts.size();
-    if (!truncated && total_parts != (int)parts->parts.size()) {
+    total_parts = obj_parts.size();
+    if (total_parts != (int)parts->parts.size()) {
       ldpp_dout(this, 0) << "NOTICE: total parts mismatch: have: " << total_parts
 		       << " expected: " << parts->parts.size() << dendl;
       op_ret = -ERR_INVALID_PART;
@@ -6055,7 +6084,7 @@ void RGWCompleteMultipart::execute(optional_yield y)
       ofs += obj_part.size;
       accounted_size += obj_part.accounted_size;
     }
-  } while (truncated);
+  }
   hash.Final((unsigned char *)final_etag);
 
   buf_to_hex((unsigned char *)final_etag, sizeof(final_etag), final_etag_str);
@@ -7024,6 +7053,8 @@ int RGWBulkUploadOp::handle_file(const std::string_view path,
   ssize_t len = 0;
   size_t ofs = 0;
   MD5 hash;
+  MD5Filter md5(filter, hash);
+  filter = &md5;
   do {
     ceph::bufferlist data;
     len = body.get_at_most(s->cct->_conf->rgw_max_chunk_size, data);
@@ -7033,7 +7064,6 @@ int RGWBulkUploadOp::handle_file(const std::string_view path,
       op_ret = len;
       return op_ret;
     } else if (len > 0) {
-      hash.Update((const unsigned char *)data.c_str(), data.length());
       op_ret = filter->process(std::move(data), ofs);
       if (op_ret < 0) {
         ldpp_dout(this, 20) << "filter->process() returned ret=" << op_ret << dendl;
@@ -28,13 +28,20 @@ int rgw_perf_start(CephContext *cct)
   plb.add_u64(l_rgw_qlen, "qlen", "Queue length");
   plb.add_u64(l_rgw_qactive, "qactive", "Active requests queue");
 
+  plb.add_u64_counter(l_rgw_blocking_rados, "blocking_rados",
+		      "Librados calls that blocked a frontend thread");
+
   plb.add_u64_counter(l_rgw_cache_hit, "cache_hit", "Cache hits");
   plb.add_u64_counter(l_rgw_cache_miss, "cache_miss", "Cache miss");
 
+  plb.add_u64_counter(l_rgw_datacache_hit, "datacache_hit", "Local data cache hits");
+  plb.add_u64_counter(l_rgw_datacache_miss, "datacache_miss", "Local data cache miss");
+
   plb.add_u64_counter(l_rgw_keystone_token_cache_hit, "keystone_token_cache_hit", "Keystone token cache hits");
   plb.add_u64_counter(l_rgw_keystone_token_cache_miss, "keystone_token_cache_miss", "Keystone token cache miss");
 
   plb.add_u64_counter(l_rgw_gc_retire, "gc_retire_object", "GC object retires");
+  plb.add_u64_counter(l_rgw_gc_tail_remove, "gc_tail_remove", "GC tail objects removed");
 
   plb.add_u64_counter(l_rgw_lc_expire_current, "lc_expire_current",
 		      "Lifecycle current expiration");
@@ -25,13 +25,19 @@ enum {
   l_rgw_qlen,
   l_rgw_qactive,
 
+  l_rgw_blocking_rados,
+
   l_rgw_cache_hit,
   l_rgw_cache_miss,
 
+  l_rgw_datacache_hit,
+  l_rgw_datacache_miss,
+
   l_rgw_keystone_token_cache_hit,
   l_rgw_keystone_token_cache_miss,
 
   l_rgw_gc_retire,
+  l_rgw_gc_tail_remove,
 
   l_rgw_lc_expire_current,
   l_rgw_lc_expire_noncurrent,
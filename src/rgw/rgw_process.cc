@@ -41,18 +41,49 @@ void RGWProcess::RGWWQ::_dump_queue()
   }
 } /* RGWProcess::RGWWQ::_dump_queue */
 
+/// the user to schedule the request of with rgw_dmclock_per_user.  The
+/// request is not authenticated yet: this is the access key it is signed
+/// with, or the tenant of its bucket
+static std::string get_dmclock_user(req_state *s)
+{
+  if (const char *auth = s->info.env->get("HTTP_AUTHORIZATION"); auth) {
+    std::string_view a{auth};
+    // AWS4-HMAC-SHA256 Credential=<key>/<scope>, ..., or AWS <key>:<sig>
+    if (auto p = a.find("Credential="); p != a.npos) {
+      a.remove_prefix(p + std::strlen("Credential="));
+      return std::string{a.substr(0, a.find('/'))};
+    }
+    if (a.substr(0, std::strlen("AWS ")) == "AWS ") {
+      a.remove_prefix(std::strlen("AWS "));
+      return std::string{a.substr(0, a.find(':'))};
+    }
+  }
+  if (auto cred = s->info.args.get("X-Amz-Credential"); !cred.empty()) {
+    return cred.substr(0, cred.find('/'));
+  }
+  if (auto key = s->info.args.get("AWSAccessKeyId"); !key.empty()) {
+    return key;
+  }
+  return s->bucket_tenant;
+}
+
 auto schedule_request(Scheduler *scheduler, req_state *s, RGWOp *op)
 {
   using rgw::dmclock::SchedulerCompleter;
   if (!scheduler)
     return std::make_pair(0,SchedulerCompleter{});
 
-  const auto client = op->dmclock_client();
+  rgw::dmclock::client_key_t client = op->dmclock_client();
+  if ((client.type == rgw::dmclock::client_id::data ||
+       client.type == rgw::dmclock::client_id::metadata) &&
+      s->cct->_conf.get_val<bool>("rgw_dmclock_per_user")) {
+    client.user = get_dmclock_user(s);
+  }
   const auto cost = op->dmclock_cost();
   if (s->cct->_conf->subsys.should_gather(ceph_subsys_rgw, 10)) {
     ldpp_dout(op,10) << "scheduling with "
 		     << s->cct->_conf.get_val<std::string>("rgw_scheduler_type")
-		     << " client=" << static_cast<int>(client)
+		     << " client=" << client
 		     << " cost=" << cost << dendl;
   }
   return scheduler->schedule_request(client, {},
@@ -40,6 +40,34 @@ std::string json_format_pubsub_event(const EventType& event) {
   return ss.str();
 }
 
+template<typename EventType>
+std::string json_format_pubsub_events(const std::vector<EventType>& events) {
+  std::stringstream ss;
+  JSONFormatter f(false);
+  {
+    Formatter::ObjectSection s(f, EventType::json_type_plural);
+    {
+      Formatter::ArraySection s(f, EventType::json_type_plural);
+      for (const auto& event : events) {
+        encode_json("", event, &f);
+      }
+    }
+  }
+  f.flush(ss);
+  return ss.str();
+}
+
+int RGWPubSubEndpoint::send_batch_to_completion_async(CephContext* cct,
+    const std::vector<rgw_pubsub_s3_event>& events, optional_yield y) {
+  for (const auto& event : events) {
+    const auto rc = send_to_completion_async(cct, event, y);
+    if (rc < 0) {
+      return rc;
+    }
+  }
+  return 0;
+}
+
 class RGWPubSubHTTPEndpoint : public RGWPubSubEndpoint {
 private:
   const std::string endpoint;
@@ -148,6 +176,19 @@ public:
     return rc;
   }
 
+  // all events go in the "Records" array of a single POST
+  int send_batch_to_completion_async(CephContext* cct, const std::vector<rgw_pubsub_s3_event>& events, optional_yield y) override {
+    bufferlist read_bl;
+    RGWPostHTTPData request(cct, "POST", endpoint, &read_bl, verify_ssl);
+    const auto post_data = json_format_pubsub_events(events);
+    request.set_post_data(post_data);
+    request.set_send_length(post_data.length());
+    if (perfcounter) perfcounter->inc(l_rgw_pubsub_push_pending);
+    const auto rc = RGWHTTP::process(&request, y);
+    if (perfcounter) perfcounter->dec(l_rgw_pubsub_push_pending);
+    return rc;
+  }
+
   std::string to_str() const override {
     std::string str("HTTP/S Endpoint");
     str += "\nURI: " + endpoint;
@@ -4,6 +4,7 @@
 
 #include <string>
 #include <memory>
+#include <vector>
 #include <stdexcept>
 #include "include/buffer_fwd.h"
 #include "include/common_fwd.h"
@@ -43,6 +44,10 @@ public:
   // in async manner via a coroutine when invoked in the frontend environment
   virtual int send_to_completion_async(CephContext* cct, const rgw_pubsub_s3_event& event, optional_yield y) = 0;
 
+  // this method is used in order to send a number of notifications (S3 compliant) and wait for completion
+  // of all of them, in a single message where the endpoint allows it, and one after the other otherwise
+  virtual int send_batch_to_completion_async(CephContext* cct, const std::vector<rgw_pubsub_s3_event>& events, optional_yield y);
+
   // present as string
   virtual std::string to_str() const { return ""; }
   
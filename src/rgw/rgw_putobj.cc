@@ -96,4 +96,13 @@ int StripeProcessor::process(bufferlist&& data, uint64_t offset)
   return Pipe::process(std::move(data), offset - bounds.first);
 }
 
+int MD5Filter::process(bufferlist&& data, uint64_t offset)
+{
+  for (const auto& ptr : data.buffers()) {
+    hash.Update(reinterpret_cast<const unsigned char*>(ptr.c_str()),
+                ptr.length());
+  }
+  return Pipe::process(std::move(data), offset);
+}
+
 } // namespace rgw::putobj
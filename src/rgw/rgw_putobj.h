@@ -16,6 +16,7 @@
 #pragma once
 
 #include "include/buffer.h"
+#include "common/ceph_crypto.h"
 
 namespace rgw::putobj {
 
@@ -57,6 +58,19 @@ class ChunkProcessor : public Pipe {
 };
 
 
+// pipe that feeds the data through an MD5 hash on its way to the next
+// processor, one buffer at a time so the bufferlist isn't rebuilt into a
+// contiguous copy first
+class MD5Filter : public Pipe {
+  ceph::crypto::MD5& hash;
+ public:
+  MD5Filter(DataProcessor *next, ceph::crypto::MD5& hash)
+    : Pipe(next), hash(hash)
+  {}
+
+  int process(bufferlist&& data, uint64_t offset) override;
+};
+
 // interface to generate the next stripe description
 class StripeGenerator {
  public:
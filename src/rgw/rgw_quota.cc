@@ -38,6 +38,7 @@
 
 struct RGWQuotaCacheStats {
   RGWStorageStats stats;
+  utime_t fetch_time; ///< when stats were read from the index
   utime_t expiration;
   utime_t async_refresh_time;
 };
@@ -188,6 +189,7 @@ void RGWQuotaCache<T>::set_stats(const rgw_user& user, const rgw_bucket& bucket,
 {
   qs.stats = stats;
   qs.expiration = ceph_clock_now();
+  qs.fetch_time = qs.expiration;
   qs.async_refresh_time = qs.expiration;
   qs.expiration += store->ctx()->_conf->rgw_bucket_quota_ttl;
   qs.async_refresh_time += store->ctx()->_conf->rgw_bucket_quota_ttl / 2;
@@ -214,6 +216,25 @@ int RGWQuotaCache<T>::get_stats(const rgw_user& user, const rgw_bucket& bucket,
       stats = qs.stats;
       return 0;
     }
+
+    /* close to the quota, or expired: stats read recently enough are still
+     * good, along with what this gateway added since, while a refresh is
+     * under way in the background */
+    const auto max_staleness =
+      store->ctx()->_conf.get_val<int64_t>("rgw_quota_max_staleness");
+    if (max_staleness > 0 && now < qs.fetch_time + utime_t(max_staleness, 0)) {
+      if (qs.async_refresh_time.sec() > 0 &&
+	  now >= qs.fetch_time + utime_t(max_staleness / 2, 0)) {
+	int r = async_refresh(user, bucket, qs);
+	if (r < 0) {
+	  ldpp_dout(dpp, 0) << "ERROR: quota async refresh returned ret=" << r << dendl;
+	}
+      }
+      ldpp_dout(dpp, 20) << "quota: using stats fetched at " << qs.fetch_time
+			 << " while refreshing" << dendl;
+      stats = qs.stats;
+      return 0;
+    }
   }
 
   int ret = fetch_stats_from_storage(user, bucket, stats, y, dpp);
@@ -24,6 +24,7 @@
 #include "rgw_sal.h"
 #include "rgw_zone.h"
 #include "rgw_cache.h"
+#include "rgw_datacache.h"
 #include "rgw_acl.h"
 #include "rgw_acl_s3.h" /* for dumping s3policy in debug log */
 #include "rgw_aio_throttle.h"
@@ -868,12 +869,80 @@ int RGWIndexCompletionThread::process(const DoutPrefixProvider *dpp)
   return 0;
 }
 
+class RGWIndexCompletionManager;
+
+/*
+ * Holds the complete ops of each bucket index shard for up to
+ * rgw_bucket_index_complete_batch_window ms, and sends them as
+ * bucket_complete_ops calls of up to rgw_bucket_index_complete_batch_max
+ * ops, on different keys, instead of one bucket_complete_op each.
+ * The ops of a batch that fails are completed one by one by the
+ * completion thread.
+ */
+class RGWIndexCompleteBatcher : public RGWRadosThread, public DoutPrefixProvider {
+public:
+  struct entry_t {
+    rgw_obj obj;
+    rgw_cls_obj_complete_op op;
+  };
+
+private:
+  struct shard_queue_t {
+    RGWSI_RADOS::Obj bucket_obj;
+    std::deque<entry_t> entries;
+  };
+
+  RGWIndexCompletionManager *manager;
+
+  ceph::mutex lock = ceph::make_mutex("RGWIndexCompleteBatcher::lock");
+  std::map<rgw_raw_obj, shard_queue_t> queues;
+  size_t num_queued = 0;
+
+  uint64_t interval_msec() override {
+    return cct->_conf.get_val<uint64_t>("rgw_bucket_index_complete_batch_window");
+  }
+
+  void send_batch(RGWSI_RADOS::Obj& bucket_obj, std::vector<entry_t>&& batch);
+
+public:
+  RGWIndexCompleteBatcher(RGWRados *_store, RGWIndexCompletionManager *_manager)
+    : RGWRadosThread(_store, "index-batch"), manager(_manager) {}
+
+  bool enabled() {
+    return interval_msec() > 0;
+  }
+  void add(const RGWSI_RADOS::Obj& bucket_obj, entry_t&& entry);
+  int process(const DoutPrefixProvider *dpp) override;
+
+  CephContext *get_cct() const override { return store->ctx(); }
+  unsigned get_subsys() const { return dout_subsys; }
+  std::ostream& gen_prefix(std::ostream& out) const { return out << "rgw index complete batcher: "; }
+};
+
+struct complete_batch_data {
+  ceph::mutex lock = ceph::make_mutex("complete_batch_data");
+  RGWIndexCompletionManager *manager{nullptr};
+  std::vector<RGWIndexCompleteBatcher::entry_t> entries;
+
+  bool stopped{false};
+
+  void stop() {
+    std::lock_guard l{lock};
+    stopped = true;
+  }
+};
+
 class RGWIndexCompletionManager {
   RGWRados *store{nullptr};
   ceph::containers::tiny_vector<ceph::mutex> locks;
   vector<set<complete_op_data *> > completions;
 
   RGWIndexCompletionThread *completion_thread{nullptr};
+  RGWIndexCompleteBatcher *batcher{nullptr};
+
+  ceph::mutex batches_lock =
+    ceph::make_mutex("RGWIndexCompletionManager::batches_lock");
+  set<complete_batch_data *> batches;
 
   int num_shards;
 
@@ -914,6 +983,13 @@ public:
                          complete_op_data **result);
   bool handle_completion(completion_t cb, complete_op_data *arg);
 
+  /// queue op for a batch, false if batching is off
+  bool batch_completion(const RGWSI_RADOS::Obj& bucket_obj, const rgw_obj& obj,
+                        rgw_cls_obj_complete_op&& op);
+  complete_batch_data *create_batch_completion(
+    std::vector<RGWIndexCompleteBatcher::entry_t>&& entries);
+  void handle_batch_completion(completion_t cb, complete_batch_data *arg);
+
   int start(const DoutPrefixProvider *dpp) {
     completion_thread = new RGWIndexCompletionThread(store);
     int ret = completion_thread->init(dpp);
@@ -921,9 +997,25 @@ public:
       return ret;
     }
     completion_thread->start();
+    batcher = new RGWIndexCompleteBatcher(store, this);
+    batcher->start();
     return 0;
   }
   void stop() {
+    if (batcher) {
+      batcher->stop();
+      // send what is left
+      batcher->process(batcher);
+      delete batcher;
+      batcher = nullptr;
+    }
+    {
+      std::lock_guard l{batches_lock};
+      for (auto b : batches) {
+        b->stop();
+      }
+      batches.clear();
+    }
     if (completion_thread) {
       completion_thread->stop();
       delete completion_thread;
@@ -1001,6 +1093,166 @@ void RGWIndexCompletionManager::create_completion(const rgw_obj& obj,
   completions[shard_id].insert(entry);
 }
 
+void RGWIndexCompleteBatcher::add(const RGWSI_RADOS::Obj& bucket_obj,
+                                  entry_t&& entry)
+{
+  const auto max = cct->_conf.get_val<uint64_t>("rgw_bucket_index_complete_batch_max");
+  bool full;
+  {
+    std::lock_guard l{lock};
+    auto& q = queues[bucket_obj.get_raw_obj()];
+    if (q.entries.empty()) {
+      q.bucket_obj = bucket_obj;
+    }
+    q.entries.push_back(std::move(entry));
+    full = ++num_queued >= max;
+  }
+  if (full) {
+    signal();
+  }
+}
+
+int RGWIndexCompleteBatcher::process(const DoutPrefixProvider *dpp)
+{
+  std::map<rgw_raw_obj, shard_queue_t> qs;
+  {
+    std::lock_guard l{lock};
+    qs.swap(queues);
+    num_queued = 0;
+  }
+
+  const auto max = std::max<uint64_t>(
+    1, cct->_conf.get_val<uint64_t>("rgw_bucket_index_complete_batch_max"));
+  for (auto& [raw_obj, q] : qs) {
+    // the ops on an object name go in the order they came, each in its
+    // own batch, and so do those removing other entries
+    std::vector<entry_t> batch;
+    std::set<std::string> names;
+    for (auto& e : q.entries) {
+      bool alone = !e.op.remove_objs.empty();
+      if (!batch.empty() &&
+          (alone || batch.size() >= max || names.count(e.op.key.name))) {
+        send_batch(q.bucket_obj, std::move(batch));
+        batch.clear();
+        names.clear();
+      }
+      names.insert(e.op.key.name);
+      batch.push_back(std::move(e));
+      if (alone) {
+        send_batch(q.bucket_obj, std::move(batch));
+        batch.clear();
+        names.clear();
+      }
+    }
+    if (!batch.empty()) {
+      send_batch(q.bucket_obj, std::move(batch));
+    }
+  }
+  return 0;
+}
+
+static void obj_complete_batch_cb(completion_t cb, void *arg)
+{
+  auto batch = static_cast<complete_batch_data *>(arg);
+  batch->lock.lock();
+  if (batch->stopped) {
+    batch->lock.unlock();
+    delete batch;
+    return;
+  }
+  batch->manager->handle_batch_completion(cb, batch);
+  batch->lock.unlock();
+  delete batch;
+}
+
+void RGWIndexCompleteBatcher::send_batch(RGWSI_RADOS::Obj& bucket_obj,
+                                         std::vector<entry_t>&& batch)
+{
+  ldpp_dout(this, 20) << __func__ << "(): " << batch.size()
+                      << " ops to " << bucket_obj.get_raw_obj() << dendl;
+  librados::ObjectWriteOperation o;
+  cls_rgw_guard_bucket_resharding(o, -ERR_BUSY_RESHARDING);
+  if (batch.size() == 1) {
+    auto& op = batch.front().op;
+    cls_rgw_bucket_complete_op(o, op.op, op.tag, op.ver, op.key, op.meta,
+                               &op.remove_objs, op.log_op, op.bilog_flags,
+                               &op.zones_trace);
+  } else {
+    std::vector<rgw_cls_obj_complete_op> ops;
+    ops.reserve(batch.size());
+    for (auto& e : batch) {
+      ops.push_back(e.op);
+    }
+    cls_rgw_bucket_complete_ops(o, ops);
+  }
+  auto arg = manager->create_batch_completion(std::move(batch));
+  auto c = librados::Rados::aio_create_completion(arg, obj_complete_batch_cb);
+  int r = bucket_obj.aio_operate(c, &o);
+  if (r < 0) {
+    ldpp_dout(this, 0) << "ERROR: " << __func__ << "(): aio_operate on "
+                       << bucket_obj.get_raw_obj() << " returned r=" << r << dendl;
+  }
+  c->release();
+}
+
+bool RGWIndexCompletionManager::batch_completion(const RGWSI_RADOS::Obj& bucket_obj,
+                                                 const rgw_obj& obj,
+                                                 rgw_cls_obj_complete_op&& op)
+{
+  if (!batcher || !batcher->enabled()) {
+    return false;
+  }
+  batcher->add(bucket_obj, {obj, std::move(op)});
+  return true;
+}
+
+complete_batch_data *RGWIndexCompletionManager::create_batch_completion(
+  std::vector<RGWIndexCompleteBatcher::entry_t>&& entries)
+{
+  auto batch = new complete_batch_data;
+  batch->manager = this;
+  batch->entries = std::move(entries);
+  std::lock_guard l{batches_lock};
+  batches.insert(batch);
+  return batch;
+}
+
+void RGWIndexCompletionManager::handle_batch_completion(completion_t cb,
+                                                        complete_batch_data *arg)
+{
+  {
+    std::lock_guard l{batches_lock};
+    auto iter = batches.find(arg);
+    if (iter == batches.end()) {
+      return;
+    }
+    batches.erase(iter);
+  }
+
+  int r = rados_aio_get_return_value(cb);
+  if (r >= 0) {
+    return;
+  }
+  ldout(store->ctx(), 5) << __func__ << "(): batch of " << arg->entries.size()
+                         << " ops failed r=" << r << ", completing them one by one"
+                         << dendl;
+  for (auto& e : arg->entries) {
+    auto c = new complete_op_data;
+    c->manager = this;
+    c->obj = e.obj;
+    c->op = e.op.op;
+    c->tag = e.op.tag;
+    c->ver = e.op.ver;
+    c->key = e.op.key;
+    c->dir_meta = e.op.meta;
+    c->remove_objs = e.op.remove_objs;
+    c->log_op = e.op.log_op;
+    c->bilog_op = e.op.bilog_flags;
+    c->zones_trace = e.op.zones_trace;
+    completion_thread->add_completion(c);
+  }
+}
+
 bool RGWIndexCompletionManager::handle_completion(completion_t cb, complete_op_data *arg)
 {
   int shard_id = arg->manager_shard_id;
@@ -1069,6 +1321,9 @@ void RGWRados::finalize()
   delete gc;
   gc = NULL;
 
+  delete datacache;
+  datacache = nullptr;
+
   delete obj_expirer;
   obj_expirer = NULL;
 
@@ -1202,6 +1457,17 @@ int RGWRados::init_complete(const DoutPrefixProvider *dpp)
   gc = new RGWGC();
   gc->initialize(cct, this);
 
+  if (cct->_conf.get_val<bool>("rgw_datacache_enabled")) {
+    datacache = new RGWDataCache(cct);
+    ret = datacache->start();
+    if (ret < 0) {
+      // serve the reads from rados alone
+      ldpp_dout(dpp, 0) << "ERROR: failed to start the data cache, ret=" << ret << dendl;
+      delete datacache;
+      datacache = nullptr;
+    }
+  }
+
   obj_expirer = new RGWObjectExpirer(this->store);
 
   if (use_gc_thread) {
@@ -3162,7 +3428,7 @@ int RGWRados::Object::Write::_do_write_meta(const DoutPrefixProvider *dpp,
   auto& ioctx = ref.pool.ioctx();
 
   tracepoint(rgw_rados, operate_enter, req_id.c_str());
-  r = rgw_rados_operate(dpp, ref.pool.ioctx(), ref.obj.oid, &op, null_yield);
+  r = rgw_rados_operate(dpp, ref.pool.ioctx(), ref.obj.oid, &op, y);
   tracepoint(rgw_rados, operate_exit, req_id.c_str());
   if (r < 0) { /* we can expect to get -ECANCELED if object was replaced under,
                 or -ENOENT if was removed, or -EEXIST if it did not exist
@@ -3800,7 +4066,8 @@ int RGWRados::fetch_remote_obj(RGWObjectCtx& obj_ctx,
                const DoutPrefixProvider *dpp,
                RGWFetchObjFilter *filter,
                rgw_zone_set *zones_trace,
-               std::optional<uint64_t>* bytes_transferred)
+               std::optional<uint64_t>* bytes_transferred,
+               const rgw_sync_fetched_obj* prefetched)
 {
   /* source is in a different zonegroup, copy from there */
 
@@ -3907,25 +4174,53 @@ int RGWRados::fetch_remote_obj(RGWObjectCtx& obj_ctx,
     }
   }
 
-  static constexpr bool prepend_meta = true;
-  static constexpr bool get_op = true;
-  static constexpr bool rgwx_stat = false;
-  static constexpr bool sync_manifest = true;
-  static constexpr bool skip_decrypt = true;
-  ret = conn->get_obj(dpp, user_id, info, src_obj, pmod, unmod_ptr,
-                      dest_mtime_weight.zone_short_id, dest_mtime_weight.pg_ver,
-                      prepend_meta, get_op, rgwx_stat,
-                      sync_manifest, skip_decrypt,
-                      true,
-                      &cb, &in_stream_req);
-  if (ret < 0) {
-    goto set_err_state;
-  }
+  if (prefetched) {
+    /* what the request below would have received, read along with other
+     * objects; the conditions it would have sent are checked here */
+    set_mtime = prefetched->mtime;
+    etag = prefetched->etag;
+    expected_size = prefetched->data.length();
+    if (pmod) {
+      obj_time_weight src_weight;
+      src_weight.init(set_mtime, prefetched->zone_short_id, prefetched->pg_ver);
+      src_weight.high_precision = true; /* as for system requests */
+      obj_time_weight mod_weight;
+      mod_weight.init(*pmod, dest_mtime_weight.zone_short_id, dest_mtime_weight.pg_ver);
+      mod_weight.high_precision = true;
+      if (!(mod_weight < src_weight)) {
+        ret = -ERR_NOT_MODIFIED;
+        goto set_err_state;
+      }
+    }
+    bufferlist bl = prefetched->meta;
+    bl.append(prefetched->data);
+    bool pause = false;
+    cb.set_extra_data_len(prefetched->meta.length());
+    ret = cb.handle_data(bl, &pause);
+    if (ret < 0) {
+      goto set_err_state;
+    }
+  } else {
+    static constexpr bool prepend_meta = true;
+    static constexpr bool get_op = true;
+    static constexpr bool rgwx_stat = false;
+    static constexpr bool sync_manifest = true;
+    static constexpr bool skip_decrypt = true;
+    ret = conn->get_obj(dpp, user_id, info, src_obj, pmod, unmod_ptr,
+                        dest_mtime_weight.zone_short_id, dest_mtime_weight.pg_ver,
+                        prepend_meta, get_op, rgwx_stat,
+                        sync_manifest, skip_decrypt,
+                        true,
+                        &cb, &in_stream_req);
+    if (ret < 0) {
+      goto set_err_state;
+    }
 
-  ret = conn->complete_request(in_stream_req, &etag, &set_mtime,
-                               &expected_size, nullptr, nullptr, null_yield);
-  if (ret < 0) {
-    goto set_err_state;
+    ret = conn->complete_request(in_stream_req, &etag, &set_mtime,
+                                 &expected_size, nullptr, nullptr, null_yield);
+    if (ret < 0) {
+      goto set_err_state;
+    }
   }
   ret = cb.flush();
   if (ret < 0) {
@@ -5167,7 +5462,7 @@ int RGWRados::Object::Delete::delete_obj(optional_yield y, const DoutPrefixProvi
   store->remove_rgw_head_obj(op);
 
   auto& ioctx = ref.pool.ioctx();
-  r = rgw_rados_operate(dpp, ioctx, ref.obj.oid, &op, null_yield);
+  r = rgw_rados_operate(dpp, ioctx, ref.obj.oid, &op, y);
 
   /* raced with another operation, object state is indeterminate */
   const bool need_invalidate = (r == -ECANCELED);
@@ -5864,7 +6159,7 @@ int RGWRados::set_attrs(const DoutPrefixProvider *dpp, void *ctx, const RGWBucke
   struct timespec mtime_ts = real_clock::to_timespec(mtime);
   op.mtime2(&mtime_ts);
   auto& ioctx = ref.pool.ioctx();
-  r = rgw_rados_operate(dpp, ioctx, ref.obj.oid, &op, null_yield);
+  r = rgw_rados_operate(dpp, ioctx, ref.obj.oid, &op, y);
   if (state) {
     if (r >= 0) {
       bufferlist acl_bl = attrs[RGW_ATTR_ACL];
@@ -6032,7 +6327,7 @@ int RGWRados::Object::Read::range_to_ofs(uint64_t obj_size, int64_t &ofs, int64_
   return 0;
 }
 
-int RGWRados::Bucket::UpdateIndex::guard_reshard(const DoutPrefixProvider *dpp, BucketShard **pbs, std::function<int(BucketShard *)> call)
+int RGWRados::Bucket::UpdateIndex::guard_reshard(const DoutPrefixProvider *dpp, BucketShard **pbs, std::function<int(BucketShard *)> call, optional_yield y)
 {
   RGWRados *store = target->get_store();
   BucketShard *bs;
@@ -6052,7 +6347,7 @@ int RGWRados::Bucket::UpdateIndex::guard_reshard(const DoutPrefixProvider *dpp,
     ldpp_dout(dpp, 0) << "NOTICE: resharding operation on bucket index detected, blocking" << dendl;
     string new_bucket_id;
     r = store->block_while_resharding(bs, &new_bucket_id,
-                                      target->bucket_info, null_yield, dpp);
+                                      target->bucket_info, y, dpp);
     if (r == -ERR_BUSY_RESHARDING) {
       continue;
     }
@@ -6097,7 +6392,7 @@ int RGWRados::Bucket::UpdateIndex::prepare(const DoutPrefixProvider *dpp, RGWMod
 
   int r = guard_reshard(dpp, nullptr, [&](BucketShard *bs) -> int {
 				   return store->cls_obj_prepare_op(dpp, *bs, op, optag, obj, bilog_flags, y, zones_trace);
-				 });
+				 }, y);
 
   if (r < 0) {
     return r;
@@ -6198,7 +6493,7 @@ int RGWRados::Bucket::UpdateIndex::cancel(const DoutPrefixProvider *dpp)
 
   int ret = guard_reshard(dpp, &bs, [&](BucketShard *bs) -> int {
 				 return store->cls_obj_complete_cancel(*bs, optag, obj, bilog_flags, zones_trace);
-			       });
+			       }, null_yield);
 
   /*
    * need to update data log anyhow, so that whoever follows needs to update its internal markers
@@ -6336,6 +6631,8 @@ struct get_obj_data {
   uint64_t offset; // next offset to write to client
   rgw::AioResultList completed; // completed read results, sorted by offset
   optional_yield yield;
+  RGWDataCache* datacache = nullptr;
+  std::map<uint64_t, std::string> cache_keys; // reads to fill the data cache with
 
   get_obj_data(RGWRados* store, RGWGetDataCB* cb, rgw::Aio* aio,
                uint64_t offset, optional_yield yield)
@@ -6347,6 +6644,16 @@ struct get_obj_data {
       return r;
     }
 
+    if (!cache_keys.empty()) {
+      for (auto& e : results) {
+        auto k = cache_keys.find(e.id);
+        if (k != cache_keys.end()) {
+          datacache->put(k->second, e.data);
+          cache_keys.erase(k);
+        }
+      }
+    }
+
     auto cmp = [](const auto& lhs, const auto& rhs) { return lhs.id < rhs.id; };
     results.sort(cmp); // merge() requires results to be sorted first
     completed.merge(results, cmp); // merge results in sorted order
@@ -6433,12 +6740,29 @@ int RGWRados::get_obj_iterate_cb(const DoutPrefixProvider *dpp,
     return r;
   }
 
-  ldpp_dout(dpp, 20) << "rados->get_obj_iterate_cb oid=" << read_obj.oid << " obj-ofs=" << obj_ofs << " read_ofs=" << read_ofs << " len=" << len << dendl;
-  op.read(read_ofs, len, nullptr, nullptr);
-
   const uint64_t cost = len;
   const uint64_t id = obj_ofs; // use logical object offset for sorting replies
 
+  // tail objects are immutable, the head object is not
+  if (d->datacache && !is_head_obj && astate) {
+    auto key = RGWDataCache::make_key(read_obj.pool.to_str(), read_obj.oid,
+                                      astate->obj_tag.to_str(), read_ofs, len);
+    bufferlist bl;
+    if (d->datacache->get(key, &bl)) {
+      ldpp_dout(dpp, 20) << "datacache hit oid=" << read_obj.oid << " obj-ofs=" << obj_ofs << " read_ofs=" << read_ofs << " len=" << len << dendl;
+      rgw::AioResultList hit;
+      auto e = std::make_unique<rgw::AioResultEntry>();
+      e->id = id;
+      e->data = std::move(bl);
+      hit.push_back(*e.release());
+      return d->flush(std::move(hit));
+    }
+    d->cache_keys.emplace(id, std::move(key));
+  }
+
+  ldpp_dout(dpp, 20) << "rados->get_obj_iterate_cb oid=" << read_obj.oid << " obj-ofs=" << obj_ofs << " read_ofs=" << read_ofs << " len=" << len << dendl;
+  op.read(read_ofs, len, nullptr, nullptr);
+
   auto completed = d->aio->get(obj, rgw::Aio::librados_op(std::move(op), d->yield), cost, id);
 
   return d->flush(std::move(completed));
@@ -6455,6 +6779,7 @@ int RGWRados::Object::Read::iterate(const DoutPrefixProvider *dpp, int64_t ofs,
 
   auto aio = rgw::make_throttle(window_size, y);
   get_obj_data data(store, cb, &*aio, ofs, y);
+  data.datacache = store->datacache;
 
   int r = store->iterate_obj(dpp, obj_ctx, source->get_bucket_info(), state.obj,
                              ofs, end, chunk_size, _get_obj_iterate_cb, &data, y);
@@ -7575,7 +7900,7 @@ int RGWRados::raw_obj_stat(const DoutPrefixProvider *dpp,
     op.read(0, cct->_conf->rgw_max_chunk_size, first_chunk, NULL);
   }
   bufferlist outbl;
-  r = rgw_rados_operate(dpp, ref.pool.ioctx(), ref.obj.oid, &op, &outbl, null_yield);
+  r = rgw_rados_operate(dpp, ref.pool.ioctx(), ref.obj.oid, &op, &outbl, y);
 
   if (epoch) {
     *epoch = ref.pool.ioctx().get_last_version();
@@ -8248,6 +8573,24 @@ int RGWRados::cls_obj_complete_op(BucketShard& bs, const rgw_obj& obj, RGWModify
   ver.pool = pool;
   ver.epoch = epoch;
   cls_rgw_obj_key key(ent.key.name, ent.key.instance);
+
+  rgw_cls_obj_complete_op call;
+  call.op = op;
+  call.tag = tag;
+  call.key = key;
+  call.ver = ver;
+  call.meta = dir_meta;
+  call.log_op = svc.zone->get_zone().log_data;
+  call.bilog_flags = bilog_flags;
+  if (remove_objs) {
+    call.remove_objs = *remove_objs;
+  }
+  call.zones_trace = zones_trace;
+  if (index_completion_manager->batch_completion(bs.bucket_obj, obj,
+                                                 std::move(call))) {
+    return 0;
+  }
+
   cls_rgw_guard_bucket_resharding(o, -ERR_BUSY_RESHARDING);
   cls_rgw_bucket_complete_op(o, op, tag, ver, key, dir_meta, remove_objs,
                              svc.zone->get_zone().log_data, bilog_flags, &zones_trace);
@@ -8421,6 +8764,10 @@ int RGWRados::cls_bucket_list_ordered(const DoutPrefixProvider *dpp,
     const std::string& oid_name;
     RGWRados::ent_map_t::iterator cursor;
     RGWRados::ent_map_t::iterator end;
+    // where to continue listing the shard from once it is consumed;
+    // the entries themselves are moved out as they are consumed
+    cls_rgw_obj_key last_key;
+    bool last_is_common_prefix = false;
 
     // manages an iterator through a shard and provides other
     // accessors
@@ -8429,10 +8776,20 @@ int RGWRados::cls_bucket_list_ordered(const DoutPrefixProvider *dpp,
 		 const std::string& _oid_name):
       shard_idx(_shard_idx),
       result(_result),
-      oid_name(_oid_name),
-      cursor(_result.dir.m.begin()),
-      end(_result.dir.m.end())
-    {}
+      oid_name(_oid_name)
+    {
+      reset();
+    }
+
+    void reset() {
+      cursor = result.dir.m.begin();
+      end = result.dir.m.end();
+      if (!result.dir.m.empty()) {
+	const auto& last = result.dir.m.rbegin()->second;
+	last_key = last.key;
+	last_is_common_prefix = last.is_common_prefix();
+      }
+    }
 
     inline const std::string& entry_name() const {
       return cursor->first;
@@ -8495,8 +8852,8 @@ int RGWRados::cls_bucket_list_ordered(const DoutPrefixProvider *dpp,
     ++tracker_idx;
   }
 
-  rgw_bucket_dir_entry*
-    last_entry_visited = nullptr; // to set last_entry (marker)
+  std::optional<rgw_obj_index_key>
+    last_entry_visited; // to set last_entry (marker)
   map<string, bufferlist> updates;
   uint32_t count = 0;
   while (count < num_entries && !candidates.empty()) {
@@ -8541,7 +8898,7 @@ int RGWRados::cls_bucket_list_ordered(const DoutPrefixProvider *dpp,
 	dirent.key << dendl;
 
       auto [it, inserted] = m.insert_or_assign(name, std::move(dirent));
-      last_entry_visited = &it->second;
+      last_entry_visited = it->second.key;
       if (inserted) {
 	++count;
       } else {
@@ -8552,7 +8909,7 @@ int RGWRados::cls_bucket_list_ordered(const DoutPrefixProvider *dpp,
     } else {
       ldpp_dout(dpp, 10) << "RGWRados::" << __func__ << ": skipping " <<
 	dirent.key.name << "[" << dirent.key.instance << "]" << dendl;
-      last_entry_visited = &tracker.dir_entry();
+      last_entry_visited = tracker.dir_entry().key;
     }
 
     // refresh the candidates map
@@ -8561,6 +8918,32 @@ int RGWRados::cls_bucket_list_ordered(const DoutPrefixProvider *dpp,
 
     next_candidate(cct, tracker, candidates, tracker_idx);
 
+    if (tracker.at_end() && tracker.is_truncated() &&
+	count < num_entries && !tracker.last_is_common_prefix) {
+      // continue listing just this shard from where its results ended,
+      // sized for what is left to return, rather than have the caller
+      // list every shard again
+      const uint32_t refill_entries =
+	std::min(num_entries_per_shard,
+		 calc_ordered_bucket_list_per_shard(num_entries - count,
+						    shard_count));
+      ldpp_dout(dpp, 20) << "RGWRados::" << __func__ <<
+	": listing " << refill_entries << " more entries from shard " <<
+	tracker.shard_idx << " after " << tracker.last_key << dendl;
+      librados::ObjectReadOperation op;
+      rgw_cls_list_ret refill;
+      cls_rgw_bucket_list_op(op, tracker.last_key, prefix, delimiter,
+			     refill_entries, list_versions, &refill);
+      r = rgw_rados_operate(dpp, ioctx, tracker.oid_name, &op, nullptr, y);
+      if (r < 0) {
+	return r;
+      }
+      *cls_filtered = *cls_filtered && refill.cls_filtered;
+      tracker.result = std::move(refill);
+      tracker.reset();
+      next_candidate(cct, tracker, candidates, tracker_idx);
+    }
+
     if (tracker.at_end() && tracker.is_truncated()) {
       // once we exhaust one shard that is truncated, we need to stop,
       // as we cannot be certain that one of the next entries needs to
@@ -8603,8 +8986,8 @@ int RGWRados::cls_bucket_list_ordered(const DoutPrefixProvider *dpp,
       count << ", which is truncated" << dendl;
   }
 
-  if (last_entry_visited != nullptr && last_entry) {
-    *last_entry = last_entry_visited->key;
+  if (last_entry_visited && last_entry) {
+    *last_entry = *last_entry_visited;
     ldpp_dout(dpp, 20) << "RGWRados::" << __func__ <<
       ": returning, last_entry=" << *last_entry << dendl;
   } else {
@@ -34,6 +34,7 @@ class RGWWatcher;
 class SafeTimer;
 class ACLOwner;
 class RGWGC;
+class RGWDataCache;
 class RGWMetaNotifier;
 class RGWDataNotifier;
 class RGWLC;
@@ -46,6 +47,7 @@ struct RGWZoneGroup;
 struct RGWZoneParams;
 class RGWReshard;
 class RGWReshardWait;
+struct rgw_sync_fetched_obj;
 
 class RGWSysObjectCtx;
 
@@ -402,6 +404,7 @@ class RGWRados
 
   rgw::sal::RadosStore* store;
   RGWGC *gc;
+  RGWDataCache *datacache = nullptr;
   RGWLC *lc;
   RGWObjectExpirer *obj_expirer;
   bool use_gc_thread;
@@ -924,7 +927,7 @@ public:
         bs_initialized = false;
       }
 
-      int guard_reshard(const DoutPrefixProvider *dpp, BucketShard **pbs, std::function<int(BucketShard *)> call);
+      int guard_reshard(const DoutPrefixProvider *dpp, BucketShard **pbs, std::function<int(BucketShard *)> call, optional_yield y);
     public:
 
       UpdateIndex(RGWRados::Bucket *_target, const rgw_obj& _obj) : target(_target), obj(_obj),
@@ -1118,7 +1121,8 @@ public:
                        const DoutPrefixProvider *dpp,
                        RGWFetchObjFilter *filter,
                        rgw_zone_set *zones_trace= nullptr,
-                       std::optional<uint64_t>* bytes_transferred = 0);
+                       std::optional<uint64_t>* bytes_transferred = 0,
+                       const rgw_sync_fetched_obj* prefetched = nullptr);
   /**
    * Copy an object.
    * dest_obj: the object to copy into
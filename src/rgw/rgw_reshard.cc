@@ -539,9 +539,206 @@ int RGWBucketReshardLock::renew(const Clock::time_point& now) {
 }
 
 
+/// the index shard of the new bucket instance that @p cls_key goes to
+static int get_target_shard(rgw::sal::RadosStore* store,
+			    const RGWBucketInfo& new_bucket_info,
+			    const cls_rgw_obj_key& cls_key,
+			    int *shard_index)
+{
+  rgw_obj_key key(cls_key);
+  rgw_obj obj(new_bucket_info.bucket, key);
+  RGWMPObj mp;
+  if (key.ns == RGW_OBJ_NS_MULTIPART && mp.from_meta(key.name)) {
+    // place the multipart .meta object on the same shard as its head object
+    obj.index_hash_source = mp.get_key();
+  }
+  int target_shard_id;
+  int ret = store->getRados()->get_target_shard_id(new_bucket_info.layout.current_index.layout.normal, obj.get_hash_object(), &target_shard_id);
+  if (ret < 0) {
+    return ret;
+  }
+  *shard_index = (target_shard_id > 0 ? target_shard_id : 0);
+  return 0;
+}
+
+static void add_stats(map<RGWObjCategory, rgw_bucket_category_stats>& stats,
+		      RGWObjCategory category,
+		      const rgw_bucket_category_stats& s, bool sub)
+{
+  // the deltas wrap around when subtracted, as the cls adds them up
+  rgw_bucket_category_stats& target = stats[category];
+  if (sub) {
+    target.num_entries -= s.num_entries;
+    target.total_size -= s.total_size;
+    target.total_size_rounded -= s.total_size_rounded;
+    target.actual_size -= s.actual_size;
+  } else {
+    target.num_entries += s.num_entries;
+    target.total_size += s.total_size;
+    target.total_size_rounded += s.total_size_rounded;
+    target.actual_size += s.actual_size;
+  }
+}
+
+int RGWBucketReshard::replay_entry(const RGWBucketInfo& new_bucket_info,
+				   int source_shard, const string& name,
+				   int max_entries,
+				   const DoutPrefixProvider *dpp)
+{
+  int shard_index;
+  int ret = get_target_shard(store, new_bucket_info, cls_rgw_obj_key(name),
+			     &shard_index);
+  if (ret < 0) {
+    ldpp_dout(dpp, -1) << "ERROR: get_target_shard_id() returned ret=" << ret << dendl;
+    return ret;
+  }
+  RGWRados::BucketShard bs(store->getRados());
+  ret = bs.init(new_bucket_info.bucket,
+		(new_bucket_info.layout.current_index.layout.normal.num_shards > 0 ?
+		 shard_index : -1),
+		new_bucket_info.layout.current_index, nullptr, dpp);
+  if (ret < 0) {
+    return ret;
+  }
+
+  librados::ObjectWriteOperation op;
+  map<RGWObjCategory, rgw_bucket_category_stats> stats;
+
+  // drop what the bulk copy put in the new shard for this name ...
+  std::set<string> stale;
+  list<rgw_cls_bi_entry> entries;
+  string marker;
+  bool is_truncated = true;
+  while (is_truncated) {
+    entries.clear();
+    ret = store->getRados()->bi_list(bs, name, marker, max_entries,
+				     &entries, &is_truncated);
+    if (ret == -ENOENT) {
+      break;
+    }
+    if (ret < 0) {
+      return ret;
+    }
+    for (auto& entry : entries) {
+      marker = entry.idx;
+      stale.insert(entry.idx);
+      cls_rgw_obj_key cls_key;
+      RGWObjCategory category;
+      rgw_bucket_category_stats s;
+      if (entry.get_info(&cls_key, &category, &s)) {
+	add_stats(stats, category, s, true);
+      }
+    }
+  }
+  if (!stale.empty()) {
+    op.omap_rm_keys(stale);
+  }
+
+  // ... and copy it again from the old one
+  marker.clear();
+  is_truncated = true;
+  while (is_truncated) {
+    entries.clear();
+    ret = store->getRados()->bi_list(dpp, bucket_info, source_shard, name,
+				     marker, max_entries, &entries,
+				     &is_truncated);
+    if (ret == -ENOENT) {
+      break;
+    }
+    if (ret < 0) {
+      return ret;
+    }
+    for (auto& entry : entries) {
+      marker = entry.idx;
+      store->getRados()->bi_put(op, bs, entry);
+      cls_rgw_obj_key cls_key;
+      RGWObjCategory category;
+      rgw_bucket_category_stats s;
+      if (entry.get_info(&cls_key, &category, &s)) {
+	add_stats(stats, category, s, false);
+      }
+    }
+  }
+  cls_rgw_bucket_update_stats(op, false, stats);
+
+  ret = bs.bucket_obj.operate(dpp, &op, null_yield);
+  if (ret < 0) {
+    ldpp_dout(dpp, -1) << "ERROR: failed to update entries of " << name
+      << " in target bucket shard (bs=" << bs.bucket << "/" << bs.shard_id
+      << ") error=" << cpp_strerror(-ret) << dendl;
+    return ret;
+  }
+  return 0;
+}
+
+int RGWBucketReshard::replay_logged_writes(const RGWBucketInfo& new_bucket_info,
+					   int max_entries,
+					   const DoutPrefixProvider *dpp)
+{
+  const int num_source_shards =
+    (bucket_info.layout.current_index.layout.normal.num_shards > 0 ? bucket_info.layout.current_index.layout.normal.num_shards : 1);
+  uint64_t total = 0;
+  for (int i = 0; i < num_source_shards; ++i) {
+    RGWRados::BucketShard bs(store->getRados());
+    int ret = bs.init(bucket_info.bucket,
+		      (bucket_info.layout.current_index.layout.normal.num_shards > 0 ?
+		       i : -1),
+		      bucket_info.layout.current_index, nullptr, dpp);
+    if (ret < 0) {
+      return ret;
+    }
+    string marker;
+    bool is_truncated = true;
+    while (is_truncated) {
+      cls_rgw_reshard_log_list_ret result;
+      int op_ret = 0;
+      librados::ObjectReadOperation op;
+      cls_rgw_reshard_log_list(op, marker, max_entries, &result, &op_ret);
+      ret = bs.bucket_obj.operate(dpp, &op, nullptr, null_yield);
+      if (ret == 0) {
+	ret = op_ret;
+      }
+      if (ret < 0) {
+	return ret;
+      }
+      is_truncated = result.is_truncated;
+      for (auto& name : result.names) {
+	marker = name;
+	ret = replay_entry(new_bucket_info, i, name, max_entries, dpp);
+	if (ret < 0) {
+	  return ret;
+	}
+	++total;
+
+	Clock::time_point now = Clock::now();
+	if (reshard_lock.should_renew(now)) {
+	  if (outer_reshard_lock) {
+	    ret = outer_reshard_lock->renew(now);
+	    if (ret < 0) {
+	      return ret;
+	    }
+	  }
+	  ret = reshard_lock.renew(now);
+	  if (ret < 0) {
+	    ldpp_dout(dpp, -1) << "Error renewing bucket lock: " << ret << dendl;
+	    return ret;
+	  }
+	}
+      }
+      if (result.names.empty()) {
+	break;
+      }
+    }
+  }
+  ldpp_dout(dpp, 10) << __func__ << " copied again the entries of " << total
+    << " objects written during the reshard" << dendl;
+  return 0;
+}
+
 int RGWBucketReshard::do_reshard(int num_shards,
 				 RGWBucketInfo& new_bucket_info,
 				 int max_entries,
+				 bool nonblocking,
 				 bool verbose,
 				 ostream *out,
 				 Formatter *formatter,
@@ -619,26 +816,17 @@ int RGWBucketReshard::do_reshard(int num_shards,
 
 	marker = entry.idx;
 
-	int target_shard_id;
 	cls_rgw_obj_key cls_key;
 	RGWObjCategory category;
 	rgw_bucket_category_stats stats;
 	bool account = entry.get_info(&cls_key, &category, &stats);
-	rgw_obj_key key(cls_key);
-	rgw_obj obj(new_bucket_info.bucket, key);
-	RGWMPObj mp;
-	if (key.ns == RGW_OBJ_NS_MULTIPART && mp.from_meta(key.name)) {
-	  // place the multipart .meta object on the same shard as its head object
-	  obj.index_hash_source = mp.get_key();
-	}
-	int ret = store->getRados()->get_target_shard_id(new_bucket_info.layout.current_index.layout.normal, obj.get_hash_object(), &target_shard_id);
+	int shard_index;
+	int ret = get_target_shard(store, new_bucket_info, cls_key, &shard_index);
 	if (ret < 0) {
 	  ldpp_dout(dpp, -1) << "ERROR: get_target_shard_id() returned ret=" << ret << dendl;
 	  return ret;
 	}
 
-	int shard_index = (target_shard_id > 0 ? target_shard_id : 0);
-
 	ret = target_shards_mgr.add_entry(shard_index, entry, account,
 					  category, stats);
 	if (ret < 0) {
@@ -684,6 +872,21 @@ int RGWBucketReshard::do_reshard(int num_shards,
     return -EIO;
   }
 
+  if (nonblocking) {
+    // block the writes for as long as the logged ones are copied again
+    ret = set_resharding_status(dpp, new_bucket_info.bucket.bucket_id,
+				num_shards, cls_rgw_reshard_status::IN_PROGRESS);
+    if (ret < 0) {
+      return ret;
+    }
+    ret = replay_logged_writes(new_bucket_info, max_entries, dpp);
+    if (ret < 0) {
+      ldpp_dout(dpp, -1) << "ERROR: failed to copy the entries written during "
+	"the reshard: " << cpp_strerror(-ret) << dendl;
+      return ret;
+    }
+  }
+
   ret = store->ctl()->bucket->link_bucket(new_bucket_info.owner, new_bucket_info.bucket, bucket_info.creation_time, null_yield, dpp);
   if (ret < 0) {
     ldpp_dout(dpp, -1) << "failed to link new bucket instance (bucket_id=" << new_bucket_info.bucket.bucket_id << ": " << cpp_strerror(-ret) << ")" << dendl;
@@ -716,6 +919,9 @@ int RGWBucketReshard::execute(int num_shards, int max_op_entries,
     return ret;
   }
 
+  const bool nonblocking =
+    store->ctx()->_conf.get_val<bool>("rgw_reshard_nonblocking");
+
   RGWBucketInfo new_bucket_info;
   ret = create_new_bucket_instance(num_shards, new_bucket_info, dpp);
   if (ret < 0) {
@@ -731,9 +937,13 @@ int RGWBucketReshard::execute(int num_shards, int max_op_entries,
   }
 
   // set resharding status of current bucket_info & shards with
-  // information about planned resharding
+  // information about planned resharding; with nonblocking the shards
+  // keep taking writes and log them until the entries are copied
   ret = set_resharding_status(dpp, new_bucket_info.bucket.bucket_id,
-			      num_shards, cls_rgw_reshard_status::IN_PROGRESS);
+			      num_shards,
+			      nonblocking ?
+			      cls_rgw_reshard_status::IN_LOGRECORD :
+			      cls_rgw_reshard_status::IN_PROGRESS);
   if (ret < 0) {
     goto error_out;
   }
@@ -741,6 +951,7 @@ int RGWBucketReshard::execute(int num_shards, int max_op_entries,
   ret = do_reshard(num_shards,
 		   new_bucket_info,
 		   max_op_entries,
+		   nonblocking,
                    verbose, out, formatter, dpp);
   if (ret < 0) {
     goto error_out;
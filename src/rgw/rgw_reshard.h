@@ -87,9 +87,18 @@ private:
   int create_new_bucket_instance(int new_num_shards,
 				 RGWBucketInfo& new_bucket_info,
                                  const DoutPrefixProvider *dpp);
+  int replay_entry(const RGWBucketInfo& new_bucket_info,
+		   int source_shard, const string& name, int max_entries,
+		   const DoutPrefixProvider *dpp);
+  // copy again the entries of the objects written in the old shards
+  // since IN_LOGRECORD was set
+  int replay_logged_writes(const RGWBucketInfo& new_bucket_info,
+			   int max_entries,
+			   const DoutPrefixProvider *dpp);
   int do_reshard(int num_shards,
 		 RGWBucketInfo& new_bucket_info,
 		 int max_entries,
+		 bool nonblocking,
                  bool verbose,
                  ostream *os,
 		 Formatter *formatter,
@@ -20,6 +20,7 @@
 #include "rgw_rest_s3.h"
 #include "rgw_rest_log.h"
 #include "rgw_client_io.h"
+#include "rgw_compression.h"
 #include "rgw_sync.h"
 #include "rgw_data_sync.h"
 #include "rgw_common.h"
@@ -549,6 +550,187 @@ void RGWOp_BILog_Delete::execute(optional_yield y) {
   return;
 }
 
+namespace {
+
+/* keeps the data read, in order */
+class FetchObjCB : public RGWGetObj_Filter {
+  bufferlist& out;
+public:
+  explicit FetchObjCB(bufferlist& out) : out(out) {}
+
+  int handle_data(bufferlist& bl, off_t bl_ofs, off_t bl_len) override {
+    bufferlist part;
+    part.substr_of(bl, bl_ofs, bl_len);
+    out.claim_append(part);
+    return 0;
+  }
+};
+
+} // anonymous namespace
+
+/*
+ * reads @o.key as a sync fetch of it alone would have: the data as
+ * stored except for compression, and the metadata the fetch would have
+ * embedded ahead of it. Returns -EFBIG for objects larger than @max_size,
+ * which are left to fetches of their own.
+ */
+int RGWOp_BILog_FetchObjs::fetch_obj(rgw::sal::Bucket* bucket,
+				     uint64_t max_size,
+				     rgw_sync_fetched_obj& o,
+				     optional_yield y)
+{
+  RGWObjectCtx obj_ctx(store);
+  std::unique_ptr<rgw::sal::Object> obj = bucket->get_object(o.key);
+  std::unique_ptr<rgw::sal::Object::ReadOp> read_op = obj->get_read_op(&obj_ctx);
+  real_time lastmod;
+  read_op->params.lastmod = &lastmod;
+
+  int r = read_op->prepare(y, this);
+  if (r < 0) {
+    return r;
+  }
+  auto& attrs = obj->get_attrs();
+
+  bool need_decompress = false;
+  RGWCompressionInfo cs_info;
+  r = rgw_compression_info_from_attrset(attrs, need_decompress, cs_info);
+  if (r < 0) {
+    return r;
+  }
+  const uint64_t size = need_decompress ? cs_info.orig_size : obj->get_obj_size();
+  if (size > max_size) {
+    return -EFBIG;
+  }
+
+  if (size > 0) {
+    FetchObjCB cb(o.data);
+    RGWGetObj_Filter* filter = &cb;
+    std::optional<RGWGetObj_Decompress> decompress;
+    if (need_decompress) {
+      decompress.emplace(s->cct, &cs_info, false, filter);
+      filter = &*decompress;
+    }
+    off_t ofs = 0;
+    off_t end = size - 1;
+    filter->fixup_range(ofs, end);
+    r = read_op->iterate(this, ofs, end, filter, y);
+    if (r >= 0) {
+      r = filter->flush();
+    }
+    if (r < 0) {
+      return r;
+    }
+    if (o.data.length() != size) {
+      return -EIO;
+    }
+  }
+
+  JSONFormatter jf;
+  jf.open_object_section("obj_metadata");
+  encode_json("attrs", attrs, &jf);
+  utime_t ut(lastmod);
+  encode_json("mtime", ut, &jf);
+  jf.close_section();
+  stringstream ss;
+  jf.flush(ss);
+  o.meta.append(ss.str());
+
+  o.mtime = lastmod;
+  auto iter = attrs.find(RGW_ATTR_ETAG);
+  if (iter != attrs.end()) {
+    o.etag = "\"" + rgw_bl_str(iter->second) + "\"";
+  }
+  r = decode_attr_bl_single_value(attrs, RGW_ATTR_PG_VER, &o.pg_ver, (uint64_t)0);
+  if (r < 0) {
+    ldpp_dout(this, 0) << "ERROR: failed to decode pg ver attr, ignoring" << dendl;
+  }
+  r = decode_attr_bl_single_value(attrs, RGW_ATTR_SOURCE_ZONE, &o.zone_short_id, (uint32_t)0);
+  if (r < 0) {
+    ldpp_dout(this, 0) << "ERROR: failed to decode source zone attr, ignoring" << dendl;
+  }
+  return 0;
+}
+
+void RGWOp_BILog_FetchObjs::execute(optional_yield y) {
+  string bucket_instance = s->info.args.get("bucket-instance"),
+         max_size_str = s->info.args.get("max-size"),
+         err;
+  std::unique_ptr<rgw::sal::Bucket> bucket;
+  rgw_bucket b;
+
+  uint64_t max_size = strict_strtoll(max_size_str.c_str(), 10, &err);
+  if (bucket_instance.empty() || !err.empty()) {
+    ldpp_dout(this, 5) << "ERROR: bucket instance and max-size are mandatory" << dendl;
+    op_ret = -EINVAL;
+    return;
+  }
+
+  int shard_id;
+  op_ret = rgw_bucket_parse_bucket_instance(bucket_instance, &b.name, &b.bucket_id, &shard_id);
+  if (op_ret < 0) {
+    return;
+  }
+  op_ret = store->get_bucket(s, nullptr, b, &bucket, y);
+  if (op_ret < 0) {
+    ldpp_dout(this, 5) << "could not get bucket info for bucket=" << bucket_instance << dendl;
+    return;
+  }
+
+  int r = 0;
+  bufferlist data;
+  std::tie(r, data) = read_all_input(s, LARGE_ENOUGH_BUF);
+  if (r < 0) {
+    op_ret = r;
+    return;
+  }
+
+  JSONParser p;
+  if (!p.parse(data.c_str(), data.length())) {
+    ldpp_dout(this, 0) << "ERROR: failed to parse JSON" << dendl;
+    op_ret = -EINVAL;
+    return;
+  }
+
+  std::vector<rgw_obj_key> keys;
+  try {
+    decode_json_obj(keys, &p);
+  } catch (JSONDecoder::err& err) {
+    ldpp_dout(this, 0) << "ERROR: failed to decode JSON" << dendl;
+    op_ret = -EINVAL;
+    return;
+  }
+
+  for (auto& key : keys) {
+    auto& o = objs.emplace_back();
+    o.key = key;
+    o.status = fetch_obj(bucket.get(), max_size, o, y);
+    if (o.status < 0) {
+      o.data.clear();
+      o.meta.clear();
+    }
+    ldpp_dout(this, 20) << __func__ << "(): key=" << key
+			<< " status=" << o.status << dendl;
+  }
+  op_ret = 0;
+}
+
+void RGWOp_BILog_FetchObjs::send_response() {
+  set_req_state_err(s, op_ret);
+  dump_errno(s);
+  end_header(s);
+
+  if (op_ret < 0)
+    return;
+
+  s->formatter->open_array_section("objs");
+  for (auto& o : objs) {
+    encode_json("obj", o, s->formatter);
+    flusher.flush();
+  }
+  s->formatter->close_section();
+  flusher.flush();
+}
+
 void RGWOp_DATALog_List::execute(optional_yield y) {
   string   shard = s->info.args.get("id");
 
@@ -1063,6 +1245,9 @@ RGWOp *RGWHandler_Log::op_post() {
       return new RGWOp_MDLog_Unlock;
     else if (s->info.args.exists("notify"))
       return new RGWOp_MDLog_Notify;	    
+  } else if (type.compare("bucket-index") == 0) {
+    if (s->info.args.exists("fetch"))
+      return new RGWOp_BILog_FetchObjs;
   } else if (type.compare("data") == 0) {
     if (s->info.args.exists("notify"))
       return new RGWOp_DATALog_Notify;	    
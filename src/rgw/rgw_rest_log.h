@@ -78,6 +78,29 @@ public:
   }
 };
 
+class RGWOp_BILog_FetchObjs : public RGWRESTOp {
+  std::vector<rgw_sync_fetched_obj> objs;
+
+  int fetch_obj(rgw::sal::Bucket* bucket, uint64_t max_size,
+		rgw_sync_fetched_obj& o, optional_yield y);
+public:
+  RGWOp_BILog_FetchObjs() {}
+  ~RGWOp_BILog_FetchObjs() override {}
+
+  int check_caps(const RGWUserCaps& caps) override {
+    return -EPERM;
+  }
+  int verify_permission(optional_yield y) override {
+    // object data, only for the other zones
+    return s->system_request ? 0 : -EACCES;
+  }
+  void execute(optional_yield y) override;
+  void send_response() override;
+  const char* name() const override {
+    return "fetch_bucket_index_log_objects";
+  }
+};
+
 class RGWOp_MDLog_List : public RGWRESTOp {
   list<cls_log_entry> entries;
   string last_marker;
@@ -183,28 +183,6 @@ int RGWGetObj_ObjStore_S3::send_response_data_error(optional_yield y)
   return send_response_data(bl, 0 , 0);
 }
 
-template <class T>
-int decode_attr_bl_single_value(map<string, bufferlist>& attrs, const char *attr_name, T *result, T def_val)
-{
-  map<string, bufferlist>::iterator iter = attrs.find(attr_name);
-  if (iter == attrs.end()) {
-    *result = def_val;
-    return 0;
-  }
-  bufferlist& bl = iter->second;
-  if (bl.length() == 0) {
-    *result = def_val;
-    return 0;
-  }
-  auto bliter = bl.cbegin();
-  try {
-    decode(*result, bliter);
-  } catch (buffer::error& err) {
-    return -EIO;
-  }
-  return 0;
-}
-
 inline bool str_has_cntrl(const std::string s) {
   return std::any_of(s.begin(), s.end(), ::iscntrl);
 }
@@ -431,7 +409,9 @@ done:
 
 send_data:
   if (get_data && !op_ret) {
-    int r = dump_body(s, bl.c_str() + bl_ofs, bl_len);
+    bufferlist data;
+    data.substr_of(bl, bl_ofs, bl_len);
+    int r = dump_body(s, data);
     if (r < 0)
       return r;
   }
@@ -6355,34 +6335,18 @@ int RGWSelectObj_ObjStore_S3::send_response_data(bufferlist& bl, off_t ofs, off_
     dump_errno(s);
   }
 
-  auto bl_len = bl.get_num_buffers();
-
   // Explicitly use chunked transfer encoding so that we can stream the result
   // to the user without having to wait for the full length of it.
   if (chunk_number == 0) {
     end_header(s, this, "application/xml", CHUNKED_TRANSFER_ENCODING);
   }
 
-  int status=0;
-  int i=0;
-
-  for(auto& it : bl.buffers()) {
-
-    ldpp_dout(this, 10) << "processing segment " << i << " out of " << bl_len << " off " << ofs
+  // hand the engine the whole chunk at once: each call costs a response
+  // message, and a row split over segments has to be stitched back
+  ldpp_dout(this, 10) << "processing " << bl.get_num_buffers() << " segments off " << ofs
                       << " len " << len << " obj-size " << s->obj_size << dendl;
 
-    if(it.length() == 0) {
-      ldpp_dout(this, 10) << "s3select:it->_len is zero. segment " << i << " out of " << bl_len
-                        <<  " obj-size " << s->obj_size << dendl;
-      continue; 
-    }
-
-    status = run_s3select(m_sql_query.c_str(), &(it)[0], it.length());
-    if(status<0) {
-      break;
-    }
-    i++;
-  }
+  int status = run_s3select(m_sql_query.c_str(), bl.c_str(), bl.length());
 
   chunk_number++;
 
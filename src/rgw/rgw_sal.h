@@ -736,6 +736,17 @@ class Object {
     virtual int omap_get_vals(const DoutPrefixProvider *dpp, const std::string& marker, uint64_t count,
 			      std::map<std::string, bufferlist>* m,
 			      bool* pmore, optional_yield y) = 0;
+    /** A range of omap keys, listed from after its marker */
+    struct OmapRange {
+      std::string marker;
+      std::map<std::string, bufferlist> vals;
+      bool more = false;
+    };
+    /** List up to @p count values of each of @p ranges, with up to
+     * @p max_aio of the listings in flight at once */
+    virtual int omap_get_vals(const DoutPrefixProvider *dpp,
+			      std::vector<OmapRange>& ranges, uint64_t count,
+			      uint64_t max_aio, optional_yield y) = 0;
     virtual int omap_get_all(const DoutPrefixProvider *dpp, std::map<std::string, bufferlist>* m,
 			     optional_yield y) = 0;
     virtual int omap_get_vals_by_keys(const DoutPrefixProvider *dpp, const std::string& oid,
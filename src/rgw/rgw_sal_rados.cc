@@ -28,6 +28,7 @@
 #include "rgw_multi.h"
 #include "rgw_acl_s3.h"
 #include "rgw_aio.h"
+#include "rgw_aio_throttle.h"
 
 #include "rgw_zone.h"
 #include "rgw_rest_conn.h"
@@ -1385,6 +1386,46 @@ int RadosObject::omap_get_vals(const DoutPrefixProvider *dpp, const std::string&
   return sysobj.omap().get_vals(dpp, marker, count, m, pmore, y);
 }
 
+int RadosObject::omap_get_vals(const DoutPrefixProvider *dpp,
+				std::vector<OmapRange>& ranges, uint64_t count,
+				uint64_t max_aio, optional_yield y)
+{
+  rgw_raw_obj raw_obj;
+  get_raw_obj(&raw_obj);
+  auto obj = store->svc()->rados->obj(raw_obj);
+  int r = obj.open(dpp);
+  if (r < 0) {
+    return r;
+  }
+
+  auto aio = rgw::make_throttle(max_aio, y);
+  // each listing costs 1 against a window of max_aio
+  std::vector<int> rvals(ranges.size(), 0);
+  for (size_t i = 0; i < ranges.size(); ++i) {
+    auto& range = ranges[i];
+    range.vals.clear();
+    range.more = false;
+    librados::ObjectReadOperation op;
+    op.omap_get_vals2(range.marker, count, &range.vals, &range.more, &rvals[i]);
+    r = rgw::check_for_errors(
+      aio->get(obj, rgw::Aio::librados_op(std::move(op), y), 1, i));
+    if (r < 0) {
+      aio->drain();
+      return r;
+    }
+  }
+  r = rgw::check_for_errors(aio->drain());
+  if (r < 0) {
+    return r;
+  }
+  for (auto rval : rvals) {
+    if (rval < 0) {
+      return rval;
+    }
+  }
+  return 0;
+}
+
 int RadosObject::omap_get_all(const DoutPrefixProvider *dpp, std::map<std::string, bufferlist> *m,
 				 optional_yield y)
 {
@@ -220,6 +220,9 @@ class RadosObject : public Object {
     virtual int omap_get_vals(const DoutPrefixProvider *dpp, const std::string& marker, uint64_t count,
 			      std::map<std::string, bufferlist> *m,
 			      bool* pmore, optional_yield y) override;
+    virtual int omap_get_vals(const DoutPrefixProvider *dpp,
+			      std::vector<OmapRange>& ranges, uint64_t count,
+			      uint64_t max_aio, optional_yield y) override;
     virtual int omap_get_all(const DoutPrefixProvider *dpp, std::map<std::string, bufferlist> *m,
 			     optional_yield y) override;
     virtual int omap_get_vals_by_keys(const DoutPrefixProvider *dpp, const std::string& oid,
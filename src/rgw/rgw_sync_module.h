@@ -30,6 +30,11 @@ public:
   virtual RGWCoroutine *start_sync(RGWDataSyncCtx *sc) {
     return nullptr;
   }
+  /* whether sync_object() fetches the objects from the source zone, which
+   * can then read them ahead, many at a time */
+  virtual bool fetches_objects() {
+    return false;
+  }
   virtual RGWCoroutine *sync_object(RGWDataSyncCtx *sc, rgw_bucket_sync_pipe& sync_pipe, rgw_obj_key& key, std::optional<uint64_t> versioned_epoch, rgw_zone_set *zones_trace) = 0;
   virtual RGWCoroutine *remove_object(RGWDataSyncCtx *sc, rgw_bucket_sync_pipe& bucket_info, rgw_obj_key& key, real_time& mtime,
                                       bool versioned, uint64_t versioned_epoch, rgw_zone_set *zones_trace) = 0;
@@ -22,6 +22,7 @@
 #include "rgw_compression.h"
 #include "rgw_zone.h"
 #include "rgw_sal_rados.h"
+#include "rgw_perf_counters.h"
 #include "osd/osd_types.h"
 
 #include "services/svc_sys_obj.h"
@@ -264,6 +265,9 @@ int rgw_rados_operate(const DoutPrefixProvider *dpp, librados::IoCtx& ioctx, con
   // work on asio threads should be asynchronous, so warn when they block
   if (is_asio_thread) {
     ldpp_dout(dpp, 20) << "WARNING: blocking librados call" << dendl;
+    if (perfcounter) {
+      perfcounter->inc(l_rgw_blocking_rados);
+    }
   }
   return ioctx.operate(oid, op, nullptr, flags);
 }
@@ -281,6 +285,9 @@ int rgw_rados_operate(const DoutPrefixProvider *dpp, librados::IoCtx& ioctx, con
   }
   if (is_asio_thread) {
     ldpp_dout(dpp, 20) << "WARNING: blocking librados call" << dendl;
+    if (perfcounter) {
+      perfcounter->inc(l_rgw_blocking_rados);
+    }
   }
   return ioctx.operate(oid, op, flags);
 }
@@ -302,6 +309,9 @@ int rgw_rados_notify(const DoutPrefixProvider *dpp, librados::IoCtx& ioctx, cons
   }
   if (is_asio_thread) {
     ldpp_dout(dpp, 20) << "WARNING: blocking librados call" << dendl;
+    if (perfcounter) {
+      perfcounter->inc(l_rgw_blocking_rados);
+    }
   }
   return ioctx.notify2(oid, bl, timeout_ms, pbl);
 }
@@ -169,6 +169,76 @@ TEST_F(cls_rgw, index_multiple_obj_writers)
   }
 }
 
+TEST_F(cls_rgw, index_complete_ops)
+{
+  string bucket_oid = "bucket_complete_ops";
+
+  ObjectWriteOperation op;
+  cls_rgw_bucket_init_index(op);
+  ASSERT_EQ(0, ioctx.operate(bucket_oid, &op));
+
+  uint64_t obj_size = 1024;
+
+  std::vector<rgw_cls_obj_complete_op> ops;
+  for (int i = 0; i < NUM_OBJS; i++) {
+    rgw_cls_obj_complete_op c;
+    c.op = CLS_RGW_OP_ADD;
+    c.key = str_int("obj", i);
+    c.tag = str_int("tag", i);
+    c.ver.pool = ioctx.get_id();
+    c.ver.epoch = 1;
+    c.meta.category = RGWObjCategory::None;
+    c.meta.size = c.meta.accounted_size = obj_size;
+    c.log_op = true;
+
+    string loc = str_int("loc", i);
+    index_prepare(ioctx, bucket_oid, CLS_RGW_OP_ADD, c.tag, c.key, loc);
+    ops.push_back(c);
+  }
+
+  /* ops on the same name are refused, and nothing is applied */
+  {
+    auto dup = ops;
+    dup.push_back(ops.front());
+    ObjectWriteOperation op;
+    cls_rgw_bucket_complete_ops(op, dup);
+    ASSERT_EQ(-EINVAL, ioctx.operate(bucket_oid, &op));
+    test_stats(ioctx, bucket_oid, RGWObjCategory::None, 0, 0);
+  }
+
+  {
+    ObjectWriteOperation op;
+    cls_rgw_bucket_complete_ops(op, ops);
+    ASSERT_EQ(0, ioctx.operate(bucket_oid, &op));
+  }
+  test_stats(ioctx, bucket_oid, RGWObjCategory::None, NUM_OBJS,
+	     obj_size * NUM_OBJS);
+
+  /* each op got its own bilog entry */
+  {
+    cls_rgw_bi_log_list_ret bilog;
+    int retcode = 0;
+    librados::ObjectReadOperation op;
+    cls_rgw_bilog_list(op, "", 128, &bilog, &retcode);
+    ASSERT_EQ(0, ioctx.operate(bucket_oid, &op, nullptr));
+    ASSERT_EQ(0, retcode);
+    std::set<string> ids;
+    for (auto& e : bilog.entries) {
+      ids.insert(e.id);
+    }
+    ASSERT_EQ((size_t)NUM_OBJS, ids.size());
+  }
+
+  /* the same ops again fail, their tags are gone */
+  {
+    ObjectWriteOperation op;
+    cls_rgw_bucket_complete_ops(op, ops);
+    ASSERT_EQ(-EINVAL, ioctx.operate(bucket_oid, &op));
+  }
+  test_stats(ioctx, bucket_oid, RGWObjCategory::None, NUM_OBJS,
+	     obj_size * NUM_OBJS);
+}
+
 TEST_F(cls_rgw, index_remove_object)
 {
   string bucket_oid = str_int("bucket", 2);
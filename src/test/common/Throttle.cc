@@ -210,6 +210,32 @@ TEST_F(ThrottleTest, wait) {
   } while(!waited);
 }
 
+TEST_F(ThrottleTest, concurrent) {
+  // the unlocked get() and put() race with the waiters; nobody may be left
+  // behind, nor go over the max
+  const int64_t throttle_max = 4;
+  Throttle throttle(g_ceph_context, "throttle", throttle_max);
+  std::atomic<int64_t> over = 0;
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 8; ++i) {
+    threads.emplace_back([&throttle, &over, i] {
+      const int64_t c = 1 + i % 2;
+      for (int j = 0; j < 10000; ++j) {
+	throttle.get(c);
+	if (throttle.get_current() > throttle_max) {
+	  ++over;
+	}
+	throttle.put(c);
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  ASSERT_EQ(0, over);
+  ASSERT_EQ(0, throttle.get_current());
+}
+
 std::pair<double, std::chrono::duration<double> > test_backoff(
   double low_threshhold,
   double high_threshhold,
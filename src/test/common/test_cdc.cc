@@ -9,6 +9,7 @@
 #include "include/buffer.h"
 
 #include "common/CDC.h"
+#include "common/Clock.h"
 #include "gtest/gtest.h"
 
 class CDCTest : public ::testing::Test,
@@ -108,6 +109,48 @@ TEST_P(CDCTest, specific_result)
 }
 
 
+TEST_P(CDCTest, fragmented)
+{
+  // the windows and lanes spanning buffers give the same cut points
+  for (int bits = 9; bits <= 20; bits += 3) {
+    cdc->set_target_bits(bits, 0);
+    bufferlist bl;
+    generate_buffer(4*1024*1024, &bl, bits);
+    bufferlist frag;
+    for (unsigned off = 0, i = 0; off < bl.length(); ++i) {
+      unsigned len = std::min(bl.length() - off, (i * 7919) % 3000 + 1);
+      bufferlist piece;
+      piece.substr_of(bl, off, len);
+      piece.rebuild();
+      frag.claim_append(piece);
+      off += len;
+    }
+    bl.rebuild();
+    vector<pair<uint64_t, uint64_t>> chunks1, chunks2;
+    cdc->calc_chunks(bl, &chunks1);
+    cdc->calc_chunks(frag, &chunks2);
+    ASSERT_EQ(chunks1, chunks2);
+  }
+}
+
+TEST_P(CDCTest, performance)
+{
+  bufferlist bl;
+  generate_buffer(256*1024*1024, &bl);
+  bl.rebuild();
+  for (int bits : {12, 18}) {
+    cdc->set_target_bits(bits, 0);
+    vector<pair<uint64_t, uint64_t>> chunks;
+    utime_t start = ceph_clock_now();
+    cdc->calc_chunks(bl, &chunks);
+    utime_t end = ceph_clock_now();
+    cout << GetParam() << " " << (1 << bits) << " byte target: "
+	 << (double)bl.length() / (1024*1024) / (double)(end - start)
+	 << " MB/sec, " << chunks.size() << " chunks" << std::endl;
+  }
+}
+
+
 void do_size_histogram(CDC& cdc, bufferlist& bl,
 		       map<int,int> *h)
 {
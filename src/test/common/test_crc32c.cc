@@ -14,6 +14,8 @@
 #include "common/sctp_crc32.h"
 #include "common/crc32c_intel_baseline.h"
 #include "common/crc32c_aarch64.h"
+#include "common/crc32c_intel_avx512.h"
+#include "arch/intel.h"
 
 TEST(Crc32c, Small) {
   const char *a = "foo bar baz";
@@ -35,6 +37,74 @@ TEST(Crc32c, PartialWord) {
   free((void*)b);
 }
 
+TEST(Crc32c, Multi) {
+  const unsigned max_len = 9000;
+  const unsigned max_count = 19;
+  unsigned char *a = (unsigned char *)malloc(max_len * max_count);
+  for (unsigned i = 0; i < max_len * max_count; ++i)
+    a[i] = rand();
+  for (unsigned len : {1u, 7u, 8u, 9u, 100u, 4096u, 4099u, max_len}) {
+    for (unsigned count = 1; count <= max_count; ++count) {
+      const unsigned char *buffers[max_count];
+      uint32_t out[max_count];
+      for (unsigned i = 0; i < count; ++i)
+	buffers[i] = a + i * max_len + (max_len - len) * (i % 2);
+      ceph_crc32c_multi(1234, buffers, len, count, out);
+      for (unsigned i = 0; i < count; ++i)
+	ASSERT_EQ(ceph_crc32c(1234, buffers[i], len), out[i]);
+    }
+  }
+  free(a);
+}
+
+#if defined(__x86_64__)
+TEST(Crc32c, Avx512) {
+  if (!ceph_arch_intel_avx512 || !ceph_arch_intel_vpclmul) {
+    GTEST_SKIP() << "no VPCLMULQDQ";
+  }
+  const unsigned max_len = 4200;
+  unsigned char *a = (unsigned char *)malloc(max_len + 64);
+  for (unsigned i = 0; i < max_len + 64; ++i)
+    a[i] = rand();
+  for (unsigned len = 0; len <= max_len; ++len) {
+    unsigned off = len % 64;
+    uint32_t crc = len * 2654435761u;
+    ASSERT_EQ(ceph_crc32c_intel_baseline(crc, a + off, len),
+	      ceph_crc32c_intel_avx512(crc, a + off, len)) << len;
+  }
+  ASSERT_EQ(ceph_crc32c_intel_baseline(1234, nullptr, max_len),
+	    ceph_crc32c_intel_avx512(1234, nullptr, max_len));
+  free(a);
+}
+#endif
+
+TEST(Crc32c, MultiPerformance) {
+  const unsigned len = 4096;
+  const unsigned count = 2560;
+  unsigned char *a = (unsigned char *)malloc(len * count);
+  memset(a, 1, len * count);
+  const unsigned char *buffers[count];
+  uint32_t out[count];
+  for (unsigned i = 0; i < count; ++i)
+    buffers[i] = a + i * len;
+
+  utime_t start = ceph_clock_now();
+  for (int r = 0; r < 100; ++r)
+    for (unsigned i = 0; i < count; ++i)
+      out[i] = ceph_crc32c(0, buffers[i], len);
+  utime_t end = ceph_clock_now();
+  double serial = (double)(end - start);
+  start = ceph_clock_now();
+  for (int r = 0; r < 100; ++r)
+    ceph_crc32c_multi(0, buffers, len, count, out);
+  end = ceph_clock_now();
+  double multi = (double)(end - start);
+  double mb = 100.0 * len * count / (1024 * 1024);
+  std::cout << "4k blocks one by one " << mb / serial << " MB/sec, "
+	    << "at once " << mb / multi << " MB/sec" << std::endl;
+  free(a);
+}
+
 TEST(Crc32c, Big) {
   int len = 4096000;
   char *a = (char *)malloc(len);
@@ -84,6 +154,17 @@ TEST(Crc32c, Performance) {
     std::cout << "intel baseline = " << rate << " MB/sec" << std::endl;
     ASSERT_EQ(261108528u, val);
   }
+#if defined(__x86_64__)
+  if (ceph_arch_intel_avx512 && ceph_arch_intel_vpclmul)
+  {
+    utime_t start = ceph_clock_now();
+    unsigned val = ceph_crc32c_intel_avx512(0, (unsigned char *)a, len);
+    utime_t end = ceph_clock_now();
+    float rate = (float)len / (float)(1024*1024) / (float)(end - start);
+    std::cout << "intel avx512 = " << rate << " MB/sec" << std::endl;
+    ASSERT_EQ(261108528u, val);
+  }
+#endif
 #if defined(__arm__) || defined(__aarch64__)
   if (ceph_arch_aarch64_crc32) // Skip if CRC32C instructions are not defined.
   {
@@ -9,3 +9,54 @@ TEST(HObject, cmp)
   ASSERT_EQ(-1, cmp(c, d));
   ASSERT_EQ(-1, cmp(d, e));
 }
+
+TEST(HObject, sort_key)
+{
+  std::vector<hobject_t> objs;
+  for (int64_t pool : {INT64_MIN, (int64_t)-2, (int64_t)-1, (int64_t)0, (int64_t)3}) {
+    for (uint32_t hash : {0u, 1u, 0x80000000u, 0xffffffffu}) {
+      for (const char *ns : {"", "a", "ab"}) {
+	for (std::string name : {std::string(), std::string("a"),
+				 std::string("a\0", 2), std::string("a\1", 2),
+				 std::string("b")}) {
+	  for (const char *key : {"", "a", "b"}) {
+	    for (snapid_t snap : {snapid_t(0), snapid_t(5), snapid_t(CEPH_NOSNAP)}) {
+	      objs.emplace_back(object_t{name}, key, snap, hash, pool, ns);
+	    }
+	  }
+	}
+      }
+    }
+  }
+  objs.emplace_back(hobject_t::get_max());
+  objs.emplace_back();
+  for (auto& l : objs) {
+    std::string lkey = l.get_sort_key();
+    for (auto& r : objs) {
+      int c = lkey.compare(r.get_sort_key());
+      ASSERT_EQ(cmp(l, r), c < 0 ? -1 : c > 0 ? 1 : 0) << l << " vs " << r;
+    }
+  }
+}
+
+TEST(GHObject, sort_key)
+{
+  std::vector<ghobject_t> objs;
+  for (int8_t shard : {int8_t(-1), int8_t(0), int8_t(2)}) {
+    for (gen_t gen : {gen_t(0), gen_t(7), ghobject_t::NO_GEN}) {
+      for (const char *name : {"a", "b"}) {
+	objs.emplace_back(shard_id_t(shard), 1, 0x1234, "", name,
+			  CEPH_NOSNAP, gen);
+      }
+    }
+  }
+  objs.emplace_back(ghobject_t::get_max());
+  objs.emplace_back();
+  for (auto& l : objs) {
+    std::string lkey = l.get_sort_key();
+    for (auto& r : objs) {
+      int c = lkey.compare(r.get_sort_key());
+      ASSERT_EQ(cmp(l, r), c < 0 ? -1 : c > 0 ? 1 : 0) << l << " vs " << r;
+    }
+  }
+}
@@ -0,0 +1,74 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+/*
+ * Ceph - scalable distributed file system
+ *
+ * This is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License version 2.1, as published by the Free Software
+ * Foundation.  See file COPYING.
+ *
+ */
+
+#include "common/MissRatioCurve.h"
+#include "gtest/gtest.h"
+
+using PriorityCache::MissRatioCurve;
+
+// references cycling through the same keys all have the same distance
+static void cycle(MissRatioCurve& mrc, unsigned keys, unsigned passes,
+		  uint64_t bytes)
+{
+  for (unsigned p = 0; p < passes; ++p) {
+    for (unsigned k = 0; k < keys; ++k) {
+      mrc.access(k, bytes);
+    }
+  }
+}
+
+TEST(MissRatioCurve, cycle)
+{
+  MissRatioCurve mrc(4096, 0.1);
+  const unsigned keys = 10000;
+  const uint64_t bytes = 4096;
+  const uint64_t working_set = keys * bytes;
+  cycle(mrc, keys, 10, bytes);
+
+  double refs = mrc.get_references();
+  EXPECT_NEAR(keys * 10, refs, keys * 10 * 0.2);
+  EXPECT_GT(mrc.get_num_samples(), 0u);
+  // an LRU smaller than the working set never hits
+  EXPECT_LT(mrc.get_hits(working_set / 2), refs * 0.01);
+  // a larger one hits all but the first pass
+  EXPECT_GT(mrc.get_hits(working_set * 2), refs * 0.8);
+  EXPECT_NEAR(mrc.get_hits(working_set / 2, working_set * 2),
+	      mrc.get_hits(working_set * 2), 1);
+}
+
+TEST(MissRatioCurve, fixed_size)
+{
+  // far more keys than it tracks: the sampling rate goes down
+  MissRatioCurve mrc(100, 1.0);
+  const unsigned keys = 10000;
+  const uint64_t bytes = 65536;
+  cycle(mrc, keys, 10, bytes);
+
+  double refs = mrc.get_references();
+  EXPECT_LT(mrc.get_hits(keys * bytes / 2), refs * 0.05);
+  EXPECT_GT(mrc.get_hits(keys * bytes * 2), refs * 0.7);
+}
+
+TEST(MissRatioCurve, age)
+{
+  MissRatioCurve mrc(4096, 1.0);
+  cycle(mrc, 100, 2, 4096);
+  double refs = mrc.get_references();
+  double hits = mrc.get_hits(1 << 30);
+  EXPECT_NEAR(100, hits, 1);
+  mrc.age(0.5);
+  EXPECT_NEAR(refs / 2, mrc.get_references(), 1);
+  EXPECT_NEAR(hits / 2, mrc.get_hits(1 << 30), 1);
+  mrc.reset();
+  EXPECT_EQ(0, mrc.get_references());
+  EXPECT_EQ(0u, mrc.get_num_samples());
+}
@@ -0,0 +1,89 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+
+#include <future>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+#include <vector>
+
+#include "common/sharded_shared_mutex.h"
+#include "common/shunique_lock.h"
+
+#include "gtest/gtest.h"
+
+static bool try_lock_async(ceph::sharded_shared_mutex& sm) {
+  return std::async(std::launch::async, [&sm] {
+    if (!sm.try_lock())
+      return false;
+    sm.unlock();
+    return true;
+  }).get();
+}
+
+static bool try_lock_shared_async(ceph::sharded_shared_mutex& sm) {
+  return std::async(std::launch::async, [&sm] {
+    if (!sm.try_lock_shared())
+      return false;
+    sm.unlock_shared();
+    return true;
+  }).get();
+}
+
+TEST(ShardedSharedMutex, Unique) {
+  ceph::sharded_shared_mutex sm("test", 4);
+  ASSERT_EQ(4u, sm.get_num_shards());
+  {
+    std::unique_lock l(sm);
+    ASSERT_FALSE(try_lock_async(sm));
+    ASSERT_FALSE(try_lock_shared_async(sm));
+  }
+  ASSERT_TRUE(try_lock_async(sm));
+  ASSERT_TRUE(try_lock_shared_async(sm));
+}
+
+TEST(ShardedSharedMutex, Shared) {
+  ceph::sharded_shared_mutex sm("test", 4);
+  {
+    std::shared_lock l(sm);
+    ASSERT_FALSE(try_lock_async(sm));
+    ASSERT_TRUE(try_lock_shared_async(sm));
+  }
+  ASSERT_TRUE(try_lock_async(sm));
+}
+
+TEST(ShardedSharedMutex, ShuniqueLock) {
+  ceph::sharded_shared_mutex sm("test", 3);
+  ceph::shunique_lock l(sm, ceph::acquire_shared);
+  ASSERT_TRUE(l.owns_lock_shared());
+  ASSERT_FALSE(try_lock_async(sm));
+  l.unlock();
+  l.lock();
+  ASSERT_TRUE(l.owns_lock());
+  ASSERT_FALSE(try_lock_shared_async(sm));
+  l.unlock();
+  ASSERT_TRUE(try_lock_async(sm));
+}
+
+TEST(ShardedSharedMutex, ManyReaders) {
+  ceph::sharded_shared_mutex sm("test", 4);
+  int value = 0;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 8; ++t) {
+    threads.emplace_back([&sm, &value, t] {
+      for (int i = 0; i < 1000; ++i) {
+	if (t == 0) {
+	  std::unique_lock l(sm);
+	  ++value;
+	} else {
+	  std::shared_lock l(sm);
+	  ASSERT_GE(value, 0);
+	}
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  ASSERT_EQ(1000, value);
+}
@@ -0,0 +1,151 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+/*
+ * Ceph - scalable distributed file system
+ *
+ * This is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License version 2.1, as published by the Free Software
+ * Foundation. See file COPYING.
+ *
+ */
+
+#include <chrono>
+#include <map>
+#include <random>
+
+#include <gtest/gtest.h>
+
+#include "common/timer_wheel.h"
+
+using namespace std::literals;
+
+namespace {
+
+struct fake_clock {
+  using duration = std::chrono::nanoseconds;
+  using rep = duration::rep;
+  using period = duration::period;
+  using time_point = std::chrono::time_point<fake_clock>;
+  static constexpr bool is_steady = true;
+  static time_point t;
+  static time_point now() {
+    return t;
+  }
+};
+fake_clock::time_point fake_clock::t = fake_clock::time_point(1000h);
+
+using wheel_t = ceph::timer_wheel<fake_clock, int>;
+
+std::vector<int> pop_all(wheel_t& wheel, fake_clock::time_point now)
+{
+  std::vector<int> popped;
+  while (auto key = wheel.pop(now)) {
+    popped.push_back(*key);
+  }
+  return popped;
+}
+
+} // anonymous namespace
+
+TEST(TimerWheel, Order)
+{
+  auto now = fake_clock::now();
+  wheel_t wheel;
+  wheel.add(now + 10s, 1);
+  wheel.add(now + 1ms, 2);
+  wheel.add(now + 1ms, 3);
+  wheel.add(now + 100ns, 4);
+  wheel.add(now + 48h, 5);
+  wheel.add(now - 1s, 6);
+  ASSERT_EQ(6u, wheel.size());
+
+  ASSERT_EQ(std::vector<int>({6}), pop_all(wheel, now));
+  ASSERT_EQ(std::vector<int>({}), pop_all(wheel, now + 99ns));
+  ASSERT_EQ(std::vector<int>({4, 2, 3}), pop_all(wheel, now + 5ms));
+  ASSERT_EQ(std::vector<int>({1}), pop_all(wheel, now + 10s));
+  ASSERT_EQ(std::vector<int>({}), pop_all(wheel, now + 47h));
+  ASSERT_EQ(std::vector<int>({5}), pop_all(wheel, now + 49h));
+  ASSERT_TRUE(wheel.empty());
+  ASSERT_FALSE(wheel.next_wakeup());
+}
+
+TEST(TimerWheel, Cancel)
+{
+  auto now = fake_clock::now();
+  wheel_t wheel;
+  wheel.add(now + 1s, 1);
+  wheel.add(now + 2s, 2);
+  wheel.add(now - 1s, 3);
+  ASSERT_TRUE(wheel.cancel(1));
+  ASSERT_FALSE(wheel.cancel(1));
+  ASSERT_TRUE(wheel.cancel(3));
+  ASSERT_FALSE(wheel.contains(3));
+  ASSERT_EQ(std::vector<int>({2}), pop_all(wheel, now + 3s));
+  ASSERT_TRUE(wheel.empty());
+}
+
+TEST(TimerWheel, Random)
+{
+  // against a multimap, with the clock going forth in random steps
+  std::mt19937 rng(42);
+  wheel_t wheel;
+  std::multimap<std::pair<fake_clock::time_point, int>, int> expected;
+  std::map<int, fake_clock::time_point> scheduled;
+  auto now = fake_clock::now();
+  int next_key = 0;
+  for (int round = 0; round < 20000; ++round) {
+    switch (rng() % 4) {
+    case 0:
+    case 1:
+      {
+	static const std::chrono::nanoseconds ranges[] = {
+	  1ms, 100ms, 10s, 1h, 200h
+	};
+	auto range = ranges[rng() % std::size(ranges)];
+	auto when = now + std::chrono::nanoseconds(rng() % range.count());
+	wheel.add(when, next_key);
+	expected.emplace(std::make_pair(when, next_key), next_key);
+	scheduled[next_key] = when;
+	++next_key;
+      }
+      break;
+    case 2:
+      if (!scheduled.empty()) {
+	auto p = scheduled.lower_bound(rng() % next_key);
+	if (p == scheduled.end()) {
+	  p = scheduled.begin();
+	}
+	auto when = wheel.cancel(p->first);
+	ASSERT_TRUE(when);
+	ASSERT_EQ(p->second, *when);
+	expected.erase(std::make_pair(p->second, p->first));
+	scheduled.erase(p);
+      }
+      break;
+    case 3:
+      {
+	static const std::chrono::nanoseconds steps[] = {
+	  10us, 1ms, 50ms, 5s, 30min, 10h
+	};
+	auto wakeup = wheel.next_wakeup();
+	if (!expected.empty()) {
+	  ASSERT_TRUE(wakeup);
+	  // never later than the first event
+	  ASSERT_LE(*wakeup, expected.begin()->first.first);
+	}
+	now = std::max(now, rng() % 2 && wakeup ? *wakeup :
+		       now + steps[rng() % std::size(steps)]);
+	std::vector<int> want;
+	while (!expected.empty() && expected.begin()->first.first <= now) {
+	  want.push_back(expected.begin()->second);
+	  scheduled.erase(expected.begin()->second);
+	  expected.erase(expected.begin());
+	}
+	ASSERT_EQ(want, pop_all(wheel, now));
+      }
+      break;
+    }
+    ASSERT_EQ(expected.size(), wheel.size());
+  }
+}
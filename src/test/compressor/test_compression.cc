@@ -451,6 +451,59 @@ TEST(CompressionPlugin, all)
   }
 }
 
+TEST(ZstdCompressor, dictionary)
+{
+  CompressorRef zstd = Compressor::create(g_ceph_context, "zstd");
+  ASSERT_TRUE(zstd);
+  // small json-ish objects sharing most of their structure
+  auto make_sample = [](unsigned i) {
+    bufferlist bl;
+    bl.append("{\"bucket\": \"photos\", \"owner\": \"user" +
+	      std::to_string(i % 17) + "\", \"size\": " +
+	      std::to_string(i * 7919 % 100000) +
+	      ", \"content-type\": \"image/jpeg\", \"etag\": \"" +
+	      std::to_string(i * 104729) + "\", \"storage-class\": "
+	      "\"STANDARD\", \"acl\": \"private\"}");
+    return bl;
+  };
+  std::vector<bufferlist> samples;
+  for (unsigned i = 0; i < 1000; ++i) {
+    samples.push_back(make_sample(i));
+  }
+  bufferlist raw;
+  ASSERT_EQ(0, zstd->train_dictionary(samples, 4096, &raw));
+  ASSERT_GT(raw.length(), 0u);
+  Compressor::DictionaryRef dict = zstd->load_dictionary(raw);
+  ASSERT_TRUE(dict);
+  EXPECT_NE(0u, dict->get_id());
+
+  bufferlist orig = make_sample(5000);
+  bufferlist plain, with_dict;
+  boost::optional<int32_t> plain_message, dict_message;
+  ASSERT_EQ(0, zstd->compress(orig, plain, plain_message));
+  EXPECT_EQ(0u, zstd->get_dictionary_id(plain_message));
+  ASSERT_EQ(0, zstd->compress_with_dictionary(orig, with_dict, dict_message,
+					      *dict));
+  EXPECT_EQ(dict->get_id(), zstd->get_dictionary_id(dict_message));
+  EXPECT_LT(with_dict.length(), plain.length());
+
+  bufferlist decompressed;
+  auto p = with_dict.cbegin();
+  ASSERT_EQ(0, zstd->decompress_with_dictionary(p, with_dict.length(),
+						decompressed, dict_message,
+						*dict));
+  EXPECT_TRUE(decompressed.contents_equal(orig));
+
+  // without the dictionary the data cannot be recovered
+  decompressed.clear();
+  EXPECT_NE(0, zstd->decompress(with_dict, decompressed, dict_message));
+
+  // garbage is not a dictionary
+  bufferlist junk;
+  junk.append("not a dictionary");
+  EXPECT_FALSE(zstd->load_dictionary(junk));
+}
+
 #ifdef __x86_64__
 
 TEST(ZlibCompressor, isal_compress_zlib_decompress_random)
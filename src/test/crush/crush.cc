@@ -511,6 +511,24 @@ double calc_straw2_stddev(int *weights, int n, bool verbose)
   return stddev;
 }
 
+TEST_F(CRUSHTest, hash32_3_vec) {
+  // the vectorized hash used by straw2 must match the scalar one,
+  // including for the tail that does not fill a whole vector.
+  __u32 b[67];
+  __u32 out[67];
+  for (unsigned i = 0; i < std::size(b); ++i) {
+    b[i] = i * 2654435761u;
+  }
+  for (unsigned n = 0; n <= std::size(b); ++n) {
+    for (__u32 x : {0u, 1u, 12345u, 0xffffffffu}) {
+      crush_hash32_3_vec(CRUSH_HASH_RJENKINS1, x, b, n / 3, out, n);
+      for (unsigned i = 0; i < n; ++i) {
+	ASSERT_EQ(crush_hash32_3(CRUSH_HASH_RJENKINS1, x, b[i], n / 3), out[i]);
+      }
+    }
+  }
+}
+
 TEST_F(CRUSHTest, straw2_stddev)
 {
   int n = 15;
@@ -776,6 +776,97 @@ TEST_F(IsaErasureCodeTest, isa_cauchy_cache_trash)
   EXPECT_EQ(2516, tcache.getDecodingTableCacheSize(ErasureCodeIsaDefault::kCauchy));
 }
 
+TEST_F(IsaErasureCodeTest, encode_delta)
+{
+  const char *ms[] = { "1", "3" };
+  for (auto matrix : { ErasureCodeIsa::kVandermonde, ErasureCodeIsa::kCauchy }) {
+    for (auto m : ms) {
+      ErasureCodeIsaDefault Isa(tcache, matrix);
+      ErasureCodeProfile profile;
+      profile["k"] = "4";
+      profile["m"] = m;
+      Isa.init(profile, &cerr);
+      int n = Isa.get_chunk_count();
+
+      set<int> want_to_encode;
+      for (int i = 0; i < n; i++)
+        want_to_encode.insert(i);
+      bufferlist in;
+      for (int i = 0; i < 4096; i++)
+        in.append((char)(rand() & 0xff));
+      map<int, bufferlist> encoded;
+      EXPECT_EQ(0, Isa.encode(want_to_encode, in, &encoded));
+      unsigned length = encoded[0].length();
+
+      // overwrite the third data chunk and xor it with its old content
+      bufferlist delta;
+      bufferlist in2;
+      in2.substr_of(in, 0, 2 * length);
+      for (unsigned i = 0; i < length; i++) {
+        char c = (char)(rand() & 0xff);
+        in2.append(c);
+        delta.append((char)(c ^ encoded[2][i]));
+      }
+      in2.append(in.c_str() + 3 * length, in.length() - 3 * length);
+      map<int, bufferlist> reencoded;
+      EXPECT_EQ(0, Isa.encode(want_to_encode, in2, &reencoded));
+
+      map<int, bufferlist> coding;
+      for (int i = 4; i < n; i++)
+        coding[i].append(encoded[i].c_str(), length);
+      EXPECT_EQ(0, Isa.encode_delta(2, delta, &coding));
+      for (int i = 4; i < n; i++)
+        EXPECT_EQ(0, memcmp(coding[i].c_str(), reencoded[i].c_str(), length));
+    }
+  }
+}
+
+TEST_F(IsaErasureCodeTest, encode_decode_batch)
+{
+  ErasureCodeIsaDefault Isa(tcache);
+  ErasureCodeProfile profile;
+  profile["k"] = "4";
+  profile["m"] = "2";
+  Isa.init(profile, &cerr);
+
+  set<int> want_to_encode;
+  for (int i = 0; i < 6; i++)
+    want_to_encode.insert(i);
+  // enough small stripes to span several groups, and a last one of
+  // another size which is encoded on its own
+  vector<bufferlist> in(100);
+  for (auto &stripe : in)
+    for (int i = 0; i < 4096; i++)
+      stripe.append((char)(rand() & 0xff));
+  in.back().append("tail");
+
+  vector<map<int, bufferlist>> encoded;
+  EXPECT_EQ(0, Isa.encode_batch(want_to_encode, in, &encoded));
+  EXPECT_EQ(in.size(), encoded.size());
+  for (unsigned i = 0; i < in.size(); i++) {
+    map<int, bufferlist> expected;
+    EXPECT_EQ(0, Isa.encode(want_to_encode, in[i], &expected));
+    EXPECT_EQ(expected.size(), encoded[i].size());
+    for (auto &c : expected)
+      EXPECT_TRUE(c.second.contents_equal(encoded[i][c.first]));
+  }
+
+  // the same two chunks missing from every stripe but the last
+  vector<map<int, bufferlist>> degraded = encoded;
+  for (unsigned i = 0; i + 1 < degraded.size(); i++) {
+    degraded[i].erase(1);
+    degraded[i].erase(4);
+  }
+  degraded.back().erase(0);
+  set<int> want_to_read = want_to_encode;
+  vector<map<int, bufferlist>> decoded;
+  EXPECT_EQ(0, Isa.decode_batch(want_to_read, degraded, &decoded, 0));
+  EXPECT_EQ(encoded.size(), decoded.size());
+  for (unsigned i = 0; i < encoded.size(); i++)
+    for (auto c : want_to_read)
+      EXPECT_TRUE(encoded[i][c].contents_equal(decoded[i][c]));
+}
+
 TEST_F(IsaErasureCodeTest, isa_xor_codec)
 {
   // Test all possible failure scenarios and reconstruction cases for
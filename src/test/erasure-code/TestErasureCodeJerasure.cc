@@ -227,6 +227,48 @@ TYPED_TEST(ErasureCodeTest, minimum_to_decode)
   }
 }
 
+TYPED_TEST(ErasureCodeTest, encode_delta)
+{
+  TypeParam jerasure;
+  ErasureCodeProfile profile;
+  profile["k"] = "3";
+  profile["m"] = "2";
+  profile["packetsize"] = "8";
+  jerasure.init(profile, &cerr);
+
+  set<int> want_to_encode;
+  for (int i = 0; i < 5; i++)
+    want_to_encode.insert(i);
+  bufferlist in;
+  for (int i = 0; i < 1024; i++)
+    in.append((char)(rand() & 0xff));
+  map<int, bufferlist> encoded;
+  EXPECT_EQ(0, jerasure.encode(want_to_encode, in, &encoded));
+  unsigned length = encoded[0].length();
+
+  // overwrite the second data chunk and xor it with its old content
+  bufferlist delta;
+  bufferlist in2;
+  in2.substr_of(in, 0, length);
+  for (unsigned i = 0; i < length; i++) {
+    char c = (char)(rand() & 0xff);
+    in2.append(c);
+    delta.append((char)(c ^ encoded[1][i]));
+  }
+  in2.append(in.c_str() + 2 * length, in.length() - 2 * length);
+  map<int, bufferlist> reencoded;
+  EXPECT_EQ(0, jerasure.encode(want_to_encode, in2, &reencoded));
+
+  map<int, bufferlist> coding;
+  for (int i = 3; i < 5; i++)
+    coding[i].append(encoded[i].c_str(), length);
+  EXPECT_EQ(0, jerasure.encode_delta(1, delta, &coding));
+  for (int i = 3; i < 5; i++)
+    EXPECT_EQ(0, memcmp(coding[i].c_str(), reencoded[i].c_str(), length));
+
+  EXPECT_EQ(-EINVAL, jerasure.encode_delta(3, delta, &coding));
+}
+
 TEST(ErasureCodeTest, encode)
 {
   ErasureCodeJerasureReedSolomonVandermonde jerasure;
@@ -47,6 +47,9 @@ int ErasureCodeBench::setup(int argc, char** argv) {
      "size of the buffer to be encoded")
     ("iterations,i", po::value<int>()->default_value(1),
      "number of encode/decode runs")
+    ("batch,b", po::value<int>()->default_value(0),
+     "if set, encode/decode that many buffers of --size bytes per run "
+     "with a single encode_batch/decode_batch call")
     ("plugin,p", po::value<string>()->default_value("jerasure"),
      "erasure code plugin name")
     ("workload,w", po::value<string>()->default_value("encode"),
@@ -111,6 +114,7 @@ int ErasureCodeBench::setup(int argc, char** argv) {
 
   in_size = vm["size"].as<int>();
   max_iterations = vm["iterations"].as<int>();
+  batch = vm["batch"].as<int>();
   plugin = vm["plugin"].as<string>();
   workload = vm["workload"].as<string>();
   erasures = vm["erasures"].as<int>();
@@ -173,6 +177,8 @@ int ErasureCodeBench::encode()
   for (int i = 0; i < k + m; i++) {
     want_to_encode.insert(i);
   }
+  if (batch > 0)
+    return encode_batch(erasure_code, in, want_to_encode);
   utime_t begin_time = ceph_clock_now();
   for (int i = 0; i < max_iterations; i++) {
     map<int,bufferlist> encoded;
@@ -185,6 +191,24 @@ int ErasureCodeBench::encode()
   return 0;
 }
 
+int ErasureCodeBench::encode_batch(ErasureCodeInterfaceRef erasure_code,
+				   const bufferlist &in,
+				   const set<int> &want_to_encode)
+{
+  vector<bufferlist> stripes(batch, in);
+  utime_t begin_time = ceph_clock_now();
+  for (int i = 0; i < max_iterations; i++) {
+    vector<map<int,bufferlist>> encoded;
+    int code = erasure_code->encode_batch(want_to_encode, stripes, &encoded);
+    if (code)
+      return code;
+  }
+  utime_t end_time = ceph_clock_now();
+  cout << (end_time - begin_time) << "\t"
+       << (max_iterations * batch * (in_size / 1024)) << endl;
+  return 0;
+}
+
 static void display_chunks(const map<int,bufferlist> &chunks,
 			   unsigned int chunk_count) {
   cout << "chunks ";
@@ -285,6 +309,15 @@ int ErasureCodeBench::decode()
     display_chunks(encoded, erasure_code->get_chunk_count());
   }
 
+  if (batch > 0) {
+    if (exhaustive_erasures) {
+      cerr << "--batch does not support --erasures-generation exhaustive"
+	   << endl;
+      return -EINVAL;
+    }
+    return decode_batch(erasure_code, encoded, want_to_read);
+  }
+
   utime_t begin_time = ceph_clock_now();
   for (int i = 0; i < max_iterations; i++) {
     if (exhaustive_erasures) {
@@ -316,6 +349,36 @@ int ErasureCodeBench::decode()
   return 0;
 }
 
+int ErasureCodeBench::decode_batch(ErasureCodeInterfaceRef erasure_code,
+				   const map<int,bufferlist> &encoded,
+				   const set<int> &want_to_read)
+{
+  utime_t begin_time = ceph_clock_now();
+  for (int i = 0; i < max_iterations; i++) {
+    // all the stripes of a batch miss the same chunks, as the stripes
+    // of an object read from the same shards do
+    map<int,bufferlist> chunks = encoded;
+    if (erased.empty()) {
+      for (int j = 0; j < erasures; j++) {
+	int erasure;
+	do {
+	  erasure = rand() % ( k + m );
+	} while(chunks.count(erasure) == 0);
+	chunks.erase(erasure);
+      }
+    }
+    vector<map<int,bufferlist>> stripes(batch, chunks);
+    vector<map<int,bufferlist>> decoded;
+    int code = erasure_code->decode_batch(want_to_read, stripes, &decoded, 0);
+    if (code)
+      return code;
+  }
+  utime_t end_time = ceph_clock_now();
+  cout << (end_time - begin_time) << "\t"
+       << (max_iterations * batch * (in_size / 1024)) << endl;
+  return 0;
+}
+
 int main(int argc, char** argv) {
   ErasureCodeBench ecbench;
   try {
@@ -25,6 +25,7 @@ using namespace std;
 class ErasureCodeBench {
   int in_size;
   int max_iterations;
+  int batch;
   int erasures;
   int k;
   int m;
@@ -48,7 +49,13 @@ public:
 		      unsigned want_erasures,
 		      ErasureCodeInterfaceRef erasure_code);
   int decode();
+  int decode_batch(ErasureCodeInterfaceRef erasure_code,
+		   const map<int,bufferlist> &encoded,
+		   const set<int> &want_to_read);
   int encode();
+  int encode_batch(ErasureCodeInterfaceRef erasure_code,
+		   const bufferlist &in,
+		   const set<int> &want_to_encode);
 };
 
 #endif
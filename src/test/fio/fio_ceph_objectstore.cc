@@ -8,12 +8,17 @@
  *
  */
 
+#include <deque>
 #include <memory>
 #include <system_error>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 #include <fstream>
 
 #include "os/ObjectStore.h"
+#include "os/TransactionTrace.h"
 #include "global/global_init.h"
 #include "common/errno.h"
 #include "include/intarith.h"
@@ -41,6 +46,7 @@ struct Options {
   char* perf_output_file;
   char* throttle_values;
   char* deferred_throttle_values;
+  char* trace_file;
   unsigned long long
     cycle_throttle_period,
     oi_attr_len_low,
@@ -57,6 +63,7 @@ struct Options {
   unsigned single_pool_mode;
   unsigned preallocate_files;
   unsigned check_files;
+  unsigned trace_speedup;
 };
 
 template <class Func> // void Func(fio_option&)
@@ -193,6 +200,23 @@ static std::vector<fio_option> ceph_options{
     o.def    = "0";
     o.minval = 0;
   }),
+  make_option([] (fio_option& o) {
+    o.name   = "trace_file";
+    o.lname  = "transaction trace to replay";
+    o.type   = FIO_OPT_STR_STORE;
+    o.help   = "Replay the transactions of a bluestore_trace_file instead of the job's writes";
+    o.off1   = offsetof(Options, trace_file);
+    o.def    = 0;
+  }),
+  make_option([] (fio_option& o) {
+    o.name   = "trace_speedup";
+    o.lname  = "trace replay speedup";
+    o.type   = FIO_OPT_INT;
+    o.help   = "Replay the trace this many times faster than it was captured, 0 for as fast as possible";
+    o.off1   = offsetof(Options, trace_speedup);
+    o.def    = "1";
+    o.minval = 0;
+  }),
   {} // fio expects a 'null'-terminated list
 };
 
@@ -466,12 +490,24 @@ struct Object {
       coll(coll) {}
 };
 
+/// completion context for ObjectStore::queue_transaction()
+class UnitComplete : public Context {
+  io_u* u;
+ public:
+  explicit UnitComplete(io_u* u) : u(u) {}
+  void finish(int r) {
+    // mark the pointer to indicate completion for fio_ceph_os_getevents()
+    u->engine_data = reinterpret_cast<void*>(1ull);
+  }
+};
+
 /// treat each fio job either like a separate pool with its own collections and objects
 /// or just a client using its own objects from the shared pool
 struct Job {
   Engine* engine; //< shared ptr to the global Engine
   const unsigned subjob_number; //< subjob num
   std::vector<Collection> collections; //< job's private collections to spread objects over
+  std::vector<Collection>* colls; //< the collections the objects are spread over
   std::vector<Object> objects; //< associate an object with each fio_file
   std::vector<io_u*> events; //< completions for fio_ceph_os_event()
   const bool unlink; //< unlink objects on destruction
@@ -485,6 +521,25 @@ struct Job {
   mono_clock::time_point last = ceph::mono_clock::zero();
   unsigned index = 0;
 
+  /// replay of the trace_file option, if any
+  std::unique_ptr<ceph::os::TransactionTraceReader> trace;
+  const unsigned trace_speedup;
+  mono_clock::time_point trace_start;
+  uint64_t trace_stamp_base = 0; //< where the trace started over from
+  uint64_t trace_last_stamp = 0;
+  /// the traced collections and objects, by hash, and those of ours they
+  /// are replayed against
+  std::unordered_map<uint64_t, Collection*> trace_colls;
+  std::unordered_map<uint64_t, Object> trace_objects;
+  std::unordered_set<uint64_t> trace_existing;
+  std::unordered_map<uint64_t, std::deque<uint64_t>> trace_omap_keys;
+  uint64_t trace_omap_seq = 0;
+  bufferptr trace_data; //< garbage to write, grown as needed
+
+  Object& get_trace_object(uint64_t cid, uint64_t oid);
+  bufferptr get_trace_data(uint64_t len);
+  int queue_trace(io_u* u);
+
   static vector<unsigned> parse_throttle_str(const char *p) {
     vector<unsigned> ret;
     if (p == nullptr) {
@@ -513,7 +568,8 @@ Job::Job(Engine* engine, const thread_data* td)
     deferred_throttle_values(
       parse_throttle_str(static_cast<Options*>(td->eo)->deferred_throttle_values)),
     cycle_throttle_period(
-      static_cast<Options*>(td->eo)->cycle_throttle_period)
+      static_cast<Options*>(td->eo)->cycle_throttle_period),
+    trace_speedup(static_cast<Options*>(td->eo)->trace_speedup)
 {
   engine->ref();
   auto o = static_cast<Options*>(td->eo);
@@ -524,7 +580,6 @@ Job::Job(Engine* engine, const thread_data* td)
   max_data = max(max_data, o->_fastinfo_omap_len_high);
   one_for_all_data = buffer::create(max_data);
 
-  std::vector<Collection>* colls;
   // create private collections up to osd_pool_default_pg_num
   if (!o->single_pool_mode) {
     uint64_t count = g_conf().get_val<uint64_t>("osd_pool_default_pg_num");
@@ -588,6 +643,17 @@ Job::Job(Engine* engine, const thread_data* td)
     derr << "fio_ceph_objectstore preallocated " << checked_or_preallocated
 	 << " files"<< dendl;
   }
+  if (o->trace_file) {
+    trace = std::make_unique<ceph::os::TransactionTraceReader>();
+    int r = trace->open(o->trace_file);
+    if (r < 0) {
+      engine->deref();
+      throw std::system_error(-r, std::system_category(),
+			      "job init -- cannot open trace");
+    }
+    trace_data = buffer::create(CEPH_PAGE_SIZE);
+    trace_start = ceph::mono_clock::now();
+  }
 }
 
 Job::~Job()
@@ -609,6 +675,189 @@ Job::~Job()
   engine->deref();
 }
 
+Object& Job::get_trace_object(uint64_t cid, uint64_t oid)
+{
+  auto p = trace_objects.find(oid);
+  if (p != trace_objects.end()) {
+    return p->second;
+  }
+  // spread the traced collections over ours as they show up
+  auto [c, added] = trace_colls.try_emplace(cid, nullptr);
+  if (added) {
+    c->second = &(*colls)[(trace_colls.size() - 1) % colls->size()];
+  }
+  char name[32];
+  snprintf(name, sizeof(name), "trace_%016llx", (unsigned long long)oid);
+  return trace_objects.emplace(
+    std::piecewise_construct,
+    std::forward_as_tuple(oid),
+    std::forward_as_tuple(name, *c->second)).first->second;
+}
+
+bufferptr Job::get_trace_data(uint64_t len)
+{
+  if (trace_data.length() < len) {
+    // fill with the garbage as we do not care of the actual content...
+    trace_data = buffer::create(len);
+  }
+  return bufferptr(trace_data, 0, len);
+}
+
+/// queue the next transaction of the trace once it is due, remapped to our
+/// collections and objects
+int Job::queue_trace(io_u* u)
+{
+  using ceph::os::Transaction;
+  ceph::os::trace_txn_t txn;
+  int r = trace->next(&txn);
+  if (r == 0) {
+    // start over, carrying on from where the trace stopped
+    trace_stamp_base = trace_last_stamp;
+    r = trace->rewind();
+    if (r == 0) {
+      r = trace->next(&txn);
+      if (r == 0) {
+	r = -ENODATA; // an empty trace
+      }
+    }
+  }
+  if (r < 0) {
+    return r;
+  }
+  trace_last_stamp = trace_stamp_base + txn.stamp;
+  if (trace_speedup) {
+    std::this_thread::sleep_until(
+      trace_start + std::chrono::microseconds(trace_last_stamp / trace_speedup));
+  }
+
+  // the attrs and omap values share what the trace saw of them
+  unsigned meta_ops = std::count_if(
+    txn.ops.begin(), txn.ops.end(), [](auto& op) {
+      return op.op == Transaction::OP_SETATTR ||
+	op.op == Transaction::OP_SETATTRS ||
+	op.op == Transaction::OP_OMAP_SETKEYS ||
+	op.op == Transaction::OP_OMAP_SETHEADER;
+    });
+  const uint64_t meta_len = meta_ops ? txn.meta_bytes / meta_ops : 0;
+  auto omap_key = [](uint64_t seq) {
+    char key[64];
+    snprintf(key, sizeof(key), "trace_%020llu", (unsigned long long)seq);
+    return std::string(key);
+  };
+
+  ObjectStore::Transaction t;
+  Collection* coll = nullptr;
+  for (auto& op : txn.ops) {
+    auto& object = get_trace_object(op.cid, op.oid);
+    const coll_t& cid = object.coll.cid;
+    if (!coll) {
+      coll = &object.coll;
+    }
+    if (op.op == Transaction::OP_TOUCH ||
+	op.op == Transaction::OP_WRITE ||
+	op.op == Transaction::OP_ZERO) {
+      trace_existing.insert(op.oid);
+    } else if (op.op != Transaction::OP_REMOVE &&
+	       trace_existing.insert(op.oid).second) {
+      // created before the trace started
+      t.touch(cid, object.oid);
+    }
+    switch (op.op) {
+    case Transaction::OP_TOUCH:
+      t.touch(cid, object.oid);
+      break;
+    case Transaction::OP_WRITE:
+      {
+	bufferlist bl;
+	bl.append(get_trace_data(op.len));
+	t.write(cid, object.oid, op.off, op.len, bl);
+      }
+      break;
+    case Transaction::OP_ZERO:
+      t.zero(cid, object.oid, op.off, op.len);
+      break;
+    case Transaction::OP_TRUNCATE:
+      t.truncate(cid, object.oid, op.off);
+      break;
+    case Transaction::OP_REMOVE:
+      t.remove(cid, object.oid);
+      trace_existing.erase(op.oid);
+      trace_omap_keys.erase(op.oid);
+      break;
+    case Transaction::OP_SETATTR:
+    case Transaction::OP_SETATTRS:
+      {
+	bufferlist bl;
+	bl.append(get_trace_data(meta_len));
+	t.setattr(cid, object.oid, "_", bl);
+      }
+      break;
+    case Transaction::OP_RMATTR:
+      t.rmattr(cid, object.oid, "_");
+      break;
+    case Transaction::OP_RMATTRS:
+      t.rmattrs(cid, object.oid);
+      break;
+    case Transaction::OP_CLONE:
+    case Transaction::OP_CLONERANGE2:
+      {
+	auto& dest = get_trace_object(op.cid, op.dest_oid);
+	if (&dest.coll != &object.coll) {
+	  break;
+	}
+	if (op.op == Transaction::OP_CLONE) {
+	  t.clone(cid, object.oid, dest.oid);
+	} else {
+	  t.clone_range(cid, object.oid, dest.oid, op.off, op.len, op.dest_off);
+	}
+	trace_existing.insert(op.dest_oid);
+      }
+      break;
+    case Transaction::OP_SETALLOCHINT:
+      t.set_alloc_hint(cid, object.oid, op.off, op.len, 0);
+      break;
+    case Transaction::OP_OMAP_CLEAR:
+      t.omap_clear(cid, object.oid);
+      trace_omap_keys.erase(op.oid);
+      break;
+    case Transaction::OP_OMAP_SETKEYS:
+      {
+	std::map<std::string, bufferlist> keys;
+	keys[omap_key(trace_omap_seq)].append(get_trace_data(meta_len));
+	trace_omap_keys[op.oid].push_back(trace_omap_seq++);
+	t.omap_setkeys(cid, object.oid, keys);
+      }
+      break;
+    case Transaction::OP_OMAP_RMKEYS:
+    case Transaction::OP_OMAP_RMKEYRANGE:
+      {
+	// like the pg log trimming, the oldest key goes first
+	auto p = trace_omap_keys.find(op.oid);
+	if (p == trace_omap_keys.end() || p->second.empty()) {
+	  break;
+	}
+	t.omap_rmkeys(cid, object.oid,
+		      std::set<std::string>{omap_key(p->second.front())});
+	p->second.pop_front();
+      }
+      break;
+    case Transaction::OP_OMAP_SETHEADER:
+      {
+	bufferlist bl;
+	bl.append(get_trace_data(meta_len));
+	t.omap_setheader(cid, object.oid, bl);
+      }
+      break;
+    }
+  }
+  if (!coll) {
+    coll = &colls->front();
+  }
+  t.register_on_commit(new UnitComplete(u));
+  r = engine->os->queue_transaction(coll->ch, std::move(t));
+  return r;
+}
+
 void Job::check_throttle()
 {
   if (subjob_number != 0)
@@ -710,17 +959,6 @@ int fio_ceph_os_getevents(thread_data* td, unsigned int min,
   return events;
 }
 
-/// completion context for ObjectStore::queue_transaction()
-class UnitComplete : public Context {
-  io_u* u;
- public:
-  explicit UnitComplete(io_u* u) : u(u) {}
-  void finish(int r) {
-    // mark the pointer to indicate completion for fio_ceph_os_getevents()
-    u->engine_data = reinterpret_cast<void*>(1ull);
-  }
-};
-
 enum fio_q_status fio_ceph_os_queue(thread_data* td, io_u* u)
 {
   fio_ro_check(td, u);
@@ -735,6 +973,17 @@ enum fio_q_status fio_ceph_os_queue(thread_data* td, io_u* u)
 
   job->check_throttle();
 
+  if (job->trace) {
+    // the trace takes the place of the job's own writes and reads
+    int r = job->queue_trace(u);
+    if (r < 0) {
+      u->error = -r;
+      td_verror(td, u->error, "xfer");
+      return FIO_Q_COMPLETED;
+    }
+    return FIO_Q_QUEUED;
+  }
+
   if (u->ddir == DDIR_WRITE) {
     // provide a hint if we're likely to read this data back
     const int flags = td_rw(td) ? CEPH_OSD_OP_FLAG_FADVISE_WILLNEED : 0;
@@ -381,6 +381,67 @@ out:
   ASSERT_EQ(0, rc);
 }
 
+TEST_F(CephSQLiteTest, StriperCache) {
+  static const uint64_t bs = SimpleRADOSStriper::cache_block_size;
+  librados::IoCtx ioctx;
+  ASSERT_EQ(0, cluster.ioctx_create(pool.c_str(), ioctx));
+  auto name = fmt::format("{}.striper", uuid.to_string());
+
+  std::string data(3*bs+100, '\0');
+  for (size_t i = 0; i < data.size(); ++i) {
+    data[i] = 'a' + i%26;
+  }
+
+  {
+    SimpleRADOSStriper rs(ioctx, name);
+    rs.set_cache_size(1<<20);
+    rs.set_readahead_max(1<<18);
+    ASSERT_EQ(0, rs.create());
+    ASSERT_EQ(0, rs.lock(0));
+    ASSERT_EQ((ssize_t)data.size(), rs.write(data.data(), data.size(), 0));
+    /* overwrite across a block boundary, read back from the cache */
+    std::string patch(200, 'Z');
+    ASSERT_EQ((ssize_t)patch.size(), rs.write(patch.data(), patch.size(), bs-100));
+    data.replace(bs-100, patch.size(), patch);
+    std::string out(data.size(), '\0');
+    ASSERT_EQ((ssize_t)data.size(), rs.read(out.data(), out.size(), 0));
+    ASSERT_EQ(data, out);
+    ASSERT_EQ(0, rs.flush());
+    ASSERT_EQ(0, rs.unlock());
+  }
+
+  {
+    /* uncached, what was written back */
+    SimpleRADOSStriper rs(ioctx, name);
+    ASSERT_EQ(0, rs.lock(0));
+    uint64_t size;
+    ASSERT_EQ(0, rs.stat(&size));
+    ASSERT_EQ(data.size(), size);
+    std::string out(data.size(), '\0');
+    ASSERT_EQ((ssize_t)data.size(), rs.read(out.data(), out.size(), 0));
+    ASSERT_EQ(data, out);
+    ASSERT_EQ(0, rs.unlock());
+  }
+
+  {
+    /* sequential reads with readahead, then a truncate */
+    SimpleRADOSStriper rs(ioctx, name);
+    rs.set_cache_size(1<<20);
+    rs.set_readahead_max(1<<18);
+    ASSERT_EQ(0, rs.lock(0));
+    std::string out(data.size(), '\0');
+    for (size_t off = 0; off < data.size(); off += 4096) {
+      auto len = std::min<size_t>(4096, data.size()-off);
+      ASSERT_EQ((ssize_t)len, rs.read(out.data()+off, len, off));
+    }
+    ASSERT_EQ(data, out);
+    ASSERT_EQ(0, rs.truncate(bs+10));
+    ASSERT_EQ(10, rs.read(out.data(), 4096, bs));
+    ASSERT_EQ(0, memcmp(out.data(), data.data()+bs, 10));
+    ASSERT_EQ(0, rs.unlock());
+  }
+}
+
 TEST_F(CephSQLiteTest, InsertExclusiveRate) {
   using clock = ceph::coarse_mono_clock;
   using time = ceph::coarse_mono_time;
@@ -765,6 +765,56 @@ TEST(LibRadosAio, RoundTripWriteFullPP2)
   destroy_one_pool_pp(pool_name, cluster);
 }
 
+TEST(LibRadosAio, OperateBatchPP) {
+  AioTestDataPP test_data;
+  ASSERT_EQ("", test_data.init());
+  constexpr int num_objects = 32;
+  std::vector<std::string> oids;
+  std::vector<std::unique_ptr<AioCompletion>> completions;
+  std::vector<AioCompletion*> cs;
+  std::vector<ObjectWriteOperation> wops(num_objects);
+  std::vector<ObjectWriteOperation*> pwops;
+  for (int i = 0; i < num_objects; ++i) {
+    oids.push_back("batch" + std::to_string(i));
+    completions.emplace_back(Rados::aio_create_completion());
+    cs.push_back(completions.back().get());
+    bufferlist bl;
+    bl.append(oids.back());
+    wops[i].write_full(bl);
+    pwops.push_back(&wops[i]);
+  }
+  // the vectors must match
+  ASSERT_EQ(-EINVAL, test_data.m_ioctx.aio_operate(
+    oids, std::vector<AioCompletion*>(cs.begin(), cs.end() - 1), pwops));
+  ASSERT_EQ(0, test_data.m_ioctx.aio_operate(oids, cs, pwops));
+  for (auto c : cs) {
+    TestAlarm alarm;
+    ASSERT_EQ(0, c->wait_for_complete());
+    ASSERT_EQ(0, c->get_return_value());
+  }
+
+  completions.clear();
+  cs.clear();
+  std::vector<ObjectReadOperation> rops(num_objects);
+  std::vector<ObjectReadOperation*> props;
+  std::vector<bufferlist> bls(num_objects);
+  std::vector<bufferlist*> pbls;
+  for (int i = 0; i < num_objects; ++i) {
+    completions.emplace_back(Rados::aio_create_completion());
+    cs.push_back(completions.back().get());
+    rops[i].read(0, 0, nullptr, nullptr);
+    props.push_back(&rops[i]);
+    pbls.push_back(&bls[i]);
+  }
+  ASSERT_EQ(0, test_data.m_ioctx.aio_operate(oids, cs, props, pbls));
+  for (int i = 0; i < num_objects; ++i) {
+    TestAlarm alarm;
+    ASSERT_EQ(0, cs[i]->wait_for_complete());
+    ASSERT_EQ(0, cs[i]->get_return_value());
+    ASSERT_EQ(oids[i], bls[i].to_str());
+  }
+}
+
 TEST(LibRadosAio, RoundTripWriteSamePP) {
   AioTestDataPP test_data;
   ASSERT_EQ("", test_data.init());
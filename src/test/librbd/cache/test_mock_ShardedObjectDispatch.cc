@@ -0,0 +1,299 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+
+#include "test/librbd/test_mock_fixture.h"
+#include "test/librbd/test_support.h"
+#include "test/librbd/mock/MockImageCtx.h"
+#include "test/librbd/mock/MockSafeTimer.h"
+#include "include/rbd/librbd.hpp"
+#include "librbd/cache/ShardedObjectDispatch.h"
+#include "librbd/io/ObjectDispatchSpec.h"
+
+namespace librbd {
+namespace {
+
+struct MockTestImageCtx : public MockImageCtx {
+  MockTestImageCtx(ImageCtx &image_ctx) : MockImageCtx(image_ctx) {
+  }
+};
+
+struct MockContext : public C_SaferCond  {
+  MOCK_METHOD1(complete, void(int));
+  MOCK_METHOD1(finish, void(int));
+
+  void do_complete(int r) {
+    C_SaferCond::complete(r);
+  }
+};
+
+} // anonymous namespace
+
+namespace io {
+
+template <>
+struct TypeTraits<MockTestImageCtx> {
+  typedef ::MockSafeTimer SafeTimer;
+};
+
+} // namespace io
+} // namespace librbd
+
+#include "librbd/cache/ShardedObjectDispatch.cc"
+
+namespace librbd {
+namespace cache {
+
+using ::testing::_;
+using ::testing::InSequence;
+using ::testing::Invoke;
+
+struct TestMockCacheShardedObjectDispatch : public TestMockFixture {
+  typedef ShardedObjectDispatch<librbd::MockTestImageCtx> MockShardedObjectDispatch;
+
+  MockSafeTimer m_mock_timer;
+  ceph::mutex m_mock_timer_lock =
+    ceph::make_mutex("TestMockCacheShardedObjectDispatch::Mutex");
+
+  TestMockCacheShardedObjectDispatch() {
+    MockTestImageCtx::set_timer_instance(&m_mock_timer, &m_mock_timer_lock);
+  }
+
+  void expect_op_work_queue(MockTestImageCtx& mock_image_ctx) {
+    EXPECT_CALL(*mock_image_ctx.op_work_queue, queue(_, _))
+      .WillRepeatedly(Invoke([](Context* ctx, int r) {
+                        ctx->complete(r);
+                      }));
+  }
+
+  void expect_context_complete(MockContext& mock_context, int r) {
+    EXPECT_CALL(mock_context, complete(r))
+      .WillOnce(Invoke([&mock_context](int r) {
+                  mock_context.do_complete(r);
+                }));
+  }
+
+  void expect_add_timer_task(Context **timer_task) {
+    EXPECT_CALL(m_mock_timer, add_event_after(_, _))
+      .WillOnce(Invoke([timer_task](double, Context *task) {
+                  *timer_task = task;
+                  return task;
+                }));
+  }
+
+  void expect_writeback(MockTestImageCtx& mock_image_ctx, uint64_t object_no,
+                        uint64_t object_off, const bufferlist& data, int r) {
+    EXPECT_CALL(*mock_image_ctx.io_object_dispatcher, send(_))
+      .WillOnce(Invoke([&mock_image_ctx, object_no, object_off, data, r]
+                       (io::ObjectDispatchSpec* spec) {
+                  auto write = boost::get<io::ObjectDispatchSpec::WriteRequest>(
+                    &spec->request);
+                  ASSERT_TRUE(write != nullptr);
+                  ASSERT_EQ(object_no, write->object_no);
+                  ASSERT_EQ(object_off, write->object_off);
+                  ASSERT_TRUE(data.contents_equal(write->data));
+
+                  spec->dispatch_result = io::DISPATCH_RESULT_COMPLETE;
+                  mock_image_ctx.image_ctx->op_work_queue->queue(
+                    &spec->dispatcher_ctx, r);
+                }));
+  }
+};
+
+TEST_F(TestMockCacheShardedObjectDispatch, WriteThrough) {
+  librbd::ImageCtx *ictx;
+  ASSERT_EQ(0, open_image(m_image_name, &ictx));
+
+  MockTestImageCtx mock_image_ctx(*ictx);
+  MockShardedObjectDispatch object_dispatch(&mock_image_ctx, 0, false);
+
+  InSequence seq;
+
+  bufferlist data;
+  data.append(std::string(4096, '1'));
+
+  io::DispatchResult dispatch_result;
+  MockContext finish_ctx;
+  MockContext dispatch_ctx;
+  Context* finish_ctx_ptr = &finish_ctx;
+  ASSERT_FALSE(object_dispatch.write(0, 0, std::move(data), {}, 0, 0,
+                                     std::nullopt, {}, nullptr, nullptr,
+                                     &dispatch_result, &finish_ctx_ptr,
+                                     &dispatch_ctx));
+  ASSERT_NE(finish_ctx_ptr, &finish_ctx);
+
+  expect_context_complete(finish_ctx, 0);
+  finish_ctx_ptr->complete(0);
+  ASSERT_EQ(0, finish_ctx.wait());
+}
+
+TEST_F(TestMockCacheShardedObjectDispatch, ReadPopulates) {
+  librbd::ImageCtx *ictx;
+  ASSERT_EQ(0, open_image(m_image_name, &ictx));
+
+  MockTestImageCtx mock_image_ctx(*ictx);
+  MockShardedObjectDispatch object_dispatch(&mock_image_ctx, 0, false);
+  expect_op_work_queue(mock_image_ctx);
+
+  InSequence seq;
+
+  bufferlist data;
+  data.append(std::string(4096, '1'));
+  auto io_context = mock_image_ctx.get_data_io_context();
+
+  io::ReadExtents extents = {{0, 4096}};
+  io::DispatchResult dispatch_result;
+  MockContext finish_ctx;
+  MockContext dispatch_ctx;
+  Context* finish_ctx_ptr = &finish_ctx;
+  ASSERT_FALSE(object_dispatch.read(0, &extents, io_context, 0, 0, {},
+                                    nullptr, nullptr, &dispatch_result,
+                                    &finish_ctx_ptr, &dispatch_ctx));
+  ASSERT_NE(finish_ctx_ptr, &finish_ctx);
+
+  expect_context_complete(finish_ctx, 0);
+  extents[0].bl = data;
+  finish_ctx_ptr->complete(0);
+  ASSERT_EQ(0, finish_ctx.wait());
+
+  expect_context_complete(dispatch_ctx, 0);
+  io::ReadExtents hit_extents = {{1024, 2048}};
+  finish_ctx_ptr = &finish_ctx;
+  ASSERT_TRUE(object_dispatch.read(0, &hit_extents, io_context, 0, 0, {},
+                                   nullptr, nullptr, &dispatch_result,
+                                   &finish_ctx_ptr, &dispatch_ctx));
+  ASSERT_EQ(io::DISPATCH_RESULT_COMPLETE, dispatch_result);
+  ASSERT_EQ(0, dispatch_ctx.wait());
+
+  bufferlist expected_bl;
+  expected_bl.substr_of(data, 1024, 2048);
+  ASSERT_TRUE(expected_bl.contents_equal(hit_extents[0].bl));
+}
+
+TEST_F(TestMockCacheShardedObjectDispatch, WriteBack) {
+  librbd::ImageCtx *ictx;
+  ASSERT_EQ(0, open_image(m_image_name, &ictx));
+
+  MockTestImageCtx mock_image_ctx(*ictx);
+  MockShardedObjectDispatch object_dispatch(&mock_image_ctx, 16384, false);
+  expect_op_work_queue(mock_image_ctx);
+
+  InSequence seq;
+
+  bufferlist data1;
+  data1.append(std::string(4096, '1'));
+  bufferlist data2;
+  data2.append(std::string(4096, '2'));
+  auto io_context = mock_image_ctx.get_data_io_context();
+
+  io::DispatchResult dispatch_result;
+  MockContext finish_ctx;
+  MockContext dispatch_ctx1;
+  Context* finish_ctx_ptr = &finish_ctx;
+
+  Context* timer_task = nullptr;
+  expect_add_timer_task(&timer_task);
+  expect_context_complete(dispatch_ctx1, 0);
+  ASSERT_TRUE(object_dispatch.write(0, 0, bufferlist{data1}, io_context, 0, 0,
+                                    std::nullopt, {}, nullptr, nullptr,
+                                    &dispatch_result, &finish_ctx_ptr,
+                                    &dispatch_ctx1));
+  ASSERT_EQ(io::DISPATCH_RESULT_COMPLETE, dispatch_result);
+  ASSERT_EQ(0, dispatch_ctx1.wait());
+
+  MockContext dispatch_ctx2;
+  expect_context_complete(dispatch_ctx2, 0);
+  ASSERT_TRUE(object_dispatch.write(0, 4096, bufferlist{data2}, io_context, 0,
+                                    0, std::nullopt, {}, nullptr, nullptr,
+                                    &dispatch_result, &finish_ctx_ptr,
+                                    &dispatch_ctx2));
+  ASSERT_EQ(io::DISPATCH_RESULT_COMPLETE, dispatch_result);
+  ASSERT_EQ(0, dispatch_ctx2.wait());
+
+  // the dirty data reads back from the cache
+  MockContext dispatch_ctx3;
+  expect_context_complete(dispatch_ctx3, 0);
+  io::ReadExtents extents = {{0, 8192}};
+  ASSERT_TRUE(object_dispatch.read(0, &extents, io_context, 0, 0, {},
+                                   nullptr, nullptr, &dispatch_result,
+                                   &finish_ctx_ptr, &dispatch_ctx3));
+  ASSERT_EQ(0, dispatch_ctx3.wait());
+
+  bufferlist data;
+  data.append(data1);
+  data.append(data2);
+  ASSERT_TRUE(data.contents_equal(extents[0].bl));
+
+  // written back in one write on flush
+  MockContext dispatch_ctx4;
+  expect_writeback(mock_image_ctx, 0, 0, data, 0);
+  expect_context_complete(dispatch_ctx4, 0);
+  ASSERT_TRUE(object_dispatch.flush(io::FLUSH_SOURCE_USER, {}, nullptr,
+                                    &dispatch_result, &finish_ctx_ptr,
+                                    &dispatch_ctx4));
+  ASSERT_EQ(io::DISPATCH_RESULT_CONTINUE, dispatch_result);
+  ASSERT_EQ(0, dispatch_ctx4.wait());
+
+  ASSERT_FALSE(object_dispatch.flush(io::FLUSH_SOURCE_USER, {}, nullptr,
+                                     &dispatch_result, &finish_ctx_ptr,
+                                     &dispatch_ctx4));
+
+  delete timer_task;
+}
+
+TEST_F(TestMockCacheShardedObjectDispatch, WriteThroughUntilFlushed) {
+  librbd::ImageCtx *ictx;
+  ASSERT_EQ(0, open_image(m_image_name, &ictx));
+
+  MockTestImageCtx mock_image_ctx(*ictx);
+  MockShardedObjectDispatch object_dispatch(&mock_image_ctx, 16384, true);
+  expect_op_work_queue(mock_image_ctx);
+
+  InSequence seq;
+
+  bufferlist data;
+  data.append(std::string(4096, '1'));
+  auto io_context = mock_image_ctx.get_data_io_context();
+
+  io::DispatchResult dispatch_result;
+  MockContext finish_ctx;
+  MockContext dispatch_ctx;
+  Context* finish_ctx_ptr = &finish_ctx;
+  ASSERT_FALSE(object_dispatch.write(0, 0, bufferlist{data}, io_context, 0, 0,
+                                     std::nullopt, {}, nullptr, nullptr,
+                                     &dispatch_result, &finish_ctx_ptr,
+                                     &dispatch_ctx));
+  ASSERT_NE(finish_ctx_ptr, &finish_ctx);
+
+  expect_context_complete(finish_ctx, 0);
+  finish_ctx_ptr->complete(0);
+  ASSERT_EQ(0, finish_ctx.wait());
+
+  finish_ctx_ptr = &finish_ctx;
+  ASSERT_FALSE(object_dispatch.flush(io::FLUSH_SOURCE_USER, {}, nullptr,
+                                     &dispatch_result, &finish_ctx_ptr,
+                                     &dispatch_ctx));
+
+  Context* timer_task = nullptr;
+  expect_add_timer_task(&timer_task);
+  expect_context_complete(dispatch_ctx, 0);
+  ASSERT_TRUE(object_dispatch.write(0, 0, bufferlist{data}, io_context, 0, 0,
+                                    std::nullopt, {}, nullptr, nullptr,
+                                    &dispatch_result, &finish_ctx_ptr,
+                                    &dispatch_ctx));
+  ASSERT_EQ(io::DISPATCH_RESULT_COMPLETE, dispatch_result);
+  ASSERT_EQ(0, dispatch_ctx.wait());
+
+  MockContext shut_down_ctx;
+  EXPECT_CALL(m_mock_timer, cancel_event(timer_task))
+    .WillOnce(Invoke([](Context *timer_task) {
+                delete timer_task;
+                return true;
+              }));
+  expect_writeback(mock_image_ctx, 0, 0, data, 0);
+  expect_context_complete(shut_down_ctx, 0);
+  object_dispatch.shut_down(&shut_down_ctx);
+  ASSERT_EQ(0, shut_down_ctx.wait());
+}
+
+} // namespace cache
+} // namespace librbd
@@ -567,6 +567,56 @@ TEST_F(TestMockDeepCopyObjectCopyRequest, Write) {
   ASSERT_EQ(0, compare_objects());
 }
 
+TEST_F(TestMockDeepCopyObjectCopyRequest, WriteSkipZeroed) {
+  bufferlist bl;
+  bl.append(std::string(4096, '1'));
+  bl.append_zero(8192);
+  bl.append(std::string(4096, '1'));
+  ASSERT_EQ(16384, api::Io<>::write(*m_src_image_ctx, 0, 16384,
+                                    std::move(bl), 0));
+
+  ASSERT_EQ(0, create_snap("copy"));
+  ASSERT_EQ(0, m_dst_image_ctx->config.set_val("rbd_deep_copy_sparse_size",
+                                               "4096"));
+  librbd::MockTestImageCtx mock_src_image_ctx(*m_src_image_ctx);
+  librbd::MockTestImageCtx mock_dst_image_ctx(*m_dst_image_ctx);
+
+  librbd::MockExclusiveLock mock_exclusive_lock;
+  prepare_exclusive_lock(mock_dst_image_ctx, mock_exclusive_lock);
+
+  librbd::MockObjectMap mock_object_map;
+  mock_dst_image_ctx.object_map = &mock_object_map;
+
+  expect_op_work_queue(mock_src_image_ctx);
+  expect_test_features(mock_dst_image_ctx);
+  expect_get_object_count(mock_dst_image_ctx);
+
+  C_SaferCond ctx;
+  MockObjectCopyRequest *request = create_request(mock_src_image_ctx,
+                                                  mock_dst_image_ctx, 0,
+                                                  CEPH_NOSNAP, 0, 0, &ctx);
+
+  librados::MockTestMemIoCtxImpl &mock_dst_io_ctx(get_mock_io_ctx(
+    request->get_dst_io_ctx()));
+
+  InSequence seq;
+  expect_list_snaps(mock_src_image_ctx, 0);
+  expect_read(mock_src_image_ctx, m_src_snap_ids[0], 0, 16384, 0);
+  expect_start_op(mock_exclusive_lock);
+  expect_update_object_map(mock_dst_image_ctx, mock_object_map,
+                           m_dst_snap_ids[0], OBJECT_EXISTS, 0);
+  expect_prepare_copyup(mock_dst_image_ctx);
+  expect_start_op(mock_exclusive_lock);
+  expect_write(mock_dst_io_ctx, 0, 4096, {0, {}}, 0);
+  EXPECT_CALL(mock_dst_io_ctx, zero(_, 4096, 8192, _))
+    .WillOnce(DoDefault());
+  expect_write(mock_dst_io_ctx, 12288, 4096, {0, {}}, 0);
+
+  request->send();
+  ASSERT_EQ(0, ctx.wait());
+  ASSERT_EQ(0, compare_objects());
+}
+
 TEST_F(TestMockDeepCopyObjectCopyRequest, ReadError) {
   // scribble some data
   interval_set<uint64_t> one;
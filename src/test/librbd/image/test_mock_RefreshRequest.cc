@@ -657,6 +657,7 @@ TEST_F(TestMockImageRefreshRequest, SuccessLegacySnapshotV2) {
   InSequence seq;
   expect_get_mutable_metadata(mock_image_ctx, ictx->features, 0);
   expect_get_parent(mock_image_ctx, -EOPNOTSUPP);
+  expect_get_mutable_metadata(mock_image_ctx, ictx->features, 0);
   expect_get_parent_legacy(mock_image_ctx, 0);
   MockGetMetadataRequest mock_get_metadata_request;
   expect_get_metadata(mock_image_ctx, mock_get_metadata_request,
@@ -697,6 +698,7 @@ TEST_F(TestMockImageRefreshRequest, SuccessLegacySnapshotNoTimestampV2) {
   InSequence seq;
   expect_get_mutable_metadata(mock_image_ctx, ictx->features, 0);
   expect_get_parent(mock_image_ctx, -EOPNOTSUPP);
+  expect_get_mutable_metadata(mock_image_ctx, ictx->features, 0);
   expect_get_parent_legacy(mock_image_ctx, 0);
   MockGetMetadataRequest mock_get_metadata_request;
   expect_get_metadata(mock_image_ctx, mock_get_metadata_request,
@@ -32,6 +32,7 @@ public:
   MOCK_METHOD1(apply_qos_schedule_tick_min, void(uint64_t));
   MOCK_METHOD4(apply_qos_limit, void(uint64_t, uint64_t, uint64_t, uint64_t));
   MOCK_METHOD1(apply_qos_exclude_ops, void(uint64_t));
+  MOCK_METHOD1(apply_qos_group, void(const std::string&));
 
   MOCK_CONST_METHOD0(writes_blocked, bool());
   MOCK_METHOD0(block_writes, int());
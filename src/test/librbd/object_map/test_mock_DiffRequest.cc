@@ -239,6 +239,81 @@ TEST_F(TestMockObjectMapDiffRequest, IntermediateDelta) {
   ASSERT_EQ(expected_diff_state, m_object_diff_state);
 }
 
+TEST_F(TestMockObjectMapDiffRequest, IntermediateDeltaGrow) {
+  REQUIRE_FEATURE(RBD_FEATURE_FAST_DIFF);
+
+  // neither size is a multiple of the four objects of a map byte
+  uint32_t object_count_1 = 7;
+  uint32_t object_count_2 = 18;
+  m_image_ctx->size = object_count_2 * (1 << m_image_ctx->order);
+
+  MockTestImageCtx mock_image_ctx(*m_image_ctx);
+  mock_image_ctx.snap_info = {
+    {1U, {"snap1", {cls::rbd::UserSnapshotNamespace{}},
+          object_count_1 * (1ULL << m_image_ctx->order), {}, {}, {}, {}}},
+    {2U, {"snap2", {cls::rbd::UserSnapshotNamespace{}}, mock_image_ctx.size, {},
+          {}, {}, {}}}
+  };
+
+  InSequence seq;
+
+  expect_get_flags(mock_image_ctx, 1U, 0, 0);
+
+  BitVector<2> object_map_1;
+  object_map_1.resize(object_count_1);
+  object_map_1[1] = OBJECT_EXISTS_CLEAN;
+  object_map_1[2] = OBJECT_EXISTS_CLEAN;
+  object_map_1[3] = OBJECT_EXISTS;
+  object_map_1[4] = OBJECT_EXISTS_CLEAN;
+  object_map_1[6] = OBJECT_EXISTS_CLEAN;
+  expect_load_map(mock_image_ctx, 1U, object_map_1, 0);
+
+  expect_get_flags(mock_image_ctx, 2U, 0, 0);
+
+  BitVector<2> object_map_2;
+  object_map_2.resize(object_count_2);
+  object_map_2[0] = OBJECT_EXISTS_CLEAN;
+  object_map_2[1] = OBJECT_EXISTS_CLEAN;
+  object_map_2[3] = OBJECT_EXISTS_CLEAN;
+  object_map_2[4] = OBJECT_EXISTS;
+  object_map_2[6] = OBJECT_PENDING;
+  object_map_2[7] = OBJECT_EXISTS_CLEAN;
+  object_map_2[9] = OBJECT_EXISTS;
+  object_map_2[10] = OBJECT_EXISTS_CLEAN;
+  object_map_2[11] = OBJECT_EXISTS_CLEAN;
+  object_map_2[12] = OBJECT_EXISTS_CLEAN;
+  object_map_2[13] = OBJECT_PENDING;
+  object_map_2[15] = OBJECT_EXISTS_CLEAN;
+  object_map_2[16] = OBJECT_EXISTS;
+  object_map_2[17] = OBJECT_EXISTS_CLEAN;
+  expect_load_map(mock_image_ctx, 2U, object_map_2, 0);
+
+  C_SaferCond ctx;
+  auto req = new MockDiffRequest(&mock_image_ctx, 1, 2,
+                                 &m_object_diff_state, &ctx);
+  req->send();
+  ASSERT_EQ(0, ctx.wait());
+
+  BitVector<2> expected_diff_state;
+  expected_diff_state.resize(object_count_2);
+  expected_diff_state[0] = DIFF_STATE_DATA_UPDATED;
+  expected_diff_state[1] = DIFF_STATE_DATA;
+  expected_diff_state[2] = DIFF_STATE_HOLE_UPDATED;
+  expected_diff_state[3] = DIFF_STATE_DATA_UPDATED;
+  expected_diff_state[4] = DIFF_STATE_DATA_UPDATED;
+  expected_diff_state[6] = DIFF_STATE_DATA_UPDATED;
+  expected_diff_state[7] = DIFF_STATE_DATA;
+  expected_diff_state[9] = DIFF_STATE_DATA_UPDATED;
+  expected_diff_state[10] = DIFF_STATE_DATA;
+  expected_diff_state[11] = DIFF_STATE_DATA;
+  expected_diff_state[12] = DIFF_STATE_DATA;
+  expected_diff_state[13] = DIFF_STATE_DATA_UPDATED;
+  expected_diff_state[15] = DIFF_STATE_DATA;
+  expected_diff_state[16] = DIFF_STATE_DATA_UPDATED;
+  expected_diff_state[17] = DIFF_STATE_DATA;
+  ASSERT_EQ(expected_diff_state, m_object_diff_state);
+}
+
 TEST_F(TestMockObjectMapDiffRequest, EndDelta) {
   REQUIRE_FEATURE(RBD_FEATURE_FAST_DIFF);
 
@@ -84,6 +84,30 @@ protected:
   using Frame::Frame;
 };
 
+// TestFrame as a message frame, the only ones that get compressed
+struct TestMessageFrame : Frame<TestMessageFrame,
+                                segment_t::DEFAULT_ALIGNMENT,
+                                segment_t::DEFAULT_ALIGNMENT,
+                                segment_t::DEFAULT_ALIGNMENT,
+                                segment_t::PAGE_SIZE_ALIGNMENT> {
+  static constexpr Tag tag = Tag::MESSAGE;
+
+  static TestMessageFrame Encode(const bufferlist& header,
+                                 const bufferlist& front,
+                                 const bufferlist& middle,
+                                 const bufferlist& data) {
+    TestMessageFrame f;
+    f.segments[SegmentIndex::Msg::HEADER] = header;
+    f.segments[SegmentIndex::Msg::FRONT] = front;
+    f.segments[SegmentIndex::Msg::MIDDLE] = middle;
+    f.segments[SegmentIndex::Msg::DATA] = data;
+    return f;
+  }
+
+protected:
+  using Frame::Frame;
+};
+
 struct mode_t {
   bool is_rev1;
   bool is_secure;
@@ -388,6 +412,72 @@ INSTANTIATE_TEST_SUITE_P(
         ::testing::ValuesIn(round_trip_instances),
         ::testing::ValuesIn(modes)));
 
+class CompressionTest : public RoundTripTestBase {
+protected:
+  void SetUp() override {
+    g_conf().set_val_or_die("ms_compress_mode", "force");
+    g_conf().set_val_or_die("ms_compress_peer_types", "client");
+    g_conf().set_val_or_die("ms_compress_secure", "true");
+    m_compression = ceph::compression::onwire::rxtx_t::create_handler_pair(
+        g_ceph_context, /*peer_supports_compression=*/true,
+        std::get<1>(GetParam()).is_secure, CEPH_ENTITY_TYPE_CLIENT,
+        entity_addr_t());
+    ASSERT_TRUE(m_compression.rx);
+    ASSERT_TRUE(m_compression.tx);
+    m_tx_frame_asm.set_compression(&m_compression);
+    m_rx_frame_asm.set_compression(&m_compression);
+  }
+
+  void TearDown() override {
+    g_conf().rm_val("ms_compress_mode");
+    g_conf().rm_val("ms_compress_peer_types");
+    g_conf().rm_val("ms_compress_secure");
+  }
+
+  ceph::compression::onwire::rxtx_t m_compression;
+};
+
+TEST_P(CompressionTest, RoundTrip) {
+  const auto& rti = std::get<0>(GetParam());
+  for (int i = 0; i < 3; i++) {
+    auto tx_frame = TestMessageFrame::Encode(m_header, m_front, m_middle,
+                                             m_data);
+    auto onwire_bl = tx_frame.get_buffer(m_tx_frame_asm);
+    EXPECT_LT(onwire_bl.length(), rti.front_len + rti.data_len);
+
+    Tag rx_tag;
+    segment_bls_t rx_segment_bls;
+    EXPECT_TRUE(disassemble_frame(m_rx_frame_asm, onwire_bl, rx_tag,
+                                  rx_segment_bls));
+    EXPECT_TRUE(m_rx_frame_asm.is_compressed());
+    EXPECT_EQ(Tag::MESSAGE, rx_tag);
+    ASSERT_EQ(rti.num_segments, rx_segment_bls.size());
+    EXPECT_TRUE(m_header.contents_equal(rx_segment_bls[0]));
+    EXPECT_TRUE(m_front.contents_equal(rx_segment_bls[1]));
+    EXPECT_TRUE(m_middle.contents_equal(rx_segment_bls[2]));
+    EXPECT_TRUE(m_data.contents_equal(rx_segment_bls[3]));
+  }
+
+  // only message frames get compressed
+  auto tx_frame = TestFrame::Encode(m_header, m_front, m_middle, m_data);
+  auto onwire_bl = tx_frame.get_buffer(m_tx_frame_asm);
+  Tag rx_tag;
+  segment_bls_t rx_segment_bls;
+  EXPECT_TRUE(disassemble_frame(m_rx_frame_asm, onwire_bl, rx_tag,
+                                rx_segment_bls));
+  EXPECT_FALSE(m_rx_frame_asm.is_compressed());
+}
+
+static const round_trip_instance_t compression_instances[] = {
+  // the onwire layout depends on the compressor
+  {41, 4000, 0, 65536, 4, {}},
+};
+
+INSTANTIATE_TEST_SUITE_P(
+    CompressionTests, CompressionTest, ::testing::Combine(
+        ::testing::ValuesIn(compression_instances),
+        ::testing::ValuesIn(modes)));
+
 class RoundTripPerfTest : public RoundTripTestBase {};
 
 TEST_P(RoundTripPerfTest, DISABLED_Basic) {
@@ -7,6 +7,7 @@
 #include "test/librados/test_cxx.h"
 #include "gtest/gtest.h"
 #include <iostream>
+#include <optional>
 
 namespace neorados {
 
@@ -34,6 +35,39 @@ TEST_F(TestNeoRADOS, MakeWithLibRADOS) {
     boost::system::system_error);
 }
 
+TEST_F(TestNeoRADOS, CompletionIoContexts) {
+  librados::Rados paleo_rados;
+  auto result = connect_cluster_pp(paleo_rados);
+  ASSERT_EQ("", result);
+
+  auto rados = RADOS::make_with_librados(paleo_rados);
+  boost::asio::io_context a, b;
+  rados.set_completion_io_contexts({&a, &b});
+
+  Object obj{"dummy-obj"};
+  auto ex = rados.get_executor(obj);
+  ASSERT_TRUE(ex == a.get_executor() || ex == b.get_executor());
+  ASSERT_TRUE(ex == rados.get_executor(obj));
+  auto& ioctx = ex == a.get_executor() ? a : b;
+
+  ReadOp op;
+  bufferlist bl;
+  op.read(0, 0, &bl);
+  std::optional<boost::system::error_code> ec;
+  rados.execute(obj, std::numeric_limits<int64_t>::max(), std::move(op),
+		nullptr, [&](boost::system::error_code e) { ec = e; });
+  // the completion goes to the io_context of the object
+  auto work = boost::asio::make_work_guard(ioctx);
+  while (!ec) {
+    ioctx.run_one();
+  }
+  work.reset();
+  ASSERT_TRUE(*ec);
+
+  rados.set_completion_io_contexts({});
+  ASSERT_TRUE(rados.get_executor(obj) == rados.get_executor());
+}
+
 } // namespace neorados
 
 int main(int argc, char **argv) {
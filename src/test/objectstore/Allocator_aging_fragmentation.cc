@@ -4,6 +4,7 @@
  * Bitmap allocator fragmentation benchmarks.
  * Author: Adam Kupczyk, akupczyk@redhat.com
  */
+#include <iomanip>
 #include <iostream>
 #include <boost/scoped_ptr.hpp>
 #include <gtest/gtest.h>
@@ -15,6 +16,7 @@
 #include "include/stringify.h"
 #include "include/Context.h"
 #include "os/bluestore/Allocator.h"
+#include "os/bluestore/StreamAllocator.h"
 
 #include <boost/random/uniform_int.hpp>
 
@@ -431,6 +433,173 @@ TEST_P(AllocTest, test_bonus_empty_fragmented)
   std::cout << "    empty storage frag.score=" << frag_score << std::endl;
 }
 
+/*
+ * Simulated years of an OSD: objects of many collections are written a
+ * chunk at a time, interleaved, and deleted as they expire, short lived
+ * ones within months, long lived ones within years.  Every simulated
+ * year prints the fragmentation score and the extents per object left
+ * alive, which are what reads of aged objects pay for.  The run only
+ * depends on the seed, AGING_SEED, so it can be repeated; AGING_YEARS
+ * sets its length.
+ */
+struct aging_object_t {
+  Allocator::lifetime_t lifetime;
+  uint64_t stream;
+  uint32_t expires;     ///< month
+  uint64_t left;         ///< still to write
+  PExtentVector extents;
+};
+
+static void do_aging_years(Allocator* alloc, uint64_t capacity,
+			   uint32_t alloc_unit, bool use_streams,
+			   uint32_t years, uint32_t seed)
+{
+  constexpr uint32_t months_per_year = 12;
+  constexpr uint64_t num_collections = 64;
+  constexpr size_t num_open = 32;
+  constexpr uint32_t max_chunk = 512 * 1024;
+  const uint64_t monthly_writes = capacity / 10;
+  const uint64_t high_mark = capacity * 0.85;
+
+  gen_type rng(seed);
+  std::vector<aging_object_t> objects;
+  std::vector<size_t> open;
+  uint64_t level = 0;
+  alloc->init_add_free(0, capacity);
+
+  auto remove = [&](size_t i) {
+    interval_set<uint64_t> release_set;
+    for (auto& e : objects[i].extents) {
+      release_set.insert(e.offset, e.length);
+      level -= e.length;
+    }
+    alloc->release(release_set);
+    if (i + 1 < objects.size()) {
+      objects[i] = std::move(objects.back());
+      // the last object, which may be open, moves to i
+      for (auto& o : open) {
+	if (o == objects.size() - 1) {
+	  o = i;
+	}
+      }
+    }
+    objects.pop_back();
+  };
+  auto remove_random_closed = [&]() {
+    if (objects.size() <= open.size()) {
+      return false;
+    }
+    size_t i;
+    do {
+      i = rng() % objects.size();
+    } while (std::find(open.begin(), open.end(), i) != open.end());
+    remove(i);
+    return true;
+  };
+  auto open_object = [&](uint32_t month) {
+    aging_object_t o;
+    uint32_t r = rng() % 10;
+    if (r < 3) {
+      o.lifetime = Allocator::lifetime_t::short_lived;
+      o.expires = month + 1 + rng() % 3;
+    } else if (r < 6) {
+      o.lifetime = Allocator::lifetime_t::long_lived;
+      o.expires = month + 36 + rng() % 84;
+    } else {
+      o.lifetime = Allocator::lifetime_t::unknown;
+      o.expires = month + 1 + rng() % 60;
+    }
+    o.stream = rng() % num_collections;
+    o.left = p2roundup<uint64_t>(64 * 1024 + rng() % (16 * 1024 * 1024),
+				 alloc_unit);
+    objects.push_back(std::move(o));
+    return objects.size() - 1;
+  };
+
+  std::cout << "  year   frag.score   extents/object   used" << std::endl;
+  for (uint32_t month = 0; month < years * months_per_year; ++month) {
+    for (size_t i = 0; i < objects.size(); ) {
+      if (objects[i].expires <= month &&
+	  std::find(open.begin(), open.end(), i) == open.end()) {
+	remove(i);
+      } else {
+	++i;
+      }
+    }
+    uint64_t written = 0;
+    while (written < monthly_writes) {
+      while (open.size() < num_open) {
+	open.push_back(open_object(month));
+      }
+      size_t which = rng() % open.size();
+      auto& o = objects[open[which]];
+      uint64_t want = std::min<uint64_t>(o.left, max_chunk);
+      while (level + want > high_mark && remove_random_closed()) ;
+      PExtentVector tmp;
+      int64_t r = use_streams ?
+	alloc->allocate_stream(o.stream, o.lifetime, want, alloc_unit, 0, &tmp) :
+	alloc->allocate(want, alloc_unit, 0, 0, &tmp);
+      ASSERT_EQ(r, (int64_t)want);
+      for (auto& e : tmp) {
+	if (!o.extents.empty() && o.extents.back().end() == e.offset) {
+	  o.extents.back().length += e.length;
+	} else {
+	  o.extents.push_back(e);
+	}
+      }
+      level += want;
+      written += want;
+      o.left -= want;
+      if (o.left == 0) {
+	open[which] = open.back();
+	open.pop_back();
+      }
+    }
+    if ((month + 1) % months_per_year == 0) {
+      uint64_t extents = 0;
+      for (auto& o : objects) {
+	extents += o.extents.size();
+      }
+      std::cout << "  " << std::setw(4) << (month + 1) / months_per_year
+		<< "   " << std::setw(10) << alloc->get_fragmentation_score()
+		<< "   " << std::setw(14)
+		<< (objects.empty() ? 0 : double(extents) / objects.size())
+		<< "   " << std::setw(3) << 100 * level / capacity << "%"
+		<< std::endl;
+    }
+  }
+  open.clear();
+  while (!objects.empty()) {
+    remove(objects.size() - 1);
+  }
+  ASSERT_EQ(alloc->get_free(), capacity);
+}
+
+TEST_P(AllocTest, test_aging_years)
+{
+  std::string allocator_name = GetParam();
+  const char* years = getenv("AGING_YEARS");
+  const char* seed = getenv("AGING_SEED");
+  uint64_t capacity = 32 * _1G;
+  uint32_t alloc_unit = 4096;
+  g_ceph_context->_conf->bdev_block_size = alloc_unit;
+  for (bool use_streams : {false, true}) {
+    std::cout << "Allocator: " << allocator_name
+	      << (use_streams ? " with streams" : "") << std::endl;
+    Allocator* a = Allocator::create(g_ceph_context, allocator_name,
+				     capacity, alloc_unit);
+    ASSERT_TRUE(a);
+    if (use_streams) {
+      // idle streams keep their regions, the simulated time is not real
+      a = new StreamAllocator(g_ceph_context, a, 16, 16 * _1m, 4 * _1m, 1e9);
+    }
+    alloc.reset(a);
+    do_aging_years(alloc.get(), capacity, alloc_unit, use_streams,
+		   years ? atoi(years) : 5, seed ? atoi(seed) : 0);
+    alloc.reset();
+  }
+}
+
 INSTANTIATE_TEST_CASE_P(
   Allocator,
   AllocTest,
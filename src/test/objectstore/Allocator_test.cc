@@ -5,6 +5,7 @@
  * Author: Ramesh Chander, Ramesh.Chander@sandisk.com
  */
 #include <iostream>
+#include <thread>
 #include <boost/scoped_ptr.hpp>
 #include <gtest/gtest.h>
 
@@ -13,6 +14,8 @@
 #include "include/stringify.h"
 #include "include/Context.h"
 #include "os/bluestore/Allocator.h"
+#include "os/bluestore/CachedAllocator.h"
+#include "os/bluestore/StreamAllocator.h"
 
 typedef boost::mt11213b gen_type;
 
@@ -500,6 +503,153 @@ TEST_P(AllocTest, test_alloc_47883)
   EXPECT_EQ(got, 0x630000);
 }
 
+TEST(CachedAllocator, basic)
+{
+  uint64_t block = 0x1000;
+  uint64_t size = 0x200000;
+  auto backend = Allocator::create(g_ceph_context, "avl", size, block);
+  CachedAllocator alloc(g_ceph_context, backend, 4, 0x100000, 0x10000, 5);
+  alloc.init_add_free(0, size);
+  ASSERT_EQ(size, alloc.get_free());
+
+  PExtentVector small;
+  EXPECT_EQ((int64_t)0x2000, alloc.allocate(0x2000, block, 0, 0, &small));
+  EXPECT_EQ(size - 0x2000, alloc.get_free());
+  EXPECT_EQ(0x100000u - 0x2000, alloc.get_cached());
+  EXPECT_EQ(size - 0x100000, backend->get_free());
+
+  // other units and large allocations bypass the caches
+  PExtentVector other;
+  EXPECT_EQ((int64_t)0x20000, alloc.allocate(0x20000, 0x10000, 0, 0, &other));
+  EXPECT_EQ(0x100000u - 0x2000, alloc.get_cached());
+  alloc.release(other);
+
+  // cached space is not lost to ENOSPC
+  PExtentVector big;
+  EXPECT_EQ((int64_t)(size - 0x2000),
+	    alloc.allocate(size - 0x2000, block, 0, 0, &big));
+  EXPECT_EQ(0u, alloc.get_cached());
+  EXPECT_EQ(0u, alloc.get_free());
+  interval_set<uint64_t> in_use;
+  for (auto& e : small) {
+    in_use.insert(e.offset, e.length);
+  }
+  for (auto& e : big) {
+    in_use.insert(e.offset, e.length);
+  }
+  EXPECT_EQ(size, in_use.size());
+
+  alloc.release(in_use);
+  EXPECT_EQ(size, alloc.get_free());
+}
+
+TEST(CachedAllocator, concurrent)
+{
+  uint64_t block = 0x1000;
+  uint64_t size = 0x10000000;
+  auto backend = Allocator::create(g_ceph_context, "avl", size, block);
+  CachedAllocator alloc(g_ceph_context, backend, 8, 0x100000, 0x10000, 0);
+  alloc.init_add_free(0, size);
+
+  ceph::mutex lock = ceph::make_mutex("CachedAllocator::concurrent");
+  interval_set<uint64_t> in_use;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 8; t++) {
+    threads.emplace_back([&, t] {
+      gen_type rng(t);
+      std::vector<PExtentVector> mine;
+      for (int i = 0; i < 2000; i++) {
+	if (mine.size() < 50 && (mine.empty() || rng() % 4)) {
+	  PExtentVector ev;
+	  uint64_t want = (rng() % 16 + 1) * block;
+	  ASSERT_EQ((int64_t)want, alloc.allocate(want, block, 0, 0, &ev));
+	  std::lock_guard l(lock);
+	  for (auto& e : ev) {
+	    ASSERT_FALSE(in_use.intersects(e.offset, e.length));
+	    in_use.insert(e.offset, e.length);
+	  }
+	  mine.push_back(std::move(ev));
+	} else {
+	  auto ev = std::move(mine.back());
+	  mine.pop_back();
+	  {
+	    std::lock_guard l(lock);
+	    for (auto& e : ev) {
+	      in_use.erase(e.offset, e.length);
+	    }
+	  }
+	  alloc.release(ev);
+	}
+      }
+      for (auto& ev : mine) {
+	{
+	  std::lock_guard l(lock);
+	  for (auto& e : ev) {
+	    in_use.erase(e.offset, e.length);
+	  }
+	}
+	alloc.release(ev);
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  ASSERT_TRUE(in_use.empty());
+  ASSERT_EQ(size, alloc.get_free());
+}
+
+TEST(StreamAllocator, basic)
+{
+  uint64_t block = 0x1000;
+  uint64_t size = 0x4000000;
+  uint64_t region = 0x100000;
+  auto backend = Allocator::create(g_ceph_context, "avl", size, block);
+  StreamAllocator alloc(g_ceph_context, backend, 4, region, 0x40000, 5);
+  alloc.init_add_free(0, size);
+
+  // interleaved allocations of two streams stay contiguous per stream
+  PExtentVector a, b;
+  for (int i = 0; i < 8; i++) {
+    EXPECT_EQ((int64_t)0x2000, alloc.allocate_stream(
+      1, Allocator::lifetime_t::unknown, 0x2000, block, 0, &a));
+    EXPECT_EQ((int64_t)0x2000, alloc.allocate_stream(
+      2, Allocator::lifetime_t::unknown, 0x2000, block, 0, &b));
+  }
+  interval_set<uint64_t> in_a, in_b;
+  for (auto& e : a) {
+    in_a.insert(e.offset, e.length);
+  }
+  for (auto& e : b) {
+    in_b.insert(e.offset, e.length);
+  }
+  EXPECT_EQ(1u, in_a.num_intervals());
+  EXPECT_EQ(1u, in_b.num_intervals());
+  EXPECT_EQ(2 * region - 0x20000, alloc.get_reserved());
+  EXPECT_EQ(size - 0x20000, alloc.get_free());
+
+  // another lifetime of the same stream takes a region of its own
+  PExtentVector c;
+  EXPECT_EQ((int64_t)0x2000, alloc.allocate_stream(
+    1, Allocator::lifetime_t::short_lived, 0x2000, block, 0, &c));
+  EXPECT_FALSE(in_a.contains(c[0].offset, c[0].length));
+  EXPECT_NE(in_a.range_end(), c[0].offset);
+  EXPECT_EQ(3 * region - 0x22000, alloc.get_reserved());
+
+  // reserved space is not lost to ENOSPC
+  PExtentVector big;
+  EXPECT_EQ((int64_t)(size - 0x22000),
+	    alloc.allocate(size - 0x22000, block, 0, 0, &big));
+  EXPECT_EQ(0u, alloc.get_reserved());
+  EXPECT_EQ(0u, alloc.get_free());
+
+  alloc.release(a);
+  alloc.release(b);
+  alloc.release(c);
+  alloc.release(big);
+  EXPECT_EQ(size, alloc.get_free());
+}
+
 INSTANTIATE_TEST_SUITE_P(
   Allocator,
   AllocTest,
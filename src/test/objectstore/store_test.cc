@@ -5083,6 +5083,58 @@ TEST_P(StoreTestSpecificAUSize, SyntheticMatrixPreferDeferred) {
   };
   do_matrix(m, std::bind(&StoreTest::doSyntheticTest, this, _1, _2, _3, _4));
 }
+
+TEST_P(StoreTestSpecificAUSize, SyntheticMatrixDeferredAggregate) {
+  if (string(GetParam()) != "bluestore")
+    return;
+
+  const char *m[][10] = {
+    { "bluestore_min_alloc_size", "4096", "65536", 0 }, // to be the first!
+    { "max_write", "65536", 0 },
+    { "max_size", "1048576", 0 },
+    { "alignment", "512", 0 },
+    { "bluestore_prefer_deferred_size", "65536", 0},
+    { "bluestore_deferred_aggregate", "true", 0 },
+    { "bluestore_deferred_aggregate_max_write", "0", "16384", 0 },
+    { 0 },
+  };
+  do_matrix(m, std::bind(&StoreTest::doSyntheticTest, this, _1, _2, _3, _4));
+}
+
+TEST_P(StoreTestSpecificAUSize, SyntheticMatrixEncodedOnodeCache) {
+  if (string(GetParam()) != "bluestore")
+    return;
+
+  const char *m[][10] = {
+    { "bluestore_min_alloc_size", "4096", 0 }, // to be the first!
+    { "max_write", "65536", 0 },
+    { "max_size", "1048576", 0 },
+    { "alignment", "512", 0 },
+    { "bluestore_cache_autotune", "false", 0 },
+    { "bluestore_cache_size", "2097152", 0 },
+    { "bluestore_onode_cache_encoded_ratio", "0.5", "0.9", 0 },
+    { "bluestore_extent_map_shard_max_size", "200", "1200", 0 },
+    { 0 },
+  };
+  do_matrix(m, std::bind(&StoreTest::doSyntheticTest, this, _1, _2, _3, _4));
+}
+
+TEST_P(StoreTestSpecificAUSize, SyntheticMatrixKVSyncLanes) {
+  if (string(GetParam()) != "bluestore")
+    return;
+
+  const char *m[][10] = {
+    { "bluestore_min_alloc_size", "4096", 0 }, // to be the first!
+    { "max_write", "65536", 0 },
+    { "max_size", "1048576", 0 },
+    { "alignment", "512", 0 },
+    { "bluestore_kv_sync_lanes", "2", "4", 0 },
+    { "bluestore_prefer_deferred_size", "32768", "0", 0},
+    { "bluestore_sync_submit_transaction", "true", "false", 0 },
+    { 0 },
+  };
+  do_matrix(m, std::bind(&StoreTest::doSyntheticTest, this, _1, _2, _3, _4));
+}
 #endif // WITH_BLUESTORE
 
 TEST_P(StoreTest, AttrSynthetic) {
@@ -5696,6 +5748,100 @@ TEST_P(StoreTest, OMapIterator) {
   }
 }
 
+TEST_P(StoreTest, OMapGetValsEncoded) {
+  coll_t cid;
+  ghobject_t hoid(hobject_t("tesomap", "", CEPH_NOSNAP, 0, 0, ""));
+  ghobject_t missing(hobject_t("missing", "", CEPH_NOSNAP, 0, 0, ""));
+  auto ch = store->create_new_collection(cid);
+  int r;
+  map<string, bufferlist> omap;
+  for (int i = 0; i < 100; i++) {
+    char buf[20];
+    snprintf(buf, sizeof(buf), "key-%02d", i);
+    omap[buf].append(string(i, 'v'));
+  }
+  omap["k\xff\xff"].append("a");
+  omap["k\xff\xffz"].append("b");
+  omap["l"].append("c");
+  {
+    ObjectStore::Transaction t;
+    t.create_collection(cid, 0);
+    t.touch(cid, hoid);
+    t.omap_setkeys(cid, hoid, omap);
+    r = queue_transaction(store, ch, std::move(t));
+    ASSERT_EQ(r, 0);
+  }
+
+  auto get = [&](const string& start_after, const string& filter_prefix,
+		 uint64_t max_entries, uint64_t max_bytes,
+		 map<string, bufferlist>* out, bool* more) {
+    bufferlist bl;
+    uint32_t num = 0;
+    int r = store->omap_get_vals_encoded(ch, hoid, start_after, filter_prefix,
+					  max_entries, max_bytes,
+					  &bl, &num, more);
+    ASSERT_EQ(r, 0);
+    out->clear();
+    auto p = bl.cbegin();
+    for (uint32_t i = 0; i < num; i++) {
+      string k;
+      bufferlist v;
+      decode(k, p);
+      decode(v, p);
+      ASSERT_TRUE(out->emplace(k, v).second);
+    }
+    ASSERT_TRUE(p.end());
+  };
+
+  map<string, bufferlist> got;
+  bool more;
+  get("", "", 1000, 1 << 20, &got, &more);
+  ASSERT_EQ(got, omap);
+  ASSERT_FALSE(more);
+
+  get("", "key-1", 1000, 1 << 20, &got, &more);
+  ASSERT_EQ(got.size(), 10u);
+  ASSERT_EQ(got.begin()->first, "key-10");
+  ASSERT_EQ(got.rbegin()->first, "key-19");
+  ASSERT_EQ(got["key-17"], omap["key-17"]);
+  ASSERT_FALSE(more);
+
+  get("key-15", "key-1", 1000, 1 << 20, &got, &more);
+  ASSERT_EQ(got.size(), 4u);
+  ASSERT_EQ(got.begin()->first, "key-16");
+
+  get("key-", "key-9", 1000, 1 << 20, &got, &more);
+  ASSERT_EQ(got.size(), 10u);
+  ASSERT_EQ(got.begin()->first, "key-90");
+
+  get("", "k\xff", 1000, 1 << 20, &got, &more);
+  ASSERT_EQ(got.size(), 2u);
+  ASSERT_EQ(got.begin()->first, "k\xff\xff");
+
+  get("key-50", "", 5, 1 << 20, &got, &more);
+  ASSERT_EQ(got.size(), 5u);
+  ASSERT_EQ(got.begin()->first, "key-51");
+  ASSERT_TRUE(more);
+
+  get("", "key-", 1000, 1, &got, &more);
+  ASSERT_EQ(got.size(), 1u);
+  ASSERT_TRUE(more);
+
+  {
+    bufferlist bl;
+    uint32_t num;
+    ASSERT_EQ(store->omap_get_vals_encoded(ch, missing, "", "", 10, 1 << 20,
+					   &bl, &num, &more), -ENOENT);
+  }
+  {
+    ObjectStore::Transaction t;
+    t.remove(cid, hoid);
+    t.remove_collection(cid);
+    r = queue_transaction(store, ch, std::move(t));
+    ASSERT_EQ(r, 0);
+  }
+}
+
 TEST_P(StoreTest, XattrTest) {
   coll_t cid;
   ghobject_t hoid(hobject_t("tesomap", "", CEPH_NOSNAP, 0, 0, ""));
@@ -8268,6 +8414,12 @@ TEST_P(StoreTestSpecificAUSize, BluestoreRepairTest) {
   bstore->inject_misreference(cid, hoid, cid, hoid_dup, offs_base * (repeats -1) );
   
   bstore->umount();
+  // the same whether objects are checked by one thread or several
+  SetVal(g_conf(), "bluestore_fsck_threads", "0");
+  g_conf().apply_changes(nullptr);
+  ASSERT_EQ(bstore->fsck(false), 6);
+  SetVal(g_conf(), "bluestore_fsck_threads", "4");
+  g_conf().apply_changes(nullptr);
   ASSERT_EQ(bstore->fsck(false), 6);
   ASSERT_EQ(bstore->repair(false), 0);
 
@@ -8515,6 +8667,113 @@ TEST_P(StoreTest, BluestoreStatistics) {
   cout << std::endl;
 }
 
+TEST_P(StoreTest, BluestoreOnodeWarmup) {
+  if (string(GetParam()) != "bluestore")
+    return;
+
+  SetVal(g_conf(), "bluestore_onode_warmup_max", "1000");
+  g_ceph_context->_conf.apply_changes(nullptr);
+
+  coll_t cid;
+  auto ch = store->create_new_collection(cid);
+  int r;
+  {
+    ObjectStore::Transaction t;
+    t.create_collection(cid, 0);
+    r = queue_transaction(store, ch, std::move(t));
+    ASSERT_EQ(r, 0);
+  }
+  const unsigned num_objects = 20;
+  bufferlist bl;
+  bl.append("0123456789abcdefghi");
+  for (unsigned i = 0; i < num_objects; ++i) {
+    ghobject_t hoid(hobject_t(sobject_t("Object " + stringify(i), CEPH_NOSNAP)));
+    ObjectStore::Transaction t;
+    t.write(cid, hoid, 0, bl.length(), bl);
+    r = queue_transaction(store, ch, std::move(t));
+    ASSERT_EQ(r, 0);
+  }
+  ch.reset();
+
+  auto cached_onodes = [&] {
+    std::stringstream ss;
+    store->dump_cache_stats(ss);
+    string s = ss.str();
+    return std::stoi(s.substr(s.find(":") + 1));
+  };
+  r = store->umount();
+  ASSERT_EQ(r, 0);
+  r = store->mount();
+  ASSERT_EQ(r, 0);
+  // loaded back in the background, without a read
+  for (unsigned i = 0; i < 100 && cached_onodes() < (int)num_objects; ++i) {
+    usleep(100000);
+  }
+  ASSERT_EQ(cached_onodes(), (int)num_objects);
+
+  ch = store->open_collection(cid);
+  for (unsigned i = 0; i < num_objects; ++i) {
+    ghobject_t hoid(hobject_t(sobject_t("Object " + stringify(i), CEPH_NOSNAP)));
+    bufferlist readback;
+    r = store->read(ch, hoid, 0, bl.length(), readback);
+    ASSERT_EQ(static_cast<int>(bl.length()), r);
+    ASSERT_TRUE(bl_eq(bl, readback));
+  }
+}
+
+TEST_P(StoreTest, BluestoreOnodePrefetch) {
+  if (string(GetParam()) != "bluestore")
+    return;
+
+  SetVal(g_conf(), "bluestore_onode_prefetch_min_accessed", "4");
+  g_ceph_context->_conf.apply_changes(nullptr);
+
+  coll_t cid;
+  auto ch = store->create_new_collection(cid);
+  int r;
+  {
+    ObjectStore::Transaction t;
+    t.create_collection(cid, 0);
+    r = queue_transaction(store, ch, std::move(t));
+    ASSERT_EQ(r, 0);
+  }
+  const unsigned num_objects = 40;
+  bufferlist bl;
+  bl.append("0123456789abcdefghi");
+  for (unsigned i = 0; i < num_objects; ++i) {
+    ghobject_t hoid(hobject_t(sobject_t("Object " + stringify(i), CEPH_NOSNAP)));
+    ObjectStore::Transaction t;
+    t.write(cid, hoid, 0, bl.length(), bl);
+    r = queue_transaction(store, ch, std::move(t));
+    ASSERT_EQ(r, 0);
+  }
+  ch.reset();
+  r = store->umount();
+  ASSERT_EQ(r, 0);
+  r = store->mount();
+  ASSERT_EQ(r, 0);
+  ch = store->open_collection(cid);
+  const PerfCounters* logger = store->get_perf_counters();
+
+  // list then stat in chunks, like a backfill scan
+  ghobject_t next;
+  unsigned stated = 0;
+  while (!next.is_max()) {
+    vector<ghobject_t> ls;
+    r = collection_list(store, ch, next, ghobject_t::get_max(), 10, &ls, &next);
+    ASSERT_EQ(r, 0);
+    for (auto& oid : ls) {
+      struct stat st;
+      ASSERT_EQ(store->stat(ch, oid, &st), 0);
+      ASSERT_EQ(st.st_size, (int)bl.length());
+      ++stated;
+    }
+  }
+  ASSERT_EQ(stated, num_objects);
+  // the first chunk is read one by one, the others are prefetched
+  ASSERT_EQ(logger->get(l_bluestore_onode_prefetched), num_objects - 10);
+}
+
 TEST_P(StoreTest, BluestorePerPoolOmapFixOnMount)
 {
   if (string(GetParam()) != "bluestore")
@@ -9117,6 +9376,71 @@ TEST_P(StoreTestSpecificAUSize, Ticket45195Repro) {
   ASSERT_EQ(r, 0x10000);
 }
 
+TEST_P(StoreTestSpecificAUSize, AllocationFromFile) {
+  if (string(GetParam()) != "bluestore")
+    return;
+
+  SetVal(g_conf(), "bluestore_allocation_from_file", "true");
+  g_conf().apply_changes(nullptr);
+  StartDeferred(0x1000);
+
+  int r;
+  coll_t cid;
+  auto ch = store->create_new_collection(cid);
+  {
+    ObjectStore::Transaction t;
+    t.create_collection(cid, 0);
+    r = queue_transaction(store, ch, std::move(t));
+    ASSERT_EQ(r, 0);
+  }
+  // small and large blobs, shared ones, and some released space
+  bufferlist bl;
+  bl.append(string(0x30000, 'a'));
+  for (unsigned i = 0; i < 20; ++i) {
+    ghobject_t hoid(hobject_t(sobject_t("Object " + stringify(i), CEPH_NOSNAP)));
+    ObjectStore::Transaction t;
+    t.write(cid, hoid, (i % 4) * 0x1000, (i + 1) * 0x1000, bl);
+    if (i % 3 == 0) {
+      ghobject_t clone = hoid;
+      clone.hobj.snap = 1;
+      t.clone(cid, hoid, clone);
+      t.write(cid, hoid, 0, 0x2000, bl);
+    }
+    if (i % 5 == 0) {
+      t.truncate(cid, hoid, 0x1000);
+    }
+    r = queue_transaction(store, ch, std::move(t));
+    ASSERT_EQ(r, 0);
+  }
+  struct store_statfs_t statfs0;
+  r = store->statfs(&statfs0);
+  ASSERT_EQ(r, 0);
+  ch.reset();
+
+  // clean umount: the allocator state is saved, and matches the onodes
+  EXPECT_EQ(store->umount(), 0);
+  ASSERT_EQ(store->fsck(false), 0);
+  EXPECT_EQ(store->mount(), 0);
+  struct store_statfs_t statfs1;
+  r = store->statfs(&statfs1);
+  ASSERT_EQ(r, 0);
+  ASSERT_EQ(statfs0.available, statfs1.available);
+  EXPECT_EQ(store->umount(), 0);
+
+  // opened read/write without a umount, like after a crash: the
+  // allocator state is rebuilt from the onodes
+  BlueStore* bstore = dynamic_cast<BlueStore*> (store.get());
+  KeyValueDB* db;
+  ASSERT_EQ(bstore->open_db_environment(&db, false), 0);
+  ASSERT_EQ(bstore->close_db_environment(), 0);
+  ASSERT_EQ(store->fsck(false), 0);
+  EXPECT_EQ(store->mount(), 0);
+  struct store_statfs_t statfs2;
+  r = store->statfs(&statfs2);
+  ASSERT_EQ(r, 0);
+  ASSERT_EQ(statfs0.available, statfs2.available);
+}
+
 #endif  // WITH_BLUESTORE
 
 int main(int argc, char **argv) {
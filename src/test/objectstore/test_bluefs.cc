@@ -607,6 +607,52 @@ TEST(BlueFS, test_simple_compaction_async) {
   fs.umount();
 }
 
+TEST(BlueFS, test_compaction_background) {
+  ConfSaver conf(g_ceph_context->_conf);
+  conf.SetVal("bluefs_compact_log_sync", "false");
+  conf.SetVal("bluefs_log_compact_min_size", "65536");
+  conf.ApplyChanges();
+  uint64_t size = 1048576 * 128;
+  TempBdev bdev{size};
+
+  BlueFS fs(g_ceph_context);
+  ASSERT_EQ(0, fs.add_block_device(BlueFS::BDEV_DB, bdev.path, false, 1048576));
+  uuid_d fsid;
+  ASSERT_EQ(0, fs.mkfs(fsid, { BlueFS::BDEV_DB, false, false }));
+  ASSERT_EQ(0, fs.mount());
+  ASSERT_EQ(0, fs.mkdir("dir"));
+  // churn the metadata so that fsyncs keep queueing compactions to the
+  // background thread, while the kept files must survive all of them
+  for (int i = 0; i < 2000; i++) {
+    string file = "file." + to_string(i);
+    BlueFS::FileWriter *h;
+    ASSERT_EQ(0, fs.open_for_write("dir", file, &h, false));
+    ASSERT_NE(nullptr, h);
+    h->append(file.c_str(), file.length());
+    fs.fsync(h);
+    fs.close_writer(h);
+    if (i % 10) {
+      fs.unlink("dir", file);
+    }
+    fs.sync_metadata(false);
+  }
+  fs.umount();
+
+  ASSERT_EQ(0, fs.mount());
+  for (int i = 0; i < 2000; i++) {
+    string file = "file." + to_string(i);
+    uint64_t fsize = 0;
+    utime_t mtime;
+    if (i % 10) {
+      ASSERT_EQ(-ENOENT, fs.stat("dir", file, &fsize, &mtime));
+    } else {
+      ASSERT_EQ(0, fs.stat("dir", file, &fsize, &mtime));
+      ASSERT_EQ(file.length(), fsize);
+    }
+  }
+  fs.umount();
+}
+
 TEST(BlueFS, test_compaction_sync) {
   uint64_t size = 1048576 * 128;
   TempBdev bdev{size};
@@ -308,6 +308,50 @@ TEST(bluestore_blob_t, calc_csum)
   }
 }
 
+TEST(bluestore_blob_t, csum_fragmented)
+{
+  // the same data in one buffer and in pieces that do not line up
+  // with the csum blocks
+  const unsigned len = 0x10000;
+  bufferptr bp(len);
+  for (unsigned i = 0; i < len; ++i) {
+    bp.c_str()[i] = rand();
+  }
+  bufferlist whole;
+  whole.append(bp);
+  bufferlist pieces;
+  for (unsigned off = 0; off < len; ) {
+    unsigned l = std::min(len - off, 1u + rand() % 0x3000);
+    pieces.append(bp.c_str() + off, l);
+    off += l;
+  }
+  bufferlist bad;
+  bad.append(bp);
+  bad.c_str()[9 * 0x1000 + 17] ^= 1;
+
+  for (unsigned csum_type = Checksummer::CSUM_NONE + 1;
+       csum_type < Checksummer::CSUM_MAX;
+       ++csum_type) {
+    cout << "csum_type " << Checksummer::get_csum_type_string(csum_type)
+	 << std::endl;
+    bluestore_blob_t a, b;
+    a.init_csum(csum_type, 12, len);
+    b.init_csum(csum_type, 12, len);
+    a.calc_csum(0, whole);
+    b.calc_csum(0, pieces);
+    ASSERT_EQ(a.csum_data.length(), b.csum_data.length());
+    ASSERT_EQ(0, memcmp(a.csum_data.c_str(), b.csum_data.c_str(),
+			a.csum_data.length()));
+
+    int bad_off;
+    uint64_t bad_csum;
+    ASSERT_EQ(0, a.verify_csum(0, pieces, &bad_off, &bad_csum));
+    ASSERT_EQ(-1, bad_off);
+    ASSERT_EQ(-1, a.verify_csum(0, bad, &bad_off, &bad_csum));
+    ASSERT_EQ(9 * 0x1000, bad_off);
+  }
+}
+
 TEST(bluestore_blob_t, csum_bench)
 {
   bufferlist bl;
@@ -331,6 +375,19 @@ TEST(bluestore_blob_t, csum_bench)
     cout << "csum_type " << Checksummer::get_csum_type_string(csum_type)
 	 << ", " << dur << " seconds, "
 	 << mbsec << " MB/sec" << std::endl;
+
+    int bad_off;
+    uint64_t bad_csum;
+    start = ceph::mono_clock::now();
+    for (int i = 0; i<count; ++i) {
+      ASSERT_EQ(0, b.verify_csum(0, bl, &bad_off, &bad_csum));
+    }
+    end = ceph::mono_clock::now();
+    dur = std::chrono::duration_cast<ceph::timespan>(end - start);
+    mbsec = (double)count * (double)bl.length() / 1000000.0 / (double)dur.count() * 1000000000.0;
+    cout << "csum_type " << Checksummer::get_csum_type_string(csum_type)
+	 << " verify, " << dur << " seconds, "
+	 << mbsec << " MB/sec" << std::endl;
   }
 }
 
@@ -945,6 +1002,58 @@ TEST(Blob, split)
   }
 }
 
+TEST(BufferSpace, arc_scan_resistance)
+{
+  const unsigned bs = 0x1000;
+  BlueStore::BufferCacheShard *bc = BlueStore::BufferCacheShard::create(
+    g_ceph_context, "arc", NULL);
+  bc->set_max(16 * bs);
+  BlueStore::BufferSpace space;
+  auto read = [&](unsigned i) {
+    bufferlist bl;
+    bl.append(string(bs, 'a' + i % 26));
+    space.did_read(bc, i * bs, bl);
+  };
+  auto cached = [&](unsigned i) {
+    auto p = space.buffer_map.find(i * bs);
+    return p != space.buffer_map.end() && p->second->is_clean();
+  };
+
+  // a hot set, read twice
+  for (unsigned i = 0; i < 8; ++i) {
+    read(i);
+    std::lock_guard l(bc->lock);
+    bc->_touch(space.buffer_map[i * bs].get());
+  }
+  // a scan four times the size of the cache
+  for (unsigned i = 100; i < 164; ++i) {
+    read(i);
+  }
+  for (unsigned i = 0; i < 8; ++i) {
+    ASSERT_TRUE(cached(i));
+  }
+  ASSERT_TRUE(cached(163));
+  ASSERT_FALSE(cached(100));
+  ASSERT_LE(bc->_get_bytes(), 16u * bs);
+
+  // ghosts are bounded by bytes too
+  unsigned ghosts = 0;
+  for (auto& p : space.buffer_map) {
+    if (p.second->is_empty()) {
+      ++ghosts;
+    }
+  }
+  ASSERT_LE(ghosts, 16u);
+  ASSERT_GT(ghosts, 0u);
+
+  {
+    std::lock_guard l(bc->lock);
+    space._clear(bc);
+  }
+  ASSERT_EQ(0u, bc->_get_bytes());
+  delete bc;
+}
+
 TEST(Blob, legacy_decode)
 {
   BlueStore store(g_ceph_context, "", 4096);
@@ -17,6 +17,8 @@
 #include <iostream>
 #include <time.h>
 #include <sys/mount.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #include "kv/KeyValueDB.h"
 #include "kv/RocksDBStore.h"
 #include "include/Context.h"
@@ -348,6 +350,43 @@ TEST_P(KVTest, ShardingRMRange) {
   fini();
 }
 
+TEST_P(KVTest, MultiGet) {
+  std::string cfs;
+  if (string(GetParam()) == "rocksdb") {
+    cfs = "O(7)=";
+  }
+  ASSERT_EQ(0, db->create_and_open(cout, cfs));
+  {
+    KeyValueDB::Transaction t = db->get_transaction();
+    for (size_t i = 0; i < 100; i += 2) {
+      char* a;
+      ASSERT_EQ(asprintf(&a, "key%3.3ld", i), 6);
+      bufferlist value;
+      value.append(a);
+      t->set("O", a, value);
+      t->set("P", a, value);
+      free(a);
+    }
+    db->submit_transaction_sync(t);
+  }
+  for (auto prefix : {"O", "P"}) {
+    std::set<std::string> keys;
+    for (size_t i = 0; i < 100; i++) {
+      char* a;
+      ASSERT_EQ(asprintf(&a, "key%3.3ld", i), 6);
+      keys.insert(a);
+      free(a);
+    }
+    std::map<std::string, bufferlist> out;
+    ASSERT_EQ(0, db->get(prefix, keys, &out));
+    ASSERT_EQ(50u, out.size());
+    for (auto& [k, v] : out) {
+      ASSERT_EQ(0, (k[5] - '0') % 2);
+      ASSERT_EQ(k, v.to_str());
+    }
+  }
+  fini();
+}
 
 TEST_P(KVTest, RocksDBColumnFamilyTest) {
   if(string(GetParam()) != "rocksdb")
@@ -1272,6 +1311,67 @@ TEST_F(RocksDBResharding, change_reshard) {
   }
 }
 
+TEST_F(RocksDBResharding, online) {
+  ASSERT_EQ(0, db->create_and_open(cout, "C(1)"));
+  generate_data();
+  data_to_db();
+  check_db();
+  db->close();
+  // only new columns fed from the default column family
+  ASSERT_EQ(db->reshard_online_prepare("C(2) Evade(4)"), -EINVAL);
+  ASSERT_EQ(db->reshard_online_prepare("Evade(4)"), -EINVAL);
+  ASSERT_EQ(db->reshard_online_prepare("C(1) D Evade(4)"), 0);
+
+  g_conf().set_val("rocksdb_online_reshard_keys_per_batch", "10");
+  g_conf().set_val("rocksdb_online_reshard_sleep", "0.001");
+  ASSERT_EQ(db->open(cout), 0);
+  check_db();
+  {
+    // overwrite and remove some keys while they move
+    KeyValueDB::Transaction t = db->get_transaction();
+    size_t i = 0;
+    for (auto d = data.begin(); d != data.end(); ++i) {
+      string prefix;
+      string key;
+      RocksDBStore::split_key(d->first, &prefix, &key);
+      if (prefix != "D" && prefix != "Evade") {
+	++d;
+      } else if (i % 11 == 0) {
+	t->rmkey(prefix, key);
+	d = data.erase(d);
+      } else if (i % 7 == 0) {
+	d->second = "updated";
+	bufferlist v;
+	v.append(d->second);
+	t->set(prefix, key, v);
+	++d;
+      } else {
+	++d;
+      }
+    }
+    ASSERT_EQ(db->submit_transaction_sync(t), 0);
+  }
+  check_db();
+  struct stat st;
+  for (int i = 0;
+       i < 600 && ::stat("sharding/online", &st) == 0;
+       i++) {
+    usleep(100000);
+  }
+  ASSERT_NE(::stat("sharding/online", &st), 0);
+  check_db();
+  db->close();
+  g_conf().set_val("rocksdb_online_reshard_keys_per_batch", "1000");
+  g_conf().set_val("rocksdb_online_reshard_sleep", "0");
+
+  std::string sharding;
+  ASSERT_TRUE(db->get_sharding(sharding));
+  ASSERT_EQ(sharding, "C(1) D Evade(4)");
+  ASSERT_EQ(db->open(cout), 0);
+  check_db();
+  db->close();
+}
+
 
 INSTANTIATE_TEST_SUITE_P(
   KeyValueDB,
@@ -313,6 +313,144 @@ TEST_F(OSDMapTest, PrimaryIsFirst) {
   EXPECT_EQ(acting_osds[0], acting_primary);
 }
 
+TEST_F(OSDMapTest, IncrementalMapping) {
+  set_up_map();
+  ThreadPool tp(g_ceph_context, "IncrementalMapping::tp", "inc_mapping_tp", 2);
+  tp.start();
+  ParallelPGMapper mapper(g_ceph_context, &tp);
+  auto check_mapping = [&]() {
+    ASSERT_EQ(osdmap.get_epoch(), mapping.get_epoch());
+    for (auto& [pool, pi] : osdmap.get_pools()) {
+      for (unsigned ps = 0; ps < pi.get_pg_num(); ++ps) {
+	pg_t pgid(ps, pool);
+	vector<int> up, acting, up2, acting2;
+	int up_primary, acting_primary, up_primary2, acting_primary2;
+	osdmap.pg_to_up_acting_osds(pgid, &up, &up_primary,
+				    &acting, &acting_primary);
+	mapping.get(pgid, &up2, &up_primary2, &acting2, &acting_primary2);
+	ASSERT_EQ(up, up2) << pgid;
+	ASSERT_EQ(up_primary, up_primary2) << pgid;
+	ASSERT_EQ(acting, acting2) << pgid;
+	ASSERT_EQ(acting_primary, acting_primary2) << pgid;
+      }
+    }
+  };
+  auto job = mapping.start_update(osdmap, mapper, 16);
+  job->wait();
+  check_mapping();
+
+  // mark an osd down, and add a pg_temp and an upmap
+  pg_t temp_pgid(0, my_rep_pool);
+  pg_t upmap_pgid(1, my_rep_pool);
+  vector<int> up;
+  osdmap.pg_to_up_acting_osds(upmap_pgid, up, up);
+  int to = -1;
+  for (unsigned i = 0; i < get_num_osds(); ++i) {
+    if (std::find(up.begin(), up.end(), (int)i) == up.end()) {
+      to = i;
+      break;
+    }
+  }
+  ASSERT_NE(-1, to);
+  {
+    OSDMap::Incremental inc(osdmap.get_epoch() + 1);
+    inc.new_state[0] = CEPH_OSD_UP;
+    inc.new_pg_temp[temp_pgid] = mempool::osdmap::vector<int>{3, 4, 5};
+    inc.new_pg_upmap_items[upmap_pgid] =
+      mempool::osdmap::vector<pair<int32_t,int32_t>>{{up[0], to}};
+    osdmap.apply_incremental(inc);
+    mapping.note_incremental(inc);
+  }
+  job = mapping.start_update(osdmap, mapper, 16);
+  job->wait();
+  check_mapping();
+
+  // nothing changed
+  job = mapping.start_update(osdmap, mapper, 16);
+  ASSERT_TRUE(job->is_done());
+  check_mapping();
+
+  // bring the osd back up and drop the upmap, across two epochs
+  {
+    OSDMap::Incremental inc(osdmap.get_epoch() + 1);
+    entity_addrvec_t sample_addrs;
+    sample_addrs.v.push_back(entity_addr_t());
+    inc.new_up_client[0] = sample_addrs;
+    inc.new_up_cluster[0] = sample_addrs;
+    inc.new_hb_back_up[0] = sample_addrs;
+    inc.new_hb_front_up[0] = sample_addrs;
+    osdmap.apply_incremental(inc);
+    mapping.note_incremental(inc);
+  }
+  {
+    OSDMap::Incremental inc(osdmap.get_epoch() + 1);
+    inc.old_pg_upmap_items.insert(upmap_pgid);
+    osdmap.apply_incremental(inc);
+    mapping.note_incremental(inc);
+  }
+  job = mapping.start_update(osdmap, mapper, 16);
+  job->wait();
+  check_mapping();
+
+  // a skipped epoch falls back to a full update
+  {
+    OSDMap::Incremental inc(osdmap.get_epoch() + 1);
+    inc.new_primary_affinity[1] = 0;
+    osdmap.apply_incremental(inc);
+  }
+  {
+    OSDMap::Incremental inc(osdmap.get_epoch() + 1);
+    inc.new_primary_affinity[2] = 0;
+    osdmap.apply_incremental(inc);
+    mapping.note_incremental(inc);
+  }
+  job = mapping.start_update(osdmap, mapper, 16);
+  job->wait();
+  check_mapping();
+  tp.stop();
+}
+
+TEST_F(OSDMapTest, DeepishCopyIsolated) {
+  set_up_map();
+  pg_t pgid(0, my_rep_pool);
+  vector<int> old_acting;
+  osdmap.pg_to_acting_osds(pgid, old_acting);
+  ASSERT_EQ(3u, old_acting.size());
+  vector<int> temp(old_acting.rbegin(), old_acting.rend());
+
+  OSDMap nextmap;
+  nextmap.deepish_copy_from(osdmap);
+  OSDMap::Incremental inc(nextmap.get_epoch() + 1);
+  inc.new_pg_temp[pgid] =
+    mempool::osdmap::vector<int>(temp.begin(), temp.end());
+  inc.new_primary_temp[pgid] = temp[1];
+  inc.new_primary_affinity[1] = 0;
+  inc.new_up_client[2] = entity_addrvec_t();
+  inc.new_hb_back_up[2] = entity_addrvec_t();
+  inc.new_hb_front_up[2] = entity_addrvec_t();
+  inc.new_uuid[0] = uuid_d();
+  ASSERT_EQ(0, nextmap.apply_incremental(inc));
+
+  // the old epoch must not see any of it
+  vector<int> acting;
+  int acting_primary;
+  ASSERT_EQ(0u, osdmap.get_num_pg_temp());
+  osdmap.pg_to_acting_osds(pgid, acting);
+  ASSERT_EQ(old_acting, acting);
+  ASSERT_EQ(CEPH_OSD_DEFAULT_PRIMARY_AFFINITY,
+	    osdmap.get_primary_affinity(1));
+  ASSERT_NE(entity_addrvec_t(), osdmap.get_addrs(2));
+  ASSERT_NE(uuid_d(), osdmap.get_uuid(0));
+
+  ASSERT_EQ(1u, nextmap.get_num_pg_temp());
+  nextmap.pg_to_acting_osds(pgid, &acting, &acting_primary);
+  ASSERT_EQ(temp, acting);
+  ASSERT_EQ(temp[1], acting_primary);
+  ASSERT_EQ(0u, nextmap.get_primary_affinity(1));
+  ASSERT_EQ(entity_addrvec_t(), nextmap.get_addrs(2));
+  ASSERT_EQ(uuid_d(), nextmap.get_uuid(0));
+}
+
 TEST_F(OSDMapTest, PGTempRespected) {
   set_up_map();
 
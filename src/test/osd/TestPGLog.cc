@@ -3243,6 +3243,176 @@ TEST_F(PGLogTrimTest, TestCopyAfter2) {
   EXPECT_EQ(7u, copy.dups.size()) << copy;
 }
 
+class PGLogBatchTest : protected PGLog, public PGLogTestBase,
+		       public StoreTestFixture {
+public:
+  PGLogBatchTest() : PGLog(g_ceph_context), StoreTestFixture("memstore") {}
+
+  void SetUp() override {
+    StoreTestFixture::SetUp();
+    ObjectStore::Transaction t;
+    test_coll = coll_t(spg_t(pg_t(1, 1)));
+    ch = store->create_new_collection(test_coll);
+    t.create_collection(test_coll, 0);
+    store->queue_transaction(ch, std::move(t));
+    hobject_t hoid;
+    hoid.pool = 1;
+    hoid.oid = "log";
+    log_oid = ghobject_t(hoid);
+    // log_keys_debug only knows about per-entry keys
+    pg_log_debug = false;
+  }
+
+  void TearDown() override {
+    clear();
+    StoreTestFixture::TearDown();
+  }
+
+  void add_entries(unsigned from, unsigned to) {
+    for (unsigned v = from; v <= to; ++v) {
+      log.log.push_back(mk_ple_mod(mk_obj(v), mk_evt(1, v), mk_evt(1, v - 1)));
+      mark_writeout_from(log.log.back().version);
+    }
+    log.head = log.log.back().version;
+  }
+
+  void trim_to(unsigned v) {
+    while (!log.log.empty() && log.log.front().version.version <= v) {
+      trimmed.insert(log.log.front().version);
+      log.log.pop_front();
+    }
+    log.tail = mk_evt(1, v);
+  }
+
+  void write() {
+    ObjectStore::Transaction t;
+    map<string, bufferlist> km;
+    write_log_and_missing(t, &km, test_coll, log_oid, false);
+    if (!km.empty()) {
+      t.omap_setkeys(test_coll, log_oid, km);
+    }
+    ASSERT_EQ(0, store->queue_transaction(ch, std::move(t)));
+  }
+
+  /// number of batch keys and of per-entry keys on disk
+  pair<unsigned, unsigned> count_keys() {
+    pair<unsigned, unsigned> r;
+    auto p = store->get_omap_iterator(ch, log_oid);
+    for (p->seek_to_first(); p->valid(); p->next()) {
+      if (p->key().compare(0, 10, "log_batch_") == 0 &&
+	  p->key() != "log_batch_entries") {
+	++r.first;
+      } else if (isdigit(p->key()[0])) {
+	++r.second;
+      }
+    }
+    return r;
+  }
+
+  void check_roundtrip() {
+    auto orig = log.log;
+    pg_info_t info;
+    info.last_update = log.head;
+    info.log_tail = log.tail;
+    clear();
+    ostringstream err;
+    read_log_and_missing(store.get(), ch, log_oid, info, err, false);
+    ASSERT_EQ(orig.size(), log.log.size());
+    auto p = log.log.begin();
+    for (auto& e : orig) {
+      EXPECT_EQ(e.version, p->version);
+      EXPECT_EQ(e.soid, p->soid);
+      ++p;
+    }
+  }
+
+  coll_t test_coll;
+  ObjectStore::CollectionHandle ch;
+  ghobject_t log_oid;
+};
+
+TEST_F(PGLogBatchTest, AppendTrim) {
+  log_batch = 4;
+  // batches 0 (1-3), 1 (4-7), 2 (8-10)
+  add_entries(1, 10);
+  write();
+  EXPECT_EQ(make_pair(3u, 0u), count_keys());
+  check_roundtrip();
+
+  // fills batch 2 and starts batch 3
+  add_entries(11, 13);
+  write();
+  EXPECT_EQ(make_pair(4u, 0u), count_keys());
+  check_roundtrip();
+
+  // drops batches 0 and 1, rewrites batch 2 with just 10 and 11
+  trim_to(9);
+  write();
+  EXPECT_EQ(make_pair(2u, 0u), count_keys());
+  check_roundtrip();
+  EXPECT_EQ(mk_evt(1, 10), log.log.front().version);
+}
+
+TEST_F(PGLogBatchTest, ChangeFormat) {
+  add_entries(1, 10);
+  write();
+  EXPECT_EQ(make_pair(0u, 10u), count_keys());
+
+  // reading per-entry keys with batching on schedules a rewrite
+  log_batch = 4;
+  check_roundtrip();
+  EXPECT_TRUE(needs_write());
+  write();
+  EXPECT_EQ(make_pair(3u, 0u), count_keys());
+  check_roundtrip();
+  EXPECT_FALSE(needs_write());
+
+  // and back
+  log_batch = 0;
+  check_roundtrip();
+  EXPECT_TRUE(needs_write());
+  write();
+  EXPECT_EQ(make_pair(0u, 10u), count_keys());
+  check_roundtrip();
+}
+
+TEST(PGLogDupIndex, insert_erase) {
+  // dups are added at the head and trimmed from the tail; run a window
+  // of them through the index and check every lookup along the way
+  std::list<pg_log_dup_t> dups;
+  PGLogDupIndex index;
+  const unsigned window = 100;
+  for (unsigned i = 1; i <= 2000; ++i) {
+    pg_log_dup_t d;
+    d.reqid = osd_reqid_t(entity_name_t::CLIENT(i % 7), 0, i);
+    d.version = eversion_t(1, i);
+    dups.push_back(d);
+    index.insert(&dups.back());
+    if (dups.size() > window) {
+      index.erase(dups.front().reqid);
+      dups.pop_front();
+    }
+    ASSERT_EQ(dups.size(), index.size());
+  }
+  for (auto& d : dups) {
+    EXPECT_EQ(&d, index.find(d.reqid));
+  }
+  for (unsigned i = 1; i <= 2000 - window; ++i) {
+    EXPECT_EQ(nullptr,
+	      index.find(osd_reqid_t(entity_name_t::CLIENT(i % 7), 0, i)));
+  }
+
+  // a second dup for the same reqid replaces the first
+  pg_log_dup_t again = dups.back();
+  index.insert(&again);
+  EXPECT_EQ(dups.size(), index.size());
+  EXPECT_EQ(&again, index.find(again.reqid));
+
+  index.clear();
+  EXPECT_TRUE(index.empty());
+  EXPECT_EQ(nullptr, index.find(again.reqid));
+}
+
 // Local Variables:
 // compile-command: "cd ../.. ; make unittest_pglog ; ./unittest_pglog --log-to-stderr=true  --debug-osd=20 # --gtest_filter=*.* "
 // End:
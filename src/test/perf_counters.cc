@@ -190,6 +190,99 @@ TEST(PerfCounters, MultiplePerfCounters) {
   ASSERT_EQ("{}", msg);
 }
 
+TEST(PerfCounters, BinaryDump) {
+  PerfCountersCollection *coll = g_ceph_context->get_perfcounters_collection();
+  coll->clear();
+  PerfCounters* fake_pf1 = setup_test_perfcounters1(g_ceph_context);
+  PerfCounters* fake_pf2 = setup_test_perfcounter2(g_ceph_context);
+  coll->add(fake_pf1);
+  coll->add(fake_pf2);
+  fake_pf1->inc(TEST_PERFCOUNTERS1_ELEMENT_1, 7);
+  fake_pf1->tset(TEST_PERFCOUNTERS1_ELEMENT_2, utime_t(0, 500000000));
+  fake_pf1->tinc(TEST_PERFCOUNTERS1_ELEMENT_3, utime_t(2, 0));
+  fake_pf1->tinc(TEST_PERFCOUNTERS1_ELEMENT_3, utime_t(4, 0));
+  fake_pf2->inc(TEST_PERFCOUNTERS2_ELEMENT_FOO, 3);
+  AdminSocketClient client(get_rand_socket_path());
+  std::string msg;
+
+  ASSERT_EQ("", client.do_request("{ \"prefix\": \"perf binary schema\" }", &msg));
+  bufferlist bl;
+  bl.append(msg);
+  auto p = bl.cbegin();
+  uint64_t generation;
+  std::vector<std::pair<std::string, std::vector<std::string>>> schema;
+  {
+    DECODE_START(1, p);
+    decode(generation, p);
+    uint32_t num_loggers;
+    decode(num_loggers, p);
+    for (uint32_t i = 0; i < num_loggers; ++i) {
+      std::string logger;
+      uint32_t num_counters;
+      decode(logger, p);
+      decode(num_counters, p);
+      std::vector<std::string> names;
+      for (uint32_t j = 0; j < num_counters; ++j) {
+	std::string name, description, nick;
+	uint8_t type, unit, prio;
+	decode(name, p);
+	decode(description, p);
+	decode(nick, p);
+	decode(type, p);
+	decode(unit, p);
+	decode(prio, p);
+	ASSERT_FALSE(type & PERFCOUNTER_HISTOGRAM);
+	names.push_back(name);
+      }
+      schema.emplace_back(logger, names);
+    }
+    DECODE_FINISH(p);
+  }
+  ASSERT_EQ(2u, schema.size());
+  ASSERT_EQ("test_perfcounter_1", schema[0].first);
+  ASSERT_EQ(std::vector<std::string>({"element1", "element2", "element3"}),
+	    schema[0].second);
+  ASSERT_EQ("test_perfcounter_2", schema[1].first);
+  ASSERT_EQ(std::vector<std::string>({"foo", "bar"}), schema[1].second);
+
+  ASSERT_EQ("", client.do_request("{ \"prefix\": \"perf binary dump\" }", &msg));
+  bl.clear();
+  bl.append(msg);
+  p = bl.cbegin();
+  {
+    DECODE_START(1, p);
+    uint64_t g;
+    decode(g, p);
+    ASSERT_EQ(generation, g);
+    std::vector<uint64_t> values;
+    for (unsigned i = 0; i < 6; ++i) {
+      uint64_t v;
+      decode(v, p);
+      values.push_back(v);
+    }
+    // element3 is a <sum, count> pair
+    ASSERT_EQ(std::vector<uint64_t>({7, 500000000, 6000000000, 2, 3, 0}),
+	      values);
+    DECODE_FINISH(p);
+  }
+
+  // the generation tells the schema is stale
+  coll->remove(fake_pf2);
+  ASSERT_EQ("", client.do_request("{ \"prefix\": \"perf binary dump\" }", &msg));
+  bl.clear();
+  bl.append(msg);
+  p = bl.cbegin();
+  {
+    DECODE_START(1, p);
+    uint64_t g;
+    decode(g, p);
+    ASSERT_NE(generation, g);
+    DECODE_FINISH(p);
+  }
+  delete fake_pf2;
+  coll->clear();
+}
+
 TEST(PerfCounters, ResetPerfCounters) {
   AdminSocketClient client(get_rand_socket_path());
   std::string msg;
@@ -252,4 +345,44 @@ TEST(PerfCounters, read_avg) {
   std::thread t2(counters_readavg_test, fake_pf);
   t2.join();
   t1.join();
-}
\ No newline at end of file
+}
+enum {
+  TEST_PERFCOUNTERS4_ELEMENT_FIRST = 500,
+  TEST_PERFCOUNTERS4_ELEMENT_COUNT,
+  TEST_PERFCOUNTERS4_ELEMENT_LAT,
+  TEST_PERFCOUNTERS4_ELEMENT_LAST,
+};
+
+TEST(PerfCounters, Sharded) {
+  PerfCountersBuilder bld(g_ceph_context, "test_perfcounter_4",
+      TEST_PERFCOUNTERS4_ELEMENT_FIRST, TEST_PERFCOUNTERS4_ELEMENT_LAST);
+  bld.set_sharded(true);
+  bld.add_u64_counter(TEST_PERFCOUNTERS4_ELEMENT_COUNT, "count");
+  bld.add_time_avg(TEST_PERFCOUNTERS4_ELEMENT_LAT, "lat");
+  std::shared_ptr<PerfCounters> fake_pf(bld.create_perf_counters());
+
+  utime_t t;
+  t.set_from_double(0.000000001);
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 20; ++i) {
+    threads.emplace_back([&] {
+      for (int j = 0; j < 10000; ++j) {
+	fake_pf->inc(TEST_PERFCOUNTERS4_ELEMENT_COUNT);
+	fake_pf->tinc(TEST_PERFCOUNTERS4_ELEMENT_LAT, t);
+      }
+    });
+  }
+  for (auto& th : threads) {
+    th.join();
+  }
+  ASSERT_EQ(200000u, fake_pf->get(TEST_PERFCOUNTERS4_ELEMENT_COUNT));
+  auto avg = fake_pf->get_tavg_ns(TEST_PERFCOUNTERS4_ELEMENT_LAT);
+  ASSERT_EQ(200000u, avg.first);
+  ASSERT_EQ(200000u, avg.second);
+
+  fake_pf->set(TEST_PERFCOUNTERS4_ELEMENT_COUNT, 5);
+  ASSERT_EQ(5u, fake_pf->get(TEST_PERFCOUNTERS4_ELEMENT_COUNT));
+  fake_pf->reset();
+  ASSERT_EQ(0u, fake_pf->get(TEST_PERFCOUNTERS4_ELEMENT_COUNT));
+  ASSERT_EQ(0u, fake_pf->get_tavg_ns(TEST_PERFCOUNTERS4_ELEMENT_LAT).second);
+}
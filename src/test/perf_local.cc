@@ -28,6 +28,12 @@
 // run.  If no test names are provided then all of the performance tests
 // are run.
 //
+// With --format json (or json-pretty), the results are printed as a JSON
+// document, which can be saved and given back with --baseline <file> to
+// a later run: each test is then compared with its time in that run, and
+// the program exits with 1 if any got more than --tolerance percent
+// (10 by default) slower.
+//
 // To add a new test:
 // * Write a function that implements the test.  Use existing test functions
 //   as a guideline, and be sure to generate output in the same form as
@@ -51,6 +57,12 @@
 #include "common/ceph_mutex.h"
 #include "common/Thread.h"
 #include "common/Timer.h"
+#include "common/Formatter.h"
+#include "common/Throttle.h"
+#include "common/ceph_json.h"
+#include "common/perf_counters.h"
+#include "messages/MOSDOp.h"
+#include "osd/OSDMap.h"
 #include "msg/async/Event.h"
 #include "global/global_init.h"
 
@@ -303,6 +315,43 @@ double buffer_iterator()
   return Cycles::to_seconds(stop - start)/count;
 }
 
+// Measure the cost of gathering a buffer of 16 ptrs into a single ptr.
+double buffer_rebuild()
+{
+  int count = 100000;
+  bufferptr ptr(256);
+  memset(ptr.c_str(), 'a', ptr.length());
+  uint64_t total = 0;
+  for (int i = 0; i < count; i++) {
+    bufferlist b;
+    for (int j = 0; j < 16; j++) {
+      b.append(ptr);
+    }
+    uint64_t start = Cycles::rdtsc();
+    b.rebuild();
+    total += Cycles::rdtsc() - start;
+  }
+  return Cycles::to_seconds(total)/count;
+}
+
+// Measure the cost of the crc32c of a 4KB buffer.
+double buffer_crc32c()
+{
+  int count = 100000;
+  bufferlist b;
+  b.append_zero(4096);
+  uint32_t crc = 0;
+  uint64_t start = Cycles::rdtsc();
+  for (int i = 0; i < count; i++) {
+    // or the crc of the ptr is taken from its cache
+    b.invalidate_crc();
+    crc += b.crc32c(i);
+  }
+  uint64_t stop = Cycles::rdtsc();
+  discard(&crc);
+  return Cycles::to_seconds(stop - start)/count;
+}
+
 // Implements the CondPingPong test.
 class CondPingPong {
   ceph::mutex mutex = ceph::make_mutex("CondPingPong::mutex");
@@ -914,6 +963,157 @@ double perf_ceph_clock_now()
   return Cycles::to_seconds(stop - start)/count;
 }
 
+// Measure the cost of comparing two hobject_ts.
+double hobject_compare()
+{
+  int count = 1000000;
+  std::vector<hobject_t> objs;
+  for (int i = 0; i < 1024; i++) {
+    char name[32];
+    snprintf(name, sizeof(name), "rbd_data.%08x", i);
+    objs.emplace_back(object_t(name), "", CEPH_NOSNAP,
+		      ceph_str_hash_rjenkins(name, strlen(name)), 1, "");
+  }
+  int sum = 0;
+  uint64_t start = Cycles::rdtsc();
+  for (int i = 0; i < count; i++) {
+    sum += cmp(objs[i & 1023], objs[(i + 1) & 1023]);
+  }
+  uint64_t stop = Cycles::rdtsc();
+  discard(&sum);
+  return Cycles::to_seconds(stop - start)/count;
+}
+
+// Measure the cost of encoding and decoding an MOSDOp with a write op.
+double mosdop_encode_decode()
+{
+  int count = 100000;
+  hobject_t hoid(object_t("rbd_data.1"), "", CEPH_NOSNAP, 0x1234, 1, "");
+  spg_t pgid(pg_t(1, 1));
+  bufferlist data;
+  data.append_zero(4096);
+  uint64_t start = Cycles::rdtsc();
+  for (int i = 0; i < count; i++) {
+    auto m = ceph::make_message<MOSDOp>(0, i, hoid, pgid, 1,
+					CEPH_OSD_FLAG_WRITE,
+					CEPH_FEATURES_SUPPORTED_DEFAULT);
+    m->write(0, data.length(), data);
+    m->encode_payload(CEPH_FEATURES_SUPPORTED_DEFAULT);
+    auto d = ceph::make_message<MOSDOp>();
+    d->set_header(m->get_header());
+    d->set_payload(m->get_payload());
+    d->set_data(m->get_data());
+    d->decode_payload();
+    d->finish_decode();
+  }
+  uint64_t stop = Cycles::rdtsc();
+  return Cycles::to_seconds(stop - start)/count;
+}
+
+// an OSDMap of 64 OSDs with a replicated pool, for the tests below
+static OSDMap& get_osdmap()
+{
+  static OSDMap osdmap;
+  if (!osdmap.get_epoch()) {
+    uuid_d fsid;
+    osdmap.build_simple_with_pool(g_ceph_context, 0, fsid, 64, 6, 6);
+    OSDMap::Incremental inc(osdmap.get_epoch() + 1);
+    inc.fsid = osdmap.get_fsid();
+    entity_addrvec_t addrs;
+    addrs.v.push_back(entity_addr_t());
+    for (int i = 0; i < 64; i++) {
+      addrs.v[0].nonce = i;
+      inc.new_state[i] = CEPH_OSD_EXISTS | CEPH_OSD_NEW;
+      inc.new_up_client[i] = addrs;
+      inc.new_up_cluster[i] = addrs;
+      inc.new_hb_back_up[i] = addrs;
+      inc.new_hb_front_up[i] = addrs;
+      inc.new_weight[i] = CEPH_OSD_IN;
+    }
+    osdmap.apply_incremental(inc);
+  }
+  return osdmap;
+}
+
+// Measure the cost of encoding an OSDMap.
+double osdmap_encode()
+{
+  int count = 1000;
+  OSDMap& osdmap = get_osdmap();
+  uint64_t start = Cycles::rdtsc();
+  for (int i = 0; i < count; i++) {
+    bufferlist bl;
+    osdmap.encode(bl, CEPH_FEATURES_SUPPORTED_DEFAULT | CEPH_FEATURE_RESERVED);
+  }
+  uint64_t stop = Cycles::rdtsc();
+  return Cycles::to_seconds(stop - start)/count;
+}
+
+// Measure the cost of decoding an OSDMap.
+double osdmap_decode()
+{
+  int count = 1000;
+  bufferlist bl;
+  get_osdmap().encode(bl, CEPH_FEATURES_SUPPORTED_DEFAULT | CEPH_FEATURE_RESERVED);
+  uint64_t start = Cycles::rdtsc();
+  for (int i = 0; i < count; i++) {
+    OSDMap osdmap;
+    osdmap.decode(bl);
+  }
+  uint64_t stop = Cycles::rdtsc();
+  return Cycles::to_seconds(stop - start)/count;
+}
+
+// Measure the cost of mapping an input to 3 OSDs with crush.
+double crush_do_rule()
+{
+  int count = 100000;
+  OSDMap& osdmap = get_osdmap();
+  std::vector<__u32> weights(osdmap.get_max_osd(), 0x10000);
+  std::vector<int> out;
+  uint64_t start = Cycles::rdtsc();
+  for (int i = 0; i < count; i++) {
+    osdmap.crush->do_rule(0, i, out, 3, weights, 0);
+  }
+  uint64_t stop = Cycles::rdtsc();
+  return Cycles::to_seconds(stop - start)/count;
+}
+
+// Measure the cost of incrementing a perf counter.
+double perf_counters_inc()
+{
+  enum {
+    l_first = 0,
+    l_counter,
+    l_last,
+  };
+  PerfCountersBuilder b(g_ceph_context, "perf_local", l_first, l_last);
+  b.add_u64_counter(l_counter, "counter");
+  std::unique_ptr<PerfCounters> logger{b.create_perf_counters()};
+  int count = 1000000;
+  uint64_t start = Cycles::rdtsc();
+  for (int i = 0; i < count; i++) {
+    logger->inc(l_counter);
+  }
+  uint64_t stop = Cycles::rdtsc();
+  return Cycles::to_seconds(stop - start)/count;
+}
+
+// Measure the cost of taking and putting back a Throttle unit, without
+// blocking.
+double throttle_get_put()
+{
+  Throttle throttle(g_ceph_context, "perf_local", 1000, false);
+  int count = 1000000;
+  uint64_t start = Cycles::rdtsc();
+  for (int i = 0; i < count; i++) {
+    throttle.get();
+    throttle.put();
+  }
+  uint64_t stop = Cycles::rdtsc();
+  return Cycles::to_seconds(stop - start)/count;
+}
+
 // The following struct and table define each performance test in terms of
 // a string name and a function that implements the test.
 struct TestInfo {
@@ -950,6 +1150,10 @@ TestInfo tests[] = {
     "buffer encoding 10 structures onto existing ptr"},
   {"buffer_iterator", buffer_iterator,
     "iterate over buffer with 5 ptrs"},
+  {"buffer_rebuild", buffer_rebuild,
+    "rebuild a buffer of 16 256B ptrs"},
+  {"buffer_crc32c", buffer_crc32c,
+    "crc32c of a 4KB buffer"},
   {"cond_ping_pong", cond_ping_pong,
     "condition variable round-trip"},
   {"div32", div32,
@@ -968,15 +1172,15 @@ TestInfo tests[] = {
     "Copy 1000 bytes with memcpy"},
   {"memcpy10000", memcpy10000,
     "Copy 10000 bytes with memcpy"},
-  {"ceph_str_hash_rjenkins", ceph_str_hash_rjenkins<16>,
+  {"ceph_str_hash_rjenkins16", ceph_str_hash_rjenkins<16>,
     "rjenkins hash on 16 byte of data"},
-  {"ceph_str_hash_rjenkins", ceph_str_hash_rjenkins<256>,
+  {"ceph_str_hash_rjenkins256", ceph_str_hash_rjenkins<256>,
     "rjenkins hash on 256 bytes of data"},
   {"rdtsc", rdtsc_test,
     "Read the fine-grain cycle counter"},
   {"cycles_to_seconds", perf_cycles_to_seconds,
     "Convert a rdtsc result to (double) seconds"},
-  {"cycles_to_seconds", perf_cycles_to_nanoseconds,
+  {"cycles_to_nanoseconds", perf_cycles_to_nanoseconds,
     "Convert a rdtsc result to (uint64_t) nanoseconds"},
   {"prefetch", perf_prefetch,
     "Prefetch instruction"},
@@ -1004,10 +1208,64 @@ TestInfo tests[] = {
     "Push and pop a std::vector"},
   {"ceph_clock_now", perf_ceph_clock_now,
    "ceph_clock_now function"},
+  {"hobject_compare", hobject_compare,
+    "Compare two hobject_ts"},
+  {"mosdop_encode_decode", mosdop_encode_decode,
+    "Encode and decode an MOSDOp of a 4KB write"},
+  {"osdmap_encode", osdmap_encode,
+    "Encode an OSDMap of 64 OSDs"},
+  {"osdmap_decode", osdmap_decode,
+    "Decode an OSDMap of 64 OSDs"},
+  {"crush_do_rule", crush_do_rule,
+    "Map an input to 3 of 64 OSDs with crush"},
+  {"perf_counters_inc", perf_counters_inc,
+    "Increment a PerfCounters counter"},
+  {"throttle_get_put", throttle_get_put,
+    "Throttle get and put, no blocking"},
+};
+
+/// the times of a previous run to compare with, by test name
+static std::map<std::string, double> baseline;
+static double tolerance = 10;
+static int regressions = 0;
+static Formatter *formatter = nullptr;
+
+struct BaselineResult {
+  std::string name;
+  double seconds = 0;
+
+  void decode_json(JSONObj *obj) {
+    JSONDecoder::decode_json("name", name, obj);
+    // there is no decoder for floats
+    std::string secs;
+    JSONDecoder::decode_json("seconds", secs, obj);
+    seconds = strtod(secs.c_str(), nullptr);
+  }
 };
 
+static int load_baseline(const std::string& path)
+{
+  JSONParser parser;
+  if (!parser.parse(path.c_str())) {
+    std::cerr << "unable to parse baseline " << path << std::endl;
+    return -EINVAL;
+  }
+  std::vector<BaselineResult> results;
+  try {
+    JSONDecoder::decode_json("tests", results, &parser, true);
+  } catch (const JSONDecoder::err& e) {
+    std::cerr << "bad baseline " << path << ": " << e.what() << std::endl;
+    return -EINVAL;
+  }
+  for (auto& r : results) {
+    baseline[r.name] = r.seconds;
+  }
+  return 0;
+}
+
 /**
- * Runs a particular test and prints a one-line result message.
+ * Runs a particular test and prints a one-line result message, or its
+ * JSON object.
  *
  * \param info
  *      Describes the test to run.
@@ -1015,6 +1273,30 @@ TestInfo tests[] = {
 void run_test(TestInfo& info)
 {
   double secs = info.func();
+  bool compared = false, regressed = false;
+  double change = 0;
+  if (auto p = baseline.find(info.name);
+      secs != -1 && p != baseline.end() && p->second > 0) {
+    compared = true;
+    change = (secs - p->second) * 100 / p->second;
+    regressed = change > tolerance;
+    if (regressed) {
+      ++regressions;
+    }
+  }
+  if (formatter) {
+    formatter->open_object_section("test");
+    formatter->dump_string("name", info.name);
+    formatter->dump_string("description", info.description);
+    formatter->dump_float("seconds", secs);
+    if (compared) {
+      formatter->dump_float("baseline_seconds", baseline[info.name]);
+      formatter->dump_float("change_percent", change);
+      formatter->dump_bool("regression", regressed);
+    }
+    formatter->close_section();
+    return;
+  }
   int width = printf("%-24s ", info.name);
   if (secs == -1) {
     width += printf(" architecture nonsupport ");
@@ -1027,7 +1309,11 @@ void run_test(TestInfo& info)
   } else {
     width += printf("%8.2fs", secs);
   }
-  printf("%*s %s\n", 32-width, "", info.description);
+  printf("%*s %s", 32-width, "", info.description);
+  if (compared) {
+    printf(" (%+.1f%% vs baseline%s)", change, regressed ? ", REGRESSION" : "");
+  }
+  printf("\n");
 }
 
 int main(int argc, char *argv[])
@@ -1041,27 +1327,68 @@ int main(int argc, char *argv[])
   common_init_finish(g_ceph_context);
   Cycles::init();
 
+  std::string format, val;
+  vector<const char*> names;
+  for (auto i = args.begin(); i != args.end(); ) {
+    if (ceph_argparse_double_dash(args, i)) {
+      break;
+    } else if (ceph_argparse_witharg(args, i, &val, "--format", (char*)NULL)) {
+      format = val;
+    } else if (ceph_argparse_witharg(args, i, &val, "--baseline", (char*)NULL)) {
+      if (load_baseline(val) < 0) {
+	return 1;
+      }
+    } else if (ceph_argparse_witharg(args, i, &val, "--tolerance", (char*)NULL)) {
+      tolerance = atof(val.c_str());
+    } else {
+      names.push_back(*i);
+      ++i;
+    }
+  }
+  std::unique_ptr<Formatter> f;
+  if (!format.empty()) {
+    f.reset(Formatter::create(format));
+    if (!f) {
+      std::cerr << "unknown format " << format << std::endl;
+      return 1;
+    }
+    formatter = f.get();
+    formatter->open_object_section("perf_local");
+    formatter->open_array_section("tests");
+  }
+
   bind_thread_to_cpu(3);
-  if (argc == 1) {
+  if (names.empty()) {
     // No test names specified; run all tests.
     for (size_t i = 0; i < sizeof(tests)/sizeof(TestInfo); ++i) {
       run_test(tests[i]);
     }
   } else {
     // Run only the tests that were specified on the command line.
-    for (int i = 1; i < argc; i++) {
+    for (auto name : names) {
       bool found_test = false;
       for (size_t j = 0; j < sizeof(tests)/sizeof(TestInfo); ++j) {
-        if (strcmp(argv[i], tests[j].name) == 0) {
+        if (strcmp(name, tests[j].name) == 0) {
           found_test = true;
           run_test(tests[j]);
           break;
         }
       }
       if (!found_test) {
-        int width = printf("%-24s ??", argv[i]);
+        if (formatter) {
+          std::cerr << name << ": no such test" << std::endl;
+          continue;
+        }
+        int width = printf("%-24s ??", name);
         printf("%*s No such test\n", 32-width, "");
       }
     }
   }
+  if (formatter) {
+    formatter->close_section(); // tests
+    formatter->close_section(); // perf_local
+    formatter->flush(std::cout);
+    std::cout << std::endl;
+  }
+  return regressions ? 1 : 0;
 }
@@ -264,6 +264,8 @@ struct Threads<librbd::MockTestImageCtx> {
 
   MockContextWQ *work_queue;
 
+  TokenBucketThrottle *image_sync_throttle = nullptr;
+
   Threads(Threads<librbd::ImageCtx>* threads)
     : timer(new MockSafeTimer()),
       timer_lock(threads->timer_lock),
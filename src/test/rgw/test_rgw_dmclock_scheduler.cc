@@ -81,12 +81,12 @@ TEST(Queue, RateLimit)
   boost::asio::io_context context;
   ClientCounters counters(g_ceph_context);
   AsyncScheduler queue(g_ceph_context, context, std::ref(counters), nullptr,
-                  [] (client_id client) -> ClientInfo* {
+                  [] (const client_key_t& client) -> ClientInfo* {
       static ClientInfo clients[] = {
         {1, 1, 1}, // admin
         {0, 1, 1}, // auth
       };
-      return &clients[static_cast<size_t>(client)];
+      return &clients[static_cast<size_t>(client.type)];
     }, AtLimit::Reject);
 
   std::optional<error_code> ec1, ec2, ec3, ec4;
@@ -137,17 +137,53 @@ TEST(Queue, RateLimit)
   EXPECT_EQ(0u, counters(client_id::auth)->get(queue_counters::l_cancel));
 }
 
+TEST(Queue, PerUserRateLimit)
+{
+  boost::asio::io_context context;
+  ClientCounters counters(g_ceph_context);
+  AsyncScheduler queue(g_ceph_context, context, std::ref(counters), nullptr,
+                  [] (const client_key_t& client) -> ClientInfo* {
+      static ClientInfo user{0, 1, 1};
+      return &user;
+    }, AtLimit::Reject);
+
+  std::optional<error_code> ec1, ec2, ec3;
+  std::optional<PhaseType> p1, p2, p3;
+
+  // the limit of each user applies to its requests only
+  auto now = get_time();
+  queue.async_request({client_id::data, "alice"}, {}, now, 1, capture(ec1, p1));
+  queue.async_request({client_id::data, "alice"}, {}, now, 1, capture(ec2, p2));
+  queue.async_request({client_id::data, "bob"}, {}, now, 1, capture(ec3, p3));
+
+  EXPECT_EQ(2u, counters(client_id::data)->get(queue_counters::l_qlen));
+
+  context.poll();
+  EXPECT_TRUE(context.stopped());
+
+  ASSERT_TRUE(ec1);
+  EXPECT_EQ(boost::system::errc::success, *ec1);
+  ASSERT_TRUE(ec2);
+  EXPECT_EQ(boost::system::errc::resource_unavailable_try_again, *ec2);
+  ASSERT_TRUE(ec3);
+  EXPECT_EQ(boost::system::errc::success, *ec3);
+
+  EXPECT_EQ(0u, counters(client_id::data)->get(queue_counters::l_qlen));
+  EXPECT_EQ(2u, counters(client_id::data)->get(queue_counters::l_prio));
+  EXPECT_EQ(1u, counters(client_id::data)->get(queue_counters::l_limit));
+}
+
 TEST(Queue, AsyncRequest)
 {
   boost::asio::io_context context;
   ClientCounters counters(g_ceph_context);
   AsyncScheduler queue(g_ceph_context, context, std::ref(counters), nullptr,
-                  [] (client_id client) -> ClientInfo* {
+                  [] (const client_key_t& client) -> ClientInfo* {
       static ClientInfo clients[] = {
         {1, 1, 1}, // admin: satisfy by reservation
         {0, 1, 1}, // auth: satisfy by priority
       };
-      return &clients[static_cast<size_t>(client)];
+      return &clients[static_cast<size_t>(client.type)];
 		  }, AtLimit::Reject
 		  );
 
@@ -195,7 +231,7 @@ TEST(Queue, Cancel)
   boost::asio::io_context context;
   ClientCounters counters(g_ceph_context);
   AsyncScheduler queue(g_ceph_context, context, std::ref(counters), nullptr,
-                  [] (client_id client) -> ClientInfo* {
+                  [] (const client_key_t& client) -> ClientInfo* {
       static ClientInfo info{0, 1, 1};
       return &info;
     });
@@ -243,7 +279,7 @@ TEST(Queue, CancelClient)
   boost::asio::io_context context;
   ClientCounters counters(g_ceph_context);
   AsyncScheduler queue(g_ceph_context, context, std::ref(counters), nullptr,
-                  [] (client_id client) -> ClientInfo* {
+                  [] (const client_key_t& client) -> ClientInfo* {
       static ClientInfo info{0, 1, 1};
       return &info;
     });
@@ -299,7 +335,7 @@ TEST(Queue, CancelOnDestructor)
   ClientCounters counters(g_ceph_context);
   {
     AsyncScheduler queue(g_ceph_context, context, std::ref(counters), nullptr,
-                    [] (client_id client) -> ClientInfo* {
+                    [] (const client_key_t& client) -> ClientInfo* {
         static ClientInfo info{0, 1, 1};
         return &info;
       });
@@ -349,7 +385,7 @@ TEST(Queue, CrossExecutorRequest)
   boost::asio::io_context queue_context;
   ClientCounters counters(g_ceph_context);
   AsyncScheduler queue(g_ceph_context, queue_context, std::ref(counters), nullptr,
-                  [] (client_id client) -> ClientInfo* {
+                  [] (const client_key_t& client) -> ClientInfo* {
       static ClientInfo info{0, 1, 1};
       return &info;
     });
@@ -403,12 +439,12 @@ TEST(Queue, SpawnAsyncRequest)
   boost::asio::spawn(context, [&] (boost::asio::yield_context yield) {
     ClientCounters counters(g_ceph_context);
     AsyncScheduler queue(g_ceph_context, context, std::ref(counters), nullptr,
-                    [] (client_id client) -> ClientInfo* {
+                    [] (const client_key_t& client) -> ClientInfo* {
         static ClientInfo clients[] = {
           {1, 1, 1}, // admin: satisfy by reservation
           {0, 1, 1}, // auth: satisfy by priority
         };
-        return &clients[static_cast<size_t>(client)];
+        return &clients[static_cast<size_t>(client.type)];
       });
 
     error_code ec1, ec2;
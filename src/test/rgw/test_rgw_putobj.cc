@@ -194,3 +194,31 @@ TEST(PutObj_Stripe, SkipFirstChunk)
   ASSERT_EQ(4u, mock.ops.size());
   EXPECT_EQ(Op({"", 4}), mock.ops[3]); // flush
 }
+
+TEST(PutObj_MD5, Segments)
+{
+  MockProcessor mock;
+  ceph::crypto::MD5 hash;
+  rgw::putobj::MD5Filter filter(&mock, hash);
+
+  bufferlist bl = string_buf("abc");
+  bl.append(string_buf("defg"));
+  ASSERT_EQ(0, filter.process(std::move(bl), 0));
+  ASSERT_EQ(0, filter.process(string_buf("h"), 7));
+  ASSERT_EQ(0, filter.process({}, 8));
+  ASSERT_EQ(3u, mock.ops.size());
+  EXPECT_EQ(Op({"abcdefg", 0}), mock.ops[0]);
+  EXPECT_EQ(Op({"h", 7}), mock.ops[1]);
+  EXPECT_EQ(Op({"", 8}), mock.ops[2]); // flush
+
+  unsigned char digest[CEPH_CRYPTO_MD5_DIGESTSIZE];
+  hash.Final(digest);
+
+  ceph::crypto::MD5 expected_hash;
+  const std::string data = "abcdefgh";
+  expected_hash.Update(reinterpret_cast<const unsigned char*>(data.data()),
+                       data.size());
+  unsigned char expected[CEPH_CRYPTO_MD5_DIGESTSIZE];
+  expected_hash.Final(expected);
+  EXPECT_EQ(0, memcmp(expected, digest, sizeof(digest)));
+}
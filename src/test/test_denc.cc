@@ -267,6 +267,45 @@ TEST(denc, vector)
   }
 }
 
+TEST(denc, vector_raw)
+{
+  // copied as a whole, but the same on the wire as one by one
+  vector<uint64_t> v(100);
+  std::iota(v.begin(), v.end(), 0x0123456789abcdefull);
+  test_denc(v);
+  {
+    bufferlist bl;
+    encode(v, bl);
+    bufferlist expected;
+    encode((uint32_t)v.size(), expected);
+    for (auto i : v) {
+      encode(i, expected);
+    }
+    ASSERT_EQ(expected, bl);
+  }
+  {
+    vector<ceph_le32> l(10);
+    for (unsigned i = 0; i < l.size(); ++i) {
+      l[i] = i * 0x01010101;
+    }
+    test_denc(l);
+  }
+  {
+    boost::container::small_vector<uint16_t, 4> sv = {1, 2, 3, 4, 5, 6};
+    test_denc(sv);
+  }
+  {
+    // a short buffer throws rather than allocating
+    bufferlist bl;
+    encode((uint32_t)1000000, bl);
+    encode((uint64_t)1, bl);
+    bl.rebuild();
+    auto bpi = bl.front().begin();
+    vector<uint64_t> out;
+    ASSERT_THROW(denc(out, bpi), buffer::end_of_buffer);
+  }
+}
+
 template<typename T>
 using default_list = std::list<T>;
 
@@ -432,6 +432,35 @@ TEST(mempool, check_shard_select)
 }
 
 
+TEST(mempool, thread_caches)
+{
+  size_t before_items = mempool::unittest_1::allocated_items();
+  size_t before_bytes = mempool::unittest_1::allocated_bytes();
+  std::vector<std::thread> workers;
+  mempool::unittest_1::vector<int> kept;
+  std::mutex kept_lock;
+  for (int i = 0; i < 4; i++) {
+    workers.emplace_back([&] {
+      mempool::unittest_1::vector<int> v;
+      for (int j = 0; j < 1000; j++) {
+	v.push_back(j);
+	mempool::unittest_1::list<int> l(j % 10);
+      }
+      std::lock_guard l{kept_lock};
+      kept.insert(kept.end(), v.begin(), v.end());
+    });
+  }
+  for (auto& t : workers) {
+    t.join();
+  }
+  // the workers flushed their counts as they exited
+  kept.shrink_to_fit();
+  EXPECT_EQ(before_items + kept.capacity(),
+	    mempool::unittest_1::allocated_items());
+  EXPECT_EQ(before_bytes + kept.capacity() * sizeof(int),
+	    mempool::unittest_1::allocated_bytes());
+}
+
 int main(int argc, char **argv)
 {
   vector<const char*> args;
@@ -359,6 +359,29 @@ public:
       cur = next.first;
     }
   }
+  void get_next_batch() {
+    string cur;
+    unsigned max = 1 + random_num();
+    while (true) {
+      vector<pair<string, bufferlist>> next;
+      int r = cache->get_next_batch(cur, max, &next);
+      ASSERT_EQ(0, r);
+      ASSERT_LE(next.size(), max);
+
+      map<string, bufferlist>::iterator i = truth.upper_bound(cur);
+      for (auto& n : next) {
+	ASSERT_TRUE(i != truth.end());
+	ASSERT_EQ(n.first, i->first);
+	assert_bl_eq(n.second, i->second);
+	++i;
+      }
+      if (next.size() < max) {
+	ASSERT_TRUE(i == truth.end());
+	break;
+      }
+      cur = next.back().first;
+    }
+  }
   void SetUp() override {
     driver.reset(new PausyAsyncMap());
     cache.reset(new MapCacher::MapCacher<string, bufferlist>(driver.get()));
@@ -413,7 +436,7 @@ TEST_F(MapCacherTest, Random)
     if (!(i % 50)) {
       std::cout << "On iteration " << i << std::endl;
     }
-    switch (rand() % 4) {
+    switch (rand() % 5) {
     case 0:
       get();
       break;
@@ -426,6 +449,9 @@ TEST_F(MapCacherTest, Random)
     case 3:
       remove();
       break;
+    case 4:
+      get_next_batch();
+      break;
     }
   }
 }
@@ -52,6 +52,43 @@ TEST(Striper, EmptyPartialResult)
   ASSERT_EQ(65536u, outbl.length());
 }
 
+TEST(Striper, StripeCountOne)
+{
+  file_layout_t l;
+  l.stripe_count = 1;
+
+  for (uint32_t object_size : {4194304u, 3000000u}) {
+    l.object_size = object_size;
+    l.stripe_unit = object_size;
+    uint64_t off = object_size - 500000;
+    uint64_t len = 2 * object_size;
+
+    striper::LightweightObjectExtents ex;
+    Striper::file_to_extents(g_ceph_context, &l, off, len, 0, 100, &ex);
+    cout << "result " << ex << std::endl;
+    ASSERT_EQ(3u, ex.size());
+    ASSERT_EQ(0u, ex[0].object_no);
+    ASSERT_EQ(off, ex[0].offset);
+    ASSERT_EQ(500000u, ex[0].length);
+    ASSERT_EQ(1u, ex[1].object_no);
+    ASSERT_EQ(0u, ex[1].offset);
+    ASSERT_EQ(object_size, ex[1].length);
+    ASSERT_EQ(2u, ex[2].object_no);
+    ASSERT_EQ(0u, ex[2].offset);
+    ASSERT_EQ(object_size - 500000, ex[2].length);
+    for (auto& e : ex) {
+      ASSERT_EQ(1u, e.buffer_extents.size());
+    }
+    ASSERT_EQ(100u + 500000u + object_size, ex[2].buffer_extents[0].first);
+
+    // a second range after the first one extends the last extent
+    Striper::file_to_extents(g_ceph_context, &l, off + len, 1000, 0, 0, &ex);
+    ASSERT_EQ(3u, ex.size());
+    ASSERT_EQ(object_size - 500000 + 1000, ex[2].length);
+    ASSERT_EQ(2u, ex[2].buffer_extents.size());
+  }
+}
+
 TEST(Striper, GetNumObj)
 {
   file_layout_t l;
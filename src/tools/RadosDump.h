@@ -376,22 +376,30 @@ class RadosDump
 
     // Define this in .h because it's templated
     template <typename T>
-      int write_section(sectiontype_t type, const T& obj, int fd) {
-        if (dry_run)
-          return 0;
-        bufferlist blhdr, bl, blftr;
+      static void encode_section(sectiontype_t type, const T& obj,
+				 bufferlist& out) {
+        bufferlist bl;
         obj.encode(bl);
         header hdr(type, bl.length());
-        hdr.encode(blhdr);
+        hdr.encode(out);
+        out.claim_append(bl);
         footer ft;
-        ft.encode(blftr);
-
-        int ret = blhdr.write_fd(fd);
-        if (ret) return ret;
-        ret = bl.write_fd(fd);
-        if (ret) return ret;
-        ret = blftr.write_fd(fd);
-        return ret;
+        ft.encode(out);
+      }
+
+    static void encode_simple(sectiontype_t type, bufferlist& out)
+    {
+      header hdr(type, 0);
+      hdr.encode(out);
+    }
+
+    template <typename T>
+      int write_section(sectiontype_t type, const T& obj, int fd) {
+        if (dry_run)
+          return 0;
+        bufferlist bl;
+        encode_section(type, obj, bl);
+        return bl.write_fd(fd);
       }
 
     int write_simple(sectiontype_t type, int fd)
@@ -399,9 +407,7 @@ class RadosDump
       if (dry_run)
         return 0;
       bufferlist hbl;
-
-      header hdr(type, 0);
-      hdr.encode(hbl);
+      encode_simple(type, hbl);
       return hbl.write_fd(fd);
     }
 };
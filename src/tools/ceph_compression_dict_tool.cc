@@ -0,0 +1,213 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+/*
+ * Ceph - scalable distributed file system
+ *
+ * This is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License version 2.1, as published by the Free Software
+ * Foundation.  See file COPYING.
+ *
+ */
+
+/*
+ * Train a compression dictionary from objects sampled out of a pool.
+ *
+ * The result is printed base64 encoded, ready for
+ *
+ *   ceph osd pool set <pool> compression_dictionary <dict>[,<older dicts>]
+ *
+ * BlueStore compresses the small blobs of the pool against the first
+ * dictionary of the list; the older ones are still needed to read data
+ * written while they were first.
+ */
+
+#include <fstream>
+#include <iostream>
+#include <random>
+
+#include "include/types.h"
+#include "include/rados/librados.hpp"
+
+#include "common/ceph_argparse.h"
+#include "common/config.h"
+#include "common/errno.h"
+#include "compressor/Compressor.h"
+#include "global/global_context.h"
+#include "global/global_init.h"
+#include "include/stringify.h"
+
+using std::cerr;
+using std::cout;
+using std::string;
+using std::vector;
+
+static void usage()
+{
+  cout << "usage: ceph-compression-dict-tool --pool <pool> [options]\n"
+       << "  --pool <pool>          pool to sample objects from\n"
+       << "  --samples <n>          number of objects to sample (default 1000)\n"
+       << "  --sample-size <bytes>  bytes read from each sampled object\n"
+       << "                         (default 65536)\n"
+       << "  --dict-size <bytes>    maximum dictionary size (default 65536)\n"
+       << "  --algorithm <alg>      compression algorithm (default zstd)\n"
+       << "  --out <file>           write the dictionary here, not to stdout\n"
+       << std::endl;
+  generic_client_usage();
+}
+
+int main(int argc, const char **argv)
+{
+  vector<const char*> args;
+  argv_to_vec(argc, argv, args);
+  if (args.empty()) {
+    cerr << argv[0] << ": -h or --help for usage" << std::endl;
+    exit(1);
+  }
+  if (ceph_argparse_need_usage(args)) {
+    usage();
+    exit(0);
+  }
+
+  auto cct = global_init(NULL, args, CEPH_ENTITY_TYPE_CLIENT,
+			 CODE_ENVIRONMENT_UTILITY, 0);
+  common_init_finish(g_ceph_context);
+
+  string pool_name, alg = "zstd", out_fn, val;
+  uint64_t num_samples = 1000;
+  uint64_t sample_size = 65536;
+  uint64_t dict_size = 65536;
+  std::ostringstream err;
+  for (auto i = args.begin(); i != args.end(); ) {
+    if (ceph_argparse_double_dash(args, i)) {
+      break;
+    } else if (ceph_argparse_witharg(args, i, &val, "--pool", (char*)NULL)) {
+      pool_name = val;
+    } else if (ceph_argparse_witharg(args, i, &val, "--algorithm", (char*)NULL)) {
+      alg = val;
+    } else if (ceph_argparse_witharg(args, i, &val, "--out", (char*)NULL)) {
+      out_fn = val;
+    } else if (ceph_argparse_witharg(args, i, &num_samples, err,
+				     "--samples", (char*)NULL) ||
+	       ceph_argparse_witharg(args, i, &sample_size, err,
+				     "--sample-size", (char*)NULL) ||
+	       ceph_argparse_witharg(args, i, &dict_size, err,
+				     "--dict-size", (char*)NULL)) {
+      if (!err.str().empty()) {
+	cerr << err.str() << std::endl;
+	exit(1);
+      }
+    } else {
+      cerr << "unrecognized option " << *i << std::endl;
+      exit(1);
+    }
+  }
+  if (pool_name.empty()) {
+    cerr << "--pool is required" << std::endl;
+    exit(1);
+  }
+  if (!num_samples || !sample_size || !dict_size) {
+    cerr << "--samples, --sample-size and --dict-size must be positive"
+	 << std::endl;
+    exit(1);
+  }
+
+  CompressorRef compressor = Compressor::create(g_ceph_context, alg);
+  if (!compressor) {
+    cerr << "unable to load compressor " << alg << std::endl;
+    exit(1);
+  }
+
+  librados::Rados rados;
+  int ret = rados.init_with_context(g_ceph_context);
+  if (ret < 0) {
+    cerr << "couldn't initialize rados: " << cpp_strerror(ret) << std::endl;
+    exit(1);
+  }
+  ret = rados.connect();
+  if (ret < 0) {
+    cerr << "couldn't connect to cluster: " << cpp_strerror(ret) << std::endl;
+    exit(1);
+  }
+  librados::IoCtx io_ctx;
+  ret = rados.ioctx_create(pool_name.c_str(), io_ctx);
+  if (ret < 0) {
+    cerr << "error opening pool " << pool_name << ": "
+	 << cpp_strerror(ret) << std::endl;
+    exit(1);
+  }
+  io_ctx.set_namespace(librados::all_nspaces);
+
+  // reservoir sample of the objects, so that every object of the pool
+  // is as likely to be picked
+  vector<std::pair<string, string>> picked;  // (nspace, oid)
+  std::mt19937_64 rng(std::random_device{}());
+  uint64_t seen = 0;
+  try {
+    for (auto p = io_ctx.nobjects_begin(); p != io_ctx.nobjects_end(); ++p) {
+      ++seen;
+      if (picked.size() < num_samples) {
+	picked.emplace_back(p->get_nspace(), p->get_oid());
+      } else {
+	uint64_t j = rng() % seen;
+	if (j < num_samples) {
+	  picked[j] = std::make_pair(p->get_nspace(), p->get_oid());
+	}
+      }
+    }
+  } catch (const std::exception& e) {
+    cerr << "error listing pool " << pool_name << ": " << e.what() << std::endl;
+    exit(1);
+  }
+
+  vector<bufferlist> samples;
+  samples.reserve(picked.size());
+  uint64_t total = 0;
+  for (auto& [nspace, oid] : picked) {
+    io_ctx.set_namespace(nspace);
+    bufferlist bl;
+    ret = io_ctx.read(oid, bl, sample_size, 0);
+    if (ret < 0) {
+      // removed since we listed it
+      continue;
+    }
+    total += bl.length();
+    samples.push_back(std::move(bl));
+  }
+  cerr << "sampled " << samples.size() << " of " << seen << " objects, "
+       << byte_u_t(total) << std::endl;
+
+  bufferlist dict;
+  ret = compressor->train_dictionary(samples, dict_size, &dict);
+  if (ret == -EOPNOTSUPP) {
+    cerr << alg << " does not support dictionaries" << std::endl;
+    exit(1);
+  }
+  if (ret < 0) {
+    cerr << "training failed, more or larger samples may help: "
+	 << cpp_strerror(ret) << std::endl;
+    exit(1);
+  }
+  auto loaded = compressor->load_dictionary(dict);
+  if (!loaded) {
+    cerr << "trained dictionary does not load" << std::endl;
+    exit(1);
+  }
+  cerr << "trained dictionary " << loaded->get_id() << ", "
+       << byte_u_t(dict.length()) << std::endl;
+
+  bufferlist encoded;
+  dict.encode_base64(encoded);
+  if (out_fn.empty()) {
+    encoded.write_stream(cout);
+    cout << std::endl;
+  } else {
+    ret = encoded.write_file(out_fn.c_str());
+    if (ret < 0) {
+      cerr << "error writing " << out_fn << ": " << cpp_strerror(ret)
+	   << std::endl;
+      exit(1);
+    }
+  }
+  return 0;
+}
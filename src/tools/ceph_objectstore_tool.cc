@@ -45,6 +45,7 @@
 #include "ceph_objectstore_tool.h"
 #include "include/compat.h"
 #include "include/util.h"
+#include "include/scope_guard.h"
 
 namespace po = boost::program_options;
 
@@ -678,12 +679,21 @@ int do_trim_pg_log(ObjectStore *store, const coll_t &coll,
 	continue;
       if (p->key().substr(0, 4) == string("dup_"))
 	continue;
+      if (p->key() == "log_batch_entries")
+	continue;
 
       bufferlist bl = p->value();
       auto bp = bl.cbegin();
+      // a batch key (see osd_pg_log_batch_entries) is only trimmed once
+      // all of its entries are
+      uint32_t n = 1;
       pg_log_entry_t e;
       try {
-	e.decode_with_checksum(bp);
+	if (p->key().substr(0, 10) == string("log_batch_"))
+	  decode(n, bp);
+	while (n--) {
+	  e.decode_with_checksum(bp);
+	}
       } catch (const buffer::error &e) {
 	cerr << "Error reading pg log entry: " << e.what() << std::endl;
       }
@@ -760,6 +770,21 @@ int ObjectStoreTool::export_file(ObjectStore *store, coll_t cid, ghobject_t &obj
 
   object_begin objb(obj);
 
+  // the sections of an object are kept together in the export, so that
+  // the objects exported at the same time do not mix.  those that do not
+  // fit in max_read hold the file until their end is written out.
+  bufferlist sections;
+  std::unique_lock file_locker{file_lock, std::defer_lock};
+  auto flush = [&](bool last) {
+    if (!last && sections.length() < (unsigned)max_read)
+      return 0;
+    if (!file_locker.owns_lock())
+      file_locker.lock();
+    int r = dry_run ? 0 : sections.write_fd(file_fd);
+    sections.clear();
+    return r;
+  };
+
   {
     bufferptr bp;
     bufferlist bl;
@@ -776,9 +801,7 @@ int ObjectStoreTool::export_file(ObjectStore *store, coll_t cid, ghobject_t &obj
 
   // NOTE: we include whiteouts, lost, etc.
 
-  ret = write_section(TYPE_OBJECT_BEGIN, objb, file_fd);
-  if (ret < 0)
-    return ret;
+  encode_section(TYPE_OBJECT_BEGIN, objb, sections);
 
   uint64_t offset = 0;
   bufferlist rawdatabl;
@@ -801,7 +824,8 @@ int ObjectStoreTool::export_file(ObjectStore *store, coll_t cid, ghobject_t &obj
     total -= ret;
     offset += ret;
 
-    ret = write_section(TYPE_DATA, dblock, file_fd);
+    encode_section(TYPE_DATA, dblock, sections);
+    ret = flush(false);
     if (ret) return ret;
   }
 
@@ -810,9 +834,7 @@ int ObjectStoreTool::export_file(ObjectStore *store, coll_t cid, ghobject_t &obj
   ret = store->getattrs(ch, obj, aset);
   if (ret) return ret;
   attr_section as(aset);
-  ret = write_section(TYPE_ATTRS, as, file_fd);
-  if (ret)
-    return ret;
+  encode_section(TYPE_ATTRS, as, sections);
 
   if (debug) {
     cerr << "attrs size " << aset.size() << std::endl;
@@ -827,9 +849,7 @@ int ObjectStoreTool::export_file(ObjectStore *store, coll_t cid, ghobject_t &obj
   }
 
   omap_hdr_section ohs(hdrbuf);
-  ret = write_section(TYPE_OMAP_HDR, ohs, file_fd);
-  if (ret)
-    return ret;
+  encode_section(TYPE_OMAP_HDR, ohs, sections);
 
   ObjectMap::ObjectMapIterator iter = store->get_omap_iterator(ch, obj);
   if (!iter) {
@@ -847,18 +867,16 @@ int ObjectStoreTool::export_file(ObjectStore *store, coll_t cid, ghobject_t &obj
 
     mapcount += out.size();
     omap_section oms(out);
-    ret = write_section(TYPE_OMAP, oms, file_fd);
+    encode_section(TYPE_OMAP, oms, sections);
+    ret = flush(false);
     if (ret)
       return ret;
   }
   if (debug)
     cerr << "omap map size " << mapcount << std::endl;
 
-  ret = write_simple(TYPE_OBJECT_END, file_fd);
-  if (ret)
-    return ret;
-
-  return 0;
+  encode_simple(TYPE_OBJECT_END, sections);
+  return flush(true);
 }
 
 int ObjectStoreTool::export_files(ObjectStore *store, coll_t coll)
@@ -867,21 +885,37 @@ int ObjectStoreTool::export_files(ObjectStore *store, coll_t coll)
   auto ch = store->open_collection(coll);
   while (!next.is_max()) {
     vector<ghobject_t> objects;
-    int r = store->collection_list(ch, next, ghobject_t::get_max(), 300,
-      &objects, &next);
+    int r = store->collection_list(ch, next, ghobject_t::get_max(),
+      300 * threads, &objects, &next);
     if (r < 0)
       return r;
-    for (vector<ghobject_t>::iterator i = objects.begin();
-	 i != objects.end();
-	 ++i) {
-      ceph_assert(!i->hobj.is_meta());
-      if (i->is_pgmeta() || i->hobj.is_temp() || !i->is_no_gen()) {
-	continue;
+    // the objects of a listing are shared out among the threads, each
+    // one taking the next that is left
+    std::atomic<size_t> pos = 0;
+    std::atomic<int> err = 0;
+    auto worker = [&] {
+      for (size_t i = pos++; i < objects.size() && !err; i = pos++) {
+	ceph_assert(!objects[i].hobj.is_meta());
+	if (objects[i].is_pgmeta() || objects[i].hobj.is_temp() ||
+	    !objects[i].is_no_gen()) {
+	  continue;
+	}
+	int r = export_file(store, coll, objects[i]);
+	if (r < 0) {
+	  err = r;
+	}
       }
-      r = export_file(store, coll, *i);
-      if (r < 0)
-        return r;
+    };
+    vector<std::thread> workers;
+    for (unsigned n = 1; n < threads; ++n) {
+      workers.emplace_back(worker);
+    }
+    worker();
+    for (auto& w : workers) {
+      w.join();
     }
+    if (err < 0)
+      return err;
   }
   return 0;
 }
@@ -1416,14 +1450,35 @@ int ObjectStoreTool::get_object(ObjectStore *store,
     }
   }
   if (!dry_run) {
-    wait_until_done(t, [&] {
-      store->queue_transaction(ch, std::move(*t));
-      ch->flush();
-    });
+    queue_object(store, ch, std::move(*t));
   }
   return 0;
 }
 
+void ObjectStoreTool::queue_object(ObjectStore *store,
+				   ObjectStore::CollectionHandle &ch,
+				   ObjectStore::Transaction &&t)
+{
+  // the objects are read from the export one after the other, but up to
+  // --threads of their transactions are left to the store at once
+  std::unique_lock l{objects_lock};
+  objects_cond.wait(l, [this] { return objects_in_flight < threads; });
+  ++objects_in_flight;
+  l.unlock();
+  t.register_on_complete(make_lambda_context([this](int) {
+    std::lock_guard l{objects_lock};
+    --objects_in_flight;
+    objects_cond.notify_all();
+  }));
+  store->queue_transaction(ch, std::move(t));
+}
+
+void ObjectStoreTool::wait_for_objects()
+{
+  std::unique_lock l{objects_lock};
+  objects_cond.wait(l, [this] { return objects_in_flight == 0; });
+}
+
 int dump_pg_metadata(Formatter *formatter, bufferlist &bl, metadata_section &ms)
 {
   auto ebliter = bl.cbegin();
@@ -1797,6 +1852,8 @@ int ObjectStoreTool::do_import(ObjectStore *store, OSDSuperblock& sb,
     coll_t(),
     OSD::make_snapmapper_oid());
   SnapMapper mapper(g_ceph_context, &driver, 0, 0, 0, pgid.shard);
+  // leave no object in flight once the import is over, failed or not
+  auto drain = make_scope_guard([this] { wait_for_objects(); });
 
   cout << "Importing pgid " << pgid;
   cout << std::endl;
@@ -3200,6 +3257,7 @@ int main(int argc, char **argv)
   spg_t pgid;
   unsigned epoch = 0;
   unsigned slow_threshold = 16;
+  unsigned threads = 1;
   ghobject_t ghobj;
   bool human_readable;
   Formatter *formatter;
@@ -3248,6 +3306,8 @@ int main(int argc, char **argv)
     ("rmtype", po::value<string>(&rmtypestr), "Specify corrupting object removal 'snapmap' or 'nosnapmap' - TESTING USE ONLY")
     ("slow-omap-threshold", po::value<unsigned>(&slow_threshold),
       "Threshold (in seconds) to consider omap listing slow (for op=list-slow-omap)")
+    ("threads", po::value<unsigned>(&threads),
+     "Number of objects to export or import at the same time (for op=export, export-remove and import)")
     ;
 
   po::options_description positional("Positional options");
@@ -3421,6 +3481,7 @@ int main(int argc, char **argv)
   }
 
   ObjectStoreTool tool = ObjectStoreTool(file_fd, dry_run);
+  tool.set_threads(threads);
 
   if (vm.count("file") && file_fd == fd_none && !dry_run) {
     cerr << "--file option only applies to import, dump-export, export, export-remove, "
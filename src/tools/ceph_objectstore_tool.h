@@ -15,15 +15,33 @@
 #ifndef CEPH_OBJECTSTORE_TOOL_H_
 #define CEPH_OBJECTSTORE_TOOL_H_
 
+#include "common/ceph_mutex.h"
 #include "RadosDump.h"
 
 class ObjectStoreTool : public RadosDump
 {
+    /// objects exported or imported at the same time
+    unsigned threads = 1;
+    /// held while the sections of an object are written to the export
+    ceph::mutex file_lock = ceph::make_mutex("ObjectStoreTool::file_lock");
+    ceph::mutex objects_lock = ceph::make_mutex("ObjectStoreTool::objects_lock");
+    ceph::condition_variable objects_cond;
+    /// imported objects whose transactions are not applied yet
+    unsigned objects_in_flight = 0;
+
+    void queue_object(ObjectStore *store, ObjectStore::CollectionHandle &ch,
+		      ObjectStore::Transaction &&t);
+    void wait_for_objects();
+
   public:
     ObjectStoreTool(int file_fd, bool dry_run)
       : RadosDump(file_fd, dry_run)
     {}
 
+    void set_threads(unsigned n) {
+      threads = std::max(n, 1u);
+    }
+
     int dump_export(Formatter *formatter);
     int do_import(ObjectStore *store, OSDSuperblock& sb, bool force,
 		  std::string pgidstr);
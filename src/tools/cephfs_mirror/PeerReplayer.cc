@@ -714,30 +714,31 @@ int PeerReplayer::remote_file_op(const std::string &dir_path,
   return 0;
 }
 
-int PeerReplayer::cleanup_remote_dir(const std::string &dir_path) {
-  dout(20) << ": dir_path=" << dir_path << dendl;
+int PeerReplayer::cleanup_remote_dir(const std::string &dir_path,
+                                     const std::string &path) {
+  dout(20) << ": dir_path=" << dir_path << ", path=" << path << dendl;
 
   std::stack<SyncEntry> rm_stack;
   ceph_dir_result *tdirp;
-  int r = ceph_opendir(m_remote_mount, dir_path.c_str(), &tdirp);
+  int r = ceph_opendir(m_remote_mount, path.c_str(), &tdirp);
   if (r < 0) {
-    derr << ": failed to open remote directory=" << dir_path << ": "
+    derr << ": failed to open remote directory=" << path << ": "
          << cpp_strerror(r) << dendl;
     return r;
   }
 
   struct ceph_statx tstx;
-  r = ceph_statx(m_remote_mount, dir_path.c_str(), &tstx,
+  r = ceph_statx(m_remote_mount, path.c_str(), &tstx,
                  CEPH_STATX_MODE | CEPH_STATX_UID | CEPH_STATX_GID |
                  CEPH_STATX_SIZE | CEPH_STATX_ATIME | CEPH_STATX_MTIME,
                  AT_NO_ATTR_SYNC | AT_SYMLINK_NOFOLLOW);
   if (r < 0) {
-    derr << ": failed to stat remote directory=" << dir_path << ": "
+    derr << ": failed to stat remote directory=" << path << ": "
          << cpp_strerror(r) << dendl;
     return r;
   }
 
-  rm_stack.emplace(SyncEntry(dir_path, tdirp, tstx));
+  rm_stack.emplace(SyncEntry(path, tdirp, tstx));
   while (!rm_stack.empty()) {
     if (should_backoff(dir_path, &r)) {
       dout(0) << ": backing off r=" << r << dendl;
@@ -830,10 +831,185 @@ int PeerReplayer::cleanup_remote_dir(const std::string &dir_path) {
   return r;
 }
 
-int PeerReplayer::do_synchronize(const std::string &dir_path, const std::string &snap_name) {
-  dout(20) << ": dir_path=" << dir_path << ", snap_name=" << snap_name << dendl;
+int PeerReplayer::remove_remote_entry(const std::string &dir_path,
+                                      const std::string &remote_path) {
+  dout(10) << ": dir_path=" << dir_path << ", remote_path=" << remote_path
+           << dendl;
+
+  struct ceph_statx stx;
+  int r = ceph_statx(m_remote_mount, remote_path.c_str(), &stx, CEPH_STATX_MODE,
+                     AT_NO_ATTR_SYNC | AT_SYMLINK_NOFOLLOW);
+  if (r == -ENOENT) {
+    return 0;
+  }
+  if (r < 0) {
+    derr << ": failed to stat remote entry=" << remote_path << ": "
+         << cpp_strerror(r) << dendl;
+    return r;
+  }
+
+  if (S_ISDIR(stx.stx_mode)) {
+    r = cleanup_remote_dir(dir_path, remote_path);
+    if (r == 0) {
+      r = ceph_rmdir(m_remote_mount, remote_path.c_str());
+    }
+  } else {
+    r = ceph_unlink(m_remote_mount, remote_path.c_str());
+  }
+  if (r < 0) {
+    derr << ": failed to remove remote entry=" << remote_path << ": "
+         << cpp_strerror(r) << dendl;
+  }
+  return r;
+}
+
+int PeerReplayer::should_sync_entry(const std::string &dir_path,
+                                    const std::string &prev_path,
+                                    const std::string &local_path,
+                                    const std::string &remote_path,
+                                    const struct ceph_statx &stx,
+                                    bool *need_sync) {
+  dout(20) << ": prev_path=" << prev_path << ", local_path=" << local_path
+           << dendl;
+
+  *need_sync = true;
+  struct ceph_statx pstx;
+  int r = ceph_statx(m_local_mount, prev_path.c_str(), &pstx,
+                     CEPH_STATX_MODE | CEPH_STATX_SIZE | CEPH_STATX_MTIME |
+                     CEPH_STATX_CTIME, AT_NO_ATTR_SYNC | AT_SYMLINK_NOFOLLOW);
+  if (r < 0 && r != -ENOENT) {
+    derr << ": failed to stat local entry=" << prev_path << ": "
+         << cpp_strerror(r) << dendl;
+    return r;
+  }
+
+  if (r == -ENOENT || (pstx.stx_mode & S_IFMT) != (stx.stx_mode & S_IFMT)) {
+    // the remote may still have an entry of another type under this name
+    struct ceph_statx rstx;
+    r = ceph_statx(m_remote_mount, remote_path.c_str(), &rstx, CEPH_STATX_MODE,
+                   AT_NO_ATTR_SYNC | AT_SYMLINK_NOFOLLOW);
+    if (r == -ENOENT) {
+      return 0;
+    }
+    if (r < 0) {
+      derr << ": failed to stat remote entry=" << remote_path << ": "
+           << cpp_strerror(r) << dendl;
+      return r;
+    }
+    if ((rstx.stx_mode & S_IFMT) != (stx.stx_mode & S_IFMT)) {
+      return remove_remote_entry(dir_path, remote_path);
+    }
+    return 0;
+  }
+
+  if (S_ISDIR(stx.stx_mode)) {
+    if (!g_ceph_context->_conf.get_val<bool>("cephfs_mirror_skip_unchanged_dirs")) {
+      return 0;
+    }
+    // the recursive ctime covers the directory and all of its subtree
+    char crctime[64] = {0};
+    char prctime[64] = {0};
+    r = ceph_getxattr(m_local_mount, local_path.c_str(), "ceph.dir.rctime",
+                      crctime, sizeof(crctime) - 1);
+    if (r >= 0) {
+      r = ceph_getxattr(m_local_mount, prev_path.c_str(), "ceph.dir.rctime",
+                        prctime, sizeof(prctime) - 1);
+    }
+    if (r < 0) {
+      derr << ": failed to get rctime of local directory=" << local_path << ": "
+           << cpp_strerror(r) << dendl;
+      return r;
+    }
+    *need_sync = strcmp(crctime, prctime) != 0;
+    return 0;
+  }
+
+  *need_sync = stx.stx_size != pstx.stx_size ||
+               stx.stx_mtime.tv_sec != pstx.stx_mtime.tv_sec ||
+               stx.stx_mtime.tv_nsec != pstx.stx_mtime.tv_nsec ||
+               stx.stx_ctime.tv_sec != pstx.stx_ctime.tv_sec ||
+               stx.stx_ctime.tv_nsec != pstx.stx_ctime.tv_nsec;
+  return 0;
+}
+
+int PeerReplayer::propagate_deleted_entries(const std::string &dir_path,
+                                            const std::string &epath,
+                                            const std::string &snap_path,
+                                            const std::string &prev_snap_path) {
+  dout(20) << ": dir_path=" << dir_path << ", epath=" << epath << dendl;
+
+  auto p_path = entry_path(prev_snap_path, epath);
+  ceph_dir_result *dirp;
+  int r = ceph_opendir(m_local_mount, p_path.c_str(), &dirp);
+  if (r == -ENOENT || r == -ENOTDIR) {
+    // nothing to delete under a new directory
+    return 0;
+  }
+  if (r < 0) {
+    derr << ": failed to open local directory=" << p_path << ": "
+         << cpp_strerror(r) << dendl;
+    return r;
+  }
+
+  while (true) {
+    if (should_backoff(dir_path, &r)) {
+      dout(0) << ": backing off r=" << r << dendl;
+      break;
+    }
+
+    struct dirent de;
+    struct ceph_statx pstx;
+    r = ceph_readdirplus_r(m_local_mount, dirp, &de, &pstx, CEPH_STATX_MODE,
+                           AT_NO_ATTR_SYNC | AT_SYMLINK_NOFOLLOW, NULL);
+    if (r < 0) {
+      derr << ": failed to read local directory=" << p_path << dendl;
+      break;
+    }
+    if (r == 0) {
+      break;
+    }
+
+    auto d_name = std::string(de.d_name);
+    if (d_name == "." || d_name == "..") {
+      continue;
+    }
+
+    auto e_name = entry_path(epath, d_name);
+    struct ceph_statx cstx;
+    r = ceph_statx(m_local_mount, entry_path(snap_path, e_name).c_str(), &cstx,
+                   CEPH_STATX_MODE, AT_NO_ATTR_SYNC | AT_SYMLINK_NOFOLLOW);
+    if (r == 0) {
+      continue;
+    }
+    if (r != -ENOENT) {
+      derr << ": failed to stat local entry=" << entry_path(snap_path, e_name)
+           << ": " << cpp_strerror(r) << dendl;
+      break;
+    }
+
+    dout(10) << ": propagating deleted entry=" << e_name << dendl;
+    r = remove_remote_entry(dir_path, entry_path(dir_path, e_name));
+    if (r < 0) {
+      break;
+    }
+  }
+
+  if (ceph_closedir(m_local_mount, dirp) < 0) {
+    derr << ": failed to close local directory=" << p_path << dendl;
+  }
+  return r;
+}
+
+int PeerReplayer::do_synchronize(const std::string &dir_path, const std::string &snap_name,
+                                 const boost::optional<std::string> &prev_snap_name) {
+  dout(20) << ": dir_path=" << dir_path << ", snap_name=" << snap_name
+           << ", prev_snap_name=" << prev_snap_name << dendl;
 
   auto snap_path = snapshot_path(m_cct, dir_path, snap_name);
+  std::string prev_snap_path;
+  if (prev_snap_name) {
+    prev_snap_path = snapshot_path(m_cct, dir_path, *prev_snap_name);
+  }
   std::stack<SyncEntry> sync_stack;
 
   ceph_dir_result *tdirp;
@@ -852,9 +1028,18 @@ int PeerReplayer::do_synchronize(const std::string &dir_path, const std::string
   if (r < 0) {
     derr << ": failed to stat local directory=" << snap_path << ": "
          << cpp_strerror(r) << dendl;
+    ceph_closedir(m_local_mount, tdirp);
     return r;
   }
 
+  if (prev_snap_name) {
+    r = propagate_deleted_entries(dir_path, "/", snap_path, prev_snap_path);
+    if (r < 0) {
+      ceph_closedir(m_local_mount, tdirp);
+      return r;
+    }
+  }
+
   sync_stack.emplace(SyncEntry("/", tdirp, tstx));
   while (!sync_stack.empty()) {
     if (should_backoff(dir_path, &r)) {
@@ -872,7 +1057,8 @@ int PeerReplayer::do_synchronize(const std::string &dir_path, const std::string
       while (true) {
         r = ceph_readdirplus_r(m_local_mount, entry.dirp, &de, &stx,
                                CEPH_STATX_MODE | CEPH_STATX_UID | CEPH_STATX_GID |
-                               CEPH_STATX_SIZE | CEPH_STATX_ATIME | CEPH_STATX_MTIME,
+                               CEPH_STATX_SIZE | CEPH_STATX_ATIME | CEPH_STATX_MTIME |
+                               CEPH_STATX_CTIME,
                                AT_NO_ATTR_SYNC | AT_SYMLINK_NOFOLLOW, NULL);
         if (r < 0) {
           derr << ": failed to local read directory=" << entry.epath << dendl;
@@ -904,11 +1090,30 @@ int PeerReplayer::do_synchronize(const std::string &dir_path, const std::string
       auto epath = entry_path(entry.epath, e_name);
       auto l_path = entry_path(snap_path, epath);
       auto r_path = entry_path(dir_path, epath);
+      if (prev_snap_name) {
+        // only what changed since the previous snapshot is sent
+        bool need_sync;
+        r = should_sync_entry(dir_path, entry_path(prev_snap_path, epath),
+                              l_path, r_path, stx, &need_sync);
+        if (r < 0) {
+          break;
+        }
+        if (!need_sync) {
+          dout(20) << ": unchanged entry=" << epath << dendl;
+          continue;
+        }
+      }
       if (S_ISDIR(stx.stx_mode)) {
         r = remote_mkdir(l_path, r_path, stx);
         if (r < 0) {
           break;
         }
+        if (prev_snap_name) {
+          r = propagate_deleted_entries(dir_path, epath, snap_path, prev_snap_path);
+          if (r < 0) {
+            break;
+          }
+        }
         ceph_dir_result *dirp;
         r = ceph_opendir(m_local_mount, l_path.c_str(), &dirp);
         if (r < 0) {
@@ -948,19 +1153,27 @@ int PeerReplayer::do_synchronize(const std::string &dir_path, const std::string
 }
 
 int PeerReplayer::synchronize(const std::string &dir_path, uint64_t snap_id,
-                              const std::string &snap_name) {
+                              const std::string &snap_name,
+                              const boost::optional<std::string> &prev_snap_name) {
   dout(20) << ": dir_path=" << dir_path << ", snap_id=" << snap_id
-           << ", snap_name=" << snap_name << dendl;
+           << ", snap_name=" << snap_name << ", prev_snap_name=" << prev_snap_name
+           << dendl;
 
   auto snap_path = snapshot_path(m_cct, dir_path, snap_name);
 
-  int r = cleanup_remote_dir(dir_path);
-  if (r < 0) {
-    derr << ": failed to cleanup remote directory=" << dir_path << dendl;
-    return r;
+  int r;
+  if (!prev_snap_name) {
+    r = cleanup_remote_dir(dir_path, dir_path);
+    if (r < 0) {
+      derr << ": failed to cleanup remote directory=" << dir_path << dendl;
+      return r;
+    }
   }
 
-  r = do_synchronize(dir_path, snap_name);
+  // with a previous snapshot the remote directory holds what it had
+  // (or some of the entries of a failed attempt at this one), so it is
+  // brought up to date with the entries changed in between.
+  r = do_synchronize(dir_path, snap_name, prev_snap_name);
   if (r < 0) {
     derr << ": failed to synchronize dir_path=" << dir_path << ", snapshot="
          << snap_path << dendl;
@@ -1024,10 +1237,15 @@ int PeerReplayer::do_sync_snaps(const std::string &dir_path) {
 
   // start mirroring snapshots from the last snap-id synchronized
   uint64_t last_snap_id = 0;
+  boost::optional<std::string> prev_snap_name;
   if (!remote_snap_map.empty()) {
     auto last = remote_snap_map.rbegin();
     last_snap_id = last->first;
     set_last_synced_snap(dir_path, last_snap_id, last->second);
+    auto prev = local_snap_map.find(last_snap_id);
+    if (prev != local_snap_map.end()) {
+      prev_snap_name = prev->second;
+    }
   }
 
   dout(5) << ": last snap-id transferred=" << last_snap_id << dendl;
@@ -1044,13 +1262,14 @@ int PeerReplayer::do_sync_snaps(const std::string &dir_path) {
   for (; it != local_snap_map.end(); ++it) {
     set_current_syncing_snap(dir_path, it->first, it->second);
     auto start = clock::now();
-    r = synchronize(dir_path, it->first, it->second);
+    r = synchronize(dir_path, it->first, it->second, prev_snap_name);
     if (r < 0) {
       derr << ": failed to synchronize dir_path=" << dir_path
            << ", snapshot=" << it->second << dendl;
       clear_current_syncing_snap(dir_path);
       return r;
     }
+    prev_snap_name = it->second;
     std::chrono::duration<double> duration = clock::now() - start;
     set_last_synced_stat(dir_path, it->first, it->second, duration.count());
     if (--snaps_per_cycle == 0) {
@@ -255,10 +255,19 @@ private:
   int propagate_snap_deletes(const std::string &dir_name, const std::set<std::string> &snaps);
   int propagate_snap_renames(const std::string &dir_name,
                              const std::set<std::pair<std::string,std::string>> &snaps);
-  int synchronize(const std::string &dir_path, uint64_t snap_id, const std::string &snap_name);
-  int do_synchronize(const std::string &path, const std::string &snap_name);
-
-  int cleanup_remote_dir(const std::string &dir_path);
+  int synchronize(const std::string &dir_path, uint64_t snap_id, const std::string &snap_name,
+                  const boost::optional<std::string> &prev_snap_name);
+  int do_synchronize(const std::string &path, const std::string &snap_name,
+                     const boost::optional<std::string> &prev_snap_name);
+  int should_sync_entry(const std::string &dir_path, const std::string &prev_path,
+                        const std::string &local_path, const std::string &remote_path,
+                        const struct ceph_statx &stx, bool *need_sync);
+  int propagate_deleted_entries(const std::string &dir_path, const std::string &epath,
+                                const std::string &snap_path,
+                                const std::string &prev_snap_path);
+
+  int cleanup_remote_dir(const std::string &dir_path, const std::string &path);
+  int remove_remote_entry(const std::string &dir_path, const std::string &remote_path);
   int remote_mkdir(const std::string &local_path, const std::string &remote_path,
                    const struct ceph_statx &stx);
   int remote_file_op(const std::string &dir_path,
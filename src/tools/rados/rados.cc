@@ -221,6 +221,9 @@ void usage(ostream& out)
 "   -t N\n"
 "   --concurrent-ios=N\n"
 "        Set number of concurrent I/O operations\n"
+"   --target-ops=N\n"
+"        start N operations per second, whether or not the previous ones\n"
+"        completed, up to the concurrent I/O operations\n"
 "   --show-time\n"
 "        prefix output with date/time\n"
 "   --no-verify\n"
@@ -1859,6 +1862,7 @@ static int rados_tool_common(const std::map < std::string, std::string > &opts,
   const char *target_pool_name = NULL;
   string oloc, target_oloc, nspace, target_nspace;
   int concurrent_ios = 16;
+  int target_ops = 0;
   unsigned op_size = default_op_size;
   unsigned object_size = 0;
   unsigned max_objects = 0;
@@ -1935,6 +1939,12 @@ static int rados_tool_common(const std::map < std::string, std::string > &opts,
       return -EINVAL;
     }
   }
+  i = opts.find("target-ops");
+  if (i != opts.end()) {
+    if (rados_sistrtoll(i, &target_ops)) {
+      return -EINVAL;
+    }
+  }
   i = opts.find("run-name");
   if (i != opts.end()) {
     run_name = i->second;
@@ -3288,6 +3298,7 @@ static int rados_tool_common(const std::map < std::string, std::string > &opts,
     }
     RadosBencher bencher(g_ceph_context, rados, io_ctx);
     bencher.set_show_time(show_time);
+    bencher.set_target_ops(target_ops);
     bencher.set_write_destination(static_cast<OpWriteDest>(bench_write_dest));
 
     ostream *outstream = NULL;
@@ -4115,6 +4126,8 @@ int main(int argc, const char **argv)
 #endif
     } else if (ceph_argparse_witharg(args, i, &val, "-t", "--concurrent-ios", (char*)NULL)) {
       opts["concurrent-ios"] = val;
+    } else if (ceph_argparse_witharg(args, i, &val, "--target-ops", (char*)NULL)) {
+      opts["target-ops"] = val;
     } else if (ceph_argparse_witharg(args, i, &val, "--block-size", (char*)NULL)) {
       opts["block-size"] = val;
     } else if (ceph_argparse_witharg(args, i, &val, "-b", (char*)NULL)) {
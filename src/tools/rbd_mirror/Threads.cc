@@ -2,6 +2,7 @@
 // vim: ts=8 sw=2 smarttab
 
 #include "tools/rbd_mirror/Threads.h"
+#include "common/Throttle.h"
 #include "common/Timer.h"
 #include "librbd/AsioEngine.h"
 #include "librbd/ImageCtx.h"
@@ -18,10 +19,21 @@ Threads<I>::Threads(std::shared_ptr<librados::Rados>& rados) {
 
   timer = new SafeTimer(cct, timer_lock, true);
   timer->init();
+
+  auto sync_bps_limit = cct->_conf.get_val<Option::size_t>(
+    "rbd_mirror_image_sync_bps_limit");
+  if (sync_bps_limit > 0) {
+    image_sync_throttle = new TokenBucketThrottle(
+      cct, "rbd_mirror_image_sync_throttle", 0, 0, timer, &timer_lock);
+    image_sync_throttle->set_limit(sync_bps_limit, sync_bps_limit, 1);
+  }
 }
 
 template <typename I>
 Threads<I>::~Threads() {
+  // releases the syncs still waiting
+  delete image_sync_throttle;
+
   {
     std::lock_guard timer_locker{timer_lock};
     timer->shutdown();
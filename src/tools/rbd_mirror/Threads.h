@@ -11,6 +11,7 @@
 
 class SafeTimer;
 class ThreadPool;
+class TokenBucketThrottle;
 
 namespace librbd {
 struct AsioEngine;
@@ -30,6 +31,9 @@ public:
   SafeTimer *timer = nullptr;
   ceph::mutex timer_lock = ceph::make_mutex("Threads::timer_lock");
 
+  /// bytes read by the image syncs, if limited
+  TokenBucketThrottle *image_sync_throttle = nullptr;
+
   explicit Threads(std::shared_ptr<librados::Rados>& rados);
   Threads(const Threads&) = delete;
   Threads& operator=(const Threads&) = delete;
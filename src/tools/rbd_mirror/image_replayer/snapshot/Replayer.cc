@@ -4,6 +4,7 @@
 #include "Replayer.h"
 #include "common/debug.h"
 #include "common/errno.h"
+#include "common/Throttle.h"
 #include "include/stringify.h"
 #include "common/Timer.h"
 #include "cls/rbd/cls_rbd_client.h"
@@ -99,6 +100,10 @@ struct Replayer<I>::DeepCopyHandler : public librbd::deep_copy::Handler {
     replayer->handle_copy_image_read(bytes_read);
   }
 
+  void throttle_read(uint64_t bytes, Context* on_ready) override {
+    replayer->throttle_copy_image_read(bytes, on_ready);
+  }
+
   int update_progress(uint64_t object_number, uint64_t object_count) override {
     replayer->handle_copy_image_progress(object_number, object_count);
     return 0;
@@ -1106,6 +1111,26 @@ void Replayer<I>::handle_copy_image_read(uint64_t bytes_read) {
   m_snapshot_bytes += bytes_read;
 }
 
+template <typename I>
+void Replayer<I>::throttle_copy_image_read(uint64_t bytes, Context* on_ready) {
+  auto throttle = m_threads->image_sync_throttle;
+  if (throttle == nullptr ||
+      !throttle->get(bytes, this, &Replayer<I>::handle_copy_image_read_throttle,
+                     on_ready, 0)) {
+    on_ready->complete(0);
+    return;
+  }
+
+  dout(20) << "waiting to read " << bytes << " bytes" << dendl;
+}
+
+template <typename I>
+void Replayer<I>::handle_copy_image_read_throttle(Context* on_ready,
+                                                  uint64_t flag) {
+  // timer_lock is held -- so resume from outside the timer thread
+  m_threads->work_queue->queue(on_ready, 0);
+}
+
 template <typename I>
 void Replayer<I>::apply_image_state() {
   dout(10) << dendl;
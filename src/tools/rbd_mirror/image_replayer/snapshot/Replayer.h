@@ -283,6 +283,8 @@ private:
   void handle_copy_image_progress(uint64_t object_number,
                                   uint64_t object_count);
   void handle_copy_image_read(uint64_t bytes_read);
+  void throttle_copy_image_read(uint64_t bytes, Context* on_ready);
+  void handle_copy_image_read_throttle(Context* on_ready, uint64_t flag);
 
   void apply_image_state();
   void handle_apply_image_state(int r);
@@ -103,6 +103,7 @@ struct Config {
   int max_part = 255;
   int io_timeout = -1;
   int reattach_timeout = 30;
+  int num_connections = 1;
 
   bool exclusive = false;
   bool quiesce = false;
@@ -158,6 +159,8 @@ static void usage()
             << "  --io-timeout <sec>            Set nbd IO timeout\n"
             << "  --max_part <limit>            Override for module param max_part\n"
             << "  --nbds_max <limit>            Override for module param nbds_max\n"
+            << "  --num-connections <num>       Number of nbd connections, each served\n"
+            << "                                by its own threads (netlink only)\n"
             << "  --quiesce                     Use quiesce callbacks\n"
             << "  --quiesce-hook <path>         Specify quiesce hook path\n"
             << "                                (default: " << Config().quiesce_hook << ")\n"
@@ -197,19 +200,19 @@ public:
   uint64_t quiesce_watch_handle = 0;
 
 private:
-  int fd;
   librbd::Image &image;
   Config *cfg;
 
 public:
-  NBDServer(int fd, librbd::Image& image, Config *cfg)
-    : fd(fd)
-    , image(image)
+  NBDServer(const std::vector<int> &fds, librbd::Image& image, Config *cfg)
+    : image(image)
     , cfg(cfg)
-    , reader_thread(*this, &NBDServer::reader_entry)
-    , writer_thread(*this, &NBDServer::writer_entry)
     , quiesce_thread(*this, &NBDServer::quiesce_entry)
   {
+    for (auto fd : fds) {
+      connections.push_back(std::make_unique<Connection>(*this, fd));
+    }
+
     std::vector<librbd::config_option_t> options;
     image.config_list(&options);
     for (auto &option : options) {
@@ -234,10 +237,13 @@ private:
   std::atomic<bool> terminated = { false };
   std::atomic<bool> allow_internal_flush = { false };
 
+  struct Connection;
+
   struct IOContext
   {
     xlist<IOContext*>::item item;
     NBDServer *server = nullptr;
+    Connection *conn = nullptr;
     struct nbd_request request;
     struct nbd_reply reply;
     bufferlist data;
@@ -252,60 +258,62 @@ private:
 
   ceph::mutex lock = ceph::make_mutex("NBDServer::Locker");
   ceph::condition_variable cond;
-  xlist<IOContext*> io_pending;
-  xlist<IOContext*> io_finished;
 
   void io_start(IOContext *ctx)
   {
-    std::lock_guard l{lock};
-    io_pending.push_back(&ctx->item);
+    Connection *conn = ctx->conn;
+    std::lock_guard l{conn->lock};
+    conn->io_pending.push_back(&ctx->item);
   }
 
   void io_finish(IOContext *ctx)
   {
-    std::lock_guard l{lock};
+    Connection *conn = ctx->conn;
+    std::lock_guard l{conn->lock};
     ceph_assert(ctx->item.is_on_list());
     ctx->item.remove_myself();
-    io_finished.push_back(&ctx->item);
-    cond.notify_all();
+    conn->io_finished.push_back(&ctx->item);
+    conn->cond.notify_all();
   }
 
-  IOContext *wait_io_finish()
+  IOContext *wait_io_finish(Connection &conn)
   {
-    std::unique_lock l{lock};
-    cond.wait(l, [this] {
-                   return !io_finished.empty() ||
-                          (io_pending.empty() && terminated);
-                 });
+    std::unique_lock l{conn.lock};
+    conn.cond.wait(l, [this, &conn] {
+                        return !conn.io_finished.empty() ||
+                               (conn.io_pending.empty() && terminated);
+                      });
 
-    if (io_finished.empty())
+    if (conn.io_finished.empty())
       return NULL;
 
-    IOContext *ret = io_finished.front();
-    io_finished.pop_front();
+    IOContext *ret = conn.io_finished.front();
+    conn.io_finished.pop_front();
 
     return ret;
   }
 
-  void wait_clean()
+  void wait_clean(Connection &conn)
   {
-    std::unique_lock l{lock};
-    cond.wait(l, [this] { return io_pending.empty(); });
+    std::unique_lock l{conn.lock};
+    conn.cond.wait(l, [&conn] { return conn.io_pending.empty(); });
 
-    while(!io_finished.empty()) {
-      std::unique_ptr<IOContext> free_ctx(io_finished.front());
-      io_finished.pop_front();
+    while(!conn.io_finished.empty()) {
+      std::unique_ptr<IOContext> free_ctx(conn.io_finished.front());
+      conn.io_finished.pop_front();
     }
   }
 
   void assert_clean()
   {
-    std::unique_lock l{lock};
+    for (auto &conn : connections) {
+      std::unique_lock l{conn->lock};
 
-    ceph_assert(!reader_thread.is_started());
-    ceph_assert(!writer_thread.is_started());
-    ceph_assert(io_pending.empty());
-    ceph_assert(io_finished.empty());
+      ceph_assert(!conn->reader_thread.is_started());
+      ceph_assert(!conn->writer_thread.is_started());
+      ceph_assert(conn->io_pending.empty());
+      ceph_assert(conn->io_finished.empty());
+    }
   }
 
   static void aio_callback(librbd::completion_t cb, void *arg)
@@ -343,11 +351,11 @@ private:
     aio_completion->release();
   }
 
-  void reader_entry()
+  void reader_entry(Connection &conn)
   {
     struct pollfd poll_fds[2];
     memset(poll_fds, 0, sizeof(struct pollfd) * 2);
-    poll_fds[0].fd = fd;
+    poll_fds[0].fd = conn.fd;
     poll_fds[0].events = POLLIN;
     poll_fds[1].fd = terminate_event_fd;
     poll_fds[1].events = POLLIN;
@@ -355,6 +363,7 @@ private:
     while (true) {
       std::unique_ptr<IOContext> ctx(new IOContext());
       ctx->server = this;
+      ctx->conn = &conn;
 
       dout(20) << __func__ << ": waiting for nbd request" << dendl;
 
@@ -378,7 +387,7 @@ private:
         continue;
       }
 
-      r = safe_read_exact(fd, &ctx->request, sizeof(struct nbd_request));
+      r = safe_read_exact(conn.fd, &ctx->request, sizeof(struct nbd_request));
       if (r < 0) {
 	derr << "failed to read nbd request header: " << cpp_strerror(r)
 	     << dendl;
@@ -409,7 +418,7 @@ private:
           goto signal;
         case NBD_CMD_WRITE:
           bufferptr ptr(ctx->request.len);
-	  r = safe_read_exact(fd, ptr.c_str(), ctx->request.len);
+	  r = safe_read_exact(conn.fd, ptr.c_str(), ctx->request.len);
           if (r < 0) {
 	    derr << *ctx << ": failed to read nbd request data: "
 		 << cpp_strerror(r) << dendl;
@@ -451,9 +460,19 @@ error:
       }
     }
 signal:
-    std::lock_guard l{lock};
-    terminated = true;
-    cond.notify_all();
+    {
+      std::lock_guard l{lock};
+      terminated = true;
+      cond.notify_all();
+    }
+    for (auto &c : connections) {
+      std::lock_guard l{c->lock};
+      c->cond.notify_all();
+    }
+    if (connections.size() > 1) {
+      // wake up the readers of the other connections
+      terminate_event_sock.notify();
+    }
 
     std::lock_guard disconnect_l{disconnect_lock};
     disconnect_cond.notify_all();
@@ -461,11 +480,11 @@ signal:
     dout(20) << __func__ << ": terminated" << dendl;
   }
 
-  void writer_entry()
+  void writer_entry(Connection &conn)
   {
     while (true) {
       dout(20) << __func__ << ": waiting for io request" << dendl;
-      std::unique_ptr<IOContext> ctx(wait_io_finish());
+      std::unique_ptr<IOContext> ctx(wait_io_finish(conn));
       if (!ctx) {
 	dout(20) << __func__ << ": no io requests, terminating" << dendl;
         goto done;
@@ -473,14 +492,14 @@ signal:
 
       dout(20) << __func__ << ": got: " << *ctx << dendl;
 
-      int r = safe_write(fd, &ctx->reply, sizeof(struct nbd_reply));
+      int r = safe_write(conn.fd, &ctx->reply, sizeof(struct nbd_reply));
       if (r < 0) {
 	derr << *ctx << ": failed to write reply header: " << cpp_strerror(r)
 	     << dendl;
         goto error;
       }
       if (ctx->command == NBD_CMD_READ && ctx->reply.error == htonl(0)) {
-	r = ctx->data.write_fd(fd);
+	r = ctx->data.write_fd(conn.fd);
         if (r < 0) {
 	  derr << *ctx << ": failed to write replay data: " << cpp_strerror(r)
 	       << dendl;
@@ -490,9 +509,9 @@ signal:
       dout(20) << *ctx << ": finish" << dendl;
     }
   error:
-    wait_clean();
+    wait_clean(conn);
   done:
-    ::shutdown(fd, SHUT_RDWR);
+    ::shutdown(conn.fd, SHUT_RDWR);
 
     dout(20) << __func__ << ": terminated" << dendl;
   }
@@ -590,7 +609,49 @@ signal:
       (server.*func)();
       return NULL;
     }
-  } reader_thread, writer_thread, quiesce_thread;
+  } quiesce_thread;
+
+  class ConnectionThread : public Thread
+  {
+  public:
+    typedef void (NBDServer::*entry_func)(Connection &conn);
+  private:
+    NBDServer &server;
+    Connection &conn;
+    entry_func func;
+  public:
+    ConnectionThread(NBDServer &_server, Connection &_conn, entry_func _func)
+      :server(_server)
+      ,conn(_conn)
+      ,func(_func)
+    {}
+  protected:
+    void* entry() override
+    {
+      (server.*func)(conn);
+      return NULL;
+    }
+  };
+
+  // the requests read from a connection are replied to on it
+  struct Connection
+  {
+    int fd;
+    ceph::mutex lock = ceph::make_mutex("NBDServer::Connection::Locker");
+    ceph::condition_variable cond;
+    xlist<IOContext*> io_pending;
+    xlist<IOContext*> io_finished;
+    ConnectionThread reader_thread;
+    ConnectionThread writer_thread;
+
+    Connection(NBDServer &server, int fd)
+      : fd(fd)
+      , reader_thread(server, *this, &NBDServer::reader_entry)
+      , writer_thread(server, *this, &NBDServer::writer_entry)
+    {}
+  };
+
+  std::vector<std::unique_ptr<Connection>> connections;
 
   bool started = false;
   bool quiesce = false;
@@ -609,8 +670,10 @@ public:
                                         EVENT_SOCKET_TYPE_EVENTFD);
       ceph_assert(r >= 0);
 
-      reader_thread.create("rbd_reader");
-      writer_thread.create("rbd_writer");
+      for (auto &conn : connections) {
+        conn->reader_thread.create("rbd_reader");
+        conn->writer_thread.create("rbd_writer");
+      }
       if (cfg->quiesce) {
         quiesce_thread.create("rbd_quiesce");
       }
@@ -655,8 +718,10 @@ public:
 
       terminate_event_sock.notify();
 
-      reader_thread.join();
-      writer_thread.join();
+      for (auto &conn : connections) {
+        conn->reader_thread.join();
+        conn->writer_thread.join();
+      }
       if (cfg->quiesce) {
         quiesce_thread.join();
       }
@@ -1279,8 +1344,9 @@ static int netlink_connect_cb(struct nl_msg *msg, void *arg)
   return NL_OK;
 }
 
-static int netlink_connect(Config *cfg, struct nl_sock *sock, int nl_id, int fd,
-                           uint64_t size, uint64_t flags, bool reconnect)
+static int netlink_connect(Config *cfg, struct nl_sock *sock, int nl_id,
+                           const std::vector<int> &fds, uint64_t size,
+                           uint64_t flags, bool reconnect)
 {
   struct nlattr *sock_attr;
   struct nlattr *sock_opt;
@@ -1333,14 +1399,16 @@ static int netlink_connect(Config *cfg, struct nl_sock *sock, int nl_id, int fd,
     goto free_msg;
   }
 
-  sock_opt = nla_nest_start(msg, NBD_SOCK_ITEM);
-  if (!sock_opt) {
-    cerr << "rbd-nbd: Could not init sock in netlink message." << std::endl;
-    goto free_msg;
-  }
+  for (auto fd : fds) {
+    sock_opt = nla_nest_start(msg, NBD_SOCK_ITEM);
+    if (!sock_opt) {
+      cerr << "rbd-nbd: Could not init sock in netlink message." << std::endl;
+      goto free_msg;
+    }
 
-  NLA_PUT_U32(msg, NBD_SOCK_FD, fd);
-  nla_nest_end(msg, sock_opt);
+    NLA_PUT_U32(msg, NBD_SOCK_FD, fd);
+    nla_nest_end(msg, sock_opt);
+  }
   nla_nest_end(msg, sock_attr);
 
   ret = nl_send_sync(sock, msg);
@@ -1359,8 +1427,8 @@ free_msg:
   return -EIO;
 }
 
-static int try_netlink_setup(Config *cfg, int fd, uint64_t size, uint64_t flags,
-                             bool reconnect)
+static int try_netlink_setup(Config *cfg, const std::vector<int> &fds,
+                             uint64_t size, uint64_t flags, bool reconnect)
 {
   struct nl_sock *sock;
   int nl_id, ret;
@@ -1374,7 +1442,7 @@ static int try_netlink_setup(Config *cfg, int fd, uint64_t size, uint64_t flags,
 
   dout(10) << "netlink interface supported." << dendl;
 
-  ret = netlink_connect(cfg, sock, nl_id, fd, size, flags, reconnect);
+  ret = netlink_connect(cfg, sock, nl_id, fds, size, flags, reconnect);
   netlink_cleanup(sock);
 
   if (ret != 0)
@@ -1430,11 +1498,12 @@ static void handle_signal(int signum)
   terminate_event_sock.notify();
 }
 
-static NBDServer *start_server(int fd, librbd::Image& image, Config *cfg)
+static NBDServer *start_server(const std::vector<int> &fds,
+                               librbd::Image& image, Config *cfg)
 {
   NBDServer *server;
 
-  server = new NBDServer(fd, image, cfg);
+  server = new NBDServer(fds, image, cfg);
   server->start();
 
   init_async_signal_handler();
@@ -1560,7 +1629,8 @@ static int do_map(int argc, const char *argv[], Config *cfg, bool reconnect)
   unsigned long blksize = RBD_NBD_BLKSIZE;
   bool use_netlink;
 
-  int fd[2];
+  std::vector<int> kernel_fds;
+  std::vector<int> server_fds;
 
   librbd::image_info_t info;
 
@@ -1602,9 +1672,14 @@ static int do_map(int argc, const char *argv[], Config *cfg, bool reconnect)
   common_init_finish(g_ceph_context);
   global_init_chdir(g_ceph_context);
 
-  if (socketpair(AF_UNIX, SOCK_STREAM, 0, fd) == -1) {
-    r = -errno;
-    goto close_ret;
+  for (int i = 0; i < cfg->num_connections; i++) {
+    int fd[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, fd) == -1) {
+      r = -errno;
+      goto close_fd;
+    }
+    kernel_fds.push_back(fd[0]);
+    server_fds.push_back(fd[1]);
   }
 
   r = rados.init_with_context(g_ceph_context);
@@ -1700,6 +1775,11 @@ static int do_map(int argc, const char *argv[], Config *cfg, bool reconnect)
     flags |= NBD_FLAG_READ_ONLY;
     read_only = 1;
   }
+  if (cfg->num_connections > 1) {
+    // all the connections serve the same image, so a flush on any of
+    // them covers the writes completed on the others
+    flags |= NBD_FLAG_CAN_MULTI_CONN;
+  }
 
   if (info.size > ULONG_MAX) {
     r = -EFBIG;
@@ -1714,11 +1794,11 @@ static int do_map(int argc, const char *argv[], Config *cfg, bool reconnect)
   if (r < 0)
     goto close_fd;
 
-  server = start_server(fd[1], image, cfg);
+  server = start_server(server_fds, image, cfg);
 
   use_netlink = cfg->try_netlink || reconnect;
   if (use_netlink) {
-    r = try_netlink_setup(cfg, fd[0], size, flags, reconnect);
+    r = try_netlink_setup(cfg, kernel_fds, size, flags, reconnect);
     if (r < 0) {
       goto free_server;
     } else if (r == 1) {
@@ -1727,7 +1807,13 @@ static int do_map(int argc, const char *argv[], Config *cfg, bool reconnect)
   }
 
   if (!use_netlink) {
-    r = try_ioctl_setup(cfg, fd[0], size, blksize, flags);
+    if (kernel_fds.size() > 1) {
+      r = -EINVAL;
+      cerr << "rbd-nbd: multiple connections require the netlink interface"
+           << std::endl;
+      goto free_server;
+    }
+    r = try_ioctl_setup(cfg, kernel_fds[0], size, blksize, flags);
     if (r < 0)
       goto free_server;
   }
@@ -1787,9 +1873,12 @@ close_nbd:
 free_server:
   delete server;
 close_fd:
-  close(fd[0]);
-  close(fd[1]);
-close_ret:
+  for (auto fd : kernel_fds) {
+    close(fd);
+  }
+  for (auto fd : server_fds) {
+    close(fd);
+  }
   image.close();
   io_ctx.close();
   rados.shutdown();
@@ -2018,6 +2107,16 @@ static int parse_args(vector<const char*>& args, std::ostream *err_msg,
         return -EINVAL;
       }
       cfg->set_max_part = true;
+    } else if (ceph_argparse_witharg(args, i, &cfg->num_connections, err,
+                                     "--num-connections", (char *)NULL)) {
+      if (!err.str().empty()) {
+        *err_msg << "rbd-nbd: " << err.str();
+        return -EINVAL;
+      }
+      if (cfg->num_connections < 1) {
+        *err_msg << "rbd-nbd: Invalid argument for num-connections!";
+        return -EINVAL;
+      }
     } else if (ceph_argparse_flag(args, i, "--quiesce", (char *)NULL)) {
       cfg->quiesce = true;
     } else if (ceph_argparse_witharg(args, i, &cfg->quiesce_hook,